@@ -0,0 +1,292 @@
+#!/usr/bin/env python3
+#
+# Copyright 2011-2020 Blender Foundation
+#
+# Licensed under the Apache License, Version 2.0 (the "License");
+# you may not use this file except in compliance with the License.
+# You may obtain a copy of the License at
+#
+# http://www.apache.org/licenses/LICENSE-2.0
+#
+# Unless required by applicable law or agreed to in writing, software
+# distributed under the License is distributed on an "AS IS" BASIS,
+# WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+# See the License for the specific language governing permissions and
+# limitations under the License.
+#
+
+# Render benchmark for the standalone Cycles application.
+#
+# Generates a fixed set of scenes covering many lights, hair, volumes,
+# subsurface scattering and heavy instancing, renders each of them and
+# collects the statistics written by --stats-json into a single JSON file.
+# Scenes are generated with a fixed seed, so results of different builds can
+# be compared. With --compare, phases that got slower than the given results
+# by more than the threshold are reported, and the exit code is non-zero.
+#
+# Example:
+#   ./cycles_benchmark.py --cycles ./bin/cycles --output results.json
+#   ./cycles_benchmark.py --cycles ./bin/cycles --compare results.json
+
+import argparse
+import json
+import math
+import os
+import platform
+import random
+import subprocess
+import sys
+
+from cycles_xml_utils import camera_matrix, write_quads
+
+
+def box_quads(x0, y0, z0, x1, y1, z1):
+    return [((x0, y0, z0), (x0, y1, z0), (x1, y1, z0), (x1, y0, z0)),
+            ((x0, y0, z1), (x1, y0, z1), (x1, y1, z1), (x0, y1, z1)),
+            ((x0, y0, z0), (x1, y0, z0), (x1, y0, z1), (x0, y0, z1)),
+            ((x1, y0, z0), (x1, y1, z0), (x1, y1, z1), (x1, y0, z1)),
+            ((x1, y1, z0), (x0, y1, z0), (x0, y1, z1), (x1, y1, z1)),
+            ((x0, y1, z0), (x0, y0, z0), (x0, y0, z1), (x0, y1, z1))]
+
+
+def sphere_quads(center, radius, rings, segments):
+    def point(ring, segment):
+        theta = math.pi * ring / rings
+        phi = 2.0 * math.pi * segment / segments
+        return (center[0] + radius * math.sin(theta) * math.cos(phi),
+                center[1] + radius * math.sin(theta) * math.sin(phi),
+                center[2] + radius * math.cos(theta))
+
+    quads = []
+    for ring in range(rings):
+        for segment in range(segments):
+            quads.append((point(ring, segment), point(ring + 1, segment),
+                          point(ring + 1, segment + 1), point(ring, segment + 1)))
+    return quads
+
+
+def write_header(f, args, eye, target):
+    f.write('<cycles>\n')
+    f.write('<integrator max_bounce="4" />\n')
+    f.write('<transform matrix="%s">\n' % camera_matrix(eye, target))
+    f.write('<camera width="%d" height="%d" type="perspective" fov="0.8" />\n' %
+            (args.width, args.height))
+    f.write('</transform>\n')
+    f.write('<background><background name="bg" strength="0.3" color="0.6 0.7 0.9" />'
+            '<connect from="bg background" to="output surface" /></background>\n')
+    f.write('<shader name="ground"><diffuse_bsdf name="diffuse" color="0.5 0.5 0.5" />'
+            '<connect from="diffuse bsdf" to="output surface" /></shader>\n')
+    f.write('<shader name="sun"><emission name="emission" color="1.0 0.95 0.9" strength="1.0" />'
+            '<connect from="emission emission" to="output surface" /></shader>\n')
+    f.write('<state shader="ground">\n')
+    write_quads(f, [((-50.0, -50.0, 0.0), (50.0, -50.0, 0.0),
+                     (50.0, 50.0, 0.0), (-50.0, 50.0, 0.0))])
+    f.write('</state>\n')
+
+
+def write_key_light(f, co, strength):
+    f.write('<state shader="sun">\n')
+    f.write('<light light_type="point" co="%.3f %.3f %.3f" size="1.0" '
+            'strength="%.1f %.1f %.1f" use_mis="true" />\n' % (co + (strength,) * 3))
+    f.write('</state>\n')
+
+
+def write_many_lights(f, args, rng):
+    write_header(f, args, (-12.0, -12.0, 8.0), (0.0, 0.0, 0.0))
+    f.write('<shader name="box"><diffuse_bsdf name="diffuse" color="0.7 0.7 0.7" />'
+            '<connect from="diffuse bsdf" to="output surface" /></shader>\n')
+    f.write('<state shader="box">\n')
+    for i in range(64):
+        x = rng.uniform(-10.0, 10.0)
+        y = rng.uniform(-10.0, 10.0)
+        write_quads(f, box_quads(x, y, 0.0, x + 0.8, y + 0.8, rng.uniform(0.5, 3.0)))
+    f.write('</state>\n')
+
+    f.write('<state shader="sun">\n')
+    for i in range(args.lights):
+        co = (rng.uniform(-10.0, 10.0), rng.uniform(-10.0, 10.0), rng.uniform(0.2, 4.0))
+        color = (rng.uniform(0.2, 1.0), rng.uniform(0.2, 1.0), rng.uniform(0.2, 1.0))
+        f.write('<light light_type="point" co="%.3f %.3f %.3f" size="0.05" '
+                'strength="%.2f %.2f %.2f" use_mis="true" />\n' %
+                (co + tuple(c * 20.0 for c in color)))
+    f.write('</state>\n')
+
+
+def write_hair(f, args, rng):
+    write_header(f, args, (-3.0, -3.0, 2.0), (0.0, 0.0, 0.3))
+    write_key_light(f, (-4.0, -2.0, 6.0), 800.0)
+    f.write('<shader name="hair"><principled_hair_bsdf name="hair" melanin="0.5" />'
+            '<connect from="hair bsdf" to="output surface" /></shader>\n')
+    f.write('<state shader="hair">\n')
+
+    keys_per_curve = 5
+    P = []
+    for i in range(args.curves):
+        x = rng.uniform(-1.5, 1.5)
+        y = rng.uniform(-1.5, 1.5)
+        length = rng.uniform(0.3, 0.6)
+        bend = (rng.uniform(-0.2, 0.2), rng.uniform(-0.2, 0.2))
+        for k in range(keys_per_curve):
+            t = k / (keys_per_curve - 1)
+            P.append("%.4f %.4f %.4f" % (x + bend[0] * t * t, y + bend[1] * t * t, length * t))
+    f.write('<hair P="%s" nkeys="%s" radius="0.002" />\n' %
+            ("  ".join(P), " ".join(str(keys_per_curve) for i in range(args.curves))))
+    f.write('</state>\n')
+
+
+def write_volume(f, args, rng):
+    write_header(f, args, (-6.0, -6.0, 3.0), (0.0, 0.0, 1.0))
+    write_key_light(f, (3.0, -2.0, 6.0), 2000.0)
+    f.write('<shader name="smoke"><scatter_volume name="scatter" color="0.8 0.8 0.8" '
+            'density="0.6" anisotropy="0.3" />'
+            '<connect from="scatter volume" to="output volume" /></shader>\n')
+    f.write('<state shader="smoke">\n')
+    for i in range(4):
+        x = rng.uniform(-2.0, 2.0)
+        y = rng.uniform(-2.0, 2.0)
+        write_quads(f, box_quads(x - 1.0, y - 1.0, 0.0, x + 1.0, y + 1.0, 2.5))
+    f.write('</state>\n')
+
+
+def write_sss(f, args, rng):
+    write_header(f, args, (-4.0, -4.0, 2.0), (0.0, 0.0, 0.8))
+    write_key_light(f, (-2.0, 3.0, 5.0), 1000.0)
+    f.write('<shader name="skin"><subsurface_scattering name="sss" color="0.9 0.6 0.5" '
+            'scale="0.2" radius="1.0 0.4 0.2" />'
+            '<connect from="sss bssrdf" to="output surface" /></shader>\n')
+    f.write('<state shader="skin" interpolation="smooth">\n')
+    for i in range(6):
+        center = (rng.uniform(-2.0, 2.0), rng.uniform(-2.0, 2.0), 0.7)
+        write_quads(f, sphere_quads(center, 0.7, 48, 96))
+    f.write('</state>\n')
+
+
+def write_instancing(f, args, rng):
+    write_header(f, args, (-30.0, -30.0, 15.0), (0.0, 0.0, 0.0))
+    write_key_light(f, (-10.0, -5.0, 30.0), 20000.0)
+    f.write('<shader name="rock"><diffuse_bsdf name="diffuse" color="0.4 0.35 0.3" />'
+            '<connect from="diffuse bsdf" to="output surface" /></shader>\n')
+    f.write('<state shader="rock" interpolation="smooth">\n')
+
+    # Hidden far away prototype, only its instances are visible.
+    f.write('<transform translate="0 0 -1000">\n')
+    write_quads(f, sphere_quads((0.0, 0.0, 0.0), 0.5, 24, 48), 'name="rock" ')
+    f.write('</transform>\n')
+
+    for i in range(args.instances):
+        f.write('<transform translate="%.3f %.3f 0.3" rotate="%.1f 0 0 1" '
+                'scale="%.3f %.3f %.3f"><instance geometry="rock" /></transform>\n' %
+                (rng.uniform(-40.0, 40.0), rng.uniform(-40.0, 40.0), rng.uniform(0.0, 360.0),
+                 rng.uniform(0.5, 1.5), rng.uniform(0.5, 1.5), rng.uniform(0.3, 1.0)))
+    f.write('</state>\n')
+
+
+# Scene name, writer and extra arguments for the cycles binary.
+SCENES = (
+    ("many_lights", write_many_lights, []),
+    ("hair", write_hair, []),
+    ("volume", write_volume, []),
+    ("sss", write_sss, []),
+    ("instancing", write_instancing, []),
+    # Noisy subsurface scattering, denoised per tile while rendering.
+    ("denoise", write_sss, ["--denoising", "nlm"]),
+)
+
+
+def render(args, name, filepath, extra_args):
+    stats_filepath = os.path.join(args.directory, "%s.json" % name)
+    command = [args.cycles, "--background", "--quiet",
+               "--samples", str(args.samples),
+               "--threads", str(args.threads),
+               "--output", os.path.join(args.directory, "%s.png" % name),
+               "--stats-json", stats_filepath] + extra_args + [filepath]
+    subprocess.check_call(command, stdout=subprocess.DEVNULL)
+    with open(stats_filepath) as f:
+        return json.load(f)
+
+
+def compare(results, baseline, threshold):
+    regressions = []
+    for name, stats in results["scenes"].items():
+        if name not in baseline["scenes"]:
+            continue
+        base_stats = baseline["scenes"][name]
+        for phase, time in stats["time"].items():
+            base_time = base_stats["time"].get(phase, 0.0)
+            # Ignore phases too short to measure reliably.
+            if base_time > 0.05 and time > base_time * (1.0 + threshold):
+                regressions.append("%s %s: %.3fs -> %.3fs (+%.0f%%)" %
+                                   (name, phase, base_time, time,
+                                    100.0 * (time / base_time - 1.0)))
+        base_peak = base_stats["memory"]["peak"]
+        peak = stats["memory"]["peak"]
+        if base_peak > 0 and peak > base_peak * (1.0 + threshold):
+            regressions.append("%s peak memory: %d -> %d bytes" % (name, base_peak, peak))
+    return regressions
+
+
+def main():
+    parser = argparse.ArgumentParser(description="Benchmark Cycles on a fixed set of scenes.")
+    parser.add_argument("--cycles", required=True, help="Path to the standalone cycles binary")
+    parser.add_argument("--directory", default="cycles_benchmark",
+                        help="Directory to write scenes and renders to")
+    parser.add_argument("--output", default="",
+                        help="File path to write the combined statistics to")
+    parser.add_argument("--compare", default="",
+                        help="Statistics of an earlier run, to report regressions against")
+    parser.add_argument("--threshold", type=float, default=0.1,
+                        help="Relative slowdown reported as regression")
+    parser.add_argument("--scenes", default=",".join(scene[0] for scene in SCENES),
+                        help="Comma separated scenes to render")
+    parser.add_argument("--width", type=int, default=640)
+    parser.add_argument("--height", type=int, default=360)
+    parser.add_argument("--samples", type=int, default=32)
+    parser.add_argument("--threads", type=int, default=0)
+    parser.add_argument("--lights", type=int, default=2000)
+    parser.add_argument("--curves", type=int, default=100000)
+    parser.add_argument("--instances", type=int, default=20000)
+    parser.add_argument("--seed", type=int, default=0)
+    args = parser.parse_args()
+
+    os.makedirs(args.directory, exist_ok=True)
+    names = args.scenes.split(",")
+
+    results = {"platform": platform.platform(),
+               "processor": platform.processor(),
+               "scenes": {}}
+
+    print("%-12s %8s %8s %8s %8s %8s %12s %10s" %
+          ("scene", "total", "sync", "bvh", "render", "denoise", "samples/s", "peak MB"))
+    for name, write, extra_args in SCENES:
+        if name not in names:
+            continue
+
+        filepath = os.path.join(args.directory, "%s.xml" % name)
+        with open(filepath, "w") as f:
+            write(f, args, random.Random(args.seed))
+            f.write('</cycles>\n')
+
+        stats = render(args, name, filepath, extra_args)
+        results["scenes"][name] = stats
+
+        time = stats["time"]
+        print("%-12s %7.2fs %7.2fs %7.2fs %7.2fs %7.2fs %12.0f %10.1f" %
+              (name, time["total"], time["sync"], time["bvh"], time["render"], time["denoise"],
+               stats["samples_per_second"], stats["memory"]["peak"] / (1024.0 * 1024.0)))
+
+    if args.output:
+        with open(args.output, "w") as f:
+            json.dump(results, f, indent=2)
+
+    if args.compare:
+        with open(args.compare) as f:
+            baseline = json.load(f)
+        regressions = compare(results, baseline, args.threshold)
+        for regression in regressions:
+            print("Regression: " + regression)
+        if regressions:
+            sys.exit(1)
+
+
+if __name__ == "__main__":
+    main()
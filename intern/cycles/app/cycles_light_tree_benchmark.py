@@ -0,0 +1,241 @@
+#!/usr/bin/env python3
+#
+# Copyright 2011-2020 Blender Foundation
+#
+# Licensed under the Apache License, Version 2.0 (the "License");
+# you may not use this file except in compliance with the License.
+# You may obtain a copy of the License at
+#
+# http://www.apache.org/licenses/LICENSE-2.0
+#
+# Unless required by applicable law or agreed to in writing, software
+# distributed under the License is distributed on an "AS IS" BASIS,
+# WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+# See the License for the specific language governing permissions and
+# limitations under the License.
+#
+
+# Many lights benchmark for the standalone Cycles application.
+#
+# Generates a city at night, with emissive windows on a grid of buildings and
+# street lamps along the roads, and renders it with the light distribution and
+# with the light tree. Both are given the same render time, and the noise is
+# compared against a reference rendered with many samples.
+#
+# Example:
+#   ./cycles_light_tree_benchmark.py --cycles ./bin/cycles --time 30
+
+import argparse
+import array
+import math
+import os
+import random
+import subprocess
+import sys
+import time
+
+from cycles_xml_utils import camera_matrix, write_quads
+
+
+def box_quads(x0, y0, x1, y1, height):
+    quads = [((x0, y0, height), (x1, y0, height), (x1, y1, height), (x0, y1, height))]
+    corners = [(x0, y0), (x1, y0), (x1, y1), (x0, y1)]
+    for i in range(4):
+        ax, ay = corners[i]
+        bx, by = corners[(i + 1) % 4]
+        quads.append(((ax, ay, 0.0), (bx, by, 0.0), (bx, by, height), (ax, ay, height)))
+    return quads
+
+
+def window_quads(rng, x0, y0, x1, y1, height, lit_fraction):
+    # Windows slightly in front of the facades, on a regular grid of floors.
+    quads = []
+    offset = 0.02
+    size = 0.6
+    floors = int(height / 1.5)
+    facades = (
+        ((x0, y0 - offset), (x1, y0 - offset)),
+        ((x1 + offset, y0), (x1 + offset, y1)),
+        ((x1, y1 + offset), (x0, y1 + offset)),
+        ((x0 - offset, y1), (x0 - offset, y0)),
+    )
+    for (ax, ay), (bx, by) in facades:
+        length = math.hypot(bx - ax, by - ay)
+        columns = int(length / 1.2)
+        dx = (bx - ax) / length
+        dy = (by - ay) / length
+        for column in range(columns):
+            t0 = (column + 0.5) * length / columns - 0.5 * size
+            t1 = t0 + size
+            for floor in range(floors):
+                if rng.random() > lit_fraction:
+                    continue
+                z0 = floor * 1.5 + 0.5
+                z1 = z0 + size
+                quads.append(((ax + dx * t0, ay + dy * t0, z0),
+                              (ax + dx * t1, ay + dy * t1, z0),
+                              (ax + dx * t1, ay + dy * t1, z1),
+                              (ax + dx * t0, ay + dy * t0, z1)))
+    return quads
+
+
+def write_scene(filepath, args):
+    rng = random.Random(args.seed)
+    blocks = args.blocks
+    block_size = 12.0
+    street = 6.0
+    extent = blocks * (block_size + street)
+
+    num_windows = 0
+    num_lamps = 0
+
+    with open(filepath, "w") as f:
+        f.write('<cycles>\n')
+        f.write('<film exposure="1.0" />\n')
+        f.write('<transform matrix="%s">\n' % camera_matrix(
+            (-0.1 * extent, -0.1 * extent, 12.0), (0.5 * extent, 0.5 * extent, 0.0)))
+        f.write('<camera width="%d" height="%d" type="perspective" fov="0.8" />\n' %
+                (args.width, args.height))
+        f.write('</transform>\n')
+
+        f.write('<background><background name="bg" strength="0.002" color="0.2 0.3 0.6" />'
+                '<connect from="bg background" to="output surface" /></background>\n')
+        f.write('<shader name="facade"><diffuse_bsdf name="diffuse" color="0.3 0.3 0.3" />'
+                '<connect from="diffuse bsdf" to="output surface" /></shader>\n')
+        f.write('<shader name="ground"><diffuse_bsdf name="diffuse" color="0.15 0.15 0.15" />'
+                '<connect from="diffuse bsdf" to="output surface" /></shader>\n')
+        f.write('<shader name="window" use_mis="true">'
+                '<emission name="emission" color="1.0 0.75 0.4" strength="6.0" />'
+                '<connect from="emission emission" to="output surface" /></shader>\n')
+        f.write('<shader name="lamp"><emission name="emission" color="1.0 0.6 0.3" '
+                'strength="1.0" /><connect from="emission emission" to="output surface" />'
+                '</shader>\n')
+
+        f.write('<state shader="ground">\n')
+        write_quads(f, [((-street, -street, 0.0), (extent, -street, 0.0),
+                         (extent, extent, 0.0), (-street, extent, 0.0))])
+        f.write('</state>\n')
+
+        for bx in range(blocks):
+            for by in range(blocks):
+                x0 = bx * (block_size + street)
+                y0 = by * (block_size + street)
+                x1 = x0 + block_size
+                y1 = y0 + block_size
+                height = rng.uniform(6.0, 40.0)
+
+                f.write('<state shader="facade">\n')
+                write_quads(f, box_quads(x0, y0, x1, y1, height))
+                f.write('</state>\n')
+
+                windows = window_quads(rng, x0, y0, x1, y1, height, args.lit_fraction)
+                if windows:
+                    f.write('<state shader="window">\n')
+                    write_quads(f, windows)
+                    f.write('</state>\n')
+                    num_windows += len(windows)
+
+                # Street lamps along two sides of every block.
+                f.write('<state shader="lamp">\n')
+                for i in range(4):
+                    t = (i + 0.5) * block_size / 4
+                    for co in ((x0 + t, y0 - 1.0, 4.0), (x0 - 1.0, y0 + t, 4.0)):
+                        f.write('<light light_type="point" co="%.3f %.3f %.3f" size="0.15" '
+                                'strength="%.1f %.1f %.1f" use_mis="true" />\n' %
+                                (co + (60.0, 40.0, 20.0)))
+                        num_lamps += 1
+                f.write('</state>\n')
+
+        f.write('</cycles>\n')
+
+    return num_windows, num_lamps
+
+
+def write_integrator_scene(filepath, scene_filepath, use_light_tree):
+    with open(filepath, "w") as f:
+        f.write('<cycles>\n')
+        f.write('<integrator use_light_tree="%s" max_bounce="2" />\n' %
+                ("true" if use_light_tree else "false"))
+        f.write('<include src="%s" />\n' % os.path.basename(scene_filepath))
+        f.write('</cycles>\n')
+
+
+def render(args, filepath, samples, output):
+    command = [args.cycles, "--background", "--quiet",
+               "--samples", str(samples),
+               "--threads", str(args.threads),
+               "--output", output,
+               filepath]
+    start = time.time()
+    subprocess.check_call(command)
+    return time.time() - start
+
+
+def read_pfm(filepath):
+    with open(filepath, "rb") as f:
+        header = f.readline().strip()
+        channels = 3 if header == b"PF" else 1
+        width, height = (int(v) for v in f.readline().split())
+        scale = float(f.readline())
+        pixels = array.array("f")
+        pixels.frombytes(f.read(width * height * channels * 4))
+        if (scale < 0.0) != (sys.byteorder == "little"):
+            pixels.byteswap()
+        return pixels
+
+
+def mean_squared_error(a, b):
+    return sum((x - y) * (x - y) for x, y in zip(a, b)) / len(a)
+
+
+def main():
+    parser = argparse.ArgumentParser(description="Compare many lights sampling at equal time.")
+    parser.add_argument("--cycles", required=True, help="Path to the standalone cycles binary")
+    parser.add_argument("--directory", default="light_tree_benchmark",
+                        help="Directory to write scenes and renders to")
+    parser.add_argument("--blocks", type=int, default=14,
+                        help="Number of city blocks along each axis")
+    parser.add_argument("--lit-fraction", type=float, default=0.5,
+                        help="Fraction of windows that are lit")
+    parser.add_argument("--width", type=int, default=640)
+    parser.add_argument("--height", type=int, default=360)
+    parser.add_argument("--time", type=float, default=30.0,
+                        help="Render time in seconds given to each method")
+    parser.add_argument("--reference-samples", type=int, default=4096)
+    parser.add_argument("--threads", type=int, default=0)
+    parser.add_argument("--seed", type=int, default=0)
+    args = parser.parse_args()
+
+    os.makedirs(args.directory, exist_ok=True)
+    scene_filepath = os.path.join(args.directory, "city.xml")
+    num_windows, num_lamps = write_scene(scene_filepath, args)
+    print("Scene with %d emissive windows and %d street lamps" % (num_windows, num_lamps))
+
+    methods = (("distribution", False), ("light_tree", True))
+    filepaths = {}
+    for name, use_light_tree in methods:
+        filepaths[name] = os.path.join(args.directory, "city_%s.xml" % name)
+        write_integrator_scene(filepaths[name], scene_filepath, use_light_tree)
+
+    reference_filepath = os.path.join(args.directory, "reference.pfm")
+    if not os.path.exists(reference_filepath):
+        print("Rendering reference with %d samples" % args.reference_samples)
+        render(args, filepaths["light_tree"], args.reference_samples, reference_filepath)
+    reference = read_pfm(reference_filepath)
+
+    print("%-14s %8s %10s %12s %12s" % ("method", "samples", "time", "MSE", "efficiency"))
+    for name, use_light_tree in methods:
+        # Estimate the time per sample, including scene setup, to render for the same time.
+        output = os.path.join(args.directory, "%s.pfm" % name)
+        calibration_samples = 4
+        calibration_time = render(args, filepaths[name], calibration_samples, output)
+        samples = max(1, int(calibration_samples * args.time / calibration_time))
+
+        render_time = render(args, filepaths[name], samples, output)
+        mse = mean_squared_error(read_pfm(output), reference)
+        efficiency = 1.0 / (mse * render_time) if mse > 0.0 else float("inf")
+        print("%-14s %8d %9.2fs %12.6g %12.6g" % (name, samples, render_time, mse, efficiency))
+
+
+if __name__ == "__main__":
+    main()
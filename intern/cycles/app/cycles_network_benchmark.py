@@ -0,0 +1,107 @@
+#!/usr/bin/env python3
+#
+# Copyright 2011-2020 Blender Foundation
+#
+# Licensed under the Apache License, Version 2.0 (the "License");
+# you may not use this file except in compliance with the License.
+# You may obtain a copy of the License at
+#
+# http://www.apache.org/licenses/LICENSE-2.0
+#
+# Unless required by applicable law or agreed to in writing, software
+# distributed under the License is distributed on an "AS IS" BASIS,
+# WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+# See the License for the specific language governing permissions and
+# limitations under the License.
+#
+
+# Distributed rendering benchmark for the standalone Cycles application.
+#
+# Starts render servers on consecutive ports of the local host, or uses the
+# given servers, and renders the same scene with an increasing number of them.
+# The time and the speedup over a single server are printed for each count.
+# The second render on the same servers shows the effect of their data cache.
+#
+# Example:
+#   ./cycles_network_benchmark.py --cycles ./bin/cycles --server ./bin/cycles_server \
+#       --scene scene.xml --servers 4 --threads 2
+
+import argparse
+import subprocess
+import time
+
+
+def start_servers(args):
+    processes = []
+    addresses = []
+    for i in range(args.servers):
+        port = args.port + i
+        command = [args.server,
+                   "--device", "CPU",
+                   "--threads", str(args.threads),
+                   "--port", str(port)]
+        processes.append(subprocess.Popen(command, stdout=subprocess.DEVNULL))
+        addresses.append("127.0.0.1:%d" % port)
+
+    # Give the servers time to start listening.
+    time.sleep(2.0)
+    return processes, addresses
+
+
+def render(args, addresses):
+    command = [args.cycles, "--background", "--quiet",
+               "--device", "NETWORK",
+               "--servers", ",".join(addresses),
+               "--samples", str(args.samples),
+               "--tile-width", str(args.tile_size),
+               "--tile-height", str(args.tile_size),
+               "--output", args.output,
+               args.scene]
+    start = time.time()
+    subprocess.check_call(command)
+    return time.time() - start
+
+
+def main():
+    parser = argparse.ArgumentParser(description="Measure scaling of network rendering.")
+    parser.add_argument("--cycles", required=True, help="Path to the standalone cycles binary")
+    parser.add_argument("--server", help="Path to the cycles_server binary")
+    parser.add_argument("--scene", required=True, help="Scene to render")
+    parser.add_argument("--servers", type=int, default=4,
+                        help="Maximum number of local servers to start")
+    parser.add_argument("--addresses", default="",
+                        help="Comma separated host:port of running servers, instead of local ones")
+    parser.add_argument("--port", type=int, default=5120, help="Port of the first local server")
+    parser.add_argument("--threads", type=int, default=1,
+                        help="Render threads of each local server")
+    parser.add_argument("--samples", type=int, default=64)
+    parser.add_argument("--tile-size", type=int, default=32)
+    parser.add_argument("--output", default="network_benchmark.png")
+    args = parser.parse_args()
+
+    processes = []
+    if args.addresses:
+        addresses = args.addresses.split(",")
+    elif args.server:
+        processes, addresses = start_servers(args)
+    else:
+        parser.error("either --server or --addresses is required")
+
+    try:
+        print("%-8s %10s %10s %10s" % ("servers", "time", "cached", "speedup"))
+        base_time = None
+        for count in range(1, len(addresses) + 1):
+            render_time = render(args, addresses[:count])
+            cached_time = render(args, addresses[:count])
+            if base_time is None:
+                base_time = cached_time
+            print("%-8d %9.2fs %9.2fs %9.2fx" %
+                  (count, render_time, cached_time, base_time / cached_time))
+    finally:
+        for process in processes:
+            process.terminate()
+            process.wait()
+
+
+if __name__ == "__main__":
+    main()
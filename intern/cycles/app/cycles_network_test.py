@@ -0,0 +1,138 @@
+#!/usr/bin/env python3
+#
+# Copyright 2011-2020 Blender Foundation
+#
+# Licensed under the Apache License, Version 2.0 (the "License");
+# you may not use this file except in compliance with the License.
+# You may obtain a copy of the License at
+#
+# http://www.apache.org/licenses/LICENSE-2.0
+#
+# Unless required by applicable law or agreed to in writing, software
+# distributed under the License is distributed on an "AS IS" BASIS,
+# WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+# See the License for the specific language governing permissions and
+# limitations under the License.
+#
+
+# Distributed rendering test for the standalone Cycles application.
+#
+# Starts render servers on consecutive ports of the local host and renders a
+# small scene with all of them through the network device. The test passes when
+# every server was connected for every render, and the images match the same
+# scene rendered on the local CPU. Rendering twice checks servers reusing their
+# data cache.
+#
+# Example:
+#   ./cycles_network_test.py --cycles ./bin/cycles --server ./bin/cycles_server \
+#       --directory /tmp/cycles_network_test
+
+import argparse
+import os
+import subprocess
+import sys
+import time
+
+SCENE = """<cycles>
+<transform matrix="1 0 0 0  0 1 0 0  0 0 1 0  0 0 -4 1">
+<camera width="%(width)d" height="%(height)d" type="perspective" fov="0.8" />
+</transform>
+<background><background name="bg" strength="0.5" color="0.6 0.7 0.9" />
+<connect from="bg background" to="output surface" /></background>
+<shader name="diffuse"><diffuse_bsdf name="bsdf" color="0.8 0.4 0.2" />
+<connect from="bsdf bsdf" to="output surface" /></shader>
+<state shader="diffuse">
+<mesh P="-1 -1 0  1 -1 0  1 1 0  -1 1 0  -1 -1 0  -1 1 0  -1 1 1  -1 -1 1"
+      nverts="4 4" verts="0 1 2 3 4 5 6 7" />
+</state>
+</cycles>
+"""
+
+
+def start_servers(args):
+    processes = []
+    addresses = []
+    for i in range(args.servers):
+        port = args.port + i
+        command = [args.server,
+                   "--device", "CPU",
+                   "--threads", "1",
+                   "--port", str(port)]
+        processes.append(subprocess.Popen(command,
+                                          stdout=subprocess.PIPE,
+                                          universal_newlines=True))
+        addresses.append("127.0.0.1:%d" % port)
+
+    # Give the servers time to start listening.
+    time.sleep(2.0)
+
+    # Servers that failed to start, for example on a port that is in use, would only show up
+    # later as unused, stop with their output instead.
+    for address, process in zip(addresses, processes):
+        if process.poll() is not None:
+            for other in processes:
+                if other.poll() is None:
+                    other.terminate()
+            log = process.communicate()[0]
+            sys.exit("FAILED: server %s exited on startup:\n%s" % (address, log))
+
+    return processes, addresses
+
+
+def render(args, scene, output, device, addresses=None):
+    command = [args.cycles, "--background", "--quiet",
+               "--device", device,
+               "--samples", "16",
+               "--tile-width", "16",
+               "--tile-height", "16",
+               "--output", output]
+    if addresses:
+        command += ["--servers", ",".join(addresses)]
+    subprocess.check_call(command + [scene], timeout=args.timeout)
+
+    with open(output, "rb") as f:
+        return f.read()
+
+
+def main():
+    parser = argparse.ArgumentParser(description="Test rendering on several local servers.")
+    parser.add_argument("--cycles", required=True, help="Path to the standalone cycles binary")
+    parser.add_argument("--server", required=True, help="Path to the cycles_server binary")
+    parser.add_argument("--directory", required=True, help="Directory to write files to")
+    parser.add_argument("--servers", type=int, default=2, help="Number of local servers")
+    parser.add_argument("--port", type=int, default=5320, help="Port of the first server")
+    parser.add_argument("--timeout", type=float, default=120.0,
+                        help="Seconds before a render is considered hanging")
+    args = parser.parse_args()
+
+    os.makedirs(args.directory, exist_ok=True)
+    scene = os.path.join(args.directory, "network_test.xml")
+    with open(scene, "w") as f:
+        f.write(SCENE % {"width": 128, "height": 96})
+
+    expected = render(args, scene, os.path.join(args.directory, "cpu.png"), "CPU")
+
+    processes, addresses = start_servers(args)
+    failed = []
+    try:
+        for run in ("first", "cached"):
+            output = os.path.join(args.directory, "network_%s.png" % run)
+            if render(args, scene, output, "NETWORK", addresses) != expected:
+                failed.append("%s network render differs from the CPU render" % run)
+    finally:
+        for process in processes:
+            process.terminate()
+        for address, process in zip(addresses, processes):
+            log = process.communicate()[0]
+            if log.count("Connected to remote client") < 2:
+                failed.append("server %s was not used for every render" % address)
+
+    for message in failed:
+        print("FAILED: " + message)
+    if failed:
+        sys.exit(1)
+    print("PASSED: %d servers" % len(addresses))
+
+
+if __name__ == "__main__":
+    main()
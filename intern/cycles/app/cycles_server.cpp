@@ -17,11 +17,13 @@
 #include <stdio.h>
 
 #include "device/device.h"
+#include "device/device_network.h"
 
 #include "util/util_args.h"
 #include "util/util_foreach.h"
 #include "util/util_logging.h"
 #include "util/util_path.h"
+#include "util/util_profiling.h"
 #include "util/util_stats.h"
 #include "util/util_string.h"
 #include "util/util_task.h"
@@ -38,8 +40,9 @@ int main(int argc, const char **argv)
   string devicename = "cpu";
   bool list = false, debug = false;
   int threads = 0, verbosity = 1;
+  int port = SERVER_PORT, cache_size = 1024;
 
-  vector<DeviceType> &types = Device::available_types();
+  vector<DeviceType> types = Device::available_types();
 
   foreach (DeviceType type, types) {
     if (devicelist != "")
@@ -61,6 +64,12 @@ int main(int argc, const char **argv)
              "--threads %d",
              &threads,
              "Number of threads to use for CPU device",
+             "--port %d",
+             &port,
+             "Port to listen on, to run multiple servers on the same host",
+             "--cache-size %d",
+             &cache_size,
+             "Megabytes of scene data to keep for clients rendering the same scene again",
 #ifdef WITH_CYCLES_LOGGING
              "--debug",
              &debug,
@@ -83,7 +92,7 @@ int main(int argc, const char **argv)
   }
 
   if (list) {
-    vector<DeviceInfo> &devices = Device::available_devices();
+    vector<DeviceInfo> devices = Device::available_devices();
 
     printf("Devices:\n");
 
@@ -96,7 +105,7 @@ int main(int argc, const char **argv)
 
   /* find matching device */
   DeviceType device_type = Device::type_from_string(devicename.c_str());
-  vector<DeviceInfo> &devices = Device::available_devices();
+  vector<DeviceInfo> devices = Device::available_devices();
   DeviceInfo device_info;
 
   foreach (DeviceInfo &device, devices) {
@@ -110,9 +119,10 @@ int main(int argc, const char **argv)
 
   while (1) {
     Stats stats;
-    Device *device = Device::create(device_info, stats, true);
-    printf("Cycles Server with device: %s\n", device->info.description.c_str());
-    device->server_run();
+    Profiler profiler;
+    Device *device = Device::create(device_info, stats, profiler, true);
+    printf("Cycles Server with device: %s, port: %d\n", device->info.description.c_str(), port);
+    device->server_run(port, (size_t)cache_size * 1024 * 1024);
     delete device;
   }
 
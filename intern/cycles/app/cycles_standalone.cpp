@@ -19,18 +19,22 @@
 #include "device/device.h"
 #include "render/buffers.h"
 #include "render/camera.h"
+#include "render/film.h"
 #include "render/integrator.h"
 #include "render/scene.h"
 #include "render/session.h"
+#include "render/stats.h"
 
 #include "util/util_args.h"
 #include "util/util_foreach.h"
 #include "util/util_function.h"
 #include "util/util_image.h"
 #include "util/util_logging.h"
+#include "util/util_map.h"
 #include "util/util_path.h"
 #include "util/util_progress.h"
 #include "util/util_string.h"
+#include "util/util_task.h"
 #include "util/util_time.h"
 #include "util/util_transform.h"
 #include "util/util_unique_ptr.h"
@@ -54,6 +58,9 @@ struct Options {
   bool quiet;
   bool show_help, interactive, pause;
   string output_path;
+  string stats_path;
+  string profile_path;
+  double load_time;
 } options;
 
 static void session_print(const string &str)
@@ -120,6 +127,7 @@ static BufferParams &session_buffer_params()
   buffer_params.height = options.height;
   buffer_params.full_width = options.width;
   buffer_params.full_height = options.height;
+  buffer_params.denoising_data_pass = options.session_params.denoising.use;
 
   return buffer_params;
 }
@@ -128,21 +136,33 @@ static void scene_init()
 {
   options.scene = new Scene(options.scene_params, options.session->device);
 
+  /* Time spent in each manager, for the statistics file. */
+  if (!options.stats_path.empty()) {
+    options.scene->enable_update_stats();
+  }
+
   /* Read XML */
+  double load_start = time_dt();
   xml_read_file(options.scene, options.filepath.c_str());
+  options.load_time = time_dt() - load_start;
 
   /* Camera width/height override? */
   if (!(options.width == 0 || options.height == 0)) {
-    options.scene->camera->width = options.width;
-    options.scene->camera->height = options.height;
+    options.scene->camera->set_full_width(options.width);
+    options.scene->camera->set_full_height(options.height);
   }
   else {
-    options.width = options.scene->camera->width;
-    options.height = options.scene->camera->height;
+    options.width = options.scene->camera->get_full_width();
+    options.height = options.scene->camera->get_full_height();
   }
 
   /* Calculate Viewplane */
   options.scene->camera->compute_auto_viewplane();
+
+  /* Denoising reads its features from the denoising data passes. */
+  if (options.session_params.denoising.use) {
+    options.scene->film->set_denoising_data_pass(true);
+  }
 }
 
 static void session_init()
@@ -165,6 +185,119 @@ static void session_init()
   options.session->start();
 }
 
+/* Statistics for benchmarking, written as JSON. */
+
+static string json_update_times(const char *name, const UpdateTimeStats &stats, bool last)
+{
+  /* Sum entries with the same name, as some updates run in multiple passes. */
+  map<string, double> times;
+  foreach (const NamedTimeEntry &entry, stats.times.entries) {
+    times[entry.name] += entry.time;
+  }
+
+  string result = string_printf("    \"%s\": {", name);
+  for (map<string, double>::iterator it = times.begin(); it != times.end(); it++) {
+    result += string_printf("%s\n      %s: %f",
+                            (it == times.begin()) ? "" : ",",
+                            string_json_quote(it->first).c_str(),
+                            it->second);
+  }
+  return result + (times.empty() ? "}" : "\n    }") + (last ? "\n" : ",\n");
+}
+
+static bool write_stats(const string &filepath)
+{
+  Session *session = options.session;
+  Scene *scene = session->scene;
+  SceneUpdateStats *update_stats = scene->update_stats;
+
+  RenderStats render_stats;
+  session->collect_statistics(&render_stats);
+
+  double total_time, render_time;
+  session->progress.get_time(total_time, render_time);
+  const double denoise_time = session->progress.get_denoise_time();
+  const uint64_t pixel_samples = session->progress.get_pixel_samples();
+
+  /* BVH building is timed as part of the geometry update. */
+  double bvh_time = 0.0;
+  foreach (const NamedTimeEntry &entry, update_stats->geometry.times.entries) {
+    if (entry.name.find("BVH") != string::npos) {
+      bvh_time += entry.time;
+    }
+  }
+
+  FILE *f = fopen(filepath.c_str(), "w");
+  if (!f) {
+    return false;
+  }
+
+  fprintf(f, "{\n");
+  fprintf(f, "  \"scene\": %s,\n", string_json_quote(options.filepath).c_str());
+  fprintf(f, "  \"device\": %s,\n", string_json_quote(session->device->info.description).c_str());
+  fprintf(f, "  \"threads\": %d,\n", TaskScheduler::num_threads());
+  fprintf(f, "  \"width\": %d,\n", options.width);
+  fprintf(f, "  \"height\": %d,\n", options.height);
+  fprintf(f, "  \"samples\": %d,\n", options.session_params.samples);
+
+  /* Render time includes denoising, which runs alongside rendering of other tiles. */
+  fprintf(f, "  \"time\": {\n");
+  fprintf(f, "    \"total\": %f,\n", total_time + options.load_time);
+  fprintf(f, "    \"load\": %f,\n", options.load_time);
+  fprintf(f, "    \"sync\": %f,\n", update_stats->scene.times.total_time);
+  fprintf(f, "    \"bvh\": %f,\n", bvh_time);
+  fprintf(f, "    \"images\": %f,\n", update_stats->image.times.total_time);
+  fprintf(f, "    \"render\": %f,\n", render_time);
+  fprintf(f, "    \"denoise\": %f\n", denoise_time);
+  fprintf(f, "  },\n");
+
+  fprintf(f,
+          "  \"samples_per_second\": %f,\n",
+          (render_time > 0.0) ? (double)pixel_samples / render_time : 0.0);
+
+  fprintf(f, "  \"memory\": {\n");
+  fprintf(f, "    \"peak\": %zu,\n", session->stats.mem_peak);
+  fprintf(f, "    \"geometry\": %zu,\n", render_stats.mesh.geometry.total_size);
+  fprintf(f, "    \"textures\": %zu\n", render_stats.image.textures.total_size);
+  fprintf(f, "  },\n");
+
+  fprintf(f, "  \"updates\": {\n");
+  fputs(json_update_times("scene", update_stats->scene, false).c_str(), f);
+  fputs(json_update_times("geometry", update_stats->geometry, false).c_str(), f);
+  fputs(json_update_times("object", update_stats->object, false).c_str(), f);
+  fputs(json_update_times("light", update_stats->light, false).c_str(), f);
+  fputs(json_update_times("image", update_stats->image, false).c_str(), f);
+  fputs(json_update_times("background", update_stats->background, false).c_str(), f);
+  fputs(json_update_times("camera", update_stats->camera, false).c_str(), f);
+  fputs(json_update_times("film", update_stats->film, false).c_str(), f);
+  fputs(json_update_times("integrator", update_stats->integrator, false).c_str(), f);
+  fputs(json_update_times("osl", update_stats->osl, false).c_str(), f);
+  fputs(json_update_times("particles", update_stats->particles, false).c_str(), f);
+  fputs(json_update_times("svm", update_stats->svm, false).c_str(), f);
+  fputs(json_update_times("tables", update_stats->tables, true).c_str(), f);
+  fprintf(f, "  }\n");
+  fprintf(f, "}\n");
+
+  fclose(f);
+  return true;
+}
+
+/* Time per kernel event, shader and object, sampled while rendering on the CPU. */
+static bool write_profile(const string &filepath)
+{
+  RenderStats render_stats;
+  options.session->collect_statistics(&render_stats);
+
+  FILE *f = fopen(filepath.c_str(), "w");
+  if (!f) {
+    return false;
+  }
+
+  fputs(render_stats.profiling_json_report().c_str(), f);
+  fclose(f);
+  return true;
+}
+
 static void session_exit()
 {
   if (options.session) {
@@ -233,7 +366,7 @@ static void display()
 static void motion(int x, int y, int button)
 {
   if (options.interactive) {
-    Transform matrix = options.session->scene->camera->matrix;
+    Transform matrix = options.session->scene->camera->get_matrix();
 
     /* Translate */
     if (button == 0) {
@@ -251,8 +384,8 @@ static void motion(int x, int y, int button)
     }
 
     /* Update and Reset */
-    options.session->scene->camera->matrix = matrix;
-    options.session->scene->camera->need_update = true;
+    options.session->scene->camera->set_matrix(matrix);
+    options.session->scene->camera->need_flags_update = true;
     options.session->scene->camera->need_device_update = true;
 
     options.session->reset(session_buffer_params(), options.session_params.samples);
@@ -266,10 +399,10 @@ static void resize(int width, int height)
 
   if (options.session) {
     /* Update camera */
-    options.session->scene->camera->width = width;
-    options.session->scene->camera->height = height;
+    options.session->scene->camera->set_full_width(width);
+    options.session->scene->camera->set_full_height(height);
     options.session->scene->camera->compute_auto_viewplane();
-    options.session->scene->camera->need_update = true;
+    options.session->scene->camera->need_flags_update = true;
     options.session->scene->camera->need_device_update = true;
 
     options.session->reset(session_buffer_params(), options.session_params.samples);
@@ -302,7 +435,7 @@ static void keyboard(unsigned char key)
 
   /* Navigation */
   else if (options.interactive && (key == 'w' || key == 'a' || key == 's' || key == 'd')) {
-    Transform matrix = options.session->scene->camera->matrix;
+    Transform matrix = options.session->scene->camera->get_matrix();
     float3 translate;
 
     if (key == 'w')
@@ -317,8 +450,8 @@ static void keyboard(unsigned char key)
     matrix = matrix * transform_translate(translate);
 
     /* Update and Reset */
-    options.session->scene->camera->matrix = matrix;
-    options.session->scene->camera->need_update = true;
+    options.session->scene->camera->set_matrix(matrix);
+    options.session->scene->camera->need_flags_update = true;
     options.session->scene->camera->need_device_update = true;
 
     options.session->reset(session_buffer_params(), options.session_params.samples);
@@ -345,10 +478,10 @@ static void keyboard(unsigned char key)
         break;
     }
 
-    options.session->scene->integrator->max_bounce = bounce;
+    options.session->scene->integrator->set_max_bounce(bounce);
 
     /* Update and Reset */
-    options.session->scene->integrator->need_update = true;
+    options.session->scene->integrator->tag_update(options.session->scene);
 
     options.session->reset(session_buffer_params(), options.session_params.samples);
   }
@@ -392,6 +525,9 @@ static void options_parse(int argc, const char **argv)
   ArgParse ap;
   bool help = false, debug = false, version = false;
   int verbosity = 1;
+  int texture_cache_size = 0;
+  string servers = "";
+  string denoiser = "";
 
   ap.options("Usage: cycles [options] file.xml",
              "%*",
@@ -432,9 +568,27 @@ static void options_parse(int argc, const char **argv)
              "--tile-height %d",
              &options.session_params.tile_size.y,
              "Tile height in pixels",
+             "--denoising %s",
+             &denoiser,
+             "Denoise the render: nlm, openimagedenoise",
+             "--texture-cache-size %d",
+             &texture_cache_size,
+             "Read image textures on demand, with a cache of this size in megabytes (CPU only)",
              "--list-devices",
              &list,
              "List information about all available devices",
+             "--stats-json %s",
+             &options.stats_path,
+             "File path to write render time per phase and memory statistics to, as JSON",
+             "--profile-json %s",
+             &options.profile_path,
+             "File path to write render time per kernel event, shader and object to, as JSON "
+             "(CPU only)",
+#ifdef WITH_NETWORK
+             "--servers %s",
+             &servers,
+             "Comma separated render servers as host[:port], for the network device",
+#endif
 #ifdef WITH_CYCLES_LOGGING
              "--debug",
              &debug,
@@ -489,6 +643,20 @@ static void options_parse(int argc, const char **argv)
   else if (ssname == "svm")
     options.scene_params.shadingsystem = SHADINGSYSTEM_SVM;
 
+  if (denoiser == "nlm") {
+    options.session_params.denoising.use = true;
+    options.session_params.denoising.type = DENOISER_NLM;
+  }
+  else if (denoiser == "openimagedenoise") {
+    options.session_params.denoising.use = true;
+    options.session_params.denoising.type = DENOISER_OPENIMAGEDENOISE;
+  }
+
+  if (texture_cache_size > 0) {
+    options.scene_params.use_texture_cache = true;
+    options.scene_params.texture_cache_size = texture_cache_size;
+  }
+
 #ifndef WITH_CYCLES_STANDALONE_GUI
   options.session_params.background = true;
 #endif
@@ -506,6 +674,22 @@ static void options_parse(int argc, const char **argv)
     device_available = true;
   }
 
+#ifdef WITH_NETWORK
+  /* Render on each of the servers, tiles are handed out to them as they finish. */
+  if (device_type == DEVICE_NETWORK && servers != "") {
+    vector<string> addresses;
+    string_split(addresses, servers, ",");
+
+    vector<DeviceInfo> subdevices;
+    foreach (const string &address, addresses) {
+      subdevices.push_back(Device::network_device(address));
+    }
+
+    options.session_params.device = Device::get_multi_device(
+        subdevices, options.session_params.threads, options.session_params.background);
+  }
+#endif
+
   /* handle invalid configurations */
   if (options.session_params.device.type == DEVICE_NONE || !device_available) {
     fprintf(stderr, "Unknown device: %s\n", devicename.c_str());
@@ -522,6 +706,15 @@ static void options_parse(int argc, const char **argv)
     exit(EXIT_FAILURE);
   }
 #endif
+  else if (!(denoiser == "" || options.session_params.denoising.use)) {
+    fprintf(stderr, "Unknown denoiser: %s\n", denoiser.c_str());
+    exit(EXIT_FAILURE);
+  }
+  else if (options.session_params.denoising.use &&
+           !(options.session_params.device.denoisers & options.session_params.denoising.type)) {
+    fprintf(stderr, "Denoiser not supported by device: %s\n", denoiser.c_str());
+    exit(EXIT_FAILURE);
+  }
   else if (options.session_params.samples < 0) {
     fprintf(stderr, "Invalid number of samples: %d\n", options.session_params.samples);
     exit(EXIT_FAILURE);
@@ -530,6 +723,12 @@ static void options_parse(int argc, const char **argv)
     fprintf(stderr, "No file path specified\n");
     exit(EXIT_FAILURE);
   }
+  else if (!options.profile_path.empty() && !options.session_params.device.has_profiling) {
+    fprintf(stderr, "Profiling only works with CPU device\n");
+    exit(EXIT_FAILURE);
+  }
+
+  options.session_params.use_profiling = !options.profile_path.empty();
 
   /* For smoother Viewport */
   options.session_params.start_resolution = 64;
@@ -550,6 +749,15 @@ int main(int argc, const char **argv)
 #endif
     session_init();
     options.session->wait();
+
+    if (!options.stats_path.empty() && !write_stats(options.stats_path)) {
+      fprintf(stderr, "Failed to write statistics to %s\n", options.stats_path.c_str());
+    }
+
+    if (!options.profile_path.empty() && !write_profile(options.profile_path)) {
+      fprintf(stderr, "Failed to write profile to %s\n", options.profile_path.c_str());
+    }
+
     session_exit();
 #ifdef WITH_CYCLES_STANDALONE_GUI
   }
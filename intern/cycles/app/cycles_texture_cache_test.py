@@ -0,0 +1,135 @@
+#!/usr/bin/env python3
+#
+# Copyright 2011-2020 Blender Foundation
+#
+# Licensed under the Apache License, Version 2.0 (the "License");
+# you may not use this file except in compliance with the License.
+# You may obtain a copy of the License at
+#
+# http://www.apache.org/licenses/LICENSE-2.0
+#
+# Unless required by applicable law or agreed to in writing, software
+# distributed under the License is distributed on an "AS IS" BASIS,
+# WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+# See the License for the specific language governing permissions and
+# limitations under the License.
+#
+
+# Texture cache test for the standalone Cycles application.
+#
+# Renders an image texture on a plane, once with the image loaded into device
+# memory and once read through the texture cache. The test passes when the
+# texture cache was used, and the renders match. Closest interpolation near
+# the camera reads the full resolution image, linear interpolation far from
+# the camera reads mipmap levels, which gives the same colors for a gradient.
+#
+# Example:
+#   ./cycles_texture_cache_test.py --cycles ./bin/cycles --directory /tmp/texture_cache_test
+
+import argparse
+import json
+import os
+import subprocess
+import sys
+
+IMAGE_SIZE = 512
+
+SCENE = """<cycles>
+<transform matrix="1 0 0 0  0 1 0 0  0 0 1 0  0 0 %(distance)f 1">
+<camera width="128" height="128" type="perspective" fov="0.8" />
+</transform>
+<background><background name="bg" strength="0.0" />
+<connect from="bg background" to="output surface" /></background>
+<shader name="image">
+<image_texture name="tex" filename="gradient.ppm" interpolation="%(interpolation)s" />
+<emission name="emission" strength="1.0" />
+<connect from="tex color" to="emission color" />
+<connect from="emission emission" to="output surface" />
+</shader>
+<state shader="image">
+<mesh P="-1 -1 0  1 -1 0  1 1 0  -1 1 0" nverts="4" verts="0 1 2 3"
+      UV="0 0  1 0  1 1  0 1" />
+</state>
+</cycles>
+"""
+
+# Name, interpolation, camera distance and largest mean difference in 8 bit levels.
+CASES = (
+    ("closest_near", "closest", -2.5, 0.5),
+    ("linear_far", "linear", -40.0, 2.0),
+)
+
+
+def write_gradient(filepath):
+    pixels = bytearray()
+    for y in range(IMAGE_SIZE):
+        for x in range(IMAGE_SIZE):
+            pixels += bytes((x * 255 // (IMAGE_SIZE - 1), y * 255 // (IMAGE_SIZE - 1), 128))
+    with open(filepath, "wb") as f:
+        f.write(b"P6\n%d %d\n255\n" % (IMAGE_SIZE, IMAGE_SIZE))
+        f.write(pixels)
+
+
+def read_ppm(filepath):
+    with open(filepath, "rb") as f:
+        data = f.read()
+    # Header fields are separated by whitespace, the pixels follow at the end of the file.
+    fields = data.split(maxsplit=4)
+    if fields[0] != b"P6" or fields[3] != b"255":
+        raise ValueError("unsupported image %s" % filepath)
+    size = int(fields[1]) * int(fields[2]) * 3
+    return data[-size:]
+
+
+def render(args, scene, name, texture_cache):
+    output = os.path.join(args.directory, name + ".ppm")
+    stats = os.path.join(args.directory, name + ".json")
+    command = [args.cycles, "--background", "--quiet",
+               "--samples", "16",
+               "--output", output,
+               "--stats-json", stats]
+    if texture_cache:
+        command += ["--texture-cache-size", "64"]
+    subprocess.check_call(command + [scene])
+
+    with open(stats) as f:
+        textures_memory = json.load(f)["memory"]["textures"]
+    return read_ppm(output), textures_memory
+
+
+def main():
+    parser = argparse.ArgumentParser(description="Test rendering with the texture cache.")
+    parser.add_argument("--cycles", required=True, help="Path to the standalone cycles binary")
+    parser.add_argument("--directory", required=True, help="Directory to write files to")
+    args = parser.parse_args()
+
+    os.makedirs(args.directory, exist_ok=True)
+    write_gradient(os.path.join(args.directory, "gradient.ppm"))
+
+    failed = []
+    for name, interpolation, distance, max_difference in CASES:
+        scene = os.path.join(args.directory, name + ".xml")
+        with open(scene, "w") as f:
+            f.write(SCENE % {"distance": distance, "interpolation": interpolation})
+
+        expected, loaded_memory = render(args, scene, name + "_loaded", False)
+        result, cached_memory = render(args, scene, name + "_cached", True)
+
+        # The cache only holds a small description per image in device memory.
+        if cached_memory * 100 > loaded_memory:
+            failed.append("%s: image was not read through the texture cache" % name)
+
+        difference = sum(abs(a - b) for a, b in zip(expected, result)) / len(expected)
+        if len(result) != len(expected) or difference > max_difference:
+            failed.append("%s: mean difference %.3f, expected at most %.3f" %
+                          (name, difference, max_difference))
+
+    for message in failed:
+        print("FAILED: " + message)
+    if failed:
+        sys.exit(1)
+    print("PASSED: %d cases" % len(CASES))
+
+
+if __name__ == "__main__":
+    main()
@@ -26,6 +26,7 @@
 #include "render/camera.h"
 #include "render/film.h"
 #include "render/graph.h"
+#include "render/hair.h"
 #include "render/integrator.h"
 #include "render/light.h"
 #include "render/mesh.h"
@@ -190,17 +191,19 @@ static void xml_read_camera(XMLReadState &state, xml_node node)
 {
   Camera *cam = state.scene->camera;
 
-  xml_read_int(&cam->width, node, "width");
-  xml_read_int(&cam->height, node, "height");
-
-  cam->full_width = cam->width;
-  cam->full_height = cam->height;
+  int width, height;
+  if (xml_read_int(&width, node, "width")) {
+    cam->set_full_width(width);
+  }
+  if (xml_read_int(&height, node, "height")) {
+    cam->set_full_height(height);
+  }
 
   xml_read_node(state, cam, node);
 
-  cam->matrix = state.tfm;
+  cam->set_matrix(state.tfm);
 
-  cam->need_update = true;
+  cam->need_flags_update = true;
   cam->update(state.scene);
 }
 
@@ -338,11 +341,11 @@ static void xml_read_shader_graph(XMLReadState &state, Shader *shader, xml_node
 
     if (node_name == "image_texture") {
       ImageTextureNode *img = (ImageTextureNode *)snode;
-      img->filename = path_join(state.base, img->filename.string());
+      img->set_filename(ustring(path_join(state.base, img->get_filename().string())));
     }
     else if (node_name == "environment_texture") {
       EnvironmentTextureNode *env = (EnvironmentTextureNode *)snode;
-      env->filename = path_join(state.base, env->filename.string());
+      env->set_filename(ustring(path_join(state.base, env->get_filename().string())));
     }
 
     if (snode) {
@@ -374,6 +377,29 @@ static void xml_read_background(XMLReadState &state, xml_node node)
   xml_read_shader_graph(state, shader, node);
 }
 
+/* Object */
+
+static void xml_add_object(Scene *scene, Geometry *geom, const Transform &tfm)
+{
+  Object *object = new Object();
+  object->set_geometry(geom);
+  object->set_tfm(tfm);
+  scene->objects.push_back(object);
+}
+
+static void xml_read_geometry_state(const XMLReadState &state, Geometry *geom, xml_node node)
+{
+  /* name for instancing */
+  string name;
+  if (xml_read_string(&name, node, "name")) {
+    geom->name = ustring(name);
+  }
+
+  array<Node *> used_shaders;
+  used_shaders.push_back_slow(state.shader);
+  geom->set_used_shaders(used_shaders);
+}
+
 /* Mesh */
 
 static Mesh *xml_add_mesh(Scene *scene, const Transform &tfm)
@@ -383,10 +409,7 @@ static Mesh *xml_add_mesh(Scene *scene, const Transform &tfm)
   scene->geometry.push_back(mesh);
 
   /* create object*/
-  Object *object = new Object();
-  object->geometry = mesh;
-  object->tfm = tfm;
-  scene->objects.push_back(object);
+  xml_add_object(scene, mesh, tfm);
 
   return mesh;
 }
@@ -395,7 +418,7 @@ static void xml_read_mesh(const XMLReadState &state, xml_node node)
 {
   /* add mesh */
   Mesh *mesh = xml_add_mesh(state.scene, state.tfm);
-  mesh->used_shaders.push_back(state.shader);
+  xml_read_geometry_state(state, mesh, node);
 
   /* read state */
   int shader = 0;
@@ -411,20 +434,22 @@ static void xml_read_mesh(const XMLReadState &state, xml_node node)
   xml_read_int_array(nverts, node, "nverts");
 
   if (xml_equal_string(node, "subdivision", "catmull-clark")) {
-    mesh->subdivision_type = Mesh::SUBDIVISION_CATMULL_CLARK;
+    mesh->set_subdivision_type(Mesh::SUBDIVISION_CATMULL_CLARK);
   }
   else if (xml_equal_string(node, "subdivision", "linear")) {
-    mesh->subdivision_type = Mesh::SUBDIVISION_LINEAR;
+    mesh->set_subdivision_type(Mesh::SUBDIVISION_LINEAR);
   }
 
-  if (mesh->subdivision_type == Mesh::SUBDIVISION_NONE) {
-    /* create vertices */
-    mesh->verts = P;
+  array<float3> P_array;
+  P_array = P;
 
+  if (mesh->get_subdivision_type() == Mesh::SUBDIVISION_NONE) {
+    /* create vertices */
     size_t num_triangles = 0;
     for (size_t i = 0; i < nverts.size(); i++)
       num_triangles += nverts[i] - 2;
-    mesh->reserve_mesh(mesh->verts.size(), num_triangles);
+    mesh->reserve_mesh(P_array.size(), num_triangles);
+    mesh->set_verts(P_array);
 
     /* create triangles */
     int index_offset = 0;
@@ -474,8 +499,6 @@ static void xml_read_mesh(const XMLReadState &state, xml_node node)
   }
   else {
     /* create vertices */
-    mesh->verts = P;
-
     size_t num_ngons = 0;
     size_t num_corners = 0;
     for (size_t i = 0; i < nverts.size(); i++) {
@@ -483,6 +506,7 @@ static void xml_read_mesh(const XMLReadState &state, xml_node node)
       num_corners += nverts[i];
     }
     mesh->reserve_subd_faces(nverts.size(), num_ngons, num_corners);
+    mesh->set_verts(P_array);
 
     /* create subd_faces */
     int index_offset = 0;
@@ -513,33 +537,92 @@ static void xml_read_mesh(const XMLReadState &state, xml_node node)
     }
 
     /* setup subd params */
-    if (!mesh->subd_params) {
-      mesh->subd_params = new SubdParams(mesh);
-    }
-    SubdParams &sdparams = *mesh->subd_params;
-
-    sdparams.dicing_rate = state.dicing_rate;
-    xml_read_float(&sdparams.dicing_rate, node, "dicing_rate");
-    sdparams.dicing_rate = std::max(0.1f, sdparams.dicing_rate);
+    float dicing_rate = state.dicing_rate;
+    xml_read_float(&dicing_rate, node, "dicing_rate");
+    dicing_rate = std::max(0.1f, dicing_rate);
 
-    sdparams.objecttoworld = state.tfm;
+    mesh->set_subd_dicing_rate(dicing_rate);
+    mesh->set_subd_objecttoworld(state.tfm);
   }
 
   /* we don't yet support arbitrary attributes, for now add vertex
    * coordinates as generated coordinates if requested */
   if (mesh->need_attribute(state.scene, ATTR_STD_GENERATED)) {
     Attribute *attr = mesh->attributes.add(ATTR_STD_GENERATED);
-    memcpy(attr->data_float3(), mesh->verts.data(), sizeof(float3) * mesh->verts.size());
+    memcpy(attr->data_float3(),
+           mesh->get_verts().data(),
+           sizeof(float3) * mesh->get_verts().size());
   }
 }
 
+/* Hair */
+
+static void xml_read_hair(const XMLReadState &state, xml_node node)
+{
+  /* add hair */
+  Hair *hair = new Hair();
+  state.scene->geometry.push_back(hair);
+  xml_add_object(state.scene, hair, state.tfm);
+  xml_read_geometry_state(state, hair, node);
+
+  /* read keys and curves, with a radius per key or for all keys */
+  vector<float3> P;
+  vector<float> radius;
+  vector<int> nkeys;
+
+  xml_read_float3_array(P, node, "P");
+  xml_read_float_array(radius, node, "radius");
+  xml_read_int_array(nkeys, node, "nkeys");
+
+  if (radius.empty()) {
+    radius.push_back(0.01f);
+  }
+
+  hair->reserve_curves(nkeys.size(), P.size());
+
+  int first_key = 0;
+  for (size_t i = 0; i < nkeys.size(); i++) {
+    for (int j = 0; j < nkeys[i]; j++) {
+      int key = first_key + j;
+      assert(key < (int)P.size());
+
+      hair->add_curve_key(P[key], (radius.size() == P.size()) ? radius[key] : radius[0]);
+    }
+
+    hair->add_curve(first_key, 0);
+    first_key += nkeys[i];
+  }
+}
+
+/* Instance */
+
+static void xml_read_instance(const XMLReadState &state, xml_node node)
+{
+  /* another object using named mesh or hair geometry, with the current transform */
+  string name;
+
+  if (!xml_read_string(&name, node, "geometry")) {
+    fprintf(stderr, "Instance without geometry name.\n");
+    return;
+  }
+
+  foreach (Geometry *geom, state.scene->geometry) {
+    if (geom->name == name) {
+      xml_add_object(state.scene, geom, state.tfm);
+      return;
+    }
+  }
+
+  fprintf(stderr, "Unknown geometry \"%s\".\n", name.c_str());
+}
+
 /* Light */
 
 static void xml_read_light(XMLReadState &state, xml_node node)
 {
   Light *light = new Light();
 
-  light->shader = state.shader;
+  light->set_shader(state.shader);
   xml_read_node(state, light, node);
 
   state.scene->lights.push_back(light);
@@ -632,6 +715,12 @@ static void xml_read_scene(XMLReadState &state, xml_node scene_node)
     else if (string_iequals(node.name(), "mesh")) {
       xml_read_mesh(state, node);
     }
+    else if (string_iequals(node.name(), "hair")) {
+      xml_read_hair(state, node);
+    }
+    else if (string_iequals(node.name(), "instance")) {
+      xml_read_instance(state, node);
+    }
     else if (string_iequals(node.name(), "light")) {
       xml_read_light(state, node);
     }
@@ -0,0 +1,47 @@
+#
+# Copyright 2011-2020 Blender Foundation
+#
+# Licensed under the Apache License, Version 2.0 (the "License");
+# you may not use this file except in compliance with the License.
+# You may obtain a copy of the License at
+#
+# http://www.apache.org/licenses/LICENSE-2.0
+#
+# Unless required by applicable law or agreed to in writing, software
+# distributed under the License is distributed on an "AS IS" BASIS,
+# WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+# See the License for the specific language governing permissions and
+# limitations under the License.
+#
+
+# Helpers to write scenes for the standalone Cycles application, shared by the
+# benchmark scripts in this directory.
+
+import math
+
+
+def write_quads(f, quads, attributes=""):
+    P = []
+    for quad in quads:
+        for co in quad:
+            P.append("%.4f %.4f %.4f" % co)
+    num_quads = len(quads)
+    verts = " ".join(str(i) for i in range(num_quads * 4))
+    nverts = " ".join("4" for i in range(num_quads))
+    f.write('<mesh %sP="%s" nverts="%s" verts="%s" />\n' %
+            (attributes, "  ".join(P), nverts, verts))
+
+
+def camera_matrix(eye, target):
+    # Cycles cameras look along +Z with +Y up, matrix is written column by column.
+    forward = [target[i] - eye[i] for i in range(3)]
+    length = math.sqrt(sum(v * v for v in forward))
+    forward = [v / length for v in forward]
+    right = [forward[1], -forward[0], 0.0]
+    length = math.sqrt(sum(v * v for v in right))
+    right = [v / length for v in right]
+    up = [right[1] * forward[2] - right[2] * forward[1],
+          right[2] * forward[0] - right[0] * forward[2],
+          right[0] * forward[1] - right[1] * forward[0]]
+    values = right + [0.0] + up + [0.0] + forward + [0.0] + list(eye) + [1.0]
+    return " ".join("%.6f" % v for v in values)
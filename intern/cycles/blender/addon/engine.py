@@ -70,6 +70,9 @@ def _configure_argument_parser():
     parser.add_argument("--cycles-print-stats",
                         help="Print rendering statistics to stderr",
                         action='store_true')
+    parser.add_argument("--cycles-profile",
+                        help="Profile render time per shader and object, see engine.profiling_report()",
+                        action='store_true')
     parser.add_argument("--cycles-device",
                         help="Set the device to use for Cycles, overriding user preferences and the scene setting."
                              "Valid options are 'CPU', 'CUDA', 'OPTIX' or 'OPENCL'."
@@ -107,6 +110,10 @@ def _parse_command_line():
         import _cycles
         _cycles.enable_print_stats()
 
+    if args.cycles_profile:
+        import _cycles
+        _cycles.enable_profiling()
+
     if args.cycles_device:
         import _cycles
         _cycles.set_device_override(args.cycles_device)
@@ -176,6 +183,23 @@ def render(engine, depsgraph):
         _cycles.render(engine.session, depsgraph.as_pointer())
 
 
+def enable_profiling():
+    """Profile final renders on the CPU, also enabled with --cycles-profile."""
+    import _cycles
+    _cycles.enable_profiling()
+
+
+def profiling_report():
+    """
+    Render time per kernel event, shader and object of the last final render of each view layer,
+    as a dictionary by view layer name. Times are in seconds, summed over all render threads.
+    Relative cost is the time per hit compared to the average of all shaders or objects.
+    """
+    import _cycles
+    import json
+    return json.loads(_cycles.profiling_report())
+
+
 def bake(engine, depsgraph, obj, pass_type, pass_filter, width, height):
     import _cycles
     session = getattr(engine, "session", None)
@@ -266,6 +290,7 @@ def list_render_passes(scene, srl):
     if crl.pass_debug_bvh_intersections:       yield ("Debug BVH Intersections",       "X",   'VALUE')
     if crl.pass_debug_ray_bounces:             yield ("Debug Ray Bounces",             "X",   'VALUE')
     if crl.pass_debug_sample_count:            yield ("Debug Sample Count",            "X",   'VALUE')
+    if crl.pass_debug_render_cost:             yield ("Debug Render Cost",             "RGB", 'COLOR')
     if crl.use_pass_volume_direct:             yield ("VolumeDir",                     "RGB", 'COLOR')
     if crl.use_pass_volume_indirect:           yield ("VolumeInd",                     "RGB", 'COLOR')
 
@@ -397,6 +397,12 @@ class CyclesRenderSettings(bpy.types.PropertyGroup):
         min=0.0, max=1.0,
         default=0.01,
     )
+    use_light_tree: BoolProperty(
+        name="Light Tree",
+        description="Pick lights by their estimated contribution to the shading point instead of their area, "
+        "reducing noise in scenes with many lights (slower to sample a light)",
+        default=False,
+    )
 
     use_adaptive_sampling: BoolProperty(
         name="Use Adaptive Sampling",
@@ -708,6 +714,19 @@ class CyclesRenderSettings(bpy.types.PropertyGroup):
         "but time can be saved by manually stopping the render when the noise is low enough)",
         default=False,
     )
+    use_texture_cache: BoolProperty(
+        name="Texture Cache",
+        description="Read image textures on demand in tiles and at the resolution needed for rendering, "
+        "instead of loading them fully before rendering (CPU only, works best with tiled and mipmapped "
+        "images such as .tx files)",
+        default=False,
+    )
+    texture_cache_size: IntProperty(
+        name="Cache Size",
+        description="Maximum memory used by the texture cache, in megabytes",
+        default=1024,
+        min=16, max=1048576,
+    )
 
     bake_type: EnumProperty(
         name="Bake Type",
@@ -1370,6 +1389,13 @@ class CyclesRenderLayerSettings(bpy.types.PropertyGroup):
         default=False,
         update=update_render_passes,
     )
+    pass_debug_render_cost: BoolProperty(
+        name="Debug Render Cost",
+        description="Render time per sample and pixel as false color, from 1 microsecond (black) "
+        "to 1 millisecond (white) on a logarithmic scale (CPU only)",
+        default=False,
+        update=update_render_passes,
+    )
     use_pass_volume_direct: BoolProperty(
         name="Volume Direct",
         description="Deliver direct volumetric scattering pass",
@@ -958,6 +958,27 @@ static PyObject *enable_print_stats_func(PyObject * /*self*/, PyObject * /*args*
   Py_RETURN_NONE;
 }
 
+static PyObject *enable_profiling_func(PyObject * /*self*/, PyObject * /*args*/)
+{
+  BlenderSession::profile_render = true;
+  Py_RETURN_NONE;
+}
+
+static PyObject *profiling_report_func(PyObject * /*self*/, PyObject * /*args*/)
+{
+  /* JSON object with the report of each view layer. */
+  string report = "{";
+  for (map<string, string>::const_iterator it = BlenderSession::profiling_reports.begin();
+       it != BlenderSession::profiling_reports.end();
+       it++) {
+    report += (it == BlenderSession::profiling_reports.begin()) ? "\n" : ",\n";
+    report += string_json_quote(it->first) + ": " + it->second;
+  }
+  report += "}\n";
+
+  return PyUnicode_FromString(report.c_str());
+}
+
 static PyObject *get_device_types_func(PyObject * /*self*/, PyObject * /*args*/)
 {
   vector<DeviceType> device_types = Device::available_types();
@@ -1043,6 +1064,8 @@ static PyMethodDef methods[] = {
 
     /* Statistics. */
     {"enable_print_stats", enable_print_stats_func, METH_NOARGS, ""},
+    {"enable_profiling", enable_profiling_func, METH_NOARGS, ""},
+    {"profiling_report", profiling_report_func, METH_NOARGS, ""},
 
     /* Resumable render */
     {"set_resumable_chunk", set_resumable_chunk_func, METH_VARARGS, ""},
@@ -25,6 +25,7 @@
 #include "render/scene.h"
 #include "render/session.h"
 
+#include "util/util_map.h"
 #include "util/util_vector.h"
 
 CCL_NAMESPACE_BEGIN
@@ -148,6 +149,14 @@ class BlenderSession {
 
   static bool print_render_stats;
 
+  /* ** Profiling ** */
+
+  /* Sample render time per kernel event, shader and object in final renders on the CPU. */
+  static bool profile_render;
+
+  /* JSON report of the last final render of each view layer, by view layer name. */
+  static map<string, string> profiling_reports;
+
  protected:
   void stamp_view_layer_metadata(Scene *scene, const string &view_layer_name);
 
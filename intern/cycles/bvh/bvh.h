@@ -91,6 +91,13 @@ class BVH {
   {
   }
 
+  /* Check whether the BVH can be refit to the current vertices of its geometry, rather than
+   * built again. This is only a hint for BVH types that track what changed since the build. */
+  virtual bool can_refit() const
+  {
+    return true;
+  }
+
  protected:
   BVH(const BVHParams &params,
       const vector<Geometry *> &geometry,
@@ -62,6 +62,12 @@ static_assert(Object::MAX_MOTION_STEPS == Geometry::MAX_MOTION_STEPS,
 
 #  define IS_HAIR(x) (x & 1)
 
+/* Refitting keeps the tree topology of the last build while primitives move, so it gets slower
+ * to trace as they deform further. Build again once the bounds of the objects grew by this
+ * factor, or after this many refits. */
+#  define BVH_EMBREE_REFIT_MAX_AREA_GROWTH 1.5f
+#  define BVH_EMBREE_MAX_REFITS 16
+
 /* This gets called by Embree at every valid ray/object intersection.
  * Things like recording subsurface or shadow hits for later evaluation
  * as well as filtering for volume objects happen here.
@@ -304,7 +310,9 @@ BVHEmbree::BVHEmbree(const BVHParams &params_,
     : BVH(params_, geometry_, objects_),
       scene(NULL),
       rtc_device(NULL),
-      build_quality(RTC_BUILD_QUALITY_REFIT)
+      build_quality(RTC_BUILD_QUALITY_REFIT),
+      build_bounds_area(0.0f),
+      num_refits(0)
 {
   _MM_SET_FLUSH_ZERO_MODE(_MM_FLUSH_ZERO_ON);
   _MM_SET_DENORMALS_ZERO_MODE(_MM_DENORMALS_ZERO_ON);
@@ -331,6 +339,7 @@ void BVHEmbree::build(Progress &progress, Stats *stats, RTCDevice rtc_device_)
     rtcReleaseScene(scene);
     scene = NULL;
   }
+  object_states.clear();
 
   const bool dynamic = params.bvh_type == SceneParams::BVH_DYNAMIC;
 
@@ -371,6 +380,14 @@ void BVHEmbree::build(Progress &progress, Stats *stats, RTCDevice rtc_device_)
 
   rtcSetSceneProgressMonitorFunction(scene, rtc_progress_func, &progress);
   rtcCommitScene(scene);
+
+  /* Record what the tree was built for, to detect when refitting is possible. */
+  object_states.reserve(objects.size());
+  foreach (Object *ob, objects) {
+    object_states.push_back(object_state(ob));
+  }
+  build_bounds_area = objects_bounds_area();
+  num_refits = 0;
 }
 
 void BVHEmbree::add_object(Object *ob, int i)
@@ -404,6 +421,21 @@ void BVHEmbree::add_instance(Object *ob, int i)
   rtcSetGeometryInstancedScene(geom_id, instance_bvh->scene);
   rtcSetGeometryTimeStepCount(geom_id, num_motion_steps);
 
+  set_instance_transform(geom_id, ob);
+
+  rtcSetGeometryUserData(geom_id, (void *)instance_bvh->scene);
+  rtcSetGeometryMask(geom_id, ob->visibility_for_tracing());
+
+  rtcCommitGeometry(geom_id);
+  rtcAttachGeometryByID(scene, geom_id, i * 2);
+  rtcReleaseGeometry(geom_id);
+}
+
+void BVHEmbree::set_instance_transform(RTCGeometry geom_id, const Object *ob)
+{
+  const size_t num_object_motion_steps = ob->use_motion() ? ob->get_motion().size() : 1;
+  const size_t num_motion_steps = min(num_object_motion_steps, RTC_MAX_TIME_STEP_COUNT);
+
   if (ob->use_motion()) {
     array<DecomposedTransform> decomp(ob->get_motion().size());
     transform_motion_decompose(decomp.data(), ob->get_motion().data(), ob->get_motion().size());
@@ -425,13 +457,6 @@ void BVHEmbree::add_instance(Object *ob, int i)
     rtcSetGeometryTransform(
         geom_id, 0, RTC_FORMAT_FLOAT3X4_ROW_MAJOR, (const float *)&ob->get_tfm());
   }
-
-  rtcSetGeometryUserData(geom_id, (void *)instance_bvh->scene);
-  rtcSetGeometryMask(geom_id, ob->visibility_for_tracing());
-
-  rtcCommitGeometry(geom_id);
-  rtcAttachGeometryByID(scene, geom_id, i * 2);
-  rtcReleaseGeometry(geom_id);
 }
 
 void BVHEmbree::add_triangles(const Object *ob, const Mesh *mesh, int i)
@@ -671,17 +696,26 @@ void BVHEmbree::refit(Progress &progress)
 {
   progress.set_substatus("Refitting BVH nodes");
 
-  /* Update all vertex buffers, then tell Embree to rebuild/-fit the BVHs. */
+  /* Update the vertex buffers of geometry that changed since the last update, then tell Embree
+   * to refit the BVHs. Geometry is switched to refit quality the first time it deforms, which
+   * builds a tree that can be refit on later updates, while static geometry keeps the quality
+   * of a full build. */
   unsigned geom_id = 0;
   foreach (Object *ob, objects) {
     if (!params.top_level || (ob->is_traceable() && !ob->get_geometry()->is_instanced())) {
       Geometry *geom = ob->get_geometry();
 
+      if (!geom->need_refit) {
+        geom_id += 2;
+        continue;
+      }
+
       if (geom->geometry_type == Geometry::MESH || geom->geometry_type == Geometry::VOLUME) {
         Mesh *mesh = static_cast<Mesh *>(geom);
         if (mesh->num_triangles() > 0) {
           RTCGeometry geom = rtcGetGeometry(scene, geom_id);
           set_tri_vertex_buffer(geom, mesh, true);
+          rtcSetGeometryBuildQuality(geom, RTC_BUILD_QUALITY_REFIT);
           rtcCommitGeometry(geom);
         }
       }
@@ -690,14 +724,113 @@ void BVHEmbree::refit(Progress &progress)
         if (hair->num_curves() > 0) {
           RTCGeometry geom = rtcGetGeometry(scene, geom_id + 1);
           set_curve_vertex_buffer(geom, hair, true);
+          rtcSetGeometryBuildQuality(geom, RTC_BUILD_QUALITY_REFIT);
           rtcCommitGeometry(geom);
         }
       }
     }
+    else if (ob->is_traceable()) {
+      /* The instanced BVH may have been built again, and the object moved. */
+      BVHEmbree *instance_bvh = (BVHEmbree *)(ob->get_geometry()->bvh);
+      RTCGeometry geom = rtcGetGeometry(scene, geom_id);
+      rtcSetGeometryInstancedScene(geom, instance_bvh->scene);
+      set_instance_transform(geom, ob);
+      rtcSetGeometryUserData(geom, (void *)instance_bvh->scene);
+      rtcCommitGeometry(geom);
+    }
     geom_id += 2;
   }
 
   rtcCommitScene(scene);
+
+  num_refits++;
+}
+
+bool BVHEmbree::can_refit() const
+{
+  if (!scene || objects.size() != object_states.size()) {
+    return false;
+  }
+
+  for (size_t i = 0; i < objects.size(); i++) {
+    if (!(object_state(objects[i]) == object_states[i])) {
+      VLOG(2) << "Embree BVH objects changed since build, can't refit.";
+      return false;
+    }
+  }
+
+  if (num_refits >= BVH_EMBREE_MAX_REFITS) {
+    VLOG(2) << "Embree BVH refit " << num_refits << " times, building again.";
+    return false;
+  }
+
+  const float bounds_area = objects_bounds_area();
+  if (bounds_area > build_bounds_area * BVH_EMBREE_REFIT_MAX_AREA_GROWTH) {
+    VLOG(2) << "Embree BVH bounds grew from " << build_bounds_area << " to " << bounds_area
+            << " since build, building again.";
+    return false;
+  }
+
+  return true;
+}
+
+bool BVHEmbree::ObjectState::operator==(const ObjectState &other) const
+{
+  return geometry == other.geometry && traceable == other.traceable &&
+         instanced == other.instanced && visibility == other.visibility &&
+         num_motion_steps == other.num_motion_steps && num_primitives == other.num_primitives &&
+         num_verts == other.num_verts;
+}
+
+BVHEmbree::ObjectState BVHEmbree::object_state(const Object *ob) const
+{
+  const Geometry *geom = ob->get_geometry();
+
+  ObjectState state;
+  state.geometry = geom;
+  state.traceable = ob->is_traceable();
+  state.instanced = geom->is_instanced();
+  state.visibility = ob->visibility_for_tracing();
+  state.num_motion_steps = 1;
+  state.num_primitives = 0;
+  state.num_verts = 0;
+
+  if (params.top_level && state.instanced) {
+    /* Only the instance transform is part of this tree. */
+    if (ob->use_motion()) {
+      state.num_motion_steps = ob->get_motion().size();
+    }
+  }
+  else if (geom->geometry_type == Geometry::MESH || geom->geometry_type == Geometry::VOLUME) {
+    const Mesh *mesh = static_cast<const Mesh *>(geom);
+    if (mesh->has_motion_blur()) {
+      state.num_motion_steps = mesh->get_motion_steps();
+    }
+    state.num_primitives = mesh->num_triangles();
+    state.num_verts = mesh->get_verts().size();
+  }
+  else if (geom->geometry_type == Geometry::HAIR) {
+    const Hair *hair = static_cast<const Hair *>(geom);
+    if (hair->has_motion_blur()) {
+      state.num_motion_steps = hair->get_motion_steps();
+    }
+    state.num_primitives = hair->num_curves();
+    state.num_verts = hair->get_curve_keys().size();
+  }
+
+  return state;
+}
+
+float BVHEmbree::objects_bounds_area() const
+{
+  /* Bounds of objects are only computed for the scene, object level BVHs are built for a
+   * temporary object around the geometry. */
+  float area = 0.0f;
+  foreach (const Object *ob, objects) {
+    const BoundBox &bounds = (params.top_level) ? ob->bounds : ob->get_geometry()->bounds;
+    area += bounds.safe_area();
+  }
+  return area;
 }
 
 CCL_NAMESPACE_END
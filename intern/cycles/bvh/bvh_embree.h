@@ -39,6 +39,10 @@ class BVHEmbree : public BVH {
   void build(Progress &progress, Stats *stats, RTCDevice rtc_device);
   void refit(Progress &progress);
 
+  /* Refitting requires the objects to have the same primitives and settings as when the BVH was
+   * built, and is only done while the tree stays reasonably tight around the moved primitives. */
+  bool can_refit() const override;
+
   RTCScene scene;
 
  protected:
@@ -56,9 +60,30 @@ class BVHEmbree : public BVH {
  private:
   void set_tri_vertex_buffer(RTCGeometry geom_id, const Mesh *mesh, const bool update);
   void set_curve_vertex_buffer(RTCGeometry geom_id, const Hair *hair, const bool update);
+  void set_instance_transform(RTCGeometry geom_id, const Object *ob);
+
+  /* Object settings that the tree depends on, recorded at build time. */
+  struct ObjectState {
+    const Geometry *geometry;
+    bool traceable;
+    bool instanced;
+    uint visibility;
+    size_t num_motion_steps;
+    size_t num_primitives;
+    size_t num_verts;
+
+    bool operator==(const ObjectState &other) const;
+  };
+
+  ObjectState object_state(const Object *ob) const;
+  float objects_bounds_area() const;
 
   RTCDevice rtc_device;
   enum RTCBuildQuality build_quality;
+
+  vector<ObjectState> object_states;
+  float build_bounds_area;
+  int num_refits;
 };
 
 CCL_NAMESPACE_END
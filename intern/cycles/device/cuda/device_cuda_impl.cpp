@@ -1017,6 +1017,29 @@ void CUDADevice::mem_copy_to(device_memory &mem)
   }
 }
 
+void CUDADevice::mem_copy_to_partial(device_memory &mem, size_t offset, size_t size)
+{
+  /* Textures and memory that changed size need to be reallocated. */
+  if (mem.type == MEM_PIXELS || mem.type == MEM_TEXTURE || mem.device_size != mem.memory_size()) {
+    mem_copy_to(mem);
+    return;
+  }
+
+  thread_scoped_lock lock(cuda_mem_map_mutex);
+  if (size == 0 || !mem.host_pointer || !mem.device_pointer) {
+    return;
+  }
+
+  /* Same as generic_copy_to, only the range. Existing global memory keeps its pointer in
+   * kernel globals. */
+  if (!cuda_mem_map[&mem].use_mapped_host || mem.host_pointer != mem.shared_pointer) {
+    const CUDAContextScope scope(this);
+    cuda_assert(cuMemcpyHtoD((CUdeviceptr)mem.device_pointer + offset,
+                             (char *)mem.host_pointer + offset,
+                             size));
+  }
+}
+
 void CUDADevice::mem_copy_from(device_memory &mem, int y, int w, int h, int elem)
 {
   if (mem.type == MEM_PIXELS && !background) {
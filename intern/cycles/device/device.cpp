@@ -366,6 +366,12 @@ void Device::draw_pixels(device_memory &rgba,
   }
 }
 
+void Device::mem_copy_to_partial(device_memory &mem, size_t /*offset*/, size_t /*size*/)
+{
+  /* Devices that can't update a part of the memory copy all of it. */
+  mem_copy_to(mem);
+}
+
 void Device::build_bvh(BVH *bvh, Progress &progress, bool refit)
 {
   assert(bvh->params.bvh_layout == BVH_LAYOUT_BVH2);
@@ -410,7 +416,13 @@ Device *Device::create(DeviceInfo &info, Stats &stats, Profiler &profiler, bool
 #endif
 #ifdef WITH_NETWORK
     case DEVICE_NETWORK:
-      device = device_network_create(info, stats, profiler, "127.0.0.1");
+      /* Server address after the prefix of the device ID, local host by default. */
+      device = device_network_create(
+          info,
+          stats,
+          profiler,
+          string_startswith(info.id, "NETWORK_") ? info.id.c_str() + strlen("NETWORK_") :
+                                                   "127.0.0.1");
       break;
 #endif
 #ifdef WITH_OPENCL
@@ -570,6 +582,19 @@ DeviceInfo Device::dummy_device(const string &error_msg)
   return info;
 }
 
+#ifdef WITH_NETWORK
+DeviceInfo Device::network_device(const string &address)
+{
+  vector<DeviceInfo> devices;
+  device_network_info(devices);
+
+  DeviceInfo info = devices.front();
+  info.id = "NETWORK_" + address;
+  info.description = "Network Device " + address;
+  return info;
+}
+#endif
+
 string Device::device_capabilities(uint mask)
 {
   thread_scoped_lock lock(device_mutex);
@@ -424,8 +424,8 @@ class Device {
   virtual void build_bvh(BVH *bvh, Progress &progress, bool refit);
 
 #ifdef WITH_NETWORK
-  /* networking */
-  void server_run();
+  /* networking, with buffers received from clients cached up to cache_size bytes */
+  void server_run(int port, size_t cache_size);
 #endif
 
   /* multi device */
@@ -465,6 +465,9 @@ class Device {
   static vector<DeviceType> available_types();
   static vector<DeviceInfo> available_devices(uint device_type_mask = DEVICE_MASK_ALL);
   static DeviceInfo dummy_device(const string &error_msg = "");
+#ifdef WITH_NETWORK
+  static DeviceInfo network_device(const string &address);
+#endif
   static string device_capabilities(uint device_type_mask = DEVICE_MASK_ALL);
   static DeviceInfo get_multi_device(const vector<DeviceInfo> &subdevices,
                                      int threads,
@@ -483,6 +486,7 @@ class Device {
 
   virtual void mem_alloc(device_memory &mem) = 0;
   virtual void mem_copy_to(device_memory &mem) = 0;
+  virtual void mem_copy_to_partial(device_memory &mem, size_t offset, size_t size);
   virtual void mem_copy_from(device_memory &mem, int y, int w, int h, int elem) = 0;
   virtual void mem_zero(device_memory &mem) = 0;
   virtual void mem_free(device_memory &mem) = 0;
@@ -64,6 +64,7 @@
 #include "util/util_system.h"
 #include "util/util_task.h"
 #include "util/util_thread.h"
+#include "util/util_time.h"
 
 CCL_NAMESPACE_BEGIN
 
@@ -936,6 +937,7 @@ class CPUDevice : public Device {
   void render(DeviceTask &task, RenderTile &tile, KernelGlobals *kg)
   {
     const bool use_coverage = kernel_data.film.cryptomatte_passes & CRYPT_ACCURATE;
+    const bool use_render_cost = kernel_data.film.pass_render_cost != 0;
 
     scoped_timer timer(&tile.buffers->render_time);
 
@@ -968,7 +970,19 @@ class CPUDevice : public Device {
             if (use_coverage) {
               coverage.init_pixel(x, y);
             }
-            path_trace_kernel()(kg, render_buffer, sample, x, y, tile.offset, tile.stride);
+            if (use_render_cost) {
+              /* Accumulate time per pixel in microseconds, for the render cost pass. */
+              const double start_time = time_dt();
+              path_trace_kernel()(kg, render_buffer, sample, x, y, tile.offset, tile.stride);
+              const double cost = (time_dt() - start_time) * 1e6;
+
+              const int index = tile.offset + x + y * tile.stride;
+              float *buffer = render_buffer + index * kernel_data.film.pass_stride;
+              buffer[kernel_data.film.pass_render_cost] += (float)cost;
+            }
+            else {
+              path_trace_kernel()(kg, render_buffer, sample, x, y, tile.offset, tile.stride);
+            }
           }
         }
       }
@@ -92,6 +92,18 @@ void device_memory::device_copy_to()
   }
 }
 
+void device_memory::device_copy_to_partial(size_t offset, size_t size)
+{
+  if (host_pointer) {
+    if (device_pointer) {
+      device->mem_copy_to_partial(*this, offset, size);
+    }
+    else {
+      device->mem_copy_to(*this);
+    }
+  }
+}
+
 void device_memory::device_copy_from(int y, int w, int h, int elem)
 {
   assert(type != MEM_TEXTURE && type != MEM_READ_ONLY && type != MEM_GLOBAL);
@@ -168,6 +180,7 @@ device_texture::device_texture(Device *device,
     case IMAGE_DATA_TYPE_BYTE:
     case IMAGE_DATA_TYPE_NANOVDB_FLOAT:
     case IMAGE_DATA_TYPE_NANOVDB_FLOAT3:
+    case IMAGE_DATA_TYPE_TEXTURE_CACHE:
       data_type = TYPE_UCHAR;
       data_elements = 1;
       break;
@@ -253,6 +253,7 @@ class device_memory {
   void device_alloc();
   void device_free();
   void device_copy_to();
+  void device_copy_to_partial(size_t offset, size_t size);
   void device_copy_from(int y, int w, int h, int elem);
   void device_zero();
 
@@ -435,6 +436,14 @@ template<typename T> class device_vector : public device_memory {
     device_copy_to();
   }
 
+  /* Copy num elements starting at offset, for when only part of the host data changed. Memory
+   * that was not allocated on the device yet is copied entirely. */
+  void copy_to_device_partial(size_t offset, size_t num)
+  {
+    assert(offset + num <= data_size);
+    device_copy_to_partial(sizeof(T) * offset, sizeof(T) * num);
+  }
+
   void copy_from_device()
   {
     device_copy_from(0, data_width, data_height, sizeof(T));
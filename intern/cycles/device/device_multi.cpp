@@ -122,16 +122,28 @@ class MultiDevice : public Device {
     }
 
 #ifdef WITH_NETWORK
-    /* try to add network devices */
-    ServerDiscovery discovery(true);
-    time_sleep(1.0);
-
-    vector<string> servers = discovery.get_server_list();
-
-    foreach (string &server, servers) {
-      Device *device = device_network_create(info, stats, profiler, server.c_str());
-      if (device)
-        devices.push_back(SubDevice(device));
+    /* try to add network devices, unless servers were specified explicitly */
+    bool have_network_devices = false;
+    foreach (const DeviceInfo &subinfo, info.multi_devices) {
+      have_network_devices |= (subinfo.type == DEVICE_NETWORK);
+    }
+
+    if (!have_network_devices) {
+      ServerDiscovery discovery(true);
+      time_sleep(1.0);
+
+      vector<string> servers = discovery.get_server_list();
+
+      foreach (string &server, servers) {
+        Device *device = device_network_create(info, stats, profiler, server.c_str());
+        if (device) {
+          devices.emplace_front();
+          devices.front().device = device;
+          peer_islands.emplace_back();
+          devices.front().peer_island_index = (int)peer_islands.size() - 1;
+          peer_islands.back().push_back(&devices.front());
+        }
+      }
     }
 #endif
   }
@@ -433,6 +445,29 @@ class MultiDevice : public Device {
     stats.mem_alloc(mem.device_size - existing_size);
   }
 
+  void mem_copy_to_partial(device_memory &mem, size_t offset, size_t size) override
+  {
+    device_ptr key = mem.device_pointer;
+    if (strcmp(mem.name, "RenderBuffers") == 0 || mem.type == MEM_TEXTURE ||
+        mem.device_size != mem.memory_size()) {
+      mem_copy_to(mem);
+      return;
+    }
+
+    /* The memory keeps its pointers, so only the owner in each peer island needs the data. */
+    foreach (const vector<SubDevice *> &island, peer_islands) {
+      SubDevice *owner_sub = find_suitable_mem_device(key, island);
+      mem.device = owner_sub->device;
+      mem.device_pointer = owner_sub->ptr_map[key];
+
+      owner_sub->device->mem_copy_to_partial(mem, offset, size);
+      owner_sub->ptr_map[key] = mem.device_pointer;
+    }
+
+    mem.device = this;
+    mem.device_pointer = key;
+  }
+
   void mem_copy_from(device_memory &mem, int y, int w, int h, int elem) override
   {
     device_ptr key = mem.device_pointer;
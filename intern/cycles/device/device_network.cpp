@@ -20,6 +20,8 @@
 
 #include "util/util_foreach.h"
 #include "util/util_logging.h"
+#include "util/util_md5.h"
+#include "util/util_time.h"
 
 #if defined(WITH_NETWORK)
 
@@ -41,6 +43,29 @@ static TileList::iterator tile_list_find(TileList &tile_list, RenderTile &tile)
   return tile_list.end();
 }
 
+/* Hash of the memory contents, for servers to find it in their cache. */
+static string network_memory_hash(device_memory &mem)
+{
+  const uint8_t *data = (const uint8_t *)mem.host_pointer;
+  const size_t size = mem.memory_size();
+  const size_t chunk_size = 1 << 30;
+
+  MD5Hash md5;
+  for (size_t offset = 0; offset < size; offset += chunk_size) {
+    md5.append(data + offset, (int)std::min(chunk_size, size - offset));
+  }
+
+  return string_printf("%s-%zu", md5.get_hex().c_str(), size);
+}
+
+/* Network Device
+ *
+ * Forwards device calls to a render server. The state sent to the server is remembered, so that
+ * it can be uploaded again when the connection is lost during rendering.
+ *
+ * Tiles are served from a thread per device while the task runs, so that multiple network
+ * devices in a multi device pull tiles from the session as fast as their servers render them. */
+
 class NetworkDevice : public Device {
  public:
   boost::asio::io_service io_service;
@@ -56,31 +81,36 @@ class NetworkDevice : public Device {
   }
 
   NetworkDevice(DeviceInfo &info, Stats &stats, Profiler &profiler, const char *address)
-      : Device(info, stats, profiler, true), socket(io_service)
+      : Device(info, stats, profiler, true),
+        socket(io_service),
+        server_address(address),
+        server_port(SERVER_PORT),
+        task_thread(NULL),
+        task_cancel_requested(false),
+        kernels_loaded(false)
   {
     error_func = NetworkError();
-    stringstream portstr;
-    portstr << SERVER_PORT;
-
-    tcp::resolver resolver(io_service);
-    tcp::resolver::query query(address, portstr.str());
-    tcp::resolver::iterator endpoint_iterator = resolver.resolve(query);
-    tcp::resolver::iterator end;
+    mem_counter = 0;
 
-    boost::system::error_code error = boost::asio::error::host_not_found;
-    while (error && endpoint_iterator != end) {
-      socket.close();
-      socket.connect(*endpoint_iterator++, error);
+    /* Optional port after the host name, to run multiple servers on the same host. */
+    const size_t port_start = server_address.rfind(':');
+    if (port_start != string::npos) {
+      server_port = atoi(server_address.c_str() + port_start + 1);
+      server_address = server_address.substr(0, port_start);
     }
 
-    if (error)
-      error_func.network_error(error.message());
-
-    mem_counter = 0;
+    if (!connect()) {
+      error_func.network_error(error_func.message());
+      set_error(string_printf("Failed to connect to render server %s:%d",
+                              server_address.c_str(),
+                              server_port));
+    }
   }
 
   ~NetworkDevice()
   {
+    task_wait();
+
     RPCSend snd(socket, &error_func, "stop");
     snd.write();
   }
@@ -101,21 +131,22 @@ class NetworkDevice : public Device {
     thread_scoped_lock lock(rpc_lock);
 
     mem.device_pointer = ++mem_counter;
+    allocations[mem.device_pointer] = &mem;
 
-    RPCSend snd(socket, &error_func, "mem_alloc");
-    snd.add(mem);
-    snd.write();
+    send_mem_alloc(mem);
   }
 
   void mem_copy_to(device_memory &mem)
   {
     thread_scoped_lock lock(rpc_lock);
 
-    RPCSend snd(socket, &error_func, "mem_copy_to");
+    /* Textures and globals are allocated on the server by their first copy. */
+    if (!mem.device_pointer) {
+      mem.device_pointer = ++mem_counter;
+      allocations[mem.device_pointer] = &mem;
+    }
 
-    snd.add(mem);
-    snd.write();
-    snd.write_buffer(mem.host_pointer, mem.memory_size());
+    send_mem_copy_to(mem);
   }
 
   void mem_copy_from(device_memory &mem, int y, int w, int h, int elem)
@@ -141,10 +172,12 @@ class NetworkDevice : public Device {
   {
     thread_scoped_lock lock(rpc_lock);
 
-    RPCSend snd(socket, &error_func, "mem_zero");
+    if (!mem.device_pointer) {
+      mem.device_pointer = ++mem_counter;
+      allocations[mem.device_pointer] = &mem;
+    }
 
-    snd.add(mem);
-    snd.write();
+    send_mem_zero(mem);
   }
 
   void mem_free(device_memory &mem)
@@ -157,6 +190,7 @@ class NetworkDevice : public Device {
       snd.add(mem);
       snd.write();
 
+      allocations.erase(mem.device_pointer);
       mem.device_pointer = 0;
     }
   }
@@ -165,14 +199,10 @@ class NetworkDevice : public Device {
   {
     thread_scoped_lock lock(rpc_lock);
 
-    RPCSend snd(socket, &error_func, "const_copy_to");
-
-    string name_string(name);
+    vector<char> &data = constants[name];
+    data.assign((const char *)host, (const char *)host + size);
 
-    snd.add(name_string);
-    snd.add(size);
-    snd.write();
-    snd.write_buffer(host, size);
+    send_const_copy_to(name, data);
   }
 
   bool load_kernels(const DeviceRequestedFeatures &requested_features)
@@ -182,70 +212,301 @@ class NetworkDevice : public Device {
 
     thread_scoped_lock lock(rpc_lock);
 
+    loaded_features = requested_features;
+    kernels_loaded = true;
+
+    return send_load_kernels();
+  }
+
+  void task_add(DeviceTask &task)
+  {
+    task_wait();
+
+    the_task = task;
+    lost_tiles.clear();
+    task_cancel_requested = false;
+
+    task_start();
+
+    task_thread = new thread(function_bind(&NetworkDevice::task_run, this));
+  }
+
+  void task_wait()
+  {
+    if (task_thread) {
+      task_thread->join();
+      delete task_thread;
+      task_thread = NULL;
+    }
+  }
+
+  void task_cancel()
+  {
+    /* The task thread holds the RPC lock while it waits for the server, so it forwards the
+     * cancel with its next reply instead. */
+    task_cancel_requested = true;
+  }
+
+  int get_split_task_count(DeviceTask &)
+  {
+    return 1;
+  }
+
+ protected:
+  bool connect()
+  {
+    stringstream portstr;
+    portstr << server_port;
+
+    tcp::resolver resolver(io_service);
+    tcp::resolver::query query(server_address, portstr.str());
+
+    boost::system::error_code error;
+    tcp::resolver::iterator endpoint_iterator = resolver.resolve(query, error);
+    tcp::resolver::iterator end;
+
+    if (!error) {
+      error = boost::asio::error::host_not_found;
+      while (error && endpoint_iterator != end) {
+        socket.close();
+        socket.connect(*endpoint_iterator++, error);
+      }
+    }
+
+    if (error) {
+      VLOG(1) << "Failed to connect to " << server_address << ":" << server_port << ": "
+              << error.message();
+      return false;
+    }
+
+    /* Tile requests are small and latency bound. */
+    socket.set_option(tcp::no_delay(true), error);
+
+    VLOG(1) << "Connected to render server " << server_address << ":" << server_port;
+    return true;
+  }
+
+  /* Connect again and restore the state of the server, in the order it was created. */
+  bool reconnect()
+  {
+    thread_scoped_lock lock(rpc_lock);
+
+    bool connected = false;
+    for (int attempt = 0; attempt < NETWORK_MAX_RECONNECTS && !connected; attempt++) {
+      time_sleep(1.0);
+      connected = connect();
+    }
+
+    if (!connected) {
+      return false;
+    }
+
+    error_func = NetworkError();
+
+    if (kernels_loaded && !send_load_kernels()) {
+      return false;
+    }
+
+    for (map<string, vector<char>>::iterator it = constants.begin(); it != constants.end();
+         it++) {
+      send_const_copy_to(it->first, it->second);
+    }
+
+    for (map<device_ptr, device_memory *>::iterator it = allocations.begin();
+         it != allocations.end();
+         it++) {
+      /* A multi device swaps in its own pointer outside of calls to this device. */
+      device_memory &mem = *it->second;
+      const device_ptr device_pointer = mem.device_pointer;
+      mem.device_pointer = it->first;
+
+      if (mem.type != MEM_TEXTURE && mem.type != MEM_GLOBAL) {
+        send_mem_alloc(mem);
+      }
+
+      if (mem.host_pointer) {
+        send_mem_copy_to(mem);
+      }
+      else {
+        send_mem_zero(mem);
+      }
+
+      mem.device_pointer = device_pointer;
+    }
+
+    VLOG(1) << "Restored " << allocations.size() << " buffers on render server "
+            << server_address << ":" << server_port;
+
+    return !error_func.have_error();
+  }
+
+  void send_mem_alloc(device_memory &mem)
+  {
+    RPCSend snd(socket, &error_func, "mem_alloc");
+    snd.add(mem);
+    snd.write();
+  }
+
+  void send_mem_copy_to(device_memory &mem)
+  {
+    const size_t data_size = mem.memory_size();
+
+    /* Render buffers change all the time and are not worth caching. */
+    string hash;
+    if (data_size >= NETWORK_CACHE_MIN_SIZE && mem.type != MEM_READ_WRITE &&
+        mem.type != MEM_DEVICE_ONLY) {
+      hash = network_memory_hash(mem);
+    }
+
+    RPCSend snd(socket, &error_func, "mem_copy_to");
+    snd.add(mem);
+    snd.add(hash);
+    snd.write();
+
+    if (!hash.empty()) {
+      /* The server replies whether it has the contents in its cache already. */
+      bool cached = false;
+      RPCReceive rcv(socket, &error_func);
+      if (rcv.name == "mem_copy_to") {
+        rcv.read(cached);
+      }
+
+      if (cached) {
+        VLOG(2) << "Buffer " << mem.name << " found in cache of render server.";
+        return;
+      }
+    }
+
+    snd.write_buffer(mem.host_pointer, data_size);
+  }
+
+  void send_mem_zero(device_memory &mem)
+  {
+    RPCSend snd(socket, &error_func, "mem_zero");
+    snd.add(mem);
+    snd.write();
+  }
+
+  void send_const_copy_to(const string &name, vector<char> &data)
+  {
+    RPCSend snd(socket, &error_func, "const_copy_to");
+
+    size_t size = data.size();
+
+    snd.add(name);
+    snd.add(size);
+    snd.write();
+    snd.write_buffer(data.data(), size);
+  }
+
+  bool send_load_kernels()
+  {
     RPCSend snd(socket, &error_func, "load_kernels");
-    snd.add(requested_features.experimental);
-    snd.add(requested_features.max_closure);
-    snd.add(requested_features.max_nodes_group);
-    snd.add(requested_features.nodes_features);
+    snd.add(loaded_features);
     snd.write();
 
-    bool result;
+    bool result = false;
     RPCReceive rcv(socket, &error_func);
-    rcv.read(result);
+    if (rcv.name == "load_kernels") {
+      rcv.read(result);
+    }
 
     return result;
   }
 
-  void task_add(DeviceTask &task)
+  void task_start()
   {
     thread_scoped_lock lock(rpc_lock);
 
-    the_task = task;
-
     RPCSend snd(socket, &error_func, "task_add");
-    snd.add(task);
+    snd.add(the_task);
     snd.write();
+
+    RPCSend snd_wait(socket, &error_func, "task_wait");
+    snd_wait.write();
   }
 
-  void task_wait()
+  void task_run()
   {
-    thread_scoped_lock lock(rpc_lock);
+    /* Tiles rendering on the server. */
+    TileList the_tiles;
+    int num_reconnects = 0;
 
-    RPCSend snd(socket, &error_func, "task_wait");
-    snd.write();
+    while (!task_serve(the_tiles)) {
+      if (task_cancel_requested || (the_task.get_cancel && the_task.get_cancel())) {
+        break;
+      }
+
+      /* Render the tiles that were in progress again after reconnecting. Their buffers are
+       * restored from the host, which still holds the samples from before they were acquired. */
+      foreach (RenderTile &tile, the_tiles) {
+        lost_tiles.push_back(tile);
+      }
+      the_tiles.clear();
 
-    lock.unlock();
+      VLOG(1) << "Lost connection to render server " << server_address << ":" << server_port
+              << ", reconnecting.";
 
-    TileList the_tiles;
+      if (num_reconnects++ == NETWORK_MAX_RECONNECTS || !reconnect()) {
+        set_error(string_printf("Lost connection to render server %s:%d",
+                                server_address.c_str(),
+                                server_port));
+        break;
+      }
+
+      task_start();
+    }
+  }
 
-    /* todo: run this threaded for connecting to multiple clients */
+  /* Respond to tile requests of the server until the task is done, returns false when the
+   * connection was lost. */
+  bool task_serve(TileList &the_tiles)
+  {
     for (;;) {
       if (error_func.have_error())
-        break;
+        return false;
 
       RenderTile tile;
 
-      lock.lock();
+      thread_scoped_lock lock(rpc_lock);
       RPCReceive rcv(socket, &error_func);
 
       if (rcv.name == "acquire_tile") {
+        uint tile_types;
+        rcv.read(tile_types);
+
+        if (task_cancel_requested) {
+          /* Cancel the tiles in progress, and hand out no new ones. */
+          RPCSend snd_cancel(socket, &error_func, "task_cancel");
+          snd_cancel.write();
+
+          RPCSend snd(socket, &error_func, "acquire_tile_none");
+          snd.write();
+          continue;
+        }
         lock.unlock();
 
-        /* todo: watch out for recursive calls! */
-        if (the_task.acquire_tile(this, tile)) { /* write return as bool */
+        bool have_tile = false;
+        if (!lost_tiles.empty()) {
+          tile = lost_tiles.front();
+          lost_tiles.pop_front();
+          have_tile = true;
+        }
+        else {
+          have_tile = the_task.acquire_tile(this, tile, tile_types);
+        }
+
+        lock.lock();
+        if (have_tile) {
           the_tiles.push_back(tile);
 
-          lock.lock();
           RPCSend snd(socket, &error_func, "acquire_tile");
           snd.add(tile);
           snd.write();
-          lock.unlock();
         }
         else {
-          lock.lock();
           RPCSend snd(socket, &error_func, "acquire_tile_none");
           snd.write();
-          lock.unlock();
         }
       }
       else if (rcv.name == "release_tile") {
@@ -265,28 +526,25 @@ class NetworkDevice : public Device {
         lock.lock();
         RPCSend snd(socket, &error_func, "release_tile");
         snd.write();
-        lock.unlock();
       }
       else if (rcv.name == "task_wait_done") {
-        lock.unlock();
-        break;
+        return true;
       }
-      else
-        lock.unlock();
     }
   }
 
-  void task_cancel()
-  {
-    thread_scoped_lock lock(rpc_lock);
-    RPCSend snd(socket, &error_func, "task_cancel");
-    snd.write();
-  }
+  string server_address;
+  int server_port;
 
-  int get_split_task_count(DeviceTask &)
-  {
-    return 1;
-  }
+  thread *task_thread;
+  list<RenderTile> lost_tiles;
+  volatile bool task_cancel_requested;
+
+  /* State of the server, to restore after reconnecting. */
+  map<device_ptr, device_memory *> allocations;
+  map<string, vector<char>> constants;
+  DeviceRequestedFeatures loaded_features;
+  bool kernels_loaded;
 
  private:
   NetworkError error_func;
@@ -318,6 +576,65 @@ void device_network_info(vector<DeviceInfo> &devices)
   devices.push_back(info);
 }
 
+/* Cache of buffers received from clients, by hash of their contents. Buffers are kept after
+ * the client frees them or disconnects, within a memory budget, so that rendering the same scene
+ * again only needs to send what changed. */
+
+class NetworkDataCache {
+ public:
+  explicit NetworkDataCache(size_t capacity) : capacity(capacity), size(0)
+  {
+  }
+
+  /* Copy the cached contents into data, returns false if not in the cache. */
+  bool find(const string &hash, DataVector &data)
+  {
+    map<string, Entry>::iterator it = entries.find(hash);
+    if (it == entries.end() || it->second.data.size() != data.size()) {
+      return false;
+    }
+
+    /* Most recently used at the front. */
+    lru.splice(lru.begin(), lru, it->second.lru_it);
+
+    memcpy(data.data(), it->second.data.data(), data.size());
+    return true;
+  }
+
+  /* Take the contents of data into the cache, evicting the least recently used buffers when
+   * over the budget. */
+  void insert(const string &hash, DataVector &data)
+  {
+    if (data.size() > capacity || entries.find(hash) != entries.end()) {
+      return;
+    }
+
+    Entry &entry = entries[hash];
+    entry.data.swap(data);
+    lru.push_front(hash);
+    entry.lru_it = lru.begin();
+    size += entry.data.size();
+
+    while (size > capacity) {
+      map<string, Entry>::iterator it = entries.find(lru.back());
+      size -= it->second.data.size();
+      entries.erase(it);
+      lru.pop_back();
+    }
+  }
+
+ protected:
+  struct Entry {
+    DataVector data;
+    list<string>::iterator lru_it;
+  };
+
+  size_t capacity;
+  size_t size;
+  map<string, Entry> entries;
+  list<string> lru;
+};
+
 class DeviceServer {
  public:
   thread_mutex rpc_lock;
@@ -332,19 +649,42 @@ class DeviceServer {
     return error_func.have_error();
   }
 
-  DeviceServer(Device *device_, tcp::socket &socket_)
-      : device(device_), socket(socket_), stop(false), blocked_waiting(false)
+  DeviceServer(Device *device_, tcp::socket &socket_, NetworkDataCache &cache_)
+      : device(device_),
+        socket(socket_),
+        cache(cache_),
+        stop(false),
+        blocked_waiting(false),
+        task_canceled(false)
   {
     error_func = NetworkError();
   }
 
+  ~DeviceServer()
+  {
+    /* Free device memory the client did not free before disconnecting, keeping the contents
+     * in the cache for when it connects again. */
+    device->task_wait();
+
+    for (PtrMap::iterator it = ptr_map.begin(); it != ptr_map.end(); it++) {
+      network_device_memory mem(device);
+      mem.type = mem_kind[it->first].first;
+      mem.slot = mem_kind[it->first].second;
+      mem.device_pointer = it->second;
+      mem.host_pointer = (void *)data_vector_find(it->first).data();
+      device->mem_free(mem);
+
+      cache_insert(it->first);
+    }
+  }
+
   void listen()
   {
     /* receive remote function calls */
     for (;;) {
       listen_step();
 
-      if (stop)
+      if (stop || have_error())
         break;
     }
   }
@@ -388,10 +728,14 @@ class DeviceServer {
   }
 
   /* setup mapping and reverse mapping of client_pointer<->real_pointer */
-  void pointer_mapping_insert(device_ptr client_pointer, device_ptr real_pointer)
+  void pointer_mapping_insert(device_ptr client_pointer, const network_device_memory &mem)
   {
+    device_ptr real_pointer = mem.device_pointer;
     pair<PtrMap::iterator, bool> mapins;
 
+    /* remember how to free it if the client disconnects */
+    mem_kind[client_pointer] = std::make_pair(mem.type, mem.slot);
+
     /* insert mapping from client pointer to our real device pointer */
     mapins = ptr_map.insert(PtrMap::value_type(client_pointer, real_pointer));
     assert(mapins.second);
@@ -423,7 +767,11 @@ class DeviceServer {
     assert(irev != ptr_imap.end());
     ptr_imap.erase(irev);
 
+    mem_kind.erase(client_pointer);
+
     /* erase the data vector */
+    cache_insert(client_pointer);
+
     DataMap::iterator idata = mem_data.find(client_pointer);
     assert(idata != mem_data.end());
     mem_data.erase(idata);
@@ -431,6 +779,22 @@ class DeviceServer {
     return result;
   }
 
+  /* Move the data of a buffer into the cache, if it was hashed by the client. */
+  void cache_insert(device_ptr client_pointer)
+  {
+    map<device_ptr, string>::iterator ihash = mem_hash.find(client_pointer);
+    if (ihash == mem_hash.end()) {
+      return;
+    }
+
+    DataMap::iterator idata = mem_data.find(client_pointer);
+    if (idata != mem_data.end()) {
+      cache.insert(ihash->second, idata->second);
+    }
+
+    mem_hash.erase(ihash);
+  }
+
   /* note that the lock must be already acquired upon entry.
    * This is necessary because the caller often peeks at
    * the header and delegates control to here when it doesn't
@@ -455,18 +819,21 @@ class DeviceServer {
       device->mem_alloc(mem);
 
       /* Store a mapping to/from client_pointer and real device pointer. */
-      pointer_mapping_insert(client_pointer, mem.device_pointer);
+      pointer_mapping_insert(client_pointer, mem);
     }
     else if (rcv.name == "mem_copy_to") {
-      string name;
+      string name, hash;
       network_device_memory mem(device);
       rcv.read(mem, name);
-      lock.unlock();
+      rcv.read(hash);
 
       size_t data_size = mem.memory_size();
       device_ptr client_pointer = mem.device_pointer;
 
-      if (client_pointer) {
+      /* Textures and globals are allocated by their first copy. */
+      const bool allocated = (mem_data.find(client_pointer) != mem_data.end());
+
+      if (allocated) {
         /* Lookup existing host side data buffer. */
         DataVector &data_v = data_vector_find(client_pointer);
         mem.host_pointer = (void *)&data_v[0];
@@ -478,17 +845,37 @@ class DeviceServer {
         /* Allocate host side data buffer. */
         DataVector &data_v = data_vector_insert(client_pointer, data_size);
         mem.host_pointer = (data_size) ? (void *)&(data_v[0]) : 0;
+        mem.device_pointer = 0;
       }
 
-      /* Copy data from network into memory buffer. */
-      rcv.read_buffer((uint8_t *)mem.host_pointer, data_size);
+      if (hash.empty()) {
+        lock.unlock();
+
+        /* Copy data from network into memory buffer. */
+        rcv.read_buffer((uint8_t *)mem.host_pointer, data_size);
+      }
+      else {
+        /* Reply while holding the lock, so the client receives it before any other call. */
+        DataVector &data_v = data_vector_find(client_pointer);
+        bool cached = cache.find(hash, data_v);
+        mem_hash[client_pointer] = hash;
+
+        RPCSend snd(socket, &error_func, "mem_copy_to");
+        snd.add(cached);
+        snd.write();
+
+        if (!cached) {
+          rcv.read_buffer((uint8_t *)mem.host_pointer, data_size);
+        }
+        lock.unlock();
+      }
 
       /* Copy the data from the memory buffer to the device buffer. */
       device->mem_copy_to(mem);
 
-      if (!client_pointer) {
+      if (!allocated) {
         /* Store a mapping to/from client_pointer and real device pointer. */
-        pointer_mapping_insert(client_pointer, mem.device_pointer);
+        pointer_mapping_insert(client_pointer, mem);
       }
     }
     else if (rcv.name == "mem_copy_from") {
@@ -507,7 +894,7 @@ class DeviceServer {
 
       DataVector &data_v = data_vector_find(client_pointer);
 
-      mem.host_pointer = (device_ptr) & (data_v[0]);
+      mem.host_pointer = (void *)&data_v[0];
 
       device->mem_copy_from(mem, y, w, h, elem);
 
@@ -526,11 +913,12 @@ class DeviceServer {
 
       size_t data_size = mem.memory_size();
       device_ptr client_pointer = mem.device_pointer;
+      const bool allocated = (mem_data.find(client_pointer) != mem_data.end());
 
-      if (client_pointer) {
+      if (allocated) {
         /* Lookup existing host side data buffer. */
         DataVector &data_v = data_vector_find(client_pointer);
-        mem.host_pointer = (void *)&data_v[0];
+        mem.host_pointer = (data_size) ? (void *)&data_v[0] : 0;
 
         /* Translate the client pointer to a real device pointer. */
         mem.device_pointer = device_ptr_from_client_pointer(client_pointer);
@@ -538,15 +926,16 @@ class DeviceServer {
       else {
         /* Allocate host side data buffer. */
         DataVector &data_v = data_vector_insert(client_pointer, data_size);
-        mem.host_pointer = (void *) ? (device_ptr) & (data_v[0]) : 0;
+        mem.host_pointer = (data_size) ? (void *)&data_v[0] : 0;
+        mem.device_pointer = 0;
       }
 
       /* Zero memory. */
       device->mem_zero(mem);
 
-      if (!client_pointer) {
+      if (!allocated) {
         /* Store a mapping to/from client_pointer and real device pointer. */
-        pointer_mapping_insert(client_pointer, mem.device_pointer);
+        pointer_mapping_insert(client_pointer, mem);
       }
     }
     else if (rcv.name == "mem_free") {
@@ -577,10 +966,7 @@ class DeviceServer {
     }
     else if (rcv.name == "load_kernels") {
       DeviceRequestedFeatures requested_features;
-      rcv.read(requested_features.experimental);
-      rcv.read(requested_features.max_closure);
-      rcv.read(requested_features.max_nodes_group);
-      rcv.read(requested_features.nodes_features);
+      rcv.read(requested_features);
 
       bool result;
       result = device->load_kernels(requested_features);
@@ -593,6 +979,7 @@ class DeviceServer {
       DeviceTask task;
 
       rcv.read(task);
+      task_canceled = false;
       lock.unlock();
 
       if (task.buffer)
@@ -610,12 +997,13 @@ class DeviceServer {
       if (task.shader_output)
         task.shader_output = device_ptr_from_client_pointer(task.shader_output);
 
-      task.acquire_tile = function_bind(&DeviceServer::task_acquire_tile, this, _1, _2);
+      task.acquire_tile = function_bind(&DeviceServer::task_acquire_tile, this, _1, _2, _3);
       task.release_tile = function_bind(&DeviceServer::task_release_tile, this, _1);
-      task.update_progress_sample = function_bind(&DeviceServer::task_update_progress_sample,
-                                                  this);
+      task.update_progress_sample = function_bind(
+          &DeviceServer::task_update_progress_sample, this, _1, _2);
       task.update_tile_sample = function_bind(&DeviceServer::task_update_tile_sample, this, _1);
       task.get_cancel = function_bind(&DeviceServer::task_get_cancel, this);
+      task.get_tile_stolen = function_bind(&DeviceServer::task_get_tile_stolen, this);
 
       device->task_add(task);
     }
@@ -632,8 +1020,10 @@ class DeviceServer {
       lock.unlock();
     }
     else if (rcv.name == "task_cancel") {
+      /* Usually received while acquiring a tile on a render thread, where waiting for the task
+       * to cancel would deadlock. Rendering polls the flag instead. */
+      task_canceled = true;
       lock.unlock();
-      device->task_cancel();
     }
     else if (rcv.name == "acquire_tile") {
       AcquireEntry entry;
@@ -660,14 +1050,18 @@ class DeviceServer {
     }
   }
 
-  bool task_acquire_tile(Device *, RenderTile &tile)
+  bool task_acquire_tile(Device *, RenderTile &tile, uint tile_types)
   {
     thread_scoped_lock acquire_lock(acquire_mutex);
 
     bool result = false;
 
-    RPCSend snd(socket, &error_func, "acquire_tile");
-    snd.write();
+    {
+      thread_scoped_lock lock(rpc_lock);
+      RPCSend snd(socket, &error_func, "acquire_tile");
+      snd.add(tile_types);
+      snd.write();
+    }
 
     do {
       if (blocked_waiting)
@@ -701,7 +1095,7 @@ class DeviceServer {
     return result;
   }
 
-  void task_update_progress_sample()
+  void task_update_progress_sample(long, int)
   {
     ; /* skip */
   }
@@ -745,22 +1139,32 @@ class DeviceServer {
           cout << "Error: unexpected release RPC receive call \"" + entry.name + "\"\n";
         }
       }
-    } while (acquire_queue.empty() && !stop);
+    } while (acquire_queue.empty() && !stop && !have_error());
   }
 
   bool task_get_cancel()
   {
+    /* Stop rendering when the client is gone or canceled the task. */
+    return stop || task_canceled || have_error();
+  }
+
+  bool task_get_tile_stolen()
+  {
+    /* Tiles are balanced by the client handing them out on request. */
     return false;
   }
 
   /* properties */
   Device *device;
   tcp::socket &socket;
+  NetworkDataCache &cache;
 
   /* mapping of remote to local pointer */
   PtrMap ptr_map;
   PtrMap ptr_imap;
   DataMap mem_data;
+  map<device_ptr, string> mem_hash;
+  map<device_ptr, pair<MemoryType, uint>> mem_kind;
 
   struct AcquireEntry {
     string name;
@@ -772,31 +1176,37 @@ class DeviceServer {
 
   bool stop;
   bool blocked_waiting;
+  volatile bool task_canceled;
 
  private:
   NetworkError error_func;
-
-  /* todo: free memory and device (osl) on network error */
 };
 
-void Device::server_run()
+void Device::server_run(int port, size_t cache_size)
 {
   try {
     /* starts thread that responds to discovery requests */
-    ServerDiscovery discovery;
+    ServerDiscovery discovery(false, port);
+
+    /* Buffers received from clients, kept across connections. */
+    NetworkDataCache cache(cache_size);
 
     for (;;) {
       /* accept connection */
       boost::asio::io_service io_service;
-      tcp::acceptor acceptor(io_service, tcp::endpoint(tcp::v4(), SERVER_PORT));
+      tcp::acceptor acceptor(io_service, tcp::endpoint(tcp::v4(), port));
 
       tcp::socket socket(io_service);
       acceptor.accept(socket);
 
+      boost::system::error_code error;
+      socket.set_option(tcp::no_delay(true), error);
+
       string remote_address = socket.remote_endpoint().address().to_string();
       printf("Connected to remote client at: %s\n", remote_address.c_str());
+      fflush(stdout);
 
-      DeviceServer server(this, socket);
+      DeviceServer server(this, socket, cache);
       server.listen();
 
       printf("Disconnected.\n");
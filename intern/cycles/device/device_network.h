@@ -33,10 +33,13 @@
 #  include <iostream>
 #  include <sstream>
 
+#  include "device/device.h"
+
 #  include "render/buffers.h"
 
 #  include "util/util_foreach.h"
 #  include "util/util_list.h"
+#  include "util/util_logging.h"
 #  include "util/util_map.h"
 #  include "util/util_param.h"
 #  include "util/util_string.h"
@@ -56,6 +59,13 @@ static const int DISCOVER_PORT = 5121;
 static const string DISCOVER_REQUEST_MSG = "REQUEST_RENDER_SERVER_IP";
 static const string DISCOVER_REPLY_MSG = "REPLY_RENDER_SERVER_IP";
 
+/* Buffers of at least this size are identified by a hash of their contents, so that servers
+ * can take them from their cache instead of receiving them again. */
+static const size_t NETWORK_CACHE_MIN_SIZE = 1024 * 1024;
+
+/* Attempts to connect to a server again after the connection was lost. */
+static const int NETWORK_MAX_RECONNECTS = 3;
+
 #  if 0
 typedef boost::archive::text_oarchive o_archive;
 typedef boost::archive::text_iarchive i_archive;
@@ -64,20 +74,24 @@ typedef boost::archive::binary_oarchive o_archive;
 typedef boost::archive::binary_iarchive i_archive;
 #  endif
 
-/* Serialization of device memory */
+/* Serialization of device memory
+ *
+ * Derived from device_texture so that devices can use it for textures too, the server owns the
+ * host data and device memory is freed explicitly. */
 
-class network_device_memory : public device_memory {
+class network_device_memory : public device_texture {
  public:
-  network_device_memory(Device *device) : device_memory(device, "", MEM_READ_ONLY)
+  network_device_memory(Device *device)
+      : device_texture(device, "", 0, IMAGE_DATA_TYPE_BYTE, INTERPOLATION_NONE, EXTENSION_REPEAT)
   {
+    type = MEM_READ_ONLY;
   }
 
   ~network_device_memory()
   {
     device_pointer = 0;
+    host_pointer = 0;
   };
-
-  vector<char> local_data;
 };
 
 /* Common netowrk error function / object for both DeviceNetwork and DeviceServer*/
@@ -101,7 +115,12 @@ class NetworkError {
 
   bool have_error()
   {
-    return true ? error_count > 0 : false;
+    return error_count > 0;
+  }
+
+  const string &message() const
+  {
+    return error;
   }
 
  private:
@@ -118,7 +137,7 @@ class RPCSend {
   {
     archive &name_;
     error_func = e;
-    fprintf(stderr, "rpc send %s\n", name.c_str());
+    VLOG(4) << "RPC send " << name;
   }
 
   ~RPCSend()
@@ -130,8 +149,17 @@ class RPCSend {
     archive &mem.data_type &mem.data_elements &mem.data_size;
     archive &mem.data_width &mem.data_height &mem.data_depth &mem.device_pointer;
     archive &mem.type &string(mem.name);
-    archive &mem.interpolation &mem.extension;
-    archive &mem.device_pointer;
+
+    if (mem.type == MEM_TEXTURE) {
+      const device_texture &tex = (const device_texture &)mem;
+      const float *transform = (const float *)&tex.info.transform_3d;
+
+      archive &tex.slot &tex.info.data_type &tex.info.interpolation &tex.info.extension;
+      archive &tex.info.width &tex.info.height &tex.info.depth &tex.info.use_transform_3d;
+      for (int i = 0; i < 12; i++) {
+        archive &transform[i];
+      }
+    }
   }
 
   template<typename T> void add(const T &data)
@@ -145,19 +173,36 @@ class RPCSend {
     archive &type &task.x &task.y &task.w &task.h;
     archive &task.rgba_byte &task.rgba_half &task.buffer &task.sample &task.num_samples;
     archive &task.offset &task.stride;
-    archive &task.shader_input &task.shader_output &task.shader_eval_type;
+    archive &task.shader_input &task.shader_output &task.shader_eval_type &task.shader_filter;
     archive &task.shader_x &task.shader_w;
-    archive &task.need_finish_queue;
+    archive &task.tile_types &task.pass_stride &task.frame_stride &task.target_pass_stride;
+    archive &task.pass_denoising_data &task.pass_denoising_clean;
+    archive &task.need_finish_queue &task.integrator_branched;
+    archive &task.adaptive_sampling.use &task.adaptive_sampling.adaptive_step;
+    archive &task.adaptive_sampling.min_samples;
   }
 
   void add(const RenderTile &tile)
   {
-    archive &tile.x &tile.y &tile.w &tile.h;
+    int task = (int)tile.task;
+    archive &task &tile.x &tile.y &tile.w &tile.h;
     archive &tile.start_sample &tile.num_samples &tile.sample;
-    archive &tile.resolution &tile.offset &tile.stride;
+    archive &tile.resolution &tile.offset &tile.stride &tile.tile_index;
     archive &tile.buffer;
   }
 
+  void add(const DeviceRequestedFeatures &features)
+  {
+    archive &features.experimental &features.max_nodes_group &features.nodes_features;
+    archive &features.use_hair &features.use_hair_thick &features.use_object_motion;
+    archive &features.use_camera_motion &features.use_baking &features.use_subsurface;
+    archive &features.use_volume &features.use_integrator_branched;
+    archive &features.use_patch_evaluation &features.use_transparent;
+    archive &features.use_shadow_tricks &features.use_principled &features.use_denoising;
+    archive &features.use_shader_raytrace &features.use_true_displacement;
+    archive &features.use_background_light;
+  }
+
   void write()
   {
     boost::system::error_code error;
@@ -246,7 +291,7 @@ class RPCReceive {
           archive = new i_archive(*archive_stream);
 
           *archive &name;
-          fprintf(stderr, "rpc receive %s\n", name.c_str());
+          VLOG(4) << "RPC receive " << name;
         }
         else {
           error_func->network_error("Network receive error: data size doesn't match header");
@@ -272,8 +317,16 @@ class RPCReceive {
     *archive &mem.data_type &mem.data_elements &mem.data_size;
     *archive &mem.data_width &mem.data_height &mem.data_depth &mem.device_pointer;
     *archive &mem.type &name;
-    *archive &mem.interpolation &mem.extension;
-    *archive &mem.device_pointer;
+
+    if (mem.type == MEM_TEXTURE) {
+      float *transform = (float *)&mem.info.transform_3d;
+
+      *archive &mem.slot &mem.info.data_type &mem.info.interpolation &mem.info.extension;
+      *archive &mem.info.width &mem.info.height &mem.info.depth &mem.info.use_transform_3d;
+      for (int i = 0; i < 12; i++) {
+        *archive &transform[i];
+      }
+    }
 
     mem.name = name.c_str();
     mem.host_pointer = 0;
@@ -309,23 +362,42 @@ class RPCReceive {
     *archive &type &task.x &task.y &task.w &task.h;
     *archive &task.rgba_byte &task.rgba_half &task.buffer &task.sample &task.num_samples;
     *archive &task.offset &task.stride;
-    *archive &task.shader_input &task.shader_output &task.shader_eval_type;
+    *archive &task.shader_input &task.shader_output &task.shader_eval_type &task.shader_filter;
     *archive &task.shader_x &task.shader_w;
-    *archive &task.need_finish_queue;
+    *archive &task.tile_types &task.pass_stride &task.frame_stride &task.target_pass_stride;
+    *archive &task.pass_denoising_data &task.pass_denoising_clean;
+    *archive &task.need_finish_queue &task.integrator_branched;
+    *archive &task.adaptive_sampling.use &task.adaptive_sampling.adaptive_step;
+    *archive &task.adaptive_sampling.min_samples;
 
     task.type = (DeviceTask::Type)type;
   }
 
   void read(RenderTile &tile)
   {
-    *archive &tile.x &tile.y &tile.w &tile.h;
+    int task;
+
+    *archive &task &tile.x &tile.y &tile.w &tile.h;
     *archive &tile.start_sample &tile.num_samples &tile.sample;
-    *archive &tile.resolution &tile.offset &tile.stride;
+    *archive &tile.resolution &tile.offset &tile.stride &tile.tile_index;
     *archive &tile.buffer;
 
+    tile.task = (RenderTile::Task)task;
     tile.buffers = NULL;
   }
 
+  void read(DeviceRequestedFeatures &features)
+  {
+    *archive &features.experimental &features.max_nodes_group &features.nodes_features;
+    *archive &features.use_hair &features.use_hair_thick &features.use_object_motion;
+    *archive &features.use_camera_motion &features.use_baking &features.use_subsurface;
+    *archive &features.use_volume &features.use_integrator_branched;
+    *archive &features.use_patch_evaluation &features.use_transparent;
+    *archive &features.use_shadow_tricks &features.use_principled &features.use_denoising;
+    *archive &features.use_shader_raytrace &features.use_true_displacement;
+    *archive &features.use_background_light;
+  }
+
   string name;
 
  protected:
@@ -340,8 +412,8 @@ class RPCReceive {
 
 class ServerDiscovery {
  public:
-  explicit ServerDiscovery(bool discover = false)
-      : listen_socket(io_service), collect_servers(false)
+  explicit ServerDiscovery(bool discover = false, int server_port = SERVER_PORT)
+      : listen_socket(io_service), server_port(server_port), collect_servers(false)
   {
     /* setup listen socket */
     listen_endpoint.address(boost::asio::ip::address_v4::any());
@@ -402,8 +474,12 @@ class ServerDiscovery {
 
       /* handle incoming message */
       if (collect_servers) {
-        if (msg == DISCOVER_REPLY_MSG) {
+        /* Replies include the port, for multiple servers running on the same host. */
+        if (string_startswith(msg, DISCOVER_REPLY_MSG.c_str())) {
           string address = receive_endpoint.address().to_string();
+          if (msg.size() > DISCOVER_REPLY_MSG.size()) {
+            address += ":" + msg.substr(DISCOVER_REPLY_MSG.size() + 1);
+          }
 
           mutex.lock();
 
@@ -419,7 +495,7 @@ class ServerDiscovery {
       else {
         /* reply to request */
         if (msg == DISCOVER_REQUEST_MSG)
-          broadcast_message(DISCOVER_REPLY_MSG);
+          broadcast_message(string_printf("%s %d", DISCOVER_REPLY_MSG.c_str(), server_port));
       }
     }
 
@@ -463,6 +539,9 @@ class ServerDiscovery {
   boost::asio::io_service::work *work;
   boost::mutex mutex;
 
+  /* port of the render server replying to requests */
+  int server_port;
+
   /* buffer and endpoint for receiving messages */
   char receive_buffer[256];
   boost::asio::ip::udp::endpoint receive_endpoint;
@@ -0,0 +1,239 @@
+/*
+ * Copyright 2011-2020 Blender Foundation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+CCL_NAMESPACE_BEGIN
+
+/* Light Tree
+ *
+ * Picks emitters by traversing a BVH over them, choosing between the two children of every node
+ * in proportion to a conservative estimate of their contribution to the shading point.
+ *
+ * Mesh light triangles and lamps are in separate trees, so the probability of picking a
+ * triangle or a lamp stays the same as with the light distribution. The probabilities of picking
+ * an emitter computed here are then applied as a scale over pdf_triangles and pdf_lights.
+ *
+ * Based on "Importance Sampling of Many Lights with Adaptive Tree Splitting",
+ * Conty Estevez and Kulla, 2018. */
+
+ccl_device float light_tree_node_importance(KernelGlobals *kg, const float3 P, int index)
+{
+  const ccl_global KernelLightTreeNode *knode = &kernel_tex_fetch(__light_tree_nodes, index);
+  if (knode->energy == 0.0f) {
+    return 0.0f;
+  }
+
+  const float3 bounds_min = make_float3(
+      knode->bounds_min[0], knode->bounds_min[1], knode->bounds_min[2]);
+  const float3 bounds_max = make_float3(
+      knode->bounds_max[0], knode->bounds_max[1], knode->bounds_max[2]);
+  const float3 axis = make_float3(knode->axis[0], knode->axis[1], knode->axis[2]);
+
+  const float3 centroid = 0.5f * (bounds_min + bounds_max);
+  const float radius = 0.5f * len(bounds_max - bounds_min);
+  float distance;
+  const float3 D = normalize_len(P - centroid, &distance);
+
+  /* Smallest angle between the emitter normals and the direction to the shading point, over all
+   * points in the bounds. */
+  float cos_theta = dot(axis, D);
+  if (knode->two_sided) {
+    cos_theta = fabsf(cos_theta);
+  }
+  const float theta = safe_acosf(cos_theta);
+  const float theta_u = (distance <= radius) ? M_PI_F : safe_asinf(radius / distance);
+  const float theta_i = max(theta - knode->theta_o - theta_u, 0.0f);
+
+  if (theta_i >= knode->theta_e) {
+    return 0.0f;
+  }
+
+  /* Clamp the distance to avoid singularities for shading points inside the bounds. */
+  const float distance_squared = max(distance * distance, 0.25f * radius * radius);
+  const float importance = knode->energy * cosf(theta_i);
+  return (distance_squared > 0.0f) ? importance / distance_squared : importance;
+}
+
+/* Traverse the tree from the root down to a leaf, returns the leaf node index or -1 when
+ * no emitter in the tree can contribute to the shading point. The random number is rescaled
+ * to be reused for sampling the emitter. */
+ccl_device int light_tree_sample(
+    KernelGlobals *kg, int root, const float3 P, float *randu, float *pick_pdf)
+{
+  int index = root;
+  float pdf = 1.0f;
+  float r = *randu;
+
+  for (;;) {
+    const int child = kernel_tex_fetch(__light_tree_nodes, index).child;
+    if (child < 0) {
+      break;
+    }
+
+    const float importance_left = light_tree_node_importance(kg, P, index + 1);
+    const float importance_right = light_tree_node_importance(kg, P, child);
+    const float importance_total = importance_left + importance_right;
+    if (importance_total == 0.0f) {
+      return -1;
+    }
+
+    const float p_left = importance_left / importance_total;
+    if (r < p_left) {
+      index = index + 1;
+      r = r / p_left;
+      pdf *= p_left;
+    }
+    else {
+      index = child;
+      r = (r - p_left) / (1.0f - p_left);
+      /* Same expression as light_tree_pdf, for sampling and evaluation to match. */
+      pdf *= importance_right / importance_total;
+    }
+  }
+
+  *randu = min(r, 1.0f - FLT_EPSILON);
+  *pick_pdf = pdf;
+  return index;
+}
+
+/* Probability of light_tree_sample picking the leaf. */
+ccl_device float light_tree_pdf(KernelGlobals *kg, const float3 P, int leaf)
+{
+  float pdf = 1.0f;
+  int index = leaf;
+  int parent = kernel_tex_fetch(__light_tree_nodes, index).parent;
+
+  while (parent != -1) {
+    const ccl_global KernelLightTreeNode *kparent = &kernel_tex_fetch(__light_tree_nodes,
+                                                                      parent);
+    const float importance_left = light_tree_node_importance(kg, P, parent + 1);
+    const float importance_right = light_tree_node_importance(kg, P, kparent->child);
+    const float importance_total = importance_left + importance_right;
+    if (importance_total == 0.0f) {
+      return 0.0f;
+    }
+
+    pdf *= ((index == parent + 1) ? importance_left : importance_right) / importance_total;
+    index = parent;
+    parent = kparent->parent;
+  }
+
+  return pdf;
+}
+
+/* Fraction of samples going to triangles, as opposed to lamps. */
+ccl_device_inline float light_tree_triangles_fraction(KernelGlobals *kg)
+{
+  if (kernel_data.integrator.pdf_triangles == 0.0f) {
+    return 0.0f;
+  }
+  return (kernel_data.integrator.num_all_lights) ? 0.5f : 1.0f;
+}
+
+/* Replacement for light_distribution_sample, returns the index in the light distribution and
+ * the factor to scale the pdf of the emitter with. Lamps that can't be bounded in space, like
+ * distant and background lights, are picked uniformly as before. */
+ccl_device int light_tree_distribution_sample(KernelGlobals *kg,
+                                              const float3 P,
+                                              float *randu,
+                                              float *pdf_scale)
+{
+  const float triangles_fraction = light_tree_triangles_fraction(kg);
+  float r = *randu;
+
+  if (r < triangles_fraction) {
+    r = r / triangles_fraction;
+    float pick_pdf;
+    const int leaf = light_tree_sample(
+        kg, kernel_data.integrator.light_tree_triangles_root, P, &r, &pick_pdf);
+    if (leaf == -1) {
+      return -1;
+    }
+
+    /* pdf_triangles includes the probability of picking the triangle by its area. */
+    const ccl_global KernelLightTreeNode *kleaf = &kernel_tex_fetch(__light_tree_nodes, leaf);
+    *pdf_scale = triangles_fraction * pick_pdf /
+                 (kleaf->area * kernel_data.integrator.pdf_triangles);
+    *randu = r;
+    return ~kleaf->child;
+  }
+
+  r = (r - triangles_fraction) / (1.0f - triangles_fraction);
+
+  const int num_lamps = kernel_data.integrator.num_all_lights;
+  const int num_tree_lamps = kernel_data.integrator.light_tree_num_lamps;
+  const float tree_fraction = (float)num_tree_lamps / (float)num_lamps;
+
+  if (r < tree_fraction) {
+    r = r / tree_fraction;
+    float pick_pdf;
+    const int leaf = light_tree_sample(
+        kg, kernel_data.integrator.light_tree_lamps_root, P, &r, &pick_pdf);
+    if (leaf == -1) {
+      return -1;
+    }
+
+    /* pdf_lights includes the probability of picking one of the lamps uniformly. */
+    *pdf_scale = pick_pdf * num_tree_lamps;
+    *randu = r;
+    return ~kernel_tex_fetch(__light_tree_nodes, leaf).child;
+  }
+
+  r = (r - tree_fraction) / (1.0f - tree_fraction);
+
+  const int num_other_lamps = num_lamps - num_tree_lamps;
+  const int other = min((int)(r * num_other_lamps), num_other_lamps - 1);
+  *pdf_scale = 1.0f;
+  *randu = min(r * num_other_lamps - other, 1.0f - FLT_EPSILON);
+  return kernel_tex_fetch(__light_tree_leaf_map,
+                          kernel_data.integrator.light_tree_other_lamps_offset + other);
+}
+
+/* Factor to scale the pdf of a triangle light with, for multiple importance sampling. */
+ccl_device float light_tree_triangle_pdf_scale(KernelGlobals *kg,
+                                               int object,
+                                               int prim,
+                                               const float3 P)
+{
+  /* The leaf map has two entries per object after the lamps, the start of the triangles of the
+   * object in the map and the primitive offset of its mesh. */
+  const int object_offset = kernel_data.integrator.num_all_lights + 2 * object;
+  const int triangles_offset = kernel_tex_fetch(__light_tree_leaf_map, object_offset);
+  if (triangles_offset == -1) {
+    return 0.0f;
+  }
+  const int prim_offset = kernel_tex_fetch(__light_tree_leaf_map, object_offset + 1);
+  const int leaf = kernel_tex_fetch(__light_tree_leaf_map,
+                                    triangles_offset + prim - prim_offset);
+  if (leaf == -1) {
+    return 0.0f;
+  }
+
+  const ccl_global KernelLightTreeNode *kleaf = &kernel_tex_fetch(__light_tree_nodes, leaf);
+  return light_tree_triangles_fraction(kg) * light_tree_pdf(kg, P, leaf) /
+         (kleaf->area * kernel_data.integrator.pdf_triangles);
+}
+
+/* Factor to scale the pdf of a lamp with, for multiple importance sampling. */
+ccl_device float light_tree_lamp_pdf_scale(KernelGlobals *kg, int lamp, const float3 P)
+{
+  const int leaf = kernel_tex_fetch(__light_tree_leaf_map, lamp);
+  if (leaf == -1) {
+    return 1.0f;
+  }
+  return light_tree_pdf(kg, P, leaf) * kernel_data.integrator.light_tree_num_lamps;
+}
+
+CCL_NAMESPACE_END
@@ -372,6 +372,7 @@ typedef enum PassType {
   PASS_AOV_VALUE,
   PASS_ADAPTIVE_AUX_BUFFER,
   PASS_SAMPLE_COUNT,
+  PASS_RENDER_COST,
   PASS_CATEGORY_MAIN_END = 31,
 
   PASS_MIST = 32,
@@ -1263,7 +1264,7 @@ typedef struct KernelFilm {
 
   int pass_bake_primitive;
   int pass_bake_differential;
-  int pad;
+  int pass_render_cost;
 
 #ifdef __KERNEL_DEBUG__
   int pass_bvh_traversed_nodes;
@@ -1387,7 +1388,14 @@ typedef struct KernelIntegrator {
 
   int max_closures;
 
-  int pad1, pad2;
+  /* light tree */
+  int use_light_tree;
+  int light_tree_triangles_root;
+  int light_tree_lamps_root;
+  int light_tree_num_lamps;
+  int light_tree_other_lamps_offset;
+
+  int pad1;
 } KernelIntegrator;
 static_assert_align(KernelIntegrator, 16);
 
@@ -1548,6 +1556,27 @@ typedef struct KernelLightDistribution {
 } KernelLightDistribution;
 static_assert_align(KernelLightDistribution, 16);
 
+/* Node of the light tree, a BVH over emitters with bounds on their orientation, used to pick
+ * emitters by their estimated contribution to a shading point. Interior nodes store the index of
+ * their second child, the first one directly follows them. */
+typedef struct KernelLightTreeNode {
+  float bounds_min[3];
+  float energy;
+  float bounds_max[3];
+  /* Emitter normals are within theta_o of the axis, and emit up to theta_e away from them. */
+  float theta_o;
+  float axis[3];
+  float theta_e;
+  /* Second child for interior nodes, ~index in the light distribution for leaves. */
+  int child;
+  int parent;
+  /* Emission is also along the opposite of the normals. */
+  int two_sided;
+  /* Area of triangle emitters, to convert between picking by area and by the tree. */
+  float area;
+} KernelLightTreeNode;
+static_assert_align(KernelLightTreeNode, 16);
+
 typedef struct KernelParticle {
   int index;
   float age;
@@ -254,6 +254,20 @@ bool RenderBuffers::get_denoising_pass_rect(
   return true;
 }
 
+/* False color for the render cost pass, on a logarithmic scale from 1 microsecond (black)
+ * to 1 millisecond (white) per sample, so tiles rendered separately use the same colors. */
+static float3 render_cost_color(float cost)
+{
+  const float t = saturate(log10f(max(cost, 1.0f)) / 3.0f) * 4.0f;
+  const float3 colors[5] = {make_float3(0.0f, 0.0f, 0.0f),
+                            make_float3(0.0f, 0.0f, 1.0f),
+                            make_float3(1.0f, 0.0f, 0.0f),
+                            make_float3(1.0f, 1.0f, 0.0f),
+                            make_float3(1.0f, 1.0f, 1.0f)};
+  const int i = min((int)t, 3);
+  return interp(colors[i], colors[i + 1], t - i);
+}
+
 bool RenderBuffers::get_pass_rect(
     const string &name, float exposure, int sample, int components, float *pixels)
 {
@@ -299,7 +313,42 @@ bool RenderBuffers::get_pass_rect(
 
     int size = params.width * params.height;
 
-    if (components == 1 && type == PASS_RENDER_TIME) {
+    if (type == PASS_RENDER_COST) {
+      /* With adaptive sampling pixels stop at different sample counts, which are stored in the
+       * sample count pass. */
+      float *pixel_sample_count = NULL;
+      int sample_offset = 0;
+      for (size_t k = 0; k < params.passes.size(); k++) {
+        if (params.passes[k].type == PASS_SAMPLE_COUNT) {
+          pixel_sample_count = buffer.data() + sample_offset;
+          break;
+        }
+        sample_offset += params.passes[k].components;
+      }
+
+      /* Microseconds per sample as value, or as false color. */
+      for (int i = 0; i < size; i++, in += pass_stride, pixels += components) {
+        float cost = *in * scale;
+        if (pixel_sample_count) {
+          /* The count is negative while the tile is rendering. */
+          const float num_samples = fabsf(pixel_sample_count[i * pass_stride]);
+          cost = (num_samples > 0.0f) ? *in / num_samples : 0.0f;
+        }
+        if (components == 1) {
+          pixels[0] = cost;
+        }
+        else {
+          const float3 color = render_cost_color(cost);
+          pixels[0] = color.x;
+          pixels[1] = color.y;
+          pixels[2] = color.z;
+          if (components == 4) {
+            pixels[3] = 1.0f;
+          }
+        }
+      }
+    }
+    else if (components == 1 && type == PASS_RENDER_TIME) {
       /* Render time is not stored by kernel, but measured per tile. */
       float val = (float)(1000.0 * render_time / (params.width * params.height * sample));
       for (int i = 0; i < size; i++, pixels++) {
@@ -63,6 +63,7 @@ static NodeEnum *get_pass_type_enum()
   pass_type_enum.insert("aov_value", PASS_AOV_VALUE);
   pass_type_enum.insert("adaptive_aux_buffer", PASS_ADAPTIVE_AUX_BUFFER);
   pass_type_enum.insert("sample_count", PASS_SAMPLE_COUNT);
+  pass_type_enum.insert("render_cost", PASS_RENDER_COST);
   pass_type_enum.insert("mist", PASS_MIST);
   pass_type_enum.insert("emission", PASS_EMISSION);
   pass_type_enum.insert("background", PASS_BACKGROUND);
@@ -252,6 +253,11 @@ void Pass::add(PassType type, vector<Pass> &passes, const char *name)
       pass.components = 1;
       pass.exposure = false;
       break;
+    case PASS_RENDER_COST:
+      /* Written by the CPU device only, not by the kernel. */
+      pass.components = 1;
+      pass.exposure = false;
+      break;
     case PASS_AOV_COLOR:
       pass.components = 4;
       break;
@@ -454,6 +460,7 @@ void Film::device_update(Device *device, DeviceScene *dscene, Scene *scene)
   kfilm->use_light_pass = use_light_visibility;
   kfilm->pass_aov_value_num = 0;
   kfilm->pass_aov_color_num = 0;
+  kfilm->pass_render_cost = 0;
 
   bool have_cryptomatte = false;
 
@@ -598,6 +605,9 @@ void Film::device_update(Device *device, DeviceScene *dscene, Scene *scene)
       case PASS_SAMPLE_COUNT:
         kfilm->pass_sample_count = kfilm->pass_stride;
         break;
+      case PASS_RENDER_COST:
+        kfilm->pass_render_cost = kfilm->pass_stride;
+        break;
       case PASS_AOV_COLOR:
         if (kfilm->pass_aov_color_num == 0) {
           kfilm->pass_aov_color = kfilm->pass_stride;
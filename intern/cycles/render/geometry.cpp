@@ -61,6 +61,8 @@ Geometry::Geometry(const NodeType *node_type, const Type type)
     : Node(node_type), geometry_type(type), attributes(this, ATTR_PRIM_GEOMETRY)
 {
   need_update_rebuild = false;
+  need_refit = false;
+  need_repack = true;
 
   transform_applied = false;
   transform_negative_scaled = false;
@@ -195,6 +197,7 @@ void Geometry::compute_bvh(
     return;
 
   compute_bounds();
+  need_refit = true;
 
   const BVHLayout bvh_layout = BVHParams::best_bvh_layout(params->bvh_layout,
                                                           device->get_bvh_layout_mask());
@@ -213,11 +216,13 @@ void Geometry::compute_bvh(
     vector<Object *> objects;
     objects.push_back(&object);
 
-    if (bvh && !need_update_rebuild) {
-      progress->set_status(msg, "Refitting BVH");
-
+    if (bvh) {
       bvh->geometry = geometry;
       bvh->objects = objects;
+    }
+
+    if (bvh && !need_update_rebuild && bvh->can_refit()) {
+      progress->set_status(msg, "Refitting BVH");
 
       device->build_bvh(bvh, *progress, true);
     }
@@ -286,6 +291,7 @@ GeometryManager::GeometryManager()
 {
   need_update = true;
   need_flags_update = true;
+  packed_arrays_valid = false;
 }
 
 GeometryManager::~GeometryManager()
@@ -915,6 +921,15 @@ void GeometryManager::device_update_attributes(Device *device,
   scene->object_manager->device_update_mesh_offsets(device, dscene, scene);
 }
 
+/* Assign an offset in the packed arrays, tagging the geometry to be packed again if it moved. */
+static void set_packed_offset(Geometry *geom, size_t &offset, size_t new_offset)
+{
+  if (offset != new_offset) {
+    offset = new_offset;
+    geom->need_repack = true;
+  }
+}
+
 void GeometryManager::mesh_calc_offset(Scene *scene)
 {
   size_t vert_size = 0;
@@ -929,16 +944,20 @@ void GeometryManager::mesh_calc_offset(Scene *scene)
 
   size_t optix_prim_size = 0;
 
+  /* Geometry is laid out in the same order every update, so offsets remain the same as long as
+   * the number of elements in the geometry before it does not change. */
   foreach (Geometry *geom, scene->geometry) {
+    geom->need_repack = geom->is_modified();
+
     if (geom->geometry_type == Geometry::MESH || geom->geometry_type == Geometry::VOLUME) {
       Mesh *mesh = static_cast<Mesh *>(geom);
 
-      mesh->vert_offset = vert_size;
-      mesh->prim_offset = tri_size;
+      set_packed_offset(mesh, mesh->vert_offset, vert_size);
+      set_packed_offset(mesh, mesh->prim_offset, tri_size);
 
-      mesh->patch_offset = patch_size;
-      mesh->face_offset = face_size;
-      mesh->corner_offset = corner_size;
+      set_packed_offset(mesh, mesh->patch_offset, patch_size);
+      set_packed_offset(mesh, mesh->face_offset, face_size);
+      set_packed_offset(mesh, mesh->corner_offset, corner_size);
 
       vert_size += mesh->verts.size();
       tri_size += mesh->num_triangles();
@@ -949,7 +968,7 @@ void GeometryManager::mesh_calc_offset(Scene *scene)
 
         /* patch tables are stored in same array so include them in patch_size */
         if (mesh->patch_table) {
-          mesh->patch_table_offset = patch_size;
+          set_packed_offset(mesh, mesh->patch_table_offset, patch_size);
           patch_size += mesh->patch_table->total_size();
         }
       }
@@ -963,8 +982,8 @@ void GeometryManager::mesh_calc_offset(Scene *scene)
     else if (geom->is_hair()) {
       Hair *hair = static_cast<Hair *>(geom);
 
-      hair->curvekey_offset = curve_key_size;
-      hair->prim_offset = curve_size;
+      set_packed_offset(hair, hair->curvekey_offset, curve_key_size);
+      set_packed_offset(hair, hair->prim_offset, curve_size);
 
       curve_key_size += hair->get_curve_keys().size();
       curve_size += hair->num_curves();
@@ -975,6 +994,53 @@ void GeometryManager::mesh_calc_offset(Scene *scene)
   }
 }
 
+/* Ranges of elements in a packed array that were rewritten. Adjacent ranges are merged, so
+ * consecutive geometry is copied to the device at once. */
+class PackedRanges {
+ public:
+  void add(size_t offset, size_t size)
+  {
+    if (size == 0) {
+      return;
+    }
+    if (!ranges.empty() && ranges.back().first + ranges.back().second == offset) {
+      ranges.back().second += size;
+    }
+    else {
+      ranges.push_back(Range(offset, size));
+    }
+  }
+
+  template<typename T> void copy_to_device(device_vector<T> &data, bool copy_all) const
+  {
+    if (copy_all) {
+      data.copy_to_device();
+      return;
+    }
+    foreach (const Range &range, ranges) {
+      data.copy_to_device_partial(range.first, range.second);
+    }
+  }
+
+ private:
+  typedef pair<size_t, size_t> Range;
+  vector<Range> ranges;
+};
+
+static void add_mesh_update_time(Scene *scene,
+                                 bool for_displacement,
+                                 const char *phase,
+                                 double time)
+{
+  if (scene->update_stats) {
+    scene->update_stats->geometry.times.add_entry(
+        {string_printf("device_update (%scopy meshes to device: %s)",
+                       for_displacement ? "displacement: " : "",
+                       phase),
+         time});
+  }
+}
+
 void GeometryManager::device_update_mesh(
     Device *, DeviceScene *dscene, Scene *scene, bool for_displacement, Progress &progress)
 {
@@ -1000,7 +1066,6 @@ void GeometryManager::device_update_mesh(
 
         /* patch tables are stored in same array so include them in patch_size */
         if (mesh->patch_table) {
-          mesh->patch_table_offset = patch_size;
           patch_size += mesh->patch_table->total_size();
         }
       }
@@ -1038,92 +1103,194 @@ void GeometryManager::device_update_mesh(
     }
   }
 
+  /* Only geometry that was modified or moved is packed and copied again. Everything is packed
+   * when the shader ids changed, or when the arrays were packed for displacement before, as the
+   * mapping to primitive triangles is different then. */
+  const bool repack_all = for_displacement || !packed_arrays_valid ||
+                          packed_shaders != scene->shaders ||
+                          packed_tri_prim_index.size() != tri_prim_index.size();
+
+  /* Invalidate until packing is done, in case the update is cancelled. */
+  packed_arrays_valid = false;
+
+  size_t num_packed = 0;
+
   /* Fill in all the arrays. */
   if (tri_size != 0) {
     /* normals */
     progress.set_status("Updating Mesh", "Computing normals");
 
-    uint *tri_shader = dscene->tri_shader.alloc(tri_size);
-    float4 *vnormal = dscene->tri_vnormal.alloc(vert_size);
-    uint4 *tri_vindex = dscene->tri_vindex.alloc(tri_size);
-    uint *tri_patch = dscene->tri_patch.alloc(tri_size);
-    float2 *tri_patch_uv = dscene->tri_patch_uv.alloc(vert_size);
+    const bool repack_all_triangles = repack_all || dscene->tri_shader.size() != tri_size ||
+                                      dscene->tri_vnormal.size() != vert_size;
+    PackedRanges tri_ranges, vert_ranges;
 
-    foreach (Geometry *geom, scene->geometry) {
-      if (geom->geometry_type == Geometry::MESH || geom->geometry_type == Geometry::VOLUME) {
-        Mesh *mesh = static_cast<Mesh *>(geom);
-        mesh->pack_shaders(scene, &tri_shader[mesh->prim_offset]);
-        mesh->pack_normals(&vnormal[mesh->vert_offset]);
-        mesh->pack_verts(tri_prim_index,
-                         &tri_vindex[mesh->prim_offset],
-                         &tri_patch[mesh->prim_offset],
-                         &tri_patch_uv[mesh->vert_offset],
-                         mesh->vert_offset,
-                         mesh->prim_offset);
-        if (progress.get_cancel())
-          return;
+    {
+      scoped_callback_timer timer([&](double time) {
+        add_mesh_update_time(scene, for_displacement, "pack triangles", time);
+      });
+
+      uint *tri_shader = dscene->tri_shader.alloc(tri_size);
+      float4 *vnormal = dscene->tri_vnormal.alloc(vert_size);
+      uint4 *tri_vindex = dscene->tri_vindex.alloc(tri_size);
+      uint *tri_patch = dscene->tri_patch.alloc(tri_size);
+      float2 *tri_patch_uv = dscene->tri_patch_uv.alloc(vert_size);
+
+      foreach (Geometry *geom, scene->geometry) {
+        if (geom->geometry_type == Geometry::MESH || geom->geometry_type == Geometry::VOLUME) {
+          Mesh *mesh = static_cast<Mesh *>(geom);
+          const size_t num_triangles = mesh->num_triangles();
+
+          /* The primitive triangles can be reordered by the BVH build. */
+          if (!(repack_all_triangles || mesh->need_repack ||
+                !std::equal(tri_prim_index.begin() + mesh->prim_offset,
+                            tri_prim_index.begin() + mesh->prim_offset + num_triangles,
+                            packed_tri_prim_index.begin() + mesh->prim_offset))) {
+            continue;
+          }
+
+          mesh->pack_shaders(scene, &tri_shader[mesh->prim_offset]);
+          mesh->pack_normals(&vnormal[mesh->vert_offset]);
+          mesh->pack_verts(tri_prim_index,
+                           &tri_vindex[mesh->prim_offset],
+                           &tri_patch[mesh->prim_offset],
+                           &tri_patch_uv[mesh->vert_offset],
+                           mesh->vert_offset,
+                           mesh->prim_offset);
+
+          tri_ranges.add(mesh->prim_offset, num_triangles);
+          vert_ranges.add(mesh->vert_offset, mesh->verts.size());
+          num_packed++;
+
+          if (progress.get_cancel())
+            return;
+        }
       }
     }
 
     /* vertex coordinates */
     progress.set_status("Updating Mesh", "Copying Mesh to device");
 
-    dscene->tri_shader.copy_to_device();
-    dscene->tri_vnormal.copy_to_device();
-    dscene->tri_vindex.copy_to_device();
-    dscene->tri_patch.copy_to_device();
-    dscene->tri_patch_uv.copy_to_device();
+    scoped_callback_timer timer([&](double time) {
+      add_mesh_update_time(scene, for_displacement, "copy triangles", time);
+    });
+
+    tri_ranges.copy_to_device(dscene->tri_shader, repack_all_triangles);
+    vert_ranges.copy_to_device(dscene->tri_vnormal, repack_all_triangles);
+    tri_ranges.copy_to_device(dscene->tri_vindex, repack_all_triangles);
+    tri_ranges.copy_to_device(dscene->tri_patch, repack_all_triangles);
+    vert_ranges.copy_to_device(dscene->tri_patch_uv, repack_all_triangles);
+  }
+  else {
+    dscene->tri_shader.free();
+    dscene->tri_vnormal.free();
+    dscene->tri_vindex.free();
+    dscene->tri_patch.free();
+    dscene->tri_patch_uv.free();
   }
 
   if (curve_size != 0) {
     progress.set_status("Updating Mesh", "Copying Strands to device");
 
-    float4 *curve_keys = dscene->curve_keys.alloc(curve_key_size);
-    float4 *curves = dscene->curves.alloc(curve_size);
+    const bool repack_all_curves = repack_all || dscene->curves.size() != curve_size ||
+                                   dscene->curve_keys.size() != curve_key_size;
+    PackedRanges curve_key_ranges, curve_ranges;
 
-    foreach (Geometry *geom, scene->geometry) {
-      if (geom->is_hair()) {
-        Hair *hair = static_cast<Hair *>(geom);
-        hair->pack_curves(scene,
-                          &curve_keys[hair->curvekey_offset],
-                          &curves[hair->prim_offset],
-                          hair->curvekey_offset);
-        if (progress.get_cancel())
-          return;
+    {
+      scoped_callback_timer timer([&](double time) {
+        add_mesh_update_time(scene, for_displacement, "pack curves", time);
+      });
+
+      float4 *curve_keys = dscene->curve_keys.alloc(curve_key_size);
+      float4 *curves = dscene->curves.alloc(curve_size);
+
+      foreach (Geometry *geom, scene->geometry) {
+        if (geom->is_hair() && (repack_all_curves || geom->need_repack)) {
+          Hair *hair = static_cast<Hair *>(geom);
+          hair->pack_curves(scene,
+                            &curve_keys[hair->curvekey_offset],
+                            &curves[hair->prim_offset],
+                            hair->curvekey_offset);
+
+          curve_key_ranges.add(hair->curvekey_offset, hair->get_curve_keys().size());
+          curve_ranges.add(hair->prim_offset, hair->num_curves());
+          num_packed++;
+
+          if (progress.get_cancel())
+            return;
+        }
       }
     }
 
-    dscene->curve_keys.copy_to_device();
-    dscene->curves.copy_to_device();
+    scoped_callback_timer timer([&](double time) {
+      add_mesh_update_time(scene, for_displacement, "copy curves", time);
+    });
+
+    curve_key_ranges.copy_to_device(dscene->curve_keys, repack_all_curves);
+    curve_ranges.copy_to_device(dscene->curves, repack_all_curves);
+  }
+  else {
+    dscene->curve_keys.free();
+    dscene->curves.free();
   }
 
   if (patch_size != 0) {
     progress.set_status("Updating Mesh", "Copying Patches to device");
 
-    uint *patch_data = dscene->patches.alloc(patch_size);
+    const bool repack_all_patches = repack_all || dscene->patches.size() != patch_size;
+    PackedRanges patch_ranges;
 
-    foreach (Geometry *geom, scene->geometry) {
-      if (geom->is_mesh()) {
-        Mesh *mesh = static_cast<Mesh *>(geom);
-        mesh->pack_patches(&patch_data[mesh->patch_offset],
-                           mesh->vert_offset,
-                           mesh->face_offset,
-                           mesh->corner_offset);
+    {
+      scoped_callback_timer timer([&](double time) {
+        add_mesh_update_time(scene, for_displacement, "pack patches", time);
+      });
 
-        if (mesh->patch_table) {
-          mesh->patch_table->copy_adjusting_offsets(&patch_data[mesh->patch_table_offset],
-                                                    mesh->patch_table_offset);
-        }
+      uint *patch_data = dscene->patches.alloc(patch_size);
 
-        if (progress.get_cancel())
-          return;
+      foreach (Geometry *geom, scene->geometry) {
+        if (geom->is_mesh() && (repack_all_patches || geom->need_repack)) {
+          Mesh *mesh = static_cast<Mesh *>(geom);
+          if (mesh->get_num_subd_faces() == 0) {
+            continue;
+          }
+
+          mesh->pack_patches(&patch_data[mesh->patch_offset],
+                             mesh->vert_offset,
+                             mesh->face_offset,
+                             mesh->corner_offset);
+
+          size_t patch_end = mesh->patch_offset;
+          Mesh::SubdFace last = mesh->get_subd_face(mesh->get_num_subd_faces() - 1);
+          patch_end += (last.ptex_offset + last.num_ptex_faces()) * 8;
+
+          if (mesh->patch_table) {
+            mesh->patch_table->copy_adjusting_offsets(&patch_data[mesh->patch_table_offset],
+                                                      mesh->patch_table_offset);
+            patch_end = mesh->patch_table_offset + mesh->patch_table->total_size();
+          }
+
+          patch_ranges.add(mesh->patch_offset, patch_end - mesh->patch_offset);
+
+          if (progress.get_cancel())
+            return;
+        }
       }
     }
 
-    dscene->patches.copy_to_device();
+    scoped_callback_timer timer([&](double time) {
+      add_mesh_update_time(scene, for_displacement, "copy patches", time);
+    });
+
+    patch_ranges.copy_to_device(dscene->patches, repack_all_patches);
+  }
+  else {
+    dscene->patches.free();
   }
 
   if (for_displacement) {
+    scoped_callback_timer timer([&](double time) {
+      add_mesh_update_time(scene, for_displacement, "pack triangle vertices", time);
+    });
+
     float4 *prim_tri_verts = dscene->prim_tri_verts.alloc(tri_size * 3);
     foreach (Geometry *geom, scene->geometry) {
       if (geom->geometry_type == Geometry::MESH || geom->geometry_type == Geometry::VOLUME) {
@@ -1139,11 +1306,19 @@ void GeometryManager::device_update_mesh(
     }
     dscene->prim_tri_verts.copy_to_device();
   }
+
+  VLOG(1) << "Packed " << num_packed << " of " << scene->geometry.size() << " geometries"
+          << (repack_all ? " (full repack)." : ".");
+
+  packed_tri_prim_index.swap(tri_prim_index);
+  packed_shaders = scene->shaders;
+  packed_arrays_valid = !for_displacement;
 }
 
 void GeometryManager::device_update_bvh(Device *device,
                                         DeviceScene *dscene,
                                         Scene *scene,
+                                        bool need_rebuild,
                                         Progress &progress)
 {
   /* bvh build */
@@ -1163,9 +1338,29 @@ void GeometryManager::device_update_bvh(Device *device,
 
   VLOG(1) << "Using " << bvh_layout_name(bparams.bvh_layout) << " layout.";
 
-  delete scene->bvh;
-  BVH *bvh = scene->bvh = BVH::create(bparams, scene->geometry, scene->objects, device);
-  device->build_bvh(bvh, progress, false);
+  /* Refit the Embree scene when geometry only deformed and objects moved, as is common when
+   * rendering animations with persistent data. Other layouts pack the scene BVH together with
+   * the object BVHs and are always built again. */
+  BVH *bvh = scene->bvh;
+  const bool refit = bvh && !need_rebuild && bparams.bvh_layout == BVH_LAYOUT_EMBREE &&
+                     bvh->params.bvh_layout == BVH_LAYOUT_EMBREE &&
+                     bvh->objects == scene->objects && bvh->geometry == scene->geometry &&
+                     bvh->can_refit();
+
+  if (refit) {
+    VLOG(1) << "Refitting scene BVH.";
+    progress.set_status("Updating Scene BVH", "Refitting");
+    device->build_bvh(bvh, progress, true);
+  }
+  else {
+    delete scene->bvh;
+    bvh = scene->bvh = BVH::create(bparams, scene->geometry, scene->objects, device);
+    device->build_bvh(bvh, progress, false);
+  }
+
+  foreach (Geometry *geom, scene->geometry) {
+    geom->need_refit = false;
+  }
 
   if (progress.get_cancel()) {
     return;
@@ -1524,16 +1719,10 @@ void GeometryManager::device_update(Device *device,
   }
 
   /* Device update. */
-  device_free(device, dscene);
+  device_free(device, dscene, false);
 
   mesh_calc_offset(scene);
   if (true_displacement_used) {
-    scoped_callback_timer timer([scene](double time) {
-      if (scene->update_stats) {
-        scene->update_stats->geometry.times.add_entry(
-            {"device_update (displacement: copy meshes to device)", time});
-      }
-    });
     device_update_mesh(device, dscene, scene, true, progress);
   }
   if (progress.get_cancel()) {
@@ -1556,6 +1745,7 @@ void GeometryManager::device_update(Device *device,
   BVHLayout bvh_layout = BVHParams::best_bvh_layout(scene->params.bvh_layout,
                                                     device->get_bvh_layout_mask());
   bool displacement_done = false;
+  bool need_scene_bvh_rebuild = false;
   size_t num_bvh = 0;
 
   {
@@ -1577,6 +1767,11 @@ void GeometryManager::device_update(Device *device,
         if (geom->need_build_bvh(bvh_layout)) {
           num_bvh++;
         }
+
+        /* Changed topology requires building the scene BVH again, compute_bvh() clears it. */
+        if (geom->need_update_rebuild) {
+          need_scene_bvh_rebuild = true;
+        }
       }
 
       if (progress.get_cancel()) {
@@ -1597,7 +1792,7 @@ void GeometryManager::device_update(Device *device,
             {"device_update (displacement: attributes)", time});
       }
     });
-    device_free(device, dscene);
+    device_free(device, dscene, false);
 
     device_update_attributes(device, dscene, scene, progress);
     if (progress.get_cancel()) {
@@ -1659,23 +1854,16 @@ void GeometryManager::device_update(Device *device,
         scene->update_stats->geometry.times.add_entry({"device_update (build scene BVH)", time});
       }
     });
-    device_update_bvh(device, dscene, scene, progress);
+    device_update_bvh(device, dscene, scene, need_scene_bvh_rebuild, progress);
     if (progress.get_cancel()) {
       return;
     }
   }
 
-  {
-    scoped_callback_timer timer([scene](double time) {
-      if (scene->update_stats) {
-        scene->update_stats->geometry.times.add_entry(
-            {"device_update (copy meshes to device)", time});
-      }
-    });
-    device_update_mesh(device, dscene, scene, false, progress);
-    if (progress.get_cancel()) {
-      return;
-    }
+  /* Timings of the phases are added by device_update_mesh. */
+  device_update_mesh(device, dscene, scene, false, progress);
+  if (progress.get_cancel()) {
+    return;
   }
 
   need_update = false;
@@ -1691,7 +1879,7 @@ void GeometryManager::device_update(Device *device,
   }
 }
 
-void GeometryManager::device_free(Device *device, DeviceScene *dscene)
+void GeometryManager::device_free(Device *device, DeviceScene *dscene, bool force_free)
 {
   dscene->bvh_nodes.free();
   dscene->bvh_leaf_nodes.free();
@@ -1703,20 +1891,28 @@ void GeometryManager::device_free(Device *device, DeviceScene *dscene)
   dscene->prim_index.free();
   dscene->prim_object.free();
   dscene->prim_time.free();
-  dscene->tri_shader.free();
-  dscene->tri_vnormal.free();
-  dscene->tri_vindex.free();
-  dscene->tri_patch.free();
-  dscene->tri_patch_uv.free();
-  dscene->curves.free();
-  dscene->curve_keys.free();
-  dscene->patches.free();
   dscene->attributes_map.free();
   dscene->attributes_float.free();
   dscene->attributes_float2.free();
   dscene->attributes_float3.free();
   dscene->attributes_uchar4.free();
 
+  /* Packed geometry arrays are kept for device_update_mesh to update only what changed. */
+  if (force_free) {
+    dscene->tri_shader.free();
+    dscene->tri_vnormal.free();
+    dscene->tri_vindex.free();
+    dscene->tri_patch.free();
+    dscene->tri_patch_uv.free();
+    dscene->curves.free();
+    dscene->curve_keys.free();
+    dscene->patches.free();
+
+    packed_tri_prim_index.clear();
+    packed_shaders.clear();
+    packed_arrays_valid = false;
+  }
+
   /* Signal for shaders like displacement not to do ray tracing. */
   dscene->data.bvh.bvh_layout = BVH_LAYOUT_NONE;
 
@@ -90,6 +90,12 @@ class Geometry : public Node {
 
   /* Update Flags */
   bool need_update_rebuild;
+  /* Geometry was modified since the BVHs were last updated, for refitting them. Set in
+   * compute_bvh() and cleared once the scene BVH is updated. */
+  bool need_refit;
+  /* Packed arrays need to be rewritten, because the geometry was modified or moved to other
+   * offsets in the arrays. Set in mesh_calc_offset(). */
+  bool need_repack;
 
   /* Index into scene->geometry (only valid during update) */
   size_t index;
@@ -174,7 +180,9 @@ class GeometryManager {
   /* Device Updates */
   void device_update_preprocess(Device *device, Scene *scene, Progress &progress);
   void device_update(Device *device, DeviceScene *dscene, Scene *scene, Progress &progress);
-  void device_free(Device *device, DeviceScene *dscene);
+  /* The packed geometry arrays are only freed with force_free, otherwise they are kept to be
+   * updated in place by the next device update. */
+  void device_free(Device *device, DeviceScene *dscene, bool force_free);
 
   /* Updates */
   void tag_update(Scene *scene);
@@ -213,13 +221,23 @@ class GeometryManager {
                                 Scene *scene,
                                 Progress &progress);
 
-  void device_update_bvh(Device *device, DeviceScene *dscene, Scene *scene, Progress &progress);
+  void device_update_bvh(Device *device,
+                         DeviceScene *dscene,
+                         Scene *scene,
+                         bool need_rebuild,
+                         Progress &progress);
 
   void device_update_displacement_images(Device *device, Scene *scene, Progress &progress);
 
   void device_update_volume_images(Device *device, Scene *scene, Progress &progress);
 
  private:
+  /* State of the packed geometry arrays from the last device_update_mesh(), to only rewrite and
+   * upload the geometry that changed. */
+  vector<uint> packed_tri_prim_index;
+  vector<Shader *> packed_shaders;
+  bool packed_arrays_valid;
+
   static void update_attribute_element_offset(Geometry *geom,
                                               device_vector<float> &attr_float,
                                               size_t &attr_float_offset,
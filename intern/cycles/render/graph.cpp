@@ -17,6 +17,7 @@
 #include "render/graph.h"
 #include "render/attribute.h"
 #include "render/constant_fold.h"
+#include "render/image.h"
 #include "render/nodes.h"
 #include "render/scene.h"
 #include "render/shader.h"
@@ -214,6 +215,12 @@ bool ShaderNode::equals(const ShaderNode &other)
   return true;
 }
 
+void ShaderNode::hash(MD5Hash &md5)
+{
+  Node::hash(md5);
+  md5.append((uint8_t *)&bump, sizeof(bump));
+}
+
 /* Graph */
 
 ShaderGraph::ShaderGraph()
@@ -383,6 +390,9 @@ void ShaderGraph::finalize(Scene *scene, bool do_bump, bool do_simplify, bool bu
     if (do_bump)
       bump_from_displacement(bump_in_object_space);
 
+    if (scene->image_manager->has_texture_cache())
+      refine_image_derivatives(scene);
+
     ShaderInput *surface_in = output()->input("Surface");
     ShaderInput *volume_in = output()->input("Volume");
 
@@ -776,6 +786,52 @@ void ShaderGraph::compute_displacement_hash()
   displacement_hash = md5.get_hex();
 }
 
+void ShaderGraph::compute_finalized_hash()
+{
+  /* Compute hash of all nodes of the finalized graph, to share the compiled
+   * shader between graphs that are identical after constant folding and other
+   * simplifications. Links are hashed by the position of the node in the
+   * graph rather than its id, as ids of removed nodes leave gaps. */
+  assert(finalized);
+
+  map<ShaderNode *, int> node_index;
+  foreach (ShaderNode *node, nodes) {
+    int index = node_index.size();
+    node_index[node] = index;
+  }
+
+  MD5Hash md5;
+  foreach (ShaderNode *node, nodes) {
+    /* IES textures and UDIM tiles are set up on compile for the specific
+     * shader, leave the hash empty so the graph is always compiled. */
+    if (node->type == IESLightNode::node_type) {
+      finalized_hash = "";
+      return;
+    }
+    if (node->type == ImageTextureNode::node_type) {
+      ImageTextureNode *image_node = static_cast<ImageTextureNode *>(node);
+      if (image_node->handle.empty() && image_node->get_tiles().size() > 1) {
+        finalized_hash = "";
+        return;
+      }
+    }
+
+    node->hash(md5);
+    foreach (ShaderInput *input, node->inputs) {
+      int link_index = (input->link) ? node_index[input->link->parent] : -1;
+      md5.append((uint8_t *)&link_index, sizeof(link_index));
+      md5.append((input->link) ? input->link->name().c_str() : "");
+    }
+
+    if (node->special_type == SHADER_SPECIAL_TYPE_OSL) {
+      OSLNode *oslnode = static_cast<OSLNode *>(node);
+      md5.append(oslnode->bytecode_hash);
+    }
+  }
+
+  finalized_hash = md5.get_hex();
+}
+
 void ShaderGraph::clean(Scene *scene)
 {
   /* Graph simplification */
@@ -954,6 +1010,51 @@ void ShaderGraph::refine_bump_nodes()
   }
 }
 
+void ShaderGraph::refine_image_derivatives(Scene *scene)
+{
+  /* Images read through the texture cache need the footprint of the lookup to pick mipmap
+   * levels. Like for bump nodes, we copy the sub-graph defined by the vector input twice and
+   * evaluate the copies at positions shifted by the ray differentials. Nodes that are already
+   * part of a bump evaluation are skipped, and look up the full resolution image. */
+
+  foreach (ShaderNode *node, nodes) {
+    if (node->type != ImageTextureNode::node_type || node->bump != SHADER_BUMP_NONE) {
+      continue;
+    }
+
+    /* Images loaded into device memory have no use for the derivatives. */
+    ImageTextureNode *image_node = static_cast<ImageTextureNode *>(node);
+    ShaderInput *vector_in = node->input("Vector");
+    if (!vector_in->link || image_node->get_projection() == NODE_IMAGE_PROJ_BOX ||
+        !image_node->uses_texture_cache(scene, this)) {
+      continue;
+    }
+
+    ShaderNodeSet nodes_vector;
+    ShaderNodeMap nodes_dx;
+    ShaderNodeMap nodes_dy;
+
+    find_dependencies(nodes_vector, vector_in);
+
+    copy_nodes(nodes_vector, nodes_dx);
+    copy_nodes(nodes_vector, nodes_dy);
+
+    foreach (NodePair &pair, nodes_dx)
+      pair.second->bump = SHADER_BUMP_DX;
+    foreach (NodePair &pair, nodes_dy)
+      pair.second->bump = SHADER_BUMP_DY;
+
+    ShaderOutput *out = vector_in->link;
+    connect(nodes_dx[out->parent]->output(out->name()), node->input("VectorDX"));
+    connect(nodes_dy[out->parent]->output(out->name()), node->input("VectorDY"));
+
+    foreach (NodePair &pair, nodes_dx)
+      add(pair.second);
+    foreach (NodePair &pair, nodes_dy)
+      add(pair.second);
+  }
+}
+
 void ShaderGraph::bump_from_displacement(bool use_object_space)
 {
   /* generate bump mapping automatically from displacement. bump mapping is
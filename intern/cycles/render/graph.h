@@ -268,6 +268,14 @@ class ShaderNode : public Node {
    * is to be handled in the subclass.
    */
   virtual bool equals(const ShaderNode &other);
+
+  /* Compute hash of the node settings that affect how it compiles.
+   *
+   * Like equals(), runtime state that is not a socket is to be added by
+   * the subclass. Nodes whose compiled code can not be shared with other
+   * shaders add something unique to them.
+   */
+  virtual void hash(MD5Hash &md5);
 };
 
 /* Node definition utility macros */
@@ -319,6 +327,7 @@ class ShaderGraph : public NodeOwner {
   bool finalized;
   bool simplified;
   string displacement_hash;
+  string finalized_hash;
 
   ShaderGraph();
   ~ShaderGraph();
@@ -335,6 +344,7 @@ class ShaderGraph : public NodeOwner {
 
   void remove_proxy_nodes();
   void compute_displacement_hash();
+  void compute_finalized_hash();
   void simplify(Scene *scene);
   void finalize(Scene *scene,
                 bool do_bump = false,
@@ -373,6 +383,7 @@ class ShaderGraph : public NodeOwner {
   void break_cycles(ShaderNode *node, vector<bool> &visited, vector<bool> &on_stack);
   void bump_from_displacement(bool use_object_space);
   void refine_bump_nodes();
+  void refine_image_derivatives(Scene *scene);
   void expand();
   void default_inputs(bool do_osl);
   void transform_multi_closure(ShaderNode *node, ShaderOutput *weight_out, bool volume);
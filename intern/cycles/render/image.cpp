@@ -30,8 +30,11 @@
 #include "util/util_progress.h"
 #include "util/util_task.h"
 #include "util/util_texture.h"
+#include "util/util_texture_cache.h"
 #include "util/util_unique_ptr.h"
 
+#include <OpenImageIO/texture.h>
+
 #ifdef WITH_OSL
 #  include <OSL/oslexec.h>
 #endif
@@ -77,6 +80,8 @@ const char *name_from_type(ImageDataType type)
       return "nanovdb_float";
     case IMAGE_DATA_TYPE_NANOVDB_FLOAT3:
       return "nanovdb_float3";
+    case IMAGE_DATA_TYPE_TEXTURE_CACHE:
+      return "texture_cache";
     case IMAGE_DATA_NUM_TYPES:
       assert(!"System enumerator type, should never be used");
       return "";
@@ -151,6 +156,25 @@ ImageMetaData ImageHandle::metadata()
   return img->metadata;
 }
 
+/* Whether all tiles are read through the texture cache, instead of being loaded into device
+ * memory. */
+bool ImageHandle::uses_texture_cache()
+{
+  if (tile_slots.empty()) {
+    return false;
+  }
+
+  foreach (int slot, tile_slots) {
+    ImageManager::Image *img = manager->images[slot];
+    manager->load_image_metadata(img);
+    if (manager->texture_cache_handle(img) == NULL) {
+      return false;
+    }
+  }
+
+  return true;
+}
+
 int ImageHandle::svm_slot(const int tile_index) const
 {
   if (tile_index >= tile_slots.size()) {
@@ -300,6 +324,8 @@ ImageManager::ImageManager(const DeviceInfo &info)
 {
   need_update = true;
   osl_texture_system = NULL;
+  texture_cache = NULL;
+  texture_cache_limit = 0;
   animation_frame = 0;
 
   /* Set image limits */
@@ -310,6 +336,10 @@ ImageManager::~ImageManager()
 {
   for (size_t slot = 0; slot < images.size(); slot++)
     assert(!images[slot]);
+
+  if (texture_cache) {
+    TextureSystem::destroy((TextureSystem *)texture_cache);
+  }
 }
 
 void ImageManager::set_osl_texture_system(void *texture_system)
@@ -317,6 +347,26 @@ void ImageManager::set_osl_texture_system(void *texture_system)
   osl_texture_system = texture_system;
 }
 
+void ImageManager::enable_texture_cache(const int max_memory_mb, const int texture_limit)
+{
+  if (texture_cache == NULL) {
+    /* Not shared with OSL or other scenes, so the memory budget applies to this scene only. */
+    TextureSystem *texture_system = TextureSystem::create(false);
+    texture_system->attribute("automip", 1);
+    texture_system->attribute("autotile", 64);
+    texture_system->attribute("gray_to_rgb", 1);
+    texture_cache = texture_system;
+  }
+
+  ((TextureSystem *)texture_cache)->attribute("max_memory_MB", (float)max_memory_mb);
+  texture_cache_limit = texture_limit;
+}
+
+bool ImageManager::has_texture_cache() const
+{
+  return texture_cache != NULL;
+}
+
 bool ImageManager::set_animation_frame_update(int frame)
 {
   if (frame != animation_frame) {
@@ -646,6 +696,45 @@ bool ImageManager::file_load_image(Image *img, int texture_limit)
   return true;
 }
 
+void *ImageManager::texture_cache_handle(Image *img)
+{
+  if (texture_cache == NULL) {
+    return NULL;
+  }
+
+  const ustring filepath = img->loader->osl_filepath();
+  if (filepath.empty()) {
+    return NULL;
+  }
+
+  /* The texture cache reads pixels as they are in the file, so only use it for images that
+   * need no conversion on load. Everything else is loaded fully as before. */
+  const ImageMetaData &metadata = img->metadata;
+  if (metadata.depth > 1 ||
+      !(metadata.channels == 1 || metadata.channels == 3 || metadata.channels == 4)) {
+    return NULL;
+  }
+  if (metadata.colorspace != u_colorspace_raw && metadata.colorspace != u_colorspace_srgb) {
+    return NULL;
+  }
+  if (metadata.channels == 4 && !image_associate_alpha(img)) {
+    return NULL;
+  }
+  /* Larger images are scaled down to the texture limit on load. */
+  if (texture_cache_limit > 0 &&
+      max(metadata.width, metadata.height) > (size_t)texture_cache_limit) {
+    return NULL;
+  }
+
+  TextureSystem *texture_system = (TextureSystem *)texture_cache;
+  TextureSystem::TextureHandle *handle = texture_system->get_texture_handle(filepath);
+  if (handle == NULL || !texture_system->good(handle)) {
+    return NULL;
+  }
+
+  return handle;
+}
+
 void ImageManager::device_load_image(Device *device, Scene *scene, int slot, Progress *progress)
 {
   if (progress->get_cancel()) {
@@ -661,6 +750,12 @@ void ImageManager::device_load_image(Device *device, Scene *scene, int slot, Pro
   load_image_metadata(img);
   ImageDataType type = img->metadata.type;
 
+  /* Images in the texture cache only need a description for the kernel. */
+  void *cache_handle = texture_cache_handle(img);
+  if (cache_handle) {
+    type = IMAGE_DATA_TYPE_TEXTURE_CACHE;
+  }
+
   /* Name for debugging. */
   img->mem_name = string_printf("__tex_image_%s_%03d", name_from_type(type), slot);
 
@@ -677,7 +772,15 @@ void ImageManager::device_load_image(Device *device, Scene *scene, int slot, Pro
   img->mem->info.transform_3d = img->metadata.transform_3d;
 
   /* Create new texture. */
-  if (type == IMAGE_DATA_TYPE_FLOAT4) {
+  if (type == IMAGE_DATA_TYPE_TEXTURE_CACHE) {
+    thread_scoped_lock device_lock(device_mutex);
+    TextureCacheImage *cache_image = (TextureCacheImage *)img->mem->alloc(
+        sizeof(TextureCacheImage), 0);
+
+    cache_image->texture_system = texture_cache;
+    cache_image->handle = cache_handle;
+  }
+  else if (type == IMAGE_DATA_TYPE_FLOAT4) {
     if (!file_load_image<TypeDesc::FLOAT, float>(img, texture_limit)) {
       /* on failure to load, we set a 1x1 pixels pink image */
       thread_scoped_lock device_lock(device_mutex);
@@ -798,6 +901,11 @@ void ImageManager::device_free_image(Device *, int slot)
 #endif
   }
 
+  /* Images loaded into device memory were never opened by the texture cache. */
+  if (img->mem && img->mem->info.data_type == IMAGE_DATA_TYPE_TEXTURE_CACHE) {
+    ((TextureSystem *)texture_cache)->invalidate(img->loader->osl_filepath());
+  }
+
   if (img->mem) {
     thread_scoped_lock device_lock(device_mutex);
     delete img->mem;
@@ -888,12 +996,48 @@ void ImageManager::device_free(Device *device)
   images.clear();
 }
 
+/* Statistics of the texture cache may be 32 or 64 bit integers depending on the OIIO version. */
+static uint64_t texture_cache_statistic(TextureSystem *texture_system, const char *name)
+{
+  long long value64 = 0;
+  if (texture_system->getattribute(name, TypeDesc::INT64, &value64)) {
+    return value64;
+  }
+  int value = 0;
+  if (texture_system->getattribute(name, TypeDesc::INT, &value)) {
+    return value;
+  }
+  return 0;
+}
+
 void ImageManager::collect_statistics(RenderStats *stats)
 {
   foreach (const Image *image, images) {
     stats->image.textures.add_entry(
         NamedSizeEntry(image->loader->name(), image->mem->memory_size()));
   }
+
+  if (texture_cache) {
+    TextureSystem *texture_system = (TextureSystem *)texture_cache;
+    TextureCacheStats &cache_stats = stats->image.texture_cache;
+
+    float max_memory_mb = 0.0f;
+    float file_io_time = 0.0f;
+    texture_system->getattribute("max_memory_MB", TypeDesc::FLOAT, &max_memory_mb);
+    texture_system->getattribute("stat:fileio_time", TypeDesc::FLOAT, &file_io_time);
+
+    cache_stats.used = true;
+    cache_stats.memory_limit = (size_t)(max_memory_mb * 1024.0f * 1024.0f);
+    cache_stats.memory_used = texture_cache_statistic(texture_system, "stat:cache_memory_used");
+    cache_stats.bytes_read = texture_cache_statistic(texture_system, "stat:bytes_read");
+    cache_stats.num_files = texture_cache_statistic(texture_system, "stat:unique_files");
+    cache_stats.file_io_time = file_io_time;
+    cache_stats.tile_lookups = texture_cache_statistic(texture_system, "stat:find_tile_calls");
+    cache_stats.microcache_misses = texture_cache_statistic(texture_system,
+                                                            "stat:find_tile_microcache_misses");
+    cache_stats.cache_misses = texture_cache_statistic(texture_system,
+                                                       "stat:find_tile_cache_misses");
+  }
 }
 
 CCL_NAMESPACE_END
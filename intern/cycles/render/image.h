@@ -150,6 +150,7 @@ class ImageHandle {
   int num_tiles();
 
   ImageMetaData metadata();
+  bool uses_texture_cache();
   int svm_slot(const int tile_index = 0) const;
   device_texture *image_memory(const int tile_index = 0) const;
 
@@ -187,6 +188,12 @@ class ImageManager {
   void set_osl_texture_system(void *texture_system);
   bool set_animation_frame_update(int frame);
 
+  /* Read file images on demand in tiles and mipmap levels, instead of loading them fully into
+   * device memory. Only for the CPU device with SVM. Images larger than the texture limit are
+   * loaded and scaled down as before. */
+  void enable_texture_cache(const int max_memory_mb, const int texture_limit);
+  bool has_texture_cache() const;
+
   void collect_statistics(RenderStats *stats);
 
   bool need_update;
@@ -217,12 +224,15 @@ class ImageManager {
 
   vector<Image *> images;
   void *osl_texture_system;
+  void *texture_cache;
+  int texture_cache_limit;
 
   int add_image_slot(ImageLoader *loader, const ImageParams &params, const bool builtin);
   void add_image_user(int slot);
   void remove_image_user(int slot);
 
   void load_image_metadata(Image *img);
+  void *texture_cache_handle(Image *img);
 
   template<TypeDesc::BASETYPE FileFormat, typename StorageType>
   bool file_load_image(Image *img, int texture_limit);
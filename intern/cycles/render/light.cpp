@@ -20,6 +20,7 @@
 #include "render/film.h"
 #include "render/graph.h"
 #include "render/integrator.h"
+#include "render/light_tree.h"
 #include "render/mesh.h"
 #include "render/nodes.h"
 #include "render/object.h"
@@ -276,6 +277,52 @@ bool LightManager::object_usable_as_light(Object *object)
   return false;
 }
 
+/* Bounds of a lamp for the light tree, returns false for lamps that aren't at a position in
+ * space and are picked uniformly instead. */
+static bool light_tree_lamp_emitter(const Light *light, LightTreeEmitter *emitter)
+{
+  const float3 co = light->get_co();
+  OrientationBounds &orientation = emitter->orientation;
+  orientation.two_sided = false;
+
+  switch (light->get_light_type()) {
+    case LIGHT_POINT: {
+      const float radius = light->get_size();
+      emitter->bounds = BoundBox(co - make_float3(radius), co + make_float3(radius));
+      orientation.axis = make_float3(0.0f, 0.0f, 1.0f);
+      orientation.theta_o = M_PI_F;
+      orientation.theta_e = M_PI_2_F;
+      break;
+    }
+    case LIGHT_SPOT: {
+      const float radius = light->get_size();
+      emitter->bounds = BoundBox(co - make_float3(radius), co + make_float3(radius));
+      orientation.axis = safe_normalize(light->get_dir());
+      orientation.theta_o = 0.0f;
+      orientation.theta_e = min(light->get_spot_angle() * 0.5f, M_PI_2_F);
+      break;
+    }
+    case LIGHT_AREA: {
+      const float3 axisu = 0.5f * light->get_axisu() * (light->get_sizeu() * light->get_size());
+      const float3 axisv = 0.5f * light->get_axisv() * (light->get_sizev() * light->get_size());
+      emitter->bounds = BoundBox(co - axisu - axisv);
+      emitter->bounds.grow(co - axisu + axisv);
+      emitter->bounds.grow(co + axisu - axisv);
+      emitter->bounds.grow(co + axisu + axisv);
+      orientation.axis = safe_normalize(light->get_dir());
+      orientation.theta_o = 0.0f;
+      orientation.theta_e = M_PI_2_F;
+      break;
+    }
+    default:
+      return false;
+  }
+
+  emitter->energy = average(fabs(light->get_strength()));
+  emitter->area = 0.0f;
+  return true;
+}
+
 void LightManager::device_update_distribution(Device *,
                                               DeviceScene *dscene,
                                               Scene *scene,
@@ -326,6 +373,25 @@ void LightManager::device_update_distribution(Device *,
   size_t num_distribution = num_triangles + num_lights;
   VLOG(1) << "Total " << num_distribution << " of light distribution primitives.";
 
+  /* Light tree. Lamps are sampled individually when sampling all lights, so only triangles
+   * can use the tree then. */
+  const Integrator *integrator = scene->integrator;
+  const bool use_light_tree = integrator->get_use_light_tree();
+  const bool use_lamp_tree = use_light_tree &&
+                             !(integrator->get_method() == Integrator::BRANCHED_PATH &&
+                               (integrator->get_sample_all_lights_direct() ||
+                                integrator->get_sample_all_lights_indirect()));
+  vector<LightTreeEmitter> triangle_emitters;
+  vector<LightTreeEmitter> lamp_emitters;
+  vector<int> other_lamps;
+  /* Index of the leaf of every emitter in the leaf map, see light_tree_triangle_pdf_scale. */
+  vector<int> leaf_map;
+  vector<int> distribution_leaf_map_index;
+  if (use_light_tree) {
+    leaf_map.resize(num_lights + 2 * scene->objects.size(), -1);
+    distribution_leaf_map_index.resize(num_distribution, -1);
+  }
+
   /* emission area */
   KernelLightDistribution *distribution = dscene->light_distribution.alloc(num_distribution + 1);
   float totarea = 0.0f;
@@ -367,6 +433,13 @@ void LightManager::device_update_distribution(Device *,
     }
 
     size_t mesh_num_triangles = mesh->num_triangles();
+    size_t leaf_map_triangles_offset = leaf_map.size();
+    if (use_light_tree) {
+      leaf_map[num_lights + 2 * object_id] = leaf_map_triangles_offset;
+      leaf_map[num_lights + 2 * object_id + 1] = mesh->prim_offset;
+      leaf_map.resize(leaf_map_triangles_offset + mesh_num_triangles, -1);
+    }
+
     for (size_t i = 0; i < mesh_num_triangles; i++) {
       int shader_index = mesh->get_shader()[i];
       Shader *shader = (shader_index < mesh->get_used_shaders().size()) ?
@@ -374,6 +447,7 @@ void LightManager::device_update_distribution(Device *,
                            scene->default_surface;
 
       if (shader->get_use_mis() && shader->has_surface_emission) {
+        const size_t distribution_index = offset;
         distribution[offset].totarea = totarea;
         distribution[offset].prim = i + mesh->prim_offset;
         distribution[offset].mesh_light.shader_flag = shader_flag;
@@ -394,7 +468,25 @@ void LightManager::device_update_distribution(Device *,
           p3 = transform_point(&tfm, p3);
         }
 
-        totarea += triangle_area(p1, p2, p3);
+        const float area = triangle_area(p1, p2, p3);
+        totarea += area;
+
+        if (use_light_tree && area > 0.0f) {
+          LightTreeEmitter emitter;
+          emitter.bounds = BoundBox(p1);
+          emitter.bounds.grow(p2);
+          emitter.bounds.grow(p3);
+          emitter.orientation.axis = safe_normalize(cross(p2 - p1, p3 - p1));
+          emitter.orientation.theta_o = 0.0f;
+          emitter.orientation.theta_e = M_PI_2_F;
+          emitter.orientation.two_sided = true;
+          /* Emission strength is not known before shader evaluation. */
+          emitter.energy = area;
+          emitter.area = area;
+          emitter.distribution_index = distribution_index;
+          triangle_emitters.push_back(emitter);
+          distribution_leaf_map_index[distribution_index] = leaf_map_triangles_offset + i;
+        }
       }
     }
 
@@ -412,6 +504,18 @@ void LightManager::device_update_distribution(Device *,
     if (!light->is_enabled)
       continue;
 
+    if (use_light_tree) {
+      LightTreeEmitter emitter;
+      if (use_lamp_tree && light_tree_lamp_emitter(light, &emitter)) {
+        emitter.distribution_index = offset;
+        lamp_emitters.push_back(emitter);
+        distribution_leaf_map_index[offset] = light_index;
+      }
+      else {
+        other_lamps.push_back(offset);
+      }
+    }
+
     distribution[offset].totarea = totarea;
     distribution[offset].prim = ~light_index;
     distribution[offset].lamp.pad = 1.0f;
@@ -495,6 +599,41 @@ void LightManager::device_update_distribution(Device *,
     /* CDF */
     dscene->light_distribution.copy_to_device();
 
+    /* Light tree */
+    kintegrator->use_light_tree = use_light_tree;
+    if (use_light_tree) {
+      vector<KernelLightTreeNode> nodes;
+      kintegrator->light_tree_triangles_root = LightTree::build(triangle_emitters, nodes);
+      kintegrator->light_tree_lamps_root = LightTree::build(lamp_emitters, nodes);
+      kintegrator->light_tree_num_lamps = lamp_emitters.size();
+      VLOG(1) << "Light tree with " << nodes.size() << " nodes, " << triangle_emitters.size()
+              << " triangles and " << lamp_emitters.size() << " lamps.";
+
+      for (size_t i = 0; i < nodes.size(); i++) {
+        if (nodes[i].child < 0) {
+          leaf_map[distribution_leaf_map_index[~nodes[i].child]] = i;
+        }
+      }
+
+      kintegrator->light_tree_other_lamps_offset = leaf_map.size();
+      leaf_map.insert(leaf_map.end(), other_lamps.begin(), other_lamps.end());
+
+      KernelLightTreeNode *knodes = dscene->light_tree_nodes.alloc(
+          std::max<size_t>(nodes.size(), 1));
+      std::copy(nodes.begin(), nodes.end(), knodes);
+      int *kleaf_map = dscene->light_tree_leaf_map.alloc(leaf_map.size());
+      std::copy(leaf_map.begin(), leaf_map.end(), kleaf_map);
+
+      dscene->light_tree_nodes.copy_to_device();
+      dscene->light_tree_leaf_map.copy_to_device();
+    }
+    else {
+      kintegrator->light_tree_triangles_root = -1;
+      kintegrator->light_tree_lamps_root = -1;
+      kintegrator->light_tree_num_lamps = 0;
+      kintegrator->light_tree_other_lamps_offset = 0;
+    }
+
     /* Portals */
     if (num_portals > 0) {
       kbackground->portal_offset = light_index;
@@ -512,12 +651,15 @@ void LightManager::device_update_distribution(Device *,
   }
   else {
     dscene->light_distribution.free();
+    dscene->light_tree_nodes.free();
+    dscene->light_tree_leaf_map.free();
 
     kintegrator->num_distribution = 0;
     kintegrator->num_all_lights = 0;
     kintegrator->pdf_triangles = 0.0f;
     kintegrator->pdf_lights = 0.0f;
     kintegrator->use_lamp_mis = false;
+    kintegrator->use_light_tree = false;
 
     kbackground->num_portals = 0;
     kbackground->portal_offset = 0;
@@ -1007,6 +1149,8 @@ void LightManager::device_update(Device *device,
 void LightManager::device_free(Device *, DeviceScene *dscene, const bool free_background)
 {
   dscene->light_distribution.free();
+  dscene->light_tree_nodes.free();
+  dscene->light_tree_leaf_map.free();
   dscene->lights.free();
   if (free_background) {
     dscene->light_background_marginal_cdf.free();
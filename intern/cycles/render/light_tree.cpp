@@ -0,0 +1,279 @@
+/*
+ * Copyright 2011-2020 Blender Foundation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "render/light_tree.h"
+
+#include "util/util_algorithm.h"
+#include "util/util_math.h"
+
+CCL_NAMESPACE_BEGIN
+
+/* Number of buckets to evaluate splits with, per axis. */
+static const int LIGHT_TREE_NUM_BUCKETS = 12;
+/* Beyond this depth nodes are split in the middle, to bound the depth of the tree. */
+static const int LIGHT_TREE_MAX_SAOH_DEPTH = 48;
+
+/* Orientation Bounds */
+
+OrientationBounds OrientationBounds::empty()
+{
+  OrientationBounds bounds;
+  bounds.axis = make_float3(0.0f, 0.0f, 1.0f);
+  bounds.theta_o = -1.0f;
+  bounds.theta_e = 0.0f;
+  bounds.two_sided = false;
+  return bounds;
+}
+
+void OrientationBounds::grow(const OrientationBounds &other)
+{
+  if (other.is_empty()) {
+    return;
+  }
+  if (is_empty()) {
+    *this = other;
+    return;
+  }
+
+  OrientationBounds a = *this;
+  OrientationBounds b = other;
+  const bool use_two_sided = a.two_sided || b.two_sided;
+
+  /* Both directions are covered, use the one closest to the other axis. */
+  if (use_two_sided && dot(a.axis, b.axis) < 0.0f) {
+    b.axis = -b.axis;
+  }
+  if (a.theta_o < b.theta_o) {
+    swap(a, b);
+  }
+
+  two_sided = use_two_sided;
+  theta_e = max(a.theta_e, b.theta_e);
+
+  const float theta_d = precise_angle(a.axis, b.axis);
+  if (min(theta_d + b.theta_o, M_PI_F) <= a.theta_o) {
+    /* b is within a. */
+    axis = a.axis;
+    theta_o = a.theta_o;
+    return;
+  }
+
+  const float theta_o_merged = 0.5f * (a.theta_o + theta_d + b.theta_o);
+  const float3 rotation_axis = cross(a.axis, b.axis);
+  if (theta_o_merged >= M_PI_F || len_squared(rotation_axis) < 1e-12f) {
+    axis = a.axis;
+    theta_o = M_PI_F;
+    return;
+  }
+
+  /* Rotate the axis of a towards b, to the middle of the merged cone. */
+  axis = normalize(
+      rotate_around_axis(a.axis, normalize(rotation_axis), theta_o_merged - a.theta_o));
+  theta_o = theta_o_merged;
+}
+
+float OrientationBounds::measure() const
+{
+  const float theta_w = min(theta_o + theta_e, M_PI_F);
+  const float cos_theta_o = cosf(theta_o);
+  const float sin_theta_o = sinf(theta_o);
+  const float measure = M_2PI_F * (1.0f - cos_theta_o) +
+                        M_PI_2_F * (2.0f * theta_w * sin_theta_o - cosf(theta_o - 2.0f * theta_w) -
+                                    2.0f * theta_o * sin_theta_o + cos_theta_o);
+  return (two_sided) ? min(2.0f * measure, 4.0f * M_PI_F) : measure;
+}
+
+/* Light Tree */
+
+int LightTree::build(vector<LightTreeEmitter> &emitters, vector<KernelLightTreeNode> &nodes)
+{
+  if (emitters.empty()) {
+    return -1;
+  }
+  LightTree tree(emitters, nodes);
+  return tree.build_recursive(0, emitters.size(), -1, 0);
+}
+
+int LightTree::build_recursive(int begin, int end, int parent, int depth)
+{
+  BoundBox bounds = BoundBox::empty;
+  OrientationBounds orientation = OrientationBounds::empty();
+  float energy = 0.0f;
+  for (int i = begin; i < end; i++) {
+    bounds.grow(emitters[i].bounds);
+    orientation.grow(emitters[i].orientation);
+    energy += emitters[i].energy;
+  }
+
+  const int index = nodes.size();
+  nodes.push_back(KernelLightTreeNode());
+  {
+    KernelLightTreeNode &knode = nodes[index];
+    knode.bounds_min[0] = bounds.min.x;
+    knode.bounds_min[1] = bounds.min.y;
+    knode.bounds_min[2] = bounds.min.z;
+    knode.energy = energy;
+    knode.bounds_max[0] = bounds.max.x;
+    knode.bounds_max[1] = bounds.max.y;
+    knode.bounds_max[2] = bounds.max.z;
+    knode.theta_o = orientation.theta_o;
+    knode.axis[0] = orientation.axis.x;
+    knode.axis[1] = orientation.axis.y;
+    knode.axis[2] = orientation.axis.z;
+    knode.theta_e = orientation.theta_e;
+    knode.child = -1;
+    knode.parent = parent;
+    knode.two_sided = orientation.two_sided;
+    knode.area = 0.0f;
+
+    if (end - begin == 1) {
+      knode.child = ~emitters[begin].distribution_index;
+      knode.area = emitters[begin].area;
+      return index;
+    }
+  }
+
+  int middle = (depth < LIGHT_TREE_MAX_SAOH_DEPTH) ? split(begin, end, bounds, orientation) : -1;
+  if (middle <= begin || middle >= end) {
+    /* No useful split found, split in the middle along the largest axis. */
+    BoundBox centroid_bounds = BoundBox::empty;
+    for (int i = begin; i < end; i++) {
+      centroid_bounds.grow(emitters[i].centroid());
+    }
+    const float3 extent = centroid_bounds.size();
+    const int axis = (extent.x >= extent.y && extent.x >= extent.z) ? 0 :
+                     (extent.y >= extent.z)                         ? 1 :
+                                                                      2;
+    middle = (begin + end) / 2;
+    std::nth_element(emitters.begin() + begin,
+                     emitters.begin() + middle,
+                     emitters.begin() + end,
+                     [axis](const LightTreeEmitter &a, const LightTreeEmitter &b) {
+                       return a.centroid()[axis] < b.centroid()[axis];
+                     });
+  }
+
+  build_recursive(begin, middle, index, depth + 1);
+  const int right = build_recursive(middle, end, index, depth + 1);
+  nodes[index].child = right;
+
+  return index;
+}
+
+/* Find the split with the lowest surface area orientation heuristic, and partition the
+ * emitters accordingly. Returns the start of the second part, or -1 when no split was found. */
+int LightTree::split(int begin,
+                     int end,
+                     const BoundBox &bounds,
+                     const OrientationBounds &orientation)
+{
+  BoundBox centroid_bounds = BoundBox::empty;
+  for (int i = begin; i < end; i++) {
+    centroid_bounds.grow(emitters[i].centroid());
+  }
+  const float3 centroid_extent = centroid_bounds.size();
+  const float3 bounds_extent = bounds.size();
+  const float max_extent = max3(bounds_extent);
+  const float parent_cost = orientation.measure() * bounds.safe_area();
+
+  struct Bucket {
+    BoundBox bounds = BoundBox::empty;
+    OrientationBounds orientation = OrientationBounds::empty();
+    float energy = 0.0f;
+    int count = 0;
+  };
+
+  float best_cost = FLT_MAX;
+  int best_axis = -1;
+  int best_bucket = -1;
+
+  for (int axis = 0; axis < 3; axis++) {
+    if (centroid_extent[axis] == 0.0f) {
+      continue;
+    }
+    const float inv_extent = 1.0f / centroid_extent[axis];
+
+    Bucket buckets[LIGHT_TREE_NUM_BUCKETS];
+    for (int i = begin; i < end; i++) {
+      const LightTreeEmitter &emitter = emitters[i];
+      const int b = clamp(
+          (int)((emitter.centroid()[axis] - centroid_bounds.min[axis]) * inv_extent *
+                LIGHT_TREE_NUM_BUCKETS),
+          0,
+          LIGHT_TREE_NUM_BUCKETS - 1);
+      buckets[b].bounds.grow(emitter.bounds);
+      buckets[b].orientation.grow(emitter.orientation);
+      buckets[b].energy += emitter.energy;
+      buckets[b].count++;
+    }
+
+    /* Sweep from the right to accumulate the costs of the second parts. */
+    float right_cost[LIGHT_TREE_NUM_BUCKETS];
+    int right_count[LIGHT_TREE_NUM_BUCKETS];
+    Bucket right;
+    for (int b = LIGHT_TREE_NUM_BUCKETS - 1; b > 0; b--) {
+      right.bounds.grow(buckets[b].bounds);
+      right.orientation.grow(buckets[b].orientation);
+      right.energy += buckets[b].energy;
+      right.count += buckets[b].count;
+      right_cost[b] = right.energy * right.orientation.measure() * right.bounds.safe_area();
+      right_count[b] = right.count;
+    }
+
+    /* Penalize splitting thin boxes along their short axis. */
+    const float regularization = (bounds_extent[axis] > 0.0f) ? max_extent / bounds_extent[axis] :
+                                                                1.0f;
+
+    Bucket left;
+    for (int b = 1; b < LIGHT_TREE_NUM_BUCKETS; b++) {
+      left.bounds.grow(buckets[b - 1].bounds);
+      left.orientation.grow(buckets[b - 1].orientation);
+      left.energy += buckets[b - 1].energy;
+      left.count += buckets[b - 1].count;
+      if (left.count == 0 || right_count[b] == 0) {
+        continue;
+      }
+
+      const float left_cost = left.energy * left.orientation.measure() * left.bounds.safe_area();
+      const float cost = regularization * (left_cost + right_cost[b]) /
+                         max(parent_cost, FLT_MIN);
+      if (cost < best_cost) {
+        best_cost = cost;
+        best_axis = axis;
+        best_bucket = b;
+      }
+    }
+  }
+
+  if (best_axis == -1) {
+    return -1;
+  }
+
+  const float split_min = centroid_bounds.min[best_axis];
+  const float inv_extent = 1.0f / centroid_extent[best_axis];
+  const auto middle = std::partition(
+      emitters.begin() + begin, emitters.begin() + end, [&](const LightTreeEmitter &emitter) {
+        const int b = clamp((int)((emitter.centroid()[best_axis] - split_min) * inv_extent *
+                                  LIGHT_TREE_NUM_BUCKETS),
+                            0,
+                            LIGHT_TREE_NUM_BUCKETS - 1);
+        return b < best_bucket;
+      });
+
+  return middle - emitters.begin();
+}
+
+CCL_NAMESPACE_END
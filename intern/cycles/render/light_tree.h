@@ -0,0 +1,97 @@
+/*
+ * Copyright 2011-2020 Blender Foundation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef __LIGHT_TREE_H__
+#define __LIGHT_TREE_H__
+
+#include "kernel/kernel_types.h"
+
+#include "util/util_boundbox.h"
+#include "util/util_types.h"
+#include "util/util_vector.h"
+
+CCL_NAMESPACE_BEGIN
+
+/* Bounds of the directions light is emitted in, as a cone of normals around an axis (theta_o)
+ * and the spread of emission around these normals (theta_e).
+ *
+ * Based on "Importance Sampling of Many Lights with Adaptive Tree Splitting",
+ * Conty Estevez and Kulla, 2018. */
+
+struct OrientationBounds {
+  float3 axis;
+  float theta_o;
+  float theta_e;
+  /* Also emits along the opposite of the normals, as mesh lights do. */
+  bool two_sided;
+
+  static OrientationBounds empty();
+
+  bool is_empty() const
+  {
+    return theta_o < 0.0f;
+  }
+
+  void grow(const OrientationBounds &other);
+
+  /* Solid angle measure of the bounds, for the cost of splits. */
+  float measure() const;
+};
+
+/* Emitter to insert in the tree. */
+
+struct LightTreeEmitter {
+  BoundBox bounds;
+  OrientationBounds orientation;
+  float energy;
+  /* Area of triangle emitters, zero for lamps. */
+  float area;
+  /* Index in the light distribution. */
+  int distribution_index;
+
+  float3 centroid() const
+  {
+    return 0.5f * (bounds.min + bounds.max);
+  }
+};
+
+/* BVH over emitters, built with the surface area orientation heuristic (SAOH).
+ *
+ * Nodes are stored depth first so that the first child of a node directly follows it,
+ * several trees can be appended to the same nodes array. */
+
+class LightTree {
+ public:
+  /* Build a tree over the emitters, which are reordered, and append it to nodes.
+   * Returns the index of the root node, or -1 when there are no emitters. */
+  static int build(vector<LightTreeEmitter> &emitters, vector<KernelLightTreeNode> &nodes);
+
+ protected:
+  LightTree(vector<LightTreeEmitter> &emitters, vector<KernelLightTreeNode> &nodes)
+      : emitters(emitters), nodes(nodes)
+  {
+  }
+
+  int build_recursive(int begin, int end, int parent, int depth);
+  int split(int begin, int end, const BoundBox &bounds, const OrientationBounds &orientation);
+
+  vector<LightTreeEmitter> &emitters;
+  vector<KernelLightTreeNode> &nodes;
+};
+
+CCL_NAMESPACE_END
+
+#endif /* __LIGHT_TREE_H__ */
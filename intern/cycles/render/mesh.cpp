@@ -210,6 +210,7 @@ Mesh::~Mesh()
 {
   delete patch_table;
   delete subd_params;
+  delete subd_patch_cache;
 }
 
 void Mesh::resize_mesh(int numverts, int numtris)
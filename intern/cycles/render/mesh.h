@@ -47,6 +47,7 @@ class SceneParams;
 class AttributeRequest;
 struct SubdParams;
 class DiagSplit;
+class DicedPatchCache;
 struct PackedPatchTable;
 
 /* Mesh */
@@ -193,6 +194,8 @@ class Mesh : public Geometry {
   friend class ObjectManager;
 
   SubdParams *subd_params = nullptr;
+  /* Vertices of the previous tessellation, kept across syncs of the mesh. */
+  DicedPatchCache *subd_patch_cache = nullptr;
 
  public:
   /* Functions */
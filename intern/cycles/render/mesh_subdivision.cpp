@@ -25,6 +25,7 @@
 #include "util/util_algorithm.h"
 #include "util/util_foreach.h"
 #include "util/util_hash.h"
+#include "util/util_murmurhash.h"
 
 CCL_NAMESPACE_BEGIN
 
@@ -369,12 +370,46 @@ struct OsdPatch : Patch {
 
 #endif
 
+template<typename T> static uint hash_array(const array<T> &data, uint seed)
+{
+  return util_murmur_hash3(data.data(), data.size() * sizeof(T), seed);
+}
+
+/* Hash of the control mesh, which the evaluation of patches depends on. */
+static uint subd_control_mesh_hash(Mesh *mesh)
+{
+  const int subdivision_type = mesh->get_subdivision_type();
+  uint hash = util_murmur_hash3(&subdivision_type, sizeof(subdivision_type), 0);
+
+  hash = hash_array(mesh->get_verts(), hash);
+  hash = hash_array(mesh->get_subd_face_corners(), hash);
+  hash = hash_array(mesh->get_subd_start_corner(), hash);
+  hash = hash_array(mesh->get_subd_num_corners(), hash);
+  hash = hash_array(mesh->get_subd_smooth(), hash);
+  hash = hash_array(mesh->get_subd_creases_edge(), hash);
+  hash = hash_array(mesh->get_subd_creases_weight(), hash);
+
+  Attribute *attr_vN = mesh->subd_attributes.find(ATTR_STD_VERTEX_NORMAL);
+  if (attr_vN) {
+    hash = util_murmur_hash3(attr_vN->data(), attr_vN->buffer.size(), hash);
+  }
+
+  return hash;
+}
+
 void Mesh::tessellate(DiagSplit *split)
 {
   /* reset the number of subdivision vertices, in case the Mesh was not cleared
    * between calls or data updates */
   num_subd_verts = 0;
 
+  /* Diced patches of the previous tessellation can be reused as long as the control mesh
+   * is the same. */
+  if (!subd_patch_cache) {
+    subd_patch_cache = new DicedPatchCache();
+  }
+  subd_patch_cache->validate(subd_control_mesh_hash(this));
+
 #ifdef WITH_OPENSUBDIV
   OsdData osd_data;
   bool need_packed_patch_table = false;
@@ -31,6 +31,7 @@
 
 #include "util/util_foreach.h"
 #include "util/util_logging.h"
+#include "util/util_md5.h"
 #include "util/util_transform.h"
 
 #include "kernel/svm/svm_color_util.h"
@@ -206,6 +207,24 @@ void TextureMapping::compile(OSLCompiler &compiler)
   }
 }
 
+/* Image Slot Texture */
+
+/* Empty handles are acquired on compile and follow from the socket values, while handles
+ * assigned on sync identify a builtin image that the sockets do not describe. */
+static void image_handle_hash(ImageHandle &handle, MD5Hash &md5)
+{
+  for (int i = 0; i < handle.num_tiles(); i++) {
+    const int slot = handle.svm_slot(i);
+    md5.append((uint8_t *)&slot, sizeof(slot));
+  }
+}
+
+void ImageSlotTextureNode::hash(MD5Hash &md5)
+{
+  TextureNode::hash(md5);
+  image_handle_hash(handle, md5);
+}
+
 /* Image Texture */
 
 NODE_DEFINE(ImageTextureNode)
@@ -252,6 +271,13 @@ NODE_DEFINE(ImageTextureNode)
 
   SOCKET_IN_POINT(vector, "Vector", make_float3(0.0f, 0.0f, 0.0f), SocketType::LINK_TEXTURE_UV);
 
+  /* These inputs are only connected by the graph transform for texture cache lookups, to
+   * the vector evaluated at positions offset by the ray differentials. */
+  SOCKET_IN_POINT(
+      vector_dx, "VectorDX", make_float3(0.0f, 0.0f, 0.0f), SocketType::SVM_INTERNAL);
+  SOCKET_IN_POINT(
+      vector_dy, "VectorDY", make_float3(0.0f, 0.0f, 0.0f), SocketType::SVM_INTERNAL);
+
   SOCKET_OUT_COLOR(color, "Color");
   SOCKET_OUT_FLOAT(alpha, "Alpha");
 
@@ -283,6 +309,18 @@ ImageParams ImageTextureNode::image_params() const
   return params;
 }
 
+/* The image is added on compile, before that it is added here in the same way to find out
+ * whether it is read through the texture cache. */
+bool ImageTextureNode::uses_texture_cache(Scene *scene, ShaderGraph *graph)
+{
+  if (handle.empty()) {
+    cull_tiles(scene, graph);
+    handle = scene->image_manager->add_image(filename.string(), image_params(), tiles);
+  }
+
+  return handle.uses_texture_cache();
+}
+
 void ImageTextureNode::cull_tiles(Scene *scene, ShaderGraph *graph)
 {
   /* Box projection computes its own UVs that always lie in the
@@ -363,6 +401,8 @@ void ImageTextureNode::attributes(Shader *shader, AttributeRequestSet *attribute
 void ImageTextureNode::compile(SVMCompiler &compiler)
 {
   ShaderInput *vector_in = input("Vector");
+  ShaderInput *vector_dx_in = input("VectorDX");
+  ShaderInput *vector_dy_in = input("VectorDY");
   ShaderOutput *color_out = output("Color");
   ShaderOutput *alpha_out = output("Alpha");
 
@@ -393,6 +433,14 @@ void ImageTextureNode::compile(SVMCompiler &compiler)
     }
   }
 
+  const bool use_derivatives = vector_dx_in->link && vector_dy_in->link;
+  int vector_dx_offset = SVM_STACK_INVALID;
+  int vector_dy_offset = SVM_STACK_INVALID;
+  if (use_derivatives) {
+    vector_dx_offset = tex_mapping.compile_begin(compiler, vector_dx_in);
+    vector_dy_offset = tex_mapping.compile_begin(compiler, vector_dy_in);
+  }
+
   if (projection != NODE_IMAGE_PROJ_BOX) {
     /* If there only is one image (a very common case), we encode it as a negative value. */
     int num_nodes;
@@ -409,7 +457,7 @@ void ImageTextureNode::compile(SVMCompiler &compiler)
                                              compiler.stack_assign_if_linked(color_out),
                                              compiler.stack_assign_if_linked(alpha_out),
                                              flags),
-                      projection);
+                      compiler.encode_uchar4(projection, vector_dx_offset, vector_dy_offset));
 
     if (num_nodes > 0) {
       for (int i = 0; i < num_nodes; i++) {
@@ -439,6 +487,10 @@ void ImageTextureNode::compile(SVMCompiler &compiler)
                       __float_as_int(projection_blend));
   }
 
+  if (use_derivatives) {
+    tex_mapping.compile_end(compiler, vector_dx_in, vector_dx_offset);
+    tex_mapping.compile_end(compiler, vector_dy_in, vector_dy_offset);
+  }
   tex_mapping.compile_end(compiler, vector_in, vector_offset);
 }
 
@@ -823,6 +875,12 @@ SkyTextureNode::SkyTextureNode() : TextureNode(node_type)
 {
 }
 
+void SkyTextureNode::hash(MD5Hash &md5)
+{
+  TextureNode::hash(md5);
+  image_handle_hash(handle, md5);
+}
+
 void SkyTextureNode::compile(SVMCompiler &compiler)
 {
   ShaderInput *vector_in = input("Vector");
@@ -1788,6 +1846,12 @@ PointDensityTextureNode::~PointDensityTextureNode()
 {
 }
 
+void PointDensityTextureNode::hash(MD5Hash &md5)
+{
+  ShaderNode::hash(md5);
+  image_handle_hash(handle, md5);
+}
+
 ShaderNode *PointDensityTextureNode::clone(ShaderGraph *graph) const
 {
   /* Increase image user count for new node. We need to ensure to not call
@@ -5957,6 +6021,12 @@ void OutputAOVNode::simplify_settings(Scene *scene)
   }
 }
 
+void OutputAOVNode::hash(MD5Hash &md5)
+{
+  ShaderNode::hash(md5);
+  md5.append((uint8_t *)&slot, sizeof(slot));
+}
+
 void OutputAOVNode::compile(SVMCompiler &compiler)
 {
   assert(slot >= 0);
@@ -97,6 +97,8 @@ class ImageSlotTextureNode : public TextureNode {
     return TextureNode::equals(other) && handle == other_node.handle;
   }
 
+  virtual void hash(MD5Hash &md5);
+
   ImageHandle handle;
 };
 
@@ -117,6 +119,7 @@ class ImageTextureNode : public ImageSlotTextureNode {
   }
 
   ImageParams image_params() const;
+  bool uses_texture_cache(Scene *scene, ShaderGraph *graph);
 
   /* Parameters. */
   NODE_SOCKET_API(ustring, filename)
@@ -128,6 +131,8 @@ class ImageTextureNode : public ImageSlotTextureNode {
   NODE_SOCKET_API(float, projection_blend)
   NODE_SOCKET_API(bool, animated)
   NODE_SOCKET_API(float3, vector)
+  NODE_SOCKET_API(float3, vector_dx)
+  NODE_SOCKET_API(float3, vector_dy)
   NODE_SOCKET_API(array<int>, tiles)
 
  protected:
@@ -191,6 +196,8 @@ class SkyTextureNode : public TextureNode {
   NODE_SOCKET_API(float3, vector)
   ImageHandle handle;
 
+  virtual void hash(MD5Hash &md5);
+
   float get_sun_size()
   {
     /* Clamping for numerical precision. */
@@ -235,6 +242,8 @@ class OutputAOVNode : public ShaderNode {
     return false;
   }
 
+  virtual void hash(MD5Hash &md5);
+
   int slot;
   bool is_color;
 };
@@ -435,6 +444,8 @@ class PointDensityTextureNode : public ShaderNode {
     const PointDensityTextureNode &other_node = (const PointDensityTextureNode &)other;
     return ShaderNode::equals(other) && handle == other_node.handle;
   }
+
+  virtual void hash(MD5Hash &md5);
 };
 
 class IESLightNode : public TextureNode {
@@ -77,6 +77,8 @@ DeviceScene::DeviceScene(Device *device)
       lights(device, "__lights", MEM_GLOBAL),
       light_background_marginal_cdf(device, "__light_background_marginal_cdf", MEM_GLOBAL),
       light_background_conditional_cdf(device, "__light_background_conditional_cdf", MEM_GLOBAL),
+      light_tree_nodes(device, "__light_tree_nodes", MEM_GLOBAL),
+      light_tree_leaf_map(device, "__light_tree_leaf_map", MEM_GLOBAL),
       particles(device, "__particles", MEM_GLOBAL),
       svm_nodes(device, "__svm_nodes", MEM_GLOBAL),
       shaders(device, "__shaders", MEM_GLOBAL),
@@ -128,6 +130,11 @@ Scene::Scene(const SceneParams &params_, Device *device)
     shader_manager = ShaderManager::create(SHADINGSYSTEM_SVM);
 
   shader_manager->add_default(this);
+
+  /* Lookups from the kernel are only possible on the CPU, and OSL has its own texture system. */
+  if (params.use_texture_cache && device->info.type == DEVICE_CPU && !shader_manager->use_osl()) {
+    image_manager->enable_texture_cache(params.texture_cache_size, params.texture_limit);
+  }
 }
 
 Scene::~Scene()
@@ -164,7 +171,7 @@ void Scene::free_memory(bool final)
     integrator->device_free(device, &dscene);
 
     object_manager->device_free(device, &dscene);
-    geometry_manager->device_free(device, &dscene);
+    geometry_manager->device_free(device, &dscene, true);
     shader_manager->device_free(device, &dscene, this);
     light_manager->device_free(device, &dscene);
 
@@ -629,6 +629,8 @@ void Session::map_neighbor_tiles(RenderTileNeighbors &neighbors, Device *tile_de
 {
   thread_scoped_lock tile_lock(tile_mutex);
 
+  progress.begin_denoise_tile();
+
   const int4 image_region = make_int4(
       tile_manager.state.buffer.full_x,
       tile_manager.state.buffer.full_y,
@@ -706,6 +708,8 @@ void Session::unmap_neighbor_tiles(RenderTileNeighbors &neighbors, Device *tile_
 {
   thread_scoped_lock tile_lock(tile_mutex);
   device->unmap_neighbor_tiles(tile_device, neighbors);
+
+  progress.end_denoise_tile();
 }
 
 void Session::run_cpu()
@@ -51,6 +51,12 @@ bool namedSampleCountPairComparator(const NamedSampleCountPair &a, const NamedSa
   return a.samples > b.samples;
 }
 
+/* Profiling samples are taken every millisecond. */
+double profiling_seconds(uint64_t samples)
+{
+  return samples * 0.001;
+}
+
 }  // namespace
 
 NamedSizeEntry::NamedSizeEntry() : name(""), size(0)
@@ -152,9 +158,9 @@ string NamedNestedSampleStats::full_report(int indent_level, uint64_t total_samp
   const string indent(indent_level * kIndentNumSpaces, ' ');
 
   const double sum_percent = 100 * ((double)sum_samples) / total_samples;
-  const double sum_seconds = sum_samples * 0.001;
+  const double sum_seconds = profiling_seconds(sum_samples);
   const double self_percent = 100 * ((double)self_samples) / total_samples;
-  const double self_seconds = self_samples * 0.001;
+  const double self_seconds = profiling_seconds(self_samples);
   string info = string_printf("%-32s: Total %3.2f%% (%.2fs), Self %3.2f%% (%.2fs)\n",
                               name.c_str(),
                               sum_percent,
@@ -170,6 +176,30 @@ string NamedNestedSampleStats::full_report(int indent_level, uint64_t total_samp
   return result;
 }
 
+string NamedNestedSampleStats::json_report(int indent_level)
+{
+  update_sum();
+
+  const string indent(indent_level * kIndentNumSpaces, ' ');
+  const string entry_indent((indent_level + 1) * kIndentNumSpaces, ' ');
+
+  string result = "{\n";
+  result += entry_indent + "\"name\": " + string_json_quote(name) + ",\n";
+  result += entry_indent + string_printf("\"time\": %f,\n", profiling_seconds(sum_samples));
+  result += entry_indent +
+            string_printf("\"self_time\": %f,\n", profiling_seconds(self_samples));
+  result += entry_indent + "\"entries\": [";
+
+  sort(entries.begin(), entries.end(), namedTimeSampleEntryComparator);
+  for (size_t i = 0; i < entries.size(); i++) {
+    result += (i == 0) ? "\n" : ",\n";
+    result += string((indent_level + 2) * kIndentNumSpaces, ' ');
+    result += entries[i].json_report(indent_level + 2);
+  }
+  result += entries.empty() ? "]\n" : "\n" + entry_indent + "]\n";
+  return result + indent + "}";
+}
+
 /* Named sample count pairs. */
 
 NamedSampleCountPair::NamedSampleCountPair(const ustring &name, uint64_t samples, uint64_t hits)
@@ -192,15 +222,15 @@ void NamedSampleCountStats::add(const ustring &name, uint64_t samples, uint64_t
   entries.emplace(name, NamedSampleCountPair(name, samples, hits));
 }
 
-string NamedSampleCountStats::full_report(int indent_level)
+/* Entries sorted by time, and the average number of samples per hit over all entries. */
+static vector<NamedSampleCountPair> sorted_sample_count_entries(
+    const NamedSampleCountStats::entry_map &entries, double &avg_samples_per_hit)
 {
-  const string indent(indent_level * kIndentNumSpaces, ' ');
-
   vector<NamedSampleCountPair> sorted_entries;
   sorted_entries.reserve(entries.size());
 
   uint64_t total_hits = 0, total_samples = 0;
-  foreach (entry_map::const_reference entry, entries) {
+  foreach (NamedSampleCountStats::entry_map::const_reference entry, entries) {
     const NamedSampleCountPair &pair = entry.second;
 
     total_hits += pair.hits;
@@ -208,13 +238,23 @@ string NamedSampleCountStats::full_report(int indent_level)
 
     sorted_entries.push_back(pair);
   }
-  const double avg_samples_per_hit = ((double)total_samples) / total_hits;
+  avg_samples_per_hit = ((double)total_samples) / total_hits;
 
   sort(sorted_entries.begin(), sorted_entries.end(), namedSampleCountPairComparator);
+  return sorted_entries;
+}
+
+string NamedSampleCountStats::full_report(int indent_level)
+{
+  const string indent(indent_level * kIndentNumSpaces, ' ');
+
+  double avg_samples_per_hit;
+  const vector<NamedSampleCountPair> sorted_entries = sorted_sample_count_entries(
+      entries, avg_samples_per_hit);
 
   string result = "";
   foreach (const NamedSampleCountPair &entry, sorted_entries) {
-    const double seconds = entry.samples * 0.001;
+    const double seconds = profiling_seconds(entry.samples);
     const double relative = ((double)entry.samples) / (entry.hits * avg_samples_per_hit);
 
     result += indent +
@@ -224,6 +264,33 @@ string NamedSampleCountStats::full_report(int indent_level)
   return result;
 }
 
+string NamedSampleCountStats::json_report(int indent_level)
+{
+  const string indent(indent_level * kIndentNumSpaces, ' ');
+  const string entry_indent((indent_level + 1) * kIndentNumSpaces, ' ');
+
+  double avg_samples_per_hit;
+  const vector<NamedSampleCountPair> sorted_entries = sorted_sample_count_entries(
+      entries, avg_samples_per_hit);
+
+  string result = "[";
+  for (size_t i = 0; i < sorted_entries.size(); i++) {
+    const NamedSampleCountPair &entry = sorted_entries[i];
+    /* Entries without hits would give an infinite cost, which is not valid JSON. */
+    const double relative = (entry.hits) ? ((double)entry.samples) /
+                                               (entry.hits * avg_samples_per_hit) :
+                                           0.0;
+
+    result += (i == 0) ? "\n" : ",\n";
+    result += entry_indent + "{\"name\": " + string_json_quote(entry.name.string());
+    result += string_printf(", \"time\": %f, \"hits\": %llu, \"relative_cost\": %f}",
+                            profiling_seconds(entry.samples),
+                            (unsigned long long)entry.hits,
+                            relative);
+  }
+  return result + (sorted_entries.empty() ? "]" : "\n" + indent + "]");
+}
+
 /* Mesh statistics. */
 
 MeshStats::MeshStats()
@@ -238,6 +305,44 @@ string MeshStats::full_report(int indent_level)
   return result;
 }
 
+/* Texture cache statistics. */
+
+TextureCacheStats::TextureCacheStats()
+    : used(false),
+      memory_limit(0),
+      memory_used(0),
+      bytes_read(0),
+      num_files(0),
+      file_io_time(0.0),
+      tile_lookups(0),
+      microcache_misses(0),
+      cache_misses(0)
+{
+}
+
+string TextureCacheStats::full_report(int indent_level)
+{
+  const string indent(indent_level * kIndentNumSpaces, ' ');
+  const double hit_rate = (tile_lookups) ? 1.0 - ((double)cache_misses) / tile_lookups : 1.0;
+  string result = "";
+  result += string_printf("%sMemory used: %s of %s\n",
+                          indent.c_str(),
+                          string_human_readable_size(memory_used).c_str(),
+                          string_human_readable_size(memory_limit).c_str());
+  result += string_printf("%sFiles: %d, read %s in %fs\n",
+                          indent.c_str(),
+                          num_files,
+                          string_human_readable_size(bytes_read).c_str(),
+                          file_io_time);
+  result += string_printf("%sTile lookups: %s, micro cache misses: %s, cache misses: %s\n",
+                          indent.c_str(),
+                          string_human_readable_number(tile_lookups).c_str(),
+                          string_human_readable_number(microcache_misses).c_str(),
+                          string_human_readable_number(cache_misses).c_str());
+  result += string_printf("%sHit rate: %.2f%%\n", indent.c_str(), 100.0 * hit_rate);
+  return result;
+}
+
 /* Image statistics. */
 
 ImageStats::ImageStats()
@@ -249,6 +354,9 @@ string ImageStats::full_report(int indent_level)
   const string indent(indent_level * kIndentNumSpaces, ' ');
   string result = "";
   result += indent + "Textures:\n" + textures.full_report(indent_level + 1);
+  if (texture_cache.used) {
+    result += indent + "Texture Cache:\n" + texture_cache.full_report(indent_level + 1);
+  }
   return result;
 }
 
@@ -345,6 +453,19 @@ string RenderStats::full_report()
   return result;
 }
 
+string RenderStats::profiling_json_report()
+{
+  if (!has_profiling) {
+    return "";
+  }
+
+  string result = "{\n";
+  result += "  \"kernel\": " + kernel.json_report(1) + ",\n";
+  result += "  \"shaders\": " + shaders.json_report(1) + ",\n";
+  result += "  \"objects\": " + objects.json_report(1) + "\n";
+  return result + "}\n";
+}
+
 NamedTimeStats::NamedTimeStats() : total_time(0.0)
 {
 }
@@ -114,6 +114,9 @@ class NamedNestedSampleStats {
 
   string full_report(int indent_level = 0, uint64_t total_samples = 0);
 
+  /* Generate report as JSON object, with times in seconds. */
+  string json_report(int indent_level = 0);
+
   string name;
 
   /* self_samples contains only the samples that this specific event got,
@@ -141,6 +144,10 @@ class NamedSampleCountStats {
   NamedSampleCountStats();
 
   string full_report(int indent_level = 0);
+
+  /* Generate report as JSON array of entries sorted by time, with times in seconds. */
+  string json_report(int indent_level = 0);
+
   void add(const ustring &name, uint64_t samples, uint64_t hits);
 
   typedef unordered_map<ustring, NamedSampleCountPair, ustringHash> entry_map;
@@ -163,6 +170,29 @@ class MeshStats {
 };
 
 /* Statistics about images held in memory. */
+/* Statistics of images read on demand through the texture cache. */
+class TextureCacheStats {
+ public:
+  TextureCacheStats();
+
+  /* Generate full human-readable report. */
+  string full_report(int indent_level = 0);
+
+  bool used;
+
+  size_t memory_limit;
+  size_t memory_used;
+  size_t bytes_read;
+  int num_files;
+  double file_io_time;
+
+  /* Tile lookups, and how many of them missed the per-thread micro cache of recently used
+   * tiles, or the whole cache and had to read the tile from disk. */
+  uint64_t tile_lookups;
+  uint64_t microcache_misses;
+  uint64_t cache_misses;
+};
+
 class ImageStats {
  public:
   ImageStats();
@@ -171,6 +201,7 @@ class ImageStats {
   string full_report(int indent_level = 0);
 
   NamedSizeStats textures;
+  TextureCacheStats texture_cache;
 };
 
 /* Render process statistics. */
@@ -181,6 +212,9 @@ class RenderStats {
   /* Return full report as string. */
   string full_report();
 
+  /* Return kernel, shader and object profiling as JSON, empty if there is no profiling. */
+  string profiling_json_report();
+
   /* Collect kernel sampling information from Stats. */
   void collect_profiling(Scene *scene, Profiler &prof);
 
@@ -45,30 +45,128 @@ SVMShaderManager::~SVMShaderManager()
 
 void SVMShaderManager::reset(Scene * /*scene*/)
 {
+  programs.clear();
+}
+
+string SVMShaderManager::program_key(Scene *scene, Shader *shader)
+{
+  /* Unused shaders compile to an empty program, which must not be shared with used ones. */
+  const bool background = (shader == scene->background->get_shader(scene));
+  return shader->graph->finalized_hash + string_printf(":%d:%d:%d",
+                                                       (int)shader->used,
+                                                       (int)background,
+                                                       (int)shader->get_displacement_method());
+}
+
+/* Image handles held by nodes, in graph order. */
+static vector<ImageHandle *> graph_image_handles(ShaderGraph *graph)
+{
+  vector<ImageHandle *> handles;
+
+  foreach (ShaderNode *node, graph->nodes) {
+    if (node->special_type == SHADER_SPECIAL_TYPE_IMAGE_SLOT) {
+      handles.push_back(&static_cast<ImageSlotTextureNode *>(node)->handle);
+    }
+    else if (node->type == SkyTextureNode::node_type) {
+      handles.push_back(&static_cast<SkyTextureNode *>(node)->handle);
+    }
+    else if (node->type == PointDensityTextureNode::node_type) {
+      handles.push_back(&static_cast<PointDensityTextureNode *>(node)->handle);
+    }
+  }
+
+  return handles;
+}
+
+void SVMShaderManager::device_update_finalize(Scene *scene, Shader *shader, Progress *progress)
+{
+  if (progress->get_cancel()) {
+    return;
+  }
+  assert(shader->graph);
+
+  /* A finalized graph only changes again when simplified for the integrator settings. */
+  ShaderGraph *graph = shader->graph;
+  if (graph->finalized_hash.empty() || shader->has_integrator_dependency) {
+    SVMCompiler compiler(scene);
+    compiler.finalize(shader);
+    graph->compute_finalized_hash();
+  }
 }
 
 void SVMShaderManager::device_update_shader(Scene *scene,
                                             Shader *shader,
                                             Progress *progress,
-                                            array<int4> *svm_nodes)
+                                            Program *program)
 {
   if (progress->get_cancel()) {
     return;
   }
   assert(shader->graph);
 
-  svm_nodes->push_back_slow(make_int4(NODE_SHADER_JUMP, 0, 0, 0));
+  array<int4> &svm_nodes = program->svm_nodes;
+  svm_nodes.push_back_slow(make_int4(NODE_SHADER_JUMP, 0, 0, 0));
 
   SVMCompiler::Summary summary;
   SVMCompiler compiler(scene);
   compiler.background = (shader == scene->background->get_shader(scene));
-  compiler.compile(shader, *svm_nodes, 0, &summary);
+  compiler.compile(shader, svm_nodes, 0, &summary);
+
+  program->images.clear();
+  foreach (ImageHandle *handle, graph_image_handles(shader->graph)) {
+    program->images.push_back(*handle);
+  }
+
+  program->has_surface = shader->has_surface;
+  program->has_surface_emission = shader->has_surface_emission;
+  program->has_surface_transparent = shader->has_surface_transparent;
+  program->has_surface_bssrdf = shader->has_surface_bssrdf;
+  program->has_bump = shader->has_bump;
+  program->has_bssrdf_bump = shader->has_bssrdf_bump;
+  program->has_volume = shader->has_volume;
+  program->has_displacement = shader->has_displacement;
+  program->has_surface_spatial_varying = shader->has_surface_spatial_varying;
+  program->has_volume_spatial_varying = shader->has_volume_spatial_varying;
+  program->has_volume_attribute_dependency = shader->has_volume_attribute_dependency;
+  program->has_integrator_dependency = shader->has_integrator_dependency;
 
   VLOG(2) << "Compilation summary:\n"
           << "Shader name: " << shader->name << "\n"
           << summary.full_report();
 }
 
+void SVMShaderManager::device_update_program(Shader *shader, Program &program, bool compiled)
+{
+  if (compiled) {
+    return;
+  }
+
+  /* The shader shares a program compiled for another shader, or in a previous update. Give
+   * its nodes the images of the program, so they are found by displacement and kept alive
+   * for as long as the shader uses them. */
+  vector<ImageHandle *> handles = graph_image_handles(shader->graph);
+  assert(handles.size() == program.images.size());
+
+  for (size_t i = 0; i < handles.size() && i < program.images.size(); i++) {
+    if (handles[i]->empty()) {
+      *handles[i] = program.images[i];
+    }
+  }
+
+  shader->has_surface = program.has_surface;
+  shader->has_surface_emission = program.has_surface_emission;
+  shader->has_surface_transparent = program.has_surface_transparent;
+  shader->has_surface_bssrdf = program.has_surface_bssrdf;
+  shader->has_bump = program.has_bump;
+  shader->has_bssrdf_bump = program.has_bssrdf_bump;
+  shader->has_volume = program.has_volume;
+  shader->has_displacement = program.has_displacement;
+  shader->has_surface_spatial_varying = program.has_surface_spatial_varying;
+  shader->has_volume_spatial_varying = program.has_volume_spatial_varying;
+  shader->has_volume_attribute_dependency = program.has_volume_attribute_dependency;
+  shader->has_integrator_dependency = program.has_integrator_dependency;
+}
+
 void SVMShaderManager::device_update(Device *device,
                                      DeviceScene *dscene,
                                      Scene *scene,
@@ -90,18 +188,18 @@ void SVMShaderManager::device_update(Device *device,
   double start_time = time_dt();
 
   /* test if we need to update */
-  device_free(device, dscene, scene);
+  device_free_common(device, dscene, scene);
+  dscene->svm_nodes.free();
 
-  /* Build all shaders. */
+  /* Finalize all graphs, so that their hash includes constant folding and
+   * other simplifications. */
   TaskPool task_pool;
-  vector<array<int4>> shader_svm_nodes(num_shaders);
   for (int i = 0; i < num_shaders; i++) {
-    task_pool.push(function_bind(&SVMShaderManager::device_update_shader,
+    task_pool.push(function_bind(&SVMShaderManager::device_update_finalize,
                                  this,
                                  scene,
                                  scene->shaders[i],
-                                 &progress,
-                                 &shader_svm_nodes[i]));
+                                 &progress));
   }
   task_pool.wait_work();
 
@@ -109,19 +207,91 @@ void SVMShaderManager::device_update(Device *device,
     return;
   }
 
+  /* Look up the program of each shader. Only the first shader with a graph
+   * that has no program yet is compiled, others with the same graph share it.
+   * Graphs without hash are compiled for every shader. */
+  map<string, Program> shader_programs;
+  vector<Program> unique_programs;
+  vector<Program *> programs_used(num_shaders, NULL);
+  vector<bool> compiled(num_shaders, false);
+  int num_compiled = 0;
+
+  for (int i = 0; i < num_shaders; i++) {
+    if (scene->shaders[i]->graph->finalized_hash.empty()) {
+      compiled[i] = true;
+      num_compiled++;
+      continue;
+    }
+
+    const string key = program_key(scene, scene->shaders[i]);
+    if (shader_programs.find(key) != shader_programs.end()) {
+      continue;
+    }
+
+    Program &program = shader_programs[key];
+    map<string, Program>::iterator it = programs.find(key);
+    if (it != programs.end()) {
+      program = it->second;
+    }
+    else {
+      compiled[i] = true;
+      num_compiled++;
+    }
+  }
+
+  unique_programs.resize(num_shaders);
+  for (int i = 0; i < num_shaders; i++) {
+    if (scene->shaders[i]->graph->finalized_hash.empty()) {
+      programs_used[i] = &unique_programs[i];
+    }
+    else {
+      programs_used[i] = &shader_programs[program_key(scene, scene->shaders[i])];
+    }
+  }
+
+  /* Build the shaders that need compiling. */
+  for (int i = 0; i < num_shaders; i++) {
+    if (compiled[i]) {
+      task_pool.push(function_bind(&SVMShaderManager::device_update_shader,
+                                   this,
+                                   scene,
+                                   scene->shaders[i],
+                                   &progress,
+                                   programs_used[i]));
+    }
+  }
+  task_pool.wait_work();
+
+  if (progress.get_cancel()) {
+    return;
+  }
+
+  /* Keep the programs of this update only, releasing their images once no
+   * shader uses them anymore. */
+  programs.swap(shader_programs);
+
   /* The global node list contains a jump table (one node per shader)
-   * followed by the nodes of all shaders. */
+   * followed by the nodes of all programs, each stored once. */
+  map<Program *, int> program_offsets;
+  vector<Program *> programs_order;
   int svm_nodes_size = num_shaders;
   for (int i = 0; i < num_shaders; i++) {
-    /* Since we're not copying the local jump node, the size ends up being one node lower. */
-    svm_nodes_size += shader_svm_nodes[i].size() - 1;
+    Program *program = programs_used[i];
+    if (program_offsets.find(program) == program_offsets.end()) {
+      program_offsets[program] = svm_nodes_size;
+      programs_order.push_back(program);
+      /* Since we're not copying the local jump node, the size ends up being one node lower. */
+      svm_nodes_size += program->svm_nodes.size() - 1;
+    }
   }
 
   int4 *svm_nodes = dscene->svm_nodes.alloc(svm_nodes_size);
 
-  int node_offset = num_shaders;
   for (int i = 0; i < num_shaders; i++) {
     Shader *shader = scene->shaders[i];
+    Program *program = programs_used[i];
+
+    device_update_program(shader, *program, compiled[i]);
 
     shader->clear_modified();
     if (shader->get_use_mis() && shader->has_surface_emission) {
@@ -131,24 +301,23 @@ void SVMShaderManager::device_update(Device *device,
     /* Update the global jump table.
      * Each compiled shader starts with a jump node that has offsets local
      * to the shader, so copy those and add the offset into the global node list. */
+    const int node_offset = program_offsets[program];
     int4 &global_jump_node = svm_nodes[shader->id];
-    int4 &local_jump_node = shader_svm_nodes[i][0];
+    int4 &local_jump_node = program->svm_nodes[0];
 
     global_jump_node.x = NODE_SHADER_JUMP;
     global_jump_node.y = local_jump_node.y - 1 + node_offset;
     global_jump_node.z = local_jump_node.z - 1 + node_offset;
     global_jump_node.w = local_jump_node.w - 1 + node_offset;
-
-    node_offset += shader_svm_nodes[i].size() - 1;
   }
 
-  /* Copy the nodes of each shader into the correct location. */
+  /* Copy the nodes of each program into the correct location. */
   svm_nodes += num_shaders;
-  for (int i = 0; i < num_shaders; i++) {
-    int shader_size = shader_svm_nodes[i].size() - 1;
+  foreach (Program *program, programs_order) {
+    int program_size = program->svm_nodes.size() - 1;
 
-    memcpy(svm_nodes, &shader_svm_nodes[i][1], sizeof(int4) * shader_size);
-    svm_nodes += shader_size;
+    memcpy(svm_nodes, &program->svm_nodes[1], sizeof(int4) * program_size);
+    svm_nodes += program_size;
   }
 
   if (progress.get_cancel()) {
@@ -162,7 +331,8 @@ void SVMShaderManager::device_update(Device *device,
   need_update = false;
 
   VLOG(1) << "Shader manager updated " << num_shaders << " shaders in " << time_dt() - start_time
-          << " seconds.";
+          << " seconds, compiled " << num_compiled << " shaders into "
+          << programs_order.size() << " unique programs.";
 }
 
 void SVMShaderManager::device_free(Device *device, DeviceScene *dscene, Scene *scene)
@@ -170,6 +340,9 @@ void SVMShaderManager::device_free(Device *device, DeviceScene *dscene, Scene *s
   device_free_common(device, dscene, scene);
 
   dscene->svm_nodes.free();
+
+  /* Programs hold on to images, which must be released before the image manager is. */
+  programs.clear();
 }
 
 /* Graph Compiler */
@@ -842,24 +1015,34 @@ void SVMCompiler::compile_type(Shader *shader, ShaderGraph *graph, ShaderType ty
   }
 }
 
-void SVMCompiler::compile(Shader *shader, array<int4> &svm_nodes, int index, Summary *summary)
+static bool shader_has_bump(Shader *shader)
 {
-  /* copy graph for shader with bump mapping */
   ShaderNode *output = shader->graph->output();
+  return (shader->get_displacement_method() != DISPLACE_TRUE) &&
+         output->input("Surface")->link && output->input("Displacement")->link;
+}
+
+void SVMCompiler::finalize(Shader *shader)
+{
+  /* copy graph for shader with bump mapping */
+  shader->graph->finalize(scene,
+                          shader_has_bump(shader),
+                          shader->has_integrator_dependency,
+                          shader->get_displacement_method() == DISPLACE_BOTH);
+}
+
+void SVMCompiler::compile(Shader *shader, array<int4> &svm_nodes, int index, Summary *summary)
+{
   int start_num_svm_nodes = svm_nodes.size();
 
   const double time_start = time_dt();
 
-  bool has_bump = (shader->get_displacement_method() != DISPLACE_TRUE) &&
-                  output->input("Surface")->link && output->input("Displacement")->link;
+  bool has_bump = shader_has_bump(shader);
 
   /* finalize */
   {
     scoped_timer timer((summary != NULL) ? &summary->time_finalize : NULL);
-    shader->graph->finalize(scene,
-                            has_bump,
-                            shader->has_integrator_dependency,
-                            shader->get_displacement_method() == DISPLACE_BOTH);
+    finalize(shader);
   }
 
   current_shader = shader;
@@ -19,9 +19,11 @@
 
 #include "render/attribute.h"
 #include "render/graph.h"
+#include "render/image.h"
 #include "render/shader.h"
 
 #include "util/util_array.h"
+#include "util/util_map.h"
 #include "util/util_set.h"
 #include "util/util_string.h"
 #include "util/util_thread.h"
@@ -50,10 +52,39 @@ class SVMShaderManager : public ShaderManager {
   void device_free(Device *device, DeviceScene *dscene, Scene *scene);
 
  protected:
-  void device_update_shader(Scene *scene,
-                            Shader *shader,
-                            Progress *progress,
-                            array<int4> *svm_nodes);
+  /* Compiled SVM program of a shader, shared by all shaders whose graphs are
+   * identical after finalization. */
+  struct Program {
+    array<int4> svm_nodes;
+
+    /* Images the program uses, handed to the nodes of shaders that share it
+     * without being compiled. */
+    vector<ImageHandle> images;
+
+    /* Shader properties found during compilation. */
+    bool has_surface;
+    bool has_surface_emission;
+    bool has_surface_transparent;
+    bool has_surface_bssrdf;
+    bool has_bump;
+    bool has_bssrdf_bump;
+    bool has_volume;
+    bool has_displacement;
+    bool has_surface_spatial_varying;
+    bool has_volume_spatial_varying;
+    bool has_volume_attribute_dependency;
+    bool has_integrator_dependency;
+  };
+
+  /* Programs of the previous update, by graph hash, compile settings and whether the
+   * shader is used. */
+  map<string, Program> programs;
+
+  string program_key(Scene *scene, Shader *shader);
+
+  void device_update_finalize(Scene *scene, Shader *shader, Progress *progress);
+  void device_update_shader(Scene *scene, Shader *shader, Progress *progress, Program *program);
+  void device_update_program(Shader *shader, Program &program, bool compiled);
 };
 
 /* Graph Compiler */
@@ -92,6 +123,7 @@ class SVMCompiler {
   };
 
   SVMCompiler(Scene *scene);
+  void finalize(Shader *shader);
   void compile(Shader *shader, array<int4> &svm_nodes, int index, Summary *summary = NULL);
 
   int stack_assign(ShaderOutput *output);
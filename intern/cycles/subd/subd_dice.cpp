@@ -20,6 +20,12 @@
 #include "subd/subd_dice.h"
 #include "subd/subd_patch.h"
 
+#include "util/util_atomic.h"
+#include "util/util_foreach.h"
+#include "util/util_hash.h"
+#include "util/util_logging.h"
+#include "util/util_tbb.h"
+
 CCL_NAMESPACE_BEGIN
 
 /* EdgeDice Base */
@@ -45,8 +51,14 @@ void EdgeDice::reserve(int num_verts, int num_triangles)
   vert_offset = mesh->get_verts().size();
   tri_offset = mesh->num_triangles();
 
-  mesh->resize_mesh(mesh->get_verts().size() + num_verts, mesh->num_triangles());
-  mesh->reserve_mesh(mesh->get_verts().size() + num_verts, mesh->num_triangles() + num_triangles);
+  /* Triangles are written by index rather than appended, so subpatches can be diced in any
+   * order. */
+  mesh->resize_mesh(vert_offset + num_verts, tri_offset + num_triangles);
+  mesh->tag_triangles_modified();
+  mesh->tag_shader_modified();
+  mesh->tag_smooth_modified();
+  mesh->tag_triangle_patch_modified();
+  mesh->tag_vert_patch_uv_modified();
 
   Attribute *attr_vN = mesh->attributes.add(ATTR_STD_VERTEX_NORMAL);
 
@@ -56,30 +68,29 @@ void EdgeDice::reserve(int num_verts, int num_triangles)
   params.mesh->num_subd_verts += num_verts;
 }
 
-void EdgeDice::set_vert(Patch *patch, int index, float2 uv)
+void EdgeDice::set_vert(int index, float2 uv, const float3 &P, const float3 &N)
 {
-  float3 P, N;
-
-  patch->eval(&P, NULL, NULL, &N, uv.x, uv.y);
-
   assert(index < params.mesh->verts.size());
 
   mesh_P[index] = P;
   mesh_N[index] = N;
-  params.mesh->vert_patch_uv[index + vert_offset] = make_float2(uv.x, uv.y);
+  params.mesh->vert_patch_uv[index + vert_offset] = uv;
 }
 
-void EdgeDice::add_triangle(Patch *patch, int v0, int v1, int v2)
+void EdgeDice::add_triangle(Patch *patch, int index, int v0, int v1, int v2)
 {
   Mesh *mesh = params.mesh;
-
-  mesh->add_triangle(v0 + vert_offset, v1 + vert_offset, v2 + vert_offset, patch->shader, true);
-  params.mesh->triangle_patch[params.mesh->num_triangles() - 1] = patch->patch_index;
-
-  tri_offset++;
+  size_t tri = tri_offset + index;
+
+  mesh->triangles[tri * 3 + 0] = v0 + vert_offset;
+  mesh->triangles[tri * 3 + 1] = v1 + vert_offset;
+  mesh->triangles[tri * 3 + 2] = v2 + vert_offset;
+  mesh->shader[tri] = patch->shader;
+  mesh->smooth[tri] = true;
+  mesh->triangle_patch[tri] = patch->patch_index;
 }
 
-void EdgeDice::stitch_triangles(Subpatch &sub, int edge)
+void EdgeDice::stitch_triangles(Subpatch &sub, int edge, int &triangle)
 {
   int Mu = max(sub.edge_u0.T, sub.edge_u1.T);
   int Mv = max(sub.edge_v0.T, sub.edge_v1.T);
@@ -122,7 +133,7 @@ void EdgeDice::stitch_triangles(Subpatch &sub, int edge)
         v2 = sub.get_vert_along_grid_edge(edge, ++i);
     }
 
-    add_triangle(sub.patch, v1, v0, v2);
+    add_triangle(sub.patch, triangle++, v1, v0, v2);
   }
 }
 
@@ -152,41 +163,25 @@ float3 QuadDice::eval_projected(Subpatch &sub, float u, float v)
   return P;
 }
 
-void QuadDice::set_vert(Subpatch &sub, int index, float u, float v)
+void QuadDice::eval_vert(Subpatch &sub, float u, float v, float3 &P, float3 &N)
 {
-  EdgeDice::set_vert(sub.patch, index, map_uv(sub, u, v));
+  float2 uv = map_uv(sub, u, v);
+  sub.patch->eval(&P, NULL, NULL, &N, uv.x, uv.y);
 }
 
-void QuadDice::set_side(Subpatch &sub, int edge)
+/* Subpatch coordinates of the vertex at fraction f along a side of the subpatch. */
+static float2 side_uv(int edge, float f)
 {
-  int t = sub.edges[edge].T;
-
-  /* set verts on the edge of the patch */
-  for (int i = 0; i < t; i++) {
-    float f = i / (float)t;
-
-    float u, v;
-    switch (edge) {
-      case 0:
-        u = 0;
-        v = f;
-        break;
-      case 1:
-        u = f;
-        v = 1;
-        break;
-      case 2:
-        u = 1;
-        v = 1.0f - f;
-        break;
-      case 3:
-      default:
-        u = 1.0f - f;
-        v = 0;
-        break;
-    }
-
-    set_vert(sub, sub.get_vert_along_edge(edge, i), u, v);
+  switch (edge) {
+    case 0:
+      return make_float2(0.0f, f);
+    case 1:
+      return make_float2(f, 1.0f);
+    case 2:
+      return make_float2(1.0f, 1.0f - f);
+    case 3:
+    default:
+      return make_float2(1.0f - f, 0.0f);
   }
 }
 
@@ -224,60 +219,265 @@ float QuadDice::scale_factor(Subpatch &sub, int Mu, int Mv)
   return S;
 }
 
-void QuadDice::add_grid(Subpatch &sub, int Mu, int Mv, int offset)
+void QuadDice::grid_size(Subpatch &sub, int &Mu, int &Mv)
+{
+  /* compute inner grid size with scale factor */
+  Mu = max(sub.edge_u0.T, sub.edge_u1.T);
+  Mv = max(sub.edge_v0.T, sub.edge_v1.T);
+
+#if 0 /* Doesn't work very well, especially at grazing angles. */
+  float S = scale_factor(sub, ef, Mu, Mv);
+#else
+  float S = 1.0f;
+#endif
+
+  Mu = max((int)ceilf(S * Mu), 2);  // XXX handle 0 & 1?
+  Mv = max((int)ceilf(S * Mv), 2);  // XXX handle 0 & 1?
+}
+
+void QuadDice::eval(Subpatch &sub, DicedSubpatch &diced)
 {
-  /* create inner grid */
+  int Mu, Mv;
+  grid_size(sub, Mu, Mv);
+
+  size_t num_verts = (Mu - 1) * (Mv - 1);
+  for (int edge = 0; edge < 4; edge++) {
+    num_verts += sub.edges[edge].T;
+  }
+
+  diced.P.resize(num_verts);
+  diced.N.resize(num_verts);
+
+  /* inner grid */
   float du = 1.0f / (float)Mu;
   float dv = 1.0f / (float)Mv;
+  size_t n = 0;
 
   for (int j = 1; j < Mv; j++) {
-    for (int i = 1; i < Mu; i++) {
-      float u = i * du;
-      float v = j * dv;
+    for (int i = 1; i < Mu; i++, n++) {
+      eval_vert(sub, i * du, j * dv, diced.P[n], diced.N[n]);
+    }
+  }
 
-      set_vert(sub, offset + (i - 1) + (j - 1) * (Mu - 1), u, v);
+  /* sides */
+  for (int edge = 0; edge < 4; edge++) {
+    int t = sub.edges[edge].T;
+
+    for (int i = 0; i < t; i++, n++) {
+      float2 uv = side_uv(edge, i / (float)t);
+      eval_vert(sub, uv.x, uv.y, diced.P[n], diced.N[n]);
+    }
+  }
+}
 
-      if (i < Mu - 1 && j < Mv - 1) {
-        int i1 = offset + (i - 1) + (j - 1) * (Mu - 1);
-        int i2 = offset + i + (j - 1) * (Mu - 1);
-        int i3 = offset + i + j * (Mu - 1);
-        int i4 = offset + (i - 1) + j * (Mu - 1);
+void QuadDice::set_grid(Subpatch &sub, const DicedSubpatch &diced)
+{
+  int Mu, Mv;
+  grid_size(sub, Mu, Mv);
 
-        add_triangle(sub.patch, i1, i2, i3);
-        add_triangle(sub.patch, i1, i3, i4);
-      }
+  float du = 1.0f / (float)Mu;
+  float dv = 1.0f / (float)Mv;
+  size_t n = 0;
+
+  for (int j = 1; j < Mv; j++) {
+    for (int i = 1; i < Mu; i++, n++) {
+      set_vert(sub.inner_grid_vert_offset + (i - 1) + (j - 1) * (Mu - 1),
+               map_uv(sub, i * du, j * dv),
+               diced.P[n],
+               diced.N[n]);
     }
   }
 }
 
-void QuadDice::dice(Subpatch &sub)
+void QuadDice::set_sides(Subpatch &sub, const DicedSubpatch &diced)
 {
-  /* compute inner grid size with scale factor */
-  int Mu = max(sub.edge_u0.T, sub.edge_u1.T);
-  int Mv = max(sub.edge_v0.T, sub.edge_v1.T);
+  int Mu, Mv;
+  grid_size(sub, Mu, Mv);
 
-#if 0 /* Doesn't work very well, especially at grazing angles. */
-  float S = scale_factor(sub, ef, Mu, Mv);
-#else
-  float S = 1.0f;
-#endif
+  /* set verts on the edge of the patch */
+  size_t n = (Mu - 1) * (Mv - 1);
 
-  Mu = max((int)ceilf(S * Mu), 2);  // XXX handle 0 & 1?
-  Mv = max((int)ceilf(S * Mv), 2);  // XXX handle 0 & 1?
+  for (int edge = 0; edge < 4; edge++) {
+    int t = sub.edges[edge].T;
+
+    for (int i = 0; i < t; i++, n++) {
+      float2 uv = side_uv(edge, i / (float)t);
+      set_vert(sub.get_vert_along_edge(edge, i), map_uv(sub, uv.x, uv.y), diced.P[n], diced.N[n]);
+    }
+  }
+}
+
+void QuadDice::add_triangles(Subpatch &sub)
+{
+  int Mu, Mv;
+  grid_size(sub, Mu, Mv);
+
+  int offset = sub.inner_grid_vert_offset;
+  int triangle = sub.triangle_offset;
 
   /* inner grid */
-  add_grid(sub, Mu, Mv, sub.inner_grid_vert_offset);
+  for (int j = 1; j < Mv - 1; j++) {
+    for (int i = 1; i < Mu - 1; i++) {
+      int i1 = offset + (i - 1) + (j - 1) * (Mu - 1);
+      int i2 = offset + i + (j - 1) * (Mu - 1);
+      int i3 = offset + i + j * (Mu - 1);
+      int i4 = offset + (i - 1) + j * (Mu - 1);
+
+      add_triangle(sub.patch, triangle++, i1, i2, i3);
+      add_triangle(sub.patch, triangle++, i1, i3, i4);
+    }
+  }
 
   /* sides */
-  set_side(sub, 0);
-  set_side(sub, 1);
-  set_side(sub, 2);
-  set_side(sub, 3);
-
-  stitch_triangles(sub, 0);
-  stitch_triangles(sub, 1);
-  stitch_triangles(sub, 2);
-  stitch_triangles(sub, 3);
+  stitch_triangles(sub, 0, triangle);
+  stitch_triangles(sub, 1, triangle);
+  stitch_triangles(sub, 2, triangle);
+  stitch_triangles(sub, 3, triangle);
+
+  assert(triangle == sub.triangle_offset + sub.calc_num_triangles());
+}
+
+void QuadDice::dice(vector<Subpatch> &subpatches, int num_edge_verts, DicedPatchCache *cache)
+{
+  int num_verts = num_edge_verts;
+  int num_triangles = 0;
+
+  foreach (Subpatch &sub, subpatches) {
+    sub.edge_u0.T = max(sub.edge_u0.T, 1);
+    sub.edge_u1.T = max(sub.edge_u1.T, 1);
+    sub.edge_v0.T = max(sub.edge_v0.T, 1);
+    sub.edge_v1.T = max(sub.edge_v1.T, 1);
+
+    sub.inner_grid_vert_offset = num_verts;
+    sub.triangle_offset = num_triangles;
+    num_verts += sub.calc_num_inner_verts();
+    num_triangles += sub.calc_num_triangles();
+  }
+
+  reserve(num_verts, num_triangles);
+
+  /* Grain size to avoid threading overhead for meshes with many small subpatches. */
+  static const size_t SUBPATCHES_PER_TASK = 16;
+  const blocked_range<size_t> range(0, subpatches.size(), SUBPATCHES_PER_TASK);
+
+  /* Evaluate patches, or take the vertices from the previous tessellation. Inner grid
+   * vertices belong to a single subpatch and can be set right away. */
+  vector<DicedSubpatch> diced(subpatches.size());
+  size_t num_cached = 0;
+
+  parallel_for(range, [&](const blocked_range<size_t> &r) {
+    for (size_t i = r.begin(); i != r.end(); i++) {
+      if (cache && cache->take(subpatches[i], diced[i])) {
+        atomic_add_and_fetch_z(&num_cached, 1);
+      }
+      else {
+        eval(subpatches[i], diced[i]);
+      }
+
+      set_grid(subpatches[i], diced[i]);
+    }
+  });
+
+  /* Vertices along the sides are shared with neighboring subpatches, set them in order so
+   * the result does not depend on scheduling. */
+  for (size_t i = 0; i < subpatches.size(); i++) {
+    set_sides(subpatches[i], diced[i]);
+  }
+
+  /* Stitching looks at the positions of the side vertices, so triangles are added last. */
+  parallel_for(range, [&](const blocked_range<size_t> &r) {
+    for (size_t i = r.begin(); i != r.end(); i++) {
+      add_triangles(subpatches[i]);
+    }
+  });
+
+  if (cache) {
+    cache->update(subpatches, diced);
+  }
+
+  VLOG(2) << "Diced " << subpatches.size() << " subpatches, " << num_cached
+          << " reused from the previous tessellation.";
+}
+
+/* Diced Patch Cache */
+
+DicedPatchCache::Key::Key(const Subpatch &sub)
+{
+  patch_index = sub.patch->patch_index;
+
+  for (int i = 0; i < 4; i++) {
+    corners[i] = sub.corners[i];
+    T[i] = sub.edges[i].T;
+  }
+}
+
+bool DicedPatchCache::Key::operator==(const Key &other) const
+{
+  if (patch_index != other.patch_index) {
+    return false;
+  }
+
+  for (int i = 0; i < 4; i++) {
+    if (!(corners[i] == other.corners[i]) || T[i] != other.T[i]) {
+      return false;
+    }
+  }
+
+  return true;
+}
+
+size_t DicedPatchCache::KeyHasher::operator()(const Key &key) const
+{
+  uint hash = hash_uint(key.patch_index);
+
+  for (int i = 0; i < 4; i++) {
+    hash = hash_uint4(hash,
+                      __float_as_uint(key.corners[i].x),
+                      __float_as_uint(key.corners[i].y),
+                      (uint)key.T[i]);
+  }
+
+  return hash;
+}
+
+DicedPatchCache::DicedPatchCache() : control_hash(0)
+{
+}
+
+void DicedPatchCache::validate(uint control_hash_)
+{
+  if (control_hash != control_hash_) {
+    entries.clear();
+    control_hash = control_hash_;
+  }
+}
+
+bool DicedPatchCache::take(const Subpatch &sub, DicedSubpatch &diced)
+{
+  /* Only the found entry is modified and the map itself is left untouched, so lookups
+   * for other subpatches can happen at the same time. */
+  auto it = entries.find(Key(sub));
+
+  if (it == entries.end() || it->second.P.empty()) {
+    return false;
+  }
+
+  diced.P.swap(it->second.P);
+  diced.N.swap(it->second.N);
+
+  return true;
+}
+
+void DicedPatchCache::update(const vector<Subpatch> &subpatches, vector<DicedSubpatch> &diced)
+{
+  entries.clear();
+  entries.reserve(subpatches.size());
+
+  for (size_t i = 0; i < subpatches.size(); i++) {
+    DicedSubpatch &entry = entries[Key(subpatches[i])];
+    entry.P.swap(diced[i].P);
+    entry.N.swap(diced[i].N);
+  }
 }
 
 CCL_NAMESPACE_END
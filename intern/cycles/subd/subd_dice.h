@@ -22,6 +22,7 @@
  * DiagSplit. For more algorithm details, see the DiagSplit paper or the
  * ARB_tessellation_shader OpenGL extension, Section 2.X.2. */
 
+#include "util/util_map.h"
 #include "util/util_types.h"
 #include "util/util_vector.h"
 
@@ -57,6 +58,61 @@ struct SubdParams {
   }
 };
 
+/* Diced Subpatch
+ *
+ * Evaluated positions and normals of the vertices of a subpatch, those of the inner
+ * grid followed by those along each of the four sides. */
+
+struct DicedSubpatch {
+  vector<float3> P;
+  vector<float3> N;
+};
+
+/* Diced Patch Cache
+ *
+ * Keeps the vertices of the subpatches diced in the previous tessellation of a mesh.
+ * A subpatch only depends on its patch, its corners and the tessellation factors of
+ * its edges, so as long as the control mesh stays the same the vertices of subpatches
+ * with unchanged factors are reused instead of evaluating the patch again. This is
+ * typically most of the mesh when only the dicing camera moves between frames. */
+
+class DicedPatchCache {
+ public:
+  DicedPatchCache();
+
+  /* Clear the cache when the control mesh changed since the previous tessellation. */
+  void validate(uint control_hash);
+
+  /* Move the cached vertices of the subpatch into diced. Safe to call from multiple
+   * threads, for different subpatches. */
+  bool take(const Subpatch &sub, DicedSubpatch &diced);
+
+  /* Replace the contents with the subpatches of the current tessellation. */
+  void update(const vector<Subpatch> &subpatches, vector<DicedSubpatch> &diced);
+
+  size_t size() const
+  {
+    return entries.size();
+  }
+
+ protected:
+  struct Key {
+    int patch_index;
+    float2 corners[4];
+    int T[4];
+
+    explicit Key(const Subpatch &sub);
+    bool operator==(const Key &other) const;
+  };
+
+  struct KeyHasher {
+    size_t operator()(const Key &key) const;
+  };
+
+  unordered_map<Key, DicedSubpatch, KeyHasher> entries;
+  uint control_hash;
+};
+
 /* EdgeDice Base */
 
 class EdgeDice {
@@ -71,10 +127,10 @@ class EdgeDice {
 
   void reserve(int num_verts, int num_triangles);
 
-  void set_vert(Patch *patch, int index, float2 uv);
-  void add_triangle(Patch *patch, int v0, int v1, int v2);
+  void set_vert(int index, float2 uv, const float3 &P, const float3 &N);
+  void add_triangle(Patch *patch, int index, int v0, int v1, int v2);
 
-  void stitch_triangles(Subpatch &sub, int edge);
+  void stitch_triangles(Subpatch &sub, int edge, int &triangle);
 };
 
 /* Quad EdgeDice */
@@ -86,16 +142,21 @@ class QuadDice : public EdgeDice {
   float3 eval_projected(Subpatch &sub, float u, float v);
 
   float2 map_uv(Subpatch &sub, float u, float v);
-  void set_vert(Subpatch &sub, int index, float u, float v);
+  void eval_vert(Subpatch &sub, float u, float v, float3 &P, float3 &N);
+
+  void grid_size(Subpatch &sub, int &Mu, int &Mv);
 
-  void add_grid(Subpatch &sub, int Mu, int Mv, int offset);
+  void eval(Subpatch &sub, DicedSubpatch &diced);
 
-  void set_side(Subpatch &sub, int edge);
+  void set_grid(Subpatch &sub, const DicedSubpatch &diced);
+  void set_sides(Subpatch &sub, const DicedSubpatch &diced);
+  void add_triangles(Subpatch &sub);
 
   float quad_area(const float3 &a, const float3 &b, const float3 &c, const float3 &d);
   float scale_factor(Subpatch &sub, int Mu, int Mv);
 
-  void dice(Subpatch &sub);
+  /* Dice all subpatches in parallel, edge verts are expected to be allocated already. */
+  void dice(vector<Subpatch> &subpatches, int num_edge_verts, DicedPatchCache *cache);
 };
 
 CCL_NAMESPACE_END
@@ -22,9 +22,11 @@
 #include "render/graph.h"
 #include "render/nodes.h"
 #include "render/scene.h"
+#include "render/shader.h"
 
 #include "util/util_array.h"
 #include "util/util_logging.h"
+#include "util/util_progress.h"
 #include "util/util_stats.h"
 #include "util/util_string.h"
 #include "util/util_vector.h"
@@ -1541,4 +1543,81 @@ TEST_F(RenderGraph, constant_fold_convert_color_float_color)
   graph.finalize(scene);
 }
 
+/*
+ * Tests:
+ *  - graphs that are identical after constant folding have the same hash.
+ *  - graphs with different settings have a different hash.
+ */
+TEST_F(RenderGraph, finalized_hash)
+{
+  EXPECT_ANY_MESSAGE(log);
+
+  builder.add_attribute("Attribute")
+      .add_node(ShaderNodeBuilder<MixNode>(graph, "Mix")
+                    .set_param("mix_type", NODE_MIX_BLEND)
+                    .set("Fac", 0.0f)
+                    .set("Color2", make_float3(0.3f, 0.5f, 0.7f)))
+      .add_connection("Attribute::Color", "Mix::Color1")
+      .output_color("Mix::Color");
+
+  graph.finalize(scene);
+  graph.compute_finalized_hash();
+
+  ShaderGraph folded_graph;
+  ShaderGraphBuilder(&folded_graph).add_attribute("Attribute").output_color("Attribute::Color");
+
+  folded_graph.finalize(scene);
+  folded_graph.compute_finalized_hash();
+
+  ShaderGraph other_graph;
+  ShaderGraphBuilder(&other_graph).add_attribute("Other").output_color("Other::Color");
+
+  other_graph.finalize(scene);
+  other_graph.compute_finalized_hash();
+
+  EXPECT_FALSE(graph.finalized_hash.empty());
+  EXPECT_EQ(graph.finalized_hash, folded_graph.finalized_hash);
+  EXPECT_NE(graph.finalized_hash, other_graph.finalized_hash);
+}
+
+/*
+ * Tests:
+ *  - shaders with identical graphs don't share a program when only one of them is used,
+ *    both within one update and through the programs cached from the previous update.
+ */
+TEST_F(RenderGraph, svm_program_shader_used)
+{
+  EXPECT_ANY_MESSAGE(log);
+
+  Shader *shaders[2];
+  for (int i = 0; i < 2; i++) {
+    ShaderGraph *shader_graph = new ShaderGraph();
+    ShaderGraphBuilder(shader_graph)
+        .add_node(ShaderNodeBuilder<EmissionNode>(*shader_graph, "Emission")
+                      .set("Color", make_float3(0.8f, 0.8f, 0.8f))
+                      .set("Strength", 1.0f))
+        .output_closure("Emission::Emission");
+
+    shaders[i] = scene->create_node<Shader>();
+    shaders[i]->set_graph(shader_graph);
+    shaders[i]->tag_update(scene);
+  }
+
+  Progress progress;
+  shaders[0]->used = true;
+  shaders[1]->used = false;
+  scene->shader_manager->device_update(device_cpu, &scene->dscene, scene, progress);
+
+  EXPECT_TRUE(shaders[0]->has_surface);
+  EXPECT_FALSE(shaders[1]->has_surface);
+
+  shaders[0]->used = false;
+  shaders[1]->used = true;
+  scene->shader_manager->need_update = true;
+  scene->shader_manager->device_update(device_cpu, &scene->dscene, scene, progress);
+
+  EXPECT_FALSE(shaders[0]->has_surface);
+  EXPECT_TRUE(shaders[1]->has_surface);
+}
+
 CCL_NAMESPACE_END
@@ -0,0 +1,129 @@
+/*
+ * Copyright 2011-2020 Blender Foundation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "testing/testing.h"
+
+#include "render/image_vdb.h"
+
+#include "kernel/kernel_compat_cpu.h"
+#include "kernel/kernel_math.h"
+#include "kernel/kernel_types.h"
+#include "kernel/split/kernel_split_data.h"
+#include "kernel/kernel_globals.h"
+#include "kernel/kernels/cpu/kernel_cpu_image.h"
+
+#include "util/util_aligned_malloc.h"
+
+CCL_NAMESPACE_BEGIN
+
+namespace {
+
+/* Loads a grid created in memory, like the loader of Blender volume objects. */
+class GridImageLoader : public VDBImageLoader {
+ public:
+  explicit GridImageLoader(openvdb::GridBase::ConstPtr grid_) : VDBImageLoader("density")
+  {
+    grid = grid_;
+  }
+};
+
+const int CLOUD_SIZE = 16;
+const int CLOUD_OFFSET = 240;
+
+/* Two small clouds in opposite corners of a large bounding box, like a sparse smoke cache. */
+openvdb::FloatGrid::Ptr create_clouds_grid()
+{
+  openvdb::FloatGrid::Ptr grid = openvdb::FloatGrid::create(0.0f);
+  openvdb::FloatGrid::Accessor accessor = grid->getAccessor();
+  for (int z = 0; z < CLOUD_SIZE; z++) {
+    for (int y = 0; y < CLOUD_SIZE; y++) {
+      for (int x = 0; x < CLOUD_SIZE; x++) {
+        accessor.setValue(openvdb::Coord(x, y, z), 0.1f + 0.05f * x);
+        accessor.setValue(openvdb::Coord(x + CLOUD_OFFSET, y + CLOUD_OFFSET, z + CLOUD_OFFSET),
+                          0.5f + 0.01f * z);
+      }
+    }
+  }
+  return grid;
+}
+
+}  // namespace
+
+/* Load a grid and sample it through the image lookup of the CPU kernel, the way volume shaders
+ * read densities, comparing against the values of the grid. */
+TEST(RenderVolume, vdb_grid_sampling)
+{
+  openvdb::initialize();
+  openvdb::FloatGrid::Ptr grid = create_clouds_grid();
+  GridImageLoader loader(grid);
+
+  ImageMetaData metadata;
+  ASSERT_TRUE(loader.load_metadata(metadata));
+  const int size = CLOUD_OFFSET + CLOUD_SIZE;
+  EXPECT_EQ(metadata.width, (size_t)size);
+  EXPECT_EQ(metadata.height, (size_t)size);
+  EXPECT_EQ(metadata.depth, (size_t)size);
+
+  const size_t dense_size = sizeof(float) * size * size * size;
+#ifdef WITH_NANOVDB
+  /* Only the leaf nodes of the clouds are stored, not the empty space between them. */
+  EXPECT_EQ(metadata.type, IMAGE_DATA_TYPE_NANOVDB_FLOAT);
+  EXPECT_LT(metadata.byte_size * 100, dense_size);
+  const size_t pixels_size = metadata.byte_size;
+#else
+  EXPECT_EQ(metadata.type, IMAGE_DATA_TYPE_FLOAT);
+  const size_t pixels_size = dense_size;
+#endif
+
+  /* Allocated the same way as CPU device memory. */
+  void *pixels = util_aligned_malloc(pixels_size, MIN_ALIGNMENT_CPU_DATA_TYPES);
+  ASSERT_TRUE(loader.load_pixels(metadata, pixels, pixels_size, false));
+
+  TextureInfo info = {};
+  info.data = (uint64_t)pixels;
+  info.data_type = metadata.type;
+  info.interpolation = INTERPOLATION_CLOSEST;
+  info.extension = EXTENSION_CLIP;
+  info.width = metadata.width;
+  info.height = metadata.height;
+  info.depth = metadata.depth;
+  info.use_transform_3d = metadata.use_transform_3d;
+  info.transform_3d = metadata.transform_3d;
+
+  KernelGlobals kg;
+  kg.__texture_info.data = &info;
+  kg.__texture_info.width = 1;
+
+  /* The grid has an identity transform, so object space matches voxel indices. */
+  openvdb::FloatGrid::ConstAccessor accessor = grid->getConstAccessor();
+  int num_mismatches = 0;
+  for (int z = 0; z < size; z += 3) {
+    for (int y = 0; y < size; y += 3) {
+      for (int x = 0; x < size; x += 3) {
+        const float3 P = make_float3(x + 0.25f, y + 0.25f, z + 0.25f);
+        const float4 value = kernel_tex_image_interp_3d(&kg, 0, P, INTERPOLATION_NONE);
+        if (fabsf(value.x - accessor.getValue(openvdb::Coord(x, y, z))) > 1e-6f) {
+          num_mismatches++;
+        }
+      }
+    }
+  }
+  EXPECT_EQ(num_mismatches, 0);
+
+  util_aligned_free(pixels);
+}
+
+CCL_NAMESPACE_END
@@ -281,4 +281,17 @@ TEST(util_string_remove_trademark, r_space_middle)
   EXPECT_EQ(str, "foo bar baz");
 }
 
+/* ******** Tests for string_json_quote() ******** */
+
+TEST(util_string_json_quote, plain)
+{
+  EXPECT_EQ(string_json_quote("Material"), "\"Material\"");
+}
+
+TEST(util_string_json_quote, escapes)
+{
+  EXPECT_EQ(string_json_quote("a\"b\\c"), "\"a\\\"b\\\\c\"");
+  EXPECT_EQ(string_json_quote("a\nb\x01"), "\"a\\nb\\u0001\"");
+}
+
 CCL_NAMESPACE_END
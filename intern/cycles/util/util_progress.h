@@ -39,9 +39,12 @@ class Progress {
     current_tile_sample = 0;
     rendered_tiles = 0;
     denoised_tiles = 0;
+    denoising_tiles = 0;
     start_time = time_dt();
     render_start_time = time_dt();
     end_time = 0.0;
+    denoise_start_time = 0.0;
+    denoise_time = 0.0;
     status = "Initializing";
     substatus = "";
     sync_status = "";
@@ -80,9 +83,12 @@ class Progress {
     current_tile_sample = 0;
     rendered_tiles = 0;
     denoised_tiles = 0;
+    denoising_tiles = 0;
     start_time = time_dt();
     render_start_time = time_dt();
     end_time = 0.0;
+    denoise_start_time = 0.0;
+    denoise_time = 0.0;
     status = "Initializing";
     substatus = "";
     sync_status = "";
@@ -258,6 +264,38 @@ class Progress {
     return denoised_tiles;
   }
 
+  uint64_t get_pixel_samples()
+  {
+    thread_scoped_lock lock(progress_mutex);
+    return pixel_samples;
+  }
+
+  /* Denoising time is the time during which any tile was being denoised, which may overlap with
+   * rendering of other tiles. */
+  void begin_denoise_tile()
+  {
+    thread_scoped_lock lock(progress_mutex);
+
+    if (denoising_tiles++ == 0) {
+      denoise_start_time = time_dt();
+    }
+  }
+
+  void end_denoise_tile()
+  {
+    thread_scoped_lock lock(progress_mutex);
+
+    if (--denoising_tiles == 0) {
+      denoise_time += time_dt() - denoise_start_time;
+    }
+  }
+
+  double get_denoise_time()
+  {
+    thread_scoped_lock lock(progress_mutex);
+    return denoise_time;
+  }
+
   /* status messages */
 
   void set_status(const string &status_, const string &substatus_ = "")
@@ -367,8 +405,11 @@ class Progress {
    * Used to determine whether all but the last tile are finished rendering,
    * in which case the current_tile_sample is displayed. */
   int rendered_tiles, denoised_tiles;
+  /* Number of tiles being denoised right now. */
+  int denoising_tiles;
 
   double start_time, render_start_time;
+  double denoise_start_time, denoise_time;
   /* End time written when render is done, so it doesn't keep increasing on redraws. */
   double end_time;
 
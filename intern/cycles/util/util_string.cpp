@@ -172,6 +172,30 @@ string to_string(const char *str)
   return string(str);
 }
 
+string string_json_quote(const string &str)
+{
+  string result = "\"";
+  foreach (char c, str) {
+    if (c == '"' || c == '\\') {
+      result += '\\';
+      result += c;
+    }
+    else if (c == '\n') {
+      result += "\\n";
+    }
+    else if (c == '\t') {
+      result += "\\t";
+    }
+    else if ((unsigned char)c < 0x20) {
+      result += string_printf("\\u%04x", (int)c);
+    }
+    else {
+      result += c;
+    }
+  }
+  return result + "\"";
+}
+
 /* Wide char strings helpers for Windows. */
 
 #ifdef _WIN32
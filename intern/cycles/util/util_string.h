@@ -51,6 +51,8 @@ string string_strip(const string &s);
 string string_remove_trademark(const string &s);
 string string_from_bool(const bool var);
 string to_string(const char *str);
+/* Quote and escape a string for use in JSON. */
+string string_json_quote(const string &str);
 
 /* Wide char strings are only used on Windows to deal with non-ascii
  * characters in file names and such. No reason to use such strings
@@ -0,0 +1,95 @@
+/*
+ * Copyright 2011-2020 Blender Foundation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "util/util_texture_cache.h"
+#include "util/util_math.h"
+
+#include <OpenImageIO/texture.h>
+
+CCL_NAMESPACE_BEGIN
+
+using OIIO::TextureOpt;
+using OIIO::TextureSystem;
+
+float4 texture_cache_lookup(const TextureInfo &info,
+                            float x,
+                            float y,
+                            float dxdx,
+                            float dydx,
+                            float dxdy,
+                            float dydy)
+{
+  const TextureCacheImage *image = (const TextureCacheImage *)info.data;
+  TextureSystem *texture_system = (TextureSystem *)image->texture_system;
+
+  TextureOpt options;
+  switch (info.interpolation) {
+    case INTERPOLATION_CLOSEST:
+      options.interpmode = TextureOpt::InterpClosest;
+      options.mipmode = TextureOpt::MipModeNoMIP;
+      break;
+    case INTERPOLATION_CUBIC:
+      options.interpmode = TextureOpt::InterpBicubic;
+      break;
+    case INTERPOLATION_SMART:
+      options.interpmode = TextureOpt::InterpSmartBicubic;
+      break;
+    default:
+      options.interpmode = TextureOpt::InterpBilinear;
+      break;
+  }
+  switch (info.extension) {
+    case EXTENSION_EXTEND:
+      options.swrap = options.twrap = TextureOpt::WrapClamp;
+      break;
+    case EXTENSION_CLIP:
+      options.swrap = options.twrap = TextureOpt::WrapBlack;
+      break;
+    default:
+      options.swrap = options.twrap = TextureOpt::WrapPeriodic;
+      break;
+  }
+  /* Opaque alpha for images without alpha channel. */
+  options.fill = 1.0f;
+
+  /* Images in Cycles start at the bottom, in the texture system at the top. The thread info is
+   * looked up by the texture system itself, as kernel globals are not available here. */
+  float result[4];
+  if (!texture_system->texture((TextureSystem::TextureHandle *)image->handle,
+                               NULL,
+                               options,
+                               x,
+                               1.0f - y,
+                               dxdx,
+                               -dydx,
+                               dxdy,
+                               -dydy,
+                               4,
+                               result)) {
+    return make_float4(
+        TEX_IMAGE_MISSING_R, TEX_IMAGE_MISSING_G, TEX_IMAGE_MISSING_B, TEX_IMAGE_MISSING_A);
+  }
+
+  /* Same as for images loaded into device memory, avoid artifacts from invalid values. */
+  if (!isfinite_safe(result[0]) || !isfinite_safe(result[1]) || !isfinite_safe(result[2]) ||
+      !isfinite_safe(result[3])) {
+    return make_float4(0.0f, 0.0f, 0.0f, 0.0f);
+  }
+
+  return make_float4(result[0], result[1], result[2], result[3]);
+}
+
+CCL_NAMESPACE_END
@@ -0,0 +1,51 @@
+/*
+ * Copyright 2011-2020 Blender Foundation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef __UTIL_TEXTURE_CACHE_H__
+#define __UTIL_TEXTURE_CACHE_H__
+
+#include "util/util_texture.h"
+#include "util/util_types.h"
+
+CCL_NAMESPACE_BEGIN
+
+/* Texture Cache
+ *
+ * Images that are not loaded into device memory, but read on demand in tiles and mipmap levels
+ * by the OpenImageIO texture system, within a fixed memory budget. This is only supported on
+ * the CPU, where the kernel can call into the texture system.
+ *
+ * For IMAGE_DATA_TYPE_TEXTURE_CACHE textures, TextureInfo.data points to this. */
+
+typedef struct TextureCacheImage {
+  /* OIIO::TextureSystem and OIIO::TextureSystem::TextureHandle. */
+  void *texture_system;
+  void *handle;
+} TextureCacheImage;
+
+/* Filtered lookup, with the derivatives of the texture coordinates in screen space used to
+ * choose the mipmap levels. Zero derivatives give a lookup in the full resolution image. */
+float4 texture_cache_lookup(const TextureInfo &info,
+                            float x,
+                            float y,
+                            float dxdx,
+                            float dydx,
+                            float dxdy,
+                            float dydy);
+
+CCL_NAMESPACE_END
+
+#endif /* __UTIL_TEXTURE_CACHE_H__ */
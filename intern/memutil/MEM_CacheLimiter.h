@@ -229,6 +229,19 @@ template<class T> class MEM_CacheLimiter {
     }
   }
 
+  /* Element enforce_limits() would destroy first, NULL when none can be destroyed. */
+  T *get_least_priority_destroyable()
+  {
+    MEM_CacheElementPtr elem = get_least_priority_destroyable_element();
+    return elem ? elem->get() : NULL;
+  }
+
+  bool destroy_least_priority_element()
+  {
+    MEM_CacheElementPtr elem = get_least_priority_destroyable_element();
+    return elem && elem->destroy_if_possible();
+  }
+
   void touch(MEM_CacheLimiterHandle<T> *handle)
   {
     /* If we're using custom priority callback re-arranging the queue
@@ -90,6 +90,24 @@ MEM_CacheLimiterHandleC *MEM_CacheLimiter_insert(MEM_CacheLimiterC *This, void *
 
 void MEM_CacheLimiter_enforce_limits(MEM_CacheLimiterC *This);
 
+/**
+ * Get the object which is freed first when enforcing the memory constraints.
+ *
+ * \param This: "This" pointer.
+ * \return Managed data, or NULL when no object can be freed.
+ */
+
+void *MEM_CacheLimiter_get_least_priority_destroyable(MEM_CacheLimiterC *This);
+
+/**
+ * Free the object which is freed first when enforcing the memory constraints.
+ *
+ * \param This: "This" pointer.
+ * \return True when an object was freed.
+ */
+
+bool MEM_CacheLimiter_destroy_least_priority(MEM_CacheLimiterC *This);
+
 /**
  * Unmanage object previously inserted object.
  * Does _not_ delete managed object!
@@ -181,6 +181,17 @@ void MEM_CacheLimiter_enforce_limits(MEM_CacheLimiterC *This)
   cast(This)->get_cache()->enforce_limits();
 }
 
+void *MEM_CacheLimiter_get_least_priority_destroyable(MEM_CacheLimiterC *This)
+{
+  MEM_CacheLimiterHandleCClass *elem = cast(This)->get_cache()->get_least_priority_destroyable();
+  return elem ? elem->get_data() : NULL;
+}
+
+bool MEM_CacheLimiter_destroy_least_priority(MEM_CacheLimiterC *This)
+{
+  return cast(This)->get_cache()->destroy_least_priority_element();
+}
+
 void MEM_CacheLimiter_unmanage(MEM_CacheLimiterHandleC *handle)
 {
   cast(handle)->unmanage();
@@ -665,7 +665,13 @@ class NODE_PT_quality(bpy.types.Panel):
         col.prop(tree, "use_opencl")
         col.prop(tree, "use_groupnode_buffer")
         col.prop(tree, "use_two_pass")
+        col.prop(tree, "use_full_frame")
+        col.prop(tree, "use_half_float_buffers")
         col.prop(tree, "use_viewer_border")
+        col.prop(tree, "use_result_cache")
+        sub = col.column()
+        sub.active = tree.use_result_cache
+        sub.prop(tree, "cache_size")
         col.separator()
         col.prop(snode, "use_auto_render")
 
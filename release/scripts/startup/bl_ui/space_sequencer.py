@@ -252,6 +252,7 @@ class SEQUENCER_PT_sequencer_overlay(Panel):
         layout.prop(st, "show_strip_name", text="Name")
         layout.prop(st, "show_strip_source", text="Source")
         layout.prop(st, "show_strip_duration", text="Duration")
+        layout.prop(st, "show_strip_render_time", text="Render Time")
 
         layout.separator()
 
@@ -51,6 +51,7 @@ struct MVert;
 struct Main;
 struct MemArena;
 struct Mesh;
+struct MeshElemMap;
 struct ModifierData;
 struct Object;
 struct PointCloud;
@@ -408,6 +409,22 @@ void BKE_lnor_space_custom_normal_to_data(MLoopNorSpace *lnor_space,
                                           short r_clnor_data[2]);
 
 /* Medium-level custom normals functions. */
+void BKE_mesh_normals_loop_split_ex(const struct MVert *mverts,
+                                    const int numVerts,
+                                    struct MEdge *medges,
+                                    const int numEdges,
+                                    struct MLoop *mloops,
+                                    float (*r_loopnors)[3],
+                                    const int numLoops,
+                                    struct MPoly *mpolys,
+                                    const float (*polynors)[3],
+                                    const int numPolys,
+                                    const bool use_split_normals,
+                                    const float split_angle,
+                                    MLoopNorSpaceArray *r_lnors_spacearr,
+                                    short (*clnors_data)[2],
+                                    int *r_loop_to_poly,
+                                    const struct MeshElemMap *vert_to_loop);
 void BKE_mesh_normals_loop_split(const struct MVert *mverts,
                                  const int numVerts,
                                  struct MEdge *medges,
@@ -38,6 +38,7 @@ struct MLoop;
 struct MLoopTri;
 struct MVertTri;
 struct Mesh;
+struct MeshElemMap;
 struct Object;
 struct Scene;
 
@@ -52,6 +53,20 @@ bool BKE_mesh_runtime_reset_edit_data(struct Mesh *mesh);
 void BKE_mesh_runtime_clear_geometry(struct Mesh *mesh);
 void BKE_mesh_runtime_clear_cache(struct Mesh *mesh);
 
+const struct MeshElemMap *BKE_mesh_runtime_vert_poly_map_ensure(struct Mesh *mesh);
+const struct MeshElemMap *BKE_mesh_runtime_vert_loop_map_ensure(struct Mesh *mesh);
+const struct MeshElemMap *BKE_mesh_runtime_vert_edge_map_ensure(struct Mesh *mesh);
+const struct MeshElemMap *BKE_mesh_runtime_edge_poly_map_ensure(struct Mesh *mesh);
+bool BKE_mesh_runtime_minmax(struct Mesh *mesh, float r_min[3], float r_max[3]);
+const float (*BKE_mesh_runtime_loop_normals_ensure(struct Mesh *mesh))[3];
+struct MVert *BKE_mesh_runtime_verts_for_write(struct Mesh *mesh);
+void BKE_mesh_runtime_clear_topology_cache(struct Mesh *mesh);
+
+float (*BKE_mesh_runtime_vert_positions_ensure(struct Mesh *mesh))[3];
+void BKE_mesh_runtime_vert_positions_assign(struct Mesh *mesh, float (*vert_positions)[3]);
+void BKE_mesh_runtime_vert_positions_flush(struct Mesh *mesh);
+void BKE_mesh_runtime_clear_vert_positions(struct Mesh *mesh);
+
 void BKE_mesh_runtime_verttri_from_looptri(struct MVertTri *r_verttri,
                                            const struct MLoop *mloop,
                                            const struct MLoopTri *looptri,
@@ -36,6 +36,7 @@ struct OpenSubdiv_Converter;
 struct OpenSubdiv_Evaluator;
 struct OpenSubdiv_TopologyRefiner;
 struct Subdiv;
+struct SubdivMeshTopologyKey;
 
 typedef enum eSubdivVtxBoundaryInterpolation {
   /* Do not interpolate boundaries. */
@@ -190,6 +191,10 @@ typedef struct Subdiv {
     /* Indexed by base face index, element indicates total number of ptex
      * faces created for preceding base faces. */
     int *face_ptex_offset;
+    /* Copy of the coarse mesh topology the topology refiner was created for.
+     * Allows to re-use the descriptor without creating a converter and comparing
+     * topology on OpenSubdiv side, see BKE_subdiv_update_from_mesh(). */
+    struct SubdivMeshTopologyKey *mesh_topology_key;
   } cache_;
 } Subdiv;
 
@@ -932,6 +932,21 @@ static Mesh *modifier_modify_mesh_and_geometry_set(ModifierData *md,
   return mesh_output;
 }
 
+/**
+ * Write the deformed coordinates to #MVert of the mesh and free them,
+ * they can be the runtime vertex positions of the mesh.
+ */
+static void mesh_deformed_verts_apply(Mesh *mesh, float (**deformed_verts)[3])
+{
+  const bool is_vert_positions = (*deformed_verts == mesh->runtime.vert_positions);
+  /* Runtime vertex positions are freed when applying them. */
+  BKE_mesh_vert_coords_apply(mesh, *deformed_verts);
+  if (!is_vert_positions) {
+    MEM_freeN(*deformed_verts);
+  }
+  *deformed_verts = nullptr;
+}
+
 static void mesh_calc_modifiers(struct Depsgraph *depsgraph,
                                 Scene *scene,
                                 Object *ob,
@@ -1044,7 +1059,10 @@ static void mesh_calc_modifiers(struct Depsgraph *depsgraph,
             mesh_final = BKE_mesh_copy_for_eval(mesh_input, true);
             ASSERT_IS_VALID_MESH(mesh_final);
           }
-          BKE_mesh_vert_coords_apply(mesh_final, deformed_verts);
+          /* The mesh takes the deformed coordinates as its runtime vertex positions, normals are
+           * calculated from those and following modifiers keep deforming them in place, without
+           * writing #MVert until a constructive modifier or the end of the stack. */
+          BKE_mesh_runtime_vert_positions_assign(mesh_final, deformed_verts);
         }
 
         BKE_modifier_deform_verts(md, &mectx, mesh_final, deformed_verts, num_deformed_verts);
@@ -1148,10 +1166,11 @@ static void mesh_calc_modifiers(struct Depsgraph *depsgraph,
       /* No existing verts to deform, need to build them. */
       if (!deformed_verts) {
         if (mesh_final) {
-          /* Deforming a mesh, read the vertex locations
-           * out of the mesh and deform them. Once done with this
-           * run of deformers verts will be written back. */
-          deformed_verts = BKE_mesh_vert_coords_alloc(mesh_final, &num_deformed_verts);
+          /* Deforming a mesh, deform the runtime vertex positions
+           * of the mesh in place. Once done with this run of
+           * deformers verts will be written back. */
+          deformed_verts = BKE_mesh_runtime_vert_positions_ensure(mesh_final);
+          num_deformed_verts = mesh_final->totvert;
         }
         else {
           deformed_verts = BKE_mesh_vert_coords_alloc(mesh_input, &num_deformed_verts);
@@ -1164,7 +1183,7 @@ static void mesh_calc_modifiers(struct Depsgraph *depsgraph,
           mesh_final = BKE_mesh_copy_for_eval(mesh_input, true);
           ASSERT_IS_VALID_MESH(mesh_final);
         }
-        BKE_mesh_vert_coords_apply(mesh_final, deformed_verts);
+        BKE_mesh_runtime_vert_positions_assign(mesh_final, deformed_verts);
       }
       BKE_modifier_deform_verts(md, &mectx, mesh_final, deformed_verts, num_deformed_verts);
     }
@@ -1185,7 +1204,7 @@ static void mesh_calc_modifiers(struct Depsgraph *depsgraph,
       }
 
       if (deformed_verts) {
-        BKE_mesh_vert_coords_apply(mesh_final, deformed_verts);
+        mesh_deformed_verts_apply(mesh_final, &deformed_verts);
       }
 
       have_non_onlydeform_modifiers_appled = true;
@@ -1262,11 +1281,6 @@ static void mesh_calc_modifiers(struct Depsgraph *depsgraph,
           BKE_id_free(nullptr, mesh_final);
         }
         mesh_final = mesh_next;
-
-        if (deformed_verts) {
-          MEM_freeN(deformed_verts);
-          deformed_verts = nullptr;
-        }
       }
 
       /* create an orco mesh in parallel */
@@ -1372,9 +1386,7 @@ static void mesh_calc_modifiers(struct Depsgraph *depsgraph,
     }
   }
   if (deformed_verts) {
-    BKE_mesh_vert_coords_apply(mesh_final, deformed_verts);
-    MEM_freeN(deformed_verts);
-    deformed_verts = nullptr;
+    mesh_deformed_verts_apply(mesh_final, &deformed_verts);
   }
 
   /* Denotes whether the object which the modifier stack came from owns the mesh or whether the
@@ -21,6 +21,7 @@
 #include "BKE_deform.h"
 #include "BKE_geometry_set.hh"
 #include "BKE_mesh.h"
+#include "BKE_mesh_runtime.h"
 #include "BKE_pointcloud.h"
 
 #include "DNA_mesh_types.h"
@@ -951,6 +952,13 @@ ReadAttributePtr MeshComponent::attribute_try_get_for_read(const StringRef attri
   }
 
   if (attribute_name == "position") {
+    if (mesh_->runtime.vert_positions != nullptr) {
+      /* Positions of a mesh in the modifier stack, used directly without gathering them. */
+      return std::make_unique<blender::bke::ArrayReadAttribute<float3>>(
+          ATTR_DOMAIN_POINT,
+          blender::Span(reinterpret_cast<const float3 *>(mesh_->runtime.vert_positions),
+                        mesh_->totvert));
+    }
     auto get_vertex_position = [](const MVert &vert) { return float3(vert.co); };
     return std::make_unique<
         blender::bke::DerivedArrayReadAttribute<MVert, float3, decltype(get_vertex_position)>>(
@@ -1002,7 +1010,18 @@ WriteAttributePtr MeshComponent::attribute_try_get_for_write(const StringRef att
   };
 
   if (attribute_name == "position") {
-    CustomData_duplicate_referenced_layer(&mesh->vdata, CD_MVERT, mesh->totvert);
+    mesh->runtime.cd_dirty_vert |= CD_MASK_NORMAL;
+
+    if (mesh->runtime.vert_positions != nullptr) {
+      /* Written in place, #MVert is updated when the modifier stack flushes the positions. */
+      return std::make_unique<blender::bke::ArrayWriteAttribute<float3>>(
+          ATTR_DOMAIN_POINT,
+          blender::MutableSpan(
+              reinterpret_cast<float3 *>(BKE_mesh_runtime_vert_positions_ensure(mesh)),
+              mesh->totvert));
+    }
+
+    BKE_mesh_runtime_verts_for_write(mesh);
     update_mesh_pointers();
 
     auto get_vertex_position = [](const MVert &vert) { return float3(vert.co); };
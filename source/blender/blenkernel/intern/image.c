@@ -37,6 +37,8 @@
 
 #include "MEM_guardedalloc.h"
 
+#include "atomic_ops.h"
+
 #include "IMB_colormanagement.h"
 #include "IMB_imbuf.h"
 #include "IMB_imbuf_types.h"
@@ -489,6 +491,7 @@ void BKE_image_free_buffers_ex(Image *ima, bool do_lock)
   if (do_lock) {
     BLI_mutex_lock(image_mutex);
   }
+  atomic_add_and_fetch_uint32(&ima->generation_counter, 1);
   image_free_cached_frames(ima);
 
   image_free_anims(ima);
@@ -5649,9 +5652,10 @@ bool BKE_image_is_dirty(Image *image)
   return BKE_image_is_dirty_writable(image, NULL);
 }
 
-void BKE_image_mark_dirty(Image *UNUSED(image), ImBuf *ibuf)
+void BKE_image_mark_dirty(Image *image, ImBuf *ibuf)
 {
   ibuf->userflags |= IB_BITMAPDIRTY;
+  atomic_add_and_fetch_uint32(&image->generation_counter, 1);
 }
 
 bool BKE_image_buffer_format_writable(ImBuf *ibuf)
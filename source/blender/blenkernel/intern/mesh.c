@@ -139,6 +139,11 @@ static void mesh_copy_data(Main *bmain, ID *id_dst, const ID *id_src, const int
 
   BKE_mesh_update_customdata_pointers(mesh_dst, do_tessface);
 
+  if (mesh_src->runtime.vert_positions) {
+    /* #MVert of the source is out of date, the copy gets the current positions. */
+    BKE_mesh_vert_coords_apply(mesh_dst, (const float(*)[3])mesh_src->runtime.vert_positions);
+  }
+
   mesh_dst->edit_mesh = NULL;
 
   mesh_dst->mselect = MEM_dupallocN(mesh_dst->mselect);
@@ -1479,6 +1484,13 @@ void BKE_mesh_looptri_get_real_edges(const Mesh *mesh, const MLoopTri *looptri,
 /* basic vertex data functions */
 bool BKE_mesh_minmax(const Mesh *me, float r_min[3], float r_max[3])
 {
+  if (me->runtime.vert_positions) {
+    for (int i = 0; i < me->totvert; i++) {
+      minmax_v3v3_v3(r_min, r_max, me->runtime.vert_positions[i]);
+    }
+    return (me->totvert != 0);
+  }
+
   int i = me->totvert;
   MVert *mvert;
   for (mvert = me->mvert; i--; mvert++) {
@@ -1491,7 +1503,8 @@ bool BKE_mesh_minmax(const Mesh *me, float r_min[3], float r_max[3])
 void BKE_mesh_transform(Mesh *me, const float mat[4][4], bool do_keys)
 {
   int i;
-  MVert *mvert = CustomData_duplicate_referenced_layer(&me->vdata, CD_MVERT, me->totvert);
+  BKE_mesh_runtime_vert_positions_flush(me);
+  MVert *mvert = BKE_mesh_runtime_verts_for_write(me);
   float(*lnors)[3] = CustomData_duplicate_referenced_layer(&me->ldata, CD_NORMAL, me->totloop);
 
   /* If the referenced l;ayer has been re-allocated need to update pointers stored in the mesh. */
@@ -1527,7 +1540,8 @@ void BKE_mesh_transform(Mesh *me, const float mat[4][4], bool do_keys)
 
 void BKE_mesh_translate(Mesh *me, const float offset[3], const bool do_keys)
 {
-  MVert *mvert = CustomData_duplicate_referenced_layer(&me->vdata, CD_MVERT, me->totvert);
+  BKE_mesh_runtime_vert_positions_flush(me);
+  MVert *mvert = BKE_mesh_runtime_verts_for_write(me);
   /* If the referenced layer has been re-allocated need to update pointers stored in the mesh. */
   BKE_mesh_update_customdata_pointers(me, false);
 
@@ -1744,6 +1758,10 @@ void BKE_mesh_count_selected_items(const Mesh *mesh, int r_count[3])
 
 void BKE_mesh_vert_coords_get(const Mesh *mesh, float (*vert_coords)[3])
 {
+  if (mesh->runtime.vert_positions) {
+    memcpy(vert_coords, mesh->runtime.vert_positions, sizeof(float[3]) * (size_t)mesh->totvert);
+    return;
+  }
   const MVert *mv = mesh->mvert;
   for (int i = 0; i < mesh->totvert; i++, mv++) {
     copy_v3_v3(vert_coords[i], mv->co);
@@ -1762,9 +1780,14 @@ float (*BKE_mesh_vert_coords_alloc(const Mesh *mesh, int *r_vert_len))[3]
 
 void BKE_mesh_vert_coords_apply(Mesh *mesh, const float (*vert_coords)[3])
 {
-  /* This will just return the pointer if it wasn't a referenced layer. */
-  MVert *mv = CustomData_duplicate_referenced_layer(&mesh->vdata, CD_MVERT, mesh->totvert);
-  mesh->mvert = mv;
+  if (vert_coords == (const float(*)[3])mesh->runtime.vert_positions) {
+    BKE_mesh_runtime_vert_positions_flush(mesh);
+    mesh->runtime.cd_dirty_vert |= CD_MASK_NORMAL;
+    return;
+  }
+  /* All positions are overwritten, the contiguous ones don't have to be written back. */
+  BKE_mesh_runtime_clear_vert_positions(mesh);
+  MVert *mv = BKE_mesh_runtime_verts_for_write(mesh);
   for (int i = 0; i < mesh->totvert; i++, mv++) {
     copy_v3_v3(mv->co, vert_coords[i]);
   }
@@ -1775,9 +1798,9 @@ void BKE_mesh_vert_coords_apply_with_mat4(Mesh *mesh,
                                           const float (*vert_coords)[3],
                                           const float mat[4][4])
 {
-  /* This will just return the pointer if it wasn't a referenced layer. */
-  MVert *mv = CustomData_duplicate_referenced_layer(&mesh->vdata, CD_MVERT, mesh->totvert);
-  mesh->mvert = mv;
+  BLI_assert(vert_coords != (const float(*)[3])mesh->runtime.vert_positions);
+  BKE_mesh_runtime_clear_vert_positions(mesh);
+  MVert *mv = BKE_mesh_runtime_verts_for_write(mesh);
   for (int i = 0; i < mesh->totvert; i++, mv++) {
     mul_v3_m4v3(mv->co, mat, vert_coords[i]);
   }
@@ -1786,9 +1809,7 @@ void BKE_mesh_vert_coords_apply_with_mat4(Mesh *mesh,
 
 void BKE_mesh_vert_normals_apply(Mesh *mesh, const short (*vert_normals)[3])
 {
-  /* This will just return the pointer if it wasn't a referenced layer. */
-  MVert *mv = CustomData_duplicate_referenced_layer(&mesh->vdata, CD_MVERT, mesh->totvert);
-  mesh->mvert = mv;
+  MVert *mv = BKE_mesh_runtime_verts_for_write(mesh);
   for (int i = 0; i < mesh->totvert; i++, mv++) {
     copy_v3_v3_short(mv->no, vert_normals[i]);
   }
@@ -1847,21 +1868,24 @@ void BKE_mesh_calc_normals_split_ex(Mesh *mesh, MLoopNorSpaceArray *r_lnors_spac
     free_polynors = true;
   }
 
-  BKE_mesh_normals_loop_split(mesh->mvert,
-                              mesh->totvert,
-                              mesh->medge,
-                              mesh->totedge,
-                              mesh->mloop,
-                              r_loopnors,
-                              mesh->totloop,
-                              mesh->mpoly,
-                              (const float(*)[3])polynors,
-                              mesh->totpoly,
-                              use_split_normals,
-                              split_angle,
-                              r_lnors_spacearr,
-                              clnors,
-                              NULL);
+  /* The vertex to loops map only depends on topology, share it with other users of the mesh. */
+  BKE_mesh_normals_loop_split_ex(mesh->mvert,
+                                 mesh->totvert,
+                                 mesh->medge,
+                                 mesh->totedge,
+                                 mesh->mloop,
+                                 r_loopnors,
+                                 mesh->totloop,
+                                 mesh->mpoly,
+                                 (const float(*)[3])polynors,
+                                 mesh->totpoly,
+                                 use_split_normals,
+                                 split_angle,
+                                 r_lnors_spacearr,
+                                 clnors,
+                                 NULL,
+                                 use_split_normals ? BKE_mesh_runtime_vert_loop_map_ensure(mesh) :
+                                                     NULL);
 
   if (free_polynors) {
     MEM_freeN(polynors);
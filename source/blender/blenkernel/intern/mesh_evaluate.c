@@ -49,6 +49,7 @@
 #include "BKE_editmesh_cache.h"
 #include "BKE_global.h"
 #include "BKE_mesh.h"
+#include "BKE_mesh_mapping.h"
 #include "BKE_multires.h"
 #include "BKE_report.h"
 
@@ -210,6 +211,8 @@ typedef struct MeshCalcNormalsData {
   const MPoly *mpolys;
   const MLoop *mloop;
   MVert *mverts;
+  /** Vertex positions read instead of #MVert.co when not NULL, see #Mesh_Runtime. */
+  const float (*vert_positions)[3];
   float (*pnors)[3];
   float (*lnors_weighted)[3];
   float (*vnors)[3];
@@ -233,6 +236,7 @@ static void mesh_calc_normals_poly_prepare_cb(void *__restrict userdata,
   const MPoly *mp = &data->mpolys[pidx];
   const MLoop *ml = &data->mloop[mp->loopstart];
   const MVert *mverts = data->mverts;
+  const float(*vert_positions)[3] = data->vert_positions;
 
   float pnor_temp[3];
   float *pnor = data->pnors ? data->pnors[pidx] : pnor_temp;
@@ -245,13 +249,13 @@ static void mesh_calc_normals_poly_prepare_cb(void *__restrict userdata,
   /* inline version of #BKE_mesh_calc_poly_normal, also does edge-vectors */
   {
     int i_prev = nverts - 1;
-    const float *v_prev = mverts[ml[i_prev].v].co;
+    const float *v_prev = vert_positions ? vert_positions[ml[i_prev].v] : mverts[ml[i_prev].v].co;
     const float *v_curr;
 
     zero_v3(pnor);
     /* Newell's Method */
     for (int i = 0; i < nverts; i++) {
-      v_curr = mverts[ml[i].v].co;
+      v_curr = vert_positions ? vert_positions[ml[i].v] : mverts[ml[i].v].co;
       add_newell_cross_v3_v3v3(pnor, v_prev, v_curr);
 
       /* Unrelated to normalize, calculate edge-vector */
@@ -299,21 +303,22 @@ static void mesh_calc_normals_poly_finalize_cb(void *__restrict userdata,
 
   if (UNLIKELY(normalize_v3(no) == 0.0f)) {
     /* following Mesh convention; we use vertex coordinate itself for normal in this case */
-    normalize_v3_v3(no, mv->co);
+    normalize_v3_v3(no, data->vert_positions ? data->vert_positions[vidx] : mv->co);
   }
 
   normal_float_to_short_v3(mv->no, no);
 }
 
-void BKE_mesh_calc_normals_poly(MVert *mverts,
-                                float (*r_vertnors)[3],
-                                int numVerts,
-                                const MLoop *mloop,
-                                const MPoly *mpolys,
-                                int numLoops,
-                                int numPolys,
-                                float (*r_polynors)[3],
-                                const bool only_face_normals)
+static void mesh_calc_normals_poly_ex(MVert *mverts,
+                                      const float (*vert_positions)[3],
+                                      float (*r_vertnors)[3],
+                                      int numVerts,
+                                      const MLoop *mloop,
+                                      const MPoly *mpolys,
+                                      int numLoops,
+                                      int numPolys,
+                                      float (*r_polynors)[3],
+                                      const bool only_face_normals)
 {
   float(*pnors)[3] = r_polynors;
 
@@ -324,6 +329,7 @@ void BKE_mesh_calc_normals_poly(MVert *mverts,
   if (only_face_normals) {
     BLI_assert((pnors != NULL) || (numPolys == 0));
     BLI_assert(r_vertnors == NULL);
+    BLI_assert(vert_positions == NULL);
 
     MeshCalcNormalsData data = {
         .mpolys = mpolys,
@@ -354,6 +360,7 @@ void BKE_mesh_calc_normals_poly(MVert *mverts,
       .mpolys = mpolys,
       .mloop = mloop,
       .mverts = mverts,
+      .vert_positions = vert_positions,
       .pnors = pnors,
       .lnors_weighted = lnors_weighted,
       .vnors = vnors,
@@ -379,6 +386,28 @@ void BKE_mesh_calc_normals_poly(MVert *mverts,
   MEM_freeN(lnors_weighted);
 }
 
+void BKE_mesh_calc_normals_poly(MVert *mverts,
+                                float (*r_vertnors)[3],
+                                int numVerts,
+                                const MLoop *mloop,
+                                const MPoly *mpolys,
+                                int numLoops,
+                                int numPolys,
+                                float (*r_polynors)[3],
+                                const bool only_face_normals)
+{
+  mesh_calc_normals_poly_ex(mverts,
+                            NULL,
+                            r_vertnors,
+                            numVerts,
+                            mloop,
+                            mpolys,
+                            numLoops,
+                            numPolys,
+                            r_polynors,
+                            only_face_normals);
+}
+
 void BKE_mesh_ensure_normals(Mesh *mesh)
 {
   if (mesh->runtime.cd_dirty_vert & CD_MASK_NORMAL) {
@@ -444,15 +473,17 @@ void BKE_mesh_calc_normals(Mesh *mesh)
 #ifdef DEBUG_TIME
   TIMEIT_START_AVERAGED(BKE_mesh_calc_normals);
 #endif
-  BKE_mesh_calc_normals_poly(mesh->mvert,
-                             NULL,
-                             mesh->totvert,
-                             mesh->mloop,
-                             mesh->mpoly,
-                             mesh->totloop,
-                             mesh->totpoly,
-                             NULL,
-                             false);
+  /* Read the contiguous positions of a mesh in the modifier stack, #MVert.co is out of date. */
+  mesh_calc_normals_poly_ex(mesh->mvert,
+                            (const float(*)[3])mesh->runtime.vert_positions,
+                            NULL,
+                            mesh->totvert,
+                            mesh->mloop,
+                            mesh->mpoly,
+                            mesh->totloop,
+                            mesh->totpoly,
+                            NULL,
+                            false);
 #ifdef DEBUG_TIME
   TIMEIT_END_AVERAGED(BKE_mesh_calc_normals);
 #endif
@@ -770,6 +801,7 @@ void BKE_lnor_space_custom_normal_to_data(MLoopNorSpace *lnor_space,
   }
 }
 
+/* Minimum amount of loops (or edges, vertices) handled by a single thread. */
 #define LOOP_SPLIT_TASK_BLOCK_SIZE 1024
 
 typedef struct LoopSplitTaskData {
@@ -809,124 +841,196 @@ typedef struct LoopSplitTaskDataCommon {
   int (*edge_to_loops)[2];
   int *loop_to_poly;
   const float (*polynors)[3];
+  const MeshElemMap *vert_to_loop;
+
+  /** #eLoopSplitFlag for each loop, each vertex only ever touches the flags of its own loops. */
+  char *loop_flags;
 
+  int numVerts;
   int numEdges;
   int numLoops;
   int numPolys;
 } LoopSplitTaskDataCommon;
 
+/** #LoopSplitTaskDataCommon.loop_flags */
+typedef enum eLoopSplitFlag {
+  /** Loop already walked by a cyclic smooth fan check. */
+  LOOP_SPLIT_SKIP = 1 << 0,
+  /** Loop is the only one of its lnor space (both its edges are sharp). */
+  LOOP_SPLIT_SINGLE = 1 << 1,
+  /** Loop is the entry point of a smooth fan. */
+  LOOP_SPLIT_FAN = 1 << 2,
+} eLoopSplitFlag;
+
+#define LOOP_SPLIT_ENTRY (LOOP_SPLIT_SINGLE | LOOP_SPLIT_FAN)
+
 #define INDEX_UNSET INT_MIN
 #define INDEX_INVALID -1
 /* See comment about edge_to_loops below. */
 #define IS_EDGE_SHARP(_e2l) (ELEM((_e2l)[1], INDEX_UNSET, INDEX_INVALID))
 
-static void mesh_edges_sharp_tag(LoopSplitTaskDataCommon *data,
-                                 const bool check_angle,
-                                 const float split_angle,
-                                 const bool do_sharp_edges_tag)
+/**
+ * Whether loop \a ml_index_a comes before loop \a ml_index_b when walking polygons in order,
+ * which is the order used to decide which loop is the 'first' one of an edge.
+ */
+BLI_INLINE bool loop_split_loop_is_before(const int *loop_to_poly,
+                                          const int ml_index_a,
+                                          const int ml_index_b)
 {
-  const MVert *mverts = data->mverts;
-  const MEdge *medges = data->medges;
-  const MLoop *mloops = data->mloops;
+  return (loop_to_poly[ml_index_a] < loop_to_poly[ml_index_b]) ||
+         (loop_to_poly[ml_index_a] == loop_to_poly[ml_index_b] && ml_index_a < ml_index_b);
+}
 
-  const MPoly *mpolys = data->mpolys;
+BLI_INLINE int loop_split_loop_prev_index(const MPoly *mp, const int ml_index)
+{
+  return (ml_index == mp->loopstart) ? (mp->loopstart + mp->totloop - 1) : (ml_index - 1);
+}
 
-  const int numEdges = data->numEdges;
-  const int numPolys = data->numPolys;
+typedef struct EdgesSharpTagData {
+  LoopSplitTaskDataCommon *common_data;
+  float split_angle_cos;
+  bool check_angle;
+  bool do_sharp_edges_tag;
+} EdgesSharpTagData;
 
+static void mesh_edges_sharp_tag_poly_cb(void *__restrict userdata,
+                                         const int mp_index,
+                                         const TaskParallelTLS *__restrict UNUSED(tls))
+{
+  LoopSplitTaskDataCommon *data = userdata;
+  const MVert *mverts = data->mverts;
+  const MLoop *mloops = data->mloops;
+  const MPoly *mp = &data->mpolys[mp_index];
   float(*loopnors)[3] = data->loopnors; /* Note: loopnors may be NULL here. */
-  const float(*polynors)[3] = data->polynors;
-
-  int(*edge_to_loops)[2] = data->edge_to_loops;
   int *loop_to_poly = data->loop_to_poly;
 
-  BLI_bitmap *sharp_edges = do_sharp_edges_tag ? BLI_BITMAP_NEW(numEdges, __func__) : NULL;
+  const int ml_last_index = (mp->loopstart + mp->totloop) - 1;
+  for (int ml_index = mp->loopstart; ml_index <= ml_last_index; ml_index++) {
+    loop_to_poly[ml_index] = mp_index;
 
-  const MPoly *mp;
-  int mp_index;
-
-  const float split_angle_cos = check_angle ? cosf(split_angle) : -1.0f;
-
-  for (mp = mpolys, mp_index = 0; mp_index < numPolys; mp++, mp_index++) {
-    const MLoop *ml_curr;
-    int *e2l;
-    int ml_curr_index = mp->loopstart;
-    const int ml_last_index = (ml_curr_index + mp->totloop) - 1;
-
-    ml_curr = &mloops[ml_curr_index];
-
-    for (; ml_curr_index <= ml_last_index; ml_curr++, ml_curr_index++) {
-      e2l = edge_to_loops[ml_curr->e];
+    /* Pre-populate all loop normals as if their verts were all-smooth,
+     * this way we don't have to compute those later!
+     */
+    if (loopnors) {
+      normal_short_to_float_v3(loopnors[ml_index], mverts[mloops[ml_index].v].no);
+    }
+  }
+}
 
-      loop_to_poly[ml_curr_index] = mp_index;
+static void mesh_edges_sharp_tag_edge_cb(void *__restrict userdata,
+                                         const int me_index,
+                                         const TaskParallelTLS *__restrict UNUSED(tls))
+{
+  const EdgesSharpTagData *tag_data = userdata;
+  const LoopSplitTaskDataCommon *data = tag_data->common_data;
 
-      /* Pre-populate all loop normals as if their verts were all-smooth,
-       * this way we don't have to compute those later!
-       */
-      if (loopnors) {
-        normal_short_to_float_v3(loopnors[ml_curr_index], mverts[ml_curr->v].no);
+  const MLoop *mloops = data->mloops;
+  const MPoly *mpolys = data->mpolys;
+  const float(*polynors)[3] = data->polynors;
+  const int *loop_to_poly = data->loop_to_poly;
+  const MeshElemMap *vert_to_loop = data->vert_to_loop;
+
+  MEdge *me = (MEdge *)&data->medges[me_index];
+  int *e2l = data->edge_to_loops[me_index];
+
+  /* Find the loops using this edge among the loops of its vertices, keeping the first two of them
+   * in polygon order, which is the order in which their sharpness used to be evaluated. */
+  const unsigned int me_verts[2] = {me->v1, me->v2};
+  const int me_verts_len = (me->v1 == me->v2) ? 1 : 2;
+  int ml_first_index = -1, ml_second_index = -1;
+  int loops_len = 0;
+
+  for (int i = 0; i < me_verts_len; i++) {
+    const MeshElemMap *map = &vert_to_loop[me_verts[i]];
+    for (int j = 0; j < map->count; j++) {
+      const int ml_index = map->indices[j];
+      if (mloops[ml_index].e != (unsigned int)me_index) {
+        continue;
       }
-
-      /* Check whether current edge might be smooth or sharp */
-      if ((e2l[0] | e2l[1]) == 0) {
-        /* 'Empty' edge until now, set e2l[0] (and e2l[1] to INDEX_UNSET to tag it as unset). */
-        e2l[0] = ml_curr_index;
-        /* We have to check this here too, else we might miss some flat faces!!! */
-        e2l[1] = (mp->flag & ME_SMOOTH) ? INDEX_UNSET : INDEX_INVALID;
+      loops_len++;
+      if (ml_first_index == -1 ||
+          loop_split_loop_is_before(loop_to_poly, ml_index, ml_first_index)) {
+        ml_second_index = ml_first_index;
+        ml_first_index = ml_index;
       }
-      else if (e2l[1] == INDEX_UNSET) {
-        const bool is_angle_sharp = (check_angle &&
-                                     dot_v3v3(polynors[loop_to_poly[e2l[0]]], polynors[mp_index]) <
-                                         split_angle_cos);
-
-        /* Second loop using this edge, time to test its sharpness.
-         * An edge is sharp if it is tagged as such, or its face is not smooth,
-         * or both poly have opposed (flipped) normals, i.e. both loops on the same edge share the
-         * same vertex, or angle between both its polys' normals is above split_angle value.
-         */
-        if (!(mp->flag & ME_SMOOTH) || (medges[ml_curr->e].flag & ME_SHARP) ||
-            ml_curr->v == mloops[e2l[0]].v || is_angle_sharp) {
-          /* Note: we are sure that loop != 0 here ;) */
-          e2l[1] = INDEX_INVALID;
-
-          /* We want to avoid tagging edges as sharp when it is already defined as such by
-           * other causes than angle threshold... */
-          if (do_sharp_edges_tag && is_angle_sharp) {
-            BLI_BITMAP_SET(sharp_edges, ml_curr->e, true);
-          }
-        }
-        else {
-          e2l[1] = ml_curr_index;
-        }
+      else if (ml_second_index == -1 ||
+               loop_split_loop_is_before(loop_to_poly, ml_index, ml_second_index)) {
+        ml_second_index = ml_index;
       }
-      else if (!IS_EDGE_SHARP(e2l)) {
-        /* More than two loops using this edge, tag as sharp if not yet done. */
-        e2l[1] = INDEX_INVALID;
-
-        /* We want to avoid tagging edges as sharp when it is already defined as such by
-         * other causes than angle threshold... */
-        if (do_sharp_edges_tag) {
-          BLI_BITMAP_SET(sharp_edges, ml_curr->e, false);
-        }
-      }
-      /* Else, edge is already 'disqualified' (i.e. sharp)! */
     }
   }
 
-  /* If requested, do actual tagging of edges as sharp in another loop. */
-  if (do_sharp_edges_tag) {
-    MEdge *me;
-    int me_index;
-    for (me = (MEdge *)medges, me_index = 0; me_index < numEdges; me++, me_index++) {
-      if (BLI_BITMAP_TEST(sharp_edges, me_index)) {
-        me->flag |= ME_SHARP;
-      }
-    }
+  if (loops_len == 0) {
+    /* Loose edge, both values are set to 0. */
+    e2l[0] = e2l[1] = 0;
+    return;
+  }
+
+  e2l[0] = ml_first_index;
 
-    MEM_freeN(sharp_edges);
+  /* We have to check this here too, else we might miss some flat faces!!! */
+  if (!(mpolys[loop_to_poly[ml_first_index]].flag & ME_SMOOTH)) {
+    e2l[1] = INDEX_INVALID;
+    return;
+  }
+  if (loops_len == 1) {
+    e2l[1] = INDEX_UNSET;
+    return;
+  }
+  const int mp_first_index = loop_to_poly[ml_first_index];
+  const int mp_second_index = loop_to_poly[ml_second_index];
+  const bool is_angle_sharp = (tag_data->check_angle &&
+                               dot_v3v3(polynors[mp_first_index], polynors[mp_second_index]) <
+                                   tag_data->split_angle_cos);
+
+  /* Test sharpness from the first two loops using this edge.
+   * An edge is sharp if it is tagged as such, or its face is not smooth,
+   * or both poly have opposed (flipped) normals, i.e. both loops on the same edge share the
+   * same vertex, or angle between both its polys' normals is above split_angle value.
+   */
+  if (!(mpolys[mp_second_index].flag & ME_SMOOTH) || (me->flag & ME_SHARP) ||
+      mloops[ml_second_index].v == mloops[ml_first_index].v || is_angle_sharp) {
+    e2l[1] = INDEX_INVALID;
+
+    /* We want to avoid tagging edges as sharp when it is already defined as such by
+     * other causes than angle threshold... */
+    if (tag_data->do_sharp_edges_tag && is_angle_sharp) {
+      me->flag |= ME_SHARP;
+    }
+  }
+  else {
+    /* More than two loops using this edge, tag as sharp. */
+    e2l[1] = (loops_len > 2) ? INDEX_INVALID : ml_second_index;
   }
 }
 
+/**
+ * Fill \a loop_to_poly and \a edge_to_loops, classifying each edge as smooth or sharp.
+ *
+ * Each edge is handled independently from the loops of its two vertices
+ * (\a vert_to_loop map), so both passes run in parallel.
+ */
+static void mesh_edges_sharp_tag(LoopSplitTaskDataCommon *data,
+                                 const bool check_angle,
+                                 const float split_angle,
+                                 const bool do_sharp_edges_tag)
+{
+  EdgesSharpTagData tag_data = {
+      .common_data = data,
+      .split_angle_cos = check_angle ? cosf(split_angle) : -1.0f,
+      .check_angle = check_angle,
+      .do_sharp_edges_tag = do_sharp_edges_tag,
+  };
+
+  TaskParallelSettings settings;
+  BLI_parallel_range_settings_defaults(&settings);
+  settings.use_threading = (data->numLoops >= LOOP_SPLIT_TASK_BLOCK_SIZE * 8);
+  settings.min_iter_per_thread = LOOP_SPLIT_TASK_BLOCK_SIZE;
+
+  BLI_task_parallel_range(0, data->numPolys, data, mesh_edges_sharp_tag_poly_cb, &settings);
+  BLI_task_parallel_range(0, data->numEdges, &tag_data, mesh_edges_sharp_tag_edge_cb, &settings);
+}
+
 /**
  * Define sharp edges as needed to mimic 'autosmooth' from angle threshold.
  *
@@ -934,7 +1038,7 @@ static void mesh_edges_sharp_tag(LoopSplitTaskDataCommon *data,
  * to keep same shading as with autosmooth!
  */
 void BKE_edges_sharp_from_angle_set(const struct MVert *mverts,
-                                    const int UNUSED(numVerts),
+                                    const int numVerts,
                                     struct MEdge *medges,
                                     const int numEdges,
                                     struct MLoop *mloops,
@@ -950,11 +1054,16 @@ void BKE_edges_sharp_from_angle_set(const struct MVert *mverts,
   }
 
   /* Mapping edge -> loops. See BKE_mesh_normals_loop_split() for details. */
-  int(*edge_to_loops)[2] = MEM_calloc_arrayN((size_t)numEdges, sizeof(*edge_to_loops), __func__);
+  int(*edge_to_loops)[2] = MEM_malloc_arrayN((size_t)numEdges, sizeof(*edge_to_loops), __func__);
 
   /* Simple mapping from a loop to its polygon index. */
   int *loop_to_poly = MEM_malloc_arrayN((size_t)numLoops, sizeof(*loop_to_poly), __func__);
 
+  MeshElemMap *vert_to_loop;
+  int *vert_to_loop_mem;
+  BKE_mesh_vert_loop_map_create(
+      &vert_to_loop, &vert_to_loop_mem, mpolys, mloops, numVerts, numPolys, numLoops);
+
   LoopSplitTaskDataCommon common_data = {
       .mverts = mverts,
       .medges = medges,
@@ -963,7 +1072,10 @@ void BKE_edges_sharp_from_angle_set(const struct MVert *mverts,
       .edge_to_loops = edge_to_loops,
       .loop_to_poly = loop_to_poly,
       .polynors = polynors,
+      .vert_to_loop = vert_to_loop,
+      .numVerts = numVerts,
       .numEdges = numEdges,
+      .numLoops = numLoops,
       .numPolys = numPolys,
   };
 
@@ -971,6 +1083,8 @@ void BKE_edges_sharp_from_angle_set(const struct MVert *mverts,
 
   MEM_freeN(edge_to_loops);
   MEM_freeN(loop_to_poly);
+  MEM_freeN(vert_to_loop);
+  MEM_freeN(vert_to_loop_mem);
 }
 
 void BKE_mesh_loop_manifold_fan_around_vert_next(const MLoop *mloops,
@@ -1296,54 +1410,6 @@ static void split_loop_nor_fan_do(LoopSplitTaskDataCommon *common_data, LoopSpli
   }
 }
 
-static void loop_split_worker_do(LoopSplitTaskDataCommon *common_data,
-                                 LoopSplitTaskData *data,
-                                 BLI_Stack *edge_vectors)
-{
-  BLI_assert(data->ml_curr);
-  if (data->e2l_prev) {
-    BLI_assert((edge_vectors == NULL) || BLI_stack_is_empty(edge_vectors));
-    data->edge_vectors = edge_vectors;
-    split_loop_nor_fan_do(common_data, data);
-  }
-  else {
-    /* No need for edge_vectors for 'single' case! */
-    split_loop_nor_single_do(common_data, data);
-  }
-}
-
-static void loop_split_worker(TaskPool *__restrict pool, void *taskdata)
-{
-  LoopSplitTaskDataCommon *common_data = BLI_task_pool_user_data(pool);
-  LoopSplitTaskData *data = taskdata;
-
-  /* Temp edge vectors stack, only used when computing lnor spacearr. */
-  BLI_Stack *edge_vectors = common_data->lnors_spacearr ?
-                                BLI_stack_new(sizeof(float[3]), __func__) :
-                                NULL;
-
-#ifdef DEBUG_TIME
-  TIMEIT_START_AVERAGED(loop_split_worker);
-#endif
-
-  for (int i = 0; i < LOOP_SPLIT_TASK_BLOCK_SIZE; i++, data++) {
-    /* A NULL ml_curr is used to tag ended data! */
-    if (data->ml_curr == NULL) {
-      break;
-    }
-
-    loop_split_worker_do(common_data, data, edge_vectors);
-  }
-
-  if (edge_vectors) {
-    BLI_stack_free(edge_vectors);
-  }
-
-#ifdef DEBUG_TIME
-  TIMEIT_END_AVERAGED(loop_split_worker);
-#endif
-}
-
 /**
  * Check whether given loop is part of an unknown-so-far cyclic smooth fan, or not.
  * Needed because cyclic smooth fans have no obvious 'entry point',
@@ -1354,7 +1420,7 @@ static bool loop_split_generator_check_cyclic_smooth_fan(const MLoop *mloops,
                                                          const int (*edge_to_loops)[2],
                                                          const int *loop_to_poly,
                                                          const int *e2l_prev,
-                                                         BLI_bitmap *skip_loops,
+                                                         char *loop_flags,
                                                          const MLoop *ml_curr,
                                                          const MLoop *ml_prev,
                                                          const int ml_curr_index,
@@ -1382,8 +1448,8 @@ static bool loop_split_generator_check_cyclic_smooth_fan(const MLoop *mloops,
   BLI_assert(mlfan_vert_index >= 0);
   BLI_assert(mpfan_curr_index >= 0);
 
-  BLI_assert(!BLI_BITMAP_TEST(skip_loops, mlfan_vert_index));
-  BLI_BITMAP_ENABLE(skip_loops, mlfan_vert_index);
+  BLI_assert(!(loop_flags[mlfan_vert_index] & LOOP_SPLIT_SKIP));
+  loop_flags[mlfan_vert_index] |= LOOP_SPLIT_SKIP;
 
   while (true) {
     /* Find next loop of the smooth fan. */
@@ -1404,7 +1470,7 @@ static bool loop_split_generator_check_cyclic_smooth_fan(const MLoop *mloops,
       return false;
     }
     /* Smooth loop/edge... */
-    if (BLI_BITMAP_TEST(skip_loops, mlfan_vert_index)) {
+    if (loop_flags[mlfan_vert_index] & LOOP_SPLIT_SKIP) {
       if (mlfan_vert_index == ml_curr_index) {
         /* We walked around a whole cyclic smooth fan without finding any already-processed loop,
          * means we can use initial ml_curr/ml_prev edge as start for this smooth fan. */
@@ -1415,181 +1481,199 @@ static bool loop_split_generator_check_cyclic_smooth_fan(const MLoop *mloops,
     }
 
     /* ... we can skip it in future, and keep checking the smooth fan. */
-    BLI_BITMAP_ENABLE(skip_loops, mlfan_vert_index);
+    loop_flags[mlfan_vert_index] |= LOOP_SPLIT_SKIP;
   }
 }
 
-static void loop_split_generator(TaskPool *pool, LoopSplitTaskDataCommon *common_data)
+/**
+ * Find the loops which start a smooth fan or a single lnor space around given vertex.
+ *
+ * All loops of a fan share its pivot vertex, so vertices are independent from each other.
+ * Loops of the vertex are visited in polygon order, so cyclic smooth fans get the same
+ * entry loop as when walking the whole mesh serially.
+ */
+static void loop_split_generator_vert_cb(void *__restrict userdata,
+                                         const int mv_index,
+                                         const TaskParallelTLS *__restrict UNUSED(tls))
 {
-  MLoopNorSpaceArray *lnors_spacearr = common_data->lnors_spacearr;
-  float(*loopnors)[3] = common_data->loopnors;
-
+  LoopSplitTaskDataCommon *common_data = userdata;
   const MLoop *mloops = common_data->mloops;
   const MPoly *mpolys = common_data->mpolys;
   const int *loop_to_poly = common_data->loop_to_poly;
   const int(*edge_to_loops)[2] = common_data->edge_to_loops;
-  const int numLoops = common_data->numLoops;
-  const int numPolys = common_data->numPolys;
-
-  const MPoly *mp;
-  int mp_index;
-
-  const MLoop *ml_curr;
-  const MLoop *ml_prev;
-  int ml_curr_index;
-  int ml_prev_index;
+  char *loop_flags = common_data->loop_flags;
+
+  const MeshElemMap *map = &common_data->vert_to_loop[mv_index];
+
+  for (int i = 0; i < map->count; i++) {
+    const int ml_curr_index = map->indices[i];
+    const int mp_index = loop_to_poly[ml_curr_index];
+    const int ml_prev_index = loop_split_loop_prev_index(&mpolys[mp_index], ml_curr_index);
+    const MLoop *ml_curr = &mloops[ml_curr_index];
+    const MLoop *ml_prev = &mloops[ml_prev_index];
+    const int *e2l_curr = edge_to_loops[ml_curr->e];
+    const int *e2l_prev = edge_to_loops[ml_prev->e];
+
+    /* A smooth edge, we have to check for cyclic smooth fan case.
+     * If we find a new, never-processed cyclic smooth fan, we can do it now using that loop/edge
+     * as 'entry point', otherwise we can skip it. */
+
+    /* Note: In theory, we could make loop_split_generator_check_cyclic_smooth_fan() store
+     * mlfan_vert_index'es and edge indexes in two stacks, to avoid having to fan again around
+     * the vert during actual computation of clnor & clnorspace. However, this would complicate
+     * the code, add more memory usage, and despite its logical complexity,
+     * loop_manifold_fan_around_vert_next() is quite cheap in term of CPU cycles,
+     * so really think it's not worth it. */
+    if (!IS_EDGE_SHARP(e2l_curr) && ((loop_flags[ml_curr_index] & LOOP_SPLIT_SKIP) ||
+                                     !loop_split_generator_check_cyclic_smooth_fan(mloops,
+                                                                                   mpolys,
+                                                                                   edge_to_loops,
+                                                                                   loop_to_poly,
+                                                                                   e2l_prev,
+                                                                                   loop_flags,
+                                                                                   ml_curr,
+                                                                                   ml_prev,
+                                                                                   ml_curr_index,
+                                                                                   ml_prev_index,
+                                                                                   mp_index))) {
+      continue;
+    }
 
-  BLI_bitmap *skip_loops = BLI_BITMAP_NEW(numLoops, __func__);
+    /* We *do not need* to check/tag loops as already computed!
+     * Due to the fact a loop only links to one of its two edges,
+     * a same fan *will never be walked more than once!*
+     * Since we consider edges having neighbor polys with inverted
+     * (flipped) normals as sharp, we are sure that no fan will be skipped,
+     * even only considering the case (sharp curr_edge, smooth prev_edge),
+     * and not the alternative (smooth curr_edge, sharp prev_edge).
+     * All this due/thanks to link between normals and loop ordering (i.e. winding).
+     */
+    loop_flags[ml_curr_index] |= (IS_EDGE_SHARP(e2l_curr) && IS_EDGE_SHARP(e2l_prev)) ?
+                                     LOOP_SPLIT_SINGLE :
+                                     LOOP_SPLIT_FAN;
+  }
+}
 
-  LoopSplitTaskData *data_buff = NULL;
-  int data_idx = 0;
+/**
+ * Create the lnor spaces of all fans found by #loop_split_generator_vert_cb in a single block,
+ * since the memarena cannot be used from worker threads.
+ * Each space is stored in its entry loop, where the workers will find it.
+ */
+static void loop_split_generator_lnor_spaces_create(LoopSplitTaskDataCommon *common_data)
+{
+  MLoopNorSpaceArray *lnors_spacearr = common_data->lnors_spacearr;
+  const char *loop_flags = common_data->loop_flags;
+  const int numLoops = common_data->numLoops;
 
-  /* Temp edge vectors stack, only used when computing lnor spacearr
-   * (and we are not multi-threading). */
-  BLI_Stack *edge_vectors = NULL;
+  int spaces_len = 0;
+  for (int ml_index = 0; ml_index < numLoops; ml_index++) {
+    if (loop_flags[ml_index] & LOOP_SPLIT_ENTRY) {
+      spaces_len++;
+    }
+  }
+  if (spaces_len == 0) {
+    return;
+  }
 
-#ifdef DEBUG_TIME
-  TIMEIT_START_AVERAGED(loop_split_generator);
-#endif
+  MLoopNorSpace *lnor_space = BLI_memarena_calloc(lnors_spacearr->mem,
+                                                  sizeof(*lnor_space) * (size_t)spaces_len);
+  lnors_spacearr->num_spaces += spaces_len;
 
-  if (!pool) {
-    if (lnors_spacearr) {
-      edge_vectors = BLI_stack_new(sizeof(float[3]), __func__);
+  for (int ml_index = 0; ml_index < numLoops; ml_index++) {
+    if (loop_flags[ml_index] & LOOP_SPLIT_ENTRY) {
+      lnors_spacearr->lspacearr[ml_index] = lnor_space++;
     }
   }
+}
 
-  /* We now know edges that can be smoothed (with their vector, and their two loops),
-   * and edges that will be hard! Now, time to generate the normals.
-   */
-  for (mp = mpolys, mp_index = 0; mp_index < numPolys; mp++, mp_index++) {
-    float(*lnors)[3];
-    const int ml_last_index = (mp->loopstart + mp->totloop) - 1;
-    ml_curr_index = mp->loopstart;
-    ml_prev_index = ml_last_index;
+typedef struct LoopSplitWorkerTLS {
+  /** Temp edge vectors stack, only used when computing lnor spacearr. */
+  BLI_Stack *edge_vectors;
+} LoopSplitWorkerTLS;
 
-    ml_curr = &mloops[ml_curr_index];
-    ml_prev = &mloops[ml_prev_index];
-    lnors = &loopnors[ml_curr_index];
+static void loop_split_worker_cb(void *__restrict userdata,
+                                 const int ml_curr_index,
+                                 const TaskParallelTLS *__restrict tls)
+{
+  LoopSplitTaskDataCommon *common_data = userdata;
+  const char loop_flag = common_data->loop_flags[ml_curr_index];
 
-    for (; ml_curr_index <= ml_last_index; ml_curr++, ml_curr_index++, lnors++) {
-      const int *e2l_curr = edge_to_loops[ml_curr->e];
-      const int *e2l_prev = edge_to_loops[ml_prev->e];
+  if (!(loop_flag & LOOP_SPLIT_ENTRY)) {
+    return;
+  }
 
-#if 0
-      printf("Checking loop %d / edge %u / vert %u (sharp edge: %d, skiploop: %d)...",
-             ml_curr_index,
-             ml_curr->e,
-             ml_curr->v,
-             IS_EDGE_SHARP(e2l_curr),
-             BLI_BITMAP_TEST_BOOL(skip_loops, ml_curr_index));
-#endif
+  MLoopNorSpaceArray *lnors_spacearr = common_data->lnors_spacearr;
+  const MLoop *mloops = common_data->mloops;
+  const int mp_index = common_data->loop_to_poly[ml_curr_index];
+  const int ml_prev_index = loop_split_loop_prev_index(&common_data->mpolys[mp_index],
+                                                       ml_curr_index);
+
+  LoopSplitTaskData data = {
+      .lnor_space = lnors_spacearr ? lnors_spacearr->lspacearr[ml_curr_index] : NULL,
+      .ml_curr = &mloops[ml_curr_index],
+      .ml_prev = &mloops[ml_prev_index],
+      .ml_curr_index = ml_curr_index,
+      .ml_prev_index = ml_prev_index,
+      .mp_index = mp_index,
+  };
 
-      /* A smooth edge, we have to check for cyclic smooth fan case.
-       * If we find a new, never-processed cyclic smooth fan, we can do it now using that loop/edge
-       * as 'entry point', otherwise we can skip it. */
-
-      /* Note: In theory, we could make loop_split_generator_check_cyclic_smooth_fan() store
-       * mlfan_vert_index'es and edge indexes in two stacks, to avoid having to fan again around
-       * the vert during actual computation of clnor & clnorspace. However, this would complicate
-       * the code, add more memory usage, and despite its logical complexity,
-       * loop_manifold_fan_around_vert_next() is quite cheap in term of CPU cycles,
-       * so really think it's not worth it. */
-      if (!IS_EDGE_SHARP(e2l_curr) && (BLI_BITMAP_TEST(skip_loops, ml_curr_index) ||
-                                       !loop_split_generator_check_cyclic_smooth_fan(mloops,
-                                                                                     mpolys,
-                                                                                     edge_to_loops,
-                                                                                     loop_to_poly,
-                                                                                     e2l_prev,
-                                                                                     skip_loops,
-                                                                                     ml_curr,
-                                                                                     ml_prev,
-                                                                                     ml_curr_index,
-                                                                                     ml_prev_index,
-                                                                                     mp_index))) {
-        //              printf("SKIPPING!\n");
-      }
-      else {
-        LoopSplitTaskData *data, data_local;
+  if (loop_flag & LOOP_SPLIT_SINGLE) {
+    data.lnor = &common_data->loopnors[ml_curr_index];
+    /* No need for edge_vectors for 'single' case! */
+    split_loop_nor_single_do(common_data, &data);
+  }
+  else {
+    LoopSplitWorkerTLS *worker_tls = tls->userdata_chunk;
+    if (lnors_spacearr && worker_tls->edge_vectors == NULL) {
+      worker_tls->edge_vectors = BLI_stack_new(sizeof(float[3]), __func__);
+    }
+    BLI_assert((worker_tls->edge_vectors == NULL) || BLI_stack_is_empty(worker_tls->edge_vectors));
 
-        //              printf("PROCESSING!\n");
+    data.e2l_prev = common_data->edge_to_loops[data.ml_prev->e];
+    data.edge_vectors = worker_tls->edge_vectors;
+    split_loop_nor_fan_do(common_data, &data);
+  }
+}
 
-        if (pool) {
-          if (data_idx == 0) {
-            data_buff = MEM_calloc_arrayN(
-                LOOP_SPLIT_TASK_BLOCK_SIZE, sizeof(*data_buff), __func__);
-          }
-          data = &data_buff[data_idx];
-        }
-        else {
-          data = &data_local;
-          memset(data, 0, sizeof(*data));
-        }
+static void loop_split_worker_free(const void *__restrict UNUSED(userdata),
+                                   void *__restrict chunk)
+{
+  LoopSplitWorkerTLS *worker_tls = chunk;
+  if (worker_tls->edge_vectors) {
+    BLI_stack_free(worker_tls->edge_vectors);
+  }
+}
 
-        if (IS_EDGE_SHARP(e2l_curr) && IS_EDGE_SHARP(e2l_prev)) {
-          data->lnor = lnors;
-          data->ml_curr = ml_curr;
-          data->ml_prev = ml_prev;
-          data->ml_curr_index = ml_curr_index;
-#if 0 /* Not needed for 'single' loop. */
-          data->ml_prev_index = ml_prev_index;
-          data->e2l_prev = NULL; /* Tag as 'single' task. */
-#endif
-          data->mp_index = mp_index;
-          if (lnors_spacearr) {
-            data->lnor_space = BKE_lnor_space_create(lnors_spacearr);
-          }
-        }
-        /* We *do not need* to check/tag loops as already computed!
-         * Due to the fact a loop only links to one of its two edges,
-         * a same fan *will never be walked more than once!*
-         * Since we consider edges having neighbor polys with inverted
-         * (flipped) normals as sharp, we are sure that no fan will be skipped,
-         * even only considering the case (sharp curr_edge, smooth prev_edge),
-         * and not the alternative (smooth curr_edge, sharp prev_edge).
-         * All this due/thanks to link between normals and loop ordering (i.e. winding).
-         */
-        else {
-#if 0 /* Not needed for 'fan' loops. */
-          data->lnor = lnors;
+/**
+ * Compute all loop normals (and their lnor spaces if needed) in three data-parallel passes:
+ * fan detection per vertex, lnor spaces allocation, and normal accumulation per fan.
+ */
+static void loop_split_generator(LoopSplitTaskDataCommon *common_data)
+{
+#ifdef DEBUG_TIME
+  TIMEIT_START_AVERAGED(loop_split_generator);
 #endif
-          data->ml_curr = ml_curr;
-          data->ml_prev = ml_prev;
-          data->ml_curr_index = ml_curr_index;
-          data->ml_prev_index = ml_prev_index;
-          data->e2l_prev = e2l_prev; /* Also tag as 'fan' task. */
-          data->mp_index = mp_index;
-          if (lnors_spacearr) {
-            data->lnor_space = BKE_lnor_space_create(lnors_spacearr);
-          }
-        }
 
-        if (pool) {
-          data_idx++;
-          if (data_idx == LOOP_SPLIT_TASK_BLOCK_SIZE) {
-            BLI_task_pool_push(pool, loop_split_worker, data_buff, true, NULL);
-            data_idx = 0;
-          }
-        }
-        else {
-          loop_split_worker_do(common_data, data, edge_vectors);
-        }
-      }
+  TaskParallelSettings settings;
+  BLI_parallel_range_settings_defaults(&settings);
+  settings.use_threading = (common_data->numLoops >= LOOP_SPLIT_TASK_BLOCK_SIZE * 8);
+  settings.min_iter_per_thread = LOOP_SPLIT_TASK_BLOCK_SIZE;
 
-      ml_prev = ml_curr;
-      ml_prev_index = ml_curr_index;
-    }
-  }
+  /* We now know edges that can be smoothed (with their vector, and their two loops),
+   * and edges that will be hard! Now, time to find the fans and generate the normals.
+   */
+  BLI_task_parallel_range(
+      0, common_data->numVerts, common_data, loop_split_generator_vert_cb, &settings);
 
-  /* Last block of data... Since it is calloc'ed and we use first NULL item as stopper,
-   * everything is fine. */
-  if (pool && data_idx) {
-    BLI_task_pool_push(pool, loop_split_worker, data_buff, true, NULL);
+  if (common_data->lnors_spacearr) {
+    loop_split_generator_lnor_spaces_create(common_data);
   }
 
-  if (edge_vectors) {
-    BLI_stack_free(edge_vectors);
-  }
-  MEM_freeN(skip_loops);
+  LoopSplitWorkerTLS worker_tls = {NULL};
+  settings.userdata_chunk = &worker_tls;
+  settings.userdata_chunk_size = sizeof(worker_tls);
+  settings.func_free = loop_split_worker_free;
+  BLI_task_parallel_range(0, common_data->numLoops, common_data, loop_split_worker_cb, &settings);
 
 #ifdef DEBUG_TIME
   TIMEIT_END_AVERAGED(loop_split_generator);
@@ -1600,22 +1684,26 @@ static void loop_split_generator(TaskPool *pool, LoopSplitTaskDataCommon *common
  * Compute split normals, i.e. vertex normals associated with each poly (hence 'loop normals').
  * Useful to materialize sharp edges (or non-smooth faces) without actually modifying the geometry
  * (splitting edges).
+ *
+ * \param vert_to_loop: Optional vertex to loops map (see #BKE_mesh_vert_loop_map_create),
+ * e.g. from the topology cache of the mesh. Computed here when NULL.
  */
-void BKE_mesh_normals_loop_split(const MVert *mverts,
-                                 const int UNUSED(numVerts),
-                                 MEdge *medges,
-                                 const int numEdges,
-                                 MLoop *mloops,
-                                 float (*r_loopnors)[3],
-                                 const int numLoops,
-                                 MPoly *mpolys,
-                                 const float (*polynors)[3],
-                                 const int numPolys,
-                                 const bool use_split_normals,
-                                 const float split_angle,
-                                 MLoopNorSpaceArray *r_lnors_spacearr,
-                                 short (*clnors_data)[2],
-                                 int *r_loop_to_poly)
+void BKE_mesh_normals_loop_split_ex(const MVert *mverts,
+                                    const int numVerts,
+                                    MEdge *medges,
+                                    const int numEdges,
+                                    MLoop *mloops,
+                                    float (*r_loopnors)[3],
+                                    const int numLoops,
+                                    MPoly *mpolys,
+                                    const float (*polynors)[3],
+                                    const int numPolys,
+                                    const bool use_split_normals,
+                                    const float split_angle,
+                                    MLoopNorSpaceArray *r_lnors_spacearr,
+                                    short (*clnors_data)[2],
+                                    int *r_loop_to_poly,
+                                    const MeshElemMap *vert_to_loop)
 {
   /* For now this is not supported.
    * If we do not use split normals, we do not generate anything fancy! */
@@ -1666,13 +1754,24 @@ void BKE_mesh_normals_loop_split(const MVert *mverts,
    * However, if needed, we can store the negated value of loop index instead of INDEX_INVALID
    * to retrieve the real value later in code).
    * Note also that loose edges always have both values set to 0! */
-  int(*edge_to_loops)[2] = MEM_calloc_arrayN((size_t)numEdges, sizeof(*edge_to_loops), __func__);
+  int(*edge_to_loops)[2] = MEM_malloc_arrayN((size_t)numEdges, sizeof(*edge_to_loops), __func__);
 
   /* Simple mapping from a loop to its polygon index. */
   int *loop_to_poly = r_loop_to_poly ?
                           r_loop_to_poly :
                           MEM_malloc_arrayN((size_t)numLoops, sizeof(*loop_to_poly), __func__);
 
+  /* Mapping vert -> loops, used to classify edges and to find smooth fans vertex per vertex. */
+  MeshElemMap *vert_to_loop_local = NULL;
+  int *vert_to_loop_mem = NULL;
+  if (vert_to_loop == NULL) {
+    BKE_mesh_vert_loop_map_create(
+        &vert_to_loop_local, &vert_to_loop_mem, mpolys, mloops, numVerts, numPolys, numLoops);
+    vert_to_loop = vert_to_loop_local;
+  }
+
+  char *loop_flags = MEM_calloc_arrayN((size_t)numLoops, sizeof(*loop_flags), __func__);
+
   /* When using custom loop normals, disable the angle feature! */
   const bool check_angle = (split_angle < (float)M_PI) && (clnors_data == NULL);
 
@@ -1702,6 +1801,9 @@ void BKE_mesh_normals_loop_split(const MVert *mverts,
       .edge_to_loops = edge_to_loops,
       .loop_to_poly = loop_to_poly,
       .polynors = polynors,
+      .vert_to_loop = vert_to_loop,
+      .loop_flags = loop_flags,
+      .numVerts = numVerts,
       .numEdges = numEdges,
       .numLoops = numLoops,
       .numPolys = numPolys,
@@ -1710,21 +1812,14 @@ void BKE_mesh_normals_loop_split(const MVert *mverts,
   /* This first loop check which edges are actually smooth, and compute edge vectors. */
   mesh_edges_sharp_tag(&common_data, check_angle, split_angle, false);
 
-  if (numLoops < LOOP_SPLIT_TASK_BLOCK_SIZE * 8) {
-    /* Not enough loops to be worth the whole threading overhead... */
-    loop_split_generator(NULL, &common_data);
-  }
-  else {
-    TaskPool *task_pool = BLI_task_pool_create(&common_data, TASK_PRIORITY_HIGH);
-
-    loop_split_generator(task_pool, &common_data);
-
-    BLI_task_pool_work_and_wait(task_pool);
-
-    BLI_task_pool_free(task_pool);
-  }
+  loop_split_generator(&common_data);
 
   MEM_freeN(edge_to_loops);
+  if (vert_to_loop_local != NULL) {
+    MEM_freeN(vert_to_loop_local);
+    MEM_freeN(vert_to_loop_mem);
+  }
+  MEM_freeN(loop_flags);
   if (!r_loop_to_poly) {
     MEM_freeN(loop_to_poly);
   }
@@ -1740,6 +1835,40 @@ void BKE_mesh_normals_loop_split(const MVert *mverts,
 #endif
 }
 
+void BKE_mesh_normals_loop_split(const MVert *mverts,
+                                 const int numVerts,
+                                 MEdge *medges,
+                                 const int numEdges,
+                                 MLoop *mloops,
+                                 float (*r_loopnors)[3],
+                                 const int numLoops,
+                                 MPoly *mpolys,
+                                 const float (*polynors)[3],
+                                 const int numPolys,
+                                 const bool use_split_normals,
+                                 const float split_angle,
+                                 MLoopNorSpaceArray *r_lnors_spacearr,
+                                 short (*clnors_data)[2],
+                                 int *r_loop_to_poly)
+{
+  BKE_mesh_normals_loop_split_ex(mverts,
+                                 numVerts,
+                                 medges,
+                                 numEdges,
+                                 mloops,
+                                 r_loopnors,
+                                 numLoops,
+                                 mpolys,
+                                 polynors,
+                                 numPolys,
+                                 use_split_normals,
+                                 split_angle,
+                                 r_lnors_spacearr,
+                                 clnors_data,
+                                 r_loop_to_poly,
+                                 NULL);
+}
+
 #undef INDEX_UNSET
 #undef INDEX_INVALID
 #undef IS_EDGE_SHARP
@@ -0,0 +1,290 @@
+/*
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ *
+ * The Original Code is Copyright (C) 2020 by Blender Foundation.
+ */
+#include "testing/testing.h"
+
+#include "BKE_customdata.h"
+#include "BKE_idtype.h"
+#include "BKE_lib_id.h"
+#include "BKE_mesh.h"
+#include "BKE_mesh_runtime.h"
+
+#include "MEM_guardedalloc.h"
+
+#include "DNA_mesh_types.h"
+#include "DNA_meshdata_types.h"
+
+#include "BLI_float3.hh"
+#include "BLI_math_base.h"
+#include "BLI_math_rotation.h"
+#include "BLI_math_vector.h"
+#include "BLI_rand.hh"
+
+#include "mesh_test_util.hh"
+
+namespace blender::bke::tests {
+
+class MeshEvaluateTest : public testing::Test {
+ public:
+  static void SetUpTestCase()
+  {
+    BKE_idtype_init();
+  }
+};
+
+struct SplitNormalsTestContext {
+  Mesh *mesh;
+  float (*poly_normals)[3];
+  float (*loop_normals)[3];
+};
+
+/**
+ * Create a grid of `resolution * resolution` vertices made out of smooth quads,
+ * folded up along `x == fold_x` so that its right part makes a 45 degrees angle with the left one.
+ */
+static void test_split_normals_init(SplitNormalsTestContext *ctx,
+                                    const int resolution,
+                                    const int fold_x)
+{
+  Mesh *mesh = test_mesh_grid_create(resolution, 1.0f);
+  for (int i = 0; i < mesh->totvert; i++) {
+    mesh->mvert[i].co[2] = (float)max_ii(i % resolution - fold_x, 0);
+  }
+
+  ctx->mesh = mesh;
+  ctx->poly_normals = (float(*)[3])MEM_malloc_arrayN(
+      mesh->totpoly, sizeof(*ctx->poly_normals), __func__);
+  ctx->loop_normals = (float(*)[3])MEM_malloc_arrayN(
+      mesh->totloop, sizeof(*ctx->loop_normals), __func__);
+  BKE_mesh_calc_normals_poly(mesh->mvert,
+                             nullptr,
+                             mesh->totvert,
+                             mesh->mloop,
+                             mesh->mpoly,
+                             mesh->totloop,
+                             mesh->totpoly,
+                             ctx->poly_normals,
+                             false);
+}
+
+static void test_split_normals_calc(SplitNormalsTestContext *ctx, const float split_angle)
+{
+  Mesh *mesh = ctx->mesh;
+  BKE_mesh_normals_loop_split(mesh->mvert,
+                              mesh->totvert,
+                              mesh->medge,
+                              mesh->totedge,
+                              mesh->mloop,
+                              ctx->loop_normals,
+                              mesh->totloop,
+                              mesh->mpoly,
+                              (const float(*)[3])ctx->poly_normals,
+                              mesh->totpoly,
+                              true,
+                              split_angle,
+                              nullptr,
+                              nullptr,
+                              nullptr);
+}
+
+static void test_split_normals_teardown(SplitNormalsTestContext *ctx)
+{
+  MEM_freeN(ctx->poly_normals);
+  MEM_freeN(ctx->loop_normals);
+  BKE_id_free(nullptr, ctx->mesh);
+}
+
+TEST_F(MeshEvaluateTest, split_normals_fold)
+{
+  const int resolution = 6;
+  const int fold_x = 2;
+  SplitNormalsTestContext ctx;
+  test_split_normals_init(&ctx, resolution, fold_x);
+  test_split_normals_calc(&ctx, DEG2RADF(30.0f));
+
+  const float3 normal_flat(0.0f, 0.0f, 1.0f);
+  const float3 normal_slope(-(float)M_SQRT1_2, 0.0f, (float)M_SQRT1_2);
+  const Mesh *mesh = ctx.mesh;
+  for (int poly_index = 0; poly_index < mesh->totpoly; poly_index++) {
+    const MPoly *mp = &mesh->mpoly[poly_index];
+    const int poly_x = poly_index % (resolution - 1);
+    for (int i = 0; i < mp->totloop; i++) {
+      const int loop_index = mp->loopstart + i;
+      const int vert_x = mesh->mloop[loop_index].v % resolution;
+      if (poly_x < fold_x) {
+        /* Left side of the fold, including loops along it, stays flat. */
+        EXPECT_V3_NEAR(ctx.loop_normals[loop_index], normal_flat, 1e-5f);
+      }
+      else if (vert_x == fold_x) {
+        /* Right side loops along the sharp fold only use their own side. */
+        EXPECT_V3_NEAR(ctx.loop_normals[loop_index], normal_slope, 1e-5f);
+      }
+    }
+  }
+
+  /* Without angle limit, loops along the fold share a smoothed normal. */
+  test_split_normals_calc(&ctx, (float)M_PI);
+  for (int loop_index = 0; loop_index < mesh->totloop; loop_index++) {
+    const int vert_x = mesh->mloop[loop_index].v % resolution;
+    if (vert_x == fold_x) {
+      EXPECT_GT(ctx.loop_normals[loop_index][2], normal_slope[2] + 0.01f);
+      EXPECT_LT(ctx.loop_normals[loop_index][2], normal_flat[2] - 0.01f);
+    }
+  }
+
+  test_split_normals_teardown(&ctx);
+}
+
+/* Custom normals go through their encoding in the normal spaces of the smooth fans, which are
+ * delimited by the sharp fold here, and come back unchanged. */
+TEST_F(MeshEvaluateTest, split_normals_custom)
+{
+  const int resolution = 6;
+  const int fold_x = 2;
+  SplitNormalsTestContext ctx;
+  test_split_normals_init(&ctx, resolution, fold_x);
+  Mesh *mesh = ctx.mesh;
+  for (int i = 0; i < mesh->totedge; i++) {
+    MEdge *me = &mesh->medge[i];
+    if ((int)me->v1 % resolution == fold_x && (int)me->v2 % resolution == fold_x) {
+      me->flag |= ME_SHARP;
+    }
+  }
+
+  float3 normal_left(0.2f, 0.1f, 1.0f);
+  float3 normal_right(-1.0f, 0.1f, 1.0f);
+  normal_left.normalize();
+  normal_right.normalize();
+  float(*custom_normals)[3] = (float(*)[3])MEM_malloc_arrayN(
+      mesh->totloop, sizeof(*custom_normals), __func__);
+  for (int poly_index = 0; poly_index < mesh->totpoly; poly_index++) {
+    const MPoly *mp = &mesh->mpoly[poly_index];
+    const bool is_left = poly_index % (resolution - 1) < fold_x;
+    for (int i = 0; i < mp->totloop; i++) {
+      copy_v3_v3(custom_normals[mp->loopstart + i], is_left ? normal_left : normal_right);
+    }
+  }
+  short(*clnors)[2] = (short(*)[2])MEM_calloc_arrayN(mesh->totloop, sizeof(*clnors), __func__);
+  BKE_mesh_normals_loop_custom_set(mesh->mvert,
+                                   mesh->totvert,
+                                   mesh->medge,
+                                   mesh->totedge,
+                                   mesh->mloop,
+                                   custom_normals,
+                                   mesh->totloop,
+                                   mesh->mpoly,
+                                   (const float(*)[3])ctx.poly_normals,
+                                   mesh->totpoly,
+                                   clnors);
+  MEM_freeN(custom_normals);
+
+  MLoopNorSpaceArray lnors_spacearr = {nullptr};
+  BKE_mesh_normals_loop_split(mesh->mvert,
+                              mesh->totvert,
+                              mesh->medge,
+                              mesh->totedge,
+                              mesh->mloop,
+                              ctx.loop_normals,
+                              mesh->totloop,
+                              mesh->mpoly,
+                              (const float(*)[3])ctx.poly_normals,
+                              mesh->totpoly,
+                              true,
+                              (float)M_PI,
+                              &lnors_spacearr,
+                              clnors,
+                              nullptr);
+
+  /* One smooth fan per vertex, two for the vertices along the fold. */
+  EXPECT_EQ(lnors_spacearr.num_spaces, resolution * resolution + resolution);
+  for (int poly_index = 0; poly_index < mesh->totpoly; poly_index++) {
+    const MPoly *mp = &mesh->mpoly[poly_index];
+    const bool is_left = poly_index % (resolution - 1) < fold_x;
+    const float3 &normal = is_left ? normal_left : normal_right;
+    for (int i = 0; i < mp->totloop; i++) {
+      const int loop_index = mp->loopstart + i;
+      EXPECT_V3_NEAR(ctx.loop_normals[loop_index], normal, 1e-3f);
+      ASSERT_NE(lnors_spacearr.lspacearr[loop_index], nullptr);
+    }
+  }
+  /* Loops of a vertex along the fold use the space of their side. */
+  const int fold_vert = resolution + fold_x;
+  const MLoopNorSpace *space_left = nullptr;
+  const MLoopNorSpace *space_right = nullptr;
+  for (int loop_index = 0; loop_index < mesh->totloop; loop_index++) {
+    if ((int)mesh->mloop[loop_index].v != fold_vert) {
+      continue;
+    }
+    const bool is_left = (loop_index / 4) % (resolution - 1) < fold_x;
+    const MLoopNorSpace **space = is_left ? &space_left : &space_right;
+    if (*space == nullptr) {
+      *space = lnors_spacearr.lspacearr[loop_index];
+    }
+    EXPECT_EQ(lnors_spacearr.lspacearr[loop_index], *space);
+  }
+  EXPECT_NE(space_left, space_right);
+  BKE_lnor_spacearr_free(&lnors_spacearr);
+
+  /* Same result from the mesh level function, which uses the topology cache of the mesh. */
+  mesh->flag |= ME_AUTOSMOOTH;
+  CustomData_add_layer(&mesh->ldata, CD_CUSTOMLOOPNORMAL, CD_ASSIGN, clnors, mesh->totloop);
+  BKE_mesh_calc_normals_split(mesh);
+  EXPECT_NE(mesh->runtime.topology_cache, nullptr);
+  const float(*mesh_loop_normals)[3] = (const float(*)[3])CustomData_get_layer(&mesh->ldata,
+                                                                                CD_NORMAL);
+  for (int loop_index = 0; loop_index < mesh->totloop; loop_index++) {
+    EXPECT_V3_NEAR(mesh_loop_normals[loop_index], ctx.loop_normals[loop_index], 0.0f);
+  }
+
+  /* And from the loop normals cached on the mesh. */
+  const float(*cached_loop_normals)[3] = BKE_mesh_runtime_loop_normals_ensure(mesh);
+  for (int loop_index = 0; loop_index < mesh->totloop; loop_index++) {
+    EXPECT_V3_NEAR(cached_loop_normals[loop_index], ctx.loop_normals[loop_index], 1e-6f);
+  }
+
+  test_split_normals_teardown(&ctx);
+}
+
+/* Split normals throughput on roughly 5M loops, smooth and with many sharp edges.
+ * Disabled as they are benchmarks, run them with `--gtest_also_run_disabled_tests`. */
+
+static void test_split_normals_performance(const bool use_sharp_edges)
+{
+  SplitNormalsTestContext ctx;
+  test_split_normals_init(&ctx, 1120, 560);
+  if (use_sharp_edges) {
+    RandomNumberGenerator rng;
+    for (int i = 0; i < ctx.mesh->totedge; i++) {
+      if (rng.get_float() < 0.1f) {
+        ctx.mesh->medge[i].flag |= ME_SHARP;
+      }
+    }
+  }
+  test_split_normals_calc(&ctx, DEG2RADF(30.0f));
+  test_split_normals_teardown(&ctx);
+}
+
+TEST_F(MeshEvaluateTest, DISABLED_split_normals_performance_5000000)
+{
+  test_split_normals_performance(false);
+}
+TEST_F(MeshEvaluateTest, DISABLED_split_normals_performance_sharp_5000000)
+{
+  test_split_normals_performance(true);
+}
+
+}  // namespace blender::bke::tests
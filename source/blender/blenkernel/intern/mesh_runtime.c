@@ -30,11 +30,14 @@
 #include "DNA_object_types.h"
 
 #include "BLI_math_geom.h"
+#include "BLI_math_vector.h"
 #include "BLI_threads.h"
 
 #include "BKE_bvhutils.h"
+#include "BKE_customdata.h"
 #include "BKE_lib_id.h"
 #include "BKE_mesh.h"
+#include "BKE_mesh_mapping.h"
 #include "BKE_mesh_runtime.h"
 #include "BKE_shrinkwrap.h"
 #include "BKE_subdiv_ccg.h"
@@ -67,6 +70,8 @@ void BKE_mesh_runtime_reset_on_copy(Mesh *mesh, const int UNUSED(flag))
   memset(&runtime->looptris, 0, sizeof(runtime->looptris));
   runtime->bvh_cache = NULL;
   runtime->shrinkwrap_data = NULL;
+  runtime->topology_cache = NULL;
+  runtime->vert_positions = NULL;
 
   mesh->runtime.eval_mutex = MEM_mallocN(sizeof(ThreadMutex), "mesh runtime eval_mutex");
   BLI_mutex_init(mesh->runtime.eval_mutex);
@@ -239,6 +244,334 @@ void BKE_mesh_runtime_clear_geometry(Mesh *mesh)
     mesh->runtime.subdiv_ccg = NULL;
   }
   BKE_shrinkwrap_discard_boundary_data(mesh);
+  BKE_mesh_runtime_clear_topology_cache(mesh);
+  BKE_mesh_runtime_clear_vert_positions(mesh);
+}
+
+/** \} */
+
+/* -------------------------------------------------------------------- */
+/** \name Mesh Runtime Vertex Positions
+ *
+ * While the modifier stack runs deform modifiers on a mesh, the vertex positions are stored as
+ * a contiguous array owned by the mesh instead of in #MVert. Deform modifiers, normal calculation
+ * and attribute access then work on `float[3]` arrays, without converting back and forth between
+ * both layouts for every modifier that needs normals. The positions are flushed to #MVert before
+ * the mesh is passed to code reading #MVert, so they never outlive the modifier stack.
+ * \{ */
+
+static void mesh_runtime_tag_positions_changed(Mesh *mesh);
+
+/**
+ * Get the contiguous vertex positions of the mesh, creating them from #MVert when needed.
+ * The mesh owns the array, modifying it changes the positions of the mesh.
+ */
+float (*BKE_mesh_runtime_vert_positions_ensure(Mesh *mesh))[3]
+{
+  if (mesh->runtime.vert_positions == NULL) {
+    mesh->runtime.vert_positions = BKE_mesh_vert_coords_alloc(mesh, NULL);
+  }
+  /* The positions are returned for writing. */
+  mesh_runtime_tag_positions_changed(mesh);
+  return mesh->runtime.vert_positions;
+}
+
+/**
+ * Take ownership of \a vert_positions (allocated with #MEM_mallocN) and use them as vertex
+ * positions of the mesh, without writing them to #MVert.
+ */
+void BKE_mesh_runtime_vert_positions_assign(Mesh *mesh, float (*vert_positions)[3])
+{
+  BLI_assert(vert_positions != NULL);
+  if (mesh->runtime.vert_positions != vert_positions) {
+    MEM_SAFE_FREE(mesh->runtime.vert_positions);
+    mesh->runtime.vert_positions = vert_positions;
+  }
+  /* Normals are calculated from the positions but stored in #MVert, which must not be shared
+   * with the mesh this one was copied from then. */
+  BKE_mesh_runtime_verts_for_write(mesh);
+  mesh->runtime.cd_dirty_vert |= CD_MASK_NORMAL;
+}
+
+/** Write the contiguous vertex positions to #MVert and free them. */
+void BKE_mesh_runtime_vert_positions_flush(Mesh *mesh)
+{
+  float(*vert_positions)[3] = mesh->runtime.vert_positions;
+  if (vert_positions == NULL) {
+    return;
+  }
+  MVert *mv = BKE_mesh_runtime_verts_for_write(mesh);
+  for (int i = 0; i < mesh->totvert; i++, mv++) {
+    copy_v3_v3(mv->co, vert_positions[i]);
+  }
+  MEM_freeN(vert_positions);
+  mesh->runtime.vert_positions = NULL;
+}
+
+/** Free the contiguous vertex positions without writing them, when #MVert is overwritten. */
+void BKE_mesh_runtime_clear_vert_positions(Mesh *mesh)
+{
+  MEM_SAFE_FREE(mesh->runtime.vert_positions);
+}
+
+/** \} */
+
+/* -------------------------------------------------------------------- */
+/** \name Mesh Runtime Topology Cache
+ *
+ * Derived data which only depends on the topology of the mesh (and the bounds which also depend
+ * on the positions), computed on first access and shared between all users of the mesh, so a
+ * modifier stack doesn't rebuild the same maps for each modifier.
+ * \{ */
+
+typedef struct MeshTopologyMap {
+  MeshElemMap *map;
+  int *mem;
+} MeshTopologyMap;
+
+typedef struct MeshTopologyCache {
+  /** Protects the data below, computing one map doesn't block the mesh `eval_mutex`. */
+  ThreadMutex mutex;
+
+  MeshTopologyMap vert_to_poly;
+  MeshTopologyMap vert_to_loop;
+  MeshTopologyMap vert_to_edge;
+  MeshTopologyMap edge_to_poly;
+
+  float bounds_min[3];
+  float bounds_max[3];
+  bool bounds_valid;
+
+  /** Loop normals and the auto smooth settings they were computed with. */
+  float (*loop_normals)[3];
+  float loop_normals_split_angle;
+  bool loop_normals_use_split;
+} MeshTopologyCache;
+
+static MeshTopologyCache *mesh_topology_cache_ensure(Mesh *mesh)
+{
+  ThreadMutex *mesh_eval_mutex = (ThreadMutex *)mesh->runtime.eval_mutex;
+  BLI_mutex_lock(mesh_eval_mutex);
+
+  if (mesh->runtime.topology_cache == NULL) {
+    MeshTopologyCache *cache = MEM_callocN(sizeof(*cache), __func__);
+    BLI_mutex_init(&cache->mutex);
+    mesh->runtime.topology_cache = cache;
+  }
+
+  BLI_mutex_unlock(mesh_eval_mutex);
+
+  return mesh->runtime.topology_cache;
+}
+
+static void mesh_topology_map_free(MeshTopologyMap *map)
+{
+  MEM_SAFE_FREE(map->map);
+  MEM_SAFE_FREE(map->mem);
+}
+
+/**
+ * Map from vertices to the polygons using them, see #BKE_mesh_vert_poly_map_create.
+ *
+ * \note Thread safe, the map is owned by the mesh and stays valid until its topology changes.
+ */
+const MeshElemMap *BKE_mesh_runtime_vert_poly_map_ensure(Mesh *mesh)
+{
+  MeshTopologyCache *cache = mesh_topology_cache_ensure(mesh);
+  BLI_mutex_lock(&cache->mutex);
+  if (cache->vert_to_poly.map == NULL) {
+    BKE_mesh_vert_poly_map_create(&cache->vert_to_poly.map,
+                                  &cache->vert_to_poly.mem,
+                                  mesh->mpoly,
+                                  mesh->mloop,
+                                  mesh->totvert,
+                                  mesh->totpoly,
+                                  mesh->totloop);
+  }
+  BLI_mutex_unlock(&cache->mutex);
+  return cache->vert_to_poly.map;
+}
+
+/* Cache mutex must be locked. */
+static const MeshElemMap *mesh_vert_loop_map_ensure_locked(Mesh *mesh, MeshTopologyCache *cache)
+{
+  if (cache->vert_to_loop.map == NULL) {
+    BKE_mesh_vert_loop_map_create(&cache->vert_to_loop.map,
+                                  &cache->vert_to_loop.mem,
+                                  mesh->mpoly,
+                                  mesh->mloop,
+                                  mesh->totvert,
+                                  mesh->totpoly,
+                                  mesh->totloop);
+  }
+  return cache->vert_to_loop.map;
+}
+
+/** Map from vertices to the loops using them, see #BKE_mesh_vert_loop_map_create. */
+const MeshElemMap *BKE_mesh_runtime_vert_loop_map_ensure(Mesh *mesh)
+{
+  MeshTopologyCache *cache = mesh_topology_cache_ensure(mesh);
+  BLI_mutex_lock(&cache->mutex);
+  const MeshElemMap *vert_to_loop = mesh_vert_loop_map_ensure_locked(mesh, cache);
+  BLI_mutex_unlock(&cache->mutex);
+  return vert_to_loop;
+}
+
+/** Map from vertices to the edges using them, see #BKE_mesh_vert_edge_map_create. */
+const MeshElemMap *BKE_mesh_runtime_vert_edge_map_ensure(Mesh *mesh)
+{
+  MeshTopologyCache *cache = mesh_topology_cache_ensure(mesh);
+  BLI_mutex_lock(&cache->mutex);
+  if (cache->vert_to_edge.map == NULL) {
+    BKE_mesh_vert_edge_map_create(&cache->vert_to_edge.map,
+                                  &cache->vert_to_edge.mem,
+                                  mesh->medge,
+                                  mesh->totvert,
+                                  mesh->totedge);
+  }
+  BLI_mutex_unlock(&cache->mutex);
+  return cache->vert_to_edge.map;
+}
+
+/** Map from edges to the polygons using them, see #BKE_mesh_edge_poly_map_create. */
+const MeshElemMap *BKE_mesh_runtime_edge_poly_map_ensure(Mesh *mesh)
+{
+  MeshTopologyCache *cache = mesh_topology_cache_ensure(mesh);
+  BLI_mutex_lock(&cache->mutex);
+  if (cache->edge_to_poly.map == NULL) {
+    BKE_mesh_edge_poly_map_create(&cache->edge_to_poly.map,
+                                  &cache->edge_to_poly.mem,
+                                  mesh->medge,
+                                  mesh->totedge,
+                                  mesh->mpoly,
+                                  mesh->totpoly,
+                                  mesh->mloop,
+                                  mesh->totloop);
+  }
+  BLI_mutex_unlock(&cache->mutex);
+  return cache->edge_to_poly.map;
+}
+
+/**
+ * Expand \a r_min and \a r_max by the cached bounds of the vertex positions.
+ *
+ * \return false when the mesh has no vertices.
+ */
+bool BKE_mesh_runtime_minmax(Mesh *mesh, float r_min[3], float r_max[3])
+{
+  if (mesh->totvert == 0) {
+    return false;
+  }
+  MeshTopologyCache *cache = mesh_topology_cache_ensure(mesh);
+  BLI_mutex_lock(&cache->mutex);
+  if (!cache->bounds_valid) {
+    INIT_MINMAX(cache->bounds_min, cache->bounds_max);
+    BKE_mesh_minmax(mesh, cache->bounds_min, cache->bounds_max);
+    cache->bounds_valid = true;
+  }
+  BLI_mutex_unlock(&cache->mutex);
+
+  minmax_v3v3_v3(r_min, r_max, cache->bounds_min);
+  minmax_v3v3_v3(r_min, r_max, cache->bounds_max);
+  return true;
+}
+
+/**
+ * Loop normals of the mesh, computed like #BKE_mesh_calc_normals_split but without adding a
+ * #CD_NORMAL layer, so several users of the mesh (e.g. draw code rebuilding its batches) share
+ * them.
+ *
+ * \note Thread safe, the normals stay valid until the positions or the topology change.
+ */
+const float (*BKE_mesh_runtime_loop_normals_ensure(Mesh *mesh))[3]
+{
+  const bool use_split_normals = (mesh->flag & ME_AUTOSMOOTH) != 0;
+  const float split_angle = use_split_normals ? mesh->smoothresh : (float)M_PI;
+
+  MeshTopologyCache *cache = mesh_topology_cache_ensure(mesh);
+  BLI_mutex_lock(&cache->mutex);
+  if (cache->loop_normals != NULL && (cache->loop_normals_use_split != use_split_normals ||
+                                      cache->loop_normals_split_angle != split_angle)) {
+    MEM_SAFE_FREE(cache->loop_normals);
+  }
+  if (cache->loop_normals == NULL) {
+    float(*poly_normals)[3] = MEM_malloc_arrayN(mesh->totpoly, sizeof(float[3]), __func__);
+    BKE_mesh_calc_normals_poly(mesh->mvert,
+                               NULL,
+                               mesh->totvert,
+                               mesh->mloop,
+                               mesh->mpoly,
+                               mesh->totloop,
+                               mesh->totpoly,
+                               poly_normals,
+                               true);
+
+    cache->loop_normals = MEM_malloc_arrayN(mesh->totloop, sizeof(float[3]), __func__);
+    BKE_mesh_normals_loop_split_ex(
+        mesh->mvert,
+        mesh->totvert,
+        mesh->medge,
+        mesh->totedge,
+        mesh->mloop,
+        cache->loop_normals,
+        mesh->totloop,
+        mesh->mpoly,
+        (const float(*)[3])poly_normals,
+        mesh->totpoly,
+        use_split_normals,
+        split_angle,
+        NULL,
+        CustomData_get_layer(&mesh->ldata, CD_CUSTOMLOOPNORMAL),
+        NULL,
+        use_split_normals ? mesh_vert_loop_map_ensure_locked(mesh, cache) : NULL);
+    cache->loop_normals_use_split = use_split_normals;
+    cache->loop_normals_split_angle = split_angle;
+
+    MEM_freeN(poly_normals);
+  }
+  BLI_mutex_unlock(&cache->mutex);
+  return (const float(*)[3])cache->loop_normals;
+}
+
+/* Invalidate cached data depending on vertex positions. */
+static void mesh_runtime_tag_positions_changed(Mesh *mesh)
+{
+  MeshTopologyCache *cache = mesh->runtime.topology_cache;
+  if (cache != NULL) {
+    BLI_mutex_lock(&cache->mutex);
+    cache->bounds_valid = false;
+    MEM_SAFE_FREE(cache->loop_normals);
+    BLI_mutex_unlock(&cache->mutex);
+  }
+}
+
+/**
+ * Get the #MVert array of the mesh for writing. The layer is copied when it is shared with another
+ * mesh, and cached data depending on vertex positions is invalidated, so any change made through
+ * the returned array is picked up.
+ */
+MVert *BKE_mesh_runtime_verts_for_write(Mesh *mesh)
+{
+  mesh->mvert = CustomData_duplicate_referenced_layer(&mesh->vdata, CD_MVERT, mesh->totvert);
+  mesh_runtime_tag_positions_changed(mesh);
+  return mesh->mvert;
+}
+
+/** Free the topology cache, must be called when the topology of the mesh changes in place. */
+void BKE_mesh_runtime_clear_topology_cache(Mesh *mesh)
+{
+  MeshTopologyCache *cache = mesh->runtime.topology_cache;
+  if (cache == NULL) {
+    return;
+  }
+  mesh_topology_map_free(&cache->vert_to_poly);
+  mesh_topology_map_free(&cache->vert_to_loop);
+  mesh_topology_map_free(&cache->vert_to_edge);
+  mesh_topology_map_free(&cache->edge_to_poly);
+  MEM_SAFE_FREE(cache->loop_normals);
+  BLI_mutex_end(&cache->mutex);
+  MEM_freeN(cache);
+  mesh->runtime.topology_cache = NULL;
 }
 
 /** \} */
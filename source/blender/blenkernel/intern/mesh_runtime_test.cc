@@ -0,0 +1,271 @@
+/*
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ *
+ * The Original Code is Copyright (C) 2020 by Blender Foundation.
+ */
+#include "testing/testing.h"
+
+#include "BKE_attribute_access.hh"
+#include "BKE_geometry_set.hh"
+#include "BKE_idtype.h"
+#include "BKE_lib_id.h"
+#include "BKE_mesh.h"
+#include "BKE_mesh_mapping.h"
+#include "BKE_mesh_runtime.h"
+
+#include "DNA_mesh_types.h"
+#include "DNA_meshdata_types.h"
+
+#include "BLI_float3.hh"
+#include "BLI_math_vector.h"
+#include "BLI_timeit.hh"
+
+#include "MEM_guardedalloc.h"
+
+#include "mesh_test_util.hh"
+
+namespace blender::bke::tests {
+
+/* Number of deform modifiers, roughly a character with a few deform modifiers. */
+static const int DEFORM_STACK_LEN = 5;
+
+class MeshRuntimeTest : public testing::Test {
+ public:
+  static void SetUpTestCase()
+  {
+    BKE_idtype_init();
+  }
+};
+
+TEST_F(MeshRuntimeTest, topology_cache)
+{
+  Mesh *mesh = test_mesh_grid_create(4, 0.25f);
+
+  const MeshElemMap *vert_to_poly = BKE_mesh_runtime_vert_poly_map_ensure(mesh);
+  EXPECT_EQ(BKE_mesh_runtime_vert_poly_map_ensure(mesh), vert_to_poly);
+  /* Corner, border and inner vertex of the 3x3 quads grid. */
+  EXPECT_EQ(vert_to_poly[0].count, 1);
+  EXPECT_EQ(vert_to_poly[1].count, 2);
+  EXPECT_EQ(vert_to_poly[5].count, 4);
+
+  const MeshElemMap *vert_to_loop = BKE_mesh_runtime_vert_loop_map_ensure(mesh);
+  EXPECT_EQ(vert_to_loop[5].count, 4);
+
+  float min[3], max[3];
+  INIT_MINMAX(min, max);
+  EXPECT_TRUE(BKE_mesh_runtime_minmax(mesh, min, max));
+  EXPECT_V3_NEAR(min, float3(0.0f, 0.0f, 0.0f), 1e-6f);
+  EXPECT_V3_NEAR(max, float3(0.75f, 0.75f, 0.0f), 1e-6f);
+
+  /* Bounds follow position changes, topology maps are kept. */
+  const float offset[3] = {1.0f, 0.0f, 0.0f};
+  BKE_mesh_translate(mesh, offset, false);
+  INIT_MINMAX(min, max);
+  BKE_mesh_runtime_minmax(mesh, min, max);
+  EXPECT_NEAR(min[0], 1.0f, 1e-6f);
+  EXPECT_EQ(BKE_mesh_runtime_vert_poly_map_ensure(mesh), vert_to_poly);
+
+  /* Maps are dropped when the edges are recomputed. */
+  BKE_mesh_runtime_edge_poly_map_ensure(mesh);
+  BKE_mesh_calc_edges(mesh, false, false);
+  EXPECT_EQ(mesh->runtime.topology_cache, nullptr);
+  const MeshElemMap *edge_to_poly = BKE_mesh_runtime_edge_poly_map_ensure(mesh);
+  int boundary_edges_len = 0;
+  for (int i = 0; i < mesh->totedge; i++) {
+    EXPECT_TRUE(ELEM(edge_to_poly[i].count, 1, 2));
+    boundary_edges_len += edge_to_poly[i].count == 1;
+  }
+  EXPECT_EQ(boundary_edges_len, 12);
+
+  BKE_id_free(nullptr, mesh);
+}
+
+TEST_F(MeshRuntimeTest, positions_cache)
+{
+  Mesh *mesh = test_mesh_grid_create(4, 0.25f);
+  mesh->flag |= ME_AUTOSMOOTH;
+  mesh->smoothresh = 0.5f;
+
+  const float(*loop_normals)[3] = BKE_mesh_runtime_loop_normals_ensure(mesh);
+  EXPECT_EQ(BKE_mesh_runtime_loop_normals_ensure(mesh), loop_normals);
+  for (int i = 0; i < mesh->totloop; i++) {
+    EXPECT_V3_NEAR(loop_normals[i], float3(0.0f, 0.0f, 1.0f), 1e-6f);
+  }
+  float min[3], max[3];
+  INIT_MINMAX(min, max);
+  BKE_mesh_runtime_minmax(mesh, min, max);
+
+  /* Positions written through the write access invalidate the data derived from them,
+   * the grid is moved to the XZ plane. */
+  MVert *mvert = BKE_mesh_runtime_verts_for_write(mesh);
+  for (int i = 0; i < mesh->totvert; i++) {
+    std::swap(mvert[i].co[1], mvert[i].co[2]);
+  }
+  loop_normals = BKE_mesh_runtime_loop_normals_ensure(mesh);
+  for (int i = 0; i < mesh->totloop; i++) {
+    EXPECT_V3_NEAR(loop_normals[i], float3(0.0f, -1.0f, 0.0f), 1e-6f);
+  }
+  INIT_MINMAX(min, max);
+  BKE_mesh_runtime_minmax(mesh, min, max);
+  EXPECT_V3_NEAR(max, float3(0.75f, 0.0f, 0.75f), 1e-6f);
+
+  BKE_id_free(nullptr, mesh);
+}
+
+static void test_deform_co(float co[3], const int pass)
+{
+  co[2] += 0.01f * sinf(co[0] * 10.0f + (float)pass) * cosf(co[1] * 10.0f);
+}
+
+/**
+ * Deform stack like the modifier stack runs it without runtime vertex positions: coordinates are
+ * copied out of #MVert, deformed, and written back to #MVert for every modifier needing normals.
+ */
+static void test_deform_stack_mvert(Mesh *mesh)
+{
+  float(*coords)[3] = BKE_mesh_vert_coords_alloc(mesh, nullptr);
+  for (int pass = 0; pass < DEFORM_STACK_LEN; pass++) {
+    BKE_mesh_vert_coords_apply(mesh, coords);
+    BKE_mesh_ensure_normals(mesh);
+    for (int i = 0; i < mesh->totvert; i++) {
+      test_deform_co(coords[i], pass);
+    }
+  }
+  BKE_mesh_vert_coords_apply(mesh, coords);
+  MEM_freeN(coords);
+  BKE_mesh_ensure_normals(mesh);
+}
+
+/** The same stack deforming the runtime vertex positions of the mesh, like the modifier stack. */
+static void test_deform_stack_positions(Mesh *mesh)
+{
+  float(*positions)[3] = BKE_mesh_runtime_vert_positions_ensure(mesh);
+  for (int pass = 0; pass < DEFORM_STACK_LEN; pass++) {
+    BKE_mesh_runtime_vert_positions_assign(mesh, positions);
+    BKE_mesh_ensure_normals(mesh);
+    for (int i = 0; i < mesh->totvert; i++) {
+      test_deform_co(positions[i], pass);
+    }
+  }
+  BKE_mesh_runtime_vert_positions_flush(mesh);
+  mesh->runtime.cd_dirty_vert |= CD_MASK_NORMAL;
+  BKE_mesh_ensure_normals(mesh);
+}
+
+TEST_F(MeshRuntimeTest, vert_positions_deform_stack)
+{
+  Mesh *mesh_a = test_mesh_grid_create(32, 1.0f / 32.0f);
+  Mesh *mesh_b = test_mesh_grid_create(32, 1.0f / 32.0f);
+
+  test_deform_stack_mvert(mesh_a);
+  test_deform_stack_positions(mesh_b);
+
+  EXPECT_EQ(mesh_b->runtime.vert_positions, nullptr);
+  for (int i = 0; i < mesh_a->totvert; i++) {
+    EXPECT_V3_NEAR(mesh_a->mvert[i].co, mesh_b->mvert[i].co, 0.0f);
+    EXPECT_EQ(mesh_a->mvert[i].no[0], mesh_b->mvert[i].no[0]);
+    EXPECT_EQ(mesh_a->mvert[i].no[1], mesh_b->mvert[i].no[1]);
+    EXPECT_EQ(mesh_a->mvert[i].no[2], mesh_b->mvert[i].no[2]);
+  }
+
+  BKE_id_free(nullptr, mesh_a);
+  BKE_id_free(nullptr, mesh_b);
+}
+
+TEST_F(MeshRuntimeTest, vert_positions)
+{
+  Mesh *mesh = test_mesh_grid_create(4, 0.25f);
+  float(*positions)[3] = BKE_mesh_runtime_vert_positions_ensure(mesh);
+  EXPECT_EQ(BKE_mesh_runtime_vert_positions_ensure(mesh), positions);
+  EXPECT_V3_NEAR(positions[5], mesh->mvert[5].co, 0.0f);
+
+  /* The positions are the current ones, #MVert is only written when flushing. */
+  positions[5][2] = 1.0f;
+  BKE_mesh_runtime_vert_positions_assign(mesh, positions);
+  EXPECT_EQ(mesh->mvert[5].co[2], 0.0f);
+  float coords[16][3];
+  BKE_mesh_vert_coords_get(mesh, coords);
+  EXPECT_EQ(coords[5][2], 1.0f);
+  float min[3], max[3];
+  INIT_MINMAX(min, max);
+  BKE_mesh_minmax(mesh, min, max);
+  EXPECT_EQ(max[2], 1.0f);
+
+  /* Normals are calculated from them. */
+  BKE_mesh_ensure_normals(mesh);
+  EXPECT_NE(mesh->mvert[1].no[2], SHRT_MAX);
+
+  /* Copies get the current positions in #MVert. */
+  Mesh *mesh_copy = BKE_mesh_copy_for_eval(mesh, true);
+  EXPECT_EQ(mesh_copy->runtime.vert_positions, nullptr);
+  EXPECT_EQ(mesh_copy->mvert[5].co[2], 1.0f);
+  EXPECT_EQ(mesh->mvert[5].co[2], 0.0f);
+  BKE_id_free(nullptr, mesh_copy);
+
+  /* Writing #MVert in place writes the positions back first. */
+  const float offset[3] = {0.0f, 0.0f, 1.0f};
+  BKE_mesh_translate(mesh, offset, false);
+  EXPECT_EQ(mesh->runtime.vert_positions, nullptr);
+  EXPECT_EQ(mesh->mvert[5].co[2], 2.0f);
+  EXPECT_EQ(mesh->mvert[4].co[2], 1.0f);
+
+  BKE_id_free(nullptr, mesh);
+}
+
+TEST_F(MeshRuntimeTest, vert_positions_attribute)
+{
+  Mesh *mesh = test_mesh_grid_create(4, 0.25f);
+  float(*positions)[3] = BKE_mesh_runtime_vert_positions_ensure(mesh);
+
+  MeshComponent component;
+  component.replace(mesh, GeometryOwnershipType::Editable);
+
+  /* The attribute uses the positions array itself. */
+  Float3ReadAttribute read_attribute = component.attribute_try_get_for_read("position");
+  EXPECT_EQ(read_attribute.get_span().data(), reinterpret_cast<const float3 *>(positions));
+
+  Float3WriteAttribute write_attribute = component.attribute_try_get_for_write("position");
+  MutableSpan<float3> span = write_attribute.get_span();
+  EXPECT_EQ(span.data(), reinterpret_cast<float3 *>(positions));
+  span[3].z = 2.0f;
+  write_attribute.apply_span();
+  EXPECT_EQ(positions[3][2], 2.0f);
+  EXPECT_TRUE(mesh->runtime.cd_dirty_vert & CD_MASK_NORMAL);
+
+  BKE_mesh_runtime_vert_positions_flush(mesh);
+  EXPECT_EQ(mesh->mvert[3].co[2], 2.0f);
+
+  component.clear();
+  BKE_id_free(nullptr, mesh);
+}
+
+/* Deform stack throughput, compare the `mvert` and `positions` timings. */
+
+TEST_F(MeshRuntimeTest, DISABLED_deform_stack_performance_mvert_1000000)
+{
+  Mesh *mesh = test_mesh_grid_create(1000, 0.001f);
+  SCOPED_TIMER(__func__);
+  test_deform_stack_mvert(mesh);
+  BKE_id_free(nullptr, mesh);
+}
+TEST_F(MeshRuntimeTest, DISABLED_deform_stack_performance_positions_1000000)
+{
+  Mesh *mesh = test_mesh_grid_create(1000, 0.001f);
+  SCOPED_TIMER(__func__);
+  test_deform_stack_positions(mesh);
+  BKE_id_free(nullptr, mesh);
+}
+
+}  // namespace blender::bke::tests
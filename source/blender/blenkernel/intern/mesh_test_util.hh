@@ -0,0 +1,71 @@
+/*
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ *
+ * The Original Code is Copyright (C) 2020 by Blender Foundation.
+ */
+
+#pragma once
+
+/** \file
+ * \ingroup bke
+ *
+ * Mesh creation helpers shared by the blenkernel tests.
+ */
+
+#include "BKE_mesh.h"
+
+#include "DNA_mesh_types.h"
+#include "DNA_meshdata_types.h"
+
+namespace blender::bke::tests {
+
+/**
+ * Create a grid of `resolution * resolution` vertices made out of smooth quads, with edges.
+ * The vertex at grid coordinates `(x, y)` is placed at `(x * scale, y * scale, 0)`.
+ */
+inline Mesh *test_mesh_grid_create(const int resolution, const float scale)
+{
+  const int quads_len = (resolution - 1) * (resolution - 1);
+  Mesh *mesh = BKE_mesh_new_nomain(resolution * resolution, 0, 0, quads_len * 4, quads_len);
+
+  for (int y = 0; y < resolution; y++) {
+    for (int x = 0; x < resolution; x++) {
+      MVert *mv = &mesh->mvert[y * resolution + x];
+      mv->co[0] = (float)x * scale;
+      mv->co[1] = (float)y * scale;
+      mv->co[2] = 0.0f;
+    }
+  }
+
+  int poly_index = 0;
+  for (int y = 0; y < resolution - 1; y++) {
+    for (int x = 0; x < resolution - 1; x++, poly_index++) {
+      MPoly *mp = &mesh->mpoly[poly_index];
+      mp->loopstart = poly_index * 4;
+      mp->totloop = 4;
+      mp->flag |= ME_SMOOTH;
+      MLoop *ml = &mesh->mloop[mp->loopstart];
+      ml[0].v = y * resolution + x;
+      ml[1].v = y * resolution + x + 1;
+      ml[2].v = (y + 1) * resolution + x + 1;
+      ml[3].v = (y + 1) * resolution + x;
+    }
+  }
+  BKE_mesh_calc_edges(mesh, false, false);
+  mesh->runtime.cd_dirty_vert |= CD_MASK_NORMAL;
+  return mesh;
+}
+
+}  // namespace blender::bke::tests
@@ -31,6 +31,7 @@
 
 #include "BKE_customdata.h"
 #include "BKE_mesh.h"
+#include "BKE_mesh_runtime.h"
 
 namespace blender::bke::calc_edges {
 
@@ -263,6 +264,9 @@ void BKE_mesh_calc_edges(Mesh *mesh, bool keep_existing_edges, const bool select
   mesh->totedge = new_totedge;
   mesh->medge = new_edges.data();
 
+  /* Cached edge maps refer to the old edge indices. */
+  BKE_mesh_runtime_clear_topology_cache(mesh);
+
   /* Explicitely clear edge maps, because that way it can be parallelized. */
   clear_hash_tables(edge_maps);
 }
@@ -884,6 +884,7 @@ static bool put_imbuf_cache(
     moviecache = IMB_moviecache_create(
         "movieclip", sizeof(MovieClipImBufCacheKey), moviecache_hashhash, moviecache_hashcmp);
 
+    IMB_moviecache_set_type(moviecache, IMB_CACHE_TYPE_MOVIECLIP);
     IMB_moviecache_set_getdata_callback(moviecache, moviecache_keydata);
     IMB_moviecache_set_priority_callback(moviecache,
                                          moviecache_getprioritydata,
@@ -27,8 +27,11 @@
 #include "DNA_meshdata_types.h"
 #include "DNA_modifier_types.h"
 
+#include "BLI_hash_mm2a.h"
 #include "BLI_utildefines.h"
 
+#include "BKE_customdata.h"
+
 #include "MEM_guardedalloc.h"
 
 #include "subdiv_converter.h"
@@ -141,6 +144,95 @@ Subdiv *BKE_subdiv_new_from_mesh(const SubdivSettings *settings, const Mesh *mes
   return subdiv;
 }
 
+/* Coarse mesh topology key. */
+
+typedef struct SubdivMeshTopologyKey {
+  int num_vertices;
+  int num_edges;
+  int num_polys;
+  int num_loops;
+  int num_uv_layers;
+  bool use_creases;
+  /* Hash of the mesh fields which affect the topology refiner: the loops, polygons, edges with
+   * their creases and UV coordinates (which define face-varying topology). Two 32 bit hashes
+   * with different seeds are used, to make a false match practically impossible. */
+  uint32_t hash[2];
+} SubdivMeshTopologyKey;
+
+typedef struct SubdivMeshTopologyHash {
+  BLI_HashMurmur2A mm2[2];
+} SubdivMeshTopologyHash;
+
+static void subdiv_mesh_topology_hash_add(SubdivMeshTopologyHash *hash,
+                                          const void *data,
+                                          size_t len)
+{
+  BLI_hash_mm2a_add(&hash->mm2[0], data, len);
+  BLI_hash_mm2a_add(&hash->mm2[1], data, len);
+}
+
+static void subdiv_mesh_topology_hash_add_int(SubdivMeshTopologyHash *hash, int data)
+{
+  BLI_hash_mm2a_add_int(&hash->mm2[0], data);
+  BLI_hash_mm2a_add_int(&hash->mm2[1], data);
+}
+
+static void subdiv_mesh_topology_key_init(SubdivMeshTopologyKey *key,
+                                          const SubdivSettings *settings,
+                                          const Mesh *mesh)
+{
+  key->num_vertices = mesh->totvert;
+  key->num_edges = mesh->totedge;
+  key->num_polys = mesh->totpoly;
+  key->num_loops = mesh->totloop;
+  key->num_uv_layers = CustomData_number_of_layers(&mesh->ldata, CD_MLOOPUV);
+  key->use_creases = settings->use_creases;
+
+  SubdivMeshTopologyHash hash;
+  BLI_hash_mm2a_init(&hash.mm2[0], 0);
+  BLI_hash_mm2a_init(&hash.mm2[1], 0x9e3779b9);
+  if (mesh->totloop != 0) {
+    subdiv_mesh_topology_hash_add(&hash, mesh->mloop, sizeof(*mesh->mloop) * mesh->totloop);
+  }
+  for (int poly_index = 0; poly_index < mesh->totpoly; poly_index++) {
+    const MPoly *poly = &mesh->mpoly[poly_index];
+    subdiv_mesh_topology_hash_add_int(&hash, poly->loopstart);
+    subdiv_mesh_topology_hash_add_int(&hash, poly->totloop);
+  }
+  for (int edge_index = 0; edge_index < mesh->totedge; edge_index++) {
+    const MEdge *edge = &mesh->medge[edge_index];
+    subdiv_mesh_topology_hash_add_int(&hash, (int)edge->v1);
+    subdiv_mesh_topology_hash_add_int(&hash, (int)edge->v2);
+    if (settings->use_creases) {
+      subdiv_mesh_topology_hash_add_int(&hash, edge->crease);
+    }
+  }
+  for (int layer_index = 0; layer_index < key->num_uv_layers; layer_index++) {
+    const MLoopUV *mloopuv = CustomData_get_layer_n(&mesh->ldata, CD_MLOOPUV, layer_index);
+    for (int loop_index = 0; loop_index < mesh->totloop; loop_index++) {
+      subdiv_mesh_topology_hash_add(&hash, mloopuv[loop_index].uv, sizeof(float[2]));
+    }
+  }
+  key->hash[0] = BLI_hash_mm2a_end(&hash.mm2[0]);
+  key->hash[1] = BLI_hash_mm2a_end(&hash.mm2[1]);
+}
+
+static bool subdiv_mesh_topology_key_matches(const SubdivMeshTopologyKey *key,
+                                             const SubdivSettings *settings,
+                                             const Mesh *mesh)
+{
+  /* Cheap checks first, so meshes with a different amount of elements are not hashed. */
+  if (key->num_vertices != mesh->totvert || key->num_edges != mesh->totedge ||
+      key->num_polys != mesh->totpoly || key->num_loops != mesh->totloop ||
+      key->use_creases != settings->use_creases ||
+      key->num_uv_layers != CustomData_number_of_layers(&mesh->ldata, CD_MLOOPUV)) {
+    return false;
+  }
+  SubdivMeshTopologyKey mesh_key;
+  subdiv_mesh_topology_key_init(&mesh_key, settings, mesh);
+  return key->hash[0] == mesh_key.hash[0] && key->hash[1] == mesh_key.hash[1];
+}
+
 /* Creation with cached-aware semantic. */
 
 Subdiv *BKE_subdiv_update_from_converter(Subdiv *subdiv,
@@ -177,10 +269,30 @@ Subdiv *BKE_subdiv_update_from_mesh(Subdiv *subdiv,
                                     const SubdivSettings *settings,
                                     const Mesh *mesh)
 {
+  /* Fast path for animated meshes: when the coarse topology did not change since the descriptor
+   * was created, there is no need to build a converter and compare it on OpenSubdiv side. Only
+   * coarse positions are to be updated, which happens on evaluator refine. */
+  if (subdiv != NULL && subdiv->topology_refiner != NULL &&
+      subdiv->cache_.mesh_topology_key != NULL &&
+      BKE_subdiv_settings_equal(&subdiv->settings, settings)) {
+    BKE_subdiv_stats_begin(&subdiv->stats, SUBDIV_STATS_TOPOLOGY_COMPARE);
+    const bool is_topology_equal = subdiv_mesh_topology_key_matches(
+        subdiv->cache_.mesh_topology_key, settings, mesh);
+    BKE_subdiv_stats_end(&subdiv->stats, SUBDIV_STATS_TOPOLOGY_COMPARE);
+    if (is_topology_equal) {
+      return subdiv;
+    }
+  }
   OpenSubdiv_Converter converter;
   BKE_subdiv_converter_init_for_mesh(&converter, settings, mesh);
   subdiv = BKE_subdiv_update_from_converter(subdiv, settings, &converter);
   BKE_subdiv_converter_free(&converter);
+  if (subdiv != NULL && subdiv->topology_refiner != NULL) {
+    if (subdiv->cache_.mesh_topology_key == NULL) {
+      subdiv->cache_.mesh_topology_key = MEM_mallocN(sizeof(SubdivMeshTopologyKey), __func__);
+    }
+    subdiv_mesh_topology_key_init(subdiv->cache_.mesh_topology_key, settings, mesh);
+  }
   return subdiv;
 }
 
@@ -198,6 +310,9 @@ void BKE_subdiv_free(Subdiv *subdiv)
   if (subdiv->cache_.face_ptex_offset != NULL) {
     MEM_freeN(subdiv->cache_.face_ptex_offset);
   }
+  if (subdiv->cache_.mesh_topology_key != NULL) {
+    MEM_freeN(subdiv->cache_.mesh_topology_key);
+  }
   MEM_freeN(subdiv);
 }
 
@@ -80,8 +80,12 @@ static void set_coarse_positions(Subdiv *subdiv,
       BLI_BITMAP_ENABLE(vertex_used_map, loop->v);
     }
   }
-  for (int vertex_index = 0, manifold_vertex_index = 0; vertex_index < mesh->totvert;
-       vertex_index++) {
+  /* Gather coordinates of all manifold vertices into a contiguous buffer, so they are passed to
+   * the evaluator at once rather than vertex by vertex. */
+  float(*manifold_vertex_cos)[3] = MEM_malloc_arrayN(
+      mesh->totvert, sizeof(*manifold_vertex_cos), "manifold vertex cos");
+  int num_manifold_vertices = 0;
+  for (int vertex_index = 0; vertex_index < mesh->totvert; vertex_index++) {
     if (!BLI_BITMAP_TEST_BOOL(vertex_used_map, vertex_index)) {
       continue;
     }
@@ -93,9 +97,14 @@ static void set_coarse_positions(Subdiv *subdiv,
       const MVert *vertex = &mvert[vertex_index];
       vertex_co = vertex->co;
     }
-    subdiv->evaluator->setCoarsePositions(subdiv->evaluator, vertex_co, manifold_vertex_index, 1);
-    manifold_vertex_index++;
+    copy_v3_v3(manifold_vertex_cos[num_manifold_vertices], vertex_co);
+    num_manifold_vertices++;
   }
+  if (num_manifold_vertices != 0) {
+    subdiv->evaluator->setCoarsePositions(
+        subdiv->evaluator, &manifold_vertex_cos[0][0], 0, num_manifold_vertices);
+  }
+  MEM_freeN(manifold_vertex_cos);
   MEM_freeN(vertex_used_map);
 }
 
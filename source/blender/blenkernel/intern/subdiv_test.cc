@@ -0,0 +1,107 @@
+/*
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ *
+ * The Original Code is Copyright (C) 2020 by Blender Foundation.
+ */
+#include "testing/testing.h"
+
+#include "BKE_idtype.h"
+#include "BKE_lib_id.h"
+#include "BKE_mesh.h"
+#include "BKE_subdiv.h"
+#include "BKE_subdiv_eval.h"
+
+#include "DNA_mesh_types.h"
+#include "DNA_meshdata_types.h"
+
+#include "mesh_test_util.hh"
+
+namespace blender::bke::tests {
+
+class SubdivTest : public testing::Test {
+ public:
+  static void SetUpTestCase()
+  {
+    BKE_idtype_init();
+    BKE_subdiv_init();
+  }
+
+  static void TearDownTestCase()
+  {
+    BKE_subdiv_exit();
+  }
+
+ protected:
+  SubdivSettings settings_ = {};
+
+  void SetUp() override
+  {
+    settings_.is_simple = false;
+    settings_.is_adaptive = false;
+    settings_.level = 2;
+    settings_.use_creases = true;
+    settings_.vtx_boundary_interpolation = SUBDIV_VTX_BOUNDARY_EDGE_ONLY;
+    settings_.fvar_linear_interpolation = SUBDIV_FVAR_LINEAR_INTERPOLATION_ALL;
+  }
+};
+
+#ifdef WITH_OPENSUBDIV
+
+/* Moving vertices keeps the descriptor, together with its evaluator. */
+TEST_F(SubdivTest, update_from_mesh_reuse)
+{
+  Mesh *mesh = test_mesh_grid_create(4, 0.25f);
+  Subdiv *subdiv = BKE_subdiv_update_from_mesh(nullptr, &settings_, mesh);
+  ASSERT_NE(subdiv, nullptr);
+  ASSERT_TRUE(BKE_subdiv_eval_begin_from_mesh(subdiv, mesh, nullptr));
+  ASSERT_NE(subdiv->evaluator, nullptr);
+
+  mesh->mvert[5].co[2] = 1.0f;
+  Subdiv *subdiv_updated = BKE_subdiv_update_from_mesh(subdiv, &settings_, mesh);
+  EXPECT_EQ(subdiv_updated, subdiv);
+  EXPECT_NE(subdiv_updated->evaluator, nullptr);
+
+  BKE_subdiv_free(subdiv_updated);
+  BKE_id_free(nullptr, mesh);
+}
+
+/* Changing topology with the same amount of elements, or changing the amount of elements,
+ * creates a new descriptor which has no evaluator yet. */
+TEST_F(SubdivTest, update_from_mesh_rebuild)
+{
+  Mesh *mesh = test_mesh_grid_create(4, 0.25f);
+  Subdiv *subdiv = BKE_subdiv_update_from_mesh(nullptr, &settings_, mesh);
+  ASSERT_NE(subdiv, nullptr);
+  ASSERT_TRUE(BKE_subdiv_eval_begin_from_mesh(subdiv, mesh, nullptr));
+
+  mesh->medge[0].crease = 255;
+  subdiv = BKE_subdiv_update_from_mesh(subdiv, &settings_, mesh);
+  ASSERT_NE(subdiv, nullptr);
+  EXPECT_EQ(subdiv->evaluator, nullptr);
+
+  ASSERT_TRUE(BKE_subdiv_eval_begin_from_mesh(subdiv, mesh, nullptr));
+  Mesh *mesh_larger = test_mesh_grid_create(5, 0.2f);
+  subdiv = BKE_subdiv_update_from_mesh(subdiv, &settings_, mesh_larger);
+  ASSERT_NE(subdiv, nullptr);
+  EXPECT_EQ(subdiv->evaluator, nullptr);
+
+  BKE_subdiv_free(subdiv);
+  BKE_id_free(nullptr, mesh_larger);
+  BKE_id_free(nullptr, mesh);
+}
+
+#endif
+
+}  // namespace blender::bke::tests
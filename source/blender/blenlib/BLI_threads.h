@@ -164,6 +164,7 @@ void BLI_condition_end(ThreadCondition *cond);
 typedef struct ThreadQueue ThreadQueue;
 
 ThreadQueue *BLI_thread_queue_init(void);
+ThreadQueue *BLI_thread_queue_init_bounded(int max_len);
 void BLI_thread_queue_free(ThreadQueue *queue);
 
 void BLI_thread_queue_push(ThreadQueue *queue, void *work);
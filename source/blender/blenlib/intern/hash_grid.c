@@ -0,0 +1,400 @@
+/*
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ */
+
+/** \file
+ * \ingroup bli
+ *
+ * Points are binned into cubic cells at least twice as large as the search range,
+ * so all neighbors of a point are found in the 2x2x2 block of cells nearest to it:
+ * its own cell and the cells on the side of the closest border along each axis.
+ * Cells are stored in a hash table of buckets (a counting sort of the points),
+ * which keeps memory linear in the number of points regardless of the extent of the set.
+ * The bucket of a cell is its linear index wrapped around the table, so cells next to each other
+ * along X are next to each other in memory, and searches mostly read memory which is cached.
+ *
+ * Clusters are resolved in parallel: cells are colored by their coordinates modulo 3,
+ * so cells of the same color are at least three cells apart and the cells searched around
+ * points in different cells of one color never overlap. Colors are resolved one after another,
+ * so the result is the same as visiting the points serially, whatever the number of threads.
+ */
+
+#include <string.h>
+
+#include "MEM_guardedalloc.h"
+
+#include "BLI_hash_grid.h"
+#include "BLI_math.h"
+#include "BLI_task.h"
+#include "BLI_utildefines.h"
+
+#include "BLI_strict_flags.h"
+
+/** Number of cells along each axis, so linear cell indices never overflow. */
+#define HASH_GRID_AXIS_CELLS_MAX (1 << 20)
+
+/** Points per thread below which multi-threading isn't worth it. */
+#define HASH_GRID_PARALLEL_GRAINSIZE 1024
+
+/** Colors of cells resolved at once, the cell coordinates modulo 3 along each axis. */
+#define HASH_GRID_CELL_COLORS 27
+
+typedef struct HashGrid3D {
+  float min[3];
+  /** Double precision, so the side of a cell a point is on is exact for any extent. */
+  double cell_size_inv;
+  /** Points sorted by bucket, `bucket_points[bucket_offsets[b]..bucket_offsets[b + 1]]`. */
+  uint *bucket_offsets;
+  uint *bucket_points;
+  /** Coordinates and cell colors of the points in the same order, so a bucket is read at once. */
+  float (*bucket_co)[3];
+  uchar *bucket_color;
+  /** Buckets with points of each color, `color_offsets[c]..color_offsets[c + 1]`. */
+  uint color_offsets[HASH_GRID_CELL_COLORS + 1];
+  uint *color_buckets;
+  uint buckets_mask;
+  /** Linear cell index strides along Y and Z. */
+  uint64_t cells_stride[2];
+} HashGrid3D;
+
+/* -------------------------------------------------------------------- */
+/** \name Grid Construction
+ * \{ */
+
+/**
+ * Cell of \a co, optionally \a r_block is the first cell of the 2x2x2 block of cells
+ * containing all points in range.
+ */
+BLI_INLINE void hash_grid_cell_coord(const HashGrid3D *grid,
+                                     const float co[3],
+                                     int r_cell[3],
+                                     int r_block[3])
+{
+  for (int i = 0; i < 3; i++) {
+    const double c = ((double)co[i] - (double)grid->min[i]) * grid->cell_size_inv;
+    const double c_floor = floor(c);
+    r_cell[i] = clamp_i((int)c_floor, 0, HASH_GRID_AXIS_CELLS_MAX);
+    if (r_block) {
+      r_block[i] = (c - c_floor < 0.5) ? max_ii(r_cell[i] - 1, 0) : r_cell[i];
+    }
+  }
+}
+
+BLI_INLINE uchar hash_grid_cell_color(const int cell[3])
+{
+  return (uchar)(cell[0] % 3 + (cell[1] % 3) * 3 + (cell[2] % 3) * 9);
+}
+
+BLI_INLINE uint hash_grid_cell_bucket(const HashGrid3D *grid, const int cell[3])
+{
+  return (uint)(((uint64_t)cell[0] + (uint64_t)cell[1] * grid->cells_stride[0] +
+                 (uint64_t)cell[2] * grid->cells_stride[1]) &
+                grid->buckets_mask);
+}
+
+typedef struct HashGridBuildData {
+  HashGrid3D *grid;
+  const float (*co)[3];
+  uint *point_bucket;
+  uchar *point_color;
+} HashGridBuildData;
+
+static void hash_grid_point_cell_cb(void *__restrict userdata,
+                                    const int i,
+                                    const TaskParallelTLS *__restrict UNUSED(tls))
+{
+  HashGridBuildData *data = userdata;
+  HashGrid3D *grid = data->grid;
+  int cell[3];
+  hash_grid_cell_coord(grid, data->co[i], cell, NULL);
+  data->point_bucket[i] = hash_grid_cell_bucket(grid, cell);
+  data->point_color[i] = hash_grid_cell_color(cell);
+}
+
+static void hash_grid_build(HashGrid3D *grid, const float (*co)[3], const int co_len, float range)
+{
+  float max[3];
+  INIT_MINMAX(grid->min, max);
+  for (int i = 0; i < co_len; i++) {
+    minmax_v3v3_v3(grid->min, max, co[i]);
+  }
+
+  /* Cells can't be smaller than twice the range, nor so small their coordinates overflow.
+   * The small margin ensures points in range are never further than the 2x2x2 block. */
+  float extent[3];
+  sub_v3_v3v3(extent, max, grid->min);
+  double cell_size = max_dd((double)range * 2.0,
+                            (double)max_fff(extent[0], extent[1], extent[2]) /
+                                (double)HASH_GRID_AXIS_CELLS_MAX) *
+                     1.001;
+  if (!(cell_size > 0.0)) {
+    cell_size = 1.0;
+  }
+  grid->cell_size_inv = 1.0 / cell_size;
+  /* One more cell per row and slice, for the neighbors of the last cells. */
+  grid->cells_stride[0] = (uint64_t)(extent[0] * grid->cell_size_inv) + 2;
+  grid->cells_stride[1] = grid->cells_stride[0] *
+                          ((uint64_t)(extent[1] * grid->cell_size_inv) + 2);
+
+  const uint buckets_len = power_of_2_max_u((uint)co_len);
+  grid->buckets_mask = buckets_len - 1;
+  grid->bucket_offsets = MEM_calloc_arrayN(buckets_len + 1, sizeof(uint), __func__);
+  grid->bucket_points = MEM_malloc_arrayN((size_t)co_len, sizeof(uint), __func__);
+  grid->bucket_co = MEM_malloc_arrayN((size_t)co_len, sizeof(*grid->bucket_co), __func__);
+  grid->bucket_color = MEM_malloc_arrayN((size_t)co_len, sizeof(uchar), __func__);
+  uint *point_bucket = MEM_malloc_arrayN((size_t)co_len, sizeof(uint), __func__);
+  uchar *point_color = MEM_malloc_arrayN((size_t)co_len, sizeof(uchar), __func__);
+
+  HashGridBuildData data = {
+      .grid = grid,
+      .co = co,
+      .point_bucket = point_bucket,
+      .point_color = point_color,
+  };
+  TaskParallelSettings settings;
+  BLI_parallel_range_settings_defaults(&settings);
+  settings.min_iter_per_thread = HASH_GRID_PARALLEL_GRAINSIZE;
+  BLI_task_parallel_range(0, co_len, &data, hash_grid_point_cell_cb, &settings);
+
+  /* Counting sort, filled in index order so points are sorted by index inside each bucket. */
+  uint *bucket_offsets = grid->bucket_offsets;
+  for (int i = 0; i < co_len; i++) {
+    bucket_offsets[point_bucket[i] + 1]++;
+  }
+  for (uint b = 0; b < buckets_len; b++) {
+    bucket_offsets[b + 1] += bucket_offsets[b];
+  }
+  uint *bucket_fill = MEM_dupallocN(bucket_offsets);
+  for (int i = 0; i < co_len; i++) {
+    const uint k = bucket_fill[point_bucket[i]]++;
+    grid->bucket_points[k] = (uint)i;
+    copy_v3_v3(grid->bucket_co[k], co[i]);
+    grid->bucket_color[k] = point_color[i];
+  }
+
+  /* Lists of buckets per color, a bucket is in the list of each color of its cells.
+   * The bit-field of colors of each bucket reuses the fill positions, which aren't needed. */
+  uint *bucket_colors = bucket_fill;
+  uint *color_offsets = grid->color_offsets;
+  memset(color_offsets, 0, sizeof(grid->color_offsets));
+  for (uint b = 0; b < buckets_len; b++) {
+    uint colors = 0;
+    for (uint k = bucket_offsets[b]; k < bucket_offsets[b + 1]; k++) {
+      colors |= 1u << grid->bucket_color[k];
+    }
+    bucket_colors[b] = colors;
+    for (uint c = 0; colors; c++, colors >>= 1) {
+      color_offsets[c + 1] += colors & 1u;
+    }
+  }
+  for (uint c = 0; c < HASH_GRID_CELL_COLORS; c++) {
+    color_offsets[c + 1] += color_offsets[c];
+  }
+  grid->color_buckets = MEM_malloc_arrayN(
+      color_offsets[HASH_GRID_CELL_COLORS], sizeof(uint), __func__);
+  uint color_fill[HASH_GRID_CELL_COLORS];
+  memcpy(color_fill, color_offsets, sizeof(color_fill));
+  for (uint b = 0; b < buckets_len; b++) {
+    uint colors = bucket_colors[b];
+    for (uint c = 0; colors; c++, colors >>= 1) {
+      if (colors & 1u) {
+        grid->color_buckets[color_fill[c]++] = b;
+      }
+    }
+  }
+
+  MEM_freeN(bucket_fill);
+  MEM_freeN(point_bucket);
+  MEM_freeN(point_color);
+}
+
+static void hash_grid_free(HashGrid3D *grid)
+{
+  MEM_freeN(grid->bucket_offsets);
+  MEM_freeN(grid->bucket_points);
+  MEM_freeN(grid->bucket_co);
+  MEM_freeN(grid->bucket_color);
+  MEM_freeN(grid->color_buckets);
+}
+
+/** \} */
+
+/* -------------------------------------------------------------------- */
+/** \name BLI_hash_grid_3d_calc_duplicates
+ * \{ */
+
+typedef struct HashGridNeighborsData {
+  const HashGrid3D *grid;
+  float range;
+  float range_sq;
+  /** The color being resolved. */
+  uchar color;
+  int *duplicates;
+} HashGridNeighborsData;
+
+/**
+ * Points are in range when they are not further apart than the range, and closer than the range
+ * along each axis. The latter follows the pruning of the kd-tree search, so a zero range merges
+ * nothing with either of them. Points exactly the range apart along an axis are never merged,
+ * the kd-tree may or may not merge them depending on its splits.
+ */
+BLI_INLINE bool hash_grid_points_in_range(const HashGridNeighborsData *data,
+                                          const float co_a[3],
+                                          const float co_b[3])
+{
+  return (fabsf(co_a[0] - co_b[0]) < data->range) && (fabsf(co_a[1] - co_b[1]) < data->range) &&
+         (fabsf(co_a[2] - co_b[2]) < data->range) &&
+         (len_squared_v3v3(co_a, co_b) <= data->range_sq);
+}
+
+/**
+ * Merge all the candidates (duplicates of -1) in range of point \a i at \a co_i into \a i,
+ * return the number of merges.
+ */
+static int hash_grid_point_merge(const HashGridNeighborsData *data,
+                                 const int i,
+                                 const float co_i[3])
+{
+  const HashGrid3D *grid = data->grid;
+  int cell_i[3], block[3];
+  hash_grid_cell_coord(grid, co_i, cell_i, block);
+
+  int found = 0;
+  int cell[3];
+  for (cell[2] = block[2]; cell[2] <= block[2] + 1; cell[2]++) {
+    for (cell[1] = block[1]; cell[1] <= block[1] + 1; cell[1]++) {
+      for (cell[0] = block[0]; cell[0] <= block[0] + 1; cell[0]++) {
+        const uint bucket = hash_grid_cell_bucket(grid, cell);
+        for (uint k = grid->bucket_offsets[bucket]; k < grid->bucket_offsets[bucket + 1]; k++) {
+          /* Points of other cells sharing the bucket are skipped by the range test, those in
+           * range are in the block too. Visiting a point twice merges it once. */
+          if (!hash_grid_points_in_range(data, co_i, grid->bucket_co[k])) {
+            continue;
+          }
+          const int j = (int)grid->bucket_points[k];
+          if (j == i) {
+            continue;
+          }
+          if (data->duplicates[j] == -1) {
+            data->duplicates[j] = i;
+            found++;
+          }
+        }
+      }
+    }
+  }
+  return found;
+}
+
+/**
+ * Resolve the points of the current color in its \a color_bucket. Points in range of different
+ * cells of the same color never overlap, so the buckets can be resolved in any order.
+ */
+static void hash_grid_resolve_bucket_cb(void *__restrict userdata,
+                                        const int color_bucket,
+                                        const TaskParallelTLS *__restrict tls)
+{
+  HashGridNeighborsData *data = userdata;
+  const HashGrid3D *grid = data->grid;
+  int *duplicates = data->duplicates;
+  int *found = tls->userdata_chunk;
+  const uint b = grid->color_buckets[grid->color_offsets[data->color] + (uint)color_bucket];
+  for (uint k = grid->bucket_offsets[b]; k < grid->bucket_offsets[b + 1]; k++) {
+    if (grid->bucket_color[k] != data->color) {
+      continue;
+    }
+    const int i = (int)grid->bucket_points[k];
+    if (!ELEM(duplicates[i], -1, i)) {
+      continue;
+    }
+    const int found_cluster = hash_grid_point_merge(data, i, grid->bucket_co[k]);
+    if (found_cluster != 0) {
+      /* Prevent chains of doubles. */
+      duplicates[i] = i;
+      *found += found_cluster;
+    }
+  }
+}
+
+static void hash_grid_resolve_reduce(const void *__restrict UNUSED(userdata),
+                                     void *__restrict chunk_join,
+                                     void *__restrict chunk)
+{
+  *(int *)chunk_join += *(int *)chunk;
+}
+
+/**
+ * Find duplicate points in \a range, a parallel alternative to
+ * #BLI_kdtree_3d_calc_duplicates_fast for large point sets.
+ *
+ * Each point not merged yet becomes the target of all remaining candidates in range.
+ * Points are visited by cell color, bucket and index, so which point of an ambiguous cluster
+ * becomes the target differs from the kd-tree, but is independent of the number of threads.
+ *
+ * Points already merged are skipped, so like the kd-tree only targets search their neighbors.
+ * Memory stays linear in the number of points, however dense the clusters are.
+ *
+ * \param co: Coordinates to search, \a co_len long.
+ * \param duplicates: An array of int's the length of \a co_len.
+ * Values initialized to -1 are candidates to be merged.
+ * Setting the index to its own position in the array prevents it from being touched,
+ * although it can still be used as a target.
+ * \returns The number of merges found.
+ *
+ * \note Merging is always a single step (target indices wont be marked for merging).
+ */
+int BLI_hash_grid_3d_calc_duplicates(const float (*co)[3],
+                                     const int co_len,
+                                     const float range,
+                                     int *duplicates)
+{
+  if (co_len == 0) {
+    return 0;
+  }
+
+  HashGrid3D grid;
+  hash_grid_build(&grid, co, co_len, range);
+
+  HashGridNeighborsData data = {
+      .grid = &grid,
+      .range = range,
+      .range_sq = square_f(range),
+      .duplicates = duplicates,
+  };
+
+  int found = 0;
+  int found_color = 0;
+  TaskParallelSettings settings;
+  BLI_parallel_range_settings_defaults(&settings);
+  /* Buckets hold about a point of each color, use the same grain size. */
+  settings.min_iter_per_thread = HASH_GRID_PARALLEL_GRAINSIZE;
+  settings.userdata_chunk = &found_color;
+  settings.userdata_chunk_size = sizeof(found_color);
+  settings.func_reduce = hash_grid_resolve_reduce;
+  for (int color = 0; color < HASH_GRID_CELL_COLORS; color++) {
+    data.color = (uchar)color;
+    found_color = 0;
+    const int color_buckets_len = (int)(grid.color_offsets[color + 1] -
+                                        grid.color_offsets[color]);
+    BLI_task_parallel_range(0, color_buckets_len, &data, hash_grid_resolve_bucket_cb, &settings);
+    found += found_color;
+  }
+
+  hash_grid_free(&grid);
+
+  return found;
+}
+
+/** \} */
@@ -636,20 +636,34 @@ struct ThreadQueue {
   GSQueue *queue;
   pthread_mutex_t mutex;
   pthread_cond_t push_cond;
+  pthread_cond_t pop_cond;
   pthread_cond_t finish_cond;
   volatile int nowait;
   volatile int canceled;
+  int max_len;
 };
 
 ThreadQueue *BLI_thread_queue_init(void)
+{
+  return BLI_thread_queue_init_bounded(0);
+}
+
+/**
+ * Queue which holds at most \a max_len items, pushing to a full queue waits until an item is
+ * popped. This keeps a fast producer from running far ahead of its consumers.
+ * A \a max_len of zero means the queue is not bounded.
+ */
+ThreadQueue *BLI_thread_queue_init_bounded(int max_len)
 {
   ThreadQueue *queue;
 
   queue = static_cast<ThreadQueue *>(MEM_callocN(sizeof(ThreadQueue), "ThreadQueue"));
   queue->queue = BLI_gsqueue_new(sizeof(void *));
+  queue->max_len = max_len;
 
   pthread_mutex_init(&queue->mutex, nullptr);
   pthread_cond_init(&queue->push_cond, nullptr);
+  pthread_cond_init(&queue->pop_cond, nullptr);
   pthread_cond_init(&queue->finish_cond, nullptr);
 
   return queue;
@@ -659,6 +673,7 @@ void BLI_thread_queue_free(ThreadQueue *queue)
 {
   /* destroy everything, assumes no one is using queue anymore */
   pthread_cond_destroy(&queue->finish_cond);
+  pthread_cond_destroy(&queue->pop_cond);
   pthread_cond_destroy(&queue->push_cond);
   pthread_mutex_destroy(&queue->mutex);
 
@@ -671,6 +686,12 @@ void BLI_thread_queue_push(ThreadQueue *queue, void *work)
 {
   pthread_mutex_lock(&queue->mutex);
 
+  /* wait until there is room, a queue which is not waited on anymore takes everything */
+  while (queue->max_len > 0 && !queue->nowait &&
+         BLI_gsqueue_len(queue->queue) >= static_cast<size_t>(queue->max_len)) {
+    pthread_cond_wait(&queue->pop_cond, &queue->mutex);
+  }
+
   BLI_gsqueue_push(queue->queue, &work);
 
   /* signal threads waiting to pop */
@@ -692,6 +713,9 @@ void *BLI_thread_queue_pop(ThreadQueue *queue)
   if (!BLI_gsqueue_is_empty(queue->queue)) {
     BLI_gsqueue_pop(queue->queue, &work);
 
+    /* signal threads waiting to push */
+    pthread_cond_signal(&queue->pop_cond);
+
     if (BLI_gsqueue_is_empty(queue->queue)) {
       pthread_cond_broadcast(&queue->finish_cond);
     }
@@ -761,6 +785,9 @@ void *BLI_thread_queue_pop_timeout(ThreadQueue *queue, int ms)
   if (!BLI_gsqueue_is_empty(queue->queue)) {
     BLI_gsqueue_pop(queue->queue, &work);
 
+    /* signal threads waiting to push */
+    pthread_cond_signal(&queue->pop_cond);
+
     if (BLI_gsqueue_is_empty(queue->queue)) {
       pthread_cond_broadcast(&queue->finish_cond);
     }
@@ -799,8 +826,9 @@ void BLI_thread_queue_nowait(ThreadQueue *queue)
 
   queue->nowait = 1;
 
-  /* signal threads waiting to pop */
+  /* signal threads waiting to pop or push */
   pthread_cond_broadcast(&queue->push_cond);
+  pthread_cond_broadcast(&queue->pop_cond);
   pthread_mutex_unlock(&queue->mutex);
 }
 
@@ -0,0 +1,201 @@
+/* Apache License, Version 2.0 */
+
+#include "testing/testing.h"
+
+#include "MEM_guardedalloc.h"
+
+#include "BLI_hash_grid.h"
+#include "BLI_kdtree.h"
+#include "BLI_math_vector.h"
+#include "BLI_rand.h"
+#include "BLI_timeit.hh"
+
+/* -------------------------------------------------------------------- */
+/* Helper Functions */
+
+/** Random coordinates in a unit cube, with some of them copied over others as exact doubles. */
+static float (*points_random_create(const int points_len, const uint seed))[3]
+{
+  float(*co)[3] = (float(*)[3])MEM_malloc_arrayN(points_len, sizeof(*co), __func__);
+  RNG *rng = BLI_rng_new(seed);
+  for (int i = 0; i < points_len; i++) {
+    co[i][0] = BLI_rng_get_float(rng);
+    co[i][1] = BLI_rng_get_float(rng);
+    co[i][2] = BLI_rng_get_float(rng);
+  }
+  for (int i = 0; i < points_len / 10; i++) {
+    copy_v3_v3(co[BLI_rng_get_int(rng) % points_len], co[BLI_rng_get_int(rng) % points_len]);
+  }
+  BLI_rng_free(rng);
+  return co;
+}
+
+struct NeighborsCheck {
+  const int *duplicates;
+  int index;
+  bool has_target;
+};
+
+static bool neighbors_check_cb(void *user_data, int index, const float * /*co*/, float /*dist_sq*/)
+{
+  NeighborsCheck *check = (NeighborsCheck *)user_data;
+  if (index != check->index && check->duplicates[index] == index) {
+    check->has_target = true;
+    return false;
+  }
+  return true;
+}
+
+/**
+ * Check the clusters are valid whatever the order points were visited in: points merge into
+ * targets in range, and no point left alone has a target (or a kept point) in range.
+ */
+static void hash_grid_calc_duplicates_check(const int points_len, const float range)
+{
+  float(*co)[3] = points_random_create(points_len, 1);
+  int *duplicates = (int *)MEM_malloc_arrayN(points_len, sizeof(int), __func__);
+  for (int i = 0; i < points_len; i++) {
+    /* Some points are kept in place, but can be used as targets. */
+    duplicates[i] = (i % 97 == 0) ? i : -1;
+  }
+
+  const int found = BLI_hash_grid_3d_calc_duplicates(co, points_len, range, duplicates);
+  EXPECT_GT(found, 0);
+
+  KDTree_3d *tree = BLI_kdtree_3d_new(points_len);
+  for (int i = 0; i < points_len; i++) {
+    BLI_kdtree_3d_insert(tree, i, co[i]);
+  }
+  BLI_kdtree_3d_balance(tree);
+
+  int merged = 0;
+  for (int i = 0; i < points_len; i++) {
+    const int target = duplicates[i];
+    if (i % 97 == 0) {
+      EXPECT_EQ(target, i);
+    }
+    if (target == -1) {
+      NeighborsCheck check = {duplicates, i, false};
+      BLI_kdtree_3d_range_search_cb(tree, co[i], range, neighbors_check_cb, &check);
+      EXPECT_FALSE(check.has_target);
+    }
+    else if (target != i) {
+      EXPECT_EQ(duplicates[target], target);
+      EXPECT_LE(len_v3v3(co[i], co[target]), range);
+      merged++;
+    }
+  }
+  EXPECT_EQ(found, merged);
+
+  BLI_kdtree_3d_free(tree);
+  MEM_freeN(co);
+  MEM_freeN(duplicates);
+}
+
+/* -------------------------------------------------------------------- */
+/* Tests */
+
+TEST(hash_grid, Empty)
+{
+  EXPECT_EQ(BLI_hash_grid_3d_calc_duplicates(nullptr, 0, 0.1f, nullptr), 0);
+}
+
+TEST(hash_grid, Coincident)
+{
+  const float co[4][3] = {{1, 2, 3}, {1, 2, 3}, {1, 2, 3}, {1, 2, 3}};
+  int duplicates[4] = {-1, -1, -1, -1};
+  EXPECT_EQ(BLI_hash_grid_3d_calc_duplicates(co, 4, 1e-5f, duplicates), 3);
+  for (int i = 0; i < 4; i++) {
+    EXPECT_EQ(duplicates[i], 0);
+  }
+
+  /* Like the kd-tree, a zero range merges nothing. */
+  int duplicates_zero[4] = {-1, -1, -1, -1};
+  EXPECT_EQ(BLI_hash_grid_3d_calc_duplicates(co, 4, 0.0f, duplicates_zero), 0);
+}
+
+/** Points further apart than the range are never merged, also not through a chain. */
+TEST(hash_grid, Chain)
+{
+  const float co[4][3] = {{0, 0, 0}, {0.6f, 0, 0}, {1.2f, 0, 0}, {1.8f, 0, 0}};
+  int duplicates[4] = {-1, -1, -1, -1};
+  EXPECT_EQ(BLI_hash_grid_3d_calc_duplicates(co, 4, 1.0f, duplicates), 2);
+  EXPECT_EQ(duplicates[0], 0);
+  EXPECT_EQ(duplicates[1], 0);
+  EXPECT_EQ(duplicates[2], 2);
+  EXPECT_EQ(duplicates[3], 2);
+}
+
+/** All points in range of each other, everything merges into the first point. */
+TEST(hash_grid, DenseCluster)
+{
+  const int points_len = 100000;
+  float(*co)[3] = points_random_create(points_len, 3);
+  int *duplicates = (int *)MEM_malloc_arrayN(points_len, sizeof(int), __func__);
+  for (int i = 0; i < points_len; i++) {
+    duplicates[i] = -1;
+  }
+  EXPECT_EQ(BLI_hash_grid_3d_calc_duplicates(co, points_len, 2.0f, duplicates),
+            points_len - 1);
+  for (int i = 0; i < points_len; i++) {
+    EXPECT_EQ(duplicates[i], 0);
+  }
+  MEM_freeN(co);
+  MEM_freeN(duplicates);
+}
+
+TEST(hash_grid, ValidClusters_Small)
+{
+  hash_grid_calc_duplicates_check(1000, 0.05f);
+}
+TEST(hash_grid, ValidClusters_Large)
+{
+  hash_grid_calc_duplicates_check(100000, 0.005f);
+}
+
+/* Merge by distance throughput as done by the weld modifier, compare `kdtree_*` (searching the
+ * kd-tree) with `grid_*` timings. */
+
+static void calc_duplicates_performance(const int points_len, const bool use_grid)
+{
+  float(*co)[3] = points_random_create(points_len, 2);
+  int *duplicates = (int *)MEM_malloc_arrayN(points_len, sizeof(int), __func__);
+  for (int i = 0; i < points_len; i++) {
+    duplicates[i] = -1;
+  }
+  const float range = 1.0f / cbrtf((float)points_len);
+  {
+    SCOPED_TIMER(use_grid ? "grid" : "kdtree");
+    if (use_grid) {
+      BLI_hash_grid_3d_calc_duplicates(co, points_len, range, duplicates);
+    }
+    else {
+      KDTree_3d *tree = BLI_kdtree_3d_new(points_len);
+      for (int i = 0; i < points_len; i++) {
+        BLI_kdtree_3d_insert(tree, i, co[i]);
+      }
+      BLI_kdtree_3d_balance(tree);
+      BLI_kdtree_3d_calc_duplicates_fast(tree, range, false, duplicates);
+      BLI_kdtree_3d_free(tree);
+    }
+  }
+  MEM_freeN(co);
+  MEM_freeN(duplicates);
+}
+
+TEST(hash_grid, DISABLED_calc_duplicates_performance_kdtree_50000)
+{
+  calc_duplicates_performance(50000, false);
+}
+TEST(hash_grid, DISABLED_calc_duplicates_performance_grid_50000)
+{
+  calc_duplicates_performance(50000, true);
+}
+TEST(hash_grid, DISABLED_calc_duplicates_performance_kdtree_1000000)
+{
+  calc_duplicates_performance(1000000, false);
+}
+TEST(hash_grid, DISABLED_calc_duplicates_performance_grid_1000000)
+{
+  calc_duplicates_performance(1000000, true);
+}
@@ -0,0 +1,72 @@
+/* Apache License, Version 2.0 */
+
+#include "testing/testing.h"
+#include <thread>
+
+#include "BLI_math_base.h"
+#include "BLI_threads.h"
+#include "BLI_utildefines.h"
+
+#define NUM_ITEMS 1000
+#define MAX_LEN 4
+
+TEST(thread_queue, Order)
+{
+  ThreadQueue *queue = BLI_thread_queue_init();
+
+  for (intptr_t i = 1; i <= NUM_ITEMS; i++) {
+    BLI_thread_queue_push(queue, (void *)i);
+  }
+  EXPECT_EQ(BLI_thread_queue_len(queue), NUM_ITEMS);
+
+  BLI_thread_queue_nowait(queue);
+  for (intptr_t i = 1; i <= NUM_ITEMS; i++) {
+    EXPECT_EQ((intptr_t)BLI_thread_queue_pop(queue), i);
+  }
+  EXPECT_TRUE(BLI_thread_queue_is_empty(queue));
+  EXPECT_EQ(BLI_thread_queue_pop(queue), nullptr);
+
+  BLI_thread_queue_free(queue);
+}
+
+TEST(thread_queue, Bounded)
+{
+  ThreadQueue *queue = BLI_thread_queue_init_bounded(MAX_LEN);
+  int max_len = 0;
+
+  std::thread consumer([&]() {
+    intptr_t expected = 1;
+    while (void *work = BLI_thread_queue_pop(queue)) {
+      EXPECT_EQ((intptr_t)work, expected++);
+    }
+    EXPECT_EQ(expected, NUM_ITEMS + 1);
+  });
+
+  for (intptr_t i = 1; i <= NUM_ITEMS; i++) {
+    BLI_thread_queue_push(queue, (void *)i);
+    max_len = max_ii(max_len, BLI_thread_queue_len(queue));
+  }
+  BLI_thread_queue_nowait(queue);
+  consumer.join();
+
+  EXPECT_LE(max_len, MAX_LEN);
+  EXPECT_TRUE(BLI_thread_queue_is_empty(queue));
+
+  BLI_thread_queue_free(queue);
+}
+
+/* Once nothing waits for new items anymore, pushing to a full queue does not block. */
+TEST(thread_queue, BoundedNoWait)
+{
+  ThreadQueue *queue = BLI_thread_queue_init_bounded(MAX_LEN);
+
+  BLI_thread_queue_nowait(queue);
+  for (intptr_t i = 1; i <= MAX_LEN * 2; i++) {
+    BLI_thread_queue_push(queue, (void *)i);
+  }
+  EXPECT_EQ(BLI_thread_queue_len(queue), MAX_LEN * 2);
+
+  while (BLI_thread_queue_pop(queue)) {
+  }
+  BLI_thread_queue_free(queue);
+}
@@ -1490,5 +1490,14 @@ void blo_do_versions_290(FileData *fd, Library *UNUSED(lib), Main *bmain)
    */
   {
     /* Keep this block, even when empty. */
+
+    if (!DNA_struct_elem_find(fd->filesdna, "bNodeTree", "int", "cache_size")) {
+      FOREACH_NODETREE_BEGIN (bmain, ntree, id) {
+        if (ntree->type == NTREE_COMPOSIT) {
+          ntree->cache_size = 1024;
+        }
+      }
+      FOREACH_NODETREE_END;
+    }
   }
 }
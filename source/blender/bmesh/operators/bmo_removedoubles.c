@@ -23,6 +23,7 @@
 #include "MEM_guardedalloc.h"
 
 #include "BLI_alloca.h"
+#include "BLI_hash_grid.h"
 #include "BLI_kdtree.h"
 #include "BLI_listbase.h"
 #include "BLI_math.h"
@@ -652,9 +653,9 @@ static void bmesh_find_doubles_common(BMesh *bm,
 
   int *duplicates = MEM_mallocN(sizeof(int) * verts_len, __func__);
   {
-    KDTree_3d *tree = BLI_kdtree_3d_new(verts_len);
+    float(*verts_co)[3] = MEM_mallocN(sizeof(*verts_co) * verts_len, __func__);
     for (int i = 0; i < verts_len; i++) {
-      BLI_kdtree_3d_insert(tree, i, verts[i]->co);
+      copy_v3_v3(verts_co[i], verts[i]->co);
       if (has_keep_vert && BMO_vert_flag_test(bm, verts[i], VERT_KEEP)) {
         duplicates[i] = i;
       }
@@ -663,9 +664,20 @@ static void bmesh_find_doubles_common(BMesh *bm,
       }
     }
 
-    BLI_kdtree_3d_balance(tree);
-    found_duplicates = BLI_kdtree_3d_calc_duplicates_fast(tree, dist, false, duplicates) != 0;
-    BLI_kdtree_3d_free(tree);
+    if (verts_len < BLI_HASH_GRID_POINTS_MIN) {
+      KDTree_3d *tree = BLI_kdtree_3d_new(verts_len);
+      for (int i = 0; i < verts_len; i++) {
+        BLI_kdtree_3d_insert(tree, i, verts_co[i]);
+      }
+      BLI_kdtree_3d_balance(tree);
+      found_duplicates = BLI_kdtree_3d_calc_duplicates_fast(tree, dist, false, duplicates) != 0;
+      BLI_kdtree_3d_free(tree);
+    }
+    else {
+      found_duplicates = BLI_hash_grid_3d_calc_duplicates(
+                             (const float(*)[3])verts_co, verts_len, dist, duplicates) != 0;
+    }
+    MEM_freeN(verts_co);
   }
 
   if (found_duplicates) {
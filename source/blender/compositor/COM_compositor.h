@@ -357,7 +357,13 @@ void COM_deinitialize(void);
  * \brief Clear all compositor caches. (Compositor system will still remain available).
  * To deinitialize the compositor use the COM_deinitialize method.
  */
-// void COM_clearCaches(void); // NOT YET WRITTEN
+void COM_clearCaches(void);
+
+/**
+ * \brief Clear cached node results that depend on render results.
+ * Called when scenes are rendered again, so render layer nodes read the new result.
+ */
+void COM_clearRenderLayerCaches(void);
 
 #ifdef __cplusplus
 }
@@ -268,6 +268,42 @@ class CompositorContext {
     return (this->getbNodeTree()->flag & NTREE_COM_GROUPNODE_BUFFER) != 0;
   }
 
+  /**
+   * \brief is full frame execution enabled, computing rows of pixels at once
+   * \see FusedRowProgram
+   */
+  bool isFullFrameEnabled() const
+  {
+    return (this->getbNodeTree()->flag & NTREE_COM_FULL_FRAME) != 0;
+  }
+
+  /**
+   * \brief are node results kept between executions
+   * \see ResultCache
+   */
+  bool isResultCacheEnabled() const
+  {
+    return (this->getbNodeTree()->flag & NTREE_COM_RESULT_CACHE) != 0;
+  }
+
+  /**
+   * \brief are intermediate color buffers stored as half floats
+   * \see MemoryProxy.setUseHalfFloat
+   */
+  bool isHalfFloatBuffersEnabled() const
+  {
+    return (this->getbNodeTree()->flag & NTREE_COM_HALF_BUFFERS) != 0;
+  }
+
+  /**
+   * \brief memory budget of the result cache in bytes
+   */
+  size_t getResultCacheSize() const
+  {
+    const int cache_size = this->getbNodeTree()->cache_size;
+    return (cache_size > 0) ? (size_t)cache_size * 1024 * 1024 : 0;
+  }
+
   /**
    * \brief Get the render percentage as a factor.
    * The compositor uses a factor i.o. a percentage.
@@ -150,6 +150,24 @@ void ExecutionGroup::initExecution()
   this->m_cachedMaxReadBufferOffset = maxNumber;
 }
 
+void ExecutionGroup::markAllChunksExecuted()
+{
+  for (unsigned int index = 0; index < this->m_numberOfChunks; index++) {
+    this->m_chunkExecutionStates[index] = COM_ES_EXECUTED;
+  }
+  this->m_chunksFinished = this->m_numberOfChunks;
+}
+
+bool ExecutionGroup::isFullyExecuted() const
+{
+  for (unsigned int index = 0; index < this->m_numberOfChunks; index++) {
+    if (this->m_chunkExecutionStates[index] != COM_ES_EXECUTED) {
+      return false;
+    }
+  }
+  return true;
+}
+
 void ExecutionGroup::deinitExecution()
 {
   if (this->m_chunkExecutionStates != nullptr) {
@@ -425,6 +425,17 @@ class ExecutionGroup {
     this->m_chunkSize = chunksize;
   }
 
+  /**
+   * \brief mark all chunks as executed, when the result is taken from the result cache
+   * \see ResultCache
+   */
+  void markAllChunksExecuted();
+
+  /**
+   * \brief have all chunks of the group been executed
+   */
+  bool isFullyExecuted() const;
+
   /**
    * \brief get the Render priority of this ExecutionGroup
    * \see ExecutionSystem.execute
@@ -18,9 +18,11 @@
 
 #include "COM_ExecutionSystem.h"
 
+#include "BLI_string.h"
 #include "BLI_utildefines.h"
 #include "PIL_time.h"
 
+#include "BKE_global.h"
 #include "BKE_node.h"
 
 #include "BLT_translation.h"
@@ -32,6 +34,10 @@
 #include "COM_NodeOperationBuilder.h"
 #include "COM_ReadBufferOperation.h"
 #include "COM_WorkScheduler.h"
+#include "COM_WriteBufferOperation.h"
+
+#include <set>
+#include <typeinfo>
 
 #ifdef WITH_CXX_GUARDEDALLOC
 #  include "MEM_guardedalloc.h"
@@ -51,6 +57,8 @@ ExecutionSystem::ExecutionSystem(RenderData *rd,
   this->m_context.setbNodeTree(editingtree);
   this->m_context.setPreviewHash(editingtree->previews);
   this->m_context.setFastCalculation(fastcalculation);
+  this->m_proxyMemory = 0;
+  this->m_proxyMemoryPeak = 0;
   /* initialize the CompositorContext */
   if (rendering) {
     this->m_context.setQuality((CompositorQuality)editingtree->render_quality);
@@ -147,27 +155,21 @@ void ExecutionSystem::execute()
   }
   unsigned int index;
 
-  // First allocale all write buffer
+  // First initialize all write buffers, they are allocated when an output group needs them
   for (index = 0; index < this->m_operations.size(); index++) {
     NodeOperation *operation = this->m_operations[index];
     if (operation->isWriteBufferOperation()) {
       operation->setbNodeTree(this->m_context.getbNodeTree());
+      operation->setFullFrame(this->m_context.isFullFrameEnabled());
       operation->initExecution();
     }
   }
-  // Connect read buffers to their write buffers
-  for (index = 0; index < this->m_operations.size(); index++) {
-    NodeOperation *operation = this->m_operations[index];
-    if (operation->isReadBufferOperation()) {
-      ReadBufferOperation *readOperation = (ReadBufferOperation *)operation;
-      readOperation->updateMemoryBuffer();
-    }
-  }
   // initialize other operations
   for (index = 0; index < this->m_operations.size(); index++) {
     NodeOperation *operation = this->m_operations[index];
     if (!operation->isWriteBufferOperation()) {
       operation->setbNodeTree(this->m_context.getbNodeTree());
+      operation->setFullFrame(this->m_context.isFullFrameEnabled());
       operation->initExecution();
     }
   }
@@ -177,16 +179,78 @@ void ExecutionSystem::execute()
     executionGroup->initExecution();
   }
 
-  WorkScheduler::start(this->m_context);
+  determineHalfFloatProxies();
+
+  if (this->m_context.isResultCacheEnabled()) {
+    computeResultKeys();
+  }
+  else {
+    ResultCache::clear(this->m_context.getScene());
+  }
 
-  executeGroups(COM_PRIORITY_HIGH);
+  Groups outputGroups;
+  findOutputExecutionGroup(&outputGroups, COM_PRIORITY_HIGH);
   if (!this->getContext().isFastCalculation()) {
-    executeGroups(COM_PRIORITY_MEDIUM);
-    executeGroups(COM_PRIORITY_LOW);
+    findOutputExecutionGroup(&outputGroups, COM_PRIORITY_MEDIUM);
+    findOutputExecutionGroup(&outputGroups, COM_PRIORITY_LOW);
+  }
+
+  /* Memory proxies are allocated before the first output group that needs them is executed, and
+   * freed after the last one, so only the buffers of the part of the tree that is being computed
+   * are in memory. Write buffers without execution group are allocated for the whole execution,
+   * buffers no output group depends on are never allocated.
+   */
+  std::map<MemoryProxy *, unsigned int> lastUse;
+  determineProxyLifetimes(outputGroups, lastUse);
+  this->m_proxyMemory = 0;
+  this->m_proxyMemoryPeak = 0;
+  for (index = 0; index < this->m_operations.size(); index++) {
+    NodeOperation *operation = this->m_operations[index];
+    if (operation->isWriteBufferOperation()) {
+      MemoryProxy *proxy = ((WriteBufferOperation *)operation)->getMemoryProxy();
+      if (proxy->getExecutor() == nullptr) {
+        allocateProxy(proxy);
+      }
+    }
+  }
+
+  WorkScheduler::start(this->m_context);
+
+  for (unsigned int groupIndex = 0; groupIndex < outputGroups.size(); groupIndex++) {
+    allocateProxies(outputGroups[groupIndex]);
+
+    // Connect read buffers to their write buffers
+    for (index = 0; index < this->m_operations.size(); index++) {
+      NodeOperation *operation = this->m_operations[index];
+      if (operation->isReadBufferOperation()) {
+        ReadBufferOperation *readOperation = (ReadBufferOperation *)operation;
+        readOperation->updateMemoryBuffer();
+      }
+    }
+
+    outputGroups[groupIndex]->execute(this);
+
+    /* Chunks can still be running when execution was cancelled. */
+    WorkScheduler::finish();
+
+    for (std::map<MemoryProxy *, unsigned int>::iterator it = lastUse.begin();
+         it != lastUse.end();
+         ++it) {
+      if (it->second == groupIndex) {
+        freeProxy(it->first);
+      }
+    }
   }
 
   WorkScheduler::finish();
   WorkScheduler::stop();
+  this->m_resultKeys.clear();
+
+  if (G.debug & G_DEBUG) {
+    char formatted_mem[15];
+    BLI_str_format_byte_unit(formatted_mem, (long long int)this->m_proxyMemoryPeak, false);
+    printf("Compositor: peak buffer memory %s\n", formatted_mem);
+  }
 
   editingtree->stats_draw(editingtree->sdh, TIP_("Compositing | De-initializing execution"));
   for (index = 0; index < this->m_operations.size(); index++) {
@@ -199,18 +263,218 @@ void ExecutionSystem::execute()
   }
 }
 
-void ExecutionSystem::executeGroups(CompositorPriority priority)
+bool ExecutionSystem::computeResultKey(NodeOperation *operation,
+                                       const ResultCacheKey &contextKey,
+                                       std::map<NodeOperation *, ResultCacheKey> &keys,
+                                       std::map<NodeOperation *, bool> &valid)
+{
+  std::map<NodeOperation *, bool>::iterator found = valid.find(operation);
+  if (found != valid.end()) {
+    return found->second;
+  }
+
+  /* Guard against reading back our own key while the inputs are being hashed. */
+  valid[operation] = false;
+
+  if (operation->isReadBufferOperation()) {
+    ReadBufferOperation *readOperation = (ReadBufferOperation *)operation;
+    WriteBufferOperation *writeOperation =
+        readOperation->getMemoryProxy()->getWriteBufferOperation();
+    if (!computeResultKey(writeOperation, contextKey, keys, valid)) {
+      return false;
+    }
+    keys[operation] = keys[writeOperation];
+    valid[operation] = true;
+    return true;
+  }
+
+  if (!operation->isResultCacheable()) {
+    return false;
+  }
+
+  ResultCacheKey key;
+  key.add(contextKey);
+  key.add(typeid(*operation).name());
+  key.add(operation->getNodeHash());
+  key.add((uint64_t)operation->getWidth());
+  key.add((uint64_t)operation->getHeight());
+  if (!operation->hashExternalData(key)) {
+    return false;
+  }
+
+  for (unsigned int index = 0; index < operation->getNumberOfInputSockets(); index++) {
+    NodeOperationOutput *link = operation->getInputSocket(index)->getLink();
+    if (link == nullptr) {
+      key.add((uint64_t)0);
+      continue;
+    }
+    NodeOperation *input = &link->getOperation();
+    if (!computeResultKey(input, contextKey, keys, valid)) {
+      return false;
+    }
+    key.add(keys[input]);
+  }
+
+  keys[operation] = key;
+  valid[operation] = true;
+  return true;
+}
+
+void ExecutionSystem::computeResultKeys()
+{
+  ResultCacheKey contextKey;
+  contextKey.add((uint64_t)this->m_context.getQuality());
+  contextKey.add((uint64_t)this->m_context.isFastCalculation());
+  contextKey.add((uint64_t)this->m_context.getHasActiveOpenCLDevices());
+  contextKey.add(this->m_context.getViewName() ? this->m_context.getViewName() : "");
+
+  std::map<NodeOperation *, ResultCacheKey> keys;
+  std::map<NodeOperation *, bool> valid;
+
+  this->m_resultKeys.clear();
+  for (unsigned int index = 0; index < this->m_operations.size(); index++) {
+    NodeOperation *operation = this->m_operations[index];
+    if (!operation->isWriteBufferOperation()) {
+      continue;
+    }
+    WriteBufferOperation *writeOperation = (WriteBufferOperation *)operation;
+    MemoryProxy *proxy = writeOperation->getMemoryProxy();
+    if (proxy->getExecutor() == nullptr ||
+        !computeResultKey(writeOperation, contextKey, keys, valid)) {
+      continue;
+    }
+    this->m_resultKeys[proxy] = keys[writeOperation];
+  }
+}
+
+void ExecutionSystem::determineHalfFloatProxies()
 {
+  /* OpenCL devices read and write the float data directly. */
+  if (!this->m_context.isHalfFloatBuffersEnabled() ||
+      this->m_context.getHasActiveOpenCLDevices()) {
+    return;
+  }
+
+  /* Complex operations get the MemoryBuffer of their inputs and can access its data directly,
+   * other operations only use its read methods. */
+  std::set<MemoryProxy *> directAccess;
   unsigned int index;
-  vector<ExecutionGroup *> executionGroups;
-  this->findOutputExecutionGroup(&executionGroups, priority);
+  for (index = 0; index < this->m_operations.size(); index++) {
+    NodeOperation *operation = this->m_operations[index];
+    if (!operation->isComplex()) {
+      continue;
+    }
+    for (unsigned int input = 0; input < operation->getNumberOfInputSockets(); input++) {
+      NodeOperationOutput *link = operation->getInputSocket(input)->getLink();
+      if (link && link->getOperation().isReadBufferOperation()) {
+        ReadBufferOperation *readOperation = (ReadBufferOperation *)&link->getOperation();
+        directAccess.insert(readOperation->getMemoryProxy());
+      }
+    }
+  }
 
-  for (index = 0; index < executionGroups.size(); index++) {
-    ExecutionGroup *group = executionGroups[index];
-    group->execute(this);
+  for (index = 0; index < this->m_operations.size(); index++) {
+    NodeOperation *operation = this->m_operations[index];
+    if (!operation->isWriteBufferOperation()) {
+      continue;
+    }
+    MemoryProxy *proxy = ((WriteBufferOperation *)operation)->getMemoryProxy();
+    if (proxy->getDataType() == COM_DT_COLOR && directAccess.find(proxy) == directAccess.end()) {
+      proxy->setUseHalfFloat(true);
+    }
   }
 }
 
+void ExecutionSystem::determineProxyLifetimes(const Groups &outputGroups,
+                                              std::map<MemoryProxy *, unsigned int> &r_lastUse)
+{
+  for (unsigned int groupIndex = 0; groupIndex < outputGroups.size(); groupIndex++) {
+    std::set<ExecutionGroup *> visited;
+    Groups stack(1, outputGroups[groupIndex]);
+    while (!stack.empty()) {
+      ExecutionGroup *group = stack.back();
+      stack.pop_back();
+
+      vector<MemoryProxy *> memoryProxies;
+      group->determineDependingMemoryProxies(&memoryProxies);
+      for (unsigned int index = 0; index < memoryProxies.size(); index++) {
+        MemoryProxy *proxy = memoryProxies[index];
+        ExecutionGroup *executor = proxy->getExecutor();
+        if (executor == nullptr) {
+          continue;
+        }
+        r_lastUse[proxy] = groupIndex;
+        if (visited.insert(executor).second) {
+          stack.push_back(executor);
+        }
+      }
+    }
+  }
+}
+
+void ExecutionSystem::allocateProxies(ExecutionGroup *outputGroup)
+{
+  std::set<ExecutionGroup *> visited;
+  Groups stack(1, outputGroup);
+  while (!stack.empty()) {
+    ExecutionGroup *group = stack.back();
+    stack.pop_back();
+
+    vector<MemoryProxy *> memoryProxies;
+    group->determineDependingMemoryProxies(&memoryProxies);
+    for (unsigned int index = 0; index < memoryProxies.size(); index++) {
+      MemoryProxy *proxy = memoryProxies[index];
+      ExecutionGroup *executor = proxy->getExecutor();
+      if (executor == nullptr) {
+        continue;
+      }
+      if (proxy->getBuffer() == nullptr) {
+        allocateProxy(proxy);
+      }
+      if (!executor->isFullyExecuted() && visited.insert(executor).second) {
+        stack.push_back(executor);
+      }
+    }
+  }
+}
+
+void ExecutionSystem::allocateProxy(MemoryProxy *proxy)
+{
+  WriteBufferOperation *writeOperation = proxy->getWriteBufferOperation();
+  proxy->allocate(writeOperation->getWidth(), writeOperation->getHeight());
+  this->m_proxyMemory += proxy->getBuffer()->getMemorySize();
+  this->m_proxyMemoryPeak = std::max(this->m_proxyMemoryPeak, this->m_proxyMemory);
+
+  std::map<MemoryProxy *, ResultCacheKey>::iterator it = this->m_resultKeys.find(proxy);
+  if (it != this->m_resultKeys.end() && ResultCache::lookup(it->second, proxy->getBuffer())) {
+    proxy->getExecutor()->markAllChunksExecuted();
+    this->m_resultKeys.erase(it);
+  }
+}
+
+void ExecutionSystem::freeProxy(MemoryProxy *proxy)
+{
+  if (proxy->getBuffer() == nullptr) {
+    return;
+  }
+
+  std::map<MemoryProxy *, ResultCacheKey>::iterator it = this->m_resultKeys.find(proxy);
+  if (it != this->m_resultKeys.end()) {
+    const bNodeTree *editingtree = this->m_context.getbNodeTree();
+    /* Only groups that were fully executed, viewers only compute the visible area. */
+    if (proxy->getExecutor()->isFullyExecuted() && !editingtree->test_break(editingtree->tbh)) {
+      ResultCache::store(it->second,
+                         this->m_context.getScene(),
+                         proxy->getBuffer(),
+                         this->m_context.getResultCacheSize());
+    }
+    this->m_resultKeys.erase(it);
+  }
+
+  this->m_proxyMemory -= proxy->getBuffer()->getMemorySize();
+  proxy->free();
+}
+
 void ExecutionSystem::findOutputExecutionGroup(vector<ExecutionGroup *> *result,
                                                CompositorPriority priority) const
 {
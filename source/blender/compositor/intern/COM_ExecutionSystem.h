@@ -17,6 +17,7 @@
  */
 
 class ExecutionGroup;
+class WriteBufferOperation;
 
 #pragma once
 
@@ -24,6 +25,7 @@ class ExecutionGroup;
 #include "COM_ExecutionGroup.h"
 #include "COM_Node.h"
 #include "COM_NodeOperation.h"
+#include "COM_ResultCache.h"
 #include "DNA_color_types.h"
 #include "DNA_node_types.h"
 
@@ -133,6 +135,18 @@ class ExecutionSystem {
    */
   Groups m_groups;
 
+  /**
+   * \brief result cache keys of the memory proxies that were not filled from the cache yet
+   * \see ResultCache
+   */
+  std::map<MemoryProxy *, ResultCacheKey> m_resultKeys;
+
+  /**
+   * \brief memory of the allocated memory proxies, and the most that was in use at once
+   */
+  size_t m_proxyMemory;
+  size_t m_proxyMemoryPeak;
+
  private:  // methods
   /**
    * find all execution group with output nodes
@@ -145,6 +159,53 @@ class ExecutionSystem {
    */
   void findOutputExecutionGroup(vector<ExecutionGroup *> *result) const;
 
+  /**
+   * \brief compute the result cache key of an operation and the operations it reads from
+   * \return false when the result can't be cached
+   */
+  bool computeResultKey(NodeOperation *operation,
+                        const ResultCacheKey &contextKey,
+                        std::map<NodeOperation *, ResultCacheKey> &keys,
+                        std::map<NodeOperation *, bool> &valid);
+
+  /**
+   * \brief compute the result cache keys of the write buffers
+   */
+  void computeResultKeys();
+
+  /**
+   * \brief store color buffers as half floats, except the ones complex operations read from
+   * directly
+   */
+  void determineHalfFloatProxies();
+
+  /**
+   * \brief determine after which output execution group each memory proxy is no longer used
+   * \param outputGroups: output execution groups in the order they are executed
+   * \param r_lastUse: index in outputGroups of the last group depending on the memory proxy,
+   * directly or through other execution groups
+   */
+  void determineProxyLifetimes(const Groups &outputGroups,
+                               std::map<MemoryProxy *, unsigned int> &r_lastUse);
+
+  /**
+   * \brief allocate the memory proxies an output execution group depends on
+   * Memory proxies whose execution group has already been executed, or is filled from the result
+   * cache, don't need the memory proxies they depend on.
+   */
+  void allocateProxies(ExecutionGroup *outputGroup);
+
+  /**
+   * \brief allocate a memory proxy, filling it from the result cache when possible
+   * The execution group writing a cached result is marked as executed so it is skipped.
+   */
+  void allocateProxy(MemoryProxy *proxy);
+
+  /**
+   * \brief free a memory proxy after it is no longer used, storing it in the result cache
+   */
+  void freeProxy(MemoryProxy *proxy);
+
  public:
   /**
    * \brief Create a new ExecutionSystem and initialize it with the
@@ -186,8 +247,6 @@ class ExecutionSystem {
   }
 
  private:
-  void executeGroups(CompositorPriority priority);
-
   /* allow the DebugInfo class to look at internals */
   friend class DebugInfo;
 
@@ -0,0 +1,636 @@
+/*
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ *
+ * Copyright 2020, Blender Foundation.
+ */
+
+#include "COM_FFTConvolution.h"
+#include "COM_defines.h"
+
+#include <cmath>
+#include <cstddef>
+#include <cstring>
+
+#include "BLI_math_base.h"
+#include "BLI_task.h"
+#include "BLI_utildefines.h"
+
+#include "MEM_guardedalloc.h"
+
+#ifdef __SSE2__
+#  include <emmintrin.h>
+#endif
+
+/* Minimum size of blocks. */
+#define FFT_MIN_BLOCK_SIZE 64
+/* Kernel size up to which blocks are four times the kernel size, instead of two times. */
+#define FFT_LARGE_KERNEL_SIZE 512
+/* Blocks up to this number of pixels are transformed by a single thread, with multiple blocks
+ * processed at once. Larger blocks are processed one at a time and threaded internally. */
+#define FFT_SMALL_BLOCK_SIZE (256 * 256)
+/* Rows and columns of the tiles that blocks are transposed in. */
+#define FFT_TRANSPOSE_TILE 32
+
+static void parallel_range(
+    int start, int stop, void *userdata, TaskParallelRangeFunc func, bool use_threading)
+{
+  TaskParallelSettings settings;
+  BLI_parallel_range_settings_defaults(&settings);
+  settings.use_threading = use_threading;
+  BLI_task_parallel_range(start, stop, userdata, func, &settings);
+}
+
+/* ******** Transforms ******** */
+
+/* Twiddle factors `exp(-pi i k / half)` of all stages of a transform. The stage that combines
+ * transforms of size half into transforms of size 2 * half uses the factors at half - 1. */
+struct FFTTwiddles {
+  int size;
+  std::vector<float> re;
+  std::vector<float> im;
+
+  FFTTwiddles(int size) : size(size), re(max_ii(size - 1, 1)), im(max_ii(size - 1, 1))
+  {
+    for (int half = 1; half < size; half <<= 1) {
+      for (int k = 0; k < half; k++) {
+        const double angle = -M_PI * k / half;
+        re[half - 1 + k] = (float)cos(angle);
+        im[half - 1 + k] = (float)sin(angle);
+      }
+    }
+  }
+};
+
+/* Block of complex values, with real and imaginary parts in separate arrays so butterflies
+ * vectorize. Rows are transformed in place, columns are transformed as rows of the transposed
+ * block, which keeps memory access sequential for large blocks. */
+struct FFTBlock {
+  int width;
+  int height;
+  const FFTTwiddles *twiddles_x;
+  const FFTTwiddles *twiddles_y;
+  /* Spatial values, height rows of width values. */
+  float *re;
+  float *im;
+  /* Spectrum, transposed: width rows of height values. */
+  float *t_re;
+  float *t_im;
+  bool use_threading;
+
+  FFTBlock(int width, int height, const FFTTwiddles *twiddles_x, const FFTTwiddles *twiddles_y)
+      : width(width), height(height), twiddles_x(twiddles_x), twiddles_y(twiddles_y)
+  {
+    const size_t size = sizeof(float) * width * height;
+    re = (float *)MEM_mallocN(size, "FFT block re");
+    im = (float *)MEM_mallocN(size, "FFT block im");
+    t_re = (float *)MEM_mallocN(size, "FFT block transposed re");
+    t_im = (float *)MEM_mallocN(size, "FFT block transposed im");
+    use_threading = false;
+  }
+
+  ~FFTBlock()
+  {
+    MEM_SAFE_FREE(re);
+    MEM_SAFE_FREE(im);
+    MEM_SAFE_FREE(t_re);
+    MEM_SAFE_FREE(t_im);
+  }
+};
+
+/* Radix-2 butterflies a + w * b and a - w * b of one stage. */
+static void butterflies(float *a_re,
+                        float *a_im,
+                        float *b_re,
+                        float *b_im,
+                        const float *w_re,
+                        const float *w_im,
+                        float w_im_sign,
+                        int length)
+{
+  int i = 0;
+#ifdef __SSE2__
+  const __m128 sign = _mm_set1_ps(w_im_sign);
+  for (; i + 4 <= length; i += 4) {
+    const __m128 wr = _mm_loadu_ps(w_re + i);
+    const __m128 wi = _mm_mul_ps(_mm_loadu_ps(w_im + i), sign);
+    const __m128 br = _mm_loadu_ps(b_re + i);
+    const __m128 bi = _mm_loadu_ps(b_im + i);
+    const __m128 tr = _mm_sub_ps(_mm_mul_ps(wr, br), _mm_mul_ps(wi, bi));
+    const __m128 ti = _mm_add_ps(_mm_mul_ps(wr, bi), _mm_mul_ps(wi, br));
+    const __m128 ar = _mm_loadu_ps(a_re + i);
+    const __m128 ai = _mm_loadu_ps(a_im + i);
+    _mm_storeu_ps(b_re + i, _mm_sub_ps(ar, tr));
+    _mm_storeu_ps(b_im + i, _mm_sub_ps(ai, ti));
+    _mm_storeu_ps(a_re + i, _mm_add_ps(ar, tr));
+    _mm_storeu_ps(a_im + i, _mm_add_ps(ai, ti));
+  }
+#endif
+  for (; i < length; i++) {
+    const float wi = w_im[i] * w_im_sign;
+    const float tr = w_re[i] * b_re[i] - wi * b_im[i];
+    const float ti = w_re[i] * b_im[i] + wi * b_re[i];
+    b_re[i] = a_re[i] - tr;
+    b_im[i] = a_im[i] - ti;
+    a_re[i] += tr;
+    a_im[i] += ti;
+  }
+}
+
+/* In place transform of one row, unnormalized. */
+static void fft_row(float *re, float *im, const FFTTwiddles &twiddles, bool inverse)
+{
+  const int n = twiddles.size;
+
+  /* Bit reversal permutation. */
+  for (int i = 1, j = 0; i < n; i++) {
+    int bit = n >> 1;
+    for (; j & bit; bit >>= 1) {
+      j ^= bit;
+    }
+    j ^= bit;
+    if (i < j) {
+      SWAP(float, re[i], re[j]);
+      SWAP(float, im[i], im[j]);
+    }
+  }
+
+  const float w_im_sign = inverse ? -1.0f : 1.0f;
+  for (int half = 1; half < n; half <<= 1) {
+    const float *w_re = &twiddles.re[half - 1];
+    const float *w_im = &twiddles.im[half - 1];
+    for (int start = 0; start < n; start += 2 * half) {
+      butterflies(re + start,
+                  im + start,
+                  re + start + half,
+                  im + start + half,
+                  w_re,
+                  w_im,
+                  w_im_sign,
+                  half);
+    }
+  }
+}
+
+struct FFTRowsTransformData {
+  float *re;
+  float *im;
+  const FFTTwiddles *twiddles;
+  bool inverse;
+};
+
+static void fft_rows_task(void *__restrict userdata,
+                          const int row,
+                          const TaskParallelTLS *__restrict UNUSED(tls))
+{
+  const FFTRowsTransformData *data = (const FFTRowsTransformData *)userdata;
+  const size_t offset = (size_t)row * data->twiddles->size;
+  fft_row(data->re + offset, data->im + offset, *data->twiddles, data->inverse);
+}
+
+/* Transform the first num_rows rows, the others are left as they are. */
+static void fft_rows(float *re,
+                     float *im,
+                     int num_rows,
+                     const FFTTwiddles &twiddles,
+                     bool inverse,
+                     bool use_threading)
+{
+  FFTRowsTransformData data = {re, im, &twiddles, inverse};
+  parallel_range(0, num_rows, &data, fft_rows_task, use_threading);
+}
+
+struct FFTTransposeData {
+  const float *src_re;
+  const float *src_im;
+  float *dst_re;
+  float *dst_im;
+  int rows;
+  int cols;
+};
+
+static void transpose_task(void *__restrict userdata,
+                           const int tile_row,
+                           const TaskParallelTLS *__restrict UNUSED(tls))
+{
+  const FFTTransposeData *data = (const FFTTransposeData *)userdata;
+  const int r_start = tile_row * FFT_TRANSPOSE_TILE;
+  const int r_end = min_ii(r_start + FFT_TRANSPOSE_TILE, data->rows);
+  for (int c_start = 0; c_start < data->cols; c_start += FFT_TRANSPOSE_TILE) {
+    const int c_end = min_ii(c_start + FFT_TRANSPOSE_TILE, data->cols);
+    for (int r = r_start; r < r_end; r++) {
+      for (int c = c_start; c < c_end; c++) {
+        data->dst_re[(size_t)c * data->rows + r] = data->src_re[(size_t)r * data->cols + c];
+        data->dst_im[(size_t)c * data->rows + r] = data->src_im[(size_t)r * data->cols + c];
+      }
+    }
+  }
+}
+
+static void transpose(const float *src_re,
+                      const float *src_im,
+                      float *dst_re,
+                      float *dst_im,
+                      int rows,
+                      int cols,
+                      bool use_threading)
+{
+  FFTTransposeData data = {src_re, src_im, dst_re, dst_im, rows, cols};
+  const int num_tiles = (rows + FFT_TRANSPOSE_TILE - 1) / FFT_TRANSPOSE_TILE;
+  parallel_range(0, num_tiles, &data, transpose_task, use_threading);
+}
+
+/* Transform the spatial values of the block into its transposed spectrum. Rows from num_rows on
+ * must be zero, their transform is skipped. */
+static void fft_block_forward(FFTBlock &block, int num_rows)
+{
+  fft_rows(block.re, block.im, num_rows, *block.twiddles_x, false, block.use_threading);
+  transpose(block.re,
+            block.im,
+            block.t_re,
+            block.t_im,
+            block.height,
+            block.width,
+            block.use_threading);
+  fft_rows(block.t_re, block.t_im, block.width, *block.twiddles_y, false, block.use_threading);
+}
+
+/* Transform the transposed spectrum of the block back into spatial values, unnormalized. */
+static void fft_block_inverse(FFTBlock &block)
+{
+  fft_rows(block.t_re, block.t_im, block.width, *block.twiddles_y, true, block.use_threading);
+  transpose(block.t_re,
+            block.t_im,
+            block.re,
+            block.im,
+            block.width,
+            block.height,
+            block.use_threading);
+  fft_rows(block.re, block.im, block.height, *block.twiddles_x, true, block.use_threading);
+}
+
+/* ******** Convolution ******** */
+
+/* A real signal that is convolved, one channel of the image or the mask of pixels inside of the
+ * image that is used to normalize edges. */
+struct FFTSignal {
+  /* Channel of the input image, -1 for the mask. */
+  int channel;
+  /* Channel of the kernel. */
+  int kernel;
+  /* Where the result is added. */
+  float *dst;
+  int dst_stride;
+};
+
+/* Two signals that are transformed together as real and imaginary part. */
+struct FFTSignalPair {
+  FFTSignal a;
+  FFTSignal b;
+  bool has_b;
+};
+
+struct FFTConvolutionData {
+  const float *input;
+  int width;
+  int height;
+
+  /* Size of the blocks, and of the part of the image that is convolved in each of them. */
+  int block_width;
+  int block_height;
+  int step_x;
+  int step_y;
+  int blocks_x;
+  /* Offset of the result of a block relative to its input, due to the center of the kernel. */
+  int offset_x;
+  int offset_y;
+
+  const FFTTwiddles *twiddles_x;
+  const FFTTwiddles *twiddles_y;
+
+  /* Transposed spectrum of every kernel channel. */
+  std::vector<FFTBlock *> spectra;
+  std::vector<FFTSignalPair> pairs;
+
+  /* Blocks processed in the current pass, which don't overlap. */
+  std::vector<int> blocks;
+  bool parallel_blocks;
+};
+
+struct FFTRowsData {
+  const FFTConvolutionData *data;
+  const FFTSignalPair *pair;
+  FFTBlock *block;
+  int x0;
+  int y0;
+};
+
+static void load_block_rows_task(void *__restrict userdata,
+                                 const int y,
+                                 const TaskParallelTLS *__restrict UNUSED(tls))
+{
+  const FFTRowsData *rows = (const FFTRowsData *)userdata;
+  const FFTConvolutionData *data = rows->data;
+  const FFTSignalPair &pair = *rows->pair;
+  float *re = rows->block->re + (size_t)y * data->block_width;
+  float *im = rows->block->im + (size_t)y * data->block_width;
+  memset(re, 0, sizeof(float) * data->block_width);
+  memset(im, 0, sizeof(float) * data->block_width);
+
+  const int yy = rows->y0 + y;
+  if (y >= data->step_y || yy >= data->height) {
+    return;
+  }
+  const int length = min_ii(data->step_x, data->width - rows->x0);
+  const float *src = data->input + ((size_t)yy * data->width + rows->x0) * COM_NUM_CHANNELS_COLOR;
+  for (int x = 0; x < length; x++) {
+    const float *pixel = src + x * COM_NUM_CHANNELS_COLOR;
+    re[x] = (pair.a.channel >= 0) ? pixel[pair.a.channel] : 1.0f;
+    if (pair.has_b) {
+      im[x] = (pair.b.channel >= 0) ? pixel[pair.b.channel] : 1.0f;
+    }
+  }
+}
+
+/* Multiply the spectrum of a pair with the spectra of their kernels. Row kx of the transposed
+ * spectrum is processed together with row -kx, as separating the spectra of the two real signals
+ * needs the values at both frequencies. */
+static void multiply_spectrum_rows_task(void *__restrict userdata,
+                                        const int kx,
+                                        const TaskParallelTLS *__restrict UNUSED(tls))
+{
+  const FFTRowsData *rows = (const FFTRowsData *)userdata;
+  const FFTConvolutionData *data = rows->data;
+  const FFTSignalPair &pair = *rows->pair;
+  const int n = data->block_height;
+  const FFTBlock *kernel_a = data->spectra[pair.a.kernel];
+  float *z_re = rows->block->t_re;
+  float *z_im = rows->block->t_im;
+
+  if (!pair.has_b || pair.a.kernel == pair.b.kernel) {
+    /* Same kernel for both signals, a plain complex multiplication. */
+    const size_t offset = (size_t)kx * n;
+    const float *k_re = kernel_a->t_re + offset;
+    const float *k_im = kernel_a->t_im + offset;
+    float *r_re = z_re + offset;
+    float *r_im = z_im + offset;
+    int i = 0;
+#ifdef __SSE2__
+    for (; i + 4 <= n; i += 4) {
+      const __m128 ar = _mm_loadu_ps(r_re + i);
+      const __m128 ai = _mm_loadu_ps(r_im + i);
+      const __m128 br = _mm_loadu_ps(k_re + i);
+      const __m128 bi = _mm_loadu_ps(k_im + i);
+      _mm_storeu_ps(r_re + i, _mm_sub_ps(_mm_mul_ps(ar, br), _mm_mul_ps(ai, bi)));
+      _mm_storeu_ps(r_im + i, _mm_add_ps(_mm_mul_ps(ar, bi), _mm_mul_ps(ai, br)));
+    }
+#endif
+    for (; i < n; i++) {
+      const float ar = r_re[i], ai = r_im[i];
+      r_re[i] = ar * k_re[i] - ai * k_im[i];
+      r_im[i] = ar * k_im[i] + ai * k_re[i];
+    }
+    return;
+  }
+
+  /* With Z the spectrum of a + ib and Ka, Kb the kernel spectra, the spectrum of the result is
+   * `Z(k) (Ka(k) + Kb(k)) / 2 + conj(Z(-k)) (Ka(k) - Kb(k)) / 2`. */
+  const FFTBlock *kernel_b = data->spectra[pair.b.kernel];
+  const int kx_neg = (data->block_width - kx) & (data->block_width - 1);
+  if (kx > kx_neg) {
+    /* Processed together with row kx_neg. */
+    return;
+  }
+  for (int ky = 0; ky < n; ky++) {
+    const int ky_neg = (n - ky) & (n - 1);
+    const size_t k = (size_t)kx * n + ky;
+    const size_t k_neg = (size_t)kx_neg * n + ky_neg;
+    if (kx == kx_neg && ky > ky_neg) {
+      continue;
+    }
+    float z[2] = {z_re[k], z_im[k]};
+    float z_neg[2] = {z_re[k_neg], z_im[k_neg]};
+    for (int side = 0; side < 2; side++) {
+      const size_t index = side ? k_neg : k;
+      const float *zc = side ? z_neg : z;
+      const float *zm = side ? z : z_neg;
+      const float p_re = 0.5f * (kernel_a->t_re[index] + kernel_b->t_re[index]);
+      const float p_im = 0.5f * (kernel_a->t_im[index] + kernel_b->t_im[index]);
+      const float q_re = 0.5f * (kernel_a->t_re[index] - kernel_b->t_re[index]);
+      const float q_im = 0.5f * (kernel_a->t_im[index] - kernel_b->t_im[index]);
+      /* zc * p + conj(zm) * q */
+      z_re[index] = zc[0] * p_re - zc[1] * p_im + zm[0] * q_re + zm[1] * q_im;
+      z_im[index] = zc[0] * p_im + zc[1] * p_re + zm[0] * q_im - zm[1] * q_re;
+      if (index == k_neg && k == k_neg) {
+        break;
+      }
+    }
+  }
+}
+
+static void accumulate_block_rows_task(void *__restrict userdata,
+                                       const int y,
+                                       const TaskParallelTLS *__restrict UNUSED(tls))
+{
+  const FFTRowsData *rows = (const FFTRowsData *)userdata;
+  const FFTConvolutionData *data = rows->data;
+  const FFTSignalPair &pair = *rows->pair;
+  const int yy = rows->y0 + y - data->offset_y;
+  if (yy < 0 || yy >= data->height) {
+    return;
+  }
+  const float scale = 1.0f / ((float)data->block_width * data->block_height);
+  const int x_start = max_ii(data->offset_x - rows->x0, 0);
+  const int x_end = min_ii(data->block_width, data->width + data->offset_x - rows->x0);
+  const float *re = rows->block->re + (size_t)y * data->block_width;
+  const float *im = rows->block->im + (size_t)y * data->block_width;
+  /* Index of the pixel at the start of the block row, can be outside of the image. */
+  const ptrdiff_t row_offset = (ptrdiff_t)yy * data->width + rows->x0 - data->offset_x;
+
+  for (int x = x_start; x < x_end; x++) {
+    pair.a.dst[(row_offset + x) * pair.a.dst_stride] += re[x] * scale;
+  }
+  if (pair.has_b) {
+    for (int x = x_start; x < x_end; x++) {
+      pair.b.dst[(row_offset + x) * pair.b.dst_stride] += im[x] * scale;
+    }
+  }
+}
+
+static void convolve_block(const FFTConvolutionData *data, const FFTSignalPair &pair, int index)
+{
+  FFTBlock block(data->block_width, data->block_height, data->twiddles_x, data->twiddles_y);
+  block.use_threading = !data->parallel_blocks;
+
+  FFTRowsData rows;
+  rows.data = data;
+  rows.pair = &pair;
+  rows.block = &block;
+  rows.x0 = (index % data->blocks_x) * data->step_x;
+  rows.y0 = (index / data->blocks_x) * data->step_y;
+
+  parallel_range(0, block.height, &rows, load_block_rows_task, block.use_threading);
+  fft_block_forward(block, min_ii(data->step_y, data->height - rows.y0));
+  parallel_range(0, block.width, &rows, multiply_spectrum_rows_task, block.use_threading);
+  fft_block_inverse(block);
+  parallel_range(0, block.height, &rows, accumulate_block_rows_task, block.use_threading);
+}
+
+static void convolve_blocks_task(void *__restrict userdata,
+                                 const int iter,
+                                 const TaskParallelTLS *__restrict UNUSED(tls))
+{
+  const FFTConvolutionData *data = (const FFTConvolutionData *)userdata;
+  const int num_blocks = (int)data->blocks.size();
+  convolve_block(data, data->pairs[iter / num_blocks], data->blocks[iter % num_blocks]);
+}
+
+/* Size of blocks for a kernel size. Blocks are four times the size of the kernel, so most of a
+ * block is image rather than padding, or two times for large kernels to bound memory usage. Either
+ * way blocks two steps apart don't overlap. Blocks don't need to be larger than the image. */
+static int block_size(int kernel_size, int image_size)
+{
+  const int factor = (kernel_size <= FFT_LARGE_KERNEL_SIZE) ? 4 : 2;
+  const int size = power_of_2_max_i(max_ii(factor * kernel_size, FFT_MIN_BLOCK_SIZE));
+  const int image_block_size = power_of_2_max_i(image_size + kernel_size - 1);
+  return min_ii(size, max_ii(image_block_size, FFT_MIN_BLOCK_SIZE));
+}
+
+FFTConvolution::FFTConvolution(const float *kernel,
+                               int kernelWidth,
+                               int kernelHeight,
+                               int kernelChannels,
+                               int centerX,
+                               int centerY)
+    : m_kernel(kernel, kernel + (size_t)kernelWidth * kernelHeight * kernelChannels)
+{
+  this->m_kernelWidth = kernelWidth;
+  this->m_kernelHeight = kernelHeight;
+  this->m_kernelChannels = kernelChannels;
+  this->m_centerX = centerX;
+  this->m_centerY = centerY;
+  this->m_normalizeEdges = false;
+}
+
+bool FFTConvolution::isFasterThanDirect(int kernelWidth, int kernelHeight)
+{
+  return kernelWidth * kernelHeight >= 32 * 32;
+}
+
+void FFTConvolution::execute(
+    const float *input, float *output, int width, int height, int numChannels) const
+{
+  const size_t num_pixels = (size_t)width * height;
+  memset(output, 0, sizeof(float) * num_pixels * COM_NUM_CHANNELS_COLOR);
+  if (num_pixels == 0) {
+    return;
+  }
+
+  FFTConvolutionData data;
+  data.input = input;
+  data.width = width;
+  data.height = height;
+  data.block_width = block_size(this->m_kernelWidth, width);
+  data.block_height = block_size(this->m_kernelHeight, height);
+  data.step_x = data.block_width - this->m_kernelWidth + 1;
+  data.step_y = data.block_height - this->m_kernelHeight + 1;
+  data.blocks_x = (width + data.step_x - 1) / data.step_x;
+  const int blocks_y = (height + data.step_y - 1) / data.step_y;
+  /* The kernel is mirrored for the convolution, its center moves with it. */
+  data.offset_x = this->m_kernelWidth - 1 - this->m_centerX;
+  data.offset_y = this->m_kernelHeight - 1 - this->m_centerY;
+  data.parallel_blocks = (size_t)data.block_width * data.block_height <= FFT_SMALL_BLOCK_SIZE;
+
+  const FFTTwiddles twiddles_x(data.block_width);
+  const FFTTwiddles twiddles_y(data.block_height);
+  data.twiddles_x = &twiddles_x;
+  data.twiddles_y = &twiddles_y;
+
+  /* Spectra of the mirrored kernel channels. */
+  for (int channel = 0; channel < this->m_kernelChannels; channel++) {
+    FFTBlock *block = new FFTBlock(data.block_width, data.block_height, &twiddles_x, &twiddles_y);
+    block->use_threading = true;
+    memset(block->re, 0, sizeof(float) * data.block_width * data.block_height);
+    memset(block->im, 0, sizeof(float) * data.block_width * data.block_height);
+    for (int y = 0; y < this->m_kernelHeight; y++) {
+      for (int x = 0; x < this->m_kernelWidth; x++) {
+        const size_t src = ((size_t)y * this->m_kernelWidth + x) * this->m_kernelChannels;
+        const size_t dst = (size_t)(this->m_kernelHeight - 1 - y) * data.block_width +
+                           (this->m_kernelWidth - 1 - x);
+        block->re[dst] = this->m_kernel[src + channel];
+      }
+    }
+    fft_block_forward(*block, this->m_kernelHeight);
+    MEM_SAFE_FREE(block->re);
+    MEM_SAFE_FREE(block->im);
+    data.spectra.push_back(block);
+  }
+
+  /* Signals to convolve, the mask is convolved once per kernel channel. */
+  float *norm = nullptr;
+  std::vector<FFTSignal> signals;
+  for (int channel = 0; channel < numChannels; channel++) {
+    FFTSignal signal = {channel,
+                        (this->m_kernelChannels == 1) ? 0 : channel,
+                        output + channel,
+                        COM_NUM_CHANNELS_COLOR};
+    signals.push_back(signal);
+  }
+  if (this->m_normalizeEdges) {
+    norm = (float *)MEM_callocN(sizeof(float) * num_pixels * this->m_kernelChannels,
+                                "FFT convolution normalization");
+    for (int channel = 0; channel < this->m_kernelChannels; channel++) {
+      FFTSignal signal = {-1, channel, norm + num_pixels * channel, 1};
+      signals.push_back(signal);
+    }
+  }
+  for (size_t i = 0; i < signals.size(); i += 2) {
+    FFTSignalPair pair;
+    pair.a = signals[i];
+    pair.has_b = (i + 1 < signals.size());
+    pair.b = pair.has_b ? signals[i + 1] : signals[i];
+    data.pairs.push_back(pair);
+  }
+
+  /* Blocks overlap with their neighbors, blocks two steps apart are processed together. */
+  for (int pass = 0; pass < 4; pass++) {
+    data.blocks.clear();
+    for (int by = pass / 2; by < blocks_y; by += 2) {
+      for (int bx = pass % 2; bx < data.blocks_x; bx += 2) {
+        data.blocks.push_back(by * data.blocks_x + bx);
+      }
+    }
+    if (data.blocks.empty()) {
+      continue;
+    }
+    const int num_tasks = (int)(data.pairs.size() * data.blocks.size());
+    parallel_range(0, num_tasks, &data, convolve_blocks_task, data.parallel_blocks);
+  }
+
+  if (norm) {
+    for (size_t i = 0; i < num_pixels; i++) {
+      float *pixel = output + i * COM_NUM_CHANNELS_COLOR;
+      for (int channel = 0; channel < numChannels; channel++) {
+        const int kernel = (this->m_kernelChannels == 1) ? 0 : channel;
+        const float weight = norm[num_pixels * kernel + i];
+        pixel[channel] = (weight > 1e-6f) ? pixel[channel] / weight : 0.0f;
+      }
+    }
+    MEM_freeN(norm);
+  }
+
+  for (FFTBlock *block : data.spectra) {
+    delete block;
+  }
+}
@@ -0,0 +1,88 @@
+/*
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ *
+ * Copyright 2020, Blender Foundation.
+ */
+
+#pragma once
+
+#include <vector>
+
+#ifdef WITH_CXX_GUARDEDALLOC
+#  include "MEM_guardedalloc.h"
+#endif
+
+/**
+ * \brief Convolution of images with large kernels, using fast Fourier transforms.
+ *
+ * Computes `output(x, y) = sum(kernel(i, j) * input(x + i - centerX, y + j - centerY))` for all
+ * channels of an image. The cost per pixel only grows with the logarithm of the kernel size, so
+ * it is used for glows and blurs with large radii, where direct convolution is quadratic in the
+ * radius.
+ *
+ * The image is split into blocks that are convolved separately and added together (overlap-add),
+ * which keeps memory usage bounded by the kernel size rather than the image size. Two real
+ * channels are transformed at once as the real and imaginary part of one complex transform.
+ * Transforms of large blocks are threaded over rows, small blocks are threaded as a whole.
+ */
+class FFTConvolution {
+ private:
+  /** Kernel, with its channels interleaved. */
+  std::vector<float> m_kernel;
+  int m_kernelWidth;
+  int m_kernelHeight;
+  int m_kernelChannels;
+  int m_centerX;
+  int m_centerY;
+
+  bool m_normalizeEdges;
+
+ public:
+  /**
+   * \param kernel: kernelWidth * kernelHeight pixels of kernelChannels interleaved channels.
+   * A single channel kernel is used for all channels of the image, otherwise every channel of
+   * the image has its own kernel.
+   */
+  FFTConvolution(const float *kernel,
+                 int kernelWidth,
+                 int kernelHeight,
+                 int kernelChannels,
+                 int centerX,
+                 int centerY);
+
+  /**
+   * \brief divide by the sum of the part of the kernel that is inside of the image, so borders
+   * are not darkened, like direct blurs that skip pixels outside of the image
+   */
+  void setNormalizeEdges(bool normalizeEdges)
+  {
+    this->m_normalizeEdges = normalizeEdges;
+  }
+
+  /**
+   * \brief convolve the first numChannels channels of an image with 4 channels per pixel
+   * The other channels of the output are set to zero.
+   */
+  void execute(const float *input, float *output, int width, int height, int numChannels) const;
+
+  /**
+   * \brief is convolution with a kernel of this size faster than direct convolution
+   */
+  static bool isFasterThanDirect(int kernelWidth, int kernelHeight);
+
+#ifdef WITH_CXX_GUARDEDALLOC
+  MEM_CXX_CLASS_ALLOC_FUNCS("COM:FFTConvolution")
+#endif
+};
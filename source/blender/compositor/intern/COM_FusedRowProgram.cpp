@@ -0,0 +1,168 @@
+/*
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ *
+ * Copyright 2020, Blender Foundation.
+ */
+
+#include "COM_FusedRowProgram.h"
+
+#include <cstring>
+
+static int num_channels_for_datatype(DataType datatype)
+{
+  switch (datatype) {
+    case COM_DT_VALUE:
+      return COM_NUM_CHANNELS_VALUE;
+    case COM_DT_VECTOR:
+      return COM_NUM_CHANNELS_VECTOR;
+    case COM_DT_COLOR:
+    default:
+      return COM_NUM_CHANNELS_COLOR;
+  }
+}
+
+FusedRowProgram::FusedRowProgram(NodeOperation *operation)
+{
+  this->m_scratchChannels = 0;
+  this->m_zeroOffset = -1;
+
+  std::map<NodeOperation *, int> step_index;
+  addStep(operation, step_index);
+
+  /* The last step is the operation itself, which writes directly to the output. */
+  this->m_steps.back().offset = -1;
+  this->m_scratchChannels -= this->m_steps.back().num_channels;
+}
+
+bool FusedRowProgram::canExecuteRow(NodeOperation *operation)
+{
+  if (!operation->isRowOperation() || operation->isComplex() ||
+      operation->getNumberOfInputSockets() > MAX_INPUTS) {
+    return false;
+  }
+  /* Input rows are passed with the number of channels of the input socket, so the output they
+   * are linked to must have the same data type. */
+  for (unsigned int index = 0; index < operation->getNumberOfInputSockets(); index++) {
+    NodeOperationInput *input = operation->getInputSocket(index);
+    if (input->isConnected() && input->getLink()->getDataType() != input->getDataType()) {
+      return false;
+    }
+  }
+  return true;
+}
+
+FusedRowProgram *FusedRowProgram::createForInput(NodeOperation *operation, unsigned int index)
+{
+  NodeOperationInput *input = operation->getInputSocket(index);
+  if (input == nullptr || !input->isConnected() ||
+      input->getLink()->getDataType() != input->getDataType()) {
+    return nullptr;
+  }
+  NodeOperation *input_operation = &input->getLink()->getOperation();
+  if (input_operation->isComplex()) {
+    return nullptr;
+  }
+
+  FusedRowProgram *program = new FusedRowProgram(input_operation);
+  if (program->getNumRowOperations() == 0) {
+    delete program;
+    return nullptr;
+  }
+  return program;
+}
+
+int FusedRowProgram::addStep(NodeOperation *operation, std::map<NodeOperation *, int> &step_index)
+{
+  std::map<NodeOperation *, int>::iterator it = step_index.find(operation);
+  if (it != step_index.end()) {
+    return it->second;
+  }
+
+  Step step;
+  step.operation = operation;
+  step.use_row = canExecuteRow(operation);
+  step.num_channels = num_channels_for_datatype(operation->getOutputSocket()->getDataType());
+
+  if (step.use_row) {
+    for (unsigned int index = 0; index < operation->getNumberOfInputSockets(); index++) {
+      NodeOperationInput *input = operation->getInputSocket(index);
+      if (input->isConnected()) {
+        step.inputs.push_back(addStep(&input->getLink()->getOperation(), step_index));
+      }
+      else {
+        if (this->m_zeroOffset == -1) {
+          this->m_zeroOffset = this->m_scratchChannels;
+          this->m_scratchChannels += COM_NUM_CHANNELS_COLOR;
+        }
+        step.inputs.push_back(-1);
+      }
+    }
+  }
+
+  step.offset = this->m_scratchChannels;
+  this->m_scratchChannels += step.num_channels;
+
+  this->m_steps.push_back(step);
+  step_index[operation] = this->m_steps.size() - 1;
+  return this->m_steps.size() - 1;
+}
+
+int FusedRowProgram::getNumRowOperations() const
+{
+  int num_row_operations = 0;
+  for (const Step &step : this->m_steps) {
+    if (step.use_row) {
+      num_row_operations++;
+    }
+  }
+  return num_row_operations;
+}
+
+size_t FusedRowProgram::getScratchSize(int length) const
+{
+  return (size_t)this->m_scratchChannels * length;
+}
+
+void FusedRowProgram::executeRow(float *output, float *scratch, int x, int y, int length) const
+{
+  if (this->m_zeroOffset != -1) {
+    memset(scratch + (size_t)this->m_zeroOffset * length,
+           0,
+           sizeof(float) * COM_NUM_CHANNELS_COLOR * length);
+  }
+
+  for (const Step &step : this->m_steps) {
+    float *result = (step.offset == -1) ? output : scratch + (size_t)step.offset * length;
+
+    if (step.use_row) {
+      const float *inputs[MAX_INPUTS];
+      for (size_t index = 0; index < step.inputs.size(); index++) {
+        const int input_step = step.inputs[index];
+        const int offset = (input_step == -1) ? this->m_zeroOffset :
+                                                this->m_steps[input_step].offset;
+        inputs[index] = scratch + (size_t)offset * length;
+      }
+      step.operation->executeRow(result, inputs, x, y, length);
+    }
+    else {
+      /* readSampled always writes four channels, so go through a temporary pixel. */
+      float color[4];
+      for (int i = 0; i < length; i++) {
+        step.operation->readSampled(color, x + i, y, COM_PS_NEAREST);
+        memcpy(result + (size_t)i * step.num_channels, color, sizeof(float) * step.num_channels);
+      }
+    }
+  }
+}
@@ -0,0 +1,101 @@
+/*
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ *
+ * Copyright 2020, Blender Foundation.
+ */
+
+#pragma once
+
+#include "COM_NodeOperation.h"
+
+#include <map>
+#include <vector>
+
+/**
+ * \brief Operations fused into a program that computes rows of pixels at once.
+ *
+ * Used in full frame execution. Starting from an operation, the program contains all operations
+ * it reads from that can compute rows of pixels (see NodeOperation.isRowOperation), in the order
+ * they have to be executed. Each of them writes its result into a row of a scratch buffer, so
+ * no intermediate buffers of the size of the frame are needed and an operation that is read by
+ * multiple operations is computed only once per pixel. Other operations are read one pixel at a
+ * time, like in tiled execution.
+ *
+ * A program can be executed by multiple threads at once, each with its own scratch buffer.
+ */
+class FusedRowProgram {
+ public:
+  /** Maximum number of inputs of an operation that is computed a row at a time. */
+  static const int MAX_INPUTS = 8;
+
+ private:
+  struct Step {
+    NodeOperation *operation;
+    /** Computed with NodeOperation.executeRow, otherwise read one pixel at a time. */
+    bool use_row;
+    /** Number of channels of the result. */
+    int num_channels;
+    /** Offset of the result in the scratch buffer, per pixel of the row. */
+    int offset;
+    /** Index of the step for each input, -1 for unconnected inputs. */
+    std::vector<int> inputs;
+  };
+
+  std::vector<Step> m_steps;
+
+  /** Channels of the scratch buffer per pixel of the row. */
+  int m_scratchChannels;
+
+  /** Offset of a row of zeros in the scratch buffer, -1 when not needed. */
+  int m_zeroOffset;
+
+  int addStep(NodeOperation *operation, std::map<NodeOperation *, int> &step_index);
+
+ public:
+  FusedRowProgram(NodeOperation *operation);
+
+  /**
+   * \brief can the operation compute rows of pixels in a fused program
+   */
+  static bool canExecuteRow(NodeOperation *operation);
+
+  /**
+   * \brief create a program for the operation linked to an input socket
+   * \return nullptr when no operations can be computed a row at a time, or when the linked
+   * output does not have the data type of the input
+   */
+  static FusedRowProgram *createForInput(NodeOperation *operation, unsigned int index);
+
+  /**
+   * \brief number of operations that are computed a row at a time
+   */
+  int getNumRowOperations() const;
+
+  /**
+   * \brief size of the scratch buffer for rows of the given length, in floats
+   */
+  size_t getScratchSize(int length) const;
+
+  /**
+   * \brief compute a row of pixels of the operation
+   * \param output: the pixels of the row, with the number of channels of the output socket
+   * \param scratch: buffer of getScratchSize floats, owned by the calling thread
+   */
+  void executeRow(float *output, float *scratch, int x, int y, int length) const;
+
+#ifdef WITH_CXX_GUARDEDALLOC
+  MEM_CXX_CLASS_ALLOC_FUNCS("COM:FusedRowProgram")
+#endif
+};
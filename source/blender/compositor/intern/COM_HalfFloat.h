@@ -0,0 +1,122 @@
+/*
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ *
+ * Copyright 2020, Blender Foundation.
+ */
+
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+
+#ifdef __F16C__
+#  include <immintrin.h>
+#endif
+
+/**
+ * \brief Conversion between 32 bit floats and IEEE 754 half floats.
+ *
+ * Half floats have 11 bits of precision and a range up to 65504, enough for colors of
+ * intermediate results while using half the memory. Values outside of the range become
+ * infinite, conversion rounds to the nearest even value.
+ * \see MemoryBuffer
+ */
+
+typedef union HalfFloatBits {
+  float f;
+  uint32_t u;
+} HalfFloatBits;
+
+inline float half_to_float(uint16_t h)
+{
+  const uint32_t shifted_exp = 0x7c00u << 13;
+  HalfFloatBits magic;
+  magic.u = 113u << 23;
+
+  HalfFloatBits o;
+  o.u = (uint32_t)(h & 0x7fffu) << 13;
+  const uint32_t exp = shifted_exp & o.u;
+  o.u += (127u - 15u) << 23;
+  if (exp == shifted_exp) {
+    /* Infinity and NaN. */
+    o.u += (128u - 16u) << 23;
+  }
+  else if (exp == 0) {
+    /* Zero and denormals. */
+    o.u += 1u << 23;
+    o.f -= magic.f;
+  }
+  o.u |= (uint32_t)(h & 0x8000u) << 16;
+  return o.f;
+}
+
+inline uint16_t float_to_half(float value)
+{
+  const uint32_t f32_infinity = 255u << 23;
+  const uint32_t f16_max = (127u + 16u) << 23;
+  HalfFloatBits denorm_magic;
+  denorm_magic.u = ((127u - 15u) + (23u - 10u) + 1u) << 23;
+
+  HalfFloatBits f;
+  f.f = value;
+  const uint32_t sign = f.u & 0x80000000u;
+  f.u ^= sign;
+
+  uint16_t o;
+  if (f.u >= f16_max) {
+    /* Infinity or NaN, NaN stays a quiet NaN. */
+    o = (f.u > f32_infinity) ? 0x7e00 : 0x7c00;
+  }
+  else if (f.u < (113u << 23)) {
+    /* Denormal or zero, let the float addition do the rounding. */
+    f.f += denorm_magic.f;
+    o = (uint16_t)(f.u - denorm_magic.u);
+  }
+  else {
+    const uint32_t mantissa_odd = (f.u >> 13) & 1u;
+    f.u += ((uint32_t)(15 - 127) << 23) + 0xfffu;
+    f.u += mantissa_odd;
+    o = (uint16_t)(f.u >> 13);
+  }
+  return o | (uint16_t)(sign >> 16);
+}
+
+inline void half_to_float_array(float *dst, const uint16_t *src, size_t count)
+{
+  size_t i = 0;
+#ifdef __F16C__
+  for (; i + 4 <= count; i += 4) {
+    const __m128i h = _mm_loadl_epi64((const __m128i *)(src + i));
+    _mm_storeu_ps(dst + i, _mm_cvtph_ps(h));
+  }
+#endif
+  for (; i < count; i++) {
+    dst[i] = half_to_float(src[i]);
+  }
+}
+
+inline void float_to_half_array(uint16_t *dst, const float *src, size_t count)
+{
+  size_t i = 0;
+#ifdef __F16C__
+  for (; i + 4 <= count; i += 4) {
+    const __m128i h = _mm_cvtps_ph(_mm_loadu_ps(src + i), _MM_FROUND_TO_NEAREST_INT);
+    _mm_storel_epi64((__m128i *)(dst + i), h);
+  }
+#endif
+  for (; i < count; i++) {
+    dst[i] = float_to_half(src[i]);
+  }
+}
@@ -58,8 +58,18 @@ MemoryBuffer::MemoryBuffer(MemoryProxy *memoryProxy, unsigned int chunkNumber, r
   this->m_memoryProxy = memoryProxy;
   this->m_chunkNumber = chunkNumber;
   this->m_num_channels = determine_num_channels(memoryProxy->getDataType());
-  this->m_buffer = (float *)MEM_mallocN_aligned(
-      sizeof(float) * determineBufferSize() * this->m_num_channels, 16, "COM_MemoryBuffer");
+  if (memoryProxy->getUseHalfFloat()) {
+    this->m_buffer = nullptr;
+    this->m_halfBuffer = (uint16_t *)MEM_mallocN_aligned(
+        sizeof(uint16_t) * determineBufferSize() * this->m_num_channels,
+        16,
+        "COM_MemoryBuffer half");
+  }
+  else {
+    this->m_buffer = (float *)MEM_mallocN_aligned(
+        sizeof(float) * determineBufferSize() * this->m_num_channels, 16, "COM_MemoryBuffer");
+    this->m_halfBuffer = nullptr;
+  }
   this->m_state = COM_MB_ALLOCATED;
   this->m_datatype = memoryProxy->getDataType();
 }
@@ -74,6 +84,7 @@ MemoryBuffer::MemoryBuffer(MemoryProxy *memoryProxy, rcti *rect)
   this->m_num_channels = determine_num_channels(memoryProxy->getDataType());
   this->m_buffer = (float *)MEM_mallocN_aligned(
       sizeof(float) * determineBufferSize() * this->m_num_channels, 16, "COM_MemoryBuffer");
+  this->m_halfBuffer = nullptr;
   this->m_state = COM_MB_TEMPORARILY;
   this->m_datatype = memoryProxy->getDataType();
 }
@@ -88,12 +99,17 @@ MemoryBuffer::MemoryBuffer(DataType dataType, rcti *rect)
   this->m_num_channels = determine_num_channels(dataType);
   this->m_buffer = (float *)MEM_mallocN_aligned(
       sizeof(float) * determineBufferSize() * this->m_num_channels, 16, "COM_MemoryBuffer");
+  this->m_halfBuffer = nullptr;
   this->m_state = COM_MB_TEMPORARILY;
   this->m_datatype = dataType;
 }
 MemoryBuffer *MemoryBuffer::duplicate()
 {
   MemoryBuffer *result = new MemoryBuffer(this->m_memoryProxy, &this->m_rect);
+  if (this->m_halfBuffer) {
+    result->copyContentFrom(this);
+    return result;
+  }
   memcpy(result->m_buffer,
          this->m_buffer,
          this->determineBufferSize() * this->m_num_channels * sizeof(float));
@@ -101,15 +117,33 @@ MemoryBuffer *MemoryBuffer::duplicate()
 }
 void MemoryBuffer::clear()
 {
+  if (this->m_halfBuffer) {
+    memset(this->m_halfBuffer,
+           0,
+           this->determineBufferSize() * this->m_num_channels * sizeof(uint16_t));
+    return;
+  }
   memset(this->m_buffer, 0, this->determineBufferSize() * this->m_num_channels * sizeof(float));
 }
 
 float MemoryBuffer::getMaximumValue()
 {
-  float result = this->m_buffer[0];
   const unsigned int size = this->determineBufferSize();
   unsigned int i;
 
+  if (this->m_halfBuffer) {
+    float result = half_to_float(this->m_halfBuffer[0]);
+    for (i = 0; i < size; i++) {
+      const float value = half_to_float(this->m_halfBuffer[i * this->m_num_channels]);
+      if (value > result) {
+        result = value;
+      }
+    }
+    return result;
+  }
+
+  float result = this->m_buffer[0];
+
   const float *fp_src = this->m_buffer;
 
   for (i = 0; i < size; i++, fp_src += this->m_num_channels) {
@@ -147,6 +181,10 @@ MemoryBuffer::~MemoryBuffer()
     MEM_freeN(this->m_buffer);
     this->m_buffer = nullptr;
   }
+  if (this->m_halfBuffer) {
+    MEM_freeN(this->m_halfBuffer);
+    this->m_halfBuffer = nullptr;
+  }
 }
 
 void MemoryBuffer::copyContentFrom(MemoryBuffer *otherBuffer)
@@ -169,9 +207,44 @@ void MemoryBuffer::copyContentFrom(MemoryBuffer *otherBuffer)
                   this->m_num_channels;
     offset = ((otherY - this->m_rect.ymin) * this->m_width + minX - this->m_rect.xmin) *
              this->m_num_channels;
-    memcpy(&this->m_buffer[offset],
-           &otherBuffer->m_buffer[otherOffset],
-           (maxX - minX) * this->m_num_channels * sizeof(float));
+    const size_t count = (maxX - minX) * this->m_num_channels;
+    if (this->m_halfBuffer && otherBuffer->m_halfBuffer) {
+      memcpy(&this->m_halfBuffer[offset],
+             &otherBuffer->m_halfBuffer[otherOffset],
+             count * sizeof(uint16_t));
+    }
+    else if (this->m_halfBuffer) {
+      float_to_half_array(&this->m_halfBuffer[offset], &otherBuffer->m_buffer[otherOffset], count);
+    }
+    else if (otherBuffer->m_halfBuffer) {
+      half_to_float_array(&this->m_buffer[offset], &otherBuffer->m_halfBuffer[otherOffset], count);
+    }
+    else {
+      memcpy(&this->m_buffer[offset], &otherBuffer->m_buffer[otherOffset], count * sizeof(float));
+    }
+  }
+}
+
+void MemoryBuffer::writeRow(const float *values, int x, int y, int length)
+{
+  if (y < this->m_rect.ymin || y >= this->m_rect.ymax) {
+    return;
+  }
+  const int x1 = max_ii(x, this->m_rect.xmin);
+  const int x2 = min_ii(x + length, this->m_rect.xmax);
+  if (x1 >= x2) {
+    return;
+  }
+  const size_t offset = ((size_t)this->m_width * (y - this->m_rect.ymin) + x1 -
+                         this->m_rect.xmin) *
+                        this->m_num_channels;
+  const float *src = values + (size_t)(x1 - x) * this->m_num_channels;
+  const size_t count = (size_t)(x2 - x1) * this->m_num_channels;
+  if (this->m_halfBuffer) {
+    float_to_half_array(&this->m_halfBuffer[offset], src, count);
+  }
+  else {
+    memcpy(&this->m_buffer[offset], src, count * sizeof(float));
   }
 }
 
@@ -181,6 +254,10 @@ void MemoryBuffer::writePixel(int x, int y, const float color[4])
       y < this->m_rect.ymax) {
     const int offset = (this->m_width * (y - this->m_rect.ymin) + x - this->m_rect.xmin) *
                        this->m_num_channels;
+    if (this->m_halfBuffer) {
+      float_to_half_array(&this->m_halfBuffer[offset], color, this->m_num_channels);
+      return;
+    }
     memcpy(&this->m_buffer[offset], color, sizeof(float) * this->m_num_channels);
   }
 }
@@ -191,6 +268,13 @@ void MemoryBuffer::addPixel(int x, int y, const float color[4])
       y < this->m_rect.ymax) {
     const int offset = (this->m_width * (y - this->m_rect.ymin) + x - this->m_rect.xmin) *
                        this->m_num_channels;
+    if (this->m_halfBuffer) {
+      uint16_t *dst = &this->m_halfBuffer[offset];
+      for (int i = 0; i < this->m_num_channels; i++) {
+        dst[i] = float_to_half(half_to_float(dst[i]) + color[i]);
+      }
+      return;
+    }
     float *dst = &this->m_buffer[offset];
     const float *src = color;
     for (int i = 0; i < this->m_num_channels; i++, dst++, src++) {
@@ -199,6 +283,72 @@ void MemoryBuffer::addPixel(int x, int y, const float color[4])
   }
 }
 
+void MemoryBuffer::readBilinearHalf(float *result, float u, float v, bool wrap_x, bool wrap_y)
+{
+  const int width = this->m_width;
+  const int height = this->m_height;
+  const int components = this->m_num_channels;
+  int x1 = (int)floorf(u);
+  int x2 = (int)ceilf(u);
+  int y1 = (int)floorf(v);
+  int y2 = (int)ceilf(v);
+
+  /* pixel value must be already wrapped, however values at boundaries may flip */
+  if (wrap_x) {
+    if (x1 < 0) {
+      x1 = width - 1;
+    }
+    if (x2 >= width) {
+      x2 = 0;
+    }
+  }
+  else if (x2 < 0 || x1 >= width) {
+    copy_vn_fl(result, components, 0.0f);
+    return;
+  }
+
+  if (wrap_y) {
+    if (y1 < 0) {
+      y1 = height - 1;
+    }
+    if (y2 >= height) {
+      y2 = 0;
+    }
+  }
+  else if (y2 < 0 || y1 >= height) {
+    copy_vn_fl(result, components, 0.0f);
+    return;
+  }
+
+  /* sample including outside of edges of image */
+  float row1[4] = {0.0f, 0.0f, 0.0f, 0.0f};
+  float row2[4] = {0.0f, 0.0f, 0.0f, 0.0f};
+  float row3[4] = {0.0f, 0.0f, 0.0f, 0.0f};
+  float row4[4] = {0.0f, 0.0f, 0.0f, 0.0f};
+  if (x1 >= 0 && y1 >= 0) {
+    half_to_float_array(row1, &this->m_halfBuffer[(width * y1 + x1) * components], components);
+  }
+  if (x1 >= 0 && y2 <= height - 1) {
+    half_to_float_array(row2, &this->m_halfBuffer[(width * y2 + x1) * components], components);
+  }
+  if (x2 <= width - 1 && y1 >= 0) {
+    half_to_float_array(row3, &this->m_halfBuffer[(width * y1 + x2) * components], components);
+  }
+  if (x2 <= width - 1 && y2 <= height - 1) {
+    half_to_float_array(row4, &this->m_halfBuffer[(width * y2 + x2) * components], components);
+  }
+
+  const float a = u - floorf(u);
+  const float b = v - floorf(v);
+  const float a_b = a * b;
+  const float ma_b = (1.0f - a) * b;
+  const float a_mb = a * (1.0f - b);
+  const float ma_mb = (1.0f - a) * (1.0f - b);
+  for (int i = 0; i < components; i++) {
+    result[i] = ma_mb * row1[i] + a_mb * row3[i] + ma_b * row2[i] + a_b * row4[i];
+  }
+}
+
 static void read_ewa_pixel_sampled(void *userdata, int x, int y, float result[4])
 {
   MemoryBuffer *buffer = (MemoryBuffer *)userdata;
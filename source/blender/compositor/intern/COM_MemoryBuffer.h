@@ -21,6 +21,7 @@ class MemoryBuffer;
 #pragma once
 
 #include "COM_ExecutionGroup.h"
+#include "COM_HalfFloat.h"
 #include "COM_MemoryProxy.h"
 #include "COM_SocketReader.h"
 
@@ -85,6 +86,12 @@ class MemoryBuffer {
    */
   float *m_buffer;
 
+  /**
+   * \brief the half float data, used instead of m_buffer by buffers with half float storage
+   * \see MemoryProxy.setUseHalfFloat
+   */
+  uint16_t *m_halfBuffer;
+
   /**
    * \brief the number of channels of a single value in the buffer.
    * For value buffers this is 1, vector 3 and color 4
@@ -131,12 +138,31 @@ class MemoryBuffer {
   /**
    * \brief get the data of this MemoryBuffer
    * \note buffer should already be available in memory
+   * \note not available for half float buffers, use the read and write methods for them
    */
   float *getBuffer()
   {
+    BLI_assert(this->m_halfBuffer == nullptr);
     return this->m_buffer;
   }
 
+  /**
+   * \brief is the data stored as half floats
+   */
+  bool isHalfFloat() const
+  {
+    return this->m_halfBuffer != nullptr;
+  }
+
+  /**
+   * \brief size of the data of this MemoryBuffer in bytes
+   */
+  size_t getMemorySize()
+  {
+    return (size_t)determineBufferSize() * this->m_num_channels *
+           (this->m_halfBuffer ? sizeof(*this->m_halfBuffer) : sizeof(*this->m_buffer));
+  }
+
   /**
    * \brief after execution the state will be set to available by calling this method
    */
@@ -245,6 +271,10 @@ class MemoryBuffer {
       int v = y;
       this->wrap_pixel(u, v, extend_x, extend_y);
       const int offset = (this->m_width * y + x) * this->m_num_channels;
+      if (this->m_halfBuffer) {
+        half_to_float_array(result, &this->m_halfBuffer[offset], this->m_num_channels);
+        return;
+      }
       float *buffer = &this->m_buffer[offset];
       memcpy(result, buffer, sizeof(float) * this->m_num_channels);
     }
@@ -271,10 +301,58 @@ class MemoryBuffer {
     BLI_assert((int)(MEM_allocN_len(this->m_buffer) / sizeof(*this->m_buffer)) ==
                (int)(this->determineBufferSize() * COM_NUMBER_OF_CHANNELS));
 #endif
+    if (this->m_halfBuffer) {
+      half_to_float_array(result, &this->m_halfBuffer[offset], this->m_num_channels);
+      return;
+    }
     float *buffer = &this->m_buffer[offset];
     memcpy(result, buffer, sizeof(float) * this->m_num_channels);
   }
 
+  /**
+   * \brief read a row of pixels, pixels outside the buffer are zero
+   * \param result: length pixels with the number of channels of the buffer
+   */
+  inline void readRow(float *result, int x, int y, int length)
+  {
+    if (y < m_rect.ymin || y >= m_rect.ymax) {
+      memset(result, 0, sizeof(float) * this->m_num_channels * length);
+      return;
+    }
+    const int x1 = max_ii(x, m_rect.xmin);
+    const int x2 = min_ii(x + length, m_rect.xmax);
+    if (x1 >= x2) {
+      memset(result, 0, sizeof(float) * this->m_num_channels * length);
+      return;
+    }
+    if (x1 > x) {
+      memset(result, 0, sizeof(float) * this->m_num_channels * (x1 - x));
+    }
+    const int offset = (this->m_width * (y - m_rect.ymin) + (x1 - m_rect.xmin)) *
+                       this->m_num_channels;
+    if (this->m_halfBuffer) {
+      half_to_float_array(result + (x1 - x) * this->m_num_channels,
+                          &this->m_halfBuffer[offset],
+                          this->m_num_channels * (x2 - x1));
+    }
+    else {
+      memcpy(result + (x1 - x) * this->m_num_channels,
+             &this->m_buffer[offset],
+             sizeof(float) * this->m_num_channels * (x2 - x1));
+    }
+    if (x2 < x + length) {
+      memset(result + (x2 - x) * this->m_num_channels,
+             0,
+             sizeof(float) * this->m_num_channels * (x + length - x2));
+    }
+  }
+
+  /**
+   * \brief write a row of pixels, pixels outside the buffer are skipped
+   * \param values: length pixels with the number of channels of the buffer
+   */
+  void writeRow(const float *values, int x, int y, int length);
+
   void writePixel(int x, int y, const float color[4]);
   void addPixel(int x, int y, const float color[4]);
   inline void readBilinear(float *result,
@@ -291,6 +369,10 @@ class MemoryBuffer {
       copy_vn_fl(result, this->m_num_channels, 0.0f);
       return;
     }
+    if (this->m_halfBuffer) {
+      readBilinearHalf(result, u, v, extend_x == COM_MB_REPEAT, extend_y == COM_MB_REPEAT);
+      return;
+    }
     BLI_bilinear_interpolation_wrap_fl(this->m_buffer,
                                        result,
                                        this->m_width,
@@ -352,6 +434,12 @@ class MemoryBuffer {
  private:
   unsigned int determineBufferSize();
 
+  /**
+   * \brief bilinear interpolation of half float buffers, matching
+   * BLI_bilinear_interpolation_wrap_fl
+   */
+  void readBilinearHalf(float *result, float u, float v, bool wrap_x, bool wrap_y);
+
 #ifdef WITH_CXX_GUARDEDALLOC
   MEM_CXX_CLASS_ALLOC_FUNCS("COM:MemoryBuffer")
 #endif
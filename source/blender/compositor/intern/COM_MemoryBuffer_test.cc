@@ -0,0 +1,173 @@
+/*
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ *
+ * Copyright 2020, Blender Foundation.
+ */
+#include "testing/testing.h"
+
+#include "MEM_guardedalloc.h"
+
+#include "COM_MemoryBuffer.h"
+#include "COM_MemoryProxy.h"
+
+/* Half floats have 11 significant bits, values below 4 are stored within this error. */
+static const float HALF_EPSILON = 4.0f / 2048.0f;
+
+static const int WIDTH = 8;
+static const int HEIGHT = 4;
+
+static void pixel_color(int x, int y, float r_color[4])
+{
+  r_color[0] = x * 0.1f;
+  r_color[1] = y * 0.25f;
+  r_color[2] = 1.0f + x * 0.333f;
+  r_color[3] = 0.5f;
+}
+
+class MemoryBufferHalfTest : public testing::Test {
+ protected:
+  MemoryProxy proxy_{COM_DT_COLOR};
+  rcti rect_;
+  MemoryBuffer *buffer_ = nullptr;
+
+  void SetUp() override
+  {
+    proxy_.setUseHalfFloat(true);
+    BLI_rcti_init(&rect_, 0, WIDTH, 0, HEIGHT);
+    buffer_ = new MemoryBuffer(&proxy_, 0, &rect_);
+    buffer_->clear();
+  }
+
+  void TearDown() override
+  {
+    delete buffer_;
+  }
+
+  void fill_rows()
+  {
+    float row[WIDTH * COM_NUM_CHANNELS_COLOR];
+    for (int y = 0; y < HEIGHT; y++) {
+      for (int x = 0; x < WIDTH; x++) {
+        pixel_color(x, y, &row[x * COM_NUM_CHANNELS_COLOR]);
+      }
+      buffer_->writeRow(row, 0, y, WIDTH);
+    }
+  }
+
+  void expect_pixels(MemoryBuffer *buffer)
+  {
+    for (int y = 0; y < HEIGHT; y++) {
+      for (int x = 0; x < WIDTH; x++) {
+        float expected[4], result[4];
+        pixel_color(x, y, expected);
+        buffer->read(result, x, y);
+        EXPECT_V4_NEAR(result, expected, HALF_EPSILON);
+      }
+    }
+  }
+};
+
+TEST_F(MemoryBufferHalfTest, write_read_row)
+{
+  EXPECT_TRUE(buffer_->isHalfFloat());
+  fill_rows();
+
+  /* A row starting left of the buffer and ending right of it is zero outside. */
+  const int length = WIDTH + 4;
+  float row[length * COM_NUM_CHANNELS_COLOR];
+  buffer_->readRow(row, -2, 1, length);
+  for (int i = 0; i < length; i++) {
+    const int x = i - 2;
+    float expected[4] = {0.0f, 0.0f, 0.0f, 0.0f};
+    if (x >= 0 && x < WIDTH) {
+      pixel_color(x, 1, expected);
+    }
+    const float *pixel = &row[i * COM_NUM_CHANNELS_COLOR];
+    EXPECT_V4_NEAR(pixel, expected, HALF_EPSILON);
+  }
+
+  /* Rows outside the buffer read as zero and are not written. */
+  buffer_->readRow(row, 0, HEIGHT, WIDTH);
+  for (int i = 0; i < WIDTH * COM_NUM_CHANNELS_COLOR; i++) {
+    EXPECT_EQ(row[i], 0.0f);
+  }
+  buffer_->writeRow(row, 0, -1, WIDTH);
+  expect_pixels(buffer_);
+  EXPECT_TRUE(buffer_->isHalfFloat());
+}
+
+TEST_F(MemoryBufferHalfTest, write_read_pixel)
+{
+  float color[4], result[4];
+  pixel_color(3, 2, color);
+  buffer_->writePixel(3, 2, color);
+  buffer_->read(result, 3, 2);
+  EXPECT_V4_NEAR(result, color, HALF_EPSILON);
+  buffer_->readNoCheck(result, 3, 2);
+  EXPECT_V4_NEAR(result, color, HALF_EPSILON);
+
+  /* Pixels outside the buffer are skipped when written and zero when read. */
+  const float zero[4] = {0.0f, 0.0f, 0.0f, 0.0f};
+  buffer_->writePixel(WIDTH, 0, color);
+  buffer_->read(result, WIDTH, 0);
+  EXPECT_V4_NEAR(result, zero, 0.0f);
+}
+
+TEST_F(MemoryBufferHalfTest, copy_content)
+{
+  fill_rows();
+
+  MemoryBuffer float_buffer(COM_DT_COLOR, &rect_);
+  EXPECT_FALSE(float_buffer.isHalfFloat());
+  float_buffer.copyContentFrom(buffer_);
+  expect_pixels(&float_buffer);
+
+  MemoryBuffer half_buffer(&proxy_, 1, &rect_);
+  EXPECT_TRUE(half_buffer.isHalfFloat());
+  half_buffer.copyContentFrom(&float_buffer);
+  expect_pixels(&half_buffer);
+
+  MemoryBuffer *duplicate = buffer_->duplicate();
+  EXPECT_FALSE(duplicate->isHalfFloat());
+  expect_pixels(duplicate);
+  delete duplicate;
+}
+
+/* Color buffers stored as half floats use half the memory of float buffers. */
+TEST(MemoryBufferMemoryTest, half_float_memory)
+{
+  const int width = 512, height = 256;
+  MemoryProxy float_proxy(COM_DT_COLOR);
+  MemoryProxy half_proxy(COM_DT_COLOR);
+  half_proxy.setUseHalfFloat(true);
+
+  const size_t mem_start = MEM_get_memory_in_use();
+  float_proxy.allocate(width, height);
+  const size_t mem_float = MEM_get_memory_in_use() - mem_start;
+  half_proxy.allocate(width, height);
+  const size_t mem_half = MEM_get_memory_in_use() - mem_start - mem_float;
+
+  EXPECT_FALSE(float_proxy.getBuffer()->isHalfFloat());
+  EXPECT_TRUE(half_proxy.getBuffer()->isHalfFloat());
+  EXPECT_EQ(float_proxy.getBuffer()->getMemorySize(),
+            sizeof(float) * width * height * COM_NUM_CHANNELS_COLOR);
+  EXPECT_EQ(half_proxy.getBuffer()->getMemorySize(),
+            sizeof(uint16_t) * width * height * COM_NUM_CHANNELS_COLOR);
+  EXPECT_NEAR((double)mem_half / (double)mem_float, 0.5, 0.001);
+
+  float_proxy.free();
+  half_proxy.free();
+  EXPECT_EQ(MEM_get_memory_in_use(), mem_start);
+}
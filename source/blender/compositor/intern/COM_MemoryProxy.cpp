@@ -23,6 +23,8 @@ MemoryProxy::MemoryProxy(DataType datatype)
   this->m_writeBufferOperation = nullptr;
   this->m_executor = nullptr;
   this->m_datatype = datatype;
+  this->m_buffer = nullptr;
+  this->m_useHalfFloat = false;
 }
 
 void MemoryProxy::allocate(unsigned int width, unsigned int height)
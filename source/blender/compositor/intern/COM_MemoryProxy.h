@@ -64,6 +64,11 @@ class MemoryProxy {
    */
   DataType m_datatype;
 
+  /**
+   * \brief store the buffer as half floats
+   */
+  bool m_useHalfFloat;
+
  public:
   MemoryProxy(DataType type);
 
@@ -125,6 +130,22 @@ class MemoryProxy {
     return this->m_datatype;
   }
 
+  /**
+   * \brief store the buffer as half floats, halving its memory usage
+   * \note only for buffers that are read with the read methods of MemoryBuffer, not by complex
+   * operations that access the float data directly
+   * \see ExecutionSystem.determineHalfFloatProxies
+   */
+  void setUseHalfFloat(bool useHalfFloat)
+  {
+    this->m_useHalfFloat = useHalfFloat;
+  }
+
+  bool getUseHalfFloat() const
+  {
+    return this->m_useHalfFloat;
+  }
+
 #ifdef WITH_CXX_GUARDEDALLOC
   MEM_CXX_CLASS_ALLOC_FUNCS("COM:MemoryProxy")
 #endif
@@ -36,6 +36,9 @@ NodeOperation::NodeOperation()
   this->m_height = 0;
   this->m_isResolutionSet = false;
   this->m_openCL = false;
+  this->m_fullFrame = false;
+  this->m_nodeHash = 0;
+  this->m_resultCacheable = true;
   this->m_btree = nullptr;
 }
 
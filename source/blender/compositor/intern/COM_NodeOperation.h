@@ -39,6 +39,7 @@ using std::min;
 
 class OpenCLDevice;
 class ReadBufferOperation;
+class ResultCacheKey;
 class WriteBufferOperation;
 
 class NodeOperationInput;
@@ -123,6 +124,23 @@ class NodeOperation : public SocketReader {
    */
   bool m_isResolutionSet;
 
+  /**
+   * \brief is this operation executed in full frame mode
+   * \see FusedRowProgram
+   */
+  bool m_fullFrame;
+
+  /**
+   * \brief hash of the settings of the node this operation was created from
+   * \see ResultCache
+   */
+  uint64_t m_nodeHash;
+
+  /**
+   * \brief can results that depend on this operation be stored in the result cache
+   */
+  bool m_resultCacheable;
+
  public:
   virtual ~NodeOperation();
 
@@ -245,6 +263,72 @@ class NodeOperation : public SocketReader {
   }
   virtual void deinitExecution();
 
+  /**
+   * \brief can this operation compute whole rows of pixels at once
+   *
+   * Only operations of which an output pixel only depends on the input pixels at the same
+   * position can do this, like mix, math, color and conversion operations.
+   * \see executeRow
+   * \see FusedRowProgram
+   */
+  virtual bool isRowOperation() const
+  {
+    return false;
+  }
+
+  /**
+   * \brief compute a row of pixels at once, used in full frame execution
+   * Results must be the same as executePixelSampled with nearest sampling.
+   * \ingroup execution
+   * \param output: the pixels of the row, with the number of channels of the output socket
+   * \param inputs: the pixels of the row for each input socket, with the number of channels of
+   * the socket data type
+   * \param x: position of the first pixel of the row
+   * \param y: position of the row
+   * \param length: number of pixels in the row
+   */
+  virtual void executeRow(float * /*output*/,
+                          const float *const * /*inputs*/,
+                          int /*x*/,
+                          int /*y*/,
+                          int /*length*/)
+  {
+  }
+
+  void setFullFrame(bool fullFrame)
+  {
+    this->m_fullFrame = fullFrame;
+  }
+  bool isFullFrame() const
+  {
+    return this->m_fullFrame;
+  }
+
+  void setNodeHash(uint64_t nodeHash, bool cacheable)
+  {
+    this->m_nodeHash = nodeHash;
+    this->m_resultCacheable = cacheable;
+  }
+  uint64_t getNodeHash() const
+  {
+    return this->m_nodeHash;
+  }
+  bool isResultCacheable() const
+  {
+    return this->m_resultCacheable;
+  }
+
+  /**
+   * \brief add data that is read from outside of the node tree to a result cache key
+   * Called after initExecution, for operations that read images or render results.
+   * \return false when results depending on this operation can't be cached
+   * \see ResultCache
+   */
+  virtual bool hashExternalData(ResultCacheKey & /*key*/) const
+  {
+    return true;
+  }
+
   bool isResolutionSet()
   {
     return this->m_isResolutionSet;
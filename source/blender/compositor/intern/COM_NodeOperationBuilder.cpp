@@ -28,6 +28,7 @@
 #include "COM_NodeOperation.h"
 #include "COM_PreviewOperation.h"
 #include "COM_ReadBufferOperation.h"
+#include "COM_ResultCache.h"
 #include "COM_SetColorOperation.h"
 #include "COM_SetValueOperation.h"
 #include "COM_SetVectorOperation.h"
@@ -38,7 +39,11 @@
 #include "COM_NodeOperationBuilder.h" /* own include */
 
 NodeOperationBuilder::NodeOperationBuilder(const CompositorContext *context, bNodeTree *b_nodetree)
-    : m_context(context), m_current_node(nullptr), m_active_viewer(nullptr)
+    : m_context(context),
+      m_current_node(nullptr),
+      m_current_node_hash(0),
+      m_current_node_cacheable(true),
+      m_active_viewer(nullptr)
 {
   m_graph.from_bNodeTree(*context, b_nodetree);
 }
@@ -56,6 +61,12 @@ void NodeOperationBuilder::convertToOperations(ExecutionSystem *system)
     Node *node = (Node *)m_graph.nodes()[index];
 
     m_current_node = node;
+    m_current_node_hash = 0;
+    m_current_node_cacheable = true;
+    if (m_context->isResultCacheEnabled() && node->getbNode()) {
+      m_current_node_hash = ResultCache::hashNode(
+          node->getbNode(), *m_context, &m_current_node_cacheable);
+    }
 
     DebugInfo::node_to_operations(node);
     node->convertToOperations(converter, *m_context);
@@ -125,6 +136,9 @@ void NodeOperationBuilder::convertToOperations(ExecutionSystem *system)
 
 void NodeOperationBuilder::addOperation(NodeOperation *operation)
 {
+  if (m_current_node) {
+    operation->setNodeHash(m_current_node_hash, m_current_node_cacheable);
+  }
   m_operations.push_back(operation);
 }
 
@@ -321,6 +335,13 @@ void NodeOperationBuilder::add_operation_input_constants()
   }
 }
 
+static uint64_t hash_constant_value(const float *value, size_t size)
+{
+  ResultCacheKey key;
+  key.add(value, size);
+  return key.getHash();
+}
+
 void NodeOperationBuilder::add_input_constant_value(NodeOperationInput *input,
                                                     NodeInput *node_input)
 {
@@ -336,6 +357,7 @@ void NodeOperationBuilder::add_input_constant_value(NodeOperationInput *input,
 
       SetValueOperation *op = new SetValueOperation();
       op->setValue(value);
+      op->setNodeHash(hash_constant_value(&value, sizeof(value)), true);
       addOperation(op);
       addLink(op->getOutputSocket(), input);
       break;
@@ -351,6 +373,7 @@ void NodeOperationBuilder::add_input_constant_value(NodeOperationInput *input,
 
       SetColorOperation *op = new SetColorOperation();
       op->setChannels(value);
+      op->setNodeHash(hash_constant_value(value, sizeof(value)), true);
       addOperation(op);
       addLink(op->getOutputSocket(), input);
       break;
@@ -366,6 +389,7 @@ void NodeOperationBuilder::add_input_constant_value(NodeOperationInput *input,
 
       SetVectorOperation *op = new SetVectorOperation();
       op->setVector(value);
+      op->setNodeHash(hash_constant_value(value, sizeof(value)), true);
       addOperation(op);
       addLink(op->getOutputSocket(), input);
       break;
@@ -88,6 +88,9 @@ class NodeOperationBuilder {
   OutputSocketMap m_output_map;
 
   Node *m_current_node;
+  /** Result cache hash of the settings of the current node, \see ResultCache */
+  uint64_t m_current_node_hash;
+  bool m_current_node_cacheable;
 
   /** Operation that will be writing to the viewer image
    *  Only one operation can occupy this place at a time,
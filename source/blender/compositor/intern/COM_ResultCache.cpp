@@ -0,0 +1,441 @@
+/*
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ *
+ * Copyright 2020, Blender Foundation.
+ */
+
+#include "COM_ResultCache.h"
+#include "COM_CompositorContext.h"
+#include "COM_MemoryBuffer.h"
+
+#include <cstring>
+#include <utility>
+
+#include "BLI_listbase.h"
+#include "BLI_utildefines.h"
+
+#include "BKE_node.h"
+
+#include "DNA_camera_types.h"
+#include "DNA_color_types.h"
+#include "DNA_image_types.h"
+#include "DNA_node_types.h"
+#include "DNA_object_types.h"
+#include "DNA_scene_types.h"
+#include "DNA_texture_types.h"
+
+#include "MEM_guardedalloc.h"
+
+/* ******** Result Cache Key ******** */
+
+/* Mixing step of MurmurHash64A. */
+static inline uint64_t hash_mix(uint64_t hash, uint64_t value)
+{
+  const uint64_t m = 0xc6a4a7935bd1e995ULL;
+  value *= m;
+  value ^= value >> 47;
+  value *= m;
+  hash ^= value;
+  hash *= m;
+  return hash;
+}
+
+ResultCacheKey::ResultCacheKey()
+{
+  this->m_hash = 0x9e3779b97f4a7c15ULL;
+  this->m_usesRenderResult = false;
+}
+
+void ResultCacheKey::add(const void *data, size_t size)
+{
+  const unsigned char *bytes = (const unsigned char *)data;
+  add((uint64_t)size);
+  while (size >= 8) {
+    uint64_t value;
+    memcpy(&value, bytes, sizeof(value));
+    add(value);
+    bytes += 8;
+    size -= 8;
+  }
+  if (size > 0) {
+    uint64_t value = 0;
+    memcpy(&value, bytes, size);
+    add(value);
+  }
+}
+
+void ResultCacheKey::add(uint64_t value)
+{
+  this->m_hash = hash_mix(this->m_hash, value);
+  this->m_values.push_back(value);
+}
+
+void ResultCacheKey::add(const char *str)
+{
+  add(str, strlen(str));
+}
+
+void ResultCacheKey::add(const ResultCacheKey &key)
+{
+  add(key.m_hash);
+  this->m_inputs.push_back(std::make_shared<const ResultCacheKey>(key));
+  if (key.m_usesRenderResult) {
+    this->m_usesRenderResult = true;
+  }
+}
+
+bool ResultCacheKey::operator==(const ResultCacheKey &other) const
+{
+  std::set<std::pair<const ResultCacheKey *, const ResultCacheKey *>> equal_keys;
+  return equals(other, equal_keys);
+}
+
+bool ResultCacheKey::equals(
+    const ResultCacheKey &other,
+    std::set<std::pair<const ResultCacheKey *, const ResultCacheKey *>> &equal_keys) const
+{
+  if (this == &other) {
+    return true;
+  }
+  if (this->m_hash != other.m_hash || this->m_values != other.m_values ||
+      this->m_inputs.size() != other.m_inputs.size()) {
+    return false;
+  }
+  if (!equal_keys.insert(std::make_pair(this, &other)).second) {
+    return true;
+  }
+  for (size_t i = 0; i < this->m_inputs.size(); i++) {
+    if (!this->m_inputs[i]->equals(*other.m_inputs[i], equal_keys)) {
+      return false;
+    }
+  }
+  return true;
+}
+
+/* ******** Result Cache ******** */
+
+std::map<uint64_t, ResultCache::Entry> ResultCache::s_entries;
+size_t ResultCache::s_totalSize = 0;
+uint64_t ResultCache::s_useCounter = 0;
+ThreadMutex ResultCache::s_mutex = BLI_MUTEX_INITIALIZER;
+
+void ResultCache::freeEntry(std::map<uint64_t, Entry>::iterator it)
+{
+  MEM_freeN(it->second.buffer);
+  s_totalSize -= it->second.size;
+  s_entries.erase(it);
+}
+
+void ResultCache::freeUntilSize(const void *owner, size_t size)
+{
+  size_t owner_size = 0;
+  for (std::map<uint64_t, Entry>::iterator it = s_entries.begin(); it != s_entries.end(); ++it) {
+    if (it->second.owner == owner) {
+      owner_size += it->second.size;
+    }
+  }
+
+  while (owner_size > size) {
+    std::map<uint64_t, Entry>::iterator oldest = s_entries.end();
+    for (std::map<uint64_t, Entry>::iterator it = s_entries.begin(); it != s_entries.end(); ++it) {
+      if (it->second.owner == owner &&
+          (oldest == s_entries.end() || it->second.last_used < oldest->second.last_used)) {
+        oldest = it;
+      }
+    }
+    owner_size -= oldest->second.size;
+    freeEntry(oldest);
+  }
+}
+
+bool ResultCache::lookup(const ResultCacheKey &key, MemoryBuffer *buffer)
+{
+  bool found = false;
+
+  BLI_mutex_lock(&s_mutex);
+  std::map<uint64_t, Entry>::iterator it = s_entries.find(key.getHash());
+  /* Keys with the same hash that differ are not the same result. */
+  if (it != s_entries.end() && it->second.key == key) {
+    Entry &entry = it->second;
+    if (entry.width == (int)buffer->getWidth() && entry.height == (int)buffer->getHeight() &&
+        entry.num_channels == (int)buffer->get_num_channels()) {
+      if (buffer->isHalfFloat()) {
+        const rcti *rect = buffer->getRect();
+        for (int y = 0; y < entry.height; y++) {
+          buffer->writeRow(entry.buffer + (size_t)y * entry.width * entry.num_channels,
+                           rect->xmin,
+                           rect->ymin + y,
+                           entry.width);
+        }
+      }
+      else {
+        memcpy(buffer->getBuffer(), entry.buffer, entry.size);
+      }
+      entry.last_used = ++s_useCounter;
+      found = true;
+    }
+  }
+  BLI_mutex_unlock(&s_mutex);
+
+  return found;
+}
+
+void ResultCache::store(const ResultCacheKey &key,
+                        const void *owner,
+                        MemoryBuffer *buffer,
+                        size_t max_size)
+{
+  const size_t size = sizeof(float) * buffer->getWidth() * buffer->getHeight() *
+                      buffer->get_num_channels();
+  if (size == 0 || size > max_size) {
+    return;
+  }
+
+  BLI_mutex_lock(&s_mutex);
+  std::map<uint64_t, Entry>::iterator it = s_entries.find(key.getHash());
+  if (it != s_entries.end()) {
+    freeEntry(it);
+  }
+  freeUntilSize(owner, max_size - size);
+
+  Entry entry;
+  entry.key = key;
+  entry.buffer = (float *)MEM_mallocN(size, "ResultCache entry");
+  entry.size = size;
+  entry.width = buffer->getWidth();
+  entry.height = buffer->getHeight();
+  entry.num_channels = buffer->get_num_channels();
+  if (buffer->isHalfFloat()) {
+    /* Entries are kept as floats, so they can be used by both kinds of buffers. */
+    const rcti *rect = buffer->getRect();
+    for (int y = 0; y < entry.height; y++) {
+      buffer->readRow(entry.buffer + (size_t)y * entry.width * entry.num_channels,
+                      rect->xmin,
+                      rect->ymin + y,
+                      entry.width);
+    }
+  }
+  else {
+    memcpy(entry.buffer, buffer->getBuffer(), size);
+  }
+  entry.uses_render_result = key.usesRenderResult();
+  entry.last_used = ++s_useCounter;
+  entry.owner = owner;
+  s_entries[key.getHash()] = std::move(entry);
+  s_totalSize += size;
+  BLI_mutex_unlock(&s_mutex);
+}
+
+void ResultCache::clear()
+{
+  BLI_mutex_lock(&s_mutex);
+  while (!s_entries.empty()) {
+    freeEntry(s_entries.begin());
+  }
+  BLI_mutex_unlock(&s_mutex);
+}
+
+void ResultCache::clear(const void *owner)
+{
+  BLI_mutex_lock(&s_mutex);
+  std::map<uint64_t, Entry>::iterator it = s_entries.begin();
+  while (it != s_entries.end()) {
+    std::map<uint64_t, Entry>::iterator next = it;
+    ++next;
+    if (it->second.owner == owner) {
+      freeEntry(it);
+    }
+    it = next;
+  }
+  BLI_mutex_unlock(&s_mutex);
+}
+
+void ResultCache::clearRenderResults()
+{
+  BLI_mutex_lock(&s_mutex);
+  std::map<uint64_t, Entry>::iterator it = s_entries.begin();
+  while (it != s_entries.end()) {
+    std::map<uint64_t, Entry>::iterator next = it;
+    ++next;
+    if (it->second.uses_render_result) {
+      freeEntry(it);
+    }
+    it = next;
+  }
+  BLI_mutex_unlock(&s_mutex);
+}
+
+size_t ResultCache::getTotalSize()
+{
+  BLI_mutex_lock(&s_mutex);
+  const size_t size = s_totalSize;
+  BLI_mutex_unlock(&s_mutex);
+  return size;
+}
+
+size_t ResultCache::getSize(const void *owner)
+{
+  size_t size = 0;
+  BLI_mutex_lock(&s_mutex);
+  for (std::map<uint64_t, Entry>::iterator it = s_entries.begin(); it != s_entries.end(); ++it) {
+    if (it->second.owner == owner) {
+      size += it->second.size;
+    }
+  }
+  BLI_mutex_unlock(&s_mutex);
+  return size;
+}
+
+/* Curve mappings are hashed by their points, the tables are derived from them. */
+static void hash_curve_mapping(ResultCacheKey &key, const CurveMapping *cumap)
+{
+  key.add((uint64_t)cumap->flag);
+  key.add(&cumap->clipr, sizeof(cumap->clipr));
+  key.add(cumap->black, sizeof(cumap->black));
+  key.add(cumap->white, sizeof(cumap->white));
+  key.add((uint64_t)cumap->tone);
+  for (int i = 0; i < CM_TOT; i++) {
+    const CurveMap *cuma = &cumap->cm[i];
+    key.add(cuma->ext_in, sizeof(cuma->ext_in));
+    key.add(cuma->ext_out, sizeof(cuma->ext_out));
+    if (cuma->curve) {
+      key.add(cuma->curve, sizeof(CurveMapPoint) * cuma->totpoint);
+    }
+  }
+}
+
+/* Cryptomatte entries are hashed by their names and hashes, not by the list pointers. */
+static void hash_cryptomatte(ResultCacheKey &key, const NodeCryptomatte *crypto)
+{
+  key.add(crypto->add, sizeof(crypto->add));
+  key.add(crypto->remove, sizeof(crypto->remove));
+  key.add((uint64_t)crypto->num_inputs);
+  LISTBASE_FOREACH (const CryptomatteEntry *, entry, &crypto->entries) {
+    key.add(&entry->encoded_hash, sizeof(entry->encoded_hash));
+    key.add(entry->name);
+  }
+}
+
+/* Hash node storage, following the pointers it contains.
+ * Returns false for storage whose pointers are not followed. */
+static bool hash_node_storage(ResultCacheKey &key, const bNode *node)
+{
+  const char *storagename = node->typeinfo ? node->typeinfo->storagename : "";
+
+  if (STREQ(storagename, "CurveMapping")) {
+    hash_curve_mapping(key, (const CurveMapping *)node->storage);
+  }
+  else if (STREQ(storagename, "NodeCryptomatte")) {
+    hash_cryptomatte(key, (const NodeCryptomatte *)node->storage);
+  }
+  else if (STREQ(storagename, "ImageUser")) {
+    /* The scene is only used to find render results, which are hashed by their operations. */
+    ImageUser iuser = *(const ImageUser *)node->storage;
+    iuser.scene = nullptr;
+    key.add(&iuser, sizeof(iuser));
+  }
+  else if (STREQ(storagename, "TexMapping")) {
+    /* Texture nodes can't be cached, their texture is an ID. */
+    TexMapping texmap = *(const TexMapping *)node->storage;
+    texmap.ob = nullptr;
+    key.add(&texmap, sizeof(texmap));
+  }
+  else if (STREQ(storagename, "NodeImageMultiFile")) {
+    /* Color management settings of the output formats hold curve mappings. */
+    return false;
+  }
+  else {
+    /* Storage of the remaining compositor nodes contains no pointers. */
+    key.add(node->storage, MEM_allocN_len(node->storage));
+  }
+  return true;
+}
+
+/* Camera settings used by the defocus node to convert depth to blur radius. */
+static void hash_defocus_camera(ResultCacheKey &key, const Object *camob)
+{
+  if (camob == nullptr || camob->type != OB_CAMERA) {
+    return;
+  }
+  const Camera *camera = (const Camera *)camob->data;
+  key.add(camob->obmat, sizeof(camob->obmat));
+  key.add(&camera->lens, sizeof(camera->lens));
+  key.add(&camera->sensor_x, sizeof(camera->sensor_x));
+  key.add(&camera->sensor_y, sizeof(camera->sensor_y));
+  key.add((uint64_t)camera->sensor_fit);
+  key.add(&camera->dof.focus_distance, sizeof(camera->dof.focus_distance));
+  if (camera->dof.focus_object) {
+    key.add(camera->dof.focus_object->obmat[3], sizeof(float[3]));
+  }
+}
+
+uint64_t ResultCache::hashNode(const bNode *node,
+                               const CompositorContext &context,
+                               bool *r_cacheable)
+{
+  ResultCacheKey key;
+  *r_cacheable = true;
+
+  key.add(node->idname);
+  key.add(&node->custom1, sizeof(node->custom1));
+  key.add(&node->custom2, sizeof(node->custom2));
+  key.add(&node->custom3, sizeof(node->custom3));
+  key.add(&node->custom4, sizeof(node->custom4));
+
+  if (node->storage && !hash_node_storage(key, node)) {
+    *r_cacheable = false;
+  }
+
+  LISTBASE_FOREACH (const bNodeSocket *, sock, &node->inputs) {
+    if (sock->default_value) {
+      key.add(sock->default_value, MEM_allocN_len(sock->default_value));
+    }
+  }
+  /* Value and RGB nodes store their value in the output socket. */
+  LISTBASE_FOREACH (const bNodeSocket *, sock, &node->outputs) {
+    if (sock->default_value) {
+      key.add(sock->default_value, MEM_allocN_len(sock->default_value));
+    }
+  }
+
+  if (node->id) {
+    switch (GS(node->id->name)) {
+      case ID_SCE:
+        /* Render layers are hashed by their operations, see RenderLayersProg. */
+        key.add((uint64_t)node->id);
+        if (node->type == CMP_NODE_DEFOCUS) {
+          hash_defocus_camera(key, ((const Scene *)node->id)->camera);
+        }
+        break;
+      case ID_IM:
+        /* Image buffers are hashed by their operations, see BaseImageOperation. */
+        key.add((uint64_t)node->id);
+        break;
+      default:
+        /* Movie clips, masks and textures can change without the node changing. */
+        *r_cacheable = false;
+        break;
+    }
+  }
+  else if (node->type == CMP_NODE_DEFOCUS && context.getScene()) {
+    hash_defocus_camera(key, context.getScene()->camera);
+  }
+
+  if (node->type == CMP_NODE_TIME) {
+    key.add((uint64_t)context.getFramenumber());
+  }
+
+  return key.getHash();
+}
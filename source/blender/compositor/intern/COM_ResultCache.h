@@ -0,0 +1,179 @@
+/*
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ *
+ * Copyright 2020, Blender Foundation.
+ */
+
+#pragma once
+
+#include <map>
+#include <memory>
+#include <set>
+#include <stdint.h>
+#include <string>
+#include <vector>
+
+#include "BLI_threads.h"
+
+#ifdef WITH_CXX_GUARDEDALLOC
+#  include "MEM_guardedalloc.h"
+#endif
+
+class CompositorContext;
+class MemoryBuffer;
+struct bNode;
+
+/**
+ * \brief Key of a result in the ResultCache.
+ *
+ * Holds everything a result depends on: the operations that computed it, the hashes of the
+ * settings of the nodes they were created from, data they read from outside of the node tree and
+ * the keys of their inputs. The hash is used to find a cached result, the complete key is
+ * compared to check that the result was computed from the same data.
+ */
+class ResultCacheKey {
+ private:
+  uint64_t m_hash;
+
+  /** Values added to the key, including the hashes of the input keys. */
+  std::vector<uint64_t> m_values;
+
+  /** Keys of the inputs, shared with the keys that are copies of the same key. */
+  std::vector<std::shared_ptr<const ResultCacheKey>> m_inputs;
+
+  /**
+   * \brief does the result depend on render results
+   * These results are freed when scenes are rendered again, see ResultCache.clearRenderResults
+   */
+  bool m_usesRenderResult;
+
+ public:
+  ResultCacheKey();
+
+  void add(const void *data, size_t size);
+  void add(uint64_t value);
+  void add(const char *str);
+  void add(const ResultCacheKey &key);
+
+  bool operator==(const ResultCacheKey &other) const;
+
+  void setUsesRenderResult()
+  {
+    this->m_usesRenderResult = true;
+  }
+  bool usesRenderResult() const
+  {
+    return this->m_usesRenderResult;
+  }
+  uint64_t getHash() const
+  {
+    return this->m_hash;
+  }
+
+ private:
+  /* Inputs shared by several keys are compared once, equal_keys holds the compared pairs. */
+  bool equals(const ResultCacheKey &other,
+              std::set<std::pair<const ResultCacheKey *, const ResultCacheKey *>> &equal_keys) const;
+
+#ifdef WITH_CXX_GUARDEDALLOC
+  MEM_CXX_CLASS_ALLOC_FUNCS("COM:ResultCacheKey")
+#endif
+};
+
+/**
+ * \brief Results of operations, kept between executions of node trees.
+ *
+ * The results written by WriteBufferOperations, which are the results of complex operations like
+ * blurs, defocus, glare and denoise and of the operations they read from, are stored with a key
+ * of everything they depend on. When a node tree is executed again after an edit or on another
+ * frame, execution groups whose result is in the cache are not executed, so only the part of the
+ * tree that is affected by a change is computed again.
+ *
+ * Every result is owned by the scene whose node tree stored it. The least recently used results
+ * of a node tree are freed to stay within its memory budget, results of other node trees are
+ * kept.
+ * \see ExecutionSystem.allocateProxy
+ */
+class ResultCache {
+ private:
+  struct Entry {
+    ResultCacheKey key;
+    float *buffer;
+    size_t size;
+    int width;
+    int height;
+    int num_channels;
+    bool uses_render_result;
+    uint64_t last_used;
+    const void *owner;
+  };
+
+  static std::map<uint64_t, Entry> s_entries;
+  static size_t s_totalSize;
+  static uint64_t s_useCounter;
+  static ThreadMutex s_mutex;
+
+  static void freeEntry(std::map<uint64_t, Entry>::iterator it);
+  static void freeUntilSize(const void *owner, size_t size);
+
+ public:
+  /**
+   * \brief copy a cached result into the buffer
+   * \return false when there is no result for the key with the size of the buffer
+   */
+  static bool lookup(const ResultCacheKey &key, MemoryBuffer *buffer);
+
+  /**
+   * \brief store a copy of the buffer, freeing the least recently used results of the owner to
+   * keep its results within max_size bytes
+   */
+  static void store(const ResultCacheKey &key,
+                    const void *owner,
+                    MemoryBuffer *buffer,
+                    size_t max_size);
+
+  /**
+   * \brief free all cached results
+   */
+  static void clear();
+
+  /**
+   * \brief free the cached results stored by the owner
+   */
+  static void clear(const void *owner);
+
+  /**
+   * \brief free cached results that depend on render results
+   */
+  static void clearRenderResults();
+
+  /**
+   * \brief total size of the cached results in bytes
+   */
+  static size_t getTotalSize();
+
+  /**
+   * \brief size of the cached results stored by the owner in bytes
+   */
+  static size_t getSize(const void *owner);
+
+  /**
+   * \brief hash the settings of a node that affect the operations it is converted to
+   * \param r_cacheable: set to false when the node reads data that is not included in the
+   * hash, like movie clips, masks and storage with pointers that are not followed, so results
+   * depending on it can't be cached
+   */
+  static uint64_t hashNode(const bNode *node, const CompositorContext &context, bool *r_cacheable);
+};
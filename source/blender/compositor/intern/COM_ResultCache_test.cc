@@ -0,0 +1,206 @@
+/*
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ *
+ * Copyright 2020, Blender Foundation.
+ */
+#include "testing/testing.h"
+
+#include "COM_CompositorContext.h"
+#include "COM_MemoryBuffer.h"
+#include "COM_ResultCache.h"
+
+#include "BLI_listbase.h"
+#include "BLI_string.h"
+
+#include "BKE_node.h"
+
+#include "DNA_node_types.h"
+
+#include "MEM_guardedalloc.h"
+
+class ResultCacheTest : public testing::Test {
+ protected:
+  bNodeType type_ = {};
+  bNode node_ = {};
+  CompositorContext context_;
+
+  void SetUp() override
+  {
+    node_.typeinfo = &type_;
+  }
+
+  void TearDown() override
+  {
+    if (node_.storage) {
+      MEM_freeN(node_.storage);
+    }
+    ResultCache::clear();
+  }
+
+  void set_storage(const char *storagename, void *storage)
+  {
+    STRNCPY(type_.storagename, storagename);
+    node_.storage = storage;
+  }
+
+  uint64_t hash_node(bool expect_cacheable = true)
+  {
+    bool cacheable;
+    const uint64_t hash = ResultCache::hashNode(&node_, context_, &cacheable);
+    EXPECT_EQ(cacheable, expect_cacheable);
+    return hash;
+  }
+};
+
+static MemoryBuffer *create_buffer(int size, float value)
+{
+  rcti rect;
+  BLI_rcti_init(&rect, 0, size, 0, size);
+  MemoryBuffer *buffer = new MemoryBuffer(COM_DT_VALUE, &rect);
+  for (int i = 0; i < size * size; i++) {
+    buffer->getBuffer()[i] = value;
+  }
+  return buffer;
+}
+
+static ResultCacheKey create_key(uint64_t hash)
+{
+  ResultCacheKey key;
+  key.add(hash);
+  return key;
+}
+
+TEST_F(ResultCacheTest, hash_node_storage)
+{
+  STRNCPY(node_.idname, "CompositorNodeBlur");
+  set_storage("NodeBlurData", MEM_callocN(sizeof(NodeBlurData), __func__));
+  const uint64_t hash = hash_node();
+
+  /* The same settings at another address. */
+  void *storage = MEM_dupallocN(node_.storage);
+  MEM_freeN(node_.storage);
+  node_.storage = storage;
+  EXPECT_EQ(hash_node(), hash);
+
+  ((NodeBlurData *)node_.storage)->sizex = 10;
+  EXPECT_NE(hash_node(), hash);
+}
+
+TEST_F(ResultCacheTest, hash_node_cryptomatte)
+{
+  NodeCryptomatte *crypto = (NodeCryptomatte *)MEM_callocN(sizeof(NodeCryptomatte), __func__);
+  set_storage("NodeCryptomatte", crypto);
+  CryptomatteEntry entry_a = {};
+  STRNCPY(entry_a.name, "Cube");
+  entry_a.encoded_hash = 1.0f;
+  BLI_addtail(&crypto->entries, &entry_a);
+  const uint64_t hash = hash_node();
+
+  /* Entries are compared by content, not by address. */
+  CryptomatteEntry entry_b = entry_a;
+  BLI_listbase_clear(&crypto->entries);
+  BLI_addtail(&crypto->entries, &entry_b);
+  EXPECT_EQ(hash_node(), hash);
+
+  STRNCPY(entry_b.name, "Sphere");
+  EXPECT_NE(hash_node(), hash);
+
+  BLI_listbase_clear(&crypto->entries);
+  EXPECT_NE(hash_node(), hash);
+}
+
+TEST_F(ResultCacheTest, hash_node_uncacheable_storage)
+{
+  set_storage("NodeImageMultiFile", MEM_callocN(sizeof(NodeImageMultiFile), __func__));
+  hash_node(false);
+}
+
+/* A result stored for the settings of a node is not found after the node changed. */
+TEST_F(ResultCacheTest, changed_node_invalidates_result)
+{
+  int owner;
+  set_storage("NodeBlurData", MEM_callocN(sizeof(NodeBlurData), __func__));
+  const ResultCacheKey key = create_key(hash_node());
+
+  MemoryBuffer *stored = create_buffer(4, 0.5f);
+  ResultCache::store(key, &owner, stored, 1024 * 1024);
+  delete stored;
+
+  MemoryBuffer *result = create_buffer(4, 0.0f);
+  EXPECT_TRUE(ResultCache::lookup(key, result));
+  EXPECT_EQ(result->getBuffer()[0], 0.5f);
+
+  ((NodeBlurData *)node_.storage)->sizex = 10;
+  EXPECT_FALSE(ResultCache::lookup(create_key(hash_node()), result));
+  delete result;
+}
+
+/* Results are evicted within the budget of their owner, other owners keep their results. */
+TEST_F(ResultCacheTest, owner_budget)
+{
+  int owner_a, owner_b;
+  const size_t buffer_size = sizeof(float) * 4 * 4;
+  MemoryBuffer *buffer = create_buffer(4, 1.0f);
+
+  ResultCache::store(create_key(1), &owner_b, buffer, buffer_size);
+  ResultCache::store(create_key(2), &owner_a, buffer, buffer_size * 2);
+  ResultCache::store(create_key(3), &owner_a, buffer, buffer_size * 2);
+  EXPECT_EQ(ResultCache::getSize(&owner_a), buffer_size * 2);
+
+  /* Use the older result, so the other one is evicted next. */
+  EXPECT_TRUE(ResultCache::lookup(create_key(2), buffer));
+  ResultCache::store(create_key(4), &owner_a, buffer, buffer_size * 2);
+  EXPECT_TRUE(ResultCache::lookup(create_key(2), buffer));
+  EXPECT_FALSE(ResultCache::lookup(create_key(3), buffer));
+  EXPECT_TRUE(ResultCache::lookup(create_key(4), buffer));
+  EXPECT_TRUE(ResultCache::lookup(create_key(1), buffer));
+  EXPECT_EQ(ResultCache::getSize(&owner_b), buffer_size);
+
+  ResultCache::clear(&owner_a);
+  EXPECT_EQ(ResultCache::getSize(&owner_a), (size_t)0);
+  EXPECT_EQ(ResultCache::getTotalSize(), buffer_size);
+  EXPECT_TRUE(ResultCache::lookup(create_key(1), buffer));
+
+  delete buffer;
+}
+
+/* Keys are compared completely, including the keys of their inputs. */
+TEST(ResultCacheKeyTest, compare_inputs)
+{
+  const ResultCacheKey input_a = create_key(1);
+  const ResultCacheKey input_b = create_key(2);
+
+  ResultCacheKey key_a;
+  key_a.add((uint64_t)3);
+  key_a.add(input_a);
+  key_a.add(input_a);
+
+  ResultCacheKey key_b;
+  key_b.add((uint64_t)3);
+  key_b.add(create_key(1));
+  key_b.add(create_key(1));
+  EXPECT_TRUE(key_a == key_b);
+  EXPECT_EQ(key_a.getHash(), key_b.getHash());
+
+  ResultCacheKey key_c;
+  key_c.add((uint64_t)3);
+  key_c.add(input_a);
+  key_c.add(input_b);
+  EXPECT_FALSE(key_a == key_c);
+
+  /* A copy shares the inputs of the original. */
+  const ResultCacheKey copy = key_c;
+  EXPECT_TRUE(copy == key_c);
+}
@@ -25,6 +25,7 @@
 
 #include "COM_ExecutionSystem.h"
 #include "COM_MovieDistortionOperation.h"
+#include "COM_ResultCache.h"
 #include "COM_WorkScheduler.h"
 #include "COM_compositor.h"
 #include "clew.h"
@@ -117,4 +118,15 @@ void COM_deinitialize()
     BLI_mutex_unlock(&s_compositorMutex);
     BLI_mutex_end(&s_compositorMutex);
   }
+  COM_clearCaches();
+}
+
+void COM_clearCaches()
+{
+  ResultCache::clear();
+}
+
+void COM_clearRenderLayerCaches()
+{
+  ResultCache::clearRenderResults();
 }
@@ -18,8 +18,11 @@
 
 #include "COM_BokehBlurOperation.h"
 #include "BLI_math.h"
+#include "COM_FFTConvolution.h"
 #include "COM_OpenCLDevice.h"
 
+#include "MEM_guardedalloc.h"
+
 #include "RE_pipeline.h"
 
 BokehBlurOperation::BokehBlurOperation()
@@ -39,6 +42,46 @@ BokehBlurOperation::BokehBlurOperation()
   this->m_inputBoundingBoxReader = nullptr;
 
   this->m_extend_bounds = false;
+  this->m_fftResult = nullptr;
+  this->m_useFFT = false;
+}
+
+int BokehBlurOperation::getPixelSize() const
+{
+  const float max_dim = max(this->getWidth(), this->getHeight());
+  return this->m_size * max_dim / 100.0f;
+}
+
+void BokehBlurOperation::executeFFT(MemoryBuffer *inputBuffer)
+{
+  const int pixelSize = getPixelSize();
+  const int kernel_size = 2 * pixelSize + 1;
+  const float m = this->m_bokehDimension / pixelSize;
+  float *kernel = (float *)MEM_callocN(
+      sizeof(float) * kernel_size * kernel_size * COM_NUM_CHANNELS_COLOR, __func__);
+
+  /* Same offsets as executePixel, the last row and column are not used. */
+  for (int dy = -pixelSize; dy < pixelSize; dy++) {
+    for (int dx = -pixelSize; dx < pixelSize; dx++) {
+      float *bokeh = &kernel[((dy + pixelSize) * kernel_size + (dx + pixelSize)) *
+                             COM_NUM_CHANNELS_COLOR];
+      const float u = this->m_bokehMidX - dx * m;
+      const float v = this->m_bokehMidY - dy * m;
+      this->m_inputBokehProgram->readSampled(bokeh, u, v, COM_PS_NEAREST);
+    }
+  }
+
+  const int width = inputBuffer->getWidth();
+  const int height = inputBuffer->getHeight();
+  this->m_fftResult = (float *)MEM_mallocN(
+      sizeof(float) * width * height * COM_NUM_CHANNELS_COLOR, __func__);
+  FFTConvolution convolution(
+      kernel, kernel_size, kernel_size, COM_NUM_CHANNELS_COLOR, pixelSize, pixelSize);
+  convolution.setNormalizeEdges(true);
+  convolution.execute(
+      inputBuffer->getBuffer(), this->m_fftResult, width, height, COM_NUM_CHANNELS_COLOR);
+
+  MEM_freeN(kernel);
 }
 
 void *BokehBlurOperation::initializeTileData(rcti * /*rect*/)
@@ -47,7 +90,10 @@ void *BokehBlurOperation::initializeTileData(rcti * /*rect*/)
   if (!this->m_sizeavailable) {
     updateSize();
   }
-  void *buffer = getInputOperation(0)->initializeTileData(nullptr);
+  MemoryBuffer *buffer = (MemoryBuffer *)getInputOperation(0)->initializeTileData(nullptr);
+  if (this->m_useFFT && this->m_fftResult == nullptr) {
+    executeFFT(buffer);
+  }
   unlockMutex();
   return buffer;
 }
@@ -68,6 +114,12 @@ void BokehBlurOperation::initExecution()
   this->m_bokehMidY = height / 2.0f;
   this->m_bokehDimension = dimension / 2.0f;
   QualityStepHelper::initExecution(COM_QH_INCREASE);
+
+  if (this->m_sizeavailable) {
+    /* The whole image is read when the size is known, see determineDependingAreaOfInterest. */
+    const int kernel_size = 2 * getPixelSize() + 1;
+    this->m_useFFT = FFTConvolution::isFasterThanDirect(kernel_size, kernel_size);
+  }
 }
 
 void BokehBlurOperation::executePixel(float output[4], int x, int y, void *data)
@@ -77,7 +129,13 @@ void BokehBlurOperation::executePixel(float output[4], int x, int y, void *data)
   float bokeh[4];
 
   this->m_inputBoundingBoxReader->readSampled(tempBoundingBox, x, y, COM_PS_NEAREST);
-  if (tempBoundingBox[0] > 0.0f) {
+  if (tempBoundingBox[0] > 0.0f && this->m_fftResult) {
+    MemoryBuffer *inputBuffer = (MemoryBuffer *)data;
+    const rcti &rect = *inputBuffer->getRect();
+    const size_t index = (size_t)(y - rect.ymin) * inputBuffer->getWidth() + (x - rect.xmin);
+    copy_v4_v4(output, &this->m_fftResult[index * COM_NUM_CHANNELS_COLOR]);
+  }
+  else if (tempBoundingBox[0] > 0.0f) {
     float multiplier_accum[4] = {0.0f, 0.0f, 0.0f, 0.0f};
     MemoryBuffer *inputBuffer = (MemoryBuffer *)data;
     float *buffer = inputBuffer->getBuffer();
@@ -133,6 +191,11 @@ void BokehBlurOperation::executePixel(float output[4], int x, int y, void *data)
 void BokehBlurOperation::deinitExecution()
 {
   deinitMutex();
+  if (this->m_fftResult) {
+    MEM_freeN(this->m_fftResult);
+    this->m_fftResult = nullptr;
+  }
+  this->m_useFFT = false;
   this->m_inputProgram = nullptr;
   this->m_inputBokehProgram = nullptr;
   this->m_inputBoundingBoxReader = nullptr;
@@ -146,7 +209,13 @@ bool BokehBlurOperation::determineDependingAreaOfInterest(rcti *input,
   rcti bokehInput;
   const float max_dim = max(this->getWidth(), this->getHeight());
 
-  if (this->m_sizeavailable) {
+  if (this->m_useFFT) {
+    newInput.xmin = 0;
+    newInput.ymin = 0;
+    newInput.xmax = this->getWidth();
+    newInput.ymax = this->getHeight();
+  }
+  else if (this->m_sizeavailable) {
     newInput.xmax = input->xmax + (this->m_size * max_dim / 100.0f);
     newInput.xmin = input->xmin - (this->m_size * max_dim / 100.0f);
     newInput.ymax = input->ymax + (this->m_size * max_dim / 100.0f);
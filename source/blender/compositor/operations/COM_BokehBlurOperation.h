@@ -34,6 +34,19 @@ class BokehBlurOperation : public NodeOperation, public QualityStepHelper {
   float m_bokehDimension;
   bool m_extend_bounds;
 
+  /**
+   * \brief result of the whole image, for large sizes that are convolved with FFTConvolution
+   */
+  float *m_fftResult;
+  /**
+   * \brief decided in initExecution, only when the size is known in advance
+   * A size read from the input is known after the area of interest was determined.
+   */
+  bool m_useFFT;
+
+  int getPixelSize() const;
+  void executeFFT(MemoryBuffer *inputBuffer);
+
  public:
   BokehBlurOperation();
 
@@ -43,6 +43,9 @@ CompositorOperation::CompositorOperation()
   this->m_imageInput = nullptr;
   this->m_alphaInput = nullptr;
   this->m_depthInput = nullptr;
+  this->m_imageProgram = nullptr;
+  this->m_alphaProgram = nullptr;
+  this->m_depthProgram = nullptr;
 
   this->m_useAlphaInput = false;
   this->m_active = false;
@@ -70,6 +73,36 @@ void CompositorOperation::initExecution()
     this->m_depthBuffer = (float *)MEM_callocN(
         sizeof(float) * this->getWidth() * this->getHeight(), "CompositorOperation");
   }
+
+  if (isFullFrame()) {
+    this->m_imageProgram = FusedRowProgram::createForInput(this, 0);
+    if (this->m_useAlphaInput) {
+      this->m_alphaProgram = FusedRowProgram::createForInput(this, 1);
+    }
+    this->m_depthProgram = FusedRowProgram::createForInput(this, 2);
+
+    /* Only use rows when the image can be computed a row at a time, reading the alpha and depth
+     * one pixel at a time otherwise is no faster than tiled execution. */
+    if (this->m_imageProgram == nullptr) {
+      freeRowPrograms();
+    }
+  }
+}
+
+void CompositorOperation::freeRowPrograms()
+{
+  if (this->m_imageProgram) {
+    delete this->m_imageProgram;
+    this->m_imageProgram = nullptr;
+  }
+  if (this->m_alphaProgram) {
+    delete this->m_alphaProgram;
+    this->m_alphaProgram = nullptr;
+  }
+  if (this->m_depthProgram) {
+    delete this->m_depthProgram;
+    this->m_depthProgram = nullptr;
+  }
 }
 
 void CompositorOperation::deinitExecution()
@@ -125,6 +158,7 @@ void CompositorOperation::deinitExecution()
     }
   }
 
+  freeRowPrograms();
   this->m_outputBuffer = nullptr;
   this->m_depthBuffer = nullptr;
   this->m_imageInput = nullptr;
@@ -141,6 +175,10 @@ void CompositorOperation::executeRegion(rcti *rect, unsigned int /*tileNumber*/)
   if (!buffer) {
     return;
   }
+  if (this->m_imageProgram) {
+    executeRegionRows(rect);
+    return;
+  }
   int x1 = rect->xmin;
   int y1 = rect->ymin;
   int x2 = rect->xmax;
@@ -216,6 +254,63 @@ void CompositorOperation::executeRegion(rcti *rect, unsigned int /*tileNumber*/)
   }
 }
 
+void CompositorOperation::executeRegionRows(rcti *rect)
+{
+  const int x1 = rect->xmin;
+  const int length = rect->xmax - rect->xmin;
+
+  size_t scratch_size = this->m_imageProgram->getScratchSize(length);
+  if (this->m_alphaProgram) {
+    scratch_size = max_zz(scratch_size, this->m_alphaProgram->getScratchSize(length));
+  }
+  if (this->m_depthProgram) {
+    scratch_size = max_zz(scratch_size, this->m_depthProgram->getScratchSize(length));
+  }
+  float *scratch = (float *)MEM_mallocN(sizeof(float) * (scratch_size + length),
+                                        "CompositorOperation row scratch");
+  /* Alpha and depth rows, when they are read one pixel at a time. */
+  float *row = scratch + scratch_size;
+  float color[4];
+
+  for (int y = rect->ymin; y < rect->ymax; y++) {
+    const size_t offset = (size_t)y * this->getWidth() + x1;
+    float *image = this->m_outputBuffer + offset * COM_NUM_CHANNELS_COLOR;
+    this->m_imageProgram->executeRow(image, scratch, x1, y, length);
+
+    if (this->m_useAlphaInput) {
+      if (this->m_alphaProgram) {
+        this->m_alphaProgram->executeRow(row, scratch, x1, y, length);
+      }
+      else {
+        for (int i = 0; i < length; i++) {
+          this->m_alphaInput->readSampled(color, x1 + i, y, COM_PS_NEAREST);
+          row[i] = color[0];
+        }
+      }
+      for (int i = 0; i < length; i++) {
+        image[i * COM_NUM_CHANNELS_COLOR + 3] = row[i];
+      }
+    }
+
+    float *depth = this->m_depthBuffer + offset;
+    if (this->m_depthProgram) {
+      this->m_depthProgram->executeRow(depth, scratch, x1, y, length);
+    }
+    else {
+      for (int i = 0; i < length; i++) {
+        this->m_depthInput->readSampled(color, x1 + i, y, COM_PS_NEAREST);
+        depth[i] = color[0];
+      }
+    }
+
+    if (isBraked()) {
+      break;
+    }
+  }
+
+  MEM_freeN(scratch);
+}
+
 void CompositorOperation::determineResolution(unsigned int resolution[2],
                                               unsigned int preferredResolution[2])
 {
@@ -20,6 +20,7 @@
 
 #include "BLI_rect.h"
 #include "BLI_string.h"
+#include "COM_FusedRowProgram.h"
 #include "COM_NodeOperation.h"
 
 struct Scene;
@@ -65,6 +66,13 @@ class CompositorOperation : public NodeOperation {
    */
   SocketReader *m_depthInput;
 
+  /**
+   * \brief input operations computed a row at a time, only in full frame execution
+   */
+  FusedRowProgram *m_imageProgram;
+  FusedRowProgram *m_alphaProgram;
+  FusedRowProgram *m_depthProgram;
+
   /**
    * \brief Ignore any alpha input
    */
@@ -80,6 +88,9 @@ class CompositorOperation : public NodeOperation {
    */
   const char *m_viewName;
 
+  void freeRowPrograms();
+  void executeRegionRows(rcti *rect);
+
  public:
   CompositorOperation();
   bool isActiveCompositorOutput() const
@@ -54,6 +54,19 @@ void ConvertValueToColorOperation::executePixelSampled(float output[4],
   output[3] = 1.0f;
 }
 
+void ConvertValueToColorOperation::executeRow(float *output,
+                                              const float *const *inputs,
+                                              int /*x*/,
+                                              int /*y*/,
+                                              int length)
+{
+  const float *value = inputs[0];
+  for (int i = 0; i < length; i++, output += 4) {
+    output[0] = output[1] = output[2] = value[i];
+    output[3] = 1.0f;
+  }
+}
+
 /* ******** Color to Value ******** */
 
 ConvertColorToValueOperation::ConvertColorToValueOperation() : ConvertBaseOperation()
@@ -72,6 +85,18 @@ void ConvertColorToValueOperation::executePixelSampled(float output[4],
   output[0] = (inputColor[0] + inputColor[1] + inputColor[2]) / 3.0f;
 }
 
+void ConvertColorToValueOperation::executeRow(float *output,
+                                              const float *const *inputs,
+                                              int /*x*/,
+                                              int /*y*/,
+                                              int length)
+{
+  const float *color = inputs[0];
+  for (int i = 0; i < length; i++, color += 4) {
+    output[i] = (color[0] + color[1] + color[2]) / 3.0f;
+  }
+}
+
 /* ******** Color to BW ******** */
 
 ConvertColorToBWOperation::ConvertColorToBWOperation() : ConvertBaseOperation()
@@ -90,6 +115,18 @@ void ConvertColorToBWOperation::executePixelSampled(float output[4],
   output[0] = IMB_colormanagement_get_luminance(inputColor);
 }
 
+void ConvertColorToBWOperation::executeRow(float *output,
+                                           const float *const *inputs,
+                                           int /*x*/,
+                                           int /*y*/,
+                                           int length)
+{
+  const float *color = inputs[0];
+  for (int i = 0; i < length; i++, color += 4) {
+    output[i] = IMB_colormanagement_get_luminance(color);
+  }
+}
+
 /* ******** Color to Vector ******** */
 
 ConvertColorToVectorOperation::ConvertColorToVectorOperation() : ConvertBaseOperation()
@@ -108,6 +145,18 @@ void ConvertColorToVectorOperation::executePixelSampled(float output[4],
   copy_v3_v3(output, color);
 }
 
+void ConvertColorToVectorOperation::executeRow(float *output,
+                                               const float *const *inputs,
+                                               int /*x*/,
+                                               int /*y*/,
+                                               int length)
+{
+  const float *color = inputs[0];
+  for (int i = 0; i < length; i++, color += 4, output += 3) {
+    copy_v3_v3(output, color);
+  }
+}
+
 /* ******** Value to Vector ******** */
 
 ConvertValueToVectorOperation::ConvertValueToVectorOperation() : ConvertBaseOperation()
@@ -126,6 +175,18 @@ void ConvertValueToVectorOperation::executePixelSampled(float output[4],
   output[0] = output[1] = output[2] = value;
 }
 
+void ConvertValueToVectorOperation::executeRow(float *output,
+                                               const float *const *inputs,
+                                               int /*x*/,
+                                               int /*y*/,
+                                               int length)
+{
+  const float *value = inputs[0];
+  for (int i = 0; i < length; i++, output += 3) {
+    output[0] = output[1] = output[2] = value[i];
+  }
+}
+
 /* ******** Vector to Color ******** */
 
 ConvertVectorToColorOperation::ConvertVectorToColorOperation() : ConvertBaseOperation()
@@ -143,6 +204,19 @@ void ConvertVectorToColorOperation::executePixelSampled(float output[4],
   output[3] = 1.0f;
 }
 
+void ConvertVectorToColorOperation::executeRow(float *output,
+                                               const float *const *inputs,
+                                               int /*x*/,
+                                               int /*y*/,
+                                               int length)
+{
+  const float *vector = inputs[0];
+  for (int i = 0; i < length; i++, vector += 3, output += 4) {
+    copy_v3_v3(output, vector);
+    output[3] = 1.0f;
+  }
+}
+
 /* ******** Vector to Value ******** */
 
 ConvertVectorToValueOperation::ConvertVectorToValueOperation() : ConvertBaseOperation()
@@ -161,6 +235,18 @@ void ConvertVectorToValueOperation::executePixelSampled(float output[4],
   output[0] = (input[0] + input[1] + input[2]) / 3.0f;
 }
 
+void ConvertVectorToValueOperation::executeRow(float *output,
+                                               const float *const *inputs,
+                                               int /*x*/,
+                                               int /*y*/,
+                                               int length)
+{
+  const float *vector = inputs[0];
+  for (int i = 0; i < length; i++, vector += 3) {
+    output[i] = (vector[0] + vector[1] + vector[2]) / 3.0f;
+  }
+}
+
 /* ******** RGB to YCC ******** */
 
 ConvertRGBToYCCOperation::ConvertRGBToYCCOperation() : ConvertBaseOperation()
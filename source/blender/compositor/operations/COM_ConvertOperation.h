@@ -36,6 +36,11 @@ class ConvertValueToColorOperation : public ConvertBaseOperation {
   ConvertValueToColorOperation();
 
   void executePixelSampled(float output[4], float x, float y, PixelSampler sampler);
+  bool isRowOperation() const
+  {
+    return true;
+  }
+  void executeRow(float *output, const float *const *inputs, int x, int y, int length);
 };
 
 class ConvertColorToValueOperation : public ConvertBaseOperation {
@@ -43,6 +48,11 @@ class ConvertColorToValueOperation : public ConvertBaseOperation {
   ConvertColorToValueOperation();
 
   void executePixelSampled(float output[4], float x, float y, PixelSampler sampler);
+  bool isRowOperation() const
+  {
+    return true;
+  }
+  void executeRow(float *output, const float *const *inputs, int x, int y, int length);
 };
 
 class ConvertColorToBWOperation : public ConvertBaseOperation {
@@ -50,6 +60,11 @@ class ConvertColorToBWOperation : public ConvertBaseOperation {
   ConvertColorToBWOperation();
 
   void executePixelSampled(float output[4], float x, float y, PixelSampler sampler);
+  bool isRowOperation() const
+  {
+    return true;
+  }
+  void executeRow(float *output, const float *const *inputs, int x, int y, int length);
 };
 
 class ConvertColorToVectorOperation : public ConvertBaseOperation {
@@ -57,6 +72,11 @@ class ConvertColorToVectorOperation : public ConvertBaseOperation {
   ConvertColorToVectorOperation();
 
   void executePixelSampled(float output[4], float x, float y, PixelSampler sampler);
+  bool isRowOperation() const
+  {
+    return true;
+  }
+  void executeRow(float *output, const float *const *inputs, int x, int y, int length);
 };
 
 class ConvertValueToVectorOperation : public ConvertBaseOperation {
@@ -64,6 +84,11 @@ class ConvertValueToVectorOperation : public ConvertBaseOperation {
   ConvertValueToVectorOperation();
 
   void executePixelSampled(float output[4], float x, float y, PixelSampler sampler);
+  bool isRowOperation() const
+  {
+    return true;
+  }
+  void executeRow(float *output, const float *const *inputs, int x, int y, int length);
 };
 
 class ConvertVectorToColorOperation : public ConvertBaseOperation {
@@ -71,6 +96,11 @@ class ConvertVectorToColorOperation : public ConvertBaseOperation {
   ConvertVectorToColorOperation();
 
   void executePixelSampled(float output[4], float x, float y, PixelSampler sampler);
+  bool isRowOperation() const
+  {
+    return true;
+  }
+  void executeRow(float *output, const float *const *inputs, int x, int y, int length);
 };
 
 class ConvertVectorToValueOperation : public ConvertBaseOperation {
@@ -78,6 +108,11 @@ class ConvertVectorToValueOperation : public ConvertBaseOperation {
   ConvertVectorToValueOperation();
 
   void executePixelSampled(float output[4], float x, float y, PixelSampler sampler);
+  bool isRowOperation() const
+  {
+    return true;
+  }
+  void executeRow(float *output, const float *const *inputs, int x, int y, int length);
 };
 
 class ConvertRGBToYCCOperation : public ConvertBaseOperation {
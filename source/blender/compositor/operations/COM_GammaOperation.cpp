@@ -49,6 +49,25 @@ void GammaOperation::executePixelSampled(float output[4], float x, float y, Pixe
   output[3] = inputValue[3];
 }
 
+void GammaOperation::executeRow(float *output,
+                                const float *const *inputs,
+                                int /*x*/,
+                                int /*y*/,
+                                int length)
+{
+  const float *inputValue = inputs[0];
+  const float *inputGamma = inputs[1];
+  for (int i = 0; i < length; i++, output += 4, inputValue += 4) {
+    const float gamma = inputGamma[i];
+    /* check for negative to avoid nan's */
+    output[0] = inputValue[0] > 0.0f ? powf(inputValue[0], gamma) : inputValue[0];
+    output[1] = inputValue[1] > 0.0f ? powf(inputValue[1], gamma) : inputValue[1];
+    output[2] = inputValue[2] > 0.0f ? powf(inputValue[2], gamma) : inputValue[2];
+
+    output[3] = inputValue[3];
+  }
+}
+
 void GammaOperation::deinitExecution()
 {
   this->m_inputProgram = nullptr;
@@ -35,6 +35,11 @@ class GammaOperation : public NodeOperation {
    * the inner loop of this program
    */
   void executePixelSampled(float output[4], float x, float y, PixelSampler sampler);
+  bool isRowOperation() const
+  {
+    return true;
+  }
+  void executeRow(float *output, const float *const *inputs, int x, int y, int length);
 
   /**
    * Initialize the execution
@@ -18,6 +18,7 @@
 
 #include "COM_GaussianBokehBlurOperation.h"
 #include "BLI_math.h"
+#include "COM_FFTConvolution.h"
 #include "MEM_guardedalloc.h"
 
 #include "RE_pipeline.h"
@@ -25,6 +26,8 @@
 GaussianBokehBlurOperation::GaussianBokehBlurOperation() : BlurBaseOperation(COM_DT_COLOR)
 {
   this->m_gausstab = nullptr;
+  this->m_fftResult = nullptr;
+  this->m_useFFT = false;
 }
 
 void *GaussianBokehBlurOperation::initializeTileData(rcti * /*rect*/)
@@ -33,7 +36,22 @@ void *GaussianBokehBlurOperation::initializeTileData(rcti * /*rect*/)
   if (!this->m_sizeavailable) {
     updateGauss();
   }
-  void *buffer = getInputOperation(0)->initializeTileData(nullptr);
+  MemoryBuffer *buffer = (MemoryBuffer *)getInputOperation(0)->initializeTileData(nullptr);
+  if (this->m_useFFT && this->m_fftResult == nullptr) {
+    const int width = buffer->getWidth();
+    const int height = buffer->getHeight();
+    this->m_fftResult = (float *)MEM_mallocN(
+        sizeof(float) * width * height * COM_NUM_CHANNELS_COLOR, __func__);
+    FFTConvolution convolution(this->m_gausstab,
+                               2 * this->m_radx + 1,
+                               2 * this->m_rady + 1,
+                               1,
+                               this->m_radx,
+                               this->m_rady);
+    convolution.setNormalizeEdges(true);
+    convolution.execute(
+        buffer->getBuffer(), this->m_fftResult, width, height, COM_NUM_CHANNELS_COLOR);
+  }
   unlockMutex();
   return buffer;
 }
@@ -46,6 +64,9 @@ void GaussianBokehBlurOperation::initExecution()
 
   if (this->m_sizeavailable) {
     updateGauss();
+    /* The whole image is read when the size is known, see determineDependingAreaOfInterest. */
+    this->m_useFFT = FFTConvolution::isFasterThanDirect(2 * this->m_radx + 1,
+                                                        2 * this->m_rady + 1);
   }
 }
 
@@ -112,6 +133,14 @@ void GaussianBokehBlurOperation::updateGauss()
 
 void GaussianBokehBlurOperation::executePixel(float output[4], int x, int y, void *data)
 {
+  if (this->m_fftResult) {
+    MemoryBuffer *inputBuffer = (MemoryBuffer *)data;
+    const rcti &rect = *inputBuffer->getRect();
+    const size_t index = (size_t)(y - rect.ymin) * inputBuffer->getWidth() + (x - rect.xmin);
+    copy_v4_v4(output, &this->m_fftResult[index * COM_NUM_CHANNELS_COLOR]);
+    return;
+  }
+
   float tempColor[4];
   tempColor[0] = 0;
   tempColor[1] = 0;
@@ -158,6 +187,11 @@ void GaussianBokehBlurOperation::deinitExecution()
     MEM_freeN(this->m_gausstab);
     this->m_gausstab = nullptr;
   }
+  if (this->m_fftResult) {
+    MEM_freeN(this->m_fftResult);
+    this->m_fftResult = nullptr;
+  }
+  this->m_useFFT = false;
 
   deinitMutex();
 }
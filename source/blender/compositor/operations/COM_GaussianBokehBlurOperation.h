@@ -28,6 +28,12 @@ class GaussianBokehBlurOperation : public BlurBaseOperation {
   int m_radx, m_rady;
   void updateGauss();
 
+  /**
+   * \brief result of the whole image, for large radii that are convolved with FFTConvolution
+   */
+  float *m_fftResult;
+  bool m_useFFT;
+
  public:
   GaussianBokehBlurOperation();
   void initExecution();
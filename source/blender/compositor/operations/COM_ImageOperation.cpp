@@ -17,6 +17,7 @@
  */
 
 #include "COM_ImageOperation.h"
+#include "COM_ResultCache.h"
 
 #include "BKE_image.h"
 #include "BKE_scene.h"
@@ -95,6 +96,27 @@ void BaseImageOperation::initExecution()
   }
 }
 
+bool BaseImageOperation::hashExternalData(ResultCacheKey &key) const
+{
+  if (this->m_image == nullptr) {
+    key.add((uint64_t)0);
+    return true;
+  }
+  if (ELEM(this->m_image->type, IMA_TYPE_R_RESULT, IMA_TYPE_COMPOSITE)) {
+    /* Render results and the viewer are written without changing the image. */
+    return false;
+  }
+  /* The generation counter changes when the image is painted or reloaded,
+   * the user frame selects the image of a sequence or movie. */
+  key.add((uint64_t)this->m_image->id.session_uuid);
+  key.add((uint64_t)this->m_image->generation_counter);
+  key.add((uint64_t)this->m_imageUser->framenr);
+  if (this->m_viewName) {
+    key.add(this->m_viewName);
+  }
+  return true;
+}
+
 void BaseImageOperation::deinitExecution()
 {
   this->m_imageFloatBuffer = nullptr;
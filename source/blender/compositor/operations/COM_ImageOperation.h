@@ -56,6 +56,7 @@ class BaseImageOperation : public NodeOperation {
  public:
   void initExecution();
   void deinitExecution();
+  bool hashExternalData(ResultCacheKey &key) const;
   void setImage(Image *image)
   {
     this->m_image = image;
@@ -84,6 +84,17 @@ void MathAddOperation::executePixelSampled(float output[4], float x, float y, Pi
   clampIfNeeded(output);
 }
 
+void MathAddOperation::executeRow(float *output,
+                                  const float *const *inputs,
+                                  int /*x*/,
+                                  int /*y*/,
+                                  int length)
+{
+  mathRow(output, inputs, length, [](float value1, float value2) {
+    return value1 + value2;
+  });
+}
+
 void MathSubtractOperation::executePixelSampled(float output[4],
                                                 float x,
                                                 float y,
@@ -100,6 +111,17 @@ void MathSubtractOperation::executePixelSampled(float output[4],
   clampIfNeeded(output);
 }
 
+void MathSubtractOperation::executeRow(float *output,
+                                       const float *const *inputs,
+                                       int /*x*/,
+                                       int /*y*/,
+                                       int length)
+{
+  mathRow(output, inputs, length, [](float value1, float value2) {
+    return value1 - value2;
+  });
+}
+
 void MathMultiplyOperation::executePixelSampled(float output[4],
                                                 float x,
                                                 float y,
@@ -116,6 +138,17 @@ void MathMultiplyOperation::executePixelSampled(float output[4],
   clampIfNeeded(output);
 }
 
+void MathMultiplyOperation::executeRow(float *output,
+                                       const float *const *inputs,
+                                       int /*x*/,
+                                       int /*y*/,
+                                       int length)
+{
+  mathRow(output, inputs, length, [](float value1, float value2) {
+    return value1 * value2;
+  });
+}
+
 void MathDivideOperation::executePixelSampled(float output[4],
                                               float x,
                                               float y,
@@ -137,6 +170,18 @@ void MathDivideOperation::executePixelSampled(float output[4],
   clampIfNeeded(output);
 }
 
+void MathDivideOperation::executeRow(float *output,
+                                     const float *const *inputs,
+                                     int /*x*/,
+                                     int /*y*/,
+                                     int length)
+{
+  mathRow(output, inputs, length, [](float value1, float value2) {
+    /* We don't want to divide by zero. */
+    return (value2 == 0) ? 0.0f : value1 / value2;
+  });
+}
+
 void MathSineOperation::executePixelSampled(float output[4],
                                             float x,
                                             float y,
@@ -356,6 +401,17 @@ void MathMinimumOperation::executePixelSampled(float output[4],
   clampIfNeeded(output);
 }
 
+void MathMinimumOperation::executeRow(float *output,
+                                      const float *const *inputs,
+                                      int /*x*/,
+                                      int /*y*/,
+                                      int length)
+{
+  mathRow(output, inputs, length, [](float value1, float value2) {
+    return min(value1, value2);
+  });
+}
+
 void MathMaximumOperation::executePixelSampled(float output[4],
                                                float x,
                                                float y,
@@ -372,6 +428,17 @@ void MathMaximumOperation::executePixelSampled(float output[4],
   clampIfNeeded(output);
 }
 
+void MathMaximumOperation::executeRow(float *output,
+                                      const float *const *inputs,
+                                      int /*x*/,
+                                      int /*y*/,
+                                      int length)
+{
+  mathRow(output, inputs, length, [](float value1, float value2) {
+    return max(value1, value2);
+  });
+}
+
 void MathRoundOperation::executePixelSampled(float output[4],
                                              float x,
                                              float y,
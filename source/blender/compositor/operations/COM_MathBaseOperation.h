@@ -43,6 +43,24 @@ class MathBaseOperation : public NodeOperation {
 
   void clampIfNeeded(float color[4]);
 
+  /**
+   * Compute rows of values for executeRow, with a function of the first two input values.
+   */
+  template<typename MathFunction>
+  inline void mathRow(float *output, const float *const *inputs, int length, MathFunction math)
+  {
+    const float *inputValue1 = inputs[0];
+    const float *inputValue2 = inputs[1];
+    for (int i = 0; i < length; i++) {
+      output[i] = math(inputValue1[i], inputValue2[i]);
+    }
+    if (this->m_useClamp) {
+      for (int i = 0; i < length; i++) {
+        CLAMP(output[i], 0.0f, 1.0f);
+      }
+    }
+  }
+
  public:
   /**
    * the inner loop of this program
@@ -76,6 +94,11 @@ class MathAddOperation : public MathBaseOperation {
   {
   }
   void executePixelSampled(float output[4], float x, float y, PixelSampler sampler);
+  bool isRowOperation() const
+  {
+    return true;
+  }
+  void executeRow(float *output, const float *const *inputs, int x, int y, int length);
 };
 class MathSubtractOperation : public MathBaseOperation {
  public:
@@ -83,6 +106,11 @@ class MathSubtractOperation : public MathBaseOperation {
   {
   }
   void executePixelSampled(float output[4], float x, float y, PixelSampler sampler);
+  bool isRowOperation() const
+  {
+    return true;
+  }
+  void executeRow(float *output, const float *const *inputs, int x, int y, int length);
 };
 class MathMultiplyOperation : public MathBaseOperation {
  public:
@@ -90,6 +118,11 @@ class MathMultiplyOperation : public MathBaseOperation {
   {
   }
   void executePixelSampled(float output[4], float x, float y, PixelSampler sampler);
+  bool isRowOperation() const
+  {
+    return true;
+  }
+  void executeRow(float *output, const float *const *inputs, int x, int y, int length);
 };
 class MathDivideOperation : public MathBaseOperation {
  public:
@@ -97,6 +130,11 @@ class MathDivideOperation : public MathBaseOperation {
   {
   }
   void executePixelSampled(float output[4], float x, float y, PixelSampler sampler);
+  bool isRowOperation() const
+  {
+    return true;
+  }
+  void executeRow(float *output, const float *const *inputs, int x, int y, int length);
 };
 class MathSineOperation : public MathBaseOperation {
  public:
@@ -183,6 +221,11 @@ class MathMinimumOperation : public MathBaseOperation {
   {
   }
   void executePixelSampled(float output[4], float x, float y, PixelSampler sampler);
+  bool isRowOperation() const
+  {
+    return true;
+  }
+  void executeRow(float *output, const float *const *inputs, int x, int y, int length);
 };
 class MathMaximumOperation : public MathBaseOperation {
  public:
@@ -190,6 +233,11 @@ class MathMaximumOperation : public MathBaseOperation {
   {
   }
   void executePixelSampled(float output[4], float x, float y, PixelSampler sampler);
+  bool isRowOperation() const
+  {
+    return true;
+  }
+  void executeRow(float *output, const float *const *inputs, int x, int y, int length);
 };
 class MathRoundOperation : public MathBaseOperation {
  public:
@@ -124,6 +124,17 @@ void MixAddOperation::executePixelSampled(float output[4], float x, float y, Pix
   clampIfNeeded(output);
 }
 
+void MixAddOperation::executeRow(float *output,
+                                 const float *const *inputs,
+                                 int /*x*/,
+                                 int /*y*/,
+                                 int length)
+{
+  mixRow(output, inputs, length, [](float col1, float col2, float value, float /*valuem*/) {
+    return col1 + value * col2;
+  });
+}
+
 /* ******** Mix Blend Operation ******** */
 
 MixBlendOperation::MixBlendOperation()
@@ -158,6 +169,17 @@ void MixBlendOperation::executePixelSampled(float output[4],
   clampIfNeeded(output);
 }
 
+void MixBlendOperation::executeRow(float *output,
+                                   const float *const *inputs,
+                                   int /*x*/,
+                                   int /*y*/,
+                                   int length)
+{
+  mixRow(output, inputs, length, [](float col1, float col2, float value, float valuem) {
+    return valuem * col1 + value * col2;
+  });
+}
+
 /* ******** Mix Burn Operation ******** */
 
 MixColorBurnOperation::MixColorBurnOperation()
@@ -319,6 +341,17 @@ void MixDarkenOperation::executePixelSampled(float output[4],
   clampIfNeeded(output);
 }
 
+void MixDarkenOperation::executeRow(float *output,
+                                    const float *const *inputs,
+                                    int /*x*/,
+                                    int /*y*/,
+                                    int length)
+{
+  mixRow(output, inputs, length, [](float col1, float col2, float value, float valuem) {
+    return min_ff(col1, col2) * value + col1 * valuem;
+  });
+}
+
 /* ******** Mix Difference Operation ******** */
 
 MixDifferenceOperation::MixDifferenceOperation()
@@ -352,6 +385,17 @@ void MixDifferenceOperation::executePixelSampled(float output[4],
   clampIfNeeded(output);
 }
 
+void MixDifferenceOperation::executeRow(float *output,
+                                        const float *const *inputs,
+                                        int /*x*/,
+                                        int /*y*/,
+                                        int length)
+{
+  mixRow(output, inputs, length, [](float col1, float col2, float value, float valuem) {
+    return valuem * col1 + value * fabsf(col1 - col2);
+  });
+}
+
 /* ******** Mix Difference Operation ******** */
 
 MixDivideOperation::MixDivideOperation()
@@ -402,6 +446,17 @@ void MixDivideOperation::executePixelSampled(float output[4],
   clampIfNeeded(output);
 }
 
+void MixDivideOperation::executeRow(float *output,
+                                    const float *const *inputs,
+                                    int /*x*/,
+                                    int /*y*/,
+                                    int length)
+{
+  mixRow(output, inputs, length, [](float col1, float col2, float value, float valuem) {
+    return (col2 != 0.0f) ? valuem * col1 + value * col1 / col2 : 0.0f;
+  });
+}
+
 /* ******** Mix Dodge Operation ******** */
 
 MixDodgeOperation::MixDodgeOperation()
@@ -624,6 +679,17 @@ void MixLightenOperation::executePixelSampled(float output[4],
   clampIfNeeded(output);
 }
 
+void MixLightenOperation::executeRow(float *output,
+                                     const float *const *inputs,
+                                     int /*x*/,
+                                     int /*y*/,
+                                     int length)
+{
+  mixRow(output, inputs, length, [](float col1, float col2, float value, float /*valuem*/) {
+    return max_ff(value * col2, col1);
+  });
+}
+
 /* ******** Mix Linear Light Operation ******** */
 
 MixLinearLightOperation::MixLinearLightOperation()
@@ -705,6 +771,17 @@ void MixMultiplyOperation::executePixelSampled(float output[4],
   clampIfNeeded(output);
 }
 
+void MixMultiplyOperation::executeRow(float *output,
+                                      const float *const *inputs,
+                                      int /*x*/,
+                                      int /*y*/,
+                                      int length)
+{
+  mixRow(output, inputs, length, [](float col1, float col2, float value, float valuem) {
+    return col1 * (valuem + value * col2);
+  });
+}
+
 /* ******** Mix Ovelray Operation ******** */
 
 MixOverlayOperation::MixOverlayOperation()
@@ -831,6 +908,17 @@ void MixScreenOperation::executePixelSampled(float output[4],
   clampIfNeeded(output);
 }
 
+void MixScreenOperation::executeRow(float *output,
+                                    const float *const *inputs,
+                                    int /*x*/,
+                                    int /*y*/,
+                                    int length)
+{
+  mixRow(output, inputs, length, [](float col1, float col2, float value, float valuem) {
+    return 1.0f - (valuem + value * (1.0f - col2)) * (1.0f - col1);
+  });
+}
+
 /* ******** Mix Soft Light Operation ******** */
 
 MixSoftLightOperation::MixSoftLightOperation()
@@ -909,6 +997,17 @@ void MixSubtractOperation::executePixelSampled(float output[4],
   clampIfNeeded(output);
 }
 
+void MixSubtractOperation::executeRow(float *output,
+                                      const float *const *inputs,
+                                      int /*x*/,
+                                      int /*y*/,
+                                      int length)
+{
+  mixRow(output, inputs, length, [](float col1, float col2, float value, float /*valuem*/) {
+    return col1 - value * col2;
+  });
+}
+
 /* ******** Mix Value Operation ******** */
 
 MixValueOperation::MixValueOperation()
@@ -43,6 +43,31 @@ class MixBaseOperation : public NodeOperation {
     }
   }
 
+  /**
+   * Mix rows of pixels for executeRow, with a function that mixes a single channel of both
+   * colors, given the factor and one minus the factor. Alpha is taken from the first color.
+   */
+  template<typename MixFunction>
+  inline void mixRow(float *output, const float *const *inputs, int length, MixFunction mix)
+  {
+    const float *inputValue = inputs[0];
+    const float *inputColor1 = inputs[1];
+    const float *inputColor2 = inputs[2];
+    for (int i = 0; i < length; i++, output += 4, inputColor1 += 4, inputColor2 += 4) {
+      float value = inputValue[i];
+      if (this->m_valueAlphaMultiply) {
+        value *= inputColor2[3];
+      }
+      const float valuem = 1.0f - value;
+      output[0] = mix(inputColor1[0], inputColor2[0], value, valuem);
+      output[1] = mix(inputColor1[1], inputColor2[1], value, valuem);
+      output[2] = mix(inputColor1[2], inputColor2[2], value, valuem);
+      output[3] = inputColor1[3];
+
+      clampIfNeeded(output);
+    }
+  }
+
  public:
   /**
    * Default constructor
@@ -84,12 +109,22 @@ class MixAddOperation : public MixBaseOperation {
  public:
   MixAddOperation();
   void executePixelSampled(float output[4], float x, float y, PixelSampler sampler);
+  bool isRowOperation() const
+  {
+    return true;
+  }
+  void executeRow(float *output, const float *const *inputs, int x, int y, int length);
 };
 
 class MixBlendOperation : public MixBaseOperation {
  public:
   MixBlendOperation();
   void executePixelSampled(float output[4], float x, float y, PixelSampler sampler);
+  bool isRowOperation() const
+  {
+    return true;
+  }
+  void executeRow(float *output, const float *const *inputs, int x, int y, int length);
 };
 
 class MixColorBurnOperation : public MixBaseOperation {
@@ -108,18 +143,33 @@ class MixDarkenOperation : public MixBaseOperation {
  public:
   MixDarkenOperation();
   void executePixelSampled(float output[4], float x, float y, PixelSampler sampler);
+  bool isRowOperation() const
+  {
+    return true;
+  }
+  void executeRow(float *output, const float *const *inputs, int x, int y, int length);
 };
 
 class MixDifferenceOperation : public MixBaseOperation {
  public:
   MixDifferenceOperation();
   void executePixelSampled(float output[4], float x, float y, PixelSampler sampler);
+  bool isRowOperation() const
+  {
+    return true;
+  }
+  void executeRow(float *output, const float *const *inputs, int x, int y, int length);
 };
 
 class MixDivideOperation : public MixBaseOperation {
  public:
   MixDivideOperation();
   void executePixelSampled(float output[4], float x, float y, PixelSampler sampler);
+  bool isRowOperation() const
+  {
+    return true;
+  }
+  void executeRow(float *output, const float *const *inputs, int x, int y, int length);
 };
 
 class MixDodgeOperation : public MixBaseOperation {
@@ -144,6 +194,11 @@ class MixLightenOperation : public MixBaseOperation {
  public:
   MixLightenOperation();
   void executePixelSampled(float output[4], float x, float y, PixelSampler sampler);
+  bool isRowOperation() const
+  {
+    return true;
+  }
+  void executeRow(float *output, const float *const *inputs, int x, int y, int length);
 };
 
 class MixLinearLightOperation : public MixBaseOperation {
@@ -156,6 +211,11 @@ class MixMultiplyOperation : public MixBaseOperation {
  public:
   MixMultiplyOperation();
   void executePixelSampled(float output[4], float x, float y, PixelSampler sampler);
+  bool isRowOperation() const
+  {
+    return true;
+  }
+  void executeRow(float *output, const float *const *inputs, int x, int y, int length);
 };
 
 class MixOverlayOperation : public MixBaseOperation {
@@ -174,6 +234,11 @@ class MixScreenOperation : public MixBaseOperation {
  public:
   MixScreenOperation();
   void executePixelSampled(float output[4], float x, float y, PixelSampler sampler);
+  bool isRowOperation() const
+  {
+    return true;
+  }
+  void executeRow(float *output, const float *const *inputs, int x, int y, int length);
 };
 
 class MixSoftLightOperation : public MixBaseOperation {
@@ -186,6 +251,11 @@ class MixSubtractOperation : public MixBaseOperation {
  public:
   MixSubtractOperation();
   void executePixelSampled(float output[4], float x, float y, PixelSampler sampler);
+  bool isRowOperation() const
+  {
+    return true;
+  }
+  void executeRow(float *output, const float *const *inputs, int x, int y, int length);
 };
 
 class MixValueOperation : public MixBaseOperation {
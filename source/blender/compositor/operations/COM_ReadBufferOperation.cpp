@@ -74,6 +74,24 @@ void ReadBufferOperation::executePixelSampled(float output[4],
   }
 }
 
+void ReadBufferOperation::executeRow(float *output,
+                                     const float *const * /*inputs*/,
+                                     int x,
+                                     int y,
+                                     int length)
+{
+  if (m_single_value) {
+    /* write buffer has a single value stored at (0,0) */
+    const int num_channels = m_buffer->get_num_channels();
+    for (int i = 0; i < length; i++) {
+      m_buffer->read(output + i * num_channels, 0, 0);
+    }
+  }
+  else {
+    m_buffer->readRow(output, x, y, length);
+  }
+}
+
 void ReadBufferOperation::executePixelExtend(float output[4],
                                              float x,
                                              float y,
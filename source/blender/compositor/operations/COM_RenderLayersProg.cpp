@@ -17,6 +17,7 @@
  */
 
 #include "COM_RenderLayersProg.h"
+#include "COM_ResultCache.h"
 
 #include "BKE_scene.h"
 #include "BLI_listbase.h"
@@ -38,6 +39,18 @@ RenderLayersProg::RenderLayersProg(const char *passName, DataType type, int elem
   this->addOutputSocket(type);
 }
 
+bool RenderLayersProg::hashExternalData(ResultCacheKey &key) const
+{
+  /* Render results are not hashed, cached results are freed when a scene is rendered again. */
+  key.add(this->m_passName.c_str());
+  key.add((uint64_t)this->m_layerId);
+  key.add(this->m_viewName ? this->m_viewName : "");
+  key.add((uint64_t)this->m_scene);
+  key.add((uint64_t)(this->m_inputBuffer != nullptr));
+  key.setUsesRenderResult();
+  return true;
+}
+
 void RenderLayersProg::initExecution()
 {
   Scene *scene = this->getScene();
@@ -174,6 +187,35 @@ void RenderLayersProg::executePixelSampled(float output[4], float x, float y, Pi
   }
 }
 
+void RenderLayersProg::executeRow(float *output,
+                                  const float *const * /*inputs*/,
+                                  int x,
+                                  int y,
+                                  int length)
+{
+  const int elemsize = this->m_elementsize;
+  const int width = this->getWidth();
+  /* Pixels outside of the render result are zero, like in doInterpolation. */
+  const int x1 = max_ii(x, 0);
+  const int x2 = (this->m_inputBuffer && y >= 0 && y < (int)this->getHeight()) ?
+                     min_ii(x + length, width) :
+                     x1;
+
+  if (x1 >= x2) {
+    memset(output, 0, sizeof(float) * elemsize * length);
+    return;
+  }
+  if (x1 > x) {
+    memset(output, 0, sizeof(float) * elemsize * (x1 - x));
+  }
+  memcpy(output + (x1 - x) * elemsize,
+         &this->m_inputBuffer[((size_t)y * width + x1) * elemsize],
+         sizeof(float) * elemsize * (x2 - x1));
+  if (x2 < x + length) {
+    memset(output + (x2 - x) * elemsize, 0, sizeof(float) * elemsize * (x + length - x2));
+  }
+}
+
 void RenderLayersProg::deinitExecution()
 {
   this->m_inputBuffer = nullptr;
@@ -243,6 +285,27 @@ void RenderLayersAlphaProg::executePixelSampled(float output[4],
   }
 }
 
+void RenderLayersAlphaProg::executeRow(float *output,
+                                       const float *const * /*inputs*/,
+                                       int x,
+                                       int y,
+                                       int length)
+{
+  const int width = this->getWidth();
+  float *inputBuffer = this->getInputBuffer();
+  const bool inside_y = (inputBuffer != nullptr && y >= 0 && y < (int)this->getHeight());
+
+  for (int i = 0; i < length; i++) {
+    const int ix = x + i;
+    if (inside_y && ix >= 0 && ix < width) {
+      output[i] = inputBuffer[((size_t)y * width + ix) * this->m_elementsize + 3];
+    }
+    else {
+      output[i] = 0.0f;
+    }
+  }
+}
+
 /* ******** Render Layers Depth Operation ******** */
 void RenderLayersDepthProg::executePixelSampled(float output[4],
                                                 float x,
@@ -262,3 +325,24 @@ void RenderLayersDepthProg::executePixelSampled(float output[4],
     output[0] = inputBuffer[offset];
   }
 }
+
+void RenderLayersDepthProg::executeRow(float *output,
+                                       const float *const * /*inputs*/,
+                                       int x,
+                                       int y,
+                                       int length)
+{
+  const int width = this->getWidth();
+  float *inputBuffer = this->getInputBuffer();
+  const bool inside_y = (inputBuffer != nullptr && y >= 0 && y < (int)this->getHeight());
+
+  for (int i = 0; i < length; i++) {
+    const int ix = x + i;
+    if (inside_y && ix >= 0 && ix < width) {
+      output[i] = inputBuffer[(size_t)y * width + ix];
+    }
+    else {
+      output[i] = 10e10f;
+    }
+  }
+}
@@ -121,6 +121,12 @@ class RenderLayersProg : public NodeOperation {
   void initExecution();
   void deinitExecution();
   void executePixelSampled(float output[4], float x, float y, PixelSampler sampler);
+  bool isRowOperation() const
+  {
+    return true;
+  }
+  void executeRow(float *output, const float *const *inputs, int x, int y, int length);
+  bool hashExternalData(ResultCacheKey &key) const;
 };
 
 class RenderLayersAOOperation : public RenderLayersProg {
@@ -130,6 +136,10 @@ class RenderLayersAOOperation : public RenderLayersProg {
   {
   }
   void executePixelSampled(float output[4], float x, float y, PixelSampler sampler);
+  bool isRowOperation() const
+  {
+    return false;
+  }
 };
 
 class RenderLayersAlphaProg : public RenderLayersProg {
@@ -139,6 +149,11 @@ class RenderLayersAlphaProg : public RenderLayersProg {
   {
   }
   void executePixelSampled(float output[4], float x, float y, PixelSampler sampler);
+  bool isRowOperation() const
+  {
+    return true;
+  }
+  void executeRow(float *output, const float *const *inputs, int x, int y, int length);
 };
 
 class RenderLayersDepthProg : public RenderLayersProg {
@@ -148,4 +163,9 @@ class RenderLayersDepthProg : public RenderLayersProg {
   {
   }
   void executePixelSampled(float output[4], float x, float y, PixelSampler sampler);
+  bool isRowOperation() const
+  {
+    return true;
+  }
+  void executeRow(float *output, const float *const *inputs, int x, int y, int length);
 };
@@ -31,6 +31,17 @@ void SetValueOperation::executePixelSampled(float output[4],
   output[0] = this->m_value;
 }
 
+void SetValueOperation::executeRow(float *output,
+                                   const float *const * /*inputs*/,
+                                   int /*x*/,
+                                   int /*y*/,
+                                   int length)
+{
+  for (int i = 0; i < length; i++) {
+    output[i] = this->m_value;
+  }
+}
+
 void SetValueOperation::determineResolution(unsigned int resolution[2],
                                             unsigned int preferredResolution[2])
 {
@@ -34,6 +34,19 @@ void SetVectorOperation::executePixelSampled(float output[4],
   output[2] = this->m_z;
 }
 
+void SetVectorOperation::executeRow(float *output,
+                                    const float *const * /*inputs*/,
+                                    int /*x*/,
+                                    int /*y*/,
+                                    int length)
+{
+  for (int i = 0; i < length; i++) {
+    output[i * 3] = this->m_x;
+    output[i * 3 + 1] = this->m_y;
+    output[i * 3 + 2] = this->m_z;
+  }
+}
+
 void SetVectorOperation::determineResolution(unsigned int resolution[2],
                                              unsigned int preferredResolution[2])
 {
@@ -51,6 +51,9 @@ ViewerOperation::ViewerOperation()
   this->m_imageInput = nullptr;
   this->m_alphaInput = nullptr;
   this->m_depthInput = nullptr;
+  this->m_imageProgram = nullptr;
+  this->m_alphaProgram = nullptr;
+  this->m_depthProgram = nullptr;
   this->m_rd = nullptr;
   this->m_viewName = nullptr;
 }
@@ -65,11 +68,41 @@ void ViewerOperation::initExecution()
 
   if (isActiveViewerOutput()) {
     initImage();
+
+    if (isFullFrame()) {
+      this->m_imageProgram = FusedRowProgram::createForInput(this, 0);
+      if (this->m_useAlphaInput) {
+        this->m_alphaProgram = FusedRowProgram::createForInput(this, 1);
+      }
+      if (this->m_doDepthBuffer) {
+        this->m_depthProgram = FusedRowProgram::createForInput(this, 2);
+      }
+      if (this->m_imageProgram == nullptr) {
+        freeRowPrograms();
+      }
+    }
+  }
+}
+
+void ViewerOperation::freeRowPrograms()
+{
+  if (this->m_imageProgram) {
+    delete this->m_imageProgram;
+    this->m_imageProgram = nullptr;
+  }
+  if (this->m_alphaProgram) {
+    delete this->m_alphaProgram;
+    this->m_alphaProgram = nullptr;
+  }
+  if (this->m_depthProgram) {
+    delete this->m_depthProgram;
+    this->m_depthProgram = nullptr;
   }
 }
 
 void ViewerOperation::deinitExecution()
 {
+  freeRowPrograms();
   this->m_imageInput = nullptr;
   this->m_alphaInput = nullptr;
   this->m_depthInput = nullptr;
@@ -83,6 +116,11 @@ void ViewerOperation::executeRegion(rcti *rect, unsigned int /*tileNumber*/)
   if (!buffer) {
     return;
   }
+  if (this->m_imageProgram) {
+    executeRegionRows(rect);
+    updateImage(rect);
+    return;
+  }
   const int x1 = rect->xmin;
   const int y1 = rect->ymin;
   const int x2 = rect->xmax;
@@ -118,6 +156,65 @@ void ViewerOperation::executeRegion(rcti *rect, unsigned int /*tileNumber*/)
   updateImage(rect);
 }
 
+void ViewerOperation::executeRegionRows(rcti *rect)
+{
+  const int x1 = rect->xmin;
+  const int length = rect->xmax - rect->xmin;
+
+  size_t scratch_size = this->m_imageProgram->getScratchSize(length);
+  if (this->m_alphaProgram) {
+    scratch_size = max_zz(scratch_size, this->m_alphaProgram->getScratchSize(length));
+  }
+  if (this->m_depthProgram) {
+    scratch_size = max_zz(scratch_size, this->m_depthProgram->getScratchSize(length));
+  }
+  float *scratch = (float *)MEM_mallocN(sizeof(float) * (scratch_size + length),
+                                        "ViewerOperation row scratch");
+  /* Alpha rows, and pixels read one at a time. */
+  float *row = scratch + scratch_size;
+  float color[4];
+
+  for (int y = rect->ymin; y < rect->ymax; y++) {
+    const size_t offset = (size_t)y * this->getWidth() + x1;
+    float *image = this->m_outputBuffer + offset * 4;
+    this->m_imageProgram->executeRow(image, scratch, x1, y, length);
+
+    if (this->m_useAlphaInput) {
+      if (this->m_alphaProgram) {
+        this->m_alphaProgram->executeRow(row, scratch, x1, y, length);
+      }
+      else {
+        for (int i = 0; i < length; i++) {
+          this->m_alphaInput->readSampled(color, x1 + i, y, COM_PS_NEAREST);
+          row[i] = color[0];
+        }
+      }
+      for (int i = 0; i < length; i++) {
+        image[i * 4 + 3] = row[i];
+      }
+    }
+
+    if (this->m_depthBuffer) {
+      float *depth = this->m_depthBuffer + offset;
+      if (this->m_depthProgram) {
+        this->m_depthProgram->executeRow(depth, scratch, x1, y, length);
+      }
+      else {
+        for (int i = 0; i < length; i++) {
+          this->m_depthInput->readSampled(color, x1 + i, y, COM_PS_NEAREST);
+          depth[i] = color[0];
+        }
+      }
+    }
+
+    if (isBraked()) {
+      break;
+    }
+  }
+
+  MEM_freeN(scratch);
+}
+
 void ViewerOperation::initImage()
 {
   Image *ima = this->m_image;
@@ -20,6 +20,7 @@
 
 #include "BKE_global.h"
 #include "BLI_rect.h"
+#include "COM_FusedRowProgram.h"
 #include "COM_NodeOperation.h"
 #include "DNA_image_types.h"
 
@@ -46,6 +47,14 @@ class ViewerOperation : public NodeOperation {
   SocketReader *m_alphaInput;
   SocketReader *m_depthInput;
 
+  /* input operations computed a row at a time, only in full frame execution */
+  FusedRowProgram *m_imageProgram;
+  FusedRowProgram *m_alphaProgram;
+  FusedRowProgram *m_depthProgram;
+
+  void freeRowPrograms();
+  void executeRegionRows(rcti *rect);
+
  public:
   ViewerOperation();
   void initExecution();
@@ -30,6 +30,10 @@ class WrapOperation : public ReadBufferOperation {
                                         ReadBufferOperation *readOperation,
                                         rcti *output);
   void executePixelSampled(float output[4], float x, float y, PixelSampler sampler);
+  bool isRowOperation() const
+  {
+    return false;
+  }
 
   void setWrapping(int wrapping_type);
   float getWrappedOriginalXPos(float x);
@@ -19,6 +19,7 @@
 #include "COM_WriteBufferOperation.h"
 #include "COM_OpenCLDevice.h"
 #include "COM_defines.h"
+#include "MEM_guardedalloc.h"
 #include <cstdio>
 
 WriteBufferOperation::WriteBufferOperation(DataType datatype)
@@ -27,6 +28,7 @@ WriteBufferOperation::WriteBufferOperation(DataType datatype)
   this->m_memoryProxy = new MemoryProxy(datatype);
   this->m_memoryProxy->setWriteBufferOperation(this);
   this->m_memoryProxy->setExecutor(nullptr);
+  this->m_rowProgram = nullptr;
 }
 WriteBufferOperation::~WriteBufferOperation()
 {
@@ -47,11 +49,18 @@ void WriteBufferOperation::executePixelSampled(float output[4],
 void WriteBufferOperation::initExecution()
 {
   this->m_input = this->getInputOperation(0);
-  this->m_memoryProxy->allocate(this->m_width, this->m_height);
+
+  if (isFullFrame()) {
+    this->m_rowProgram = FusedRowProgram::createForInput(this, 0);
+  }
 }
 
 void WriteBufferOperation::deinitExecution()
 {
+  if (this->m_rowProgram) {
+    delete this->m_rowProgram;
+    this->m_rowProgram = nullptr;
+  }
   this->m_input = nullptr;
   this->m_memoryProxy->free();
 }
@@ -59,23 +68,34 @@ void WriteBufferOperation::deinitExecution()
 void WriteBufferOperation::executeRegion(rcti *rect, unsigned int /*tileNumber*/)
 {
   MemoryBuffer *memoryBuffer = this->m_memoryProxy->getBuffer();
-  float *buffer = memoryBuffer->getBuffer();
   const int num_channels = memoryBuffer->get_num_channels();
+  const int x1 = rect->xmin;
+  const int length = rect->xmax - rect->xmin;
+  /* Half float buffers are written a row at a time, converting from a float row. */
+  const bool halfFloat = memoryBuffer->isHalfFloat();
+  float *buffer = halfFloat ? nullptr : memoryBuffer->getBuffer();
+  float *halfFloatRow = halfFloat ? (float *)MEM_mallocN(sizeof(float) * num_channels * length,
+                                                         "WriteBuffer half float row") :
+                                    nullptr;
   if (this->m_input->isComplex()) {
     void *data = this->m_input->initializeTileData(rect);
-    int x1 = rect->xmin;
-    int y1 = rect->ymin;
     int x2 = rect->xmax;
+    int y1 = rect->ymin;
     int y2 = rect->ymax;
     int x;
     int y;
     bool breaked = false;
     for (y = y1; y < y2 && (!breaked); y++) {
-      int offset4 = (y * memoryBuffer->getWidth() + x1) * num_channels;
+      float *row = halfFloat ? halfFloatRow :
+                               &buffer[((size_t)y * memoryBuffer->getWidth() + x1) * num_channels];
+      int offset4 = 0;
       for (x = x1; x < x2; x++) {
-        this->m_input->read(&(buffer[offset4]), x, y, data);
+        this->m_input->read(&(row[offset4]), x, y, data);
         offset4 += num_channels;
       }
+      if (halfFloat) {
+        memoryBuffer->writeRow(row, x1, y, length);
+      }
       if (isBraked()) {
         breaked = true;
       }
@@ -85,26 +105,49 @@ void WriteBufferOperation::executeRegion(rcti *rect, unsigned int /*tileNumber*/
       data = nullptr;
     }
   }
+  else if (this->m_rowProgram) {
+    float *scratch = (float *)MEM_mallocN(
+        sizeof(float) * this->m_rowProgram->getScratchSize(length), "WriteBuffer row scratch");
+    for (int y = rect->ymin; y < rect->ymax; y++) {
+      float *row = halfFloat ? halfFloatRow :
+                               &buffer[((size_t)y * memoryBuffer->getWidth() + x1) * num_channels];
+      this->m_rowProgram->executeRow(row, scratch, x1, y, length);
+      if (halfFloat) {
+        memoryBuffer->writeRow(row, x1, y, length);
+      }
+      if (isBraked()) {
+        break;
+      }
+    }
+    MEM_freeN(scratch);
+  }
   else {
-    int x1 = rect->xmin;
-    int y1 = rect->ymin;
     int x2 = rect->xmax;
+    int y1 = rect->ymin;
     int y2 = rect->ymax;
 
     int x;
     int y;
     bool breaked = false;
     for (y = y1; y < y2 && (!breaked); y++) {
-      int offset4 = (y * memoryBuffer->getWidth() + x1) * num_channels;
+      float *row = halfFloat ? halfFloatRow :
+                               &buffer[((size_t)y * memoryBuffer->getWidth() + x1) * num_channels];
+      int offset4 = 0;
       for (x = x1; x < x2; x++) {
-        this->m_input->readSampled(&(buffer[offset4]), x, y, COM_PS_NEAREST);
+        this->m_input->readSampled(&(row[offset4]), x, y, COM_PS_NEAREST);
         offset4 += num_channels;
       }
+      if (halfFloat) {
+        memoryBuffer->writeRow(row, x1, y, length);
+      }
       if (isBraked()) {
         breaked = true;
       }
     }
   }
+  if (halfFloatRow) {
+    MEM_freeN(halfFloatRow);
+  }
   memoryBuffer->setCreatedState();
 }
 
@@ -18,6 +18,7 @@
 
 #pragma once
 
+#include "COM_FusedRowProgram.h"
 #include "COM_MemoryProxy.h"
 #include "COM_NodeOperation.h"
 #include "COM_SocketReader.h"
@@ -29,6 +30,8 @@ class WriteBufferOperation : public NodeOperation {
   MemoryProxy *m_memoryProxy;
   bool m_single_value; /* single value stored in buffer */
   NodeOperation *m_input;
+  /* input operations computed a row at a time, only in full frame execution */
+  FusedRowProgram *m_rowProgram;
 
  public:
   WriteBufferOperation(DataType datatype);
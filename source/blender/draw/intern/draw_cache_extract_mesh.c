@@ -129,7 +129,8 @@ typedef struct MeshRenderData {
   BMFace *efa_act_uv;
   /* Data created on-demand (usually not for #BMesh based data). */
   MLoopTri *mlooptri;
-  float (*loop_normals)[3];
+  /** Owned by the mesh for #Mesh based data, see #BKE_mesh_runtime_loop_normals_ensure. */
+  const float (*loop_normals)[3];
   float (*poly_normals)[3];
   int *lverts, *ledges;
 } MeshRenderData;
@@ -259,23 +260,8 @@ static void mesh_render_data_update_normals(MeshRenderData *mr,
                                  true);
     }
     if (((data_flag & MR_DATA_LOOP_NOR) && is_auto_smooth) || (data_flag & MR_DATA_TAN_LOOP_NOR)) {
-      mr->loop_normals = MEM_mallocN(sizeof(*mr->loop_normals) * mr->loop_len, __func__);
-      short(*clnors)[2] = CustomData_get_layer(&mr->me->ldata, CD_CUSTOMLOOPNORMAL);
-      BKE_mesh_normals_loop_split(mr->me->mvert,
-                                  mr->vert_len,
-                                  mr->me->medge,
-                                  mr->edge_len,
-                                  mr->me->mloop,
-                                  mr->loop_normals,
-                                  mr->loop_len,
-                                  mr->me->mpoly,
-                                  mr->poly_normals,
-                                  mr->poly_len,
-                                  is_auto_smooth,
-                                  split_angle,
-                                  NULL,
-                                  clnors,
-                                  NULL);
+      /* Cached on the mesh, batches rebuilt for the same mesh don't compute them again. */
+      mr->loop_normals = BKE_mesh_runtime_loop_normals_ensure(mr->me);
     }
   }
   else {
@@ -295,7 +281,7 @@ static void mesh_render_data_update_normals(MeshRenderData *mr,
         poly_normals = mr->bm_poly_normals;
       }
 
-      mr->loop_normals = MEM_mallocN(sizeof(*mr->loop_normals) * mr->loop_len, __func__);
+      float(*loop_normals)[3] = MEM_mallocN(sizeof(*loop_normals) * mr->loop_len, __func__);
       const int clnors_offset = CustomData_get_offset(&mr->bm->ldata, CD_CUSTOMLOOPNORMAL);
       BM_loops_calc_normal_vcos(mr->bm,
                                 vert_coords,
@@ -303,11 +289,12 @@ static void mesh_render_data_update_normals(MeshRenderData *mr,
                                 poly_normals,
                                 is_auto_smooth,
                                 split_angle,
-                                mr->loop_normals,
+                                loop_normals,
                                 NULL,
                                 NULL,
                                 clnors_offset,
                                 false);
+      mr->loop_normals = (const float(*)[3])loop_normals;
     }
   }
 }
@@ -444,7 +431,9 @@ static void mesh_render_data_free(MeshRenderData *mr)
 {
   MEM_SAFE_FREE(mr->mlooptri);
   MEM_SAFE_FREE(mr->poly_normals);
-  MEM_SAFE_FREE(mr->loop_normals);
+  if (mr->extract_type == MR_EXTRACT_BMESH && mr->loop_normals) {
+    MEM_freeN((void *)mr->loop_normals);
+  }
 
   MEM_SAFE_FREE(mr->lverts);
   MEM_SAFE_FREE(mr->ledges);
@@ -675,23 +675,34 @@ static size_t draw_seq_text_get_overlay_string(SpaceSeq *sseq,
   bool show_name = sseq->flag & SEQ_SHOW_STRIP_NAME;
   bool show_source = (sseq->flag & (SEQ_SHOW_STRIP_SOURCE)) && source[0] != '\0';
   bool show_duration = sseq->flag & SEQ_SHOW_STRIP_DURATION;
+  bool show_render_time = (sseq->flag & SEQ_SHOW_STRIP_RENDER_TIME) &&
+                          seq->runtime.render_time > 0.0f;
 
   size_t string_len = 0;
   if (show_name) {
     string_len = BLI_snprintf(r_overlay_string, overlay_string_len, "%s", name);
-    if (show_source || show_duration) {
+    if (show_source || show_duration || show_render_time) {
       string_len += BLI_snprintf(r_overlay_string + string_len, overlay_string_len, " | ");
     }
   }
   if (show_source) {
     string_len += BLI_snprintf(r_overlay_string + string_len, overlay_string_len, "%s", source);
-    if (show_duration) {
+    if (show_duration || show_render_time) {
       string_len += BLI_snprintf(r_overlay_string + string_len, overlay_string_len, " | ");
     }
   }
   if (show_duration) {
     string_len += BLI_snprintf(
         r_overlay_string + string_len, overlay_string_len, "%d", strip_duration);
+    if (show_render_time) {
+      string_len += BLI_snprintf(r_overlay_string + string_len, overlay_string_len, " | ");
+    }
+  }
+  if (show_render_time) {
+    string_len += BLI_snprintf(r_overlay_string + string_len,
+                               overlay_string_len,
+                               "%.1f ms",
+                               seq->runtime.render_time * 1000.0f);
   }
   return string_len;
 }
@@ -1087,7 +1098,7 @@ static void draw_seq_strip(const bContext *C,
   float text_margin_y;
   bool y_threshold;
   if ((sseq->flag & SEQ_SHOW_STRIP_NAME) || (sseq->flag & SEQ_SHOW_STRIP_SOURCE) ||
-      (sseq->flag & SEQ_SHOW_STRIP_DURATION)) {
+      (sseq->flag & SEQ_SHOW_STRIP_DURATION) || (sseq->flag & SEQ_SHOW_STRIP_RENDER_TIME)) {
 
     /* Calculate height needed for drawing text on strip. */
     text_margin_y = y2 - min_ff(0.40f, 20 * U.dpi_fac * pixely);
@@ -75,18 +75,13 @@ static void proxy_freejob(void *pjv)
 static void proxy_startjob(void *pjv, short *stop, short *do_update, float *progress)
 {
   ProxyJob *pj = pjv;
-  LinkData *link;
-
-  for (link = pj->queue.first; link; link = link->next) {
-    struct SeqIndexBuildContext *context = link->data;
 
-    SEQ_proxy_rebuild(context, stop, do_update, progress);
+  /* Movie and image strips are built in parallel, other strips one after the other. */
+  SEQ_proxy_rebuild_queue(&pj->queue, stop, do_update, progress);
 
-    if (*stop) {
-      pj->stop = 1;
-      fprintf(stderr, "Canceling proxy rebuild on users request...\n");
-      break;
-    }
+  if (*stop) {
+    pj->stop = 1;
+    fprintf(stderr, "Canceling proxy rebuild on users request...\n");
   }
 }
 
@@ -207,6 +202,10 @@ static int sequencer_rebuild_proxy_exec(bContext *C, wmOperator *UNUSED(op))
   Editing *ed = SEQ_editing_get(scene, false);
   Sequence *seq;
   GSet *file_list;
+  ListBase queue = {NULL, NULL};
+  LinkData *link;
+  short stop = 0, do_update;
+  float progress;
 
   if (ed == NULL) {
     return OPERATOR_CANCELLED;
@@ -216,23 +215,19 @@ static int sequencer_rebuild_proxy_exec(bContext *C, wmOperator *UNUSED(op))
 
   SEQ_CURRENT_BEGIN (ed, seq) {
     if ((seq->flag & SELECT)) {
-      ListBase queue = {NULL, NULL};
-      LinkData *link;
-      short stop = 0, do_update;
-      float progress;
-
       SEQ_proxy_rebuild_context(bmain, depsgraph, scene, seq, file_list, &queue);
-
-      for (link = queue.first; link; link = link->next) {
-        struct SeqIndexBuildContext *context = link->data;
-        SEQ_proxy_rebuild(context, &stop, &do_update, &progress);
-        SEQ_proxy_rebuild_finish(context, 0);
-      }
-      SEQ_relations_free_imbuf(scene, &ed->seqbase, false);
     }
   }
   SEQ_CURRENT_END;
 
+  SEQ_proxy_rebuild_queue(&queue, &stop, &do_update, &progress);
+
+  for (link = queue.first; link; link = link->next) {
+    SEQ_proxy_rebuild_finish(link->data, 0);
+  }
+  BLI_freelistN(&queue);
+  SEQ_relations_free_imbuf(scene, &ed->seqbase, false);
+
   BLI_gset_free(file_list, MEM_freeN);
 
   return OPERATOR_FINISHED;
@@ -0,0 +1,94 @@
+/*
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ */
+
+/** \file
+ * \ingroup imbuf
+ */
+
+#pragma once
+
+#include "BLI_sys_types.h"
+#include "BLI_threads.h"
+#include "BLI_utildefines.h"
+
+/* Single memory budget shared by all image buffer caches.
+ *
+ * Every cache registers itself as a consumer. When the memory used by all consumers exceeds the
+ * memory cache limit, each consumer is asked for the item it would free first and the item which
+ * is least valuable to keep is freed, taking the priority of the cache type, the cost to
+ * recompute the item and how recently it was used into account. */
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+typedef enum eIMBCacheType {
+  IMB_CACHE_TYPE_IMAGE = 0,
+  IMB_CACHE_TYPE_MOVIECLIP = 1,
+  IMB_CACHE_TYPE_SEQUENCER = 2,
+  IMB_CACHE_TYPE_COLORMANAGE = 3,
+} eIMBCacheType;
+
+#define IMB_CACHE_TYPE_TOT 4
+
+typedef struct IMBCacheCandidate {
+  /** Memory freed when evicting the item. */
+  size_t size;
+  /** Time in seconds to recompute the item, zero when unknown. */
+  float cost;
+  /** #PIL_check_seconds_timer() of the last time the item was used. */
+  double last_used;
+} IMBCacheCandidate;
+
+typedef struct IMBCacheStats {
+  size_t memory_in_use;
+  uint64_t hits;
+  uint64_t misses;
+  uint64_t evictions;
+  float priority;
+} IMBCacheStats;
+
+/* Both callbacks are called with the lock of the consumer held. */
+typedef bool (*IMBCacheCandidateFP)(void *userdata, IMBCacheCandidate *r_candidate);
+typedef bool (*IMBCacheEvictFP)(void *userdata);
+
+struct IMBCacheConsumer;
+
+struct IMBCacheConsumer *IMB_cache_consumer_add(eIMBCacheType type,
+                                                ThreadMutex *lock,
+                                                IMBCacheCandidateFP candidatefp,
+                                                IMBCacheEvictFP evictfp,
+                                                void *userdata);
+void IMB_cache_consumer_remove(struct IMBCacheConsumer *consumer);
+
+void IMB_cache_memory_add(eIMBCacheType type, size_t size);
+void IMB_cache_memory_sub(eIMBCacheType type, size_t size);
+void IMB_cache_hit(eIMBCacheType type);
+void IMB_cache_miss(eIMBCacheType type);
+
+size_t IMB_cache_memory_in_use(void);
+size_t IMB_cache_memory_limit(void);
+bool IMB_cache_is_full(size_t extra_size);
+bool IMB_cache_enforce_limits(ThreadMutex *held_lock, size_t extra_size);
+
+const char *IMB_cache_type_name(eIMBCacheType type);
+void IMB_cache_priority_set(eIMBCacheType type, float priority);
+void IMB_cache_stats_get(eIMBCacheType type, IMBCacheStats *r_stats);
+void IMB_cache_stats_reset(void);
+
+#ifdef __cplusplus
+}
+#endif
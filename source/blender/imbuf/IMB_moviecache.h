@@ -26,6 +26,8 @@
 #include "BLI_ghash.h"
 #include "BLI_utildefines.h"
 
+#include "IMB_cache_manager.h"
+
 /* Cache system for movie data - now supports storing ImBufs only
  * Supposed to provide unified cache system for movie clips, sequencer and
  * other movie-related areas */
@@ -50,6 +52,7 @@ struct MovieCache *IMB_moviecache_create(const char *name,
                                          int keysize,
                                          GHashHashFP hashfp,
                                          GHashCmpFP cmpfp);
+void IMB_moviecache_set_type(struct MovieCache *cache, eIMBCacheType type);
 void IMB_moviecache_set_getdata_callback(struct MovieCache *cache,
                                          MovieCacheGetKeyDataFP getdatafp);
 void IMB_moviecache_set_priority_callback(struct MovieCache *cache,
@@ -0,0 +1,285 @@
+/*
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ */
+
+/** \file
+ * \ingroup imbuf
+ */
+
+#include <float.h>
+#include <math.h>
+
+#include "MEM_CacheLimiterC-Api.h"
+#include "MEM_guardedalloc.h"
+
+#include "BLI_listbase.h"
+#include "BLI_math_base.h"
+#include "BLI_threads.h"
+#include "BLI_utildefines.h"
+
+#include "PIL_time.h"
+
+#include "atomic_ops.h"
+
+#include "IMB_cache_manager.h"
+
+/* Seconds after which an unused item is worth half as much. */
+#define CACHE_RECENCY_HALF_LIFE 30.0f
+/* Cost used for items without a measured cost, in seconds per megabyte. */
+#define CACHE_DEFAULT_COST_PER_MEGABYTE 0.004f
+
+typedef struct IMBCacheConsumer {
+  struct IMBCacheConsumer *next, *prev;
+  eIMBCacheType type;
+  ThreadMutex *lock;
+  IMBCacheCandidateFP candidatefp;
+  IMBCacheEvictFP evictfp;
+  void *userdata;
+} IMBCacheConsumer;
+
+typedef struct CacheTypeInfo {
+  const char *name;
+  float priority;
+  /* Updated atomically. */
+  size_t memory_in_use;
+  uint64_t hits;
+  uint64_t misses;
+  uint64_t evictions;
+} CacheTypeInfo;
+
+/* Default priorities favor what is most expensive to get back: painted and packed images,
+ * then tracked footage, then sequencer frames, display buffers are cheapest to redo. */
+static CacheTypeInfo cache_types[IMB_CACHE_TYPE_TOT] = {
+    [IMB_CACHE_TYPE_IMAGE] = {"IMAGE", 4.0f},
+    [IMB_CACHE_TYPE_MOVIECLIP] = {"MOVIECLIP", 2.0f},
+    [IMB_CACHE_TYPE_SEQUENCER] = {"SEQUENCER", 1.0f},
+    [IMB_CACHE_TYPE_COLORMANAGE] = {"COLORMANAGE", 0.5f},
+};
+
+static ListBase cache_consumers = {NULL, NULL};
+static ThreadMutex cache_consumers_lock = BLI_MUTEX_INITIALIZER;
+static size_t cache_memory_in_use = 0;
+
+/* -------------------------------------------------------------------- */
+/** \name Consumers
+ * \{ */
+
+IMBCacheConsumer *IMB_cache_consumer_add(eIMBCacheType type,
+                                         ThreadMutex *lock,
+                                         IMBCacheCandidateFP candidatefp,
+                                         IMBCacheEvictFP evictfp,
+                                         void *userdata)
+{
+  IMBCacheConsumer *consumer = MEM_callocN(sizeof(IMBCacheConsumer), "IMBCacheConsumer");
+  consumer->type = type;
+  consumer->lock = lock;
+  consumer->candidatefp = candidatefp;
+  consumer->evictfp = evictfp;
+  consumer->userdata = userdata;
+
+  BLI_mutex_lock(&cache_consumers_lock);
+  BLI_addtail(&cache_consumers, consumer);
+  BLI_mutex_unlock(&cache_consumers_lock);
+
+  return consumer;
+}
+
+/* Once this returns the consumer callbacks are not called anymore. */
+void IMB_cache_consumer_remove(IMBCacheConsumer *consumer)
+{
+  BLI_mutex_lock(&cache_consumers_lock);
+  BLI_remlink(&cache_consumers, consumer);
+  BLI_mutex_unlock(&cache_consumers_lock);
+
+  MEM_freeN(consumer);
+}
+
+/** \} */
+
+/* -------------------------------------------------------------------- */
+/** \name Statistics
+ * \{ */
+
+void IMB_cache_memory_add(eIMBCacheType type, size_t size)
+{
+  atomic_add_and_fetch_z(&cache_types[type].memory_in_use, size);
+  atomic_add_and_fetch_z(&cache_memory_in_use, size);
+}
+
+void IMB_cache_memory_sub(eIMBCacheType type, size_t size)
+{
+  atomic_sub_and_fetch_z(&cache_types[type].memory_in_use, size);
+  atomic_sub_and_fetch_z(&cache_memory_in_use, size);
+}
+
+void IMB_cache_hit(eIMBCacheType type)
+{
+  atomic_add_and_fetch_uint64(&cache_types[type].hits, 1);
+}
+
+void IMB_cache_miss(eIMBCacheType type)
+{
+  atomic_add_and_fetch_uint64(&cache_types[type].misses, 1);
+}
+
+const char *IMB_cache_type_name(eIMBCacheType type)
+{
+  return cache_types[type].name;
+}
+
+void IMB_cache_priority_set(eIMBCacheType type, float priority)
+{
+  cache_types[type].priority = max_ff(priority, 0.0f);
+}
+
+void IMB_cache_stats_get(eIMBCacheType type, IMBCacheStats *r_stats)
+{
+  const CacheTypeInfo *info = &cache_types[type];
+  r_stats->memory_in_use = info->memory_in_use;
+  r_stats->hits = info->hits;
+  r_stats->misses = info->misses;
+  r_stats->evictions = info->evictions;
+  r_stats->priority = info->priority;
+}
+
+/* Memory in use is not a counter and is kept. */
+void IMB_cache_stats_reset(void)
+{
+  for (int i = 0; i < IMB_CACHE_TYPE_TOT; i++) {
+    cache_types[i].hits = 0;
+    cache_types[i].misses = 0;
+    cache_types[i].evictions = 0;
+  }
+}
+
+/** \} */
+
+/* -------------------------------------------------------------------- */
+/** \name Eviction
+ * \{ */
+
+size_t IMB_cache_memory_in_use(void)
+{
+  return cache_memory_in_use;
+}
+
+size_t IMB_cache_memory_limit(void)
+{
+  if (MEM_CacheLimiter_is_disabled()) {
+    return 0;
+  }
+  return MEM_CacheLimiter_get_maximum();
+}
+
+/* A limit of zero means the caches are not limited. */
+bool IMB_cache_is_full(size_t extra_size)
+{
+  const size_t limit = IMB_cache_memory_limit();
+  return limit != 0 && cache_memory_in_use + extra_size > limit;
+}
+
+/* Value of keeping an item, the least valuable item is evicted first. This is the cost per
+ * megabyte to get the item back, scaled by the priority of the cache type and halved for every
+ * #CACHE_RECENCY_HALF_LIFE seconds the item was not used. */
+static float cache_candidate_value(const IMBCacheConsumer *consumer,
+                                   const IMBCacheCandidate *candidate,
+                                   double time)
+{
+  const float megabytes = max_ff((float)candidate->size / (1024.0f * 1024.0f), 1e-3f);
+  const float cost = (candidate->cost > 0.0f) ? candidate->cost :
+                                                megabytes * CACHE_DEFAULT_COST_PER_MEGABYTE;
+  const float age = max_ff((float)(time - candidate->last_used), 0.0f);
+
+  return cache_types[consumer->type].priority * (cost / megabytes) *
+         exp2f(-age / CACHE_RECENCY_HALF_LIFE);
+}
+
+/* Consumers whose lock is held by another thread are skipped rather than waited for, the other
+ * thread may be waiting for #cache_consumers_lock while holding it. */
+static bool cache_consumer_lock(IMBCacheConsumer *consumer, ThreadMutex *held_lock)
+{
+  return consumer->lock == held_lock || BLI_mutex_trylock(consumer->lock);
+}
+
+static void cache_consumer_unlock(IMBCacheConsumer *consumer, ThreadMutex *held_lock)
+{
+  if (consumer->lock != held_lock) {
+    BLI_mutex_unlock(consumer->lock);
+  }
+}
+
+static IMBCacheConsumer *cache_find_victim(ThreadMutex *held_lock)
+{
+  IMBCacheConsumer *victim = NULL;
+  float victim_value = FLT_MAX;
+  const double time = PIL_check_seconds_timer();
+
+  LISTBASE_FOREACH (IMBCacheConsumer *, consumer, &cache_consumers) {
+    IMBCacheCandidate candidate;
+    bool found;
+
+    if (!cache_consumer_lock(consumer, held_lock)) {
+      continue;
+    }
+    found = consumer->candidatefp(consumer->userdata, &candidate);
+    cache_consumer_unlock(consumer, held_lock);
+
+    if (found) {
+      const float value = cache_candidate_value(consumer, &candidate, time);
+      if (victim == NULL || value < victim_value) {
+        victim = consumer;
+        victim_value = value;
+      }
+    }
+  }
+
+  return victim;
+}
+
+/**
+ * Evict items from all caches until \a extra_size more bytes fit in the memory limit.
+ *
+ * \param held_lock: Lock of the calling consumer, which the caller holds.
+ * \return False when not enough memory could be freed.
+ */
+bool IMB_cache_enforce_limits(ThreadMutex *held_lock, size_t extra_size)
+{
+  bool result = true;
+
+  BLI_mutex_lock(&cache_consumers_lock);
+
+  while (IMB_cache_is_full(extra_size)) {
+    IMBCacheConsumer *victim = cache_find_victim(held_lock);
+    bool evicted = false;
+
+    if (victim && cache_consumer_lock(victim, held_lock)) {
+      evicted = victim->evictfp(victim->userdata);
+      cache_consumer_unlock(victim, held_lock);
+    }
+
+    if (!evicted) {
+      result = false;
+      break;
+    }
+
+    atomic_add_and_fetch_uint64(&cache_types[victim->type].evictions, 1);
+  }
+
+  BLI_mutex_unlock(&cache_consumers_lock);
+
+  return result;
+}
+
+/** \} */
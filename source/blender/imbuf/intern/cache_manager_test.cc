@@ -0,0 +1,231 @@
+/*
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ *
+ * The Original Code is Copyright (C) 2020 by Blender Foundation.
+ */
+#include "testing/testing.h"
+
+#include "MEM_CacheLimiterC-Api.h"
+
+#include "PIL_time.h"
+
+#include "IMB_cache_manager.h"
+
+namespace blender::imbuf::tests {
+
+static const size_t MEGABYTE = 1024 * 1024;
+
+/* Cache holding a single item, which is all the cache manager sees of a consumer. */
+struct TestCache {
+  eIMBCacheType type;
+  ThreadMutex lock;
+  IMBCacheCandidate item;
+  bool has_item;
+  int evictions;
+  IMBCacheConsumer *consumer;
+};
+
+static bool test_cache_candidate(void *userdata, IMBCacheCandidate *r_candidate)
+{
+  TestCache *cache = (TestCache *)userdata;
+  if (!cache->has_item) {
+    return false;
+  }
+  *r_candidate = cache->item;
+  return true;
+}
+
+static bool test_cache_evict(void *userdata)
+{
+  TestCache *cache = (TestCache *)userdata;
+  if (!cache->has_item) {
+    return false;
+  }
+  IMB_cache_memory_sub(cache->type, cache->item.size);
+  cache->has_item = false;
+  cache->evictions++;
+  return true;
+}
+
+class CacheManagerTest : public testing::Test {
+ protected:
+  size_t limit_;
+  bool limit_disabled_;
+  TestCache caches_[2];
+
+  void SetUp() override
+  {
+    limit_ = MEM_CacheLimiter_get_maximum();
+    limit_disabled_ = MEM_CacheLimiter_is_disabled();
+    MEM_CacheLimiter_set_disabled(false);
+    IMB_cache_stats_reset();
+
+    for (TestCache &cache : caches_) {
+      cache.type = IMB_CACHE_TYPE_IMAGE;
+      BLI_mutex_init(&cache.lock);
+      cache.has_item = false;
+      cache.evictions = 0;
+      cache.consumer = IMB_cache_consumer_add(
+          cache.type, &cache.lock, test_cache_candidate, test_cache_evict, &cache);
+    }
+  }
+
+  void TearDown() override
+  {
+    for (TestCache &cache : caches_) {
+      IMB_cache_consumer_remove(cache.consumer);
+      if (cache.has_item) {
+        IMB_cache_memory_sub(cache.type, cache.item.size);
+      }
+      BLI_mutex_end(&cache.lock);
+    }
+    MEM_CacheLimiter_set_maximum(limit_);
+    MEM_CacheLimiter_set_disabled(limit_disabled_);
+  }
+
+  /* Consumers are registered with their type, so change it by registering again. */
+  void set_type(TestCache &cache, eIMBCacheType type)
+  {
+    IMB_cache_consumer_remove(cache.consumer);
+    cache.type = type;
+    cache.consumer = IMB_cache_consumer_add(
+        type, &cache.lock, test_cache_candidate, test_cache_evict, &cache);
+  }
+
+  void add_item(TestCache &cache, size_t size, float cost, double age)
+  {
+    cache.item.size = size;
+    cache.item.cost = cost;
+    cache.item.last_used = PIL_check_seconds_timer() - age;
+    cache.has_item = true;
+    IMB_cache_memory_add(cache.type, size);
+  }
+
+  /* Set the limit so that freeing one item of the given size is enough. */
+  void set_limit_one_over(size_t size)
+  {
+    MEM_CacheLimiter_set_maximum(IMB_cache_memory_in_use() - size / 2);
+  }
+};
+
+TEST_F(CacheManagerTest, memory_accounting)
+{
+  const size_t total = IMB_cache_memory_in_use();
+  IMBCacheStats stats_before;
+  IMB_cache_stats_get(IMB_CACHE_TYPE_MOVIECLIP, &stats_before);
+
+  set_type(caches_[0], IMB_CACHE_TYPE_MOVIECLIP);
+  add_item(caches_[0], 3 * MEGABYTE, 0.0f, 0.0);
+  add_item(caches_[1], 2 * MEGABYTE, 0.0f, 0.0);
+  EXPECT_EQ(IMB_cache_memory_in_use(), total + 5 * MEGABYTE);
+
+  IMBCacheStats stats;
+  IMB_cache_stats_get(IMB_CACHE_TYPE_MOVIECLIP, &stats);
+  EXPECT_EQ(stats.memory_in_use, stats_before.memory_in_use + 3 * MEGABYTE);
+
+  IMB_cache_hit(IMB_CACHE_TYPE_MOVIECLIP);
+  IMB_cache_miss(IMB_CACHE_TYPE_MOVIECLIP);
+  IMB_cache_miss(IMB_CACHE_TYPE_MOVIECLIP);
+  IMB_cache_stats_get(IMB_CACHE_TYPE_MOVIECLIP, &stats);
+  EXPECT_EQ(stats.hits, 1u);
+  EXPECT_EQ(stats.misses, 2u);
+
+  MEM_CacheLimiter_set_maximum(total + 8 * MEGABYTE);
+  EXPECT_FALSE(IMB_cache_is_full(3 * MEGABYTE));
+  EXPECT_TRUE(IMB_cache_is_full(3 * MEGABYTE + 1));
+
+  /* A disabled limit never fills up. */
+  MEM_CacheLimiter_set_disabled(true);
+  EXPECT_EQ(IMB_cache_memory_limit(), 0u);
+  EXPECT_FALSE(IMB_cache_is_full(100 * MEGABYTE));
+}
+
+TEST_F(CacheManagerTest, evict_lowest_priority)
+{
+  set_type(caches_[0], IMB_CACHE_TYPE_COLORMANAGE);
+  add_item(caches_[0], MEGABYTE, 0.0f, 0.0);
+  add_item(caches_[1], MEGABYTE, 0.0f, 0.0);
+  set_limit_one_over(MEGABYTE);
+
+  EXPECT_TRUE(IMB_cache_enforce_limits(nullptr, 0));
+  EXPECT_EQ(caches_[0].evictions, 1);
+  EXPECT_EQ(caches_[1].evictions, 0);
+
+  IMBCacheStats stats;
+  IMB_cache_stats_get(IMB_CACHE_TYPE_COLORMANAGE, &stats);
+  EXPECT_EQ(stats.evictions, 1u);
+}
+
+TEST_F(CacheManagerTest, evict_lowest_cost)
+{
+  /* Equal cost, but the larger item is cheaper per megabyte. */
+  add_item(caches_[0], MEGABYTE, 0.5f, 0.0);
+  add_item(caches_[1], 4 * MEGABYTE, 0.5f, 0.0);
+  set_limit_one_over(MEGABYTE);
+
+  EXPECT_TRUE(IMB_cache_enforce_limits(nullptr, 0));
+  EXPECT_EQ(caches_[0].evictions, 0);
+  EXPECT_EQ(caches_[1].evictions, 1);
+}
+
+TEST_F(CacheManagerTest, evict_oldest)
+{
+  add_item(caches_[0], MEGABYTE, 0.5f, 0.0);
+  add_item(caches_[1], MEGABYTE, 0.5f, 120.0);
+  set_limit_one_over(MEGABYTE);
+
+  EXPECT_TRUE(IMB_cache_enforce_limits(nullptr, 0));
+  EXPECT_EQ(caches_[0].evictions, 0);
+  EXPECT_EQ(caches_[1].evictions, 1);
+}
+
+TEST_F(CacheManagerTest, evict_until_extra_size_fits)
+{
+  add_item(caches_[0], MEGABYTE, 0.0f, 0.0);
+  add_item(caches_[1], MEGABYTE, 0.0f, 0.0);
+  MEM_CacheLimiter_set_maximum(IMB_cache_memory_in_use());
+
+  EXPECT_TRUE(IMB_cache_enforce_limits(nullptr, 2 * MEGABYTE));
+  EXPECT_EQ(caches_[0].evictions + caches_[1].evictions, 2);
+
+  /* Nothing is left to free. */
+  EXPECT_FALSE(IMB_cache_enforce_limits(nullptr, 3 * MEGABYTE));
+}
+
+/* A consumer locked by another thread is skipped instead of waited for. */
+TEST_F(CacheManagerTest, skip_locked_consumer)
+{
+  add_item(caches_[0], MEGABYTE, 0.0f, 120.0);
+  add_item(caches_[1], MEGABYTE, 0.0f, 0.0);
+  set_limit_one_over(MEGABYTE);
+
+  /* Locking here makes the lock busy for the cache manager, like another thread holding it. */
+  BLI_mutex_lock(&caches_[0].lock);
+  EXPECT_TRUE(IMB_cache_enforce_limits(nullptr, 0));
+  EXPECT_EQ(caches_[0].evictions, 0);
+  EXPECT_EQ(caches_[1].evictions, 1);
+
+  /* Only the locked consumer has items left. */
+  set_limit_one_over(MEGABYTE);
+  EXPECT_FALSE(IMB_cache_enforce_limits(nullptr, 0));
+  EXPECT_EQ(caches_[0].evictions, 0);
+
+  /* The lock held by the caller itself is not locked again. */
+  EXPECT_TRUE(IMB_cache_enforce_limits(&caches_[0].lock, 0));
+  EXPECT_EQ(caches_[0].evictions, 1);
+  BLI_mutex_unlock(&caches_[0].lock);
+}
+
+}  // namespace blender::imbuf::tests
@@ -292,6 +292,7 @@ static struct MovieCache *colormanage_moviecache_ensure(ImBuf *ibuf)
                                        sizeof(ColormanageCacheKey),
                                        colormanage_hashhash,
                                        colormanage_hashcmp);
+    IMB_moviecache_set_type(moviecache, IMB_CACHE_TYPE_COLORMANAGE);
 
     ibuf->colormanage_cache->moviecache = moviecache;
   }
@@ -842,6 +842,9 @@ static void index_rebuild_ffmpeg_proc_decoded_frame(FFmpegIndexBuilderContext *c
   unsigned long long s_dts = context->seek_pos_dts;
   unsigned long long pts = av_get_pts_from_frame(context->iFormatCtx, in_frame);
 
+  /* TODO: the proxy sizes are scaled and encoded one after the other on the decoding thread,
+   * they could each get an encoder thread fed through a bounded queue of frame references.
+   * Only several movies are built in parallel for now, see #SEQ_proxy_rebuild_queue. */
   for (i = 0; i < context->num_proxy_sizes; i++) {
     add_to_proxy_output_ffmpeg(context->proxy_ctx[i], in_frame);
   }
@@ -35,6 +35,9 @@
 #include "BLI_threads.h"
 #include "BLI_utildefines.h"
 
+#include "PIL_time.h"
+
+#include "IMB_cache_manager.h"
 #include "IMB_moviecache.h"
 
 #include "IMB_imbuf.h"
@@ -50,7 +53,16 @@
 #  define PRINT(format, ...)
 #endif
 
-static MEM_CacheLimiterC *limitor = NULL;
+/* Cache types used by movie caches, the sequencer has a cache of its own. */
+static const eIMBCacheType moviecache_types[] = {
+    IMB_CACHE_TYPE_IMAGE,
+    IMB_CACHE_TYPE_MOVIECLIP,
+    IMB_CACHE_TYPE_COLORMANAGE,
+};
+
+/* One limiter per cache type, each registered as consumer of the cache manager. */
+static MEM_CacheLimiterC *limitors[IMB_CACHE_TYPE_TOT] = {NULL};
+static struct IMBCacheConsumer *consumers[IMB_CACHE_TYPE_TOT] = {NULL};
 static pthread_mutex_t limitor_lock = BLI_MUTEX_INITIALIZER;
 
 typedef struct MovieCache {
@@ -70,6 +82,7 @@ typedef struct MovieCache {
   struct BLI_mempool *userkeys_pool;
 
   int keysize;
+  eIMBCacheType type;
 
   void *last_userkey;
 
@@ -87,6 +100,9 @@ typedef struct MovieCacheItem {
   ImBuf *ibuf;
   MEM_CacheLimiterHandleC *c_handle;
   void *priority_data;
+  /* Size accounted in the cache manager. */
+  size_t size;
+  double last_used;
 } MovieCacheItem;
 
 static unsigned int moviecache_hashhash(const void *keyv)
@@ -122,6 +138,7 @@ static void moviecache_valfree(void *val)
 
   if (item->ibuf) {
     MEM_CacheLimiter_unmanage(item->c_handle);
+    IMB_cache_memory_sub(cache->type, item->size);
     IMB_freeImBuf(item->ibuf);
   }
 
@@ -173,10 +190,12 @@ static void IMB_moviecache_destructor(void *p)
 
     PRINT("%s: cache '%s' destroy item %p buffer %p\n", __func__, cache->name, item, item->ibuf);
 
+    IMB_cache_memory_sub(cache->type, item->size);
     IMB_freeImBuf(item->ibuf);
 
     item->ibuf = NULL;
     item->c_handle = NULL;
+    item->size = 0;
 
     /* force cached segments to be updated */
     if (cache->points) {
@@ -244,18 +263,48 @@ static bool get_item_destroyable(void *item_v)
   return true;
 }
 
+static bool moviecache_candidate(void *userdata, IMBCacheCandidate *r_candidate)
+{
+  MovieCacheItem *item = MEM_CacheLimiter_get_least_priority_destroyable(userdata);
+
+  if (item == NULL) {
+    return false;
+  }
+
+  r_candidate->size = item->size;
+  r_candidate->cost = 0.0f;
+  r_candidate->last_used = item->last_used;
+  return true;
+}
+
+static bool moviecache_evict(void *userdata)
+{
+  return MEM_CacheLimiter_destroy_least_priority(userdata);
+}
+
 void IMB_moviecache_init(void)
 {
-  limitor = new_MEM_CacheLimiter(IMB_moviecache_destructor, get_item_size);
+  for (int i = 0; i < ARRAY_SIZE(moviecache_types); i++) {
+    const eIMBCacheType type = moviecache_types[i];
+    MEM_CacheLimiterC *limitor = new_MEM_CacheLimiter(IMB_moviecache_destructor, get_item_size);
 
-  MEM_CacheLimiter_ItemPriority_Func_set(limitor, get_item_priority);
-  MEM_CacheLimiter_ItemDestroyable_Func_set(limitor, get_item_destroyable);
+    MEM_CacheLimiter_ItemPriority_Func_set(limitor, get_item_priority);
+    MEM_CacheLimiter_ItemDestroyable_Func_set(limitor, get_item_destroyable);
+
+    limitors[type] = limitor;
+    consumers[type] = IMB_cache_consumer_add(
+        type, &limitor_lock, moviecache_candidate, moviecache_evict, limitor);
+  }
 }
 
 void IMB_moviecache_destruct(void)
 {
-  if (limitor) {
-    delete_MEM_CacheLimiter(limitor);
+  for (int type = 0; type < IMB_CACHE_TYPE_TOT; type++) {
+    if (limitors[type]) {
+      IMB_cache_consumer_remove(consumers[type]);
+      delete_MEM_CacheLimiter(limitors[type]);
+      limitors[type] = NULL;
+    }
   }
 }
 
@@ -282,10 +331,18 @@ MovieCache *IMB_moviecache_create(const char *name,
   cache->hashfp = hashfp;
   cache->cmpfp = cmpfp;
   cache->proxy = -1;
+  cache->type = IMB_CACHE_TYPE_IMAGE;
 
   return cache;
 }
 
+/* Type the memory of this cache is accounted to, must be set before anything is put. */
+void IMB_moviecache_set_type(MovieCache *cache, eIMBCacheType type)
+{
+  BLI_assert(type != IMB_CACHE_TYPE_SEQUENCER);
+  cache->type = type;
+}
+
 void IMB_moviecache_set_getdata_callback(MovieCache *cache, MovieCacheGetKeyDataFP getdatafp)
 {
   cache->getdatafp = getdatafp;
@@ -308,7 +365,7 @@ static void do_moviecache_put(MovieCache *cache, void *userkey, ImBuf *ibuf, boo
   MovieCacheKey *key;
   MovieCacheItem *item;
 
-  if (!limitor) {
+  if (!limitors[IMB_CACHE_TYPE_IMAGE]) {
     IMB_moviecache_init();
   }
 
@@ -327,12 +384,15 @@ static void do_moviecache_put(MovieCache *cache, void *userkey, ImBuf *ibuf, boo
   item->cache_owner = cache;
   item->c_handle = NULL;
   item->priority_data = NULL;
+  item->size = get_item_size(item);
+  item->last_used = PIL_check_seconds_timer();
 
   if (cache->getprioritydatafp) {
     item->priority_data = cache->getprioritydatafp(userkey);
   }
 
   BLI_ghash_reinsert(cache->hash, key, item, moviecache_keyfree, moviecache_valfree);
+  IMB_cache_memory_add(cache->type, item->size);
 
   if (cache->last_userkey) {
     memcpy(cache->last_userkey, userkey, cache->keysize);
@@ -342,10 +402,10 @@ static void do_moviecache_put(MovieCache *cache, void *userkey, ImBuf *ibuf, boo
     BLI_mutex_lock(&limitor_lock);
   }
 
-  item->c_handle = MEM_CacheLimiter_insert(limitor, item);
+  item->c_handle = MEM_CacheLimiter_insert(limitors[cache->type], item);
 
   MEM_CacheLimiter_ref(item->c_handle);
-  MEM_CacheLimiter_enforce_limits(limitor);
+  IMB_cache_enforce_limits(&limitor_lock, 0);
   MEM_CacheLimiter_unref(item->c_handle);
 
   if (need_lock) {
@@ -368,16 +428,14 @@ void IMB_moviecache_put(MovieCache *cache, void *userkey, ImBuf *ibuf)
 
 bool IMB_moviecache_put_if_possible(MovieCache *cache, void *userkey, ImBuf *ibuf)
 {
-  size_t mem_in_use, mem_limit, elem_size;
+  size_t elem_size;
   bool result = false;
 
   elem_size = get_size_in_memory(ibuf);
-  mem_limit = MEM_CacheLimiter_get_maximum();
 
   BLI_mutex_lock(&limitor_lock);
-  mem_in_use = MEM_CacheLimiter_get_memory_in_use(limitor);
 
-  if (mem_in_use + elem_size <= mem_limit) {
+  if (!IMB_cache_is_full(elem_size)) {
     do_moviecache_put(cache, userkey, ibuf, false);
     result = true;
   }
@@ -408,14 +466,17 @@ ImBuf *IMB_moviecache_get(MovieCache *cache, void *userkey)
     if (item->ibuf) {
       BLI_mutex_lock(&limitor_lock);
       MEM_CacheLimiter_touch(item->c_handle);
+      item->last_used = PIL_check_seconds_timer();
       BLI_mutex_unlock(&limitor_lock);
 
       IMB_refImBuf(item->ibuf);
+      IMB_cache_hit(cache->type);
 
       return item->ibuf;
     }
   }
 
+  IMB_cache_miss(cache->type);
   return NULL;
 }
 
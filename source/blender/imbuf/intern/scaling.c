@@ -23,7 +23,13 @@
  */
 
 #include <math.h>
+#include <string.h>
 
+#ifdef __SSE2__
+#  include <emmintrin.h>
+#endif
+
+#include "BLI_math_base.h"
 #include "BLI_math_color.h"
 #include "BLI_math_interp.h"
 #include "BLI_utildefines.h"
@@ -908,648 +914,410 @@ static bool q_scale_linear_interpolation(struct ImBuf *ibuf, int newx, int newy)
   return true;
 }
 
-static ImBuf *scaledownx(struct ImBuf *ibuf, int newx)
+/* -------------------------------------------------------------------- */
+/** \name Separable Resampling
+ *
+ * Images are resampled one axis at a time. The contributing input pixels and their weights are
+ * computed once per output column and row, after which both passes run threaded over scanlines
+ * and accumulate all four channels of a pixel at once.
+ * \{ */
+
+typedef struct ScaleFilterWeights {
+  /* Maximum number of input pixels contributing to an output pixel. */
+  int taps;
+  /* Per output pixel, the first contributing input pixel and the number of contributions. */
+  int *start;
+  int *count;
+  /* Per output pixel, `taps` normalized weights. */
+  float *weights;
+} ScaleFilterWeights;
+
+typedef struct ScaleFilterPassData {
+  const ScaleFilterWeights *weights;
+  const void *in;
+  void *out;
+  bool is_float;
+  int channels;
+  /* Row length of the input and output buffer in pixels. */
+  int in_width;
+  int out_width;
+} ScaleFilterPassData;
+
+static float scale_filter_support(IMB_ScaleFilter filter)
 {
-  const int do_rect = (ibuf->rect != NULL);
-  const int do_float = (ibuf->rect_float != NULL);
-  const size_t rect_size = ibuf->x * ibuf->y * 4;
-
-  uchar *rect, *_newrect, *newrect;
-  float *rectf, *_newrectf, *newrectf;
-  float sample, add, val[4], nval[4], valf[4], nvalf[4];
-  int x, y;
-
-  rectf = _newrectf = newrectf = NULL;
-  rect = _newrect = newrect = NULL;
-  nval[0] = nval[1] = nval[2] = nval[3] = 0.0f;
-  nvalf[0] = nvalf[1] = nvalf[2] = nvalf[3] = 0.0f;
+  switch (filter) {
+    case IMB_SCALE_FILTER_BOX:
+      return 0.5f;
+    case IMB_SCALE_FILTER_BILINEAR:
+      return 1.0f;
+    case IMB_SCALE_FILTER_BICUBIC:
+      return 2.0f;
+    case IMB_SCALE_FILTER_LANCZOS:
+      return 3.0f;
+  }
+  return 1.0f;
+}
 
-  if (!do_rect && !do_float) {
-    return ibuf;
+static float scale_filter_sinc(float x)
+{
+  if (x == 0.0f) {
+    return 1.0f;
   }
+  x *= (float)M_PI;
+  return sinf(x) / x;
+}
 
-  if (do_rect) {
-    _newrect = MEM_mallocN(sizeof(uchar[4]) * newx * ibuf->y, "scaledownx");
-    if (_newrect == NULL) {
-      return ibuf;
-    }
-  }
-  if (do_float) {
-    _newrectf = MEM_mallocN(sizeof(float[4]) * newx * ibuf->y, "scaledownxf");
-    if (_newrectf == NULL) {
-      if (_newrect) {
-        MEM_freeN(_newrect);
+/* Weight of an input pixel at distance \a x from the sample center, in input pixels. */
+static float scale_filter_eval(IMB_ScaleFilter filter, float x)
+{
+  x = fabsf(x);
+  switch (filter) {
+    case IMB_SCALE_FILTER_BOX:
+      return (x <= 0.5f) ? 1.0f : 0.0f;
+    case IMB_SCALE_FILTER_BILINEAR:
+      return (x < 1.0f) ? 1.0f - x : 0.0f;
+    case IMB_SCALE_FILTER_BICUBIC: {
+      /* Catmull-Rom spline. */
+      const float a = -0.5f;
+      if (x < 1.0f) {
+        return ((a + 2.0f) * x - (a + 3.0f)) * x * x + 1.0f;
+      }
+      if (x < 2.0f) {
+        return ((a * x - 5.0f * a) * x + 8.0f * a) * x - 4.0f * a;
       }
-      return ibuf;
+      return 0.0f;
     }
+    case IMB_SCALE_FILTER_LANCZOS:
+      return (x < 3.0f) ? scale_filter_sinc(x) * scale_filter_sinc(x / 3.0f) : 0.0f;
   }
+  return 0.0f;
+}
 
-  add = (ibuf->x - 0.01) / newx;
+static void scale_filter_weights_free(ScaleFilterWeights *fw)
+{
+  MEM_SAFE_FREE(fw->start);
+  MEM_SAFE_FREE(fw->count);
+  MEM_SAFE_FREE(fw->weights);
+}
 
-  if (do_rect) {
-    rect = (uchar *)ibuf->rect;
-    newrect = _newrect;
-  }
-  if (do_float) {
-    rectf = ibuf->rect_float;
-    newrectf = _newrectf;
+static bool scale_filter_weights_init(ScaleFilterWeights *fw,
+                                      IMB_ScaleFilter filter,
+                                      int size_in,
+                                      int size_out)
+{
+  const float scale = (float)size_in / (float)size_out;
+  /* When shrinking the filter is widened so every input pixel contributes. */
+  const float filter_scale = max_ff(scale, 1.0f);
+  const float support = scale_filter_support(filter) * filter_scale;
+
+  fw->taps = (int)ceilf(support) * 2 + 1;
+  fw->start = MEM_mallocN(sizeof(int) * size_out, "scale filter start");
+  fw->count = MEM_mallocN(sizeof(int) * size_out, "scale filter count");
+  fw->weights = MEM_mallocN(sizeof(float) * fw->taps * size_out, "scale filter weights");
+
+  if (fw->start == NULL || fw->count == NULL || fw->weights == NULL) {
+    scale_filter_weights_free(fw);
+    return false;
   }
 
-  for (y = ibuf->y; y > 0; y--) {
-    sample = 0.0f;
-    val[0] = val[1] = val[2] = val[3] = 0.0f;
-    valf[0] = valf[1] = valf[2] = valf[3] = 0.0f;
-
-    for (x = newx; x > 0; x--) {
-      if (do_rect) {
-        nval[0] = -val[0] * sample;
-        nval[1] = -val[1] * sample;
-        nval[2] = -val[2] * sample;
-        nval[3] = -val[3] * sample;
+  for (int i = 0; i < size_out; i++) {
+    const float center = ((float)i + 0.5f) * scale;
+    const int min = max_ii((int)floorf(center - support), 0);
+    const int max = min_ii((int)ceilf(center + support), size_in);
+    float *weights = fw->weights + (size_t)i * fw->taps;
+    int first = -1, last = -1;
+    float total = 0.0f;
+
+    for (int j = min; j < max; j++) {
+      float weight;
+      if (filter == IMB_SCALE_FILTER_BOX) {
+        /* Exact coverage of the input pixel, so shrinking averages the covered area. */
+        weight = min_ff(j + 1.0f, center + support) - max_ff((float)j, center - support);
+        weight = max_ff(weight, 0.0f);
       }
-      if (do_float) {
-        nvalf[0] = -valf[0] * sample;
-        nvalf[1] = -valf[1] * sample;
-        nvalf[2] = -valf[2] * sample;
-        nvalf[3] = -valf[3] * sample;
+      else {
+        weight = scale_filter_eval(filter, ((float)j + 0.5f - center) / filter_scale);
       }
 
-      sample += add;
-
-      while (sample >= 1.0f) {
-        sample -= 1.0f;
-
-        if (do_rect) {
-          nval[0] += rect[0];
-          nval[1] += rect[1];
-          nval[2] += rect[2];
-          nval[3] += rect[3];
-          rect += 4;
-        }
-        if (do_float) {
-          nvalf[0] += rectf[0];
-          nvalf[1] += rectf[1];
-          nvalf[2] += rectf[2];
-          nvalf[3] += rectf[3];
-          rectf += 4;
+      weights[j - min] = weight;
+      total += weight;
+      if (weight != 0.0f) {
+        if (first == -1) {
+          first = j - min;
         }
+        last = j - min;
       }
+    }
 
-      if (do_rect) {
-        val[0] = rect[0];
-        val[1] = rect[1];
-        val[2] = rect[2];
-        val[3] = rect[3];
-        rect += 4;
-
-        newrect[0] = roundf((nval[0] + sample * val[0]) / add);
-        newrect[1] = roundf((nval[1] + sample * val[1]) / add);
-        newrect[2] = roundf((nval[2] + sample * val[2]) / add);
-        newrect[3] = roundf((nval[3] + sample * val[3]) / add);
-
-        newrect += 4;
-      }
-      if (do_float) {
-
-        valf[0] = rectf[0];
-        valf[1] = rectf[1];
-        valf[2] = rectf[2];
-        valf[3] = rectf[3];
-        rectf += 4;
-
-        newrectf[0] = ((nvalf[0] + sample * valf[0]) / add);
-        newrectf[1] = ((nvalf[1] + sample * valf[1]) / add);
-        newrectf[2] = ((nvalf[2] + sample * valf[2]) / add);
-        newrectf[3] = ((nvalf[3] + sample * valf[3]) / add);
-
-        newrectf += 4;
-      }
-
-      sample -= 1.0f;
+    if (first == -1) {
+      /* Can only happen for degenerate sizes, fall back to the nearest pixel. */
+      fw->start[i] = min_ii(max_ii((int)center, 0), size_in - 1);
+      fw->count[i] = 1;
+      weights[0] = 1.0f;
+      continue;
     }
-  }
 
-  if (do_rect) {
-    // printf("%ld %ld\n", (uchar *)rect - ((uchar *)ibuf->rect), rect_size);
-    BLI_assert((uchar *)rect - ((uchar *)ibuf->rect) == rect_size); /* see bug T26502. */
-    imb_freerectImBuf(ibuf);
-    ibuf->mall |= IB_rect;
-    ibuf->rect = (unsigned int *)_newrect;
-  }
-  if (do_float) {
-    // printf("%ld %ld\n", rectf - ibuf->rect_float, rect_size);
-    BLI_assert((rectf - ibuf->rect_float) == rect_size); /* see bug T26502. */
-    imb_freerectfloatImBuf(ibuf);
-    ibuf->mall |= IB_rectfloat;
-    ibuf->rect_float = _newrectf;
+    /* Skip zero weights at both ends of the window. */
+    fw->start[i] = min + first;
+    fw->count[i] = last - first + 1;
+    for (int k = 0; k < fw->count[i]; k++) {
+      weights[k] = weights[first + k] / total;
+    }
   }
-  (void)rect_size; /* UNUSED in release builds */
 
-  ibuf->x = newx;
-  return ibuf;
+  return true;
 }
 
-static ImBuf *scaledowny(struct ImBuf *ibuf, int newy)
+#ifdef __SSE2__
+BLI_INLINE __m128 scale_filter_load_byte(const uchar *pixel)
 {
-  const int do_rect = (ibuf->rect != NULL);
-  const int do_float = (ibuf->rect_float != NULL);
-  const size_t rect_size = ibuf->x * ibuf->y * 4;
-
-  uchar *rect, *_newrect, *newrect;
-  float *rectf, *_newrectf, *newrectf;
-  float sample, add, val[4], nval[4], valf[4], nvalf[4];
-  int x, y, skipx;
+  const __m128i zero = _mm_setzero_si128();
+  int value;
+  memcpy(&value, pixel, sizeof(value));
+  __m128i v = _mm_unpacklo_epi8(_mm_cvtsi32_si128(value), zero);
+  return _mm_cvtepi32_ps(_mm_unpacklo_epi16(v, zero));
+}
 
-  rectf = _newrectf = newrectf = NULL;
-  rect = _newrect = newrect = NULL;
-  nval[0] = nval[1] = nval[2] = nval[3] = 0.0f;
-  nvalf[0] = nvalf[1] = nvalf[2] = nvalf[3] = 0.0f;
+BLI_INLINE void scale_filter_store_byte(__m128 color, uchar *pixel)
+{
+  color = _mm_min_ps(_mm_max_ps(color, _mm_setzero_ps()), _mm_set1_ps(255.0f));
+  __m128i v = _mm_cvttps_epi32(_mm_add_ps(color, _mm_set1_ps(0.5f)));
+  v = _mm_packs_epi32(v, v);
+  v = _mm_packus_epi16(v, v);
+  const int value = _mm_cvtsi128_si32(v);
+  memcpy(pixel, &value, sizeof(value));
+}
+#endif
 
-  if (!do_rect && !do_float) {
-    return ibuf;
-  }
+BLI_INLINE uchar scale_filter_unit_byte(float value)
+{
+  return (uchar)(clamp_f(value, 0.0f, 255.0f) + 0.5f);
+}
 
-  if (do_rect) {
-    _newrect = MEM_mallocN(sizeof(uchar[4]) * newy * ibuf->x, "scaledowny");
-    if (_newrect == NULL) {
-      return ibuf;
+static void scale_filter_row_byte(const uchar *in,
+                                  uchar *out,
+                                  const ScaleFilterWeights *fw,
+                                  int out_width)
+{
+  for (int x = 0; x < out_width; x++, out += 4) {
+    const uchar *src = in + (size_t)fw->start[x] * 4;
+    const float *weights = fw->weights + (size_t)x * fw->taps;
+    const int count = fw->count[x];
+#ifdef __SSE2__
+    __m128 color = _mm_setzero_ps();
+    for (int i = 0; i < count; i++, src += 4) {
+      color = _mm_add_ps(color, _mm_mul_ps(_mm_set1_ps(weights[i]), scale_filter_load_byte(src)));
     }
-  }
-  if (do_float) {
-    _newrectf = MEM_mallocN(sizeof(float[4]) * newy * ibuf->x, "scaledownyf");
-    if (_newrectf == NULL) {
-      if (_newrect) {
-        MEM_freeN(_newrect);
+    scale_filter_store_byte(color, out);
+#else
+    float color[4] = {0.0f, 0.0f, 0.0f, 0.0f};
+    for (int i = 0; i < count; i++, src += 4) {
+      for (int c = 0; c < 4; c++) {
+        color[c] += weights[i] * src[c];
       }
-      return ibuf;
-    }
-  }
-
-  add = (ibuf->y - 0.01) / newy;
-  skipx = 4 * ibuf->x;
-
-  for (x = skipx - 4; x >= 0; x -= 4) {
-    if (do_rect) {
-      rect = ((uchar *)ibuf->rect) + x;
-      newrect = _newrect + x;
     }
-    if (do_float) {
-      rectf = ibuf->rect_float + x;
-      newrectf = _newrectf + x;
+    for (int c = 0; c < 4; c++) {
+      out[c] = scale_filter_unit_byte(color[c]);
     }
+#endif
+  }
+}
 
-    sample = 0.0f;
-    val[0] = val[1] = val[2] = val[3] = 0.0f;
-    valf[0] = valf[1] = valf[2] = valf[3] = 0.0f;
-
-    for (y = newy; y > 0; y--) {
-      if (do_rect) {
-        nval[0] = -val[0] * sample;
-        nval[1] = -val[1] * sample;
-        nval[2] = -val[2] * sample;
-        nval[3] = -val[3] * sample;
-      }
-      if (do_float) {
-        nvalf[0] = -valf[0] * sample;
-        nvalf[1] = -valf[1] * sample;
-        nvalf[2] = -valf[2] * sample;
-        nvalf[3] = -valf[3] * sample;
-      }
-
-      sample += add;
-
-      while (sample >= 1.0f) {
-        sample -= 1.0f;
-
-        if (do_rect) {
-          nval[0] += rect[0];
-          nval[1] += rect[1];
-          nval[2] += rect[2];
-          nval[3] += rect[3];
-          rect += skipx;
-        }
-        if (do_float) {
-          nvalf[0] += rectf[0];
-          nvalf[1] += rectf[1];
-          nvalf[2] += rectf[2];
-          nvalf[3] += rectf[3];
-          rectf += skipx;
-        }
-      }
-
-      if (do_rect) {
-        val[0] = rect[0];
-        val[1] = rect[1];
-        val[2] = rect[2];
-        val[3] = rect[3];
-        rect += skipx;
-
-        newrect[0] = roundf((nval[0] + sample * val[0]) / add);
-        newrect[1] = roundf((nval[1] + sample * val[1]) / add);
-        newrect[2] = roundf((nval[2] + sample * val[2]) / add);
-        newrect[3] = roundf((nval[3] + sample * val[3]) / add);
-
-        newrect += skipx;
+static void scale_filter_row_float(
+    const float *in, float *out, const ScaleFilterWeights *fw, int out_width, int channels)
+{
+  for (int x = 0; x < out_width; x++, out += channels) {
+    const float *src = in + (size_t)fw->start[x] * channels;
+    const float *weights = fw->weights + (size_t)x * fw->taps;
+    const int count = fw->count[x];
+#ifdef __SSE2__
+    if (channels == 4) {
+      __m128 color = _mm_setzero_ps();
+      for (int i = 0; i < count; i++, src += 4) {
+        color = _mm_add_ps(color, _mm_mul_ps(_mm_set1_ps(weights[i]), _mm_loadu_ps(src)));
       }
-      if (do_float) {
-
-        valf[0] = rectf[0];
-        valf[1] = rectf[1];
-        valf[2] = rectf[2];
-        valf[3] = rectf[3];
-        rectf += skipx;
-
-        newrectf[0] = ((nvalf[0] + sample * valf[0]) / add);
-        newrectf[1] = ((nvalf[1] + sample * valf[1]) / add);
-        newrectf[2] = ((nvalf[2] + sample * valf[2]) / add);
-        newrectf[3] = ((nvalf[3] + sample * valf[3]) / add);
-
-        newrectf += skipx;
+      _mm_storeu_ps(out, color);
+      continue;
+    }
+#endif
+    for (int c = 0; c < channels; c++) {
+      float value = 0.0f;
+      for (int i = 0; i < count; i++) {
+        value += weights[i] * src[i * channels + c];
       }
-
-      sample -= 1.0f;
+      out[c] = value;
     }
   }
+}
 
-  if (do_rect) {
-    // printf("%ld %ld\n", (uchar *)rect - ((uchar *)ibuf->rect), rect_size);
-    BLI_assert((uchar *)rect - ((uchar *)ibuf->rect) == rect_size); /* see bug T26502. */
-    imb_freerectImBuf(ibuf);
-    ibuf->mall |= IB_rect;
-    ibuf->rect = (unsigned int *)_newrect;
+/* `accum += weight * row` over \a len values. */
+static void scale_filter_madd_byte(float *accum, const uchar *row, float weight, int len)
+{
+  int i = 0;
+#ifdef __SSE2__
+  const __m128 w = _mm_set1_ps(weight);
+  for (; i + 4 <= len; i += 4) {
+    const __m128 value = _mm_mul_ps(w, scale_filter_load_byte(row + i));
+    _mm_storeu_ps(accum + i, _mm_add_ps(_mm_loadu_ps(accum + i), value));
   }
-  if (do_float) {
-    // printf("%ld %ld\n", rectf - ibuf->rect_float, rect_size);
-    BLI_assert((rectf - ibuf->rect_float) == rect_size); /* see bug T26502. */
-    imb_freerectfloatImBuf(ibuf);
-    ibuf->mall |= IB_rectfloat;
-    ibuf->rect_float = (float *)_newrectf;
+#endif
+  for (; i < len; i++) {
+    accum[i] += weight * row[i];
   }
-  (void)rect_size; /* UNUSED in release builds */
-
-  ibuf->y = newy;
-  return ibuf;
 }
 
-static ImBuf *scaleupx(struct ImBuf *ibuf, int newx)
+static void scale_filter_madd_float(float *accum, const float *row, float weight, int len)
 {
-  uchar *rect, *_newrect = NULL, *newrect;
-  float *rectf, *_newrectf = NULL, *newrectf;
-  float sample, add;
-  float val_a, nval_a, diff_a;
-  float val_b, nval_b, diff_b;
-  float val_g, nval_g, diff_g;
-  float val_r, nval_r, diff_r;
-  float val_af, nval_af, diff_af;
-  float val_bf, nval_bf, diff_bf;
-  float val_gf, nval_gf, diff_gf;
-  float val_rf, nval_rf, diff_rf;
-  int x, y;
-  bool do_rect = false, do_float = false;
-
-  val_a = nval_a = diff_a = val_b = nval_b = diff_b = 0;
-  val_g = nval_g = diff_g = val_r = nval_r = diff_r = 0;
-  val_af = nval_af = diff_af = val_bf = nval_bf = diff_bf = 0;
-  val_gf = nval_gf = diff_gf = val_rf = nval_rf = diff_rf = 0;
-  if (ibuf == NULL) {
-    return NULL;
+  int i = 0;
+#ifdef __SSE2__
+  const __m128 w = _mm_set1_ps(weight);
+  for (; i + 4 <= len; i += 4) {
+    const __m128 value = _mm_mul_ps(w, _mm_loadu_ps(row + i));
+    _mm_storeu_ps(accum + i, _mm_add_ps(_mm_loadu_ps(accum + i), value));
   }
-  if (ibuf->rect == NULL && ibuf->rect_float == NULL) {
-    return ibuf;
+#endif
+  for (; i < len; i++) {
+    accum[i] += weight * row[i];
   }
+}
 
-  if (ibuf->rect) {
-    do_rect = true;
-    _newrect = MEM_mallocN(newx * ibuf->y * sizeof(int), "scaleupx");
-    if (_newrect == NULL) {
-      return ibuf;
-    }
+static void scale_filter_store_row_byte(const float *accum, uchar *out, int len)
+{
+  int i = 0;
+#ifdef __SSE2__
+  for (; i + 4 <= len; i += 4) {
+    scale_filter_store_byte(_mm_loadu_ps(accum + i), out + i);
   }
-  if (ibuf->rect_float) {
-    do_float = true;
-    _newrectf = MEM_mallocN(sizeof(float[4]) * newx * ibuf->y, "scaleupxf");
-    if (_newrectf == NULL) {
-      if (_newrect) {
-        MEM_freeN(_newrect);
-      }
-      return ibuf;
-    }
+#endif
+  for (; i < len; i++) {
+    out[i] = scale_filter_unit_byte(accum[i]);
   }
+}
 
-  add = (ibuf->x - 1.001) / (newx - 1.0);
-
-  rect = (uchar *)ibuf->rect;
-  rectf = (float *)ibuf->rect_float;
-  newrect = _newrect;
-  newrectf = _newrectf;
-
-  for (y = ibuf->y; y > 0; y--) {
-
-    sample = 0;
-
-    if (do_rect) {
-      val_a = rect[0];
-      nval_a = rect[4];
-      diff_a = nval_a - val_a;
-      val_a += 0.5f;
-
-      val_b = rect[1];
-      nval_b = rect[5];
-      diff_b = nval_b - val_b;
-      val_b += 0.5f;
-
-      val_g = rect[2];
-      nval_g = rect[6];
-      diff_g = nval_g - val_g;
-      val_g += 0.5f;
-
-      val_r = rect[3];
-      nval_r = rect[7];
-      diff_r = nval_r - val_r;
-      val_r += 0.5f;
-
-      rect += 8;
+static void scale_filter_horizontal_scanlines(void *custom_data,
+                                              int start_scanline,
+                                              int num_scanlines)
+{
+  const ScaleFilterPassData *data = custom_data;
+  const int channels = data->channels;
+
+  for (int y = start_scanline; y < start_scanline + num_scanlines; y++) {
+    if (data->is_float) {
+      const float *in = (const float *)data->in + (size_t)y * data->in_width * channels;
+      float *out = (float *)data->out + (size_t)y * data->out_width * channels;
+      scale_filter_row_float(in, out, data->weights, data->out_width, channels);
     }
-    if (do_float) {
-      val_af = rectf[0];
-      nval_af = rectf[4];
-      diff_af = nval_af - val_af;
+    else {
+      const uchar *in = (const uchar *)data->in + (size_t)y * data->in_width * 4;
+      uchar *out = (uchar *)data->out + (size_t)y * data->out_width * 4;
+      scale_filter_row_byte(in, out, data->weights, data->out_width);
+    }
+  }
+}
 
-      val_bf = rectf[1];
-      nval_bf = rectf[5];
-      diff_bf = nval_bf - val_bf;
+static void scale_filter_vertical_scanlines(void *custom_data,
+                                            int start_scanline,
+                                            int num_scanlines)
+{
+  const ScaleFilterPassData *data = custom_data;
+  const ScaleFilterWeights *fw = data->weights;
+  /* Both rows have the same width, only the number of rows changes. */
+  const int len = data->out_width * data->channels;
+  float *accum = NULL;
 
-      val_gf = rectf[2];
-      nval_gf = rectf[6];
-      diff_gf = nval_gf - val_gf;
+  if (!data->is_float) {
+    accum = MEM_mallocN(sizeof(float) * len, "scale filter accumulation");
+  }
 
-      val_rf = rectf[3];
-      nval_rf = rectf[7];
-      diff_rf = nval_rf - val_rf;
+  for (int y = start_scanline; y < start_scanline + num_scanlines; y++) {
+    const float *weights = fw->weights + (size_t)y * fw->taps;
 
-      rectf += 8;
-    }
-    for (x = newx; x > 0; x--) {
-      if (sample >= 1.0f) {
-        sample -= 1.0f;
-
-        if (do_rect) {
-          val_a = nval_a;
-          nval_a = rect[0];
-          diff_a = nval_a - val_a;
-          val_a += 0.5f;
-
-          val_b = nval_b;
-          nval_b = rect[1];
-          diff_b = nval_b - val_b;
-          val_b += 0.5f;
-
-          val_g = nval_g;
-          nval_g = rect[2];
-          diff_g = nval_g - val_g;
-          val_g += 0.5f;
-
-          val_r = nval_r;
-          nval_r = rect[3];
-          diff_r = nval_r - val_r;
-          val_r += 0.5f;
-          rect += 4;
-        }
-        if (do_float) {
-          val_af = nval_af;
-          nval_af = rectf[0];
-          diff_af = nval_af - val_af;
-
-          val_bf = nval_bf;
-          nval_bf = rectf[1];
-          diff_bf = nval_bf - val_bf;
-
-          val_gf = nval_gf;
-          nval_gf = rectf[2];
-          diff_gf = nval_gf - val_gf;
-
-          val_rf = nval_rf;
-          nval_rf = rectf[3];
-          diff_rf = nval_rf - val_rf;
-          rectf += 4;
-        }
-      }
-      if (do_rect) {
-        newrect[0] = val_a + sample * diff_a;
-        newrect[1] = val_b + sample * diff_b;
-        newrect[2] = val_g + sample * diff_g;
-        newrect[3] = val_r + sample * diff_r;
-        newrect += 4;
+    if (data->is_float) {
+      const float *in = (const float *)data->in + (size_t)fw->start[y] * len;
+      float *out = (float *)data->out + (size_t)y * len;
+      memset(out, 0, sizeof(float) * len);
+      for (int i = 0; i < fw->count[y]; i++, in += len) {
+        scale_filter_madd_float(out, in, weights[i], len);
       }
-      if (do_float) {
-        newrectf[0] = val_af + sample * diff_af;
-        newrectf[1] = val_bf + sample * diff_bf;
-        newrectf[2] = val_gf + sample * diff_gf;
-        newrectf[3] = val_rf + sample * diff_rf;
-        newrectf += 4;
+    }
+    else {
+      const uchar *in = (const uchar *)data->in + (size_t)fw->start[y] * len;
+      uchar *out = (uchar *)data->out + (size_t)y * len;
+      memset(accum, 0, sizeof(float) * len);
+      for (int i = 0; i < fw->count[y]; i++, in += len) {
+        scale_filter_madd_byte(accum, in, weights[i], len);
       }
-      sample += add;
+      scale_filter_store_row_byte(accum, out, len);
     }
   }
 
-  if (do_rect) {
-    imb_freerectImBuf(ibuf);
-    ibuf->mall |= IB_rect;
-    ibuf->rect = (unsigned int *)_newrect;
-  }
-  if (do_float) {
-    imb_freerectfloatImBuf(ibuf);
-    ibuf->mall |= IB_rectfloat;
-    ibuf->rect_float = (float *)_newrectf;
+  if (accum) {
+    MEM_freeN(accum);
   }
-
-  ibuf->x = newx;
-  return ibuf;
 }
 
-static ImBuf *scaleupy(struct ImBuf *ibuf, int newy)
+/**
+ * Resample a byte or float buffer, \a fw_x and \a fw_y are NULL for an axis that keeps its size.
+ * Returns a new buffer, or NULL when out of memory.
+ */
+static void *scale_filter_buffer(const void *in,
+                                 bool is_float,
+                                 int channels,
+                                 int in_x,
+                                 int in_y,
+                                 int out_x,
+                                 int out_y,
+                                 const ScaleFilterWeights *fw_x,
+                                 const ScaleFilterWeights *fw_y)
 {
-  uchar *rect, *_newrect = NULL, *newrect;
-  float *rectf, *_newrectf = NULL, *newrectf;
-  float sample, add;
-  float val_a, nval_a, diff_a;
-  float val_b, nval_b, diff_b;
-  float val_g, nval_g, diff_g;
-  float val_r, nval_r, diff_r;
-  float val_af, nval_af, diff_af;
-  float val_bf, nval_bf, diff_bf;
-  float val_gf, nval_gf, diff_gf;
-  float val_rf, nval_rf, diff_rf;
-  int x, y, skipx;
-  bool do_rect = false, do_float = false;
-
-  val_a = nval_a = diff_a = val_b = nval_b = diff_b = 0;
-  val_g = nval_g = diff_g = val_r = nval_r = diff_r = 0;
-  val_af = nval_af = diff_af = val_bf = nval_bf = diff_bf = 0;
-  val_gf = nval_gf = diff_gf = val_rf = nval_rf = diff_rf = 0;
-  if (ibuf == NULL) {
-    return NULL;
-  }
-  if (ibuf->rect == NULL && ibuf->rect_float == NULL) {
-    return ibuf;
-  }
-
-  if (ibuf->rect) {
-    do_rect = true;
-    _newrect = MEM_mallocN(ibuf->x * newy * sizeof(int), "scaleupy");
-    if (_newrect == NULL) {
-      return ibuf;
-    }
-  }
-  if (ibuf->rect_float) {
-    do_float = true;
-    _newrectf = MEM_mallocN(sizeof(float[4]) * ibuf->x * newy, "scaleupyf");
-    if (_newrectf == NULL) {
-      if (_newrect) {
-        MEM_freeN(_newrect);
-      }
-      return ibuf;
+  const size_t pixel_size = is_float ? sizeof(float) * channels : sizeof(uchar[4]);
+  /* Resample the axis first that keeps the intermediate buffer smallest. */
+  const bool horizontal_first = fw_x && (!fw_y || (size_t)out_x * in_y <= (size_t)in_x * out_y);
+  const void *buffer = in;
+  void *result = NULL;
+  int x = in_x, y = in_y;
+
+  for (int pass = 0; pass < 2; pass++) {
+    const bool horizontal = (pass == 0) == horizontal_first;
+    const ScaleFilterWeights *fw = horizontal ? fw_x : fw_y;
+    if (fw == NULL) {
+      continue;
     }
-  }
 
-  add = (ibuf->y - 1.001) / (newy - 1.0);
-  skipx = 4 * ibuf->x;
-
-  rect = (uchar *)ibuf->rect;
-  rectf = (float *)ibuf->rect_float;
-  newrect = _newrect;
-  newrectf = _newrectf;
-
-  for (x = ibuf->x; x > 0; x--) {
-
-    sample = 0;
-    if (do_rect) {
-      rect = ((uchar *)ibuf->rect) + 4 * (x - 1);
-      newrect = _newrect + 4 * (x - 1);
-
-      val_a = rect[0];
-      nval_a = rect[skipx];
-      diff_a = nval_a - val_a;
-      val_a += 0.5f;
-
-      val_b = rect[1];
-      nval_b = rect[skipx + 1];
-      diff_b = nval_b - val_b;
-      val_b += 0.5f;
-
-      val_g = rect[2];
-      nval_g = rect[skipx + 2];
-      diff_g = nval_g - val_g;
-      val_g += 0.5f;
-
-      val_r = rect[3];
-      nval_r = rect[skipx + 3];
-      diff_r = nval_r - val_r;
-      val_r += 0.5f;
-
-      rect += 2 * skipx;
+    const int pass_x = horizontal ? out_x : x;
+    const int pass_y = horizontal ? y : out_y;
+    void *out = MEM_mallocN(pixel_size * pass_x * pass_y, "scale filter buffer");
+    if (out == NULL) {
+      MEM_SAFE_FREE(result);
+      return NULL;
     }
-    if (do_float) {
-      rectf = ibuf->rect_float + 4 * (x - 1);
-      newrectf = _newrectf + 4 * (x - 1);
-
-      val_af = rectf[0];
-      nval_af = rectf[skipx];
-      diff_af = nval_af - val_af;
-
-      val_bf = rectf[1];
-      nval_bf = rectf[skipx + 1];
-      diff_bf = nval_bf - val_bf;
-
-      val_gf = rectf[2];
-      nval_gf = rectf[skipx + 2];
-      diff_gf = nval_gf - val_gf;
 
-      val_rf = rectf[3];
-      nval_rf = rectf[skipx + 3];
-      diff_rf = nval_rf - val_rf;
+    ScaleFilterPassData data;
+    data.weights = fw;
+    data.in = buffer;
+    data.out = out;
+    data.is_float = is_float;
+    data.channels = is_float ? channels : 4;
+    data.in_width = x;
+    data.out_width = pass_x;
 
-      rectf += 2 * skipx;
-    }
-
-    for (y = newy; y > 0; y--) {
-      if (sample >= 1.0f) {
-        sample -= 1.0f;
-
-        if (do_rect) {
-          val_a = nval_a;
-          nval_a = rect[0];
-          diff_a = nval_a - val_a;
-          val_a += 0.5f;
-
-          val_b = nval_b;
-          nval_b = rect[1];
-          diff_b = nval_b - val_b;
-          val_b += 0.5f;
-
-          val_g = nval_g;
-          nval_g = rect[2];
-          diff_g = nval_g - val_g;
-          val_g += 0.5f;
-
-          val_r = nval_r;
-          nval_r = rect[3];
-          diff_r = nval_r - val_r;
-          val_r += 0.5f;
-          rect += skipx;
-        }
-        if (do_float) {
-          val_af = nval_af;
-          nval_af = rectf[0];
-          diff_af = nval_af - val_af;
-
-          val_bf = nval_bf;
-          nval_bf = rectf[1];
-          diff_bf = nval_bf - val_bf;
-
-          val_gf = nval_gf;
-          nval_gf = rectf[2];
-          diff_gf = nval_gf - val_gf;
-
-          val_rf = nval_rf;
-          nval_rf = rectf[3];
-          diff_rf = nval_rf - val_rf;
-          rectf += skipx;
-        }
-      }
-      if (do_rect) {
-        newrect[0] = val_a + sample * diff_a;
-        newrect[1] = val_b + sample * diff_b;
-        newrect[2] = val_g + sample * diff_g;
-        newrect[3] = val_r + sample * diff_r;
-        newrect += skipx;
-      }
-      if (do_float) {
-        newrectf[0] = val_af + sample * diff_af;
-        newrectf[1] = val_bf + sample * diff_bf;
-        newrectf[2] = val_gf + sample * diff_gf;
-        newrectf[3] = val_rf + sample * diff_rf;
-        newrectf += skipx;
-      }
-      sample += add;
-    }
-  }
+    IMB_processor_apply_threaded_scanlines(pass_y,
+                                           horizontal ? scale_filter_horizontal_scanlines :
+                                                        scale_filter_vertical_scanlines,
+                                           &data);
 
-  if (do_rect) {
-    imb_freerectImBuf(ibuf);
-    ibuf->mall |= IB_rect;
-    ibuf->rect = (unsigned int *)_newrect;
-  }
-  if (do_float) {
-    imb_freerectfloatImBuf(ibuf);
-    ibuf->mall |= IB_rectfloat;
-    ibuf->rect_float = (float *)_newrectf;
+    MEM_SAFE_FREE(result);
+    result = out;
+    buffer = out;
+    x = pass_x;
+    y = pass_y;
   }
 
-  ibuf->y = newy;
-  return ibuf;
+  return result;
 }
 
+/** \} */
+
 static void scalefast_Z_ImBuf(ImBuf *ibuf, int newx, int newy)
 {
   int *zbuf, *newzbuf, *_newzbuf = NULL;
@@ -1616,10 +1384,19 @@ static void scalefast_Z_ImBuf(ImBuf *ibuf, int newx, int newy)
 }
 
 /**
+ * Resample \a ibuf with \a filter, a zero size keeps that axis.
  * Return true if \a ibuf is modified.
  */
-bool IMB_scaleImBuf(struct ImBuf *ibuf, unsigned int newx, unsigned int newy)
+bool IMB_scaleImBuf_filtered(struct ImBuf *ibuf,
+                             unsigned int newx,
+                             unsigned int newy,
+                             IMB_ScaleFilter filter)
 {
+  ScaleFilterWeights fw_x = {0}, fw_y = {0};
+  unsigned int *newrect = NULL;
+  float *newrectf = NULL;
+  bool ok = true;
+
   if (ibuf == NULL) {
     return false;
   }
@@ -1627,57 +1404,143 @@ bool IMB_scaleImBuf(struct ImBuf *ibuf, unsigned int newx, unsigned int newy)
     return false;
   }
 
+  if (newx == 0) {
+    newx = ibuf->x;
+  }
+  if (newy == 0) {
+    newy = ibuf->y;
+  }
   if (newx == ibuf->x && newy == ibuf->y) {
     return false;
   }
 
-  /* Scale-up / scale-down functions below change ibuf->x and ibuf->y
-   * so we first scale the Z-buffer (if any). */
+  if (newx != ibuf->x) {
+    ok = scale_filter_weights_init(&fw_x, filter, ibuf->x, newx);
+  }
+  if (ok && newy != ibuf->y) {
+    ok = scale_filter_weights_init(&fw_y, filter, ibuf->y, newy);
+  }
+
+  if (ok && ibuf->rect) {
+    newrect = scale_filter_buffer(ibuf->rect,
+                                  false,
+                                  4,
+                                  ibuf->x,
+                                  ibuf->y,
+                                  newx,
+                                  newy,
+                                  fw_x.weights ? &fw_x : NULL,
+                                  fw_y.weights ? &fw_y : NULL);
+    ok = (newrect != NULL);
+  }
+  if (ok && ibuf->rect_float) {
+    newrectf = scale_filter_buffer(ibuf->rect_float,
+                                   true,
+                                   ibuf->channels,
+                                   ibuf->x,
+                                   ibuf->y,
+                                   newx,
+                                   newy,
+                                   fw_x.weights ? &fw_x : NULL,
+                                   fw_y.weights ? &fw_y : NULL);
+    ok = (newrectf != NULL);
+  }
+
+  scale_filter_weights_free(&fw_x);
+  scale_filter_weights_free(&fw_y);
+
+  if (!ok) {
+    MEM_SAFE_FREE(newrect);
+    MEM_SAFE_FREE(newrectf);
+    return false;
+  }
+
+  /* Uses the old size, so scale the Z-buffer (if any) before changing it. */
   scalefast_Z_ImBuf(ibuf, newx, newy);
 
+  if (newrect) {
+    imb_freerectImBuf(ibuf);
+    ibuf->mall |= IB_rect;
+    ibuf->rect = newrect;
+  }
+  if (newrectf) {
+    imb_freerectfloatImBuf(ibuf);
+    ibuf->mall |= IB_rectfloat;
+    ibuf->rect_float = newrectf;
+  }
+
+  ibuf->x = newx;
+  ibuf->y = newy;
+  return true;
+}
+
+/**
+ * Return true if \a ibuf is modified.
+ */
+bool IMB_scaleImBuf(struct ImBuf *ibuf, unsigned int newx, unsigned int newy)
+{
   /* try to scale common cases in a fast way */
   /* disabled, quality loss is unacceptable, see report T18609  (ton) */
   if (0 && q_scale_linear_interpolation(ibuf, newx, newy)) {
     return true;
   }
 
-  if (newx && (newx < ibuf->x)) {
-    scaledownx(ibuf, newx);
-  }
-  if (newy && (newy < ibuf->y)) {
-    scaledowny(ibuf, newy);
-  }
-  if (newx && (newx > ibuf->x)) {
-    scaleupx(ibuf, newx);
-  }
-  if (newy && (newy > ibuf->y)) {
-    scaleupy(ibuf, newy);
-  }
-
-  return true;
+  /* The box filter averages the covered area when shrinking and interpolates linearly
+   * when enlarging. */
+  return IMB_scaleImBuf_filtered(ibuf, newx, newy, IMB_SCALE_FILTER_BOX);
 }
 
 struct imbufRGBA {
   float r, g, b, a;
 };
 
+typedef struct ScaleFastData {
+  ImBuf *ibuf;
+  unsigned int *newrect;
+  struct imbufRGBA *newrectf;
+  int newx;
+  size_t stepx, stepy;
+} ScaleFastData;
+
+static void scalefast_scanlines(void *custom_data, int start_scanline, int num_scanlines)
+{
+  const ScaleFastData *data = custom_data;
+  const ImBuf *ibuf = data->ibuf;
+  size_t ofsx, ofsy = 32768 + data->stepy * start_scanline;
+  int x, y;
+
+  for (y = start_scanline; y < start_scanline + num_scanlines; y++, ofsy += data->stepy) {
+    const size_t row = (ofsy >> 16) * ibuf->x;
+
+    if (data->newrect) {
+      const unsigned int *rect = ibuf->rect + row;
+      unsigned int *newrect = data->newrect + (size_t)y * data->newx;
+      ofsx = 32768;
+
+      for (x = data->newx; x > 0; x--, ofsx += data->stepx) {
+        *newrect++ = rect[ofsx >> 16];
+      }
+    }
+
+    if (data->newrectf) {
+      const struct imbufRGBA *rectf = (const struct imbufRGBA *)ibuf->rect_float + row;
+      struct imbufRGBA *newrectf = data->newrectf + (size_t)y * data->newx;
+      ofsx = 32768;
+
+      for (x = data->newx; x > 0; x--, ofsx += data->stepx) {
+        *newrectf++ = rectf[ofsx >> 16];
+      }
+    }
+  }
+}
+
 /**
  * Return true if \a ibuf is modified.
  */
 bool IMB_scalefastImBuf(struct ImBuf *ibuf, unsigned int newx, unsigned int newy)
 {
-  unsigned int *rect, *_newrect, *newrect;
-  struct imbufRGBA *rectf, *_newrectf, *newrectf;
-  int x, y;
+  ScaleFastData data = {NULL};
   bool do_float = false, do_rect = false;
-  size_t ofsx, ofsy, stepx, stepy;
-
-  rect = NULL;
-  _newrect = NULL;
-  newrect = NULL;
-  rectf = NULL;
-  _newrectf = NULL;
-  newrectf = NULL;
 
   if (ibuf == NULL) {
     return false;
@@ -1697,60 +1560,39 @@ bool IMB_scalefastImBuf(struct ImBuf *ibuf, unsigned int newx, unsigned int newy
   }
 
   if (do_rect) {
-    _newrect = MEM_mallocN(newx * newy * sizeof(int), "scalefastimbuf");
-    if (_newrect == NULL) {
+    data.newrect = MEM_mallocN(newx * newy * sizeof(int), "scalefastimbuf");
+    if (data.newrect == NULL) {
       return false;
     }
-    newrect = _newrect;
   }
 
   if (do_float) {
-    _newrectf = MEM_mallocN(sizeof(float[4]) * newx * newy, "scalefastimbuf f");
-    if (_newrectf == NULL) {
-      if (_newrect) {
-        MEM_freeN(_newrect);
+    data.newrectf = MEM_mallocN(sizeof(float[4]) * newx * newy, "scalefastimbuf f");
+    if (data.newrectf == NULL) {
+      if (data.newrect) {
+        MEM_freeN(data.newrect);
       }
       return false;
     }
-    newrectf = _newrectf;
   }
 
-  stepx = round(65536.0 * (ibuf->x - 1.0) / (newx - 1.0));
-  stepy = round(65536.0 * (ibuf->y - 1.0) / (newy - 1.0));
-  ofsy = 32768;
-
-  for (y = newy; y > 0; y--, ofsy += stepy) {
-    if (do_rect) {
-      rect = ibuf->rect;
-      rect += (ofsy >> 16) * ibuf->x;
-      ofsx = 32768;
-
-      for (x = newx; x > 0; x--, ofsx += stepx) {
-        *newrect++ = rect[ofsx >> 16];
-      }
-    }
+  data.ibuf = ibuf;
+  data.newx = newx;
+  data.stepx = round(65536.0 * (ibuf->x - 1.0) / (newx - 1.0));
+  data.stepy = round(65536.0 * (ibuf->y - 1.0) / (newy - 1.0));
 
-    if (do_float) {
-      rectf = (struct imbufRGBA *)ibuf->rect_float;
-      rectf += (ofsy >> 16) * ibuf->x;
-      ofsx = 32768;
-
-      for (x = newx; x > 0; x--, ofsx += stepx) {
-        *newrectf++ = rectf[ofsx >> 16];
-      }
-    }
-  }
+  IMB_processor_apply_threaded_scanlines(newy, scalefast_scanlines, &data);
 
   if (do_rect) {
     imb_freerectImBuf(ibuf);
     ibuf->mall |= IB_rect;
-    ibuf->rect = _newrect;
+    ibuf->rect = data.newrect;
   }
 
   if (do_float) {
     imb_freerectfloatImBuf(ibuf);
     ibuf->mall |= IB_rectfloat;
-    ibuf->rect_float = (float *)_newrectf;
+    ibuf->rect_float = (float *)data.newrectf;
   }
 
   scalefast_Z_ImBuf(ibuf, newx, newy);
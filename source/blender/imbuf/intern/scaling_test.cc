@@ -0,0 +1,193 @@
+/*
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ *
+ * The Original Code is Copyright (C) 2020 by Blender Foundation.
+ */
+#include "testing/testing.h"
+
+#include "MEM_guardedalloc.h"
+
+#include "IMB_imbuf.h"
+#include "IMB_imbuf_types.h"
+
+namespace blender::imbuf::tests {
+
+static const float EPSILON = 1e-5f;
+
+static ImBuf *create_byte_ibuf(int x, int y, const unsigned char (*pixels)[4])
+{
+  ImBuf *ibuf = IMB_allocImBuf(x, y, 32, IB_rect);
+  memcpy(ibuf->rect, pixels, sizeof(unsigned char[4]) * x * y);
+  return ibuf;
+}
+
+static ImBuf *create_float_ibuf(int x, int y, int channels, const float *pixels)
+{
+  ImBuf *ibuf = IMB_allocImBuf(x, y, 32, 0);
+  ibuf->channels = channels;
+  ibuf->rect_float = (float *)MEM_mallocN(sizeof(float) * x * y * channels, __func__);
+  ibuf->mall |= IB_rectfloat;
+  ibuf->flags |= IB_rectfloat;
+  memcpy(ibuf->rect_float, pixels, sizeof(float) * x * y * channels);
+  return ibuf;
+}
+
+static void expect_byte_pixel(const ImBuf *ibuf, int x, int y, const unsigned char expected[4])
+{
+  const unsigned char *pixel = (const unsigned char *)(ibuf->rect + (size_t)y * ibuf->x + x);
+  for (int c = 0; c < 4; c++) {
+    EXPECT_EQ(pixel[c], expected[c]) << "pixel " << x << ", " << y << " channel " << c;
+  }
+}
+
+/* Shrinking by whole factors averages the pixels of each block. */
+TEST(imbuf_scaling, box_downscale_byte)
+{
+  const unsigned char pixels[8][4] = {
+      {10, 20, 30, 255},
+      {30, 40, 50, 255},
+      {100, 0, 0, 255},
+      {200, 0, 0, 255},
+      {20, 20, 30, 255},
+      {40, 40, 50, 255},
+      {0, 100, 0, 255},
+      {100, 0, 0, 255},
+  };
+  ImBuf *ibuf = create_byte_ibuf(4, 2, pixels);
+
+  EXPECT_TRUE(IMB_scaleImBuf(ibuf, 2, 1));
+  EXPECT_EQ(ibuf->x, 2);
+  EXPECT_EQ(ibuf->y, 1);
+
+  const unsigned char expected[2][4] = {{25, 30, 40, 255}, {100, 25, 0, 255}};
+  expect_byte_pixel(ibuf, 0, 0, expected[0]);
+  expect_byte_pixel(ibuf, 1, 0, expected[1]);
+
+  IMB_freeImBuf(ibuf);
+}
+
+/* Enlarging interpolates linearly between pixel centers, edges repeat the outer pixels. */
+TEST(imbuf_scaling, box_enlarge_byte)
+{
+  const unsigned char pixels[2][4] = {{0, 100, 200, 255}, {100, 200, 0, 255}};
+  ImBuf *ibuf = create_byte_ibuf(2, 1, pixels);
+
+  EXPECT_TRUE(IMB_scaleImBuf(ibuf, 4, 1));
+
+  const unsigned char expected[4][4] = {
+      {0, 100, 200, 255},
+      {25, 125, 150, 255},
+      {75, 175, 50, 255},
+      {100, 200, 0, 255},
+  };
+  for (int x = 0; x < 4; x++) {
+    expect_byte_pixel(ibuf, x, 0, expected[x]);
+  }
+
+  IMB_freeImBuf(ibuf);
+}
+
+/* Odd sizes cover input pixels partially, they contribute with the covered fraction. */
+TEST(imbuf_scaling, box_downscale_float_odd)
+{
+  /* Every channel is x + 10 * y + 100 * channel. */
+  float pixels[5 * 3 * 4];
+  for (int y = 0; y < 3; y++) {
+    for (int x = 0; x < 5; x++) {
+      for (int c = 0; c < 4; c++) {
+        pixels[(y * 5 + x) * 4 + c] = x + 10.0f * y + 100.0f * c;
+      }
+    }
+  }
+  ImBuf *ibuf = create_float_ibuf(5, 3, 4, pixels);
+
+  EXPECT_TRUE(IMB_scaleImBuf(ibuf, 2, 1));
+  EXPECT_EQ(ibuf->x, 2);
+  EXPECT_EQ(ibuf->y, 1);
+
+  /* Output pixels cover 2.5 input pixels: x = (0 + 1 + 0.5 * 2) / 2.5 and
+   * (0.5 * 2 + 3 + 4) / 2.5. All rows are covered, y averages to 1. */
+  for (int c = 0; c < 4; c++) {
+    EXPECT_NEAR(ibuf->rect_float[c], 0.8f + 10.0f + 100.0f * c, EPSILON * 100.0f);
+    EXPECT_NEAR(ibuf->rect_float[4 + c], 3.2f + 10.0f + 100.0f * c, EPSILON * 100.0f);
+  }
+
+  IMB_freeImBuf(ibuf);
+}
+
+/* Float buffers with three channels are averaged per channel. */
+TEST(imbuf_scaling, box_downscale_float_three_channels)
+{
+  /* Every channel is x + 4 * y + 16 * channel. */
+  float pixels[4 * 4 * 3];
+  for (int y = 0; y < 4; y++) {
+    for (int x = 0; x < 4; x++) {
+      for (int c = 0; c < 3; c++) {
+        pixels[(y * 4 + x) * 3 + c] = x + 4.0f * y + 16.0f * c;
+      }
+    }
+  }
+  ImBuf *ibuf = create_float_ibuf(4, 4, 3, pixels);
+
+  EXPECT_TRUE(IMB_scaleImBuf(ibuf, 2, 2));
+  EXPECT_EQ(ibuf->channels, 3);
+
+  const float expected[4] = {2.5f, 4.5f, 10.5f, 12.5f};
+  for (int i = 0; i < 4; i++) {
+    for (int c = 0; c < 3; c++) {
+      EXPECT_NEAR(ibuf->rect_float[i * 3 + c], expected[i] + 16.0f * c, EPSILON * 100.0f);
+    }
+  }
+
+  IMB_freeImBuf(ibuf);
+}
+
+/* Single channel float buffers are enlarged like color buffers. */
+TEST(imbuf_scaling, box_enlarge_float_one_channel)
+{
+  const float pixels[2] = {1.0f, 3.0f};
+  ImBuf *ibuf = create_float_ibuf(2, 1, 1, pixels);
+
+  EXPECT_TRUE(IMB_scaleImBuf(ibuf, 4, 1));
+
+  const float expected[4] = {1.0f, 1.5f, 2.5f, 3.0f};
+  for (int x = 0; x < 4; x++) {
+    EXPECT_NEAR(ibuf->rect_float[x], expected[x], EPSILON);
+  }
+
+  IMB_freeImBuf(ibuf);
+}
+
+/* Enlarging 3 to 5 pixels vertically, with two channels. Output pixel centers are at
+ * 0.3, 0.9, 1.5, 2.1 and 2.7 input pixels. */
+TEST(imbuf_scaling, box_enlarge_float_odd_two_channels)
+{
+  const float pixels[3 * 2] = {0.0f, 0.0f, 10.0f, 20.0f, 20.0f, 40.0f};
+  ImBuf *ibuf = create_float_ibuf(1, 3, 2, pixels);
+
+  EXPECT_TRUE(IMB_scaleImBuf(ibuf, 1, 5));
+  EXPECT_EQ(ibuf->x, 1);
+  EXPECT_EQ(ibuf->y, 5);
+
+  const float expected[5] = {0.0f, 4.0f, 10.0f, 16.0f, 20.0f};
+  for (int y = 0; y < 5; y++) {
+    EXPECT_NEAR(ibuf->rect_float[y * 2], expected[y], EPSILON * 100.0f);
+    EXPECT_NEAR(ibuf->rect_float[y * 2 + 1], 2.0f * expected[y], EPSILON * 100.0f);
+  }
+
+  IMB_freeImBuf(ibuf);
+}
+
+}  // namespace blender::imbuf::tests
@@ -157,7 +157,9 @@ typedef struct Image {
   short gpuflag;
   short gpu_pass;
   short gpu_layer;
-  char _pad2[6];
+  char _pad2[2];
+  /** Incremented when the pixels are freed or changed, used to detect outdated cached results. */
+  unsigned int generation_counter;
 
   /** Deprecated. */
   struct PackedFile *packedfile DNA_DEPRECATED;
@@ -46,6 +46,7 @@ struct MPoly;
 struct MVert;
 struct Material;
 struct Mesh;
+struct MeshTopologyCache;
 struct SubdivCCG;
 
 #
@@ -103,6 +104,19 @@ typedef struct Mesh_Runtime {
   /** Non-manifold boundary data for Shrinkwrap Target Project. */
   struct ShrinkwrapBoundaryData *shrinkwrap_data;
 
+  /**
+   * Lazily computed topology maps and bounds shared by all users of this mesh,
+   * see #BKE_mesh_runtime_vert_poly_map_ensure and friends. Defined in `mesh_runtime.c`.
+   */
+  struct MeshTopologyCache *topology_cache;
+
+  /**
+   * Vertex positions as a contiguous array, used by the modifier stack while it runs deform
+   * modifiers. When set these are the current positions and #MVert.co is out of date until
+   * #BKE_mesh_runtime_vert_positions_flush writes them back.
+   */
+  float (*vert_positions)[3];
+
   /** Set by modifier stack if only deformed from original. */
   char deformed_only;
   /**
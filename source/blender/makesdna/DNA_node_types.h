@@ -447,7 +447,8 @@ typedef struct bNodeTree {
   short is_updating;
   /** Generic temporary flag for recursion check (DFS/BFS). */
   short done;
-  char _pad2[4];
+  /** Memory budget of the compositor result cache, in megabytes. */
+  int cache_size;
 
   /** Specific node type this tree is used for. */
   int nodetype DNA_DEPRECATED;
@@ -517,6 +518,9 @@ typedef struct bNodeTree {
 
 /* tree is localized copy, free when deleting node groups */
 /* #define NTREE_IS_LOCALIZED           (1 << 5) */
+#define NTREE_COM_FULL_FRAME (1 << 6)   /* process rows of pixels at once */
+#define NTREE_COM_RESULT_CACHE (1 << 7) /* keep node results between executions */
+#define NTREE_COM_HALF_BUFFERS (1 << 8) /* store color buffers as half floats */
 
 /* ntree->update */
 typedef enum eNodeTreeUpdate {
@@ -124,6 +124,9 @@ typedef struct Strip {
 
 typedef struct SequenceRuntime {
   SessionUUID session_uuid;
+  /** Time in seconds it took to render and blend the strip the last time it was rendered. */
+  float render_time;
+  char _pad[4];
 } SequenceRuntime;
 
 /**
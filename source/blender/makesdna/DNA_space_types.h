@@ -635,6 +635,7 @@ typedef enum eSpaceSeq_Flag {
   SEQ_SHOW_STRIP_NAME = (1 << 14),
   SEQ_SHOW_STRIP_SOURCE = (1 << 15),
   SEQ_SHOW_STRIP_DURATION = (1 << 16),
+  SEQ_SHOW_STRIP_RENDER_TIME = (1 << 17),
 } eSpaceSeq_Flag;
 
 /* SpaceSeq.view */
@@ -212,6 +212,10 @@ static void rna_Mesh_update_data(Main *UNUSED(bmain), Scene *UNUSED(scene), Poin
 {
   ID *id = ptr->owner_id;
 
+  /* The data was written in place, topology maps, bounds or normals cached on the mesh may be
+   * outdated. */
+  BKE_mesh_runtime_clear_topology_cache(rna_mesh(ptr));
+
   /* cheating way for importers to avoid slow updates */
   if (id->us > 0) {
     DEG_id_tag_update(id, 0);
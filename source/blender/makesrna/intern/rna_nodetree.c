@@ -10353,6 +10353,33 @@ static void rna_def_composite_nodetree(BlenderRNA *brna)
                            "Use two pass execution during editing: first calculate fast nodes, "
                            "second pass calculate all nodes");
 
+  prop = RNA_def_property(srna, "use_full_frame", PROP_BOOLEAN, PROP_NONE);
+  RNA_def_property_boolean_sdna(prop, NULL, "flag", NTREE_COM_FULL_FRAME);
+  RNA_def_property_ui_text(prop,
+                           "Full Frame",
+                           "Compute whole rows of pixels at once, which is faster for chains of "
+                           "mix, math and color nodes on large images");
+
+  prop = RNA_def_property(srna, "use_half_float_buffers", PROP_BOOLEAN, PROP_NONE);
+  RNA_def_property_boolean_sdna(prop, NULL, "flag", NTREE_COM_HALF_BUFFERS);
+  RNA_def_property_ui_text(prop,
+                           "Half Float Buffers",
+                           "Store intermediate color buffers as half floats, using half the "
+                           "memory at reduced precision");
+
+  prop = RNA_def_property(srna, "use_result_cache", PROP_BOOLEAN, PROP_NONE);
+  RNA_def_property_boolean_sdna(prop, NULL, "flag", NTREE_COM_RESULT_CACHE);
+  RNA_def_property_ui_text(prop,
+                           "Cache Results",
+                           "Keep results of nodes between edits and frames, only nodes affected "
+                           "by a change are computed again");
+
+  prop = RNA_def_property(srna, "cache_size", PROP_INT, PROP_NONE);
+  RNA_def_property_int_sdna(prop, NULL, "cache_size");
+  RNA_def_property_range(prop, 0, INT_MAX);
+  RNA_def_property_ui_range(prop, 0, 65536, 64, -1);
+  RNA_def_property_ui_text(prop, "Cache Size", "Memory used for cached node results, in MB");
+
   prop = RNA_def_property(srna, "use_viewer_border", PROP_BOOLEAN, PROP_NONE);
   RNA_def_property_boolean_sdna(prop, NULL, "flag", NTREE_VIEWER_BORDER);
   RNA_def_property_ui_text(
@@ -5327,12 +5327,13 @@ static void rna_def_userdef_system(BlenderRNA *brna)
        "LOW",
        0,
        "Low",
-       "Doesn't require fast storage and uses less CPU resources"},
+       "Fast compression (LZO) with delta coding between frames, uses little CPU resources"},
       {USER_SEQ_DISK_CACHE_COMPRESSION_HIGH,
        "HIGH",
        0,
        "High",
-       "Works on slower storage devices and uses most CPU resources"},
+       "Deflate compression with delta coding between frames, works on slower storage devices "
+       "and uses most CPU resources"},
       {0, NULL, 0, NULL, NULL},
   };
 
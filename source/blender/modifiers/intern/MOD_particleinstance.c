@@ -42,6 +42,7 @@
 #include "BKE_lattice.h"
 #include "BKE_lib_query.h"
 #include "BKE_mesh.h"
+#include "BKE_mesh_runtime.h"
 #include "BKE_modifier.h"
 #include "BKE_particle.h"
 #include "BKE_pointcache.h"
@@ -328,7 +329,7 @@ static Mesh *modifyMesh(ModifierData *md, const ModifierEvalContext *ctx, Mesh *
   if (psys->flag & (PSYS_HAIR_DONE | PSYS_KEYED) || psys->pointcache->flag & PTCACHE_BAKED) {
     float min[3], max[3];
     INIT_MINMAX(min, max);
-    BKE_mesh_minmax(mesh, min, max);
+    BKE_mesh_runtime_minmax(mesh, min, max);
     min_co = min[track];
     max_co = max[track];
   }
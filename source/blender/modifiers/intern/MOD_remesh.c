@@ -87,7 +87,7 @@ static void init_dualcon_mesh(DualConInput *input, Mesh *mesh)
   input->tottri = mesh->runtime.looptris.len;
 
   INIT_MINMAX(input->min, input->max);
-  BKE_mesh_minmax(mesh, input->min, input->max);
+  BKE_mesh_runtime_minmax(mesh, input->min, input->max);
 }
 
 /* simple structure to hold the output: a CDDM and two counters to
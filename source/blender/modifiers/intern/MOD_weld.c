@@ -37,8 +37,10 @@
 
 #include "BLI_alloca.h"
 #include "BLI_bitmap.h"
+#include "BLI_hash_grid.h"
 #include "BLI_kdtree.h"
 #include "BLI_math.h"
+#include "BLI_task.h"
 
 #include "BLT_translation.h"
 
@@ -1567,6 +1569,40 @@ static bool bvhtree_weld_overlap_cb(void *userdata, int index_a, int index_b, in
 }
 #endif
 
+/** Elements per thread when remapping the indices of the result. */
+#define WELD_REMAP_GRAINSIZE 4096
+
+/**
+ * Edges and loops of the result are first filled in with their original vertex and edge
+ * indices, which are then remapped to the final ones in parallel.
+ */
+struct WeldRemapData {
+  MEdge *medge;
+  MLoop *mloop;
+  const uint *vert_final;
+  const uint *edge_final;
+};
+
+static void weld_edge_remap_cb(void *__restrict userdata,
+                               const int i,
+                               const TaskParallelTLS *__restrict UNUSED(tls))
+{
+  const struct WeldRemapData *data = userdata;
+  MEdge *me = &data->medge[i];
+  me->v1 = data->vert_final[me->v1];
+  me->v2 = data->vert_final[me->v2];
+}
+
+static void weld_loop_remap_cb(void *__restrict userdata,
+                               const int i,
+                               const TaskParallelTLS *__restrict UNUSED(tls))
+{
+  const struct WeldRemapData *data = userdata;
+  MLoop *ml = &data->mloop[i];
+  ml->v = data->vert_final[ml->v];
+  ml->e = data->edge_final[ml->e];
+}
+
 /** Use for #MOD_WELD_MODE_CONNECTED calculation. */
 struct WeldVertexCluster {
   float co[3];
@@ -1694,18 +1730,52 @@ static Mesh *weldModifier_doWeld(WeldModifierData *wmd, const ModifierEvalContex
   }
 #else
   {
-    KDTree_3d *tree = BLI_kdtree_3d_new(v_mask ? v_mask_act : totvert);
-    for (uint i = 0; i < totvert; i++) {
+    /* Only the vertices in the group are searched, the others stay out of context. */
+    const uint search_len = v_mask ? (uint)v_mask_act : totvert;
+    float(*search_co)[3] = MEM_malloc_arrayN(search_len, sizeof(*search_co), __func__);
+    uint *search_index = v_mask ? MEM_malloc_arrayN(search_len, sizeof(*search_index), __func__) :
+                                  NULL;
+    int *search_dest_map = v_mask ? MEM_malloc_arrayN(search_len, sizeof(int), __func__) :
+                                    (int *)vert_dest_map;
+    for (uint i = 0, j = 0; i < totvert; i++) {
       if (!v_mask || BLI_BITMAP_TEST(v_mask, i)) {
-        BLI_kdtree_3d_insert(tree, i, mvert[i].co);
+        copy_v3_v3(search_co[j], mvert[i].co);
+        if (search_index) {
+          search_index[j] = i;
+        }
+        j++;
       }
       vert_dest_map[i] = OUT_OF_CONTEXT;
     }
+    if (v_mask) {
+      copy_vn_i(search_dest_map, (int)search_len, -1);
+    }
+
+    if (search_len < BLI_HASH_GRID_POINTS_MIN) {
+      KDTree_3d *tree = BLI_kdtree_3d_new(search_len);
+      for (uint j = 0; j < search_len; j++) {
+        BLI_kdtree_3d_insert(tree, (int)j, search_co[j]);
+      }
+      BLI_kdtree_3d_balance(tree);
+      vert_kill_len = (uint)BLI_kdtree_3d_calc_duplicates_fast(
+          tree, wmd->merge_dist, false, search_dest_map);
+      BLI_kdtree_3d_free(tree);
+    }
+    else {
+      vert_kill_len = (uint)BLI_hash_grid_3d_calc_duplicates(
+          (const float(*)[3])search_co, (int)search_len, wmd->merge_dist, search_dest_map);
+    }
 
-    BLI_kdtree_3d_balance(tree);
-    vert_kill_len = BLI_kdtree_3d_calc_duplicates_fast(
-        tree, wmd->merge_dist, false, (int *)vert_dest_map);
-    BLI_kdtree_3d_free(tree);
+    if (v_mask) {
+      for (uint j = 0; j < search_len; j++) {
+        if (search_dest_map[j] != -1) {
+          vert_dest_map[search_index[j]] = search_index[search_dest_map[j]];
+        }
+      }
+      MEM_freeN(search_index);
+      MEM_freeN(search_dest_map);
+    }
+    MEM_freeN(search_co);
   }
 #endif
   else {
@@ -1857,12 +1927,7 @@ static Mesh *weldModifier_doWeld(WeldModifierData *wmd, const ModifierEvalContex
       }
       if (count) {
         CustomData_copy_data(&mesh->edata, &result->edata, source_index, dest_index, count);
-        MEdge *me = &result->medge[dest_index];
         dest_index += count;
-        for (; count--; me++) {
-          me->v1 = vert_final[me->v1];
-          me->v2 = vert_final[me->v2];
-        }
       }
       if (i == totedge) {
         break;
@@ -1875,8 +1940,8 @@ static Mesh *weldModifier_doWeld(WeldModifierData *wmd, const ModifierEvalContex
                         wegrp->group.len,
                         dest_index);
         MEdge *me = &result->medge[dest_index];
-        me->v1 = vert_final[wegrp->v1];
-        me->v2 = vert_final[wegrp->v2];
+        me->v1 = wegrp->v1;
+        me->v2 = wegrp->v2;
         me->flag |= ME_LOOSEEDGE;
 
         *index_iter = dest_index;
@@ -1886,6 +1951,18 @@ static Mesh *weldModifier_doWeld(WeldModifierData *wmd, const ModifierEvalContex
 
     BLI_assert(dest_index == result_nedges);
 
+    TaskParallelSettings settings;
+    BLI_parallel_range_settings_defaults(&settings);
+    settings.min_iter_per_thread = WELD_REMAP_GRAINSIZE;
+
+    struct WeldRemapData remap_data = {
+        .medge = result->medge,
+        .mloop = result->mloop,
+        .vert_final = vert_final,
+        .edge_final = edge_final,
+    };
+    BLI_task_parallel_range(0, result_nedges, &remap_data, weld_edge_remap_cb, &settings);
+
     /* Polys/Loops */
 
     mp = &mpoly[0];
@@ -1901,10 +1978,7 @@ static Mesh *weldModifier_doWeld(WeldModifierData *wmd, const ModifierEvalContex
         uint mp_loop_len = mp->totloop;
         CustomData_copy_data(&mesh->ldata, &result->ldata, mp->loopstart, loop_cur, mp_loop_len);
         loop_cur += mp_loop_len;
-        for (; mp_loop_len--; r_ml++) {
-          r_ml->v = vert_final[r_ml->v];
-          r_ml->e = edge_final[r_ml->e];
-        }
+        r_ml += mp_loop_len;
       }
       else {
         WeldPoly *wp = &weld_mesh.wpoly[poly_ctx];
@@ -1919,10 +1993,9 @@ static Mesh *weldModifier_doWeld(WeldModifierData *wmd, const ModifierEvalContex
         }
         while (weld_iter_loop_of_poly_next(&iter)) {
           customdata_weld(&mesh->ldata, &result->ldata, group_buffer, iter.group_len, loop_cur);
-          uint v = vert_final[iter.v];
           uint e = edge_final[iter.e];
-          r_ml->v = v;
-          r_ml->e = e;
+          r_ml->v = iter.v;
+          r_ml->e = iter.e;
           r_ml++;
           loop_cur++;
           if (iter.type) {
@@ -1953,10 +2026,9 @@ static Mesh *weldModifier_doWeld(WeldModifierData *wmd, const ModifierEvalContex
       }
       while (weld_iter_loop_of_poly_next(&iter)) {
         customdata_weld(&mesh->ldata, &result->ldata, group_buffer, iter.group_len, loop_cur);
-        uint v = vert_final[iter.v];
         uint e = edge_final[iter.e];
-        r_ml->v = v;
-        r_ml->e = e;
+        r_ml->v = iter.v;
+        r_ml->e = iter.e;
         r_ml++;
         loop_cur++;
         if (iter.type) {
@@ -1974,6 +2046,8 @@ static Mesh *weldModifier_doWeld(WeldModifierData *wmd, const ModifierEvalContex
     BLI_assert((int)r_i == result_npolys);
     BLI_assert(loop_cur == result_nloops);
 
+    BLI_task_parallel_range(0, result_nloops, &remap_data, weld_loop_remap_cb, &settings);
+
     /* is this needed? */
     /* recalculate normals */
     result->runtime.cd_dirty_vert |= CD_MASK_NORMAL;
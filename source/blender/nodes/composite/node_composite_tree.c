@@ -322,6 +322,11 @@ void ntreeCompositTagRender(Scene *scene)
       }
     }
   }
+
+#ifdef WITH_COMPOSITOR
+  /* Cached results of render layer nodes are outdated by the new render result. */
+  COM_clearRenderLayerCaches();
+#endif
 }
 
 /* XXX after render animation system gets a refresh, this call allows composite to end clean */
@@ -32,6 +32,7 @@
 
 #include "imbuf_py_api.h" /* own include */
 
+#include "../../imbuf/IMB_cache_manager.h"
 #include "../../imbuf/IMB_imbuf.h"
 #include "../../imbuf/IMB_imbuf_types.h"
 
@@ -87,7 +88,7 @@ PyDoc_STRVAR(py_imbuf_resize_doc,
              "\n"
              "   :arg size: New size.\n"
              "   :type size: pair of ints\n"
-             "   :arg method: Method of resizing ('FAST', 'BILINEAR')\n"
+             "   :arg method: Method of resizing ('FAST', 'BILINEAR', 'BICUBIC', 'LANCZOS')\n"
              "   :type method: str\n");
 static PyObject *py_imbuf_resize(Py_ImBuf *self, PyObject *args, PyObject *kw)
 {
@@ -95,10 +96,12 @@ static PyObject *py_imbuf_resize(Py_ImBuf *self, PyObject *args, PyObject *kw)
 
   uint size[2];
 
-  enum { FAST, BILINEAR };
+  enum { FAST, BILINEAR, BICUBIC, LANCZOS };
   const struct PyC_StringEnumItems method_items[] = {
       {FAST, "FAST"},
       {BILINEAR, "BILINEAR"},
+      {BICUBIC, "BICUBIC"},
+      {LANCZOS, "LANCZOS"},
       {0, NULL},
   };
   struct PyC_StringEnum method = {method_items, FAST};
@@ -115,6 +118,12 @@ static PyObject *py_imbuf_resize(Py_ImBuf *self, PyObject *args, PyObject *kw)
   else if (method.value_found == BILINEAR) {
     IMB_scaleImBuf(self->ibuf, UNPACK2(size));
   }
+  else if (method.value_found == BICUBIC) {
+    IMB_scaleImBuf_filtered(self->ibuf, UNPACK2(size), IMB_SCALE_FILTER_BICUBIC);
+  }
+  else if (method.value_found == LANCZOS) {
+    IMB_scaleImBuf_filtered(self->ibuf, UNPACK2(size), IMB_SCALE_FILTER_LANCZOS);
+  }
   else {
     BLI_assert(0);
   }
@@ -516,6 +525,101 @@ static PyObject *M_imbuf_write(PyObject *UNUSED(self), PyObject *args, PyObject
 
 /** \} */
 
+/* -------------------------------------------------------------------- */
+/** \name Cache Statistics
+ * \{ */
+
+static const struct PyC_StringEnumItems py_imbuf_cache_type_items[] = {
+    {IMB_CACHE_TYPE_IMAGE, "IMAGE"},
+    {IMB_CACHE_TYPE_MOVIECLIP, "MOVIECLIP"},
+    {IMB_CACHE_TYPE_SEQUENCER, "SEQUENCER"},
+    {IMB_CACHE_TYPE_COLORMANAGE, "COLORMANAGE"},
+    {0, NULL},
+};
+
+static void py_dict_set_item_steal(PyObject *dict, const char *key, PyObject *value)
+{
+  PyDict_SetItemString(dict, key, value);
+  Py_DECREF(value);
+}
+
+PyDoc_STRVAR(M_imbuf_cache_stats_doc,
+             ".. function:: cache_stats()\n"
+             "\n"
+             "   Statistics of the image, movie clip, sequencer and color management caches,\n"
+             "   which share the memory cache limit.\n"
+             "\n"
+             "   :return: A dictionary per cache type ('IMAGE', 'MOVIECLIP', 'SEQUENCER',\n"
+             "      'COLORMANAGE') with ``memory_in_use`` in bytes, the ``hits``, ``misses``\n"
+             "      and ``evictions`` counters and the eviction ``priority``.\n"
+             "      The ``memory_limit`` key holds the memory cache limit in bytes.\n"
+             "   :rtype: dict\n");
+static PyObject *M_imbuf_cache_stats(PyObject *UNUSED(self))
+{
+  PyObject *result = PyDict_New();
+
+  for (int i = 0; py_imbuf_cache_type_items[i].id; i++) {
+    IMBCacheStats stats;
+    PyObject *item = PyDict_New();
+
+    IMB_cache_stats_get(py_imbuf_cache_type_items[i].value, &stats);
+    py_dict_set_item_steal(item, "memory_in_use", PyLong_FromSize_t(stats.memory_in_use));
+    py_dict_set_item_steal(item, "hits", PyLong_FromUnsignedLongLong(stats.hits));
+    py_dict_set_item_steal(item, "misses", PyLong_FromUnsignedLongLong(stats.misses));
+    py_dict_set_item_steal(item, "evictions", PyLong_FromUnsignedLongLong(stats.evictions));
+    py_dict_set_item_steal(item, "priority", PyFloat_FromDouble(stats.priority));
+
+    py_dict_set_item_steal(result, py_imbuf_cache_type_items[i].id, item);
+  }
+
+  py_dict_set_item_steal(result, "memory_limit", PyLong_FromSize_t(IMB_cache_memory_limit()));
+
+  return result;
+}
+
+PyDoc_STRVAR(M_imbuf_cache_stats_reset_doc,
+             ".. function:: cache_stats_reset()\n"
+             "\n"
+             "   Reset the hits, misses and evictions counters of all caches.\n");
+static PyObject *M_imbuf_cache_stats_reset(PyObject *UNUSED(self))
+{
+  IMB_cache_stats_reset();
+  Py_RETURN_NONE;
+}
+
+PyDoc_STRVAR(M_imbuf_cache_priority_set_doc,
+             ".. function:: cache_priority_set(type, priority)\n"
+             "\n"
+             "   Set how valuable items of a cache are compared to other caches when memory\n"
+             "   has to be freed, items of higher priority caches are kept longer.\n"
+             "\n"
+             "   :arg type: Cache type ('IMAGE', 'MOVIECLIP', 'SEQUENCER', 'COLORMANAGE').\n"
+             "   :type type: str\n"
+             "   :arg priority: Priority, zero or more.\n"
+             "   :type priority: float\n");
+static PyObject *M_imbuf_cache_priority_set(PyObject *UNUSED(self), PyObject *args, PyObject *kw)
+{
+  struct PyC_StringEnum type = {py_imbuf_cache_type_items};
+  float priority;
+
+  static const char *_keywords[] = {"type", "priority", NULL};
+  static _PyArg_Parser _parser = {"O&f:cache_priority_set", _keywords, 0};
+  if (!_PyArg_ParseTupleAndKeywordsFast(
+          args, kw, &_parser, PyC_ParseStringEnum, &type, &priority)) {
+    return NULL;
+  }
+
+  if (priority < 0.0f) {
+    PyErr_SetString(PyExc_ValueError, "cache_priority_set: priority must not be negative");
+    return NULL;
+  }
+
+  IMB_cache_priority_set(type.value_found, priority);
+  Py_RETURN_NONE;
+}
+
+/** \} */
+
 /* -------------------------------------------------------------------- */
 /** \name Module Definition
  * \{ */
@@ -524,6 +628,15 @@ static PyMethodDef IMB_methods[] = {
     {"new", (PyCFunction)M_imbuf_new, METH_VARARGS | METH_KEYWORDS, M_imbuf_new_doc},
     {"load", (PyCFunction)M_imbuf_load, METH_VARARGS | METH_KEYWORDS, M_imbuf_load_doc},
     {"write", (PyCFunction)M_imbuf_write, METH_VARARGS | METH_KEYWORDS, M_imbuf_write_doc},
+    {"cache_stats", (PyCFunction)M_imbuf_cache_stats, METH_NOARGS, M_imbuf_cache_stats_doc},
+    {"cache_stats_reset",
+     (PyCFunction)M_imbuf_cache_stats_reset,
+     METH_NOARGS,
+     M_imbuf_cache_stats_reset_doc},
+    {"cache_priority_set",
+     (PyCFunction)M_imbuf_cache_priority_set,
+     METH_VARARGS | METH_KEYWORDS,
+     M_imbuf_cache_priority_set_doc},
     {NULL, NULL, 0, NULL},
 };
 
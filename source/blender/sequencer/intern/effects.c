@@ -28,6 +28,10 @@
 #include <stdlib.h>
 #include <string.h>
 
+#ifdef __SSE2__
+#  include <emmintrin.h>
+#endif
+
 #include "MEM_guardedalloc.h"
 
 #include "BLI_listbase.h"
@@ -193,6 +197,85 @@ static ImBuf *prepare_effect_imbufs(const SeqRenderData *context,
   return out;
 }
 
+/*********************** Line Kernels *************************/
+
+/* Effects use facf0 for even and facf1 for odd lines of a slice (fields rendering).
+ * Kernels below process a single line with constant factor, so they are free of parity
+ * branches and can be vectorized. SSE2 versions are used on x86-64, where it is always
+ * available, other platforms use the scalar versions. */
+
+typedef void (*EffectLineFuncByte)(float fac,
+                                   int x,
+                                   const unsigned char *rt1,
+                                   const unsigned char *rt2,
+                                   unsigned char *rt);
+typedef void (*EffectLineFuncFloat)(
+    float fac, int x, const float *rt1, const float *rt2, float *rt);
+
+BLI_INLINE void apply_line_function_byte(float facf0,
+                                         float facf1,
+                                         int x,
+                                         int y,
+                                         const unsigned char *rect1,
+                                         const unsigned char *rect2,
+                                         unsigned char *out,
+                                         EffectLineFuncByte line_function)
+{
+  const size_t stride = (size_t)x * 4;
+  for (int i = 0; i < y; i++) {
+    const size_t offset = stride * i;
+    line_function((i & 1) ? facf1 : facf0, x, rect1 + offset, rect2 + offset, out + offset);
+  }
+}
+
+BLI_INLINE void apply_line_function_float(float facf0,
+                                          float facf1,
+                                          int x,
+                                          int y,
+                                          const float *rect1,
+                                          const float *rect2,
+                                          float *out,
+                                          EffectLineFuncFloat line_function)
+{
+  const size_t stride = (size_t)x * 4;
+  for (int i = 0; i < y; i++) {
+    const size_t offset = stride * i;
+    line_function((i & 1) ? facf1 : facf0, x, rect1 + offset, rect2 + offset, out + offset);
+  }
+}
+
+#ifdef __SSE2__
+/* Per lane `mask ? a : b`. */
+BLI_INLINE __m128 sse_select(__m128 mask, __m128 a, __m128 b)
+{
+  return _mm_or_ps(_mm_and_ps(mask, a), _mm_andnot_ps(mask, b));
+}
+
+BLI_INLINE __m128 sse_splat_alpha(__m128 pixel)
+{
+  return _mm_shuffle_ps(pixel, pixel, _MM_SHUFFLE(3, 3, 3, 3));
+}
+
+/* Lane of alpha channel of a float pixel. */
+BLI_INLINE __m128 sse_alpha_mask(void)
+{
+  return _mm_castsi128_ps(_mm_set_epi32(-1, 0, 0, 0));
+}
+
+/* Alpha of 2 byte pixels unpacked to 16 bit, in all lanes of each pixel. */
+BLI_INLINE __m128i sse_splat_alpha_epi16(__m128i pixels)
+{
+  pixels = _mm_shufflelo_epi16(pixels, _MM_SHUFFLE(3, 3, 3, 3));
+  return _mm_shufflehi_epi16(pixels, _MM_SHUFFLE(3, 3, 3, 3));
+}
+
+/* Byte factors of 0..256 keep all intermediate products of byte kernels within 16 bits. */
+BLI_INLINE bool sse_byte_factor_valid(int fac)
+{
+  return fac >= 0 && fac <= 256;
+}
+#endif
+
 /*********************** Alpha Over *************************/
 
 static void init_alpha_over_or_under(Sequence *seq)
@@ -289,73 +372,48 @@ static void do_alphaover_effect_byte(float facf0,
   }
 }
 
-static void do_alphaover_effect_float(
-    float facf0, float facf1, int x, int y, float *rect1, float *rect2, float *out)
+static void alphaover_line_float(
+    float fac, int x, const float *rt1, const float *rt2, float *rt)
 {
-  float fac2, mfac, fac, fac4;
-  int xo;
-  float *rt1, *rt2, *rt;
-
-  xo = x;
-  rt1 = rect1;
-  rt2 = rect2;
-  rt = out;
-
-  fac2 = facf0;
-  fac4 = facf1;
-
-  while (y--) {
-    x = xo;
-    while (x--) {
-      /* rt = rt1 over rt2  (alpha from rt1) */
+  /* rt = rt1 over rt2  (alpha from rt1) */
+  if (fac <= 0.0f) {
+    memcpy(rt, rt2, sizeof(float[4]) * x);
+    return;
+  }
 
-      fac = fac2;
-      mfac = 1.0f - (fac2 * rt1[3]);
+#ifdef __SSE2__
+  const __m128 fac_v = _mm_set1_ps(fac);
+  const __m128 one = _mm_set1_ps(1.0f);
+  const __m128 zero = _mm_setzero_ps();
 
-      if (fac <= 0.0f) {
-        memcpy(rt, rt2, sizeof(float[4]));
-      }
-      else if (mfac <= 0) {
-        memcpy(rt, rt1, sizeof(float[4]));
-      }
-      else {
-        rt[0] = fac * rt1[0] + mfac * rt2[0];
-        rt[1] = fac * rt1[1] + mfac * rt2[1];
-        rt[2] = fac * rt1[2] + mfac * rt2[2];
-        rt[3] = fac * rt1[3] + mfac * rt2[3];
-      }
-      rt1 += 4;
-      rt2 += 4;
-      rt += 4;
-    }
+  for (int i = 0; i < x; i++, rt1 += 4, rt2 += 4, rt += 4) {
+    const __m128 c1 = _mm_loadu_ps(rt1);
+    const __m128 c2 = _mm_loadu_ps(rt2);
+    const __m128 mfac = _mm_sub_ps(one, _mm_mul_ps(fac_v, sse_splat_alpha(c1)));
+    const __m128 c = _mm_add_ps(_mm_mul_ps(fac_v, c1), _mm_mul_ps(mfac, c2));
+    _mm_storeu_ps(rt, sse_select(_mm_cmple_ps(mfac, zero), c1, c));
+  }
+#else
+  for (int i = 0; i < x; i++, rt1 += 4, rt2 += 4, rt += 4) {
+    const float mfac = 1.0f - (fac * rt1[3]);
 
-    if (y == 0) {
-      break;
+    if (mfac <= 0.0f) {
+      memcpy(rt, rt1, sizeof(float[4]));
     }
-    y--;
-
-    x = xo;
-    while (x--) {
-      fac = fac4;
-      mfac = 1.0f - (fac4 * rt1[3]);
-
-      if (fac <= 0.0f) {
-        memcpy(rt, rt2, sizeof(float[4]));
-      }
-      else if (mfac <= 0.0f) {
-        memcpy(rt, rt1, sizeof(float[4]));
-      }
-      else {
-        rt[0] = fac * rt1[0] + mfac * rt2[0];
-        rt[1] = fac * rt1[1] + mfac * rt2[1];
-        rt[2] = fac * rt1[2] + mfac * rt2[2];
-        rt[3] = fac * rt1[3] + mfac * rt2[3];
-      }
-      rt1 += 4;
-      rt2 += 4;
-      rt += 4;
+    else {
+      rt[0] = fac * rt1[0] + mfac * rt2[0];
+      rt[1] = fac * rt1[1] + mfac * rt2[1];
+      rt[2] = fac * rt1[2] + mfac * rt2[2];
+      rt[3] = fac * rt1[3] + mfac * rt2[3];
     }
   }
+#endif
+}
+
+static void do_alphaover_effect_float(
+    float facf0, float facf1, int x, int y, float *rect1, float *rect2, float *out)
+{
+  apply_line_function_float(facf0, facf1, x, y, rect1, rect2, out, alphaover_line_float);
 }
 
 static void do_alphaover_effect(const SeqRenderData *context,
@@ -485,84 +543,63 @@ static void do_alphaunder_effect_byte(float facf0,
   }
 }
 
-static void do_alphaunder_effect_float(
-    float facf0, float facf1, int x, int y, float *rect1, float *rect2, float *out)
+static void alphaunder_line_float(
+    float fac, int x, const float *rt1, const float *rt2, float *rt)
 {
-  float fac2, fac, fac4;
-  int xo;
-  float *rt1, *rt2, *rt;
-
-  xo = x;
-  rt1 = rect1;
-  rt2 = rect2;
-  rt = out;
-
-  fac2 = facf0;
-  fac4 = facf1;
+  /* rt = rt1 under rt2  (alpha from rt2) */
 
-  while (y--) {
-    x = xo;
-    while (x--) {
-      /* rt = rt1 under rt2  (alpha from rt2) */
+#ifdef __SSE2__
+  const __m128 fac_v = _mm_set1_ps(fac);
+  const __m128 one = _mm_set1_ps(1.0f);
+  const __m128 zero = _mm_setzero_ps();
+  const bool fac_full = fac >= 1.0f;
 
-      /* this complex optimization is because the
-       * 'skybuf' can be crossed in
-       */
-      if (rt2[3] <= 0 && fac2 >= 1.0f) {
-        memcpy(rt, rt1, sizeof(float[4]));
-      }
-      else if (rt2[3] >= 1.0f) {
-        memcpy(rt, rt2, sizeof(float[4]));
-      }
-      else {
-        fac = fac2 * (1.0f - rt2[3]);
+  for (int i = 0; i < x; i++, rt1 += 4, rt2 += 4, rt += 4) {
+    const __m128 c1 = _mm_loadu_ps(rt1);
+    const __m128 c2 = _mm_loadu_ps(rt2);
+    const __m128 alpha2 = sse_splat_alpha(c2);
+    const __m128 f = _mm_mul_ps(fac_v, _mm_sub_ps(one, alpha2));
+    __m128 c = _mm_add_ps(_mm_mul_ps(f, c1), c2);
 
-        if (fac == 0) {
-          memcpy(rt, rt2, sizeof(float[4]));
-        }
-        else {
-          rt[0] = fac * rt1[0] + rt2[0];
-          rt[1] = fac * rt1[1] + rt2[1];
-          rt[2] = fac * rt1[2] + rt2[2];
-          rt[3] = fac * rt1[3] + rt2[3];
-        }
-      }
-      rt1 += 4;
-      rt2 += 4;
-      rt += 4;
+    c = sse_select(_mm_or_ps(_mm_cmpeq_ps(f, zero), _mm_cmpge_ps(alpha2, one)), c2, c);
+    /* This complex optimization is because the 'skybuf' can be crossed in. */
+    if (fac_full) {
+      c = sse_select(_mm_cmple_ps(alpha2, zero), c1, c);
     }
-
-    if (y == 0) {
-      break;
+    _mm_storeu_ps(rt, c);
+  }
+#else
+  for (int i = 0; i < x; i++, rt1 += 4, rt2 += 4, rt += 4) {
+    /* this complex optimization is because the
+     * 'skybuf' can be crossed in
+     */
+    if (rt2[3] <= 0 && fac >= 1.0f) {
+      memcpy(rt, rt1, sizeof(float[4]));
     }
-    y--;
+    else if (rt2[3] >= 1.0f) {
+      memcpy(rt, rt2, sizeof(float[4]));
+    }
+    else {
+      const float f = fac * (1.0f - rt2[3]);
 
-    x = xo;
-    while (x--) {
-      if (rt2[3] <= 0 && fac4 >= 1.0f) {
-        memcpy(rt, rt1, sizeof(float[4]));
-      }
-      else if (rt2[3] >= 1.0f) {
+      if (f == 0) {
         memcpy(rt, rt2, sizeof(float[4]));
       }
       else {
-        fac = fac4 * (1.0f - rt2[3]);
-
-        if (fac == 0) {
-          memcpy(rt, rt2, sizeof(float[4]));
-        }
-        else {
-          rt[0] = fac * rt1[0] + rt2[0];
-          rt[1] = fac * rt1[1] + rt2[1];
-          rt[2] = fac * rt1[2] + rt2[2];
-          rt[3] = fac * rt1[3] + rt2[3];
-        }
+        rt[0] = f * rt1[0] + rt2[0];
+        rt[1] = f * rt1[1] + rt2[1];
+        rt[2] = f * rt1[2] + rt2[2];
+        rt[3] = f * rt1[3] + rt2[3];
       }
-      rt1 += 4;
-      rt2 += 4;
-      rt += 4;
     }
   }
+#endif
+}
+
+static void do_alphaunder_effect_float(
+    float facf0, float facf1, int x, int y, float *rect1, float *rect2, float *out)
+{
+  apply_line_function_float(facf0, facf1, x, y, rect1, rect2, out, alphaunder_line_float);
 }
 
 static void do_alphaunder_effect(const SeqRenderData *context,
@@ -597,6 +634,42 @@ static void do_alphaunder_effect(const SeqRenderData *context,
 
 /*********************** Cross *************************/
 
+static void cross_line_byte(
+    float fac, int x, const unsigned char *rt1, const unsigned char *rt2, unsigned char *rt)
+{
+  const int fac2 = (int)(256.0f * fac);
+  const int fac1 = 256 - fac2;
+  int i = 0;
+
+#ifdef __SSE2__
+  if (sse_byte_factor_valid(fac2)) {
+    const __m128i fac1_v = _mm_set1_epi16(fac1);
+    const __m128i fac2_v = _mm_set1_epi16(fac2);
+    const __m128i zero = _mm_setzero_si128();
+
+    for (; i + 4 <= x; i += 4) {
+      const __m128i c1 = _mm_loadu_si128((const __m128i *)(rt1 + i * 4));
+      const __m128i c2 = _mm_loadu_si128((const __m128i *)(rt2 + i * 4));
+      const __m128i lo = _mm_add_epi16(_mm_mullo_epi16(_mm_unpacklo_epi8(c1, zero), fac1_v),
+                                       _mm_mullo_epi16(_mm_unpacklo_epi8(c2, zero), fac2_v));
+      const __m128i hi = _mm_add_epi16(_mm_mullo_epi16(_mm_unpackhi_epi8(c1, zero), fac1_v),
+                                       _mm_mullo_epi16(_mm_unpackhi_epi8(c2, zero), fac2_v));
+      _mm_storeu_si128((__m128i *)(rt + i * 4),
+                       _mm_packus_epi16(_mm_srli_epi16(lo, 8), _mm_srli_epi16(hi, 8)));
+    }
+  }
+#endif
+
+  for (; i < x; i++) {
+    const unsigned char *cp1 = rt1 + i * 4, *cp2 = rt2 + i * 4;
+    unsigned char *cp = rt + i * 4;
+    cp[0] = (fac1 * cp1[0] + fac2 * cp2[0]) >> 8;
+    cp[1] = (fac1 * cp1[1] + fac2 * cp2[1]) >> 8;
+    cp[2] = (fac1 * cp1[2] + fac2 * cp2[2]) >> 8;
+    cp[3] = (fac1 * cp1[3] + fac2 * cp2[3]) >> 8;
+  }
+}
+
 static void do_cross_effect_byte(float facf0,
                                  float facf1,
                                  int x,
@@ -605,99 +678,36 @@ static void do_cross_effect_byte(float facf0,
                                  unsigned char *rect2,
                                  unsigned char *out)
 {
-  int fac1, fac2, fac3, fac4;
-  int xo;
-  unsigned char *rt1, *rt2, *rt;
-
-  xo = x;
-  rt1 = rect1;
-  rt2 = rect2;
-  rt = out;
-
-  fac2 = (int)(256.0f * facf0);
-  fac1 = 256 - fac2;
-  fac4 = (int)(256.0f * facf1);
-  fac3 = 256 - fac4;
-
-  while (y--) {
-    x = xo;
-    while (x--) {
-      rt[0] = (fac1 * rt1[0] + fac2 * rt2[0]) >> 8;
-      rt[1] = (fac1 * rt1[1] + fac2 * rt2[1]) >> 8;
-      rt[2] = (fac1 * rt1[2] + fac2 * rt2[2]) >> 8;
-      rt[3] = (fac1 * rt1[3] + fac2 * rt2[3]) >> 8;
-
-      rt1 += 4;
-      rt2 += 4;
-      rt += 4;
-    }
+  apply_line_function_byte(facf0, facf1, x, y, rect1, rect2, out, cross_line_byte);
+}
 
-    if (y == 0) {
-      break;
-    }
-    y--;
+static void cross_line_float(float fac, int x, const float *rt1, const float *rt2, float *rt)
+{
+  const float mfac = 1.0f - fac;
 
-    x = xo;
-    while (x--) {
-      rt[0] = (fac3 * rt1[0] + fac4 * rt2[0]) >> 8;
-      rt[1] = (fac3 * rt1[1] + fac4 * rt2[1]) >> 8;
-      rt[2] = (fac3 * rt1[2] + fac4 * rt2[2]) >> 8;
-      rt[3] = (fac3 * rt1[3] + fac4 * rt2[3]) >> 8;
+#ifdef __SSE2__
+  const __m128 fac_v = _mm_set1_ps(fac);
+  const __m128 mfac_v = _mm_set1_ps(mfac);
 
-      rt1 += 4;
-      rt2 += 4;
-      rt += 4;
-    }
+  for (int i = 0; i < x; i++, rt1 += 4, rt2 += 4, rt += 4) {
+    _mm_storeu_ps(rt,
+                  _mm_add_ps(_mm_mul_ps(mfac_v, _mm_loadu_ps(rt1)),
+                             _mm_mul_ps(fac_v, _mm_loadu_ps(rt2))));
   }
+#else
+  for (int i = 0; i < x; i++, rt1 += 4, rt2 += 4, rt += 4) {
+    rt[0] = mfac * rt1[0] + fac * rt2[0];
+    rt[1] = mfac * rt1[1] + fac * rt2[1];
+    rt[2] = mfac * rt1[2] + fac * rt2[2];
+    rt[3] = mfac * rt1[3] + fac * rt2[3];
+  }
+#endif
 }
 
 static void do_cross_effect_float(
     float facf0, float facf1, int x, int y, float *rect1, float *rect2, float *out)
 {
-  float fac1, fac2, fac3, fac4;
-  int xo;
-  float *rt1, *rt2, *rt;
-
-  xo = x;
-  rt1 = rect1;
-  rt2 = rect2;
-  rt = out;
-
-  fac2 = facf0;
-  fac1 = 1.0f - fac2;
-  fac4 = facf1;
-  fac3 = 1.0f - fac4;
-
-  while (y--) {
-    x = xo;
-    while (x--) {
-      rt[0] = fac1 * rt1[0] + fac2 * rt2[0];
-      rt[1] = fac1 * rt1[1] + fac2 * rt2[1];
-      rt[2] = fac1 * rt1[2] + fac2 * rt2[2];
-      rt[3] = fac1 * rt1[3] + fac2 * rt2[3];
-
-      rt1 += 4;
-      rt2 += 4;
-      rt += 4;
-    }
-
-    if (y == 0) {
-      break;
-    }
-    y--;
-
-    x = xo;
-    while (x--) {
-      rt[0] = fac3 * rt1[0] + fac4 * rt2[0];
-      rt[1] = fac3 * rt1[1] + fac4 * rt2[1];
-      rt[2] = fac3 * rt1[2] + fac4 * rt2[2];
-      rt[3] = fac3 * rt1[3] + fac4 * rt2[3];
-
-      rt1 += 4;
-      rt2 += 4;
-      rt += 4;
-    }
-  }
+  apply_line_function_float(facf0, facf1, x, y, rect1, rect2, out, cross_line_float);
 }
 
 static void do_cross_effect(const SeqRenderData *context,
@@ -1030,6 +1040,51 @@ static void do_gammacross_effect(const SeqRenderData *context,
 
 /*********************** Add *************************/
 
+#ifdef __SSE2__
+/* Premultiplied by `fac * alpha2` color of rt2 for 4 byte pixels, as in `(m * c2) >> 16`,
+ * with zero in alpha channel. */
+BLI_INLINE __m128i sse_add_sub_term_byte(__m128i c2, __m128i fac_v)
+{
+  const __m128i zero = _mm_setzero_si128();
+  const __m128i lo = _mm_unpacklo_epi8(c2, zero);
+  const __m128i hi = _mm_unpackhi_epi8(c2, zero);
+  const __m128i m_lo = _mm_mullo_epi16(sse_splat_alpha_epi16(lo), fac_v);
+  const __m128i m_hi = _mm_mullo_epi16(sse_splat_alpha_epi16(hi), fac_v);
+  const __m128i term = _mm_packus_epi16(_mm_mulhi_epu16(m_lo, lo), _mm_mulhi_epu16(m_hi, hi));
+  return _mm_andnot_si128(_mm_set1_epi32((int)0xff000000), term);
+}
+#endif
+
+static void add_line_byte(
+    float fac, int x, const unsigned char *rt1, const unsigned char *rt2, unsigned char *rt)
+{
+  const int fac1 = (int)(256.0f * fac);
+  int i = 0;
+
+#ifdef __SSE2__
+  if (sse_byte_factor_valid(fac1)) {
+    const __m128i fac_v = _mm_set1_epi16(fac1);
+
+    for (; i + 4 <= x; i += 4) {
+      const __m128i c1 = _mm_loadu_si128((const __m128i *)(rt1 + i * 4));
+      const __m128i c2 = _mm_loadu_si128((const __m128i *)(rt2 + i * 4));
+      _mm_storeu_si128((__m128i *)(rt + i * 4),
+                       _mm_adds_epu8(c1, sse_add_sub_term_byte(c2, fac_v)));
+    }
+  }
+#endif
+
+  for (; i < x; i++) {
+    const unsigned char *cp1 = rt1 + i * 4, *cp2 = rt2 + i * 4;
+    unsigned char *cp = rt + i * 4;
+    const int m = fac1 * (int)cp2[3];
+    cp[0] = min_ii(cp1[0] + ((m * cp2[0]) >> 16), 255);
+    cp[1] = min_ii(cp1[1] + ((m * cp2[1]) >> 16), 255);
+    cp[2] = min_ii(cp1[2] + ((m * cp2[2]) >> 16), 255);
+    cp[3] = cp1[3];
+  }
+}
+
 static void do_add_effect_byte(float facf0,
                                float facf1,
                                int x,
@@ -1038,100 +1093,42 @@ static void do_add_effect_byte(float facf0,
                                unsigned char *rect2,
                                unsigned char *out)
 {
-  int xo, fac1, fac3;
-  unsigned char *cp1, *cp2, *rt;
-
-  xo = x;
-  cp1 = rect1;
-  cp2 = rect2;
-  rt = out;
-
-  fac1 = (int)(256.0f * facf0);
-  fac3 = (int)(256.0f * facf1);
-
-  while (y--) {
-    x = xo;
-
-    while (x--) {
-      const int m = fac1 * (int)cp2[3];
-      rt[0] = min_ii(cp1[0] + ((m * cp2[0]) >> 16), 255);
-      rt[1] = min_ii(cp1[1] + ((m * cp2[1]) >> 16), 255);
-      rt[2] = min_ii(cp1[2] + ((m * cp2[2]) >> 16), 255);
-      rt[3] = cp1[3];
-
-      cp1 += 4;
-      cp2 += 4;
-      rt += 4;
-    }
+  apply_line_function_byte(facf0, facf1, x, y, rect1, rect2, out, add_line_byte);
+}
 
-    if (y == 0) {
-      break;
-    }
-    y--;
+static void add_line_float(float fac, int x, const float *rt1, const float *rt2, float *rt)
+{
+  const float fac_inv = 1.0f - fac;
 
-    x = xo;
-    while (x--) {
-      const int m = fac3 * (int)cp2[3];
-      rt[0] = min_ii(cp1[0] + ((m * cp2[0]) >> 16), 255);
-      rt[1] = min_ii(cp1[1] + ((m * cp2[1]) >> 16), 255);
-      rt[2] = min_ii(cp1[2] + ((m * cp2[2]) >> 16), 255);
-      rt[3] = cp1[3];
+#ifdef __SSE2__
+  const __m128 fac_inv_v = _mm_set1_ps(fac_inv);
+  const __m128 one = _mm_set1_ps(1.0f);
+  const __m128 alpha_mask = sse_alpha_mask();
 
-      cp1 += 4;
-      cp2 += 4;
-      rt += 4;
-    }
+  for (int i = 0; i < x; i++, rt1 += 4, rt2 += 4, rt += 4) {
+    const __m128 c1 = _mm_loadu_ps(rt1);
+    const __m128 c2 = _mm_loadu_ps(rt2);
+    const __m128 m = _mm_mul_ps(_mm_sub_ps(one, _mm_mul_ps(sse_splat_alpha(c1), fac_inv_v)),
+                                sse_splat_alpha(c2));
+    const __m128 c = _mm_add_ps(c1, _mm_mul_ps(m, c2));
+    _mm_storeu_ps(rt, sse_select(alpha_mask, c1, c));
   }
+#else
+  for (int i = 0; i < x; i++, rt1 += 4, rt2 += 4, rt += 4) {
+    const float m = (1.0f - (rt1[3] * fac_inv)) * rt2[3];
+    rt[0] = rt1[0] + m * rt2[0];
+    rt[1] = rt1[1] + m * rt2[1];
+    rt[2] = rt1[2] + m * rt2[2];
+    rt[3] = rt1[3];
+  }
+#endif
 }
 
 static void do_add_effect_float(
     float facf0, float facf1, int x, int y, float *rect1, float *rect2, float *out)
 {
-  int xo;
-  float fac1, fac3;
-  float *rt1, *rt2, *rt;
-
-  xo = x;
-  rt1 = rect1;
-  rt2 = rect2;
-  rt = out;
-
-  fac1 = facf0;
-  fac3 = facf1;
-
-  while (y--) {
-    x = xo;
-    while (x--) {
-      const float m = (1.0f - (rt1[3] * (1.0f - fac1))) * rt2[3];
-      rt[0] = rt1[0] + m * rt2[0];
-      rt[1] = rt1[1] + m * rt2[1];
-      rt[2] = rt1[2] + m * rt2[2];
-      rt[3] = rt1[3];
-
-      rt1 += 4;
-      rt2 += 4;
-      rt += 4;
-    }
-
-    if (y == 0) {
-      break;
-    }
-    y--;
-
-    x = xo;
-    while (x--) {
-      const float m = (1.0f - (rt1[3] * (1.0f - fac3))) * rt2[3];
-      rt[0] = rt1[0] + m * rt2[0];
-      rt[1] = rt1[1] + m * rt2[1];
-      rt[2] = rt1[2] + m * rt2[2];
-      rt[3] = rt1[3];
-
-      rt1 += 4;
-      rt2 += 4;
-      rt += 4;
-    }
-  }
-}
+  apply_line_function_float(facf0, facf1, x, y, rect1, rect2, out, add_line_float);
+}
 
 static void do_add_effect(const SeqRenderData *context,
                           Sequence *UNUSED(seq),
@@ -1165,6 +1162,36 @@ static void do_add_effect(const SeqRenderData *context,
 
 /*********************** Sub *************************/
 
+static void sub_line_byte(
+    float fac, int x, const unsigned char *rt1, const unsigned char *rt2, unsigned char *rt)
+{
+  const int fac1 = (int)(256.0f * fac);
+  int i = 0;
+
+#ifdef __SSE2__
+  if (sse_byte_factor_valid(fac1)) {
+    const __m128i fac_v = _mm_set1_epi16(fac1);
+
+    for (; i + 4 <= x; i += 4) {
+      const __m128i c1 = _mm_loadu_si128((const __m128i *)(rt1 + i * 4));
+      const __m128i c2 = _mm_loadu_si128((const __m128i *)(rt2 + i * 4));
+      _mm_storeu_si128((__m128i *)(rt + i * 4),
+                       _mm_subs_epu8(c1, sse_add_sub_term_byte(c2, fac_v)));
+    }
+  }
+#endif
+
+  for (; i < x; i++) {
+    const unsigned char *cp1 = rt1 + i * 4, *cp2 = rt2 + i * 4;
+    unsigned char *cp = rt + i * 4;
+    const int m = fac1 * (int)cp2[3];
+    cp[0] = max_ii(cp1[0] - ((m * cp2[0]) >> 16), 0);
+    cp[1] = max_ii(cp1[1] - ((m * cp2[1]) >> 16), 0);
+    cp[2] = max_ii(cp1[2] - ((m * cp2[2]) >> 16), 0);
+    cp[3] = cp1[3];
+  }
+}
+
 static void do_sub_effect_byte(float facf0,
                                float facf1,
                                int x,
@@ -1173,99 +1200,43 @@ static void do_sub_effect_byte(float facf0,
                                unsigned char *rect2,
                                unsigned char *out)
 {
-  int xo, fac1, fac3;
-  unsigned char *cp1, *cp2, *rt;
-
-  xo = x;
-  cp1 = rect1;
-  cp2 = rect2;
-  rt = out;
-
-  fac1 = (int)(256.0f * facf0);
-  fac3 = (int)(256.0f * facf1);
-
-  while (y--) {
-    x = xo;
-    while (x--) {
-      const int m = fac1 * (int)cp2[3];
-      rt[0] = max_ii(cp1[0] - ((m * cp2[0]) >> 16), 0);
-      rt[1] = max_ii(cp1[1] - ((m * cp2[1]) >> 16), 0);
-      rt[2] = max_ii(cp1[2] - ((m * cp2[2]) >> 16), 0);
-      rt[3] = cp1[3];
-
-      cp1 += 4;
-      cp2 += 4;
-      rt += 4;
-    }
+  apply_line_function_byte(facf0, facf1, x, y, rect1, rect2, out, sub_line_byte);
+}
 
-    if (y == 0) {
-      break;
-    }
-    y--;
+static void sub_line_float(float fac, int x, const float *rt1, const float *rt2, float *rt)
+{
+  const float fac_inv = 1.0f - fac;
 
-    x = xo;
-    while (x--) {
-      const int m = fac3 * (int)cp2[3];
-      rt[0] = max_ii(cp1[0] - ((m * cp2[0]) >> 16), 0);
-      rt[1] = max_ii(cp1[1] - ((m * cp2[1]) >> 16), 0);
-      rt[2] = max_ii(cp1[2] - ((m * cp2[2]) >> 16), 0);
-      rt[3] = cp1[3];
+#ifdef __SSE2__
+  const __m128 fac_inv_v = _mm_set1_ps(fac_inv);
+  const __m128 one = _mm_set1_ps(1.0f);
+  const __m128 zero = _mm_setzero_ps();
+  const __m128 alpha_mask = sse_alpha_mask();
 
-      cp1 += 4;
-      cp2 += 4;
-      rt += 4;
-    }
+  for (int i = 0; i < x; i++, rt1 += 4, rt2 += 4, rt += 4) {
+    const __m128 c1 = _mm_loadu_ps(rt1);
+    const __m128 c2 = _mm_loadu_ps(rt2);
+    const __m128 m = _mm_mul_ps(_mm_sub_ps(one, _mm_mul_ps(sse_splat_alpha(c1), fac_inv_v)),
+                                sse_splat_alpha(c2));
+    const __m128 c = _mm_max_ps(_mm_sub_ps(c1, _mm_mul_ps(m, c2)), zero);
+    _mm_storeu_ps(rt, sse_select(alpha_mask, c1, c));
+  }
+#else
+  for (int i = 0; i < x; i++, rt1 += 4, rt2 += 4, rt += 4) {
+    const float m = (1.0f - (rt1[3] * fac_inv)) * rt2[3];
+    rt[0] = max_ff(rt1[0] - m * rt2[0], 0.0f);
+    rt[1] = max_ff(rt1[1] - m * rt2[1], 0.0f);
+    rt[2] = max_ff(rt1[2] - m * rt2[2], 0.0f);
+    rt[3] = rt1[3];
   }
+#endif
 }
 
 static void do_sub_effect_float(
     float UNUSED(facf0), float facf1, int x, int y, float *rect1, float *rect2, float *out)
 {
-  int xo;
-  float /* fac1, */ fac3_inv;
-  float *rt1, *rt2, *rt;
-
-  xo = x;
-  rt1 = rect1;
-  rt2 = rect2;
-  rt = out;
-
-  /* UNUSED */
-  // fac1 = facf0;
-  fac3_inv = 1.0f - facf1;
-
-  while (y--) {
-    x = xo;
-    while (x--) {
-      const float m = (1.0f - (rt1[3] * fac3_inv)) * rt2[3];
-      rt[0] = max_ff(rt1[0] - m * rt2[0], 0.0f);
-      rt[1] = max_ff(rt1[1] - m * rt2[1], 0.0f);
-      rt[2] = max_ff(rt1[2] - m * rt2[2], 0.0f);
-      rt[3] = rt1[3];
-
-      rt1 += 4;
-      rt2 += 4;
-      rt += 4;
-    }
-
-    if (y == 0) {
-      break;
-    }
-    y--;
-
-    x = xo;
-    while (x--) {
-      const float m = (1.0f - (rt1[3] * fac3_inv)) * rt2[3];
-      rt[0] = max_ff(rt1[0] - m * rt2[0], 0.0f);
-      rt[1] = max_ff(rt1[1] - m * rt2[1], 0.0f);
-      rt[2] = max_ff(rt1[2] - m * rt2[2], 0.0f);
-      rt[3] = rt1[3];
-
-      rt1 += 4;
-      rt2 += 4;
-      rt += 4;
-    }
-  }
+  /* Only facf1 is used for all lines. */
+  apply_line_function_float(facf1, facf1, x, y, rect1, rect2, out, sub_line_float);
 }
 
 static void do_sub_effect(const SeqRenderData *context,
@@ -1409,6 +1380,52 @@ static void do_drop_effect_float(
 
 /*********************** Mul *************************/
 
+/* formula:
+ * fac * (a * b) + (1 - fac) * a  =>  fac * a * (b - 1) + a
+ */
+
+static void mul_line_byte(
+    float fac, int x, const unsigned char *rt1, const unsigned char *rt2, unsigned char *rt)
+{
+  const int fac1 = (int)(256.0f * fac);
+  int i = 0;
+
+#ifdef __SSE2__
+  if (sse_byte_factor_valid(fac1)) {
+    const __m128i fac_v = _mm_set1_epi16(fac1);
+    const __m128i zero = _mm_setzero_si128();
+    const __m128i ones = _mm_set1_epi16(-1);
+    const __m128i c255 = _mm_set1_epi16(255);
+
+    for (; i + 4 <= x; i += 4) {
+      const __m128i c1 = _mm_loadu_si128((const __m128i *)(rt1 + i * 4));
+      const __m128i c2 = _mm_loadu_si128((const __m128i *)(rt2 + i * 4));
+      __m128i result[2];
+
+      for (int half = 0; half < 2; half++) {
+        const __m128i a = half ? _mm_unpackhi_epi8(c1, zero) : _mm_unpacklo_epi8(c1, zero);
+        const __m128i b = half ? _mm_unpackhi_epi8(c2, zero) : _mm_unpacklo_epi8(c2, zero);
+        /* `(fac * a * (b - 255)) >> 16` is minus the rounded up `fac * a * (255 - b) / 65536`. */
+        const __m128i p = _mm_mullo_epi16(a, fac_v);
+        const __m128i q = _mm_sub_epi16(c255, b);
+        const __m128i round_up = _mm_xor_si128(_mm_cmpeq_epi16(_mm_mullo_epi16(p, q), zero), ones);
+        result[half] = _mm_sub_epi16(a, _mm_sub_epi16(_mm_mulhi_epu16(p, q), round_up));
+      }
+      _mm_storeu_si128((__m128i *)(rt + i * 4), _mm_packus_epi16(result[0], result[1]));
+    }
+  }
+#endif
+
+  for (; i < x; i++) {
+    const unsigned char *cp1 = rt1 + i * 4, *cp2 = rt2 + i * 4;
+    unsigned char *cp = rt + i * 4;
+    cp[0] = cp1[0] + ((fac1 * cp1[0] * (cp2[0] - 255)) >> 16);
+    cp[1] = cp1[1] + ((fac1 * cp1[1] * (cp2[1] - 255)) >> 16);
+    cp[2] = cp1[2] + ((fac1 * cp1[2] * (cp2[2] - 255)) >> 16);
+    cp[3] = cp1[3] + ((fac1 * cp1[3] * (cp2[3] - 255)) >> 16);
+  }
+}
+
 static void do_mul_effect_byte(float facf0,
                                float facf1,
                                int x,
@@ -1417,106 +1434,34 @@ static void do_mul_effect_byte(float facf0,
                                unsigned char *rect2,
                                unsigned char *out)
 {
-  int xo, fac1, fac3;
-  unsigned char *rt1, *rt2, *rt;
-
-  xo = x;
-  rt1 = rect1;
-  rt2 = rect2;
-  rt = out;
-
-  fac1 = (int)(256.0f * facf0);
-  fac3 = (int)(256.0f * facf1);
-
-  /* formula:
-   * fac * (a * b) + (1 - fac) * a  => fac * a * (b - 1) + axaux = c * px + py * s; //+centx
-   * yaux = -s * px + c * py; //+centy
-   */
-
-  while (y--) {
-
-    x = xo;
-    while (x--) {
-
-      rt[0] = rt1[0] + ((fac1 * rt1[0] * (rt2[0] - 255)) >> 16);
-      rt[1] = rt1[1] + ((fac1 * rt1[1] * (rt2[1] - 255)) >> 16);
-      rt[2] = rt1[2] + ((fac1 * rt1[2] * (rt2[2] - 255)) >> 16);
-      rt[3] = rt1[3] + ((fac1 * rt1[3] * (rt2[3] - 255)) >> 16);
-
-      rt1 += 4;
-      rt2 += 4;
-      rt += 4;
-    }
-
-    if (y == 0) {
-      break;
-    }
-    y--;
-
-    x = xo;
-    while (x--) {
+  apply_line_function_byte(facf0, facf1, x, y, rect1, rect2, out, mul_line_byte);
+}
 
-      rt[0] = rt1[0] + ((fac3 * rt1[0] * (rt2[0] - 255)) >> 16);
-      rt[1] = rt1[1] + ((fac3 * rt1[1] * (rt2[1] - 255)) >> 16);
-      rt[2] = rt1[2] + ((fac3 * rt1[2] * (rt2[2] - 255)) >> 16);
-      rt[3] = rt1[3] + ((fac3 * rt1[3] * (rt2[3] - 255)) >> 16);
+static void mul_line_float(float fac, int x, const float *rt1, const float *rt2, float *rt)
+{
+#ifdef __SSE2__
+  const __m128 fac_v = _mm_set1_ps(fac);
+  const __m128 one = _mm_set1_ps(1.0f);
 
-      rt1 += 4;
-      rt2 += 4;
-      rt += 4;
-    }
+  for (int i = 0; i < x; i++, rt1 += 4, rt2 += 4, rt += 4) {
+    const __m128 c1 = _mm_loadu_ps(rt1);
+    const __m128 c2 = _mm_loadu_ps(rt2);
+    _mm_storeu_ps(rt, _mm_add_ps(c1, _mm_mul_ps(_mm_mul_ps(fac_v, c1), _mm_sub_ps(c2, one))));
   }
+#else
+  for (int i = 0; i < x; i++, rt1 += 4, rt2 += 4, rt += 4) {
+    rt[0] = rt1[0] + fac * rt1[0] * (rt2[0] - 1.0f);
+    rt[1] = rt1[1] + fac * rt1[1] * (rt2[1] - 1.0f);
+    rt[2] = rt1[2] + fac * rt1[2] * (rt2[2] - 1.0f);
+    rt[3] = rt1[3] + fac * rt1[3] * (rt2[3] - 1.0f);
+  }
+#endif
 }
 
 static void do_mul_effect_float(
     float facf0, float facf1, int x, int y, float *rect1, float *rect2, float *out)
 {
-  int xo;
-  float fac1, fac3;
-  float *rt1, *rt2, *rt;
-
-  xo = x;
-  rt1 = rect1;
-  rt2 = rect2;
-  rt = out;
-
-  fac1 = facf0;
-  fac3 = facf1;
-
-  /* formula:
-   * fac * (a * b) + (1 - fac) * a  =>  fac * a * (b - 1) + a
-   */
-
-  while (y--) {
-    x = xo;
-    while (x--) {
-      rt[0] = rt1[0] + fac1 * rt1[0] * (rt2[0] - 1.0f);
-      rt[1] = rt1[1] + fac1 * rt1[1] * (rt2[1] - 1.0f);
-      rt[2] = rt1[2] + fac1 * rt1[2] * (rt2[2] - 1.0f);
-      rt[3] = rt1[3] + fac1 * rt1[3] * (rt2[3] - 1.0f);
-
-      rt1 += 4;
-      rt2 += 4;
-      rt += 4;
-    }
-
-    if (y == 0) {
-      break;
-    }
-    y--;
-
-    x = xo;
-    while (x--) {
-      rt[0] = rt1[0] + fac3 * rt1[0] * (rt2[0] - 1.0f);
-      rt[1] = rt1[1] + fac3 * rt1[1] * (rt2[1] - 1.0f);
-      rt[2] = rt1[2] + fac3 * rt1[2] * (rt2[2] - 1.0f);
-      rt[3] = rt1[3] + fac3 * rt1[3] * (rt2[3] - 1.0f);
-
-      rt1 += 4;
-      rt2 += 4;
-      rt += 4;
-    }
-  }
+  apply_line_function_float(facf0, facf1, x, y, rect1, rect2, out, mul_line_float);
 }
 
 static void do_mul_effect(const SeqRenderData *context,
@@ -1643,9 +1588,280 @@ BLI_INLINE void apply_blend_function_float(float facf0,
   }
 }
 
+#ifdef __SSE2__
+/* Vector versions of blend_color_*_float for one pixel. `s1` and `s2` are input colors,
+ * `a1` alpha of s1 scaled by effect factor and `t` alpha of s2. Alpha channel of the result
+ * and the no-op case of zero `t` are handled by caller. */
+typedef __m128 (*IMB_blend_func_float_sse)(__m128 s1, __m128 s2, __m128 a1, __m128 t);
+
+BLI_INLINE __m128 sse_blend_mix(__m128 temp, __m128 s1, __m128 t)
+{
+  return _mm_add_ps(_mm_mul_ps(temp, t), _mm_mul_ps(s1, _mm_sub_ps(_mm_set1_ps(1.0f), t)));
+}
+
+BLI_INLINE __m128 blend_color_add_sse(__m128 s1, __m128 s2, __m128 a1, __m128 UNUSED(t))
+{
+  return _mm_add_ps(s1, _mm_mul_ps(s2, a1));
+}
+
+BLI_INLINE __m128 blend_color_sub_sse(__m128 s1, __m128 s2, __m128 a1, __m128 UNUSED(t))
+{
+  return _mm_max_ps(_mm_sub_ps(s1, _mm_mul_ps(s2, a1)), _mm_setzero_ps());
+}
+
+BLI_INLINE __m128 blend_color_mul_sse(__m128 s1, __m128 s2, __m128 a1, __m128 t)
+{
+  const __m128 mt = _mm_sub_ps(_mm_set1_ps(1.0f), t);
+  return _mm_add_ps(_mm_mul_ps(mt, s1), _mm_mul_ps(_mm_mul_ps(s1, s2), a1));
+}
+
+BLI_INLINE __m128 blend_color_lighten_sse(__m128 s1, __m128 s2, __m128 a1, __m128 t)
+{
+  const __m128 mt = _mm_sub_ps(_mm_set1_ps(1.0f), t);
+  const __m128 map_alpha = _mm_div_ps(a1, t);
+  return _mm_add_ps(_mm_mul_ps(mt, s1), _mm_mul_ps(t, _mm_max_ps(s1, _mm_mul_ps(s2, map_alpha))));
+}
+
+BLI_INLINE __m128 blend_color_darken_sse(__m128 s1, __m128 s2, __m128 a1, __m128 t)
+{
+  const __m128 mt = _mm_sub_ps(_mm_set1_ps(1.0f), t);
+  const __m128 map_alpha = _mm_div_ps(a1, t);
+  return _mm_add_ps(_mm_mul_ps(mt, s1), _mm_mul_ps(t, _mm_min_ps(s1, _mm_mul_ps(s2, map_alpha))));
+}
+
+BLI_INLINE __m128 blend_color_overlay_sse(__m128 s1, __m128 s2, __m128 UNUSED(a1), __m128 t)
+{
+  const __m128 one = _mm_set1_ps(1.0f);
+  const __m128 two = _mm_set1_ps(2.0f);
+  const __m128 half = _mm_set1_ps(0.5f);
+  const __m128 high = _mm_sub_ps(
+      one,
+      _mm_mul_ps(_mm_sub_ps(one, _mm_mul_ps(two, _mm_sub_ps(s1, half))), _mm_sub_ps(one, s2)));
+  const __m128 low = _mm_mul_ps(_mm_mul_ps(two, s1), s2);
+  const __m128 temp = sse_select(_mm_cmpgt_ps(s1, half), high, low);
+  return _mm_min_ps(sse_blend_mix(temp, s1, t), one);
+}
+
+BLI_INLINE __m128 blend_color_hardlight_sse(__m128 s1, __m128 s2, __m128 UNUSED(a1), __m128 t)
+{
+  const __m128 one = _mm_set1_ps(1.0f);
+  const __m128 two = _mm_set1_ps(2.0f);
+  const __m128 half = _mm_set1_ps(0.5f);
+  const __m128 high = _mm_sub_ps(
+      one,
+      _mm_mul_ps(_mm_sub_ps(one, _mm_mul_ps(two, _mm_sub_ps(s2, half))), _mm_sub_ps(one, s1)));
+  const __m128 low = _mm_mul_ps(_mm_mul_ps(two, s2), s1);
+  const __m128 temp = sse_select(_mm_cmpgt_ps(s2, half), high, low);
+  return _mm_min_ps(sse_blend_mix(temp, s1, t), one);
+}
+
+BLI_INLINE __m128 blend_color_burn_sse(__m128 s1, __m128 s2, __m128 UNUSED(a1), __m128 t)
+{
+  const __m128 one = _mm_set1_ps(1.0f);
+  const __m128 zero = _mm_setzero_ps();
+  const __m128 burn = _mm_max_ps(_mm_sub_ps(one, _mm_div_ps(_mm_sub_ps(one, s1), s2)), zero);
+  const __m128 temp = sse_select(_mm_cmpeq_ps(s2, zero), zero, burn);
+  return sse_blend_mix(temp, s1, t);
+}
+
+BLI_INLINE __m128 blend_color_linearburn_sse(__m128 s1, __m128 s2, __m128 UNUSED(a1), __m128 t)
+{
+  const __m128 temp = _mm_max_ps(_mm_sub_ps(_mm_add_ps(s1, s2), _mm_set1_ps(1.0f)),
+                                 _mm_setzero_ps());
+  return sse_blend_mix(temp, s1, t);
+}
+
+BLI_INLINE __m128 blend_color_dodge_sse(__m128 s1, __m128 s2, __m128 UNUSED(a1), __m128 t)
+{
+  const __m128 one = _mm_set1_ps(1.0f);
+  const __m128 dodge = _mm_min_ps(_mm_div_ps(s1, _mm_sub_ps(one, s2)), one);
+  const __m128 temp = sse_select(_mm_cmpge_ps(s2, one), one, dodge);
+  return sse_blend_mix(temp, s1, t);
+}
+
+BLI_INLINE __m128 blend_color_screen_sse(__m128 s1, __m128 s2, __m128 UNUSED(a1), __m128 t)
+{
+  const __m128 one = _mm_set1_ps(1.0f);
+  const __m128 temp = _mm_max_ps(
+      _mm_sub_ps(one, _mm_mul_ps(_mm_sub_ps(one, s1), _mm_sub_ps(one, s2))), _mm_setzero_ps());
+  return sse_blend_mix(temp, s1, t);
+}
+
+BLI_INLINE __m128 blend_color_softlight_sse(__m128 s1, __m128 s2, __m128 UNUSED(a1), __m128 t)
+{
+  const __m128 one = _mm_set1_ps(1.0f);
+  const __m128 half = _mm_set1_ps(0.5f);
+  const __m128 s2_half = _mm_add_ps(s2, half);
+  const __m128 low = _mm_mul_ps(s2_half, s1);
+  const __m128 high = _mm_sub_ps(one, _mm_mul_ps(_mm_sub_ps(one, s2_half), _mm_sub_ps(one, s1)));
+  const __m128 temp = sse_select(_mm_cmplt_ps(s1, half), low, high);
+  return sse_blend_mix(temp, s1, t);
+}
+
+BLI_INLINE __m128 blend_color_pinlight_sse(__m128 s1, __m128 s2, __m128 UNUSED(a1), __m128 t)
+{
+  const __m128 two = _mm_set1_ps(2.0f);
+  const __m128 half = _mm_set1_ps(0.5f);
+  const __m128 high = _mm_max_ps(_mm_mul_ps(two, _mm_sub_ps(s2, half)), s1);
+  const __m128 low = _mm_min_ps(_mm_mul_ps(two, s2), s1);
+  const __m128 temp = sse_select(_mm_cmpgt_ps(s2, half), high, low);
+  return sse_blend_mix(temp, s1, t);
+}
+
+BLI_INLINE __m128 blend_color_linearlight_sse(__m128 s1, __m128 s2, __m128 UNUSED(a1), __m128 t)
+{
+  const __m128 one = _mm_set1_ps(1.0f);
+  const __m128 two = _mm_set1_ps(2.0f);
+  const __m128 half = _mm_set1_ps(0.5f);
+  const __m128 high = _mm_min_ps(_mm_add_ps(s1, _mm_mul_ps(two, _mm_sub_ps(s2, half))), one);
+  const __m128 low = _mm_max_ps(_mm_sub_ps(_mm_add_ps(s1, _mm_mul_ps(two, s2)), one),
+                                _mm_setzero_ps());
+  const __m128 temp = sse_select(_mm_cmpgt_ps(s2, half), high, low);
+  return sse_blend_mix(temp, s1, t);
+}
+
+BLI_INLINE __m128 blend_color_vividlight_sse(__m128 s1, __m128 s2, __m128 UNUSED(a1), __m128 t)
+{
+  const __m128 zero = _mm_setzero_ps();
+  const __m128 one = _mm_set1_ps(1.0f);
+  const __m128 two = _mm_set1_ps(2.0f);
+  const __m128 half = _mm_set1_ps(0.5f);
+  const __m128 high = _mm_min_ps(_mm_div_ps(s1, _mm_mul_ps(two, _mm_sub_ps(one, s2))), one);
+  const __m128 low = _mm_max_ps(
+      _mm_sub_ps(one, _mm_div_ps(_mm_sub_ps(one, s1), _mm_mul_ps(two, s2))), zero);
+  __m128 temp = sse_select(_mm_cmpgt_ps(s2, half), high, low);
+  temp = sse_select(_mm_cmpeq_ps(s2, zero), sse_select(_mm_cmpeq_ps(s1, one), half, zero), temp);
+  temp = sse_select(_mm_cmpeq_ps(s2, one), sse_select(_mm_cmpeq_ps(s1, zero), half, one), temp);
+  return sse_blend_mix(temp, s1, t);
+}
+
+BLI_INLINE __m128 blend_color_difference_sse(__m128 s1, __m128 s2, __m128 UNUSED(a1), __m128 t)
+{
+  const __m128 sign_mask = _mm_set1_ps(-0.0f);
+  const __m128 temp = _mm_andnot_ps(sign_mask, _mm_sub_ps(s1, s2));
+  return sse_blend_mix(temp, s1, t);
+}
+
+BLI_INLINE __m128 blend_color_exclusion_sse(__m128 s1, __m128 s2, __m128 UNUSED(a1), __m128 t)
+{
+  const __m128 two = _mm_set1_ps(2.0f);
+  const __m128 half = _mm_set1_ps(0.5f);
+  const __m128 temp = _mm_sub_ps(
+      half, _mm_mul_ps(_mm_mul_ps(two, _mm_sub_ps(s1, half)), _mm_sub_ps(s2, half)));
+  return sse_blend_mix(temp, s1, t);
+}
+
+BLI_INLINE void apply_blend_function_float_sse(float facf0,
+                                               float facf1,
+                                               int x,
+                                               int y,
+                                               const float *rect1,
+                                               const float *rect2,
+                                               float *out,
+                                               IMB_blend_func_float_sse blend_function)
+{
+  const __m128 zero = _mm_setzero_ps();
+  const __m128 alpha_mask = sse_alpha_mask();
+
+  for (int j = 0; j < y; j++) {
+    const __m128 fac = _mm_set1_ps((j & 1) ? facf1 : facf0);
+
+    for (int i = 0; i < x; i++, rect1 += 4, rect2 += 4, out += 4) {
+      const __m128 s1 = _mm_loadu_ps(rect1);
+      const __m128 s2 = _mm_loadu_ps(rect2);
+      const __m128 alpha1 = sse_splat_alpha(s1);
+      const __m128 t = sse_splat_alpha(s2);
+      __m128 c = blend_function(s1, s2, _mm_mul_ps(alpha1, fac), t);
+
+      c = sse_select(_mm_cmpeq_ps(t, zero), s1, c);
+      _mm_storeu_ps(out, sse_select(alpha_mask, alpha1, c));
+    }
+  }
+}
+
+/* Returns false for blend types without vector version. */
+static bool do_blend_effect_float_sse(
+    float facf0, float facf1, int x, int y, float *rect1, float *rect2, int btype, float *out)
+{
+  switch (btype) {
+    case SEQ_TYPE_ADD:
+      apply_blend_function_float_sse(facf0, facf1, x, y, rect1, rect2, out, blend_color_add_sse);
+      return true;
+    case SEQ_TYPE_SUB:
+      apply_blend_function_float_sse(facf0, facf1, x, y, rect1, rect2, out, blend_color_sub_sse);
+      return true;
+    case SEQ_TYPE_MUL:
+      apply_blend_function_float_sse(facf0, facf1, x, y, rect1, rect2, out, blend_color_mul_sse);
+      return true;
+    case SEQ_TYPE_DARKEN:
+      apply_blend_function_float_sse(
+          facf0, facf1, x, y, rect1, rect2, out, blend_color_darken_sse);
+      return true;
+    case SEQ_TYPE_COLOR_BURN:
+      apply_blend_function_float_sse(facf0, facf1, x, y, rect1, rect2, out, blend_color_burn_sse);
+      return true;
+    case SEQ_TYPE_LINEAR_BURN:
+      apply_blend_function_float_sse(
+          facf0, facf1, x, y, rect1, rect2, out, blend_color_linearburn_sse);
+      return true;
+    case SEQ_TYPE_SCREEN:
+      apply_blend_function_float_sse(
+          facf0, facf1, x, y, rect1, rect2, out, blend_color_screen_sse);
+      return true;
+    case SEQ_TYPE_LIGHTEN:
+      apply_blend_function_float_sse(
+          facf0, facf1, x, y, rect1, rect2, out, blend_color_lighten_sse);
+      return true;
+    case SEQ_TYPE_DODGE:
+      apply_blend_function_float_sse(facf0, facf1, x, y, rect1, rect2, out, blend_color_dodge_sse);
+      return true;
+    case SEQ_TYPE_OVERLAY:
+      apply_blend_function_float_sse(
+          facf0, facf1, x, y, rect1, rect2, out, blend_color_overlay_sse);
+      return true;
+    case SEQ_TYPE_SOFT_LIGHT:
+      apply_blend_function_float_sse(
+          facf0, facf1, x, y, rect1, rect2, out, blend_color_softlight_sse);
+      return true;
+    case SEQ_TYPE_HARD_LIGHT:
+      apply_blend_function_float_sse(
+          facf0, facf1, x, y, rect1, rect2, out, blend_color_hardlight_sse);
+      return true;
+    case SEQ_TYPE_PIN_LIGHT:
+      apply_blend_function_float_sse(
+          facf0, facf1, x, y, rect1, rect2, out, blend_color_pinlight_sse);
+      return true;
+    case SEQ_TYPE_LIN_LIGHT:
+      apply_blend_function_float_sse(
+          facf0, facf1, x, y, rect1, rect2, out, blend_color_linearlight_sse);
+      return true;
+    case SEQ_TYPE_VIVID_LIGHT:
+      apply_blend_function_float_sse(
+          facf0, facf1, x, y, rect1, rect2, out, blend_color_vividlight_sse);
+      return true;
+    case SEQ_TYPE_DIFFERENCE:
+      apply_blend_function_float_sse(
+          facf0, facf1, x, y, rect1, rect2, out, blend_color_difference_sse);
+      return true;
+    case SEQ_TYPE_EXCLUSION:
+      apply_blend_function_float_sse(
+          facf0, facf1, x, y, rect1, rect2, out, blend_color_exclusion_sse);
+      return true;
+  }
+  /* Color, hue, saturation and value blending converts to HSV and stays scalar. */
+  return false;
+}
+#endif
+
 static void do_blend_effect_float(
     float facf0, float facf1, int x, int y, float *rect1, float *rect2, int btype, float *out)
 {
+#ifdef __SSE2__
+  if (do_blend_effect_float_sse(facf0, facf1, x, y, rect1, rect2, btype, out)) {
+    return;
+  }
+#endif
+
   switch (btype) {
     case SEQ_TYPE_ADD:
       apply_blend_function_float(facf0, facf1, x, y, rect1, rect2, out, blend_color_add_float);
@@ -24,12 +24,17 @@
 #include <stddef.h>
 #include <time.h>
 
+#include "zlib.h"
+
 #include "MEM_guardedalloc.h"
 
+#include "atomic_ops.h"
+
 #include "DNA_scene_types.h"
 #include "DNA_sequence_types.h"
 #include "DNA_space_types.h" /* for FILE_MAX. */
 
+#include "IMB_cache_manager.h"
 #include "IMB_colormanagement.h"
 #include "IMB_imbuf.h"
 #include "IMB_imbuf_types.h"
@@ -42,12 +47,15 @@
 #include "BLI_listbase.h"
 #include "BLI_mempool.h"
 #include "BLI_path_util.h"
+#include "BLI_task.h"
 #include "BLI_threads.h"
 
 #include "BKE_global.h"
 #include "BKE_main.h"
 #include "BKE_scene.h"
 
+#include "PIL_time.h"
+
 #include "SEQ_prefetch.h"
 #include "SEQ_relations.h"
 #include "SEQ_render.h"
@@ -57,6 +65,15 @@
 #include "prefetch.h"
 #include "strip_time.h"
 
+#ifdef WITH_LZO
+#  ifdef WITH_SYSTEM_LZO
+#    include <lzo/lzo1x.h>
+#  else
+#    include "minilzo.h"
+#  endif
+#  define LZO_OUT_LEN(size) ((size) + (size) / 16 + 64 + 3)
+#endif
+
 /**
  * Sequencer Cache Design Notes
  * ============================
@@ -89,7 +106,13 @@
  * For each cached non-temp image, image data and supplementary info are written to HDD.
  * Multiple(DCACHE_IMAGES_PER_FILE) images share the same file.
  * Each of these files contains header DiskCacheHeader followed by image data.
- * Zlib compression with user definable level can be used to compress image data(per image)
+ * Image data is compressed per image, the codec is chosen by user preferences: LZO for low
+ * compression level and Deflate for high level.
+ * Before compression, bytes of each pixel are shuffled into planes and, unless the image is
+ * a keyframe, stored as difference to previous frame of the same file. Every
+ * DCACHE_DELTA_KEYFRAME_INTERVAL frames a keyframe is written, so a random read decodes at most
+ * that many images. Sequential reads use last decoded image as reference and decode only once.
+ * Compression and writing is done by background task pool, so rendering is not blocked by it.
  * Images are written in order in which they are rendered.
  * Overwriting of individual entry is not possible.
  * Stored images are deleted by invalidation, or when size of all files exceeds maximum
@@ -102,12 +125,20 @@
 /* <cache type>-<resolution X>x<resolution Y>-<rendersize>%(<view_id>)-<frame no>.dcf */
 #define DCACHE_FNAME_FORMAT "%d-%dx%d-%d%%(%d)-%d.dcf"
 #define DCACHE_IMAGES_PER_FILE 100
-#define DCACHE_CURRENT_VERSION 1
+#define DCACHE_CURRENT_VERSION 2
+#define DCACHE_DELTA_KEYFRAME_INTERVAL 8
+/* Images waiting to be written are referenced, so limit their number. */
+#define DCACHE_MAX_PENDING_WRITES 16
+/* Files that are written at the same time keep their own delta reference. */
+#define DCACHE_MAX_DELTA_REFERENCES 8
 #define COLORSPACE_NAME_MAX 64 /* XXX: defined in imb intern */
 
 typedef struct DiskCacheHeaderEntry {
   unsigned char encoding;
+  unsigned char codec;
+  unsigned char filter;
   uint64_t frameno;
+  uint64_t reference_frameno;
   uint64_t size_compressed;
   uint64_t size_raw;
   uint64_t offset;
@@ -118,12 +149,36 @@ typedef struct DiskCacheHeader {
   DiskCacheHeaderEntry entry[DCACHE_IMAGES_PER_FILE];
 } DiskCacheHeader;
 
+/* Last image pushed to write_pool for a file, used as reference for delta coding of the next
+ * frame of the same file. */
+typedef struct DiskCacheDeltaReference {
+  struct DiskCacheDeltaReference *next, *prev;
+  char path[FILE_MAX];
+  struct ImBuf *ibuf;
+  uint64_t frameno;
+  int chain_len;
+} DiskCacheDeltaReference;
+
 typedef struct SeqDiskCache {
   Main *bmain;
   int64_t timestamp;
   ListBase files;
   ThreadMutex read_write_mutex;
   size_t size_total;
+
+  /* Images are compressed and written by this pool. */
+  struct TaskPool *write_pool;
+  unsigned int pending_writes;
+
+  /* DiskCacheDeltaReference of files being written, most recently used first. */
+  ThreadMutex delta_mutex;
+  ListBase delta_references;
+
+  /* Last decoded image data, protected by read_write_mutex. */
+  void *read_data;
+  size_t read_data_size;
+  char read_path[FILE_MAX];
+  uint64_t read_frameno;
 } SeqDiskCache;
 
 typedef struct DiskCacheFile {
@@ -148,11 +203,15 @@ typedef struct SeqCache {
   struct BLI_mempool *items_pool;
   struct SeqCacheKey *last_key;
   SeqDiskCache *disk_cache;
+  struct IMBCacheConsumer *consumer;
 } SeqCache;
 
 typedef struct SeqCacheItem {
   struct SeqCache *cache_owner;
   struct ImBuf *ibuf;
+  /* Size accounted in the cache manager. */
+  size_t size;
+  double last_used;
 } SeqCacheItem;
 
 typedef struct SeqCacheKey {
@@ -164,7 +223,7 @@ typedef struct SeqCacheKey {
   SeqRenderData context;
   float frame_index;    /* Usually same as timeline_frame. Mapped to media for RAW entries. */
   float timeline_frame; /* Only for reference - used for freeing when cache is full. */
-  float cost;           /* In short: render time(s) divided by playback frame duration(s) */
+  float cost;           /* Last render time of the strip in seconds, see #SequenceRuntime. */
   bool is_temp_cache;   /* this cache entry will be freed before rendering next frame */
   /* ID of task for asigning temp cache entries to particular task(thread, etc.) */
   eSeqTaskId task_id;
@@ -182,18 +241,30 @@ static char *seq_disk_cache_base_dir(void)
   return U.sequencer_disk_cache_dir;
 }
 
-static int seq_disk_cache_compression_level(void)
+static int seq_disk_cache_codec(void)
 {
   switch (U.sequencer_disk_cache_compression) {
     case USER_SEQ_DISK_CACHE_COMPRESSION_NONE:
-      return 0;
+      return DCACHE_CODEC_NONE;
     case USER_SEQ_DISK_CACHE_COMPRESSION_LOW:
-      return 1;
+#ifdef WITH_LZO
+      return DCACHE_CODEC_LZO;
+#else
+      return DCACHE_CODEC_DEFLATE;
+#endif
     case USER_SEQ_DISK_CACHE_COMPRESSION_HIGH:
-      return 9;
+      return DCACHE_CODEC_DEFLATE;
   }
 
-  return U.sequencer_disk_cache_compression;
+  return DCACHE_CODEC_DEFLATE;
+}
+
+static int seq_disk_cache_deflate_level(void)
+{
+  if (U.sequencer_disk_cache_compression == USER_SEQ_DISK_CACHE_COMPRESSION_LOW) {
+    return 1;
+  }
+  return 6;
 }
 
 static size_t seq_disk_cache_size_limit(void)
@@ -287,6 +358,10 @@ static DiskCacheFile *seq_disk_cache_get_oldest_file(SeqDiskCache *disk_cache)
 
 static void seq_disk_cache_delete_file(SeqDiskCache *disk_cache, DiskCacheFile *file)
 {
+  /* Decoded data must not be used as delta reference for content of new file. */
+  if (STREQ(disk_cache->read_path, file->path)) {
+    disk_cache->read_path[0] = '\0';
+  }
   disk_cache->size_total -= file->fstat.st_size;
   BLI_delete(file->path, false, false);
   BLI_remlink(&disk_cache->files, file);
@@ -469,6 +544,36 @@ static void seq_disk_cache_delete_invalid_files(SeqDiskCache *disk_cache,
   }
 }
 
+typedef struct DiskCacheWriteTask {
+  SeqDiskCache *disk_cache;
+  char path[FILE_MAX];
+  uint64_t frameno;
+  ImBuf *ibuf;
+  /* Previous frame of same file, NULL for keyframes. */
+  ImBuf *ibuf_reference;
+} DiskCacheWriteTask;
+
+static void seq_disk_cache_delta_reference_free(SeqDiskCache *disk_cache,
+                                               DiskCacheDeltaReference *reference)
+{
+  if (reference->ibuf != NULL) {
+    IMB_freeImBuf(reference->ibuf);
+  }
+  BLI_freelinkN(&disk_cache->delta_references, reference);
+}
+
+/* Wait for pending writes and drop delta references. */
+static void seq_disk_cache_write_flush(SeqDiskCache *disk_cache)
+{
+  BLI_task_pool_work_and_wait(disk_cache->write_pool);
+
+  BLI_mutex_lock(&disk_cache->delta_mutex);
+  while (disk_cache->delta_references.first != NULL) {
+    seq_disk_cache_delta_reference_free(disk_cache, disk_cache->delta_references.first);
+  }
+  BLI_mutex_unlock(&disk_cache->delta_mutex);
+}
+
 static void seq_disk_cache_invalidate(Scene *scene,
                                       Sequence *seq,
                                       Sequence *seq_changed,
@@ -478,6 +583,8 @@ static void seq_disk_cache_invalidate(Scene *scene,
   int end;
   SeqDiskCache *disk_cache = scene->ed->cache->disk_cache;
 
+  seq_disk_cache_write_flush(disk_cache);
+
   BLI_mutex_lock(&disk_cache->read_write_mutex);
 
   start = seq_changed->startdisp - DCACHE_IMAGES_PER_FILE;
@@ -488,29 +595,148 @@ static void seq_disk_cache_invalidate(Scene *scene,
   BLI_mutex_unlock(&disk_cache->read_write_mutex);
 }
 
-static size_t deflate_imbuf_to_file(ImBuf *ibuf,
-                                    FILE *file,
-                                    int level,
-                                    DiskCacheHeaderEntry *header_entry)
+static size_t seq_disk_cache_imbuf_data_size(ImBuf *ibuf)
 {
   if (ibuf->rect) {
-    return BLI_gzip_mem_to_file_at_pos(
-        ibuf->rect, header_entry->size_raw, file, header_entry->offset, level);
+    return (size_t)ibuf->x * ibuf->y * ibuf->channels;
+  }
+  return (size_t)ibuf->x * ibuf->y * ibuf->channels * 4;
+}
+
+/* Split 4 byte elements of `src` into byte planes. When `ref` is given, difference to it is
+ * stored, per channel for byte images and per bit pattern of float values, so the filter is
+ * lossless. */
+void seq_disk_cache_filter_encode(unsigned char *dst,
+                                  const unsigned char *src,
+                                  const unsigned char *ref,
+                                  size_t size,
+                                  bool is_float)
+{
+  const size_t elem_len = size / 4;
+
+  for (size_t i = 0; i < elem_len; i++) {
+    const unsigned char *s = src + i * 4;
+
+    if (ref == NULL) {
+      for (int b = 0; b < 4; b++) {
+        dst[b * elem_len + i] = s[b];
+      }
+    }
+    else if (is_float) {
+      uint32_t value, value_ref;
+      memcpy(&value, s, sizeof(value));
+      memcpy(&value_ref, ref + i * 4, sizeof(value_ref));
+      value -= value_ref;
+      for (int b = 0; b < 4; b++) {
+        dst[b * elem_len + i] = (value >> (b * 8)) & 0xff;
+      }
+    }
+    else {
+      const unsigned char *r = ref + i * 4;
+      for (int b = 0; b < 4; b++) {
+        dst[b * elem_len + i] = s[b] - r[b];
+      }
+    }
   }
 
-  return BLI_gzip_mem_to_file_at_pos(
-      ibuf->rect_float, header_entry->size_raw, file, header_entry->offset, level);
+  for (size_t i = elem_len * 4; i < size; i++) {
+    dst[i] = ref ? src[i] - ref[i] : src[i];
+  }
 }
 
-static size_t inflate_file_to_imbuf(ImBuf *ibuf, FILE *file, DiskCacheHeaderEntry *header_entry)
+void seq_disk_cache_filter_decode(unsigned char *dst,
+                                  const unsigned char *src,
+                                  const unsigned char *ref,
+                                  size_t size,
+                                  bool is_float)
 {
-  if (ibuf->rect) {
-    return BLI_ungzip_file_to_mem_at_pos(
-        ibuf->rect, header_entry->size_raw, file, header_entry->offset);
+  const size_t elem_len = size / 4;
+
+  for (size_t i = 0; i < elem_len; i++) {
+    unsigned char *d = dst + i * 4;
+
+    if (ref == NULL) {
+      for (int b = 0; b < 4; b++) {
+        d[b] = src[b * elem_len + i];
+      }
+    }
+    else if (is_float) {
+      uint32_t value = 0, value_ref;
+      for (int b = 0; b < 4; b++) {
+        value |= (uint32_t)src[b * elem_len + i] << (b * 8);
+      }
+      memcpy(&value_ref, ref + i * 4, sizeof(value_ref));
+      value += value_ref;
+      memcpy(d, &value, sizeof(value));
+    }
+    else {
+      const unsigned char *r = ref + i * 4;
+      for (int b = 0; b < 4; b++) {
+        d[b] = src[b * elem_len + i] + r[b];
+      }
+    }
+  }
+
+  for (size_t i = elem_len * 4; i < size; i++) {
+    dst[i] = ref ? src[i] + ref[i] : src[i];
   }
+}
+
+size_t seq_disk_cache_compress_bound(int codec, size_t size)
+{
+  switch (codec) {
+    case DCACHE_CODEC_DEFLATE:
+      return compressBound(size);
+#ifdef WITH_LZO
+    case DCACHE_CODEC_LZO:
+      return LZO_OUT_LEN(size);
+#endif
+  }
+  return size;
+}
 
-  return BLI_ungzip_file_to_mem_at_pos(
-      ibuf->rect_float, header_entry->size_raw, file, header_entry->offset);
+/* Returns size of compressed data, 0 on failure. */
+size_t seq_disk_cache_compress(
+    int codec, const unsigned char *src, size_t size, unsigned char *dst, size_t dst_size)
+{
+  switch (codec) {
+    case DCACHE_CODEC_DEFLATE: {
+      uLongf dst_len = dst_size;
+      if (compress2(dst, &dst_len, src, size, seq_disk_cache_deflate_level()) != Z_OK) {
+        return 0;
+      }
+      return dst_len;
+    }
+#ifdef WITH_LZO
+    case DCACHE_CODEC_LZO: {
+      void *wrkmem = MEM_mallocN(LZO1X_1_MEM_COMPRESS, "seq disk cache lzo wrkmem");
+      lzo_uint dst_len = dst_size;
+      int r = lzo1x_1_compress(src, (lzo_uint)size, dst, &dst_len, wrkmem);
+      MEM_freeN(wrkmem);
+      return (r == LZO_E_OK) ? dst_len : 0;
+    }
+#endif
+  }
+  return 0;
+}
+
+bool seq_disk_cache_decompress(
+    int codec, const unsigned char *src, size_t size, unsigned char *dst, size_t dst_size)
+{
+  switch (codec) {
+    case DCACHE_CODEC_DEFLATE: {
+      uLongf dst_len = dst_size;
+      return uncompress(dst, &dst_len, src, size) == Z_OK && dst_len == dst_size;
+    }
+#ifdef WITH_LZO
+    case DCACHE_CODEC_LZO: {
+      lzo_uint dst_len = dst_size;
+      int r = lzo1x_decompress_safe(src, (lzo_uint)size, dst, &dst_len, NULL);
+      return r == LZO_E_OK && dst_len == dst_size;
+    }
+#endif
+  }
+  return false;
 }
 
 static bool seq_disk_cache_read_header(FILE *file, DiskCacheHeader *header)
@@ -525,6 +751,7 @@ static bool seq_disk_cache_read_header(FILE *file, DiskCacheHeader *header)
   for (int i = 0; i < DCACHE_IMAGES_PER_FILE; i++) {
     if ((ENDIAN_ORDER == B_ENDIAN) && header->entry[i].encoding == 0) {
       BLI_endian_switch_uint64(&header->entry[i].frameno);
+      BLI_endian_switch_uint64(&header->entry[i].reference_frameno);
       BLI_endian_switch_uint64(&header->entry[i].offset);
       BLI_endian_switch_uint64(&header->entry[i].size_compressed);
       BLI_endian_switch_uint64(&header->entry[i].size_raw);
@@ -540,7 +767,7 @@ static size_t seq_disk_cache_write_header(FILE *file, DiskCacheHeader *header)
   return fwrite(header, sizeof(*header), 1, file);
 }
 
-static int seq_disk_cache_add_header_entry(SeqCacheKey *key, ImBuf *ibuf, DiskCacheHeader *header)
+static int seq_disk_cache_add_header_entry(uint64_t frameno, ImBuf *ibuf, DiskCacheHeader *header)
 {
   int i;
   uint64_t offset = sizeof(*header);
@@ -573,16 +800,15 @@ static int seq_disk_cache_add_header_entry(SeqCacheKey *key, ImBuf *ibuf, DiskCa
   }
 
   header->entry[i].offset = offset;
-  header->entry[i].frameno = key->frame_index;
+  header->entry[i].frameno = frameno;
+  header->entry[i].size_raw = seq_disk_cache_imbuf_data_size(ibuf);
 
   /* Store colorspace name of ibuf. */
   const char *colorspace_name;
   if (ibuf->rect) {
-    header->entry[i].size_raw = ibuf->x * ibuf->y * ibuf->channels;
     colorspace_name = IMB_colormanagement_get_rect_colorspace(ibuf);
   }
   else {
-    header->entry[i].size_raw = ibuf->x * ibuf->y * ibuf->channels * 4;
     colorspace_name = IMB_colormanagement_get_float_colorspace(ibuf);
   }
   BLI_strncpy(
@@ -591,10 +817,10 @@ static int seq_disk_cache_add_header_entry(SeqCacheKey *key, ImBuf *ibuf, DiskCa
   return i;
 }
 
-static int seq_disk_cache_get_header_entry(SeqCacheKey *key, DiskCacheHeader *header)
+static int seq_disk_cache_get_header_entry(uint64_t frameno, DiskCacheHeader *header)
 {
   for (int i = 0; i < DCACHE_IMAGES_PER_FILE; i++) {
-    if (header->entry[i].frameno == key->frame_index) {
+    if (header->entry[i].size_compressed != 0 && header->entry[i].frameno == frameno) {
       return i;
     }
   }
@@ -602,20 +828,23 @@ static int seq_disk_cache_get_header_entry(SeqCacheKey *key, DiskCacheHeader *he
   return -1;
 }
 
-static bool seq_disk_cache_write_file(SeqDiskCache *disk_cache, SeqCacheKey *key, ImBuf *ibuf)
+/* Write already encoded data, must be called with read_write_mutex locked. */
+static bool seq_disk_cache_write_entry(SeqDiskCache *disk_cache,
+                                       DiskCacheWriteTask *task,
+                                       int codec,
+                                       int filter,
+                                       const void *data,
+                                       size_t size)
 {
-  char path[FILE_MAX];
+  BLI_make_existing_file(task->path);
 
-  seq_disk_cache_get_file_path(disk_cache, key, path, sizeof(path));
-  BLI_make_existing_file(path);
-
-  FILE *file = BLI_fopen(path, "rb+");
+  FILE *file = BLI_fopen(task->path, "rb+");
   if (!file) {
-    file = BLI_fopen(path, "wb+");
+    file = BLI_fopen(task->path, "wb+");
     if (!file) {
       return false;
     }
-    seq_disk_cache_add_file_to_list(disk_cache, path);
+    seq_disk_cache_add_file_to_list(disk_cache, task->path);
   }
 
   DiskCacheHeader header;
@@ -624,24 +853,274 @@ static bool seq_disk_cache_write_file(SeqDiskCache *disk_cache, SeqCacheKey *key
     fclose(file);
     return false;
   }
-  int entry_index = seq_disk_cache_add_header_entry(key, ibuf, &header);
+  int entry_index = seq_disk_cache_add_header_entry(task->frameno, task->ibuf, &header);
+  DiskCacheHeaderEntry *entry = &header.entry[entry_index];
+  entry->codec = codec;
+  entry->filter = filter;
+  entry->reference_frameno = (filter & DCACHE_FILTER_DELTA) ? task->frameno - 1 : 0;
 
-  size_t bytes_written = deflate_imbuf_to_file(
-      ibuf, file, seq_disk_cache_compression_level(), &header.entry[entry_index]);
+  /* Header was reset, so file content no longer matches last decoded image. */
+  if (entry_index == 0 && STREQ(disk_cache->read_path, task->path)) {
+    disk_cache->read_path[0] = '\0';
+  }
 
-  if (bytes_written != 0) {
+  bool success = false;
+  if (fseek(file, entry->offset, SEEK_SET) == 0 && fwrite(data, 1, size, file) == size) {
     /* Last step is writing header, as image data can be overwritten,
      * but missing data would cause problems.
      */
-    header.entry[entry_index].size_compressed = bytes_written;
+    entry->size_compressed = size;
     seq_disk_cache_write_header(file, &header);
-    seq_disk_cache_update_file(disk_cache, path);
-    fclose(file);
+    success = true;
+  }
+  fclose(file);
 
-    return true;
+  if (success) {
+    seq_disk_cache_update_file(disk_cache, task->path);
   }
 
-  return false;
+  return success;
+}
+
+static bool seq_disk_cache_write_file(SeqDiskCache *disk_cache, DiskCacheWriteTask *task)
+{
+  ImBuf *ibuf = task->ibuf;
+  const bool is_float = ibuf->rect == NULL;
+  const unsigned char *data = is_float ? (unsigned char *)ibuf->rect_float :
+                                         (unsigned char *)ibuf->rect;
+  const unsigned char *data_ref = NULL;
+  if (task->ibuf_reference) {
+    data_ref = is_float ? (unsigned char *)task->ibuf_reference->rect_float :
+                          (unsigned char *)task->ibuf_reference->rect;
+  }
+
+  const size_t size_raw = seq_disk_cache_imbuf_data_size(ibuf);
+  int codec = seq_disk_cache_codec();
+  int filter = 0;
+  unsigned char *filtered = NULL;
+  unsigned char *compressed = NULL;
+  const void *write_data = data;
+  size_t write_size = size_raw;
+
+  /* Encoding is done without lock, only file access is serialized. */
+  if (codec != DCACHE_CODEC_NONE) {
+    filter = DCACHE_FILTER_SHUFFLE | (data_ref ? DCACHE_FILTER_DELTA : 0);
+    filtered = MEM_mallocN(size_raw, "seq disk cache filtered");
+    seq_disk_cache_filter_encode(filtered, data, data_ref, size_raw, is_float);
+
+    const size_t compressed_size_max = seq_disk_cache_compress_bound(codec, size_raw);
+    compressed = MEM_mallocN(compressed_size_max, "seq disk cache compressed");
+    write_size = seq_disk_cache_compress(
+        codec, filtered, size_raw, compressed, compressed_size_max);
+    write_data = compressed;
+
+    /* Incompressible data is stored filtered only. */
+    if (write_size == 0 || write_size >= size_raw) {
+      codec = DCACHE_CODEC_NONE;
+      write_data = filtered;
+      write_size = size_raw;
+    }
+  }
+
+  BLI_mutex_lock(&disk_cache->read_write_mutex);
+  bool success = seq_disk_cache_write_entry(
+      disk_cache, task, codec, filter, write_data, write_size);
+  BLI_mutex_unlock(&disk_cache->read_write_mutex);
+
+  MEM_SAFE_FREE(filtered);
+  MEM_SAFE_FREE(compressed);
+
+  return success;
+}
+
+static void seq_disk_cache_write_task(TaskPool *__restrict UNUSED(pool), void *taskdata)
+{
+  DiskCacheWriteTask *task = taskdata;
+  SeqDiskCache *disk_cache = task->disk_cache;
+
+  seq_disk_cache_write_file(disk_cache, task);
+  seq_disk_cache_enforce_limits(disk_cache);
+  atomic_sub_and_fetch_uint32(&disk_cache->pending_writes, 1);
+}
+
+static void seq_disk_cache_write_task_free(TaskPool *__restrict UNUSED(pool), void *taskdata)
+{
+  DiskCacheWriteTask *task = taskdata;
+  IMB_freeImBuf(task->ibuf);
+  if (task->ibuf_reference) {
+    IMB_freeImBuf(task->ibuf_reference);
+  }
+  MEM_freeN(task);
+}
+
+/* Get delta reference of the file, must be called with delta_mutex locked. */
+static DiskCacheDeltaReference *seq_disk_cache_delta_reference_ensure(SeqDiskCache *disk_cache,
+                                                                      const char *path)
+{
+  DiskCacheDeltaReference *reference = BLI_findstring(
+      &disk_cache->delta_references, path, offsetof(DiskCacheDeltaReference, path));
+
+  if (reference != NULL) {
+    BLI_remlink(&disk_cache->delta_references, reference);
+  }
+  else {
+    reference = MEM_callocN(sizeof(*reference), "DiskCacheDeltaReference");
+    BLI_strncpy(reference->path, path, sizeof(reference->path));
+
+    if (BLI_listbase_count_at_most(&disk_cache->delta_references, DCACHE_MAX_DELTA_REFERENCES) ==
+        DCACHE_MAX_DELTA_REFERENCES) {
+      seq_disk_cache_delta_reference_free(disk_cache, disk_cache->delta_references.last);
+    }
+  }
+  BLI_addhead(&disk_cache->delta_references, reference);
+
+  return reference;
+}
+
+static bool seq_disk_cache_can_delta_code(DiskCacheDeltaReference *reference,
+                                          DiskCacheWriteTask *task)
+{
+  ImBuf *ibuf = task->ibuf;
+  ImBuf *ibuf_prev = reference->ibuf;
+
+  return ibuf_prev != NULL && reference->chain_len < DCACHE_DELTA_KEYFRAME_INTERVAL - 1 &&
+         reference->frameno + 1 == task->frameno && ibuf_prev->x == ibuf->x &&
+         ibuf_prev->y == ibuf->y && ibuf_prev->channels == ibuf->channels &&
+         (ibuf_prev->rect != NULL) == (ibuf->rect != NULL);
+}
+
+/* Queue image to be compressed and written in background. */
+static void seq_disk_cache_write_push(SeqDiskCache *disk_cache, SeqCacheKey *key, ImBuf *ibuf)
+{
+  DiskCacheWriteTask *task = MEM_callocN(sizeof(*task), "DiskCacheWriteTask");
+  task->disk_cache = disk_cache;
+  task->frameno = key->frame_index;
+  task->ibuf = ibuf;
+  IMB_refImBuf(ibuf);
+  seq_disk_cache_get_file_path(disk_cache, key, task->path, sizeof(task->path));
+
+  /* Previous frame of same file is reference for this one, ownership is passed to task. */
+  BLI_mutex_lock(&disk_cache->delta_mutex);
+  DiskCacheDeltaReference *reference = seq_disk_cache_delta_reference_ensure(disk_cache,
+                                                                            task->path);
+  if (seq_disk_cache_can_delta_code(reference, task)) {
+    task->ibuf_reference = reference->ibuf;
+    reference->chain_len++;
+  }
+  else {
+    if (reference->ibuf != NULL) {
+      IMB_freeImBuf(reference->ibuf);
+    }
+    reference->chain_len = 0;
+  }
+  IMB_refImBuf(ibuf);
+  reference->ibuf = ibuf;
+  reference->frameno = task->frameno;
+  BLI_mutex_unlock(&disk_cache->delta_mutex);
+
+  const uint pending_writes = atomic_add_and_fetch_uint32(&disk_cache->pending_writes, 1);
+  BLI_task_pool_push(disk_cache->write_pool,
+                     seq_disk_cache_write_task,
+                     task,
+                     true,
+                     seq_disk_cache_write_task_free);
+
+  if (pending_writes > DCACHE_MAX_PENDING_WRITES) {
+    BLI_task_pool_work_and_wait(disk_cache->write_pool);
+  }
+}
+
+/* Decode image data of entry into `r_data`, resolving delta references recursively. */
+static bool seq_disk_cache_read_entry_data(SeqDiskCache *disk_cache,
+                                           FILE *file,
+                                           const char *path,
+                                           DiskCacheHeader *header,
+                                           int entry_index,
+                                           bool is_float,
+                                           unsigned char *r_data,
+                                           int depth)
+{
+  DiskCacheHeaderEntry *entry = &header->entry[entry_index];
+  const size_t size_raw = entry->size_raw;
+
+  if (fseek(file, entry->offset, SEEK_SET) != 0) {
+    return false;
+  }
+
+  if (entry->codec == DCACHE_CODEC_NONE && entry->filter == 0) {
+    return entry->size_compressed == size_raw && fread(r_data, 1, size_raw, file) == size_raw;
+  }
+
+  unsigned char *compressed = MEM_mallocN(entry->size_compressed, "seq disk cache compressed");
+  unsigned char *filtered = NULL;
+  unsigned char *data_ref = NULL;
+  bool success = false;
+
+  if (fread(compressed, 1, entry->size_compressed, file) != entry->size_compressed) {
+    goto finally;
+  }
+
+  if (entry->codec == DCACHE_CODEC_NONE) {
+    if (entry->size_compressed != size_raw) {
+      goto finally;
+    }
+    SWAP(unsigned char *, filtered, compressed);
+  }
+  else {
+    filtered = MEM_mallocN(size_raw, "seq disk cache filtered");
+    if (!seq_disk_cache_decompress(
+            entry->codec, compressed, entry->size_compressed, filtered, size_raw)) {
+      goto finally;
+    }
+  }
+
+  const unsigned char *reference = NULL;
+  if (entry->filter & DCACHE_FILTER_DELTA) {
+    if (disk_cache->read_data != NULL && disk_cache->read_data_size == size_raw &&
+        disk_cache->read_frameno == entry->reference_frameno &&
+        STREQ(disk_cache->read_path, path)) {
+      reference = disk_cache->read_data;
+    }
+    else {
+      int ref_index = seq_disk_cache_get_header_entry(entry->reference_frameno, header);
+      if (ref_index < 0 || ref_index == entry_index || depth >= DCACHE_DELTA_KEYFRAME_INTERVAL ||
+          header->entry[ref_index].size_raw != size_raw) {
+        goto finally;
+      }
+      data_ref = MEM_mallocN(size_raw, "seq disk cache reference");
+      if (!seq_disk_cache_read_entry_data(
+              disk_cache, file, path, header, ref_index, is_float, data_ref, depth + 1)) {
+        goto finally;
+      }
+      reference = data_ref;
+    }
+  }
+
+  seq_disk_cache_filter_decode(r_data, filtered, reference, size_raw, is_float);
+  success = true;
+
+finally:
+  MEM_SAFE_FREE(compressed);
+  MEM_SAFE_FREE(filtered);
+  MEM_SAFE_FREE(data_ref);
+  return success;
+}
+
+/* Keep decoded data, so next frame can be decoded without decoding its reference. */
+static void seq_disk_cache_store_read_data(SeqDiskCache *disk_cache,
+                                           const char *path,
+                                           uint64_t frameno,
+                                           const void *data,
+                                           size_t size)
+{
+  if (disk_cache->read_data_size != size) {
+    MEM_SAFE_FREE(disk_cache->read_data);
+    disk_cache->read_data = MEM_mallocN(size, "seq disk cache read data");
+    disk_cache->read_data_size = size;
+  }
+  memcpy(disk_cache->read_data, data, size);
+  disk_cache->read_frameno = frameno;
+  BLI_strncpy(disk_cache->read_path, path, sizeof(disk_cache->read_path));
 }
 
 static ImBuf *seq_disk_cache_read_file(SeqDiskCache *disk_cache, SeqCacheKey *key)
@@ -661,7 +1140,7 @@ static ImBuf *seq_disk_cache_read_file(SeqDiskCache *disk_cache, SeqCacheKey *ke
     fclose(file);
     return NULL;
   }
-  int entry_index = seq_disk_cache_get_header_entry(key, &header);
+  int entry_index = seq_disk_cache_get_header_entry(key->frame_index, &header);
 
   /* Item not found. */
   if (entry_index < 0) {
@@ -670,33 +1149,38 @@ static ImBuf *seq_disk_cache_read_file(SeqDiskCache *disk_cache, SeqCacheKey *ke
   }
 
   ImBuf *ibuf;
+  unsigned char *data;
   uint64_t size_char = (uint64_t)key->context.rectx * key->context.recty * 4;
   uint64_t size_float = (uint64_t)key->context.rectx * key->context.recty * 16;
-  size_t expected_size;
+  DiskCacheHeaderEntry *entry = &header.entry[entry_index];
 
-  if (header.entry[entry_index].size_raw == size_char) {
-    expected_size = size_char;
+  if (entry->size_raw == size_char) {
     ibuf = IMB_allocImBuf(key->context.rectx, key->context.recty, 32, IB_rect);
-    IMB_colormanagement_assign_rect_colorspace(ibuf, header.entry[entry_index].colorspace_name);
+    IMB_colormanagement_assign_rect_colorspace(ibuf, entry->colorspace_name);
+    data = (unsigned char *)ibuf->rect;
   }
-  else if (header.entry[entry_index].size_raw == size_float) {
-    expected_size = size_float;
+  else if (entry->size_raw == size_float) {
     ibuf = IMB_allocImBuf(key->context.rectx, key->context.recty, 32, IB_rectfloat);
-    IMB_colormanagement_assign_float_colorspace(ibuf, header.entry[entry_index].colorspace_name);
+    IMB_colormanagement_assign_float_colorspace(ibuf, entry->colorspace_name);
+    data = (unsigned char *)ibuf->rect_float;
   }
   else {
     fclose(file);
     return NULL;
   }
 
-  size_t bytes_read = inflate_file_to_imbuf(ibuf, file, &header.entry[entry_index]);
-
-  /* Sanity check. */
-  if (bytes_read != expected_size) {
+  const bool is_float = ibuf->rect_float != NULL;
+  if (!seq_disk_cache_read_entry_data(
+          disk_cache, file, path, &header, entry_index, is_float, data, 0)) {
     fclose(file);
     IMB_freeImBuf(ibuf);
     return NULL;
   }
+
+  if (entry->filter & DCACHE_FILTER_SHUFFLE) {
+    seq_disk_cache_store_read_data(disk_cache, path, entry->frameno, data, entry->size_raw);
+  }
+
   BLI_file_touch(path);
   seq_disk_cache_update_file(disk_cache, path);
   fclose(file);
@@ -708,6 +1192,8 @@ static ImBuf *seq_disk_cache_read_file(SeqDiskCache *disk_cache, SeqCacheKey *ke
 #undef DCACHE_IMAGES_PER_FILE
 #undef COLORSPACE_NAME_MAX
 #undef DCACHE_CURRENT_VERSION
+#undef DCACHE_DELTA_KEYFRAME_INTERVAL
+#undef DCACHE_MAX_PENDING_WRITES
 
 static bool seq_cmp_render_data(const SeqRenderData *a, const SeqRenderData *b)
 {
@@ -797,11 +1283,6 @@ static void seq_cache_unlock(Scene *scene)
   }
 }
 
-static size_t seq_cache_get_mem_total(void)
-{
-  return ((size_t)U.memcachelimit) * 1024 * 1024;
-}
-
 static void seq_cache_keyfree(void *val)
 {
   SeqCacheKey *key = val;
@@ -813,6 +1294,7 @@ static void seq_cache_valfree(void *val)
   SeqCacheItem *item = (SeqCacheItem *)val;
 
   if (item->ibuf) {
+    IMB_cache_memory_sub(IMB_CACHE_TYPE_SEQUENCER, item->size);
     IMB_freeImBuf(item->ibuf);
   }
 
@@ -825,11 +1307,14 @@ static void seq_cache_put_ex(SeqCache *cache, SeqCacheKey *key, ImBuf *ibuf)
   item = BLI_mempool_alloc(cache->items_pool);
   item->cache_owner = cache;
   item->ibuf = ibuf;
+  item->size = IMB_get_size_in_memory(ibuf);
+  item->last_used = PIL_check_seconds_timer();
 
   if (BLI_ghash_reinsert(cache->hash, key, item, seq_cache_keyfree, seq_cache_valfree)) {
     IMB_refImBuf(ibuf);
     cache->last_key = key;
   }
+  IMB_cache_memory_add(IMB_CACHE_TYPE_SEQUENCER, item->size);
 }
 
 static ImBuf *seq_cache_get_ex(SeqCache *cache, SeqCacheKey *key)
@@ -838,6 +1323,7 @@ static ImBuf *seq_cache_get_ex(SeqCache *cache, SeqCacheKey *key)
 
   if (item && item->ibuf) {
     IMB_refImBuf(item->ibuf);
+    item->last_used = PIL_check_seconds_timer();
 
     return item->ibuf;
   }
@@ -997,33 +1483,65 @@ static SeqCacheKey *seq_cache_get_item_for_removal(Scene *scene)
   return finalkey;
 }
 
-/* Find only "base" keys.
- * Sources(other types) for a frame must be freed all at once.
- */
-bool seq_cache_recycle_item(Scene *scene)
+/* Cache manager callbacks, called with the cache locked.
+ * Only "base" keys are evicted, sources (other types) for a frame must be freed all at once. */
+static bool seq_cache_candidate(void *userdata, IMBCacheCandidate *r_candidate)
 {
+  Scene *scene = userdata;
   SeqCache *cache = seq_cache_get_from_scene(scene);
-  if (!cache) {
+  SeqCacheKey *finalkey = seq_cache_get_item_for_removal(scene);
+
+  if (finalkey == NULL) {
     return false;
   }
 
-  seq_cache_lock(scene);
+  r_candidate->size = 0;
+  r_candidate->cost = 0.0f;
+  r_candidate->last_used = 0.0;
 
-  while (seq_cache_is_full()) {
-    SeqCacheKey *finalkey = seq_cache_get_item_for_removal(scene);
-
-    if (finalkey) {
-      seq_cache_recycle_linked(scene, finalkey);
+  for (SeqCacheKey *key = finalkey; key; key = key->link_prev) {
+    SeqCacheItem *item = BLI_ghash_lookup(cache->hash, key);
+    if (item) {
+      r_candidate->size += item->size;
+      r_candidate->last_used = max_dd(r_candidate->last_used, item->last_used);
     }
-    else {
-      seq_cache_unlock(scene);
-      return false;
+    /* Keys of a strip are linked next to each other, count its render time once. */
+    if (key->link_prev == NULL || key->link_prev->seq != key->seq) {
+      r_candidate->cost += key->cost;
     }
   }
-  seq_cache_unlock(scene);
+
+  return true;
+}
+
+static bool seq_cache_evict(void *userdata)
+{
+  Scene *scene = userdata;
+  SeqCacheKey *finalkey = seq_cache_get_item_for_removal(scene);
+
+  if (finalkey == NULL) {
+    return false;
+  }
+
+  seq_cache_recycle_linked(scene, finalkey);
   return true;
 }
 
+/* Free items of this or other caches until the memory limit is respected. */
+bool seq_cache_recycle_item(Scene *scene)
+{
+  SeqCache *cache = seq_cache_get_from_scene(scene);
+  if (!cache) {
+    return false;
+  }
+
+  seq_cache_lock(scene);
+  const bool result = IMB_cache_enforce_limits(&cache->iterator_mutex, 0);
+  seq_cache_unlock(scene);
+
+  return result;
+}
+
 static void seq_cache_set_temp_cache_linked(Scene *scene, SeqCacheKey *base)
 {
   SeqCache *cache = seq_cache_get_from_scene(scene);
@@ -1064,6 +1582,9 @@ static void seq_disk_cache_create(Main *bmain, Scene *scene)
   cache->disk_cache = MEM_callocN(sizeof(SeqDiskCache), "SeqDiskCache");
   cache->disk_cache->bmain = bmain;
   BLI_mutex_init(&cache->disk_cache->read_write_mutex);
+  BLI_mutex_init(&cache->disk_cache->delta_mutex);
+  cache->disk_cache->write_pool = BLI_task_pool_create_background(cache->disk_cache,
+                                                                  TASK_PRIORITY_LOW);
   seq_disk_cache_handle_versioning(cache->disk_cache);
   seq_disk_cache_get_files(cache->disk_cache, seq_disk_cache_base_dir());
   cache->disk_cache->timestamp = scene->ed->disk_cache_timestamp;
@@ -1081,6 +1602,11 @@ static void seq_cache_create(Main *bmain, Scene *scene)
     cache->last_key = NULL;
     cache->bmain = bmain;
     BLI_mutex_init(&cache->iterator_mutex);
+    cache->consumer = IMB_cache_consumer_add(IMB_CACHE_TYPE_SEQUENCER,
+                                             &cache->iterator_mutex,
+                                             seq_cache_candidate,
+                                             seq_cache_evict,
+                                             scene);
     scene->ed->cache = cache;
 
     if (scene->ed->disk_cache_timestamp == 0) {
@@ -1127,14 +1653,19 @@ void seq_cache_destruct(Scene *scene)
     return;
   }
 
+  IMB_cache_consumer_remove(cache->consumer);
   BLI_ghash_free(cache->hash, seq_cache_keyfree, seq_cache_valfree);
   BLI_mempool_destroy(cache->keys_pool);
   BLI_mempool_destroy(cache->items_pool);
   BLI_mutex_end(&cache->iterator_mutex);
 
   if (cache->disk_cache != NULL) {
+    seq_disk_cache_write_flush(cache->disk_cache);
+    BLI_task_pool_free(cache->disk_cache->write_pool);
+    MEM_SAFE_FREE(cache->disk_cache->read_data);
     BLI_freelistN(&cache->disk_cache->files);
     BLI_mutex_end(&cache->disk_cache->read_write_mutex);
+    BLI_mutex_end(&cache->disk_cache->delta_mutex);
     MEM_freeN(cache->disk_cache);
   }
 
@@ -1235,11 +1766,12 @@ void seq_cache_cleanup_sequence(Scene *scene,
   seq_cache_unlock(scene);
 }
 
-struct ImBuf *seq_cache_get(const SeqRenderData *context,
-                            Sequence *seq,
-                            float timeline_frame,
-                            int type,
-                            bool skip_disk_cache)
+static struct ImBuf *seq_cache_lookup(const SeqRenderData *context,
+                                      Sequence *seq,
+                                      float timeline_frame,
+                                      int type,
+                                      bool skip_disk_cache,
+                                      bool use_stats)
 {
 
   if (context->skip_cache || context->is_proxy_render || !seq) {
@@ -1278,6 +1810,15 @@ struct ImBuf *seq_cache_get(const SeqRenderData *context,
   }
   seq_cache_unlock(scene);
 
+  if (use_stats) {
+    if (ibuf) {
+      IMB_cache_hit(IMB_CACHE_TYPE_SEQUENCER);
+    }
+    else {
+      IMB_cache_miss(IMB_CACHE_TYPE_SEQUENCER);
+    }
+  }
+
   if (ibuf) {
     return ibuf;
   }
@@ -1304,6 +1845,17 @@ struct ImBuf *seq_cache_get(const SeqRenderData *context,
   return ibuf;
 }
 
+/* Prefetch lookups are not counted, statistics show what playback and editing sees. */
+struct ImBuf *seq_cache_get(const SeqRenderData *context,
+                            Sequence *seq,
+                            float timeline_frame,
+                            int type,
+                            bool skip_disk_cache)
+{
+  return seq_cache_lookup(
+      context, seq, timeline_frame, type, skip_disk_cache, !context->is_prefetch_render);
+}
+
 bool seq_cache_put_if_possible(const SeqRenderData *context,
                                Sequence *seq,
                                float timeline_frame,
@@ -1354,7 +1906,7 @@ void seq_cache_put(const SeqRenderData *context,
   }
 
   /* Prevent reinserting, it breaks cache key linking. */
-  ImBuf *test = seq_cache_get(context, seq, timeline_frame, type, true);
+  ImBuf *test = seq_cache_lookup(context, seq, timeline_frame, type, true, false);
   if (test) {
     IMB_freeImBuf(test);
     return;
@@ -1392,6 +1944,7 @@ void seq_cache_put(const SeqRenderData *context,
   key->link_next = NULL;
   key->is_temp_cache = true;
   key->task_id = context->task_id;
+  key->cost = seq->runtime.render_time;
 
   /* Item stored for later use */
   if (flag & type) {
@@ -1427,10 +1980,7 @@ void seq_cache_put(const SeqRenderData *context,
         seq_disk_cache_create(context->bmain, context->scene);
       }
 
-      BLI_mutex_lock(&cache->disk_cache->read_write_mutex);
-      seq_disk_cache_write_file(cache->disk_cache, key, i);
-      BLI_mutex_unlock(&cache->disk_cache->read_write_mutex);
-      seq_disk_cache_enforce_limits(cache->disk_cache);
+      seq_disk_cache_write_push(cache->disk_cache, key, i);
     }
   }
 }
@@ -1465,5 +2015,5 @@ void SEQ_cache_iterate(
 
 bool seq_cache_is_full(void)
 {
-  return seq_cache_get_mem_total() < MEM_get_memory_in_use();
+  return IMB_cache_is_full(0);
 }
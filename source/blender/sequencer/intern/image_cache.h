@@ -33,10 +33,6 @@ struct Scene;
 struct SeqRenderData;
 struct Sequence;
 
-#ifdef __cplusplus
-}
-#endif
-
 struct ImBuf *seq_cache_get(const struct SeqRenderData *context,
                             struct Sequence *seq,
                             float timeline_frame,
@@ -65,6 +61,39 @@ void seq_cache_cleanup_sequence(struct Scene *scene,
                                 bool force_seq_changed_range);
 bool seq_cache_is_full(void);
 
+/* Encoding of disk cache entries. */
+
+/* DiskCacheHeaderEntry.codec */
+enum {
+  DCACHE_CODEC_NONE = 0,
+  DCACHE_CODEC_DEFLATE = 1,
+  DCACHE_CODEC_LZO = 2,
+};
+
+/* DiskCacheHeaderEntry.filter */
+enum {
+  /* Bytes of each 4 byte element are stored in separate planes. */
+  DCACHE_FILTER_SHUFFLE = (1 << 0),
+  /* Data is difference to image stored as reference_frameno. */
+  DCACHE_FILTER_DELTA = (1 << 1),
+};
+
+void seq_disk_cache_filter_encode(unsigned char *dst,
+                                  const unsigned char *src,
+                                  const unsigned char *ref,
+                                  size_t size,
+                                  bool is_float);
+void seq_disk_cache_filter_decode(unsigned char *dst,
+                                  const unsigned char *src,
+                                  const unsigned char *ref,
+                                  size_t size,
+                                  bool is_float);
+size_t seq_disk_cache_compress_bound(int codec, size_t size);
+size_t seq_disk_cache_compress(
+    int codec, const unsigned char *src, size_t size, unsigned char *dst, size_t dst_size);
+bool seq_disk_cache_decompress(
+    int codec, const unsigned char *src, size_t size, unsigned char *dst, size_t dst_size);
+
 #ifdef __cplusplus
 }
 #endif
@@ -0,0 +1,137 @@
+/*
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ *
+ * The Original Code is Copyright (C) 2020 by Blender Foundation.
+ */
+#include "testing/testing.h"
+
+#include <cstring>
+#include <vector>
+
+#include "BLI_rand.h"
+
+#include "image_cache.h"
+
+namespace blender::seq::tests {
+
+/* Image like data: smooth gradients with some noise. */
+static std::vector<unsigned char> create_data(size_t size, unsigned int seed)
+{
+  std::vector<unsigned char> data(size);
+  RNG *rng = BLI_rng_new(seed);
+  for (size_t i = 0; i < size; i++) {
+    data[i] = (unsigned char)(i / 16);
+    if (i % 8 == 0) {
+      data[i] += BLI_rng_get_uint(rng) & 3;
+    }
+  }
+  BLI_rng_free(rng);
+  return data;
+}
+
+static std::vector<unsigned char> create_float_data(size_t num_floats, float offset)
+{
+  std::vector<unsigned char> data(num_floats * sizeof(float));
+  for (size_t i = 0; i < num_floats; i++) {
+    const float value = offset + (float)i * 0.01f;
+    memcpy(&data[i * sizeof(float)], &value, sizeof(value));
+  }
+  return data;
+}
+
+TEST(seq_disk_cache, filter_shuffle_planes)
+{
+  const unsigned char src[9] = {0, 1, 2, 3, 4, 5, 6, 7, 8};
+  const unsigned char expected[9] = {0, 4, 1, 5, 2, 6, 3, 7, 8};
+  unsigned char encoded[9], decoded[9];
+
+  seq_disk_cache_filter_encode(encoded, src, nullptr, sizeof(src), false);
+  EXPECT_EQ(memcmp(encoded, expected, sizeof(expected)), 0);
+
+  seq_disk_cache_filter_decode(decoded, encoded, nullptr, sizeof(src), false);
+  EXPECT_EQ(memcmp(decoded, src, sizeof(src)), 0);
+}
+
+TEST(seq_disk_cache, filter_delta_byte)
+{
+  const size_t size = 4 * 1000 + 3;
+  const std::vector<unsigned char> ref = create_data(size, 1);
+  const std::vector<unsigned char> src = create_data(size, 2);
+  std::vector<unsigned char> encoded(size), decoded(size);
+
+  seq_disk_cache_filter_encode(encoded.data(), src.data(), ref.data(), size, false);
+  seq_disk_cache_filter_decode(decoded.data(), encoded.data(), ref.data(), size, false);
+  EXPECT_EQ(decoded, src);
+
+  /* Identical frames are stored as zeros. */
+  seq_disk_cache_filter_encode(encoded.data(), ref.data(), ref.data(), size, false);
+  EXPECT_EQ(encoded, std::vector<unsigned char>(size, 0));
+}
+
+TEST(seq_disk_cache, filter_delta_float)
+{
+  const size_t num_floats = 1000;
+  const size_t size = num_floats * sizeof(float);
+  const std::vector<unsigned char> ref = create_float_data(num_floats, 0.5f);
+  const std::vector<unsigned char> src = create_float_data(num_floats, -0.25f);
+  std::vector<unsigned char> encoded(size), decoded(size);
+
+  /* Differences of bit patterns are lossless, also when the sign changes. */
+  seq_disk_cache_filter_encode(encoded.data(), src.data(), ref.data(), size, true);
+  seq_disk_cache_filter_decode(decoded.data(), encoded.data(), ref.data(), size, true);
+  EXPECT_EQ(decoded, src);
+
+  seq_disk_cache_filter_encode(encoded.data(), src.data(), nullptr, size, true);
+  seq_disk_cache_filter_decode(decoded.data(), encoded.data(), nullptr, size, true);
+  EXPECT_EQ(decoded, src);
+}
+
+static void test_codec_round_trip(int codec)
+{
+  const size_t size = 4 * 4096 + 1;
+  const std::vector<unsigned char> src = create_data(size, 3);
+  std::vector<unsigned char> filtered(size);
+  seq_disk_cache_filter_encode(filtered.data(), src.data(), nullptr, size, false);
+
+  std::vector<unsigned char> compressed(seq_disk_cache_compress_bound(codec, size));
+  const size_t compressed_size = seq_disk_cache_compress(
+      codec, filtered.data(), size, compressed.data(), compressed.size());
+  ASSERT_GT(compressed_size, (size_t)0);
+  EXPECT_LT(compressed_size, size);
+
+  std::vector<unsigned char> decompressed(size), decoded(size);
+  EXPECT_TRUE(seq_disk_cache_decompress(
+      codec, compressed.data(), compressed_size, decompressed.data(), size));
+  seq_disk_cache_filter_decode(decoded.data(), decompressed.data(), nullptr, size, false);
+  EXPECT_EQ(decoded, src);
+
+  /* Data of other size than the entry is an error. */
+  EXPECT_FALSE(seq_disk_cache_decompress(
+      codec, compressed.data(), compressed_size, decompressed.data(), size - 1));
+}
+
+TEST(seq_disk_cache, deflate_round_trip)
+{
+  test_codec_round_trip(DCACHE_CODEC_DEFLATE);
+}
+
+#ifdef WITH_LZO
+TEST(seq_disk_cache, lzo_round_trip)
+{
+  test_codec_round_trip(DCACHE_CODEC_LZO);
+}
+#endif
+
+}  // namespace blender::seq::tests
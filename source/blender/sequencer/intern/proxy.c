@@ -33,8 +33,11 @@
 
 #include "BLI_fileops.h"
 #include "BLI_listbase.h"
+#include "BLI_math_base.h"
+#include "BLI_math_bits.h"
 #include "BLI_path_util.h"
 #include "BLI_string.h"
+#include "BLI_threads.h"
 
 #ifdef WIN32
 #  include "BLI_winstuff.h"
@@ -49,6 +52,10 @@
 
 #include "DEG_depsgraph.h"
 
+#include "PIL_time.h"
+
+#include "atomic_ops.h"
+
 #include "IMB_colormanagement.h"
 #include "IMB_imbuf.h"
 #include "IMB_imbuf_types.h"
@@ -260,61 +267,119 @@ ImBuf *seq_proxy_fetch(const SeqRenderData *context, Sequence *seq, int timeline
   return NULL;
 }
 
-static void seq_proxy_build_frame(const SeqRenderData *context,
-                                  SeqRenderState *state,
-                                  Sequence *seq,
-                                  int timeline_frame,
-                                  int proxy_render_size,
-                                  const bool overwrite)
-{
-  char name[PROXY_MAXFILE];
+/* Rendered frames waiting for the proxy writers, each holds a full resolution image. */
+#define PROXY_BUILD_QUEUE_LEN 4
+/* Strips built at the same time, each one decodes and holds frames of its own. */
+#define PROXY_BUILD_MAX_STRIPS 8
+
+static const int proxy_size_flags[IMB_PROXY_MAX_SLOT] = {
+    IMB_PROXY_25, IMB_PROXY_50, IMB_PROXY_75, IMB_PROXY_100};
+static const int proxy_render_sizes[IMB_PROXY_MAX_SLOT] = {25, 50, 75, 100};
+
+typedef struct ProxyBuildFrame {
+  ImBuf *ibuf;
   int quality;
-  int rectx, recty;
-  ImBuf *ibuf_tmp, *ibuf;
+  /* File to write per proxy size, empty when the size is not built. */
+  char names[IMB_PROXY_MAX_SLOT][PROXY_MAXFILE];
+} ProxyBuildFrame;
+
+/* Render a frame once for all proxy sizes in \a size_flags,
+ * NULL when there is nothing to build for this frame. */
+static ProxyBuildFrame *seq_proxy_render_frame(const SeqRenderData *context,
+                                               SeqRenderState *state,
+                                               Sequence *seq,
+                                               int timeline_frame,
+                                               int size_flags,
+                                               const bool overwrite)
+{
+  ProxyBuildFrame *frame = MEM_callocN(sizeof(ProxyBuildFrame), "seq proxy build frame");
   Editing *ed = context->scene->ed;
+  bool do_render = false;
 
-  if (!seq_proxy_get_fname(ed, seq, timeline_frame, proxy_render_size, name, context->view_id)) {
-    return;
+  for (int i = 0; i < IMB_PROXY_MAX_SLOT; i++) {
+    char *name = frame->names[i];
+
+    if ((size_flags & proxy_size_flags[i]) == 0) {
+      continue;
+    }
+    if (!seq_proxy_get_fname(
+            ed, seq, timeline_frame, proxy_render_sizes[i], name, context->view_id)) {
+      name[0] = '\0';
+      continue;
+    }
+    if (!overwrite && BLI_exists(name)) {
+      name[0] = '\0';
+      continue;
+    }
+    do_render = true;
   }
 
-  if (!overwrite && BLI_exists(name)) {
-    return;
+  if (do_render) {
+    frame->ibuf = seq_render_strip(context, state, seq, timeline_frame);
   }
 
-  ibuf_tmp = seq_render_strip(context, state, seq, timeline_frame);
+  if (frame->ibuf == NULL) {
+    MEM_freeN(frame);
+    return NULL;
+  }
 
-  rectx = (proxy_render_size * ibuf_tmp->x) / 100;
-  recty = (proxy_render_size * ibuf_tmp->y) / 100;
+  frame->quality = seq->strip->proxy->quality;
+  return frame;
+}
 
-  if (ibuf_tmp->x != rectx || ibuf_tmp->y != recty) {
-    ibuf = IMB_dupImBuf(ibuf_tmp);
-    IMB_metadata_copy(ibuf, ibuf_tmp);
-    IMB_freeImBuf(ibuf_tmp);
-    IMB_scalefastImBuf(ibuf, (short)rectx, (short)recty);
-  }
-  else {
-    ibuf = ibuf_tmp;
-  }
+static void seq_proxy_write_frame(ProxyBuildFrame *frame)
+{
+  for (int i = 0; i < IMB_PROXY_MAX_SLOT; i++) {
+    const char *name = frame->names[i];
+    const int rectx = (proxy_render_sizes[i] * frame->ibuf->x) / 100;
+    const int recty = (proxy_render_sizes[i] * frame->ibuf->y) / 100;
+    ImBuf *ibuf;
 
-  /* depth = 32 is intentionally left in, otherwise ALPHA channels
-   * won't work... */
-  quality = seq->strip->proxy->quality;
-  ibuf->ftype = IMB_FTYPE_JPG;
-  ibuf->foptions.quality = quality;
+    if (name[0] == '\0') {
+      continue;
+    }
+
+    /* The rendered frame is shared by all sizes. */
+    ibuf = IMB_dupImBuf(frame->ibuf);
+    IMB_metadata_copy(ibuf, frame->ibuf);
+    if (ibuf->x != rectx || ibuf->y != recty) {
+      IMB_scalefastImBuf(ibuf, (short)rectx, (short)recty);
+    }
+
+    /* depth = 32 is intentionally left in, otherwise ALPHA channels
+     * won't work... */
+    ibuf->ftype = IMB_FTYPE_JPG;
+    ibuf->foptions.quality = frame->quality;
+
+    /* unsupported feature only confuses other s/w */
+    if (ibuf->planes == 32) {
+      ibuf->planes = 24;
+    }
+
+    BLI_make_existing_file(name);
+
+    const bool ok = IMB_saveiff(ibuf, name, IB_rect | IB_zbuf | IB_zbuffloat);
+    if (ok == false) {
+      perror(name);
+    }
 
-  /* unsupported feature only confuses other s/w */
-  if (ibuf->planes == 32) {
-    ibuf->planes = 24;
+    IMB_freeImBuf(ibuf);
   }
+}
 
-  BLI_make_existing_file(name);
+/* Scales and saves rendered frames while the next ones are rendered. */
+static void *seq_proxy_write_thread(void *data)
+{
+  ThreadQueue *frames = data;
+  ProxyBuildFrame *frame;
 
-  const bool ok = IMB_saveiff(ibuf, name, IB_rect | IB_zbuf | IB_zbuffloat);
-  if (ok == false) {
-    perror(name);
+  while ((frame = BLI_thread_queue_pop(frames))) {
+    seq_proxy_write_frame(frame);
+    IMB_freeImBuf(frame->ibuf);
+    MEM_freeN(frame);
   }
 
-  IMB_freeImBuf(ibuf);
+  return NULL;
 }
 
 /**
@@ -512,20 +577,25 @@ void SEQ_proxy_rebuild(SeqIndexBuildContext *context,
   SeqRenderState state;
   seq_render_state_init(&state);
 
+  /* Each frame is rendered once for all sizes, scaling and saving happens on writer threads.
+   * The queue is bounded so rendering does not run far ahead of the writers. */
+  ThreadQueue *frames = BLI_thread_queue_init_bounded(PROXY_BUILD_QUEUE_LEN);
+  const int num_writers = max_ii(count_bits_i(context->size_flags), 1);
+  ListBase writers;
+
+  BLI_threadpool_init(&writers, seq_proxy_write_thread, num_writers);
+  for (int i = 0; i < num_writers; i++) {
+    BLI_threadpool_insert(&writers, frames);
+  }
+
   for (timeline_frame = seq->startdisp + seq->startstill;
        timeline_frame < seq->enddisp - seq->endstill;
        timeline_frame++) {
-    if (context->size_flags & IMB_PROXY_25) {
-      seq_proxy_build_frame(&render_context, &state, seq, timeline_frame, 25, overwrite);
-    }
-    if (context->size_flags & IMB_PROXY_50) {
-      seq_proxy_build_frame(&render_context, &state, seq, timeline_frame, 50, overwrite);
-    }
-    if (context->size_flags & IMB_PROXY_75) {
-      seq_proxy_build_frame(&render_context, &state, seq, timeline_frame, 75, overwrite);
-    }
-    if (context->size_flags & IMB_PROXY_100) {
-      seq_proxy_build_frame(&render_context, &state, seq, timeline_frame, 100, overwrite);
+    ProxyBuildFrame *frame = seq_proxy_render_frame(
+        &render_context, &state, seq, timeline_frame, context->size_flags, overwrite);
+
+    if (frame) {
+      BLI_thread_queue_push(frames, frame);
     }
 
     *progress = (float)(timeline_frame - seq->startdisp - seq->startstill) /
@@ -536,6 +606,129 @@ void SEQ_proxy_rebuild(SeqIndexBuildContext *context,
       break;
     }
   }
+
+  /* Writers finish the frames already rendered. */
+  BLI_thread_queue_nowait(frames);
+  BLI_threadpool_end(&writers);
+  BLI_thread_queue_free(frames);
+}
+
+typedef struct ProxyBuildItem {
+  SeqIndexBuildContext *context;
+  float progress;
+  short do_update;
+} ProxyBuildItem;
+
+typedef struct ProxyBuildQueue {
+  ThreadQueue *items;
+  short *stop;
+  int num_done;
+} ProxyBuildQueue;
+
+static void *seq_proxy_build_thread(void *data)
+{
+  ProxyBuildQueue *build_queue = data;
+  ProxyBuildItem *item;
+
+  while ((item = BLI_thread_queue_pop(build_queue->items))) {
+    if (!*build_queue->stop) {
+      SEQ_proxy_rebuild(item->context, build_queue->stop, &item->do_update, &item->progress);
+    }
+    item->progress = 1.0f;
+    atomic_add_and_fetch_int32(&build_queue->num_done, 1);
+  }
+
+  return NULL;
+}
+
+/**
+ * Movie and image strips only read their own files, so several of them can be built at once.
+ * Scene, meta and multi-camera strips render scenes, which is only safe from one thread at a time.
+ */
+static bool seq_proxy_rebuild_is_threadsafe(const Sequence *seq)
+{
+  return ELEM(seq->type, SEQ_TYPE_MOVIE, SEQ_TYPE_IMAGE);
+}
+
+/**
+ * Build proxies and timecode indices of all #SeqIndexBuildContext in \a queue.
+ *
+ * Movie and image strips are built on worker threads, several strips at the same time.
+ * Other strips are built one after the other on the calling thread meanwhile, so scene strips
+ * still use the OpenGL render when called from the main thread. \a progress is the progress of
+ * the strip built on the calling thread, then of all parallel strips together.
+ */
+void SEQ_proxy_rebuild_queue(ListBase *queue, short *stop, short *do_update, float *progress)
+{
+  ProxyBuildItem *items = NULL;
+  ProxyBuildQueue build_queue = {NULL};
+  ListBase threads;
+  int num_items = 0, num_threads, i;
+
+  LISTBASE_FOREACH (LinkData *, link, queue) {
+    SeqIndexBuildContext *context = link->data;
+    if (seq_proxy_rebuild_is_threadsafe(context->seq)) {
+      num_items++;
+    }
+  }
+
+  if (num_items != 0) {
+    items = MEM_calloc_arrayN(num_items, sizeof(ProxyBuildItem), "seq proxy build items");
+    build_queue.items = BLI_thread_queue_init();
+    build_queue.stop = stop;
+
+    i = 0;
+    LISTBASE_FOREACH (LinkData *, link, queue) {
+      SeqIndexBuildContext *context = link->data;
+      if (seq_proxy_rebuild_is_threadsafe(context->seq)) {
+        items[i].context = context;
+        BLI_thread_queue_push(build_queue.items, &items[i]);
+        i++;
+      }
+    }
+    BLI_thread_queue_nowait(build_queue.items);
+
+    num_threads = min_iii(BLI_system_thread_count(), num_items, PROXY_BUILD_MAX_STRIPS);
+    BLI_threadpool_init(&threads, seq_proxy_build_thread, num_threads);
+    for (i = 0; i < num_threads; i++) {
+      BLI_threadpool_insert(&threads, &build_queue);
+    }
+  }
+
+  LISTBASE_FOREACH (LinkData *, link, queue) {
+    SeqIndexBuildContext *context = link->data;
+    if (*stop) {
+      break;
+    }
+    if (!seq_proxy_rebuild_is_threadsafe(context->seq)) {
+      SEQ_proxy_rebuild(context, stop, do_update, progress);
+    }
+  }
+
+  if (num_items == 0) {
+    *progress = 1.0f;
+    *do_update = true;
+    return;
+  }
+
+  while (atomic_add_and_fetch_int32(&build_queue.num_done, 0) < num_items) {
+    float total_progress = 0.0f;
+
+    PIL_sleep_ms(50);
+
+    for (i = 0; i < num_items; i++) {
+      total_progress += items[i].progress;
+    }
+    *progress = total_progress / num_items;
+    *do_update = true;
+  }
+
+  BLI_threadpool_end(&threads);
+  BLI_thread_queue_free(build_queue.items);
+  MEM_freeN(items);
+
+  *progress = 1.0f;
+  *do_update = true;
 }
 
 void SEQ_proxy_rebuild_finish(SeqIndexBuildContext *context, bool stop)
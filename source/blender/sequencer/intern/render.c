@@ -37,6 +37,7 @@
 #include "BLI_linklist.h"
 #include "BLI_listbase.h"
 #include "BLI_path_util.h"
+#include "BLI_task.h"
 
 #include "BKE_anim_data.h"
 #include "BKE_animsys.h"
@@ -51,6 +52,8 @@
 #include "BKE_scene.h"
 #include "BKE_sequencer_offscreen.h"
 
+#include "PIL_time.h"
+
 #include "DEG_depsgraph.h"
 #include "DEG_depsgraph_query.h"
 
@@ -1874,6 +1877,88 @@ static ImBuf *seq_render_strip_stack_apply_effect(
   return out;
 }
 
+typedef struct RenderStripTask {
+  const SeqRenderData *context;
+  SeqRenderState state;
+  Sequence *seq;
+  float timeline_frame;
+  ImBuf *ibuf;
+  double render_time;
+} RenderStripTask;
+
+/* Image and movie strips only read their own files, so they can be rendered while other strips
+ * are rendered. Modifiers with a mask input render other strips. */
+static bool seq_render_strip_is_thread_safe(Sequence *seq)
+{
+  if (!ELEM(seq->type, SEQ_TYPE_IMAGE, SEQ_TYPE_MOVIE)) {
+    return false;
+  }
+  LISTBASE_FOREACH (SequenceModifierData *, smd, &seq->modifiers) {
+    if (smd->mask_sequence || smd->mask_id) {
+      return false;
+    }
+  }
+  return true;
+}
+
+static void seq_render_strip_task_run(RenderStripTask *task)
+{
+  const double start = PIL_check_seconds_timer();
+  task->ibuf = seq_render_strip(task->context, &task->state, task->seq, task->timeline_frame);
+  task->render_time = PIL_check_seconds_timer() - start;
+}
+
+static void seq_render_strip_task(TaskPool *__restrict UNUSED(pool), void *taskdata)
+{
+  seq_render_strip_task_run((RenderStripTask *)taskdata);
+}
+
+/* Render the strips of a stack that are blended together. Strips that can be rendered at the same
+ * time are decoded and preprocessed in a task pool, while the others are rendered on this thread.
+ */
+static void seq_render_strip_stack_inputs(RenderStripTask *tasks, int tasks_len)
+{
+  TaskPool *task_pool = NULL;
+  int i;
+
+  if (tasks_len > 1) {
+    for (i = 0; i < tasks_len; i++) {
+      if (seq_render_strip_is_thread_safe(tasks[i].seq)) {
+        if (task_pool == NULL) {
+          task_pool = BLI_task_pool_create(NULL, TASK_PRIORITY_HIGH);
+        }
+        BLI_task_pool_push(task_pool, seq_render_strip_task, &tasks[i], false, NULL);
+      }
+    }
+  }
+
+  for (i = 0; i < tasks_len; i++) {
+    if (task_pool == NULL || !seq_render_strip_is_thread_safe(tasks[i].seq)) {
+      seq_render_strip_task_run(&tasks[i]);
+    }
+  }
+
+  if (task_pool) {
+    BLI_task_pool_work_and_wait(task_pool);
+    BLI_task_pool_free(task_pool);
+  }
+}
+
+/* Time spent rendering and blending a strip, shown in the timeline. */
+static void seq_render_strip_time_store(const SeqRenderData *context,
+                                        Sequence *seq,
+                                        double render_time)
+{
+  if (context->is_prefetch_render) {
+    Scene *scene = seq_prefetch_get_original_context(context)->scene;
+    seq = seq_prefetch_get_original_sequence(seq, scene);
+    if (seq == NULL) {
+      return;
+    }
+  }
+  seq->runtime.render_time = (float)render_time;
+}
+
 static ImBuf *seq_render_strip_stack(const SeqRenderData *context,
                                      SeqRenderState *state,
                                      ListBase *seqbasep,
@@ -1881,8 +1966,12 @@ static ImBuf *seq_render_strip_stack(const SeqRenderData *context,
                                      int chanshown)
 {
   Sequence *seq_arr[MAXSEQ + 1];
+  int early_out_arr[MAXSEQ + 1];
+  RenderStripTask tasks[MAXSEQ + 1];
+  RenderStripTask *task;
+  int tasks_len = 0;
   int count;
-  int i;
+  int i, base;
   ImBuf *out = NULL;
 
   count = seq_get_shown_sequences(seqbasep, timeline_frame, chanshown, (Sequence **)&seq_arr);
@@ -1891,8 +1980,8 @@ static ImBuf *seq_render_strip_stack(const SeqRenderData *context,
     return NULL;
   }
 
+  /* Find the strip the stack starts from, strips below it are covered. */
   for (i = count - 1; i >= 0; i--) {
-    int early_out;
     Sequence *seq = seq_arr[i];
 
     out = seq_cache_get(context, seq, timeline_frame, SEQ_CACHE_STORE_COMPOSITE, false);
@@ -1901,54 +1990,83 @@ static ImBuf *seq_render_strip_stack(const SeqRenderData *context,
       break;
     }
     if (seq->blend_mode == SEQ_BLEND_REPLACE) {
-      out = seq_render_strip(context, state, seq, timeline_frame);
+      early_out_arr[i] = EARLY_USE_INPUT_2;
+      break;
+    }
+
+    early_out_arr[i] = seq_get_early_out_for_blend_mode(seq);
+
+    if (ELEM(early_out_arr[i], EARLY_NO_INPUT, EARLY_USE_INPUT_2) || i == 0) {
       break;
     }
+  }
+  base = i;
+
+  /* Render all strips that are used before blending them. */
+  for (i = base; i < count; i++) {
+    bool render = (i == base) ? (out == NULL && early_out_arr[i] != EARLY_USE_INPUT_1) :
+                                (early_out_arr[i] == EARLY_DO_EFFECT);
+    if (render) {
+      task = &tasks[tasks_len++];
+      task->context = context;
+      task->state = *state;
+      task->seq = seq_arr[i];
+      task->timeline_frame = timeline_frame;
+      task->ibuf = NULL;
+      task->render_time = 0.0;
+    }
+  }
+
+  seq_render_strip_stack_inputs(tasks, tasks_len);
+  task = tasks;
 
-    early_out = seq_get_early_out_for_blend_mode(seq);
+  if (out == NULL) {
+    Sequence *seq = seq_arr[base];
 
-    switch (early_out) {
+    switch (early_out_arr[base]) {
       case EARLY_NO_INPUT:
       case EARLY_USE_INPUT_2:
-        out = seq_render_strip(context, state, seq, timeline_frame);
+        out = task->ibuf;
+        seq_render_strip_time_store(context, seq, task->render_time);
+        task++;
         break;
       case EARLY_USE_INPUT_1:
-        if (i == 0) {
-          out = IMB_allocImBuf(context->rectx, context->recty, 32, IB_rect);
-        }
+        out = IMB_allocImBuf(context->rectx, context->recty, 32, IB_rect);
         break;
-      case EARLY_DO_EFFECT:
-        if (i == 0) {
-          ImBuf *ibuf1 = IMB_allocImBuf(context->rectx, context->recty, 32, IB_rect);
-          ImBuf *ibuf2 = seq_render_strip(context, state, seq, timeline_frame);
+      case EARLY_DO_EFFECT: {
+        const double start = PIL_check_seconds_timer();
+        ImBuf *ibuf1 = IMB_allocImBuf(context->rectx, context->recty, 32, IB_rect);
+        ImBuf *ibuf2 = task->ibuf;
 
-          out = seq_render_strip_stack_apply_effect(context, seq, timeline_frame, ibuf1, ibuf2);
+        out = seq_render_strip_stack_apply_effect(context, seq, timeline_frame, ibuf1, ibuf2);
 
-          seq_cache_put(
-              context, seq_arr[i], timeline_frame, SEQ_CACHE_STORE_COMPOSITE, out, false);
+        seq_cache_put(context, seq, timeline_frame, SEQ_CACHE_STORE_COMPOSITE, out, false);
 
-          IMB_freeImBuf(ibuf1);
-          IMB_freeImBuf(ibuf2);
-        }
+        IMB_freeImBuf(ibuf1);
+        IMB_freeImBuf(ibuf2);
+        seq_render_strip_time_store(
+            context, seq, task->render_time + PIL_check_seconds_timer() - start);
+        task++;
         break;
-    }
-    if (out) {
-      break;
+      }
     }
   }
 
-  i++;
-  for (; i < count; i++) {
+  for (i = base + 1; i < count; i++) {
     Sequence *seq = seq_arr[i];
 
-    if (seq_get_early_out_for_blend_mode(seq) == EARLY_DO_EFFECT) {
+    if (early_out_arr[i] == EARLY_DO_EFFECT) {
+      const double start = PIL_check_seconds_timer();
       ImBuf *ibuf1 = out;
-      ImBuf *ibuf2 = seq_render_strip(context, state, seq, timeline_frame);
+      ImBuf *ibuf2 = task->ibuf;
 
       out = seq_render_strip_stack_apply_effect(context, seq, timeline_frame, ibuf1, ibuf2);
 
       IMB_freeImBuf(ibuf1);
       IMB_freeImBuf(ibuf2);
+      seq_render_strip_time_store(
+          context, seq, task->render_time + PIL_check_seconds_timer() - start);
+      task++;
     }
 
     seq_cache_put(context, seq_arr[i], timeline_frame, SEQ_CACHE_STORE_COMPOSITE, out, false);
@@ -0,0 +1,113 @@
+# ##### BEGIN GPL LICENSE BLOCK #####
+#
+#  This program is free software; you can redistribute it and/or
+#  modify it under the terms of the GNU General Public License
+#  as published by the Free Software Foundation; either version 2
+#  of the License, or (at your option) any later version.
+#
+#  This program is distributed in the hope that it will be useful,
+#  but WITHOUT ANY WARRANTY; without even the implied warranty of
+#  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+#  GNU General Public License for more details.
+#
+#  You should have received a copy of the GNU General Public License
+#  along with this program; if not, write to the Free Software Foundation,
+#  Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+#
+# ##### END GPL LICENSE BLOCK #####
+
+# <pep8 compliant>
+
+"""
+Compare tiled and full frame compositor execution, on a chain of mix, math
+and color nodes applied to a generated image.
+
+Example usage:
+
+  blender -b --factory-startup --python tests/python/compositor_benchmark.py -- \\
+      --resolution 3840 2160 --chain 8 --repeat 3
+"""
+
+import argparse
+import sys
+import time
+
+import bpy
+
+
+def build_tree(scene, resolution, chain):
+    scene.use_nodes = True
+    scene.render.resolution_x = resolution[0]
+    scene.render.resolution_y = resolution[1]
+    scene.render.resolution_percentage = 100
+    scene.render.use_compositing = True
+    scene.render.use_sequencer = False
+
+    tree = scene.node_tree
+    tree.nodes.clear()
+
+    image = bpy.data.images.new(
+        "Benchmark", resolution[0], resolution[1], alpha=True, float_buffer=True)
+    image.generated_type = 'COLOR_GRID'
+
+    node_image = tree.nodes.new("CompositorNodeImage")
+    node_image.image = image
+    socket = node_image.outputs["Image"]
+
+    mix_types = ('ADD', 'MULTIPLY', 'SCREEN', 'SUBTRACT', 'DIFFERENCE', 'LIGHTEN')
+    for i in range(chain):
+        node_math = tree.nodes.new("CompositorNodeMath")
+        node_math.operation = 'MULTIPLY'
+        node_math.inputs[1].default_value = 0.5 + i / (2 * chain)
+        tree.links.new(node_image.outputs["Alpha"], node_math.inputs[0])
+
+        node_mix = tree.nodes.new("CompositorNodeMixRGB")
+        node_mix.blend_type = mix_types[i % len(mix_types)]
+        tree.links.new(node_math.outputs[0], node_mix.inputs["Fac"])
+        tree.links.new(socket, node_mix.inputs[1])
+        node_mix.inputs[2].default_value = (0.2, 0.3, 0.4, 1.0)
+
+        node_gamma = tree.nodes.new("CompositorNodeGamma")
+        node_gamma.inputs["Gamma"].default_value = 1.1
+        tree.links.new(node_mix.outputs[0], node_gamma.inputs["Image"])
+        socket = node_gamma.outputs[0]
+
+    node_composite = tree.nodes.new("CompositorNodeComposite")
+    tree.links.new(socket, node_composite.inputs["Image"])
+    return tree
+
+
+def time_render(repeat):
+    timings = []
+    for _ in range(repeat):
+        start = time.perf_counter()
+        bpy.ops.render.render()
+        timings.append(time.perf_counter() - start)
+    return min(timings)
+
+
+def main():
+    argv = sys.argv[sys.argv.index("--") + 1:] if "--" in sys.argv else []
+
+    parser = argparse.ArgumentParser(description="Compositor execution benchmark.")
+    parser.add_argument("--resolution", nargs=2, type=int, default=(3840, 2160))
+    parser.add_argument("--chain", type=int, default=8, help="Number of mix, math and gamma nodes")
+    parser.add_argument("--repeat", type=int, default=3, help="Renders per mode, fastest is used")
+    args = parser.parse_args(argv)
+
+    scene = bpy.context.scene
+    tree = build_tree(scene, args.resolution, args.chain)
+
+    results = {}
+    for use_full_frame in (False, True):
+        tree.use_full_frame = use_full_frame
+        results[use_full_frame] = time_render(args.repeat)
+
+    print("Resolution: %dx%d, chain of %d" % (args.resolution[0], args.resolution[1], args.chain))
+    print("Tiled:      %.3fs" % results[False])
+    print("Full frame: %.3fs" % results[True])
+    print("Speedup:    %.2fx" % (results[False] / results[True]))
+
+
+if __name__ == "__main__":
+    main()
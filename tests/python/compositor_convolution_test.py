@@ -0,0 +1,227 @@
+# ##### BEGIN GPL LICENSE BLOCK #####
+#
+#  This program is free software; you can redistribute it and/or
+#  modify it under the terms of the GNU General Public License
+#  as published by the Free Software Foundation; either version 2
+#  of the License, or (at your option) any later version.
+#
+#  This program is distributed in the hope that it will be useful,
+#  but WITHOUT ANY WARRANTY; without even the implied warranty of
+#  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+#  GNU General Public License for more details.
+#
+#  You should have received a copy of the GNU General Public License
+#  along with this program; if not, write to the Free Software Foundation,
+#  Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+#
+# ##### END GPL LICENSE BLOCK #####
+
+# <pep8 compliant>
+
+"""
+Check Fog Glow and large Bokeh Blurs, which are computed with FFT convolution,
+against reference pixels computed by direct convolution of the same input.
+
+Example usage:
+
+  blender -b --factory-startup --python tests/python/compositor_convolution_test.py
+"""
+
+import math
+import os
+import tempfile
+import unittest
+
+import bpy
+import numpy as np
+
+RESOLUTION = (320, 200)
+
+# Bokeh blur radius in pixels, size is a percentage of the largest dimension.
+BOKEH_SIZE = 10.0
+BOKEH_RADIUS = int(BOKEH_SIZE * max(RESOLUTION) / 100.0)
+# Bokeh image of twice the radius, so kernel taps map to bokeh pixels one to one.
+BOKEH_IMAGE_SIZE = 2 * BOKEH_RADIUS
+
+# Fog glow kernel size is 1 << size.
+FOG_GLOW_SIZE = 6
+
+TOLERANCE = 1e-4
+
+
+def setup_scene(scene):
+    scene.use_nodes = True
+    scene.render.engine = 'CYCLES'
+    scene.cycles.samples = 1
+    scene.render.resolution_x = RESOLUTION[0]
+    scene.render.resolution_y = RESOLUTION[1]
+    scene.render.resolution_percentage = 100
+    scene.render.use_compositing = True
+    scene.render.use_sequencer = False
+    scene.render.image_settings.file_format = 'OPEN_EXR'
+    scene.render.image_settings.color_depth = '32'
+    scene.render.image_settings.exr_codec = 'NONE'
+
+    tree = scene.node_tree
+    tree.nodes.clear()
+    tree.use_result_cache = False
+    return tree
+
+
+def image_to_array(image):
+    pixels = np.empty(image.size[0] * image.size[1] * 4, dtype=np.float32)
+    image.pixels.foreach_get(pixels)
+    # Rows from bottom to top, like compositor buffers.
+    return pixels.reshape(image.size[1], image.size[0], 4).astype(np.float64)
+
+
+def create_input_image():
+    image = bpy.data.images.new(
+        "ConvolutionTest", RESOLUTION[0], RESOLUTION[1], alpha=True, float_buffer=True)
+    image.generated_type = 'COLOR_GRID'
+    return image
+
+
+def create_bokeh_image():
+    size = BOKEH_IMAGE_SIZE
+    pixels = np.zeros((size, size, 4), dtype=np.float32)
+    center = size / 2.0
+    for y in range(size):
+        for x in range(size):
+            if math.hypot(x - center, y - center) < center - 4.0:
+                # Weights that differ per channel.
+                pixels[y, x] = (1.0, 0.5 + 0.5 * x / size, 1.0 - 0.5 * y / size, 1.0)
+    image = bpy.data.images.new("ConvolutionTestBokeh", size, size, alpha=True, float_buffer=True)
+    image.pixels.foreach_set(pixels.ravel())
+    return image
+
+
+def correlate(image, kernel, center_x, center_y):
+    """
+    Direct convolution,
+    output(x, y) = sum(kernel(i, j) * image(x + i - center_x, y + j - center_y)),
+    pixels outside of the image are zero. Returns the result and the sum of the kernel weights
+    inside of the image.
+    """
+    height, width = image.shape[:2]
+    kernel_height, kernel_width = kernel.shape[:2]
+    pad_x = max(center_x, kernel_width - center_x)
+    pad_y = max(center_y, kernel_height - center_y)
+
+    padded = np.zeros((height + 2 * pad_y, width + 2 * pad_x) + image.shape[2:])
+    padded[pad_y:pad_y + height, pad_x:pad_x + width] = image
+    mask = np.zeros((height + 2 * pad_y, width + 2 * pad_x, 1))
+    mask[pad_y:pad_y + height, pad_x:pad_x + width] = 1.0
+
+    result = np.zeros(image.shape)
+    weights = np.zeros((height, width) + kernel.shape[2:])
+    for j in range(kernel_height):
+        for i in range(kernel_width):
+            weight = kernel[j, i]
+            if not np.any(weight):
+                continue
+            y = pad_y + j - center_y
+            x = pad_x + i - center_x
+            result += weight * padded[y:y + height, x:x + width]
+            weights += weight * mask[y:y + height, x:x + width]
+    return result, weights
+
+
+def bokeh_reference(image, bokeh):
+    """Same sampling as BokehBlurOperation::executePixel, with nearest lookups of the bokeh."""
+    radius = BOKEH_RADIUS
+    mid = BOKEH_IMAGE_SIZE / 2.0
+    scale = (BOKEH_IMAGE_SIZE / 2.0) / radius
+    kernel = np.zeros((2 * radius + 1, 2 * radius + 1, 4))
+    for dy in range(-radius, radius):
+        for dx in range(-radius, radius):
+            u = int(mid - dx * scale)
+            v = int(mid - dy * scale)
+            if 0 <= u < BOKEH_IMAGE_SIZE and 0 <= v < BOKEH_IMAGE_SIZE:
+                kernel[dy + radius, dx + radius] = bokeh[v, u]
+
+    result, weights = correlate(image, kernel, radius, radius)
+    return result / weights
+
+
+def fog_glow_reference(image):
+    """Fog glow kernel of GlareFogGlowOperation, with threshold 0 and mix 1 only the glow."""
+    sz = 1 << FOG_GLOW_SIZE
+    coords = 2.0 * (np.arange(sz, dtype=np.float32) / sz) - 1.0
+    u = coords[np.newaxis, :]
+    v = coords[:, np.newaxis]
+    r = (u * u + v * v) * (0.25 * sz)
+    window = (0.5 + 0.5 * np.cos(u * np.pi)) * (0.5 + 0.5 * np.cos(v * np.pi))
+    kernel = np.exp(-np.sqrt(np.sqrt(np.sqrt(r))) * 9.0) * window
+    kernel = (kernel / kernel.sum())[:, :, np.newaxis]
+
+    color = np.maximum(image[:, :, :3], 0.0)
+    glow, _ = correlate(color, kernel, sz // 2, sz // 2)
+    return np.dstack((np.maximum(glow, 0.0), image[:, :, 3]))
+
+
+def render_array(scene, filepath):
+    scene.render.filepath = filepath
+    bpy.ops.render.render(write_still=True)
+    image = bpy.data.images.load(filepath)
+    pixels = image_to_array(image)
+    bpy.data.images.remove(image)
+    return pixels
+
+
+class CompositorConvolutionTest(unittest.TestCase):
+
+    def render_and_compare(self, scene, reference):
+        with tempfile.TemporaryDirectory() as directory:
+            result = render_array(scene, os.path.join(directory, "result.exr"))
+
+        self.assertEqual(result.shape, reference.shape)
+        max_difference = np.max(np.abs(result - reference))
+        self.assertLessEqual(max_difference, TOLERANCE)
+
+    def test_fog_glow(self):
+        scene = bpy.context.scene
+        tree = setup_scene(scene)
+        image = create_input_image()
+
+        node_image = tree.nodes.new("CompositorNodeImage")
+        node_image.image = image
+        node_glare = tree.nodes.new("CompositorNodeGlare")
+        node_glare.glare_type = 'FOG_GLOW'
+        node_glare.quality = 'HIGH'
+        node_glare.size = FOG_GLOW_SIZE
+        node_glare.threshold = 0.0
+        node_glare.mix = 1.0
+        node_composite = tree.nodes.new("CompositorNodeComposite")
+        tree.links.new(node_image.outputs["Image"], node_glare.inputs["Image"])
+        tree.links.new(node_glare.outputs["Image"], node_composite.inputs["Image"])
+
+        self.render_and_compare(scene, fog_glow_reference(image_to_array(image)))
+
+    def test_large_bokeh_blur(self):
+        scene = bpy.context.scene
+        tree = setup_scene(scene)
+        image = create_input_image()
+        bokeh = create_bokeh_image()
+
+        node_image = tree.nodes.new("CompositorNodeImage")
+        node_image.image = image
+        node_bokeh = tree.nodes.new("CompositorNodeImage")
+        node_bokeh.image = bokeh
+        node_blur = tree.nodes.new("CompositorNodeBokehBlur")
+        node_blur.use_variable_size = False
+        node_blur.use_extended_bounds = False
+        node_blur.inputs["Size"].default_value = BOKEH_SIZE
+        node_composite = tree.nodes.new("CompositorNodeComposite")
+        tree.links.new(node_image.outputs["Image"], node_blur.inputs["Image"])
+        tree.links.new(node_bokeh.outputs["Image"], node_blur.inputs["Bokeh"])
+        tree.links.new(node_blur.outputs["Image"], node_composite.inputs["Image"])
+
+        self.render_and_compare(
+            scene, bokeh_reference(image_to_array(image), image_to_array(bokeh)))
+
+
+if __name__ == '__main__':
+    import sys
+    sys.argv = [__file__] + (sys.argv[sys.argv.index("--") + 1:] if "--" in sys.argv else [])
+    unittest.main()
@@ -0,0 +1,143 @@
+# ##### BEGIN GPL LICENSE BLOCK #####
+#
+#  This program is free software; you can redistribute it and/or
+#  modify it under the terms of the GNU General Public License
+#  as published by the Free Software Foundation; either version 2
+#  of the License, or (at your option) any later version.
+#
+#  This program is distributed in the hope that it will be useful,
+#  but WITHOUT ANY WARRANTY; without even the implied warranty of
+#  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+#  GNU General Public License for more details.
+#
+#  You should have received a copy of the GNU General Public License
+#  along with this program; if not, write to the Free Software Foundation,
+#  Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+#
+# ##### END GPL LICENSE BLOCK #####
+
+# <pep8 compliant>
+
+"""
+Check that full frame compositor execution, which computes chains of operations
+a row at a time, gives the same pixels as tiled execution.
+
+Example usage:
+
+  blender -b --factory-startup --python tests/python/compositor_full_frame_test.py
+"""
+
+import os
+import tempfile
+import unittest
+
+import bpy
+
+RESOLUTION = (200, 120)
+
+MIX_TYPES = (
+    'MIX', 'ADD', 'MULTIPLY', 'SUBTRACT', 'SCREEN', 'DIVIDE', 'DIFFERENCE', 'DARKEN',
+    'LIGHTEN', 'OVERLAY', 'DODGE', 'BURN', 'HUE', 'SATURATION', 'VALUE', 'COLOR',
+    'SOFT_LIGHT', 'LINEAR_LIGHT',
+)
+
+MATH_OPERATIONS = (
+    'ADD', 'SUBTRACT', 'MULTIPLY', 'DIVIDE', 'POWER', 'MINIMUM', 'MAXIMUM', 'SQRT',
+    'ABSOLUTE', 'FRACT', 'SINE', 'ROUND',
+)
+
+
+def build_tree(scene):
+    scene.use_nodes = True
+    scene.render.engine = 'CYCLES'
+    scene.cycles.samples = 1
+    scene.render.resolution_x = RESOLUTION[0]
+    scene.render.resolution_y = RESOLUTION[1]
+    scene.render.resolution_percentage = 100
+    scene.render.use_compositing = True
+    scene.render.use_sequencer = False
+    scene.render.image_settings.file_format = 'OPEN_EXR'
+    scene.render.image_settings.color_depth = '32'
+    scene.render.image_settings.exr_codec = 'NONE'
+
+    tree = scene.node_tree
+    tree.nodes.clear()
+    # Tiles smaller than the image, so tiled execution differs from full frame.
+    tree.chunk_size = '32'
+    tree.use_result_cache = False
+
+    image = bpy.data.images.new(
+        "FullFrameTest", RESOLUTION[0], RESOLUTION[1], alpha=True, float_buffer=True)
+    image.generated_type = 'COLOR_GRID'
+
+    node_image = tree.nodes.new("CompositorNodeImage")
+    node_image.image = image
+    socket = node_image.outputs["Image"]
+
+    for i, blend_type in enumerate(MIX_TYPES):
+        node_math = tree.nodes.new("CompositorNodeMath")
+        node_math.operation = MATH_OPERATIONS[i % len(MATH_OPERATIONS)]
+        node_math.inputs[1].default_value = 0.3 + i / (2 * len(MIX_TYPES))
+        tree.links.new(node_image.outputs["Alpha"], node_math.inputs[0])
+
+        node_mix = tree.nodes.new("CompositorNodeMixRGB")
+        node_mix.blend_type = blend_type
+        node_mix.use_clamp = (i % 2 == 0)
+        tree.links.new(node_math.outputs[0], node_mix.inputs["Fac"])
+        tree.links.new(socket, node_mix.inputs[1])
+        node_mix.inputs[2].default_value = (0.2, 0.5 + i * 0.02, 0.4, 1.0)
+
+        node_gamma = tree.nodes.new("CompositorNodeGamma")
+        node_gamma.inputs["Gamma"].default_value = 1.1
+        tree.links.new(node_mix.outputs[0], node_gamma.inputs["Image"])
+        socket = node_gamma.outputs[0]
+
+        # A blur in the middle of the chain is read from a buffer by the rows after it.
+        if i == len(MIX_TYPES) // 2:
+            node_blur = tree.nodes.new("CompositorNodeBlur")
+            node_blur.size_x = 5
+            node_blur.size_y = 5
+            tree.links.new(socket, node_blur.inputs["Image"])
+            socket = node_blur.outputs[0]
+
+    node_invert = tree.nodes.new("CompositorNodeInvert")
+    node_invert.inputs["Fac"].default_value = 0.25
+    tree.links.new(socket, node_invert.inputs["Color"])
+
+    node_composite = tree.nodes.new("CompositorNodeComposite")
+    tree.links.new(node_invert.outputs[0], node_composite.inputs["Image"])
+    return tree
+
+
+def render_pixels(scene, filepath):
+    scene.render.filepath = filepath
+    bpy.ops.render.render(write_still=True)
+    image = bpy.data.images.load(filepath)
+    pixels = image.pixels[:]
+    bpy.data.images.remove(image)
+    return pixels
+
+
+class CompositorFullFrameTest(unittest.TestCase):
+
+    def test_full_frame_matches_tiled(self):
+        scene = bpy.context.scene
+        tree = build_tree(scene)
+
+        with tempfile.TemporaryDirectory() as directory:
+            tree.use_full_frame = False
+            tiled = render_pixels(scene, os.path.join(directory, "tiled.exr"))
+            tree.use_full_frame = True
+            full_frame = render_pixels(scene, os.path.join(directory, "full_frame.exr"))
+
+        self.assertEqual(len(tiled), RESOLUTION[0] * RESOLUTION[1] * 4)
+        self.assertEqual(len(full_frame), len(tiled))
+
+        max_difference = max(abs(a - b) for a, b in zip(tiled, full_frame))
+        self.assertLessEqual(max_difference, 1e-4)
+
+
+if __name__ == '__main__':
+    import sys
+    sys.argv = [__file__] + (sys.argv[sys.argv.index("--") + 1:] if "--" in sys.argv else [])
+    unittest.main()
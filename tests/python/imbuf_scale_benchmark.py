@@ -0,0 +1,71 @@
+# ##### BEGIN GPL LICENSE BLOCK #####
+#
+#  This program is free software; you can redistribute it and/or
+#  modify it under the terms of the GNU General Public License
+#  as published by the Free Software Foundation; either version 2
+#  of the License, or (at your option) any later version.
+#
+#  This program is distributed in the hope that it will be useful,
+#  but WITHOUT ANY WARRANTY; without even the implied warranty of
+#  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+#  GNU General Public License for more details.
+#
+#  You should have received a copy of the GNU General Public License
+#  along with this program; if not, write to the Free Software Foundation,
+#  Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+#
+# ##### END GPL LICENSE BLOCK #####
+
+# <pep8 compliant>
+
+"""
+Measure image buffer resizing for each resize method, in input megapixels per second.
+
+Example usage:
+
+  blender -b --factory-startup --python tests/python/imbuf_scale_benchmark.py -- \\
+      --resolution 7680 4320 --size 1920 1080 --repeat 5
+"""
+
+import argparse
+import sys
+import time
+
+import imbuf
+
+
+METHODS = ('FAST', 'BILINEAR', 'BICUBIC', 'LANCZOS')
+
+
+def time_resize(source, size, method, repeat):
+    timings = []
+    for _ in range(repeat):
+        ibuf = source.copy()
+        start = time.perf_counter()
+        ibuf.resize(size, method=method)
+        timings.append(time.perf_counter() - start)
+        ibuf.free()
+    return min(timings)
+
+
+def main():
+    argv = sys.argv[sys.argv.index("--") + 1:] if "--" in sys.argv else []
+
+    parser = argparse.ArgumentParser(description="Image buffer resize benchmark.")
+    parser.add_argument("--resolution", nargs=2, type=int, default=(7680, 4320))
+    parser.add_argument("--size", nargs=2, type=int, default=(1920, 1080), help="Target size")
+    parser.add_argument(
+        "--repeat", type=int, default=5, help="Resizes per method, fastest is used")
+    args = parser.parse_args(argv)
+
+    source = imbuf.new(args.resolution)
+    megapixels = args.resolution[0] * args.resolution[1] / 1e6
+
+    print("Resize %dx%d to %dx%d:" % (*args.resolution, *args.size))
+    for method in METHODS:
+        seconds = time_resize(source, args.size, method, args.repeat)
+        print("  %-10s %8.3fs %10.1f MP/s" % (method, seconds, megapixels / seconds))
+
+
+if __name__ == "__main__":
+    main()
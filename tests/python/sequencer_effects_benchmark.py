@@ -0,0 +1,187 @@
+# ##### BEGIN GPL LICENSE BLOCK #####
+#
+#  This program is free software; you can redistribute it and/or
+#  modify it under the terms of the GNU General Public License
+#  as published by the Free Software Foundation; either version 2
+#  of the License, or (at your option) any later version.
+#
+#  This program is distributed in the hope that it will be useful,
+#  but WITHOUT ANY WARRANTY; without even the implied warranty of
+#  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+#  GNU General Public License for more details.
+#
+#  You should have received a copy of the GNU General Public License
+#  along with this program; if not, write to the Free Software Foundation,
+#  Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+#
+# ##### END GPL LICENSE BLOCK #####
+
+# <pep8 compliant>
+"""
+Measure throughput of sequencer effects and blend modes in megapixels per second,
+for byte and float images.
+
+Each effect is rendered on top of two image strips with the cache disabled. Time of
+rendering the plain image strips is subtracted, so the numbers are close to the cost
+of the effect itself.
+
+Example usage:
+
+  blender -b --factory-startup --python tests/python/sequencer_effects_benchmark.py -- \\
+      --resolution 3840 2160 --repeat 5
+"""
+
+import argparse
+import os
+import sys
+import tempfile
+import time
+
+import bpy
+
+
+EFFECT_TYPES = (
+    'CROSS',
+    'ADD',
+    'SUBTRACT',
+    'ALPHA_OVER',
+    'ALPHA_UNDER',
+    'GAMMA_CROSS',
+    'MULTIPLY',
+)
+
+BLEND_TYPES = (
+    'ADD',
+    'SUBTRACT',
+    'MULTIPLY',
+    'DARKEN',
+    'LIGHTEN',
+    'SCREEN',
+    'DODGE',
+    'BURN',
+    'LINEAR_BURN',
+    'OVERLAY',
+    'SOFT_LIGHT',
+    'HARD_LIGHT',
+    'PIN_LIGHT',
+    'LINEAR_LIGHT',
+    'VIVID_LIGHT',
+    'DIFFERENCE',
+    'EXCLUSION',
+    'HUE',
+    'SATURATION',
+    'COLOR',
+    'VALUE',
+)
+
+
+def save_test_image(dirpath, name, resolution, generated_type, use_float):
+    image = bpy.data.images.new(
+        name, resolution[0], resolution[1], alpha=True, float_buffer=use_float)
+    image.generated_type = generated_type
+    image.file_format = 'OPEN_EXR' if use_float else 'PNG'
+    image.filepath_raw = os.path.join(dirpath, name + (".exr" if use_float else ".png"))
+    image.save()
+    return image.filepath_raw
+
+
+def setup_scene(scene, resolution):
+    scene.render.resolution_x = resolution[0]
+    scene.render.resolution_y = resolution[1]
+    scene.render.resolution_percentage = 100
+    scene.render.use_compositing = False
+    scene.render.use_sequencer = True
+    scene.frame_start = 1
+    scene.frame_end = 1
+    scene.frame_current = 1
+
+    ed = scene.sequence_editor_create()
+    ed.use_cache_raw = False
+    ed.use_cache_preprocessed = False
+    ed.use_cache_composite = False
+    ed.use_cache_final = False
+    return ed
+
+
+def clear_strips(ed):
+    for strip in list(ed.sequences_all):
+        ed.sequences.remove(strip)
+
+
+def add_inputs(ed, filepaths):
+    strip1 = ed.sequences.new_image("A", filepaths[0], 1, 1)
+    strip2 = ed.sequences.new_image("B", filepaths[1], 2, 1)
+    strip1.frame_final_duration = 1
+    strip2.frame_final_duration = 1
+    return strip1, strip2
+
+
+def time_render(repeat):
+    timings = []
+    for _ in range(repeat):
+        start = time.perf_counter()
+        bpy.ops.render.render()
+        timings.append(time.perf_counter() - start)
+    return min(timings)
+
+
+def benchmark(ed, filepaths, repeat, megapixels):
+    results = []
+
+    # Baseline: second strip replaces the first one, no blending work.
+    clear_strips(ed)
+    strip1, strip2 = add_inputs(ed, filepaths)
+    strip2.blend_type = 'REPLACE'
+    time_base = time_render(repeat)
+
+    def report(name, time_total):
+        time_effect = max(time_total - time_base, 1e-6)
+        results.append((name, megapixels / time_effect, megapixels / time_total))
+
+    for effect_type in EFFECT_TYPES:
+        clear_strips(ed)
+        strip1, strip2 = add_inputs(ed, filepaths)
+        ed.sequences.new_effect(
+            effect_type.lower(), effect_type, 3, 1, frame_end=2, seq1=strip1, seq2=strip2)
+        report("Effect " + effect_type, time_render(repeat))
+
+    for blend_type in BLEND_TYPES:
+        clear_strips(ed)
+        strip1, strip2 = add_inputs(ed, filepaths)
+        strip2.blend_type = blend_type
+        strip2.blend_alpha = 0.75
+        report("Blend " + blend_type, time_render(repeat))
+
+    return results
+
+
+def main():
+    argv = sys.argv[sys.argv.index("--") + 1:] if "--" in sys.argv else []
+
+    parser = argparse.ArgumentParser(description="Sequencer effects benchmark.")
+    parser.add_argument("--resolution", nargs=2, type=int, default=(1920, 1080))
+    parser.add_argument(
+        "--repeat", type=int, default=5, help="Renders per effect, fastest is used")
+    args = parser.parse_args(argv)
+
+    scene = bpy.context.scene
+    ed = setup_scene(scene, args.resolution)
+    megapixels = args.resolution[0] * args.resolution[1] / 1e6
+
+    with tempfile.TemporaryDirectory() as dirpath:
+        for use_float in (False, True):
+            filepaths = (
+                save_test_image(dirpath, "grid", args.resolution, 'COLOR_GRID', use_float),
+                save_test_image(dirpath, "uv", args.resolution, 'UV_GRID', use_float),
+            )
+            results = benchmark(ed, filepaths, args.repeat, megapixels)
+
+            print("%s images, %dx%d:" % (
+                "Float" if use_float else "Byte", args.resolution[0], args.resolution[1]))
+            print("  %-24s %12s %12s" % ("", "Effect MP/s", "Frame MP/s"))
+            for name, mps_effect, mps_total in results:
+                print("  %-24s %12.1f %12.1f" % (name, mps_effect, mps_total))
+
+
+if __name__ == "__main__":
+    main()
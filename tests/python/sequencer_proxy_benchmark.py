@@ -0,0 +1,105 @@
+# ##### BEGIN GPL LICENSE BLOCK #####
+#
+#  This program is free software; you can redistribute it and/or
+#  modify it under the terms of the GNU General Public License
+#  as published by the Free Software Foundation; either version 2
+#  of the License, or (at your option) any later version.
+#
+#  This program is distributed in the hope that it will be useful,
+#  but WITHOUT ANY WARRANTY; without even the implied warranty of
+#  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+#  GNU General Public License for more details.
+#
+#  You should have received a copy of the GNU General Public License
+#  along with this program; if not, write to the Free Software Foundation,
+#  Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+#
+# ##### END GPL LICENSE BLOCK #####
+
+# <pep8 compliant>
+"""
+Measure proxy building of several image strips at once, every strip builds
+the 25%, 50% and 100% proxies of its frames.
+
+Strips are built in parallel, run with "-t 1" to compare with building one
+strip after the other. Movie strips are built in parallel too, but the proxy
+sizes of one movie are still encoded one after the other.
+
+Example usage:
+
+  blender -b --factory-startup --python tests/python/sequencer_proxy_benchmark.py -- \\
+      --resolution 3840 2160 --strips 8 --frames 24
+"""
+
+import argparse
+import os
+import shutil
+import sys
+import tempfile
+import time
+
+import bpy
+
+
+def save_test_image(dirpath, resolution):
+    image = bpy.data.images.new("grid", resolution[0], resolution[1], alpha=True)
+    image.generated_type = 'COLOR_GRID'
+    image.file_format = 'PNG'
+    image.filepath_raw = os.path.join(dirpath, "grid.png")
+    image.save()
+    return image.filepath_raw
+
+
+def add_strips(ed, dirpath, filepath, strips, frames):
+    for i in range(strips):
+        strip_dir = os.path.join(dirpath, "strip_%02d" % i)
+        os.makedirs(strip_dir)
+        names = ["%04d.png" % frame for frame in range(frames)]
+        for name in names:
+            shutil.copyfile(filepath, os.path.join(strip_dir, name))
+
+        strip = ed.sequences.new_image(
+            "strip_%02d" % i, os.path.join(strip_dir, names[0]), i + 1, 1)
+        for name in names[1:]:
+            strip.elements.append(name)
+
+        strip.select = True
+        strip.use_proxy = True
+        strip.proxy.build_25 = True
+        strip.proxy.build_50 = True
+        strip.proxy.build_100 = True
+        strip.proxy.use_overwrite = True
+
+
+def main():
+    argv = sys.argv[sys.argv.index("--") + 1:] if "--" in sys.argv else []
+
+    parser = argparse.ArgumentParser(description="Sequencer proxy building benchmark.")
+    parser.add_argument("--resolution", nargs=2, type=int, default=(1920, 1080))
+    parser.add_argument("--strips", type=int, default=8, help="Number of image strips")
+    parser.add_argument("--frames", type=int, default=24, help="Frames per strip")
+    args = parser.parse_args(argv)
+
+    scene = bpy.context.scene
+    scene.render.resolution_x = args.resolution[0]
+    scene.render.resolution_y = args.resolution[1]
+    scene.render.resolution_percentage = 100
+    ed = scene.sequence_editor_create()
+
+    with tempfile.TemporaryDirectory() as dirpath:
+        filepath = save_test_image(dirpath, args.resolution)
+        add_strips(ed, dirpath, filepath, args.strips, args.frames)
+
+        start = time.perf_counter()
+        bpy.ops.sequencer.rebuild_proxy()
+        time_total = time.perf_counter() - start
+
+    frames = args.strips * args.frames
+    print("Resolution: %dx%d, %d strips of %d frames" % (
+        args.resolution[0], args.resolution[1], args.strips, args.frames))
+    print("Total:      %.3fs" % time_total)
+    print("Per frame:  %.1fms" % (time_total * 1000.0 / frames))
+
+
+if __name__ == "__main__":
+    main()
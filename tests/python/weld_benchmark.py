@@ -0,0 +1,117 @@
+# ##### BEGIN GPL LICENSE BLOCK #####
+#
+#  This program is free software; you can redistribute it and/or
+#  modify it under the terms of the GNU General Public License
+#  as published by the Free Software Foundation; either version 2
+#  of the License, or (at your option) any later version.
+#
+#  This program is distributed in the hope that it will be useful,
+#  but WITHOUT ANY WARRANTY; without even the implied warranty of
+#  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+#  GNU General Public License for more details.
+#
+#  You should have received a copy of the GNU General Public License
+#  along with this program; if not, write to the Free Software Foundation,
+#  Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+#
+# ##### END GPL LICENSE BLOCK #####
+
+# <pep8 compliant>
+"""
+Measure the Weld modifier and the "Merge by Distance" BMesh operator on a grid
+of disconnected quads, where every corner is shared by up to four quads.
+
+Run the same command with a previous build to compare both, the printed
+vertex counts must match between builds.
+
+Example usage:
+
+  blender -b --factory-startup --python tests/python/weld_benchmark.py -- \\
+      --resolution 1000 --repeat 3
+"""
+
+import argparse
+import sys
+import time
+
+import bmesh
+import bpy
+
+
+def create_quads_mesh(resolution):
+    """Disconnected quads on a grid, with some jitter below the merge distance."""
+    verts = []
+    faces = []
+    for y in range(resolution):
+        for x in range(resolution):
+            i = len(verts)
+            jitter = ((x * 7 + y * 13) % 5) * 1e-5
+            verts.extend((
+                (x + jitter, y, 0.0),
+                (x + 1, y + jitter, 0.0),
+                (x + 1 - jitter, y + 1, 0.0),
+                (x, y + 1 - jitter, 0.0),
+            ))
+            faces.append((i, i + 1, i + 2, i + 3))
+
+    mesh = bpy.data.meshes.new("weld_benchmark")
+    mesh.from_pydata(verts, [], faces)
+    mesh.update()
+    return mesh
+
+
+def time_weld_modifier(mesh, merge_dist, repeat):
+    obj = bpy.data.objects.new("weld_benchmark", mesh)
+    bpy.context.scene.collection.objects.link(obj)
+    modifier = obj.modifiers.new("Weld", 'WELD')
+    modifier.merge_threshold = merge_dist
+
+    times = []
+    verts_len = 0
+    for _ in range(repeat):
+        obj.update_tag()
+        start = time.perf_counter()
+        depsgraph = bpy.context.evaluated_depsgraph_get()
+        obj_eval = obj.evaluated_get(depsgraph)
+        times.append(time.perf_counter() - start)
+        verts_len = len(obj_eval.data.vertices)
+
+    bpy.data.objects.remove(obj)
+    return min(times), verts_len
+
+
+def time_remove_doubles(mesh, merge_dist, repeat):
+    times = []
+    verts_len = 0
+    for _ in range(repeat):
+        bm = bmesh.new()
+        bm.from_mesh(mesh)
+        start = time.perf_counter()
+        bmesh.ops.remove_doubles(bm, verts=bm.verts, dist=merge_dist)
+        times.append(time.perf_counter() - start)
+        verts_len = len(bm.verts)
+        bm.free()
+    return min(times), verts_len
+
+
+def main():
+    argv = sys.argv[sys.argv.index("--") + 1:] if "--" in sys.argv else []
+
+    parser = argparse.ArgumentParser(description="Weld and merge by distance benchmark.")
+    parser.add_argument("--resolution", type=int, default=500, help="Quads along each side")
+    parser.add_argument("--distance", type=float, default=1e-3, help="Merge distance")
+    parser.add_argument("--repeat", type=int, default=3, help="Runs, the fastest is reported")
+    args = parser.parse_args(argv)
+
+    mesh = create_quads_mesh(args.resolution)
+    print("Vertices:       %d" % len(mesh.vertices))
+
+    time_modifier, verts_modifier = time_weld_modifier(mesh, args.distance, args.repeat)
+    print("Weld modifier:  %.3fs, %d vertices" % (time_modifier, verts_modifier))
+
+    time_bmesh, verts_bmesh = time_remove_doubles(mesh, args.distance, args.repeat)
+    print("Remove doubles: %.3fs, %d vertices" % (time_bmesh, verts_bmesh))
+
+
+if __name__ == "__main__":
+    main()